@@ -32,6 +32,103 @@ typedef struct
   __m128i decrypt_key[15];
 } aes_cbc_key_data_t;
 
+/* number of independent ops encrypted in parallel, VAES packs 4 of them
+   into each 512-bit register */
+#if __VAES__
+#define N_AES_LANES 16
+#define u32xN u32x16
+#define u32xN_min_scalar u32x16_min_scalar
+#define u32xN_is_all_zero u32x16_is_all_zero
+#else
+#define N_AES_LANES 4
+#define u32xN u32x4
+#define u32xN_min_scalar u32x4_min_scalar
+#define u32xN_is_all_zero u32x4_is_all_zero
+#endif
+
+#if __VAES__
+static_always_inline __m512i
+aes_cbc_load_x4 (u8 ** p, u32 off)
+{
+  __m512i r;
+  r = _mm512_castsi128_si512 (_mm_loadu_si128 ((__m128i *) (p[0] + off)));
+  r = _mm512_inserti32x4 (r, _mm_loadu_si128 ((__m128i *) (p[1] + off)), 1);
+  r = _mm512_inserti32x4 (r, _mm_loadu_si128 ((__m128i *) (p[2] + off)), 2);
+  r = _mm512_inserti32x4 (r, _mm_loadu_si128 ((__m128i *) (p[3] + off)), 3);
+  return r;
+}
+
+static_always_inline void
+aes_cbc_store_x4 (u8 ** p, u32 off, __m512i r)
+{
+  _mm_storeu_si128 ((__m128i *) (p[0] + off), _mm512_castsi512_si128 (r));
+  _mm_storeu_si128 ((__m128i *) (p[1] + off),
+		    _mm512_extracti32x4_epi32 (r, 1));
+  _mm_storeu_si128 ((__m128i *) (p[2] + off),
+		    _mm512_extracti32x4_epi32 (r, 2));
+  _mm_storeu_si128 ((__m128i *) (p[3] + off),
+		    _mm512_extracti32x4_epi32 (r, 3));
+}
+
+static_always_inline void
+aes_cbc_dec_vaes (__m128i * k, u8 * src, u8 * dst, __m128i * f, int *count,
+		  aesni_key_size_t rounds)
+{
+  __m512i kz[15], r0, r1, r2, r3, c0, c1, c2, c3, fz;
+  int i;
+
+  for (i = 0; i < rounds + 1; i++)
+    kz[i] = _mm512_broadcast_i32x4 (k[i]);
+
+  /* previous ciphertext block lives in the top lane */
+  fz = _mm512_inserti32x4 (_mm512_setzero_si512 (), *f, 3);
+
+  while (*count >= 256)
+    {
+      c0 = _mm512_loadu_si512 (src + 0);
+      c1 = _mm512_loadu_si512 (src + 64);
+      c2 = _mm512_loadu_si512 (src + 128);
+      c3 = _mm512_loadu_si512 (src + 192);
+
+      r0 = c0 ^ kz[0];
+      r1 = c1 ^ kz[0];
+      r2 = c2 ^ kz[0];
+      r3 = c3 ^ kz[0];
+
+      for (i = 1; i < rounds; i++)
+	{
+	  r0 = _mm512_aesdec_epi128 (r0, kz[i]);
+	  r1 = _mm512_aesdec_epi128 (r1, kz[i]);
+	  r2 = _mm512_aesdec_epi128 (r2, kz[i]);
+	  r3 = _mm512_aesdec_epi128 (r3, kz[i]);
+	}
+
+      r0 = _mm512_aesdeclast_epi128 (r0, kz[i]);
+      r1 = _mm512_aesdeclast_epi128 (r1, kz[i]);
+      r2 = _mm512_aesdeclast_epi128 (r2, kz[i]);
+      r3 = _mm512_aesdeclast_epi128 (r3, kz[i]);
+
+      /* shift in the previous block, one 128-bit lane up */
+      r0 ^= _mm512_alignr_epi64 (c0, fz, 6);
+      r1 ^= _mm512_alignr_epi64 (c1, c0, 6);
+      r2 ^= _mm512_alignr_epi64 (c2, c1, 6);
+      r3 ^= _mm512_alignr_epi64 (c3, c2, 6);
+
+      _mm512_storeu_si512 (dst + 0, r0);
+      _mm512_storeu_si512 (dst + 64, r1);
+      _mm512_storeu_si512 (dst + 128, r2);
+      _mm512_storeu_si512 (dst + 192, r3);
+
+      fz = c3;
+      *count -= 256;
+      src += 256;
+      dst += 256;
+    }
+
+  *f = _mm512_extracti32x4_epi32 (fz, 3);
+}
+#endif
+
 static_always_inline void
 aes_cbc_dec (__m128i * k, u8 * src, u8 * dst, u8 * iv, int count,
 	     aesni_key_size_t rounds)
@@ -41,6 +138,16 @@ aes_cbc_dec (__m128i * k, u8 * src, u8 * dst, u8 * iv, int count,
 
   f = _mm_loadu_si128 ((__m128i *) iv);
 
+#if __VAES__
+  if (count >= 256)
+    {
+      int n = count;
+      aes_cbc_dec_vaes (k, src, dst, &f, &count, rounds);
+      src += n - count;
+      dst += n - count;
+    }
+#endif
+
   while (count >= 64)
     {
       _mm_prefetch (src + 128, _MM_HINT_T0);
@@ -105,16 +212,25 @@ aesni_ops_enc_aes_cbc (vlib_main_t * vm, vnet_crypto_op_t * ops[],
 							 vm->thread_index);
   int rounds = AESNI_KEY_ROUNDS (ks);
   u8 dummy[8192];
-  u8 *src[4] = { };
-  u8 *dst[4] = { };
-  vnet_crypto_key_index_t key_index[4] = { ~0, ~0, ~0, ~0 };
-  u32x4 dummy_mask = { };
-  u32x4 len = { };
+  u8 *src[N_AES_LANES] = { };
+  u8 *dst[N_AES_LANES] = { };
+  vnet_crypto_key_index_t key_index[N_AES_LANES];
+  u32xN dummy_mask = { };
+  u32xN len = { };
   u32 i, j, count, n_left = n_ops;
-  __m128i r[4] = { }, k[4][rounds + 1];
+  /* round keys of each group of 4 lanes are kept next to each other so
+     they can be loaded as a single 512-bit vector */
+  __m128i r[N_AES_LANES] = { }, k[N_AES_LANES / 4][rounds + 1][4];
+#if __VAES__
+  __m512i rq[N_AES_LANES / 4];
+  int q;
+#endif
+
+  for (i = 0; i < N_AES_LANES; i++)
+    key_index[i] = ~0;
 
 more:
-  for (i = 0; i < 4; i++)
+  for (i = 0; i < N_AES_LANES; i++)
     if (len[i] == 0)
       {
 	if (n_left == 0)
@@ -143,8 +259,8 @@ more:
 		aes_cbc_key_data_t *kd;
 		key_index[i] = ops[0]->key_index;
 		kd = (aes_cbc_key_data_t *) cm->key_data[key_index[i]];
-		clib_memcpy_fast (k[i], kd->encrypt_key,
-				  (rounds + 1) * sizeof (__m128i));
+		for (j = 0; j < rounds + 1; j++)
+		  k[i / 4][j][i % 4] = kd->encrypt_key[j];
 	      }
 	    ops[0]->status = VNET_CRYPTO_OP_STATUS_COMPLETED;
 	    n_left--;
@@ -152,37 +268,63 @@ more:
 	  }
       }
 
-  count = u32x4_min_scalar (len);
+  count = u32xN_min_scalar (len);
 
   ASSERT (count % 16 == 0);
 
+#if __VAES__
+  for (q = 0; q < N_AES_LANES / 4; q++)
+    rq[q] = _mm512_loadu_si512 (r + 4 * q);
+
+  for (i = 0; i < count; i += 16)
+    {
+      for (q = 0; q < N_AES_LANES / 4; q++)
+	rq[q] ^= aes_cbc_load_x4 (src + 4 * q, i) ^
+	  _mm512_loadu_si512 (k[q][0]);
+
+      for (j = 1; j < rounds; j++)
+	for (q = 0; q < N_AES_LANES / 4; q++)
+	  rq[q] = _mm512_aesenc_epi128 (rq[q], _mm512_loadu_si512 (k[q][j]));
+
+      for (q = 0; q < N_AES_LANES / 4; q++)
+	{
+	  rq[q] = _mm512_aesenclast_epi128 (rq[q],
+					    _mm512_loadu_si512 (k[q][j]));
+	  aes_cbc_store_x4 (dst + 4 * q, i, rq[q]);
+	}
+    }
+
+  for (q = 0; q < N_AES_LANES / 4; q++)
+    _mm512_storeu_si512 (r + 4 * q, rq[q]);
+#else
   for (i = 0; i < count; i += 16)
     {
-      r[0] ^= _mm_loadu_si128 ((__m128i *) (src[0] + i)) ^ k[0][0];
-      r[1] ^= _mm_loadu_si128 ((__m128i *) (src[1] + i)) ^ k[1][0];
-      r[2] ^= _mm_loadu_si128 ((__m128i *) (src[2] + i)) ^ k[2][0];
-      r[3] ^= _mm_loadu_si128 ((__m128i *) (src[3] + i)) ^ k[3][0];
+      r[0] ^= _mm_loadu_si128 ((__m128i *) (src[0] + i)) ^ k[0][0][0];
+      r[1] ^= _mm_loadu_si128 ((__m128i *) (src[1] + i)) ^ k[0][0][1];
+      r[2] ^= _mm_loadu_si128 ((__m128i *) (src[2] + i)) ^ k[0][0][2];
+      r[3] ^= _mm_loadu_si128 ((__m128i *) (src[3] + i)) ^ k[0][0][3];
 
       for (j = 1; j < rounds; j++)
 	{
-	  r[0] = _mm_aesenc_si128 (r[0], k[0][j]);
-	  r[1] = _mm_aesenc_si128 (r[1], k[1][j]);
-	  r[2] = _mm_aesenc_si128 (r[2], k[2][j]);
-	  r[3] = _mm_aesenc_si128 (r[3], k[3][j]);
+	  r[0] = _mm_aesenc_si128 (r[0], k[0][j][0]);
+	  r[1] = _mm_aesenc_si128 (r[1], k[0][j][1]);
+	  r[2] = _mm_aesenc_si128 (r[2], k[0][j][2]);
+	  r[3] = _mm_aesenc_si128 (r[3], k[0][j][3]);
 	}
 
-      r[0] = _mm_aesenclast_si128 (r[0], k[0][j]);
-      r[1] = _mm_aesenclast_si128 (r[1], k[1][j]);
-      r[2] = _mm_aesenclast_si128 (r[2], k[2][j]);
-      r[3] = _mm_aesenclast_si128 (r[3], k[3][j]);
+      r[0] = _mm_aesenclast_si128 (r[0], k[0][j][0]);
+      r[1] = _mm_aesenclast_si128 (r[1], k[0][j][1]);
+      r[2] = _mm_aesenclast_si128 (r[2], k[0][j][2]);
+      r[3] = _mm_aesenclast_si128 (r[3], k[0][j][3]);
 
       _mm_storeu_si128 ((__m128i *) (dst[0] + i), r[0]);
       _mm_storeu_si128 ((__m128i *) (dst[1] + i), r[1]);
       _mm_storeu_si128 ((__m128i *) (dst[2] + i), r[2]);
       _mm_storeu_si128 ((__m128i *) (dst[3] + i), r[3]);
     }
+#endif
 
-  for (i = 0; i < 4; i++)
+  for (i = 0; i < N_AES_LANES; i++)
     {
       src[i] += count;
       dst[i] += count;
@@ -192,7 +334,7 @@ more:
   if (n_left > 0)
     goto more;
 
-  if (!u32x4_is_all_zero (len & dummy_mask))
+  if (!u32xN_is_all_zero (len & dummy_mask))
     goto more;
 
   return n_ops;
@@ -224,6 +366,145 @@ decrypt:
   return n_ops;
 }
 
+static_always_inline __m128i
+aes_cbc_enc_blocks (__m128i * k, u8 * src, u8 * dst, __m128i r, u32 count,
+		    aesni_key_size_t rounds)
+{
+  int j;
+
+  for (u32 i = 0; i < count; i += 16)
+    {
+      r ^= _mm_loadu_si128 ((__m128i *) (src + i)) ^ k[0];
+      for (j = 1; j < rounds; j++)
+	r = _mm_aesenc_si128 (r, k[j]);
+      r = _mm_aesenclast_si128 (r, k[j]);
+      _mm_storeu_si128 ((__m128i *) (dst + i), r);
+    }
+  return r;
+}
+
+static_always_inline __m128i
+aes_cbc_dec_blocks (__m128i * k, u8 * src, u8 * dst, __m128i iv, u32 count,
+		    aesni_key_size_t rounds)
+{
+  __m128i last;
+
+  if (count == 0)
+    return iv;
+
+  /* src and dst may overlap, keep the last ciphertext block for the next
+     chunk */
+  last = _mm_loadu_si128 ((__m128i *) (src + count - 16));
+  aes_cbc_dec (k, src, dst, (u8 *) & iv, count, rounds);
+  return last;
+}
+
+static_always_inline void
+aes_cbc_chained (__m128i * k, vnet_crypto_op_t * op,
+		 vnet_crypto_op_chunk_t * chp, __m128i iv,
+		 aesni_key_size_t rounds, int is_encrypt)
+{
+  aesni_chunk_block_t cb = { };
+  u32 i, n, len;
+  u8 *src, *dst;
+
+  for (i = 0; i < op->n_chunks; i++, chp++)
+    {
+      src = chp->src;
+      dst = chp->dst;
+      len = chp->len;
+
+      /* complete the block left over from the previous chunk(s) */
+      if (cb.n_bytes)
+	{
+	  n = aesni_chunk_block_fill (&cb, src, dst, len);
+	  src += n;
+	  dst += n;
+	  len -= n;
+
+	  if (cb.n_bytes < 16)
+	    continue;
+
+	  if (is_encrypt)
+	    iv = aes_cbc_enc_blocks (k, cb.data, cb.data, iv, 16, rounds);
+	  else
+	    iv = aes_cbc_dec_blocks (k, cb.data, cb.data, iv, 16, rounds);
+	  aesni_chunk_block_flush (&cb);
+	}
+
+      n = len & ~15;
+      if (is_encrypt)
+	iv = aes_cbc_enc_blocks (k, src, dst, iv, n, rounds);
+      else
+	iv = aes_cbc_dec_blocks (k, src, dst, iv, n, rounds);
+
+      aesni_chunk_block_fill (&cb, src + n, dst + n, len - n);
+    }
+
+  /* total length is expected to be a multiple of the block size */
+  ASSERT (cb.n_bytes == 0);
+}
+
+static_always_inline u32
+aesni_ops_enc_aes_cbc_chained (vlib_main_t * vm, vnet_crypto_op_t * ops[],
+			       vnet_crypto_op_chunk_t * chunks, u32 n_ops,
+			       aesni_key_size_t ks)
+{
+  crypto_ia32_main_t *cm = &crypto_ia32_main;
+  crypto_ia32_per_thread_data_t *ptd = vec_elt_at_index (cm->per_thread_data,
+							 vm->thread_index);
+  int rounds = AESNI_KEY_ROUNDS (ks);
+  aes_cbc_key_data_t *kd;
+  vnet_crypto_op_t *op;
+  __m128i iv;
+  u32 i;
+
+  for (i = 0; i < n_ops; i++)
+    {
+      op = ops[i];
+      kd = (aes_cbc_key_data_t *) cm->key_data[op->key_index];
+
+      if (op->flags & VNET_CRYPTO_OP_FLAG_INIT_IV)
+	{
+	  iv = ptd->cbc_iv[0];
+	  _mm_storeu_si128 ((__m128i *) op->iv, iv);
+	  ptd->cbc_iv[0] = _mm_aesenc_si128 (iv, iv);
+	}
+      else
+	iv = _mm_loadu_si128 ((__m128i *) op->iv);
+
+      aes_cbc_chained (kd->encrypt_key, op, chunks + op->chunk_index, iv,
+		       rounds, /* is_encrypt */ 1);
+      op->status = VNET_CRYPTO_OP_STATUS_COMPLETED;
+    }
+
+  return n_ops;
+}
+
+static_always_inline u32
+aesni_ops_dec_aes_cbc_chained (vlib_main_t * vm, vnet_crypto_op_t * ops[],
+			       vnet_crypto_op_chunk_t * chunks, u32 n_ops,
+			       aesni_key_size_t ks)
+{
+  crypto_ia32_main_t *cm = &crypto_ia32_main;
+  int rounds = AESNI_KEY_ROUNDS (ks);
+  aes_cbc_key_data_t *kd;
+  vnet_crypto_op_t *op;
+  u32 i;
+
+  for (i = 0; i < n_ops; i++)
+    {
+      op = ops[i];
+      kd = (aes_cbc_key_data_t *) cm->key_data[op->key_index];
+      aes_cbc_chained (kd->decrypt_key, op, chunks + op->chunk_index,
+		       _mm_loadu_si128 ((__m128i *) op->iv), rounds,
+		       /* is_encrypt */ 0);
+      op->status = VNET_CRYPTO_OP_STATUS_COMPLETED;
+    }
+
+  return n_ops;
+}
+
 static_always_inline void *
 aesni_cbc_key_exp (vnet_crypto_key_t * key, aesni_key_size_t ks)
 {
@@ -244,6 +525,16 @@ static u32 aesni_ops_dec_aes_cbc_##x \
 static u32 aesni_ops_enc_aes_cbc_##x \
 (vlib_main_t * vm, vnet_crypto_op_t * ops[], u32 n_ops) \
 { return aesni_ops_enc_aes_cbc (vm, ops, n_ops, AESNI_KEY_##x); } \
+static u32 aesni_ops_dec_aes_cbc_chained_##x \
+(vlib_main_t * vm, vnet_crypto_op_t * ops[], vnet_crypto_op_chunk_t *chunks, \
+ u32 n_ops) \
+{ return aesni_ops_dec_aes_cbc_chained (vm, ops, chunks, n_ops, \
+					AESNI_KEY_##x); } \
+static u32 aesni_ops_enc_aes_cbc_chained_##x \
+(vlib_main_t * vm, vnet_crypto_op_t * ops[], vnet_crypto_op_chunk_t *chunks, \
+ u32 n_ops) \
+{ return aesni_ops_enc_aes_cbc_chained (vm, ops, chunks, n_ops, \
+					AESNI_KEY_##x); } \
 static void * aesni_cbc_key_exp_##x (vnet_crypto_key_t *key) \
 { return aesni_cbc_key_exp (key, AESNI_KEY_##x); }
 
@@ -253,7 +544,9 @@ foreach_aesni_cbc_handler_type;
 #include <fcntl.h>
 
 clib_error_t *
-#ifdef __AVX512F__
+#if __VAES__
+crypto_ia32_aesni_cbc_init_vaes (vlib_main_t * vm)
+#elif __AVX512F__
 crypto_ia32_aesni_cbc_init_avx512 (vlib_main_t * vm)
 #elif __AVX2__
 crypto_ia32_aesni_cbc_init_avx2 (vlib_main_t * vm)
@@ -272,14 +565,11 @@ crypto_ia32_aesni_cbc_init_sse42 (vlib_main_t * vm)
   /* *INDENT-OFF* */
   vec_foreach (ptd, cm->per_thread_data)
     {
-      for (int i = 0; i < 4; i++)
+      if (read(fd, ptd->cbc_iv, sizeof (ptd->cbc_iv)) !=
+	  sizeof (ptd->cbc_iv))
 	{
-	  if (read(fd, ptd->cbc_iv, sizeof (ptd->cbc_iv)) !=
-	      sizeof (ptd->cbc_iv))
-	    {
-	      err = clib_error_return_unix (0, "'/dev/urandom' read failure");
-	      goto error;
-	    }
+	  err = clib_error_return_unix (0, "'/dev/urandom' read failure");
+	  goto error;
 	}
     }
   /* *INDENT-ON* */
@@ -291,6 +581,12 @@ crypto_ia32_aesni_cbc_init_sse42 (vlib_main_t * vm)
   vnet_crypto_register_ops_handler (vm, cm->crypto_engine_index, \
 				    VNET_CRYPTO_OP_AES_##x##_CBC_DEC, \
 				    aesni_ops_dec_aes_cbc_##x); \
+  vnet_crypto_register_chained_ops_handler \
+    (vm, cm->crypto_engine_index, VNET_CRYPTO_OP_AES_##x##_CBC_ENC, \
+     aesni_ops_enc_aes_cbc_chained_##x); \
+  vnet_crypto_register_chained_ops_handler \
+    (vm, cm->crypto_engine_index, VNET_CRYPTO_OP_AES_##x##_CBC_DEC, \
+     aesni_ops_dec_aes_cbc_chained_##x); \
   cm->key_fn[VNET_CRYPTO_ALG_AES_##x##_CBC] = aesni_cbc_key_exp_##x;
   foreach_aesni_cbc_handler_type;
 #undef _
@@ -33,6 +33,12 @@ typedef struct
   const __m128i Hi[8];
   /* extracted AES key */
   const __m128i Ke[15];
+#if __VAES__
+  /* hash key powers H^16 .. H^1 in descending order so a 512-bit load at
+     any offset gives the powers for consecutive blocks, padded for loads
+     which run past H^1 */
+  const __m128i Hi4[16 + 3];
+#endif
 } aes_gcm_key_data_t;
 
 static const __m128i last_byte_one = { 0, 1ULL << 56 };
@@ -413,12 +419,11 @@ aesni_gcm_ghash_last (__m128i T, aes_gcm_key_data_t * kd, __m128i * d,
 
 
 static_always_inline __m128i
-aesni_gcm_enc (__m128i T, aes_gcm_key_data_t * kd, __m128i Y, const u8 * in,
-	       const u8 * out, u32 n_left, int rounds)
+aesni_gcm_enc (__m128i T, aes_gcm_key_data_t * kd, __m128i * Y, u32 * ctr,
+	       const u8 * in, const u8 * out, u32 n_left, int rounds)
 {
   __m128i *inv = (__m128i *) in, *outv = (__m128i *) out;
   __m128i d[4];
-  u32 ctr = 1;
 
   if (n_left == 0)
     return T;
@@ -428,34 +433,34 @@ aesni_gcm_enc (__m128i T, aes_gcm_key_data_t * kd, __m128i Y, const u8 * in,
       if (n_left > 48)
 	{
 	  n_left &= 0x0f;
-	  aesni_gcm_calc (T, kd, d, &Y, &ctr, inv, outv, rounds, 4, n_left,
+	  aesni_gcm_calc (T, kd, d, Y, ctr, inv, outv, rounds, 4, n_left,
 			  /* with_ghash */ 0, /* is_encrypt */ 1);
 	  return aesni_gcm_ghash_last (T, kd, d, 4, n_left);
 	}
       else if (n_left > 32)
 	{
 	  n_left &= 0x0f;
-	  aesni_gcm_calc (T, kd, d, &Y, &ctr, inv, outv, rounds, 3, n_left,
+	  aesni_gcm_calc (T, kd, d, Y, ctr, inv, outv, rounds, 3, n_left,
 			  /* with_ghash */ 0, /* is_encrypt */ 1);
 	  return aesni_gcm_ghash_last (T, kd, d, 3, n_left);
 	}
       else if (n_left > 16)
 	{
 	  n_left &= 0x0f;
-	  aesni_gcm_calc (T, kd, d, &Y, &ctr, inv, outv, rounds, 2, n_left,
+	  aesni_gcm_calc (T, kd, d, Y, ctr, inv, outv, rounds, 2, n_left,
 			  /* with_ghash */ 0, /* is_encrypt */ 1);
 	  return aesni_gcm_ghash_last (T, kd, d, 2, n_left);
 	}
       else
 	{
 	  n_left &= 0x0f;
-	  aesni_gcm_calc (T, kd, d, &Y, &ctr, inv, outv, rounds, 1, n_left,
+	  aesni_gcm_calc (T, kd, d, Y, ctr, inv, outv, rounds, 1, n_left,
 			  /* with_ghash */ 0, /* is_encrypt */ 1);
 	  return aesni_gcm_ghash_last (T, kd, d, 1, n_left);
 	}
     }
 
-  aesni_gcm_calc (T, kd, d, &Y, &ctr, inv, outv, rounds, 4, 0,
+  aesni_gcm_calc (T, kd, d, Y, ctr, inv, outv, rounds, 4, 0,
 		  /* with_ghash */ 0, /* is_encrypt */ 1);
 
   /* next */
@@ -465,7 +470,7 @@ aesni_gcm_enc (__m128i T, aes_gcm_key_data_t * kd, __m128i Y, const u8 * in,
 
   while (n_left >= 128)
     {
-      T = aesni_gcm_calc_double (T, kd, d, &Y, &ctr, inv, outv, rounds,
+      T = aesni_gcm_calc_double (T, kd, d, Y, ctr, inv, outv, rounds,
 				 /* is_encrypt */ 1);
 
       /* next */
@@ -476,7 +481,7 @@ aesni_gcm_enc (__m128i T, aes_gcm_key_data_t * kd, __m128i Y, const u8 * in,
 
   if (n_left >= 64)
     {
-      T = aesni_gcm_calc (T, kd, d, &Y, &ctr, inv, outv, rounds, 4, 0,
+      T = aesni_gcm_calc (T, kd, d, Y, ctr, inv, outv, rounds, 4, 0,
 			  /* with_ghash */ 1, /* is_encrypt */ 1);
 
       /* next */
@@ -491,7 +496,7 @@ aesni_gcm_enc (__m128i T, aes_gcm_key_data_t * kd, __m128i Y, const u8 * in,
   if (n_left > 48)
     {
       n_left &= 0x0f;
-      T = aesni_gcm_calc (T, kd, d, &Y, &ctr, inv, outv, rounds, 4, n_left,
+      T = aesni_gcm_calc (T, kd, d, Y, ctr, inv, outv, rounds, 4, n_left,
 			  /* with_ghash */ 1, /* is_encrypt */ 1);
       return aesni_gcm_ghash_last (T, kd, d, 4, n_left);
     }
@@ -499,7 +504,7 @@ aesni_gcm_enc (__m128i T, aes_gcm_key_data_t * kd, __m128i Y, const u8 * in,
   if (n_left > 32)
     {
       n_left &= 0x0f;
-      T = aesni_gcm_calc (T, kd, d, &Y, &ctr, inv, outv, rounds, 3, n_left,
+      T = aesni_gcm_calc (T, kd, d, Y, ctr, inv, outv, rounds, 3, n_left,
 			  /* with_ghash */ 1, /* is_encrypt */ 1);
       return aesni_gcm_ghash_last (T, kd, d, 3, n_left);
     }
@@ -507,28 +512,27 @@ aesni_gcm_enc (__m128i T, aes_gcm_key_data_t * kd, __m128i Y, const u8 * in,
   if (n_left > 16)
     {
       n_left &= 0x0f;
-      T = aesni_gcm_calc (T, kd, d, &Y, &ctr, inv, outv, rounds, 2, n_left,
+      T = aesni_gcm_calc (T, kd, d, Y, ctr, inv, outv, rounds, 2, n_left,
 			  /* with_ghash */ 1, /* is_encrypt */ 1);
       return aesni_gcm_ghash_last (T, kd, d, 2, n_left);
     }
 
   n_left &= 0x0f;
-  T = aesni_gcm_calc (T, kd, d, &Y, &ctr, inv, outv, rounds, 1, n_left,
+  T = aesni_gcm_calc (T, kd, d, Y, ctr, inv, outv, rounds, 1, n_left,
 		      /* with_ghash */ 1, /* is_encrypt */ 1);
   return aesni_gcm_ghash_last (T, kd, d, 1, n_left);
 }
 
 static_always_inline __m128i
-aesni_gcm_dec (__m128i T, aes_gcm_key_data_t * kd, __m128i Y, const u8 * in,
-	       const u8 * out, u32 n_left, int rounds)
+aesni_gcm_dec (__m128i T, aes_gcm_key_data_t * kd, __m128i * Y, u32 * ctr,
+	       const u8 * in, const u8 * out, u32 n_left, int rounds)
 {
   __m128i *inv = (__m128i *) in, *outv = (__m128i *) out;
   __m128i d[8];
-  u32 ctr = 1;
 
   while (n_left >= 128)
     {
-      T = aesni_gcm_calc_double (T, kd, d, &Y, &ctr, inv, outv, rounds,
+      T = aesni_gcm_calc_double (T, kd, d, Y, ctr, inv, outv, rounds,
 				 /* is_encrypt */ 0);
 
       /* next */
@@ -539,7 +543,7 @@ aesni_gcm_dec (__m128i T, aes_gcm_key_data_t * kd, __m128i Y, const u8 * in,
 
   if (n_left >= 64)
     {
-      T = aesni_gcm_calc (T, kd, d, &Y, &ctr, inv, outv, rounds, 4, 0, 1, 0);
+      T = aesni_gcm_calc (T, kd, d, Y, ctr, inv, outv, rounds, 4, 0, 1, 0);
 
       /* next */
       n_left -= 64;
@@ -551,54 +555,355 @@ aesni_gcm_dec (__m128i T, aes_gcm_key_data_t * kd, __m128i Y, const u8 * in,
     return T;
 
   if (n_left > 48)
-    return aesni_gcm_calc (T, kd, d, &Y, &ctr, inv, outv, rounds, 4,
+    return aesni_gcm_calc (T, kd, d, Y, ctr, inv, outv, rounds, 4,
 			   n_left - 48,
 			   /* with_ghash */ 1, /* is_encrypt */ 0);
 
   if (n_left > 32)
-    return aesni_gcm_calc (T, kd, d, &Y, &ctr, inv, outv, rounds, 3,
+    return aesni_gcm_calc (T, kd, d, Y, ctr, inv, outv, rounds, 3,
 			   n_left - 32,
 			   /* with_ghash */ 1, /* is_encrypt */ 0);
 
   if (n_left > 16)
-    return aesni_gcm_calc (T, kd, d, &Y, &ctr, inv, outv, rounds, 2,
+    return aesni_gcm_calc (T, kd, d, Y, ctr, inv, outv, rounds, 2,
 			   n_left - 16,
 			   /* with_ghash */ 1, /* is_encrypt */ 0);
 
-  return aesni_gcm_calc (T, kd, d, &Y, &ctr, inv, outv, rounds, 1, n_left,
+  return aesni_gcm_calc (T, kd, d, Y, ctr, inv, outv, rounds, 1, n_left,
 			 /* with_ghash */ 1, /* is_encrypt */ 0);
 }
 
+#if __VAES__
+/* VAES variant, 4 blocks per 512-bit register and up to 4 registers
+   (256 bytes) per round of AES and GHASH computation */
+
+static const u32x16 ctr_inc_1234 = {
+  0, 0, 0, 1 << 24, 0, 0, 0, 2 << 24, 0, 0, 0, 3 << 24, 0, 0, 0, 4 << 24
+};
+
+static const u32x16 ctr_inc_4444 = {
+  0, 0, 0, 4 << 24, 0, 0, 0, 4 << 24, 0, 0, 0, 4 << 24, 0, 0, 0, 4 << 24
+};
+
+static_always_inline __m512i
+aes4_gcm_bswap (__m512i x)
+{
+  return _mm512_shuffle_epi8 (x, _mm512_broadcast_i32x4 ((__m128i)
+							 bswap_mask));
+}
+
+static_always_inline __mmask64
+aes4_gcm_byte_mask (int n_bytes)
+{
+  return n_bytes ? (1ULL << n_bytes) - 1 : ~0ULL;
+}
+
+/* number of 16-byte blocks in n 512-bit registers, last one holding
+   n_bytes bytes (0 - full) */
 static_always_inline int
-aes_gcm (const u8 * in, u8 * out, const u8 * addt, const u8 * iv, u8 * tag,
-	 u32 data_bytes, u32 aad_bytes, u8 tag_len, aes_gcm_key_data_t * kd,
-	 int aes_rounds, int is_encrypt)
+aes4_gcm_n_blocks (int n, int n_bytes)
 {
-  int i;
-  __m128i r, Y0, T = { };
-  ghash_data_t _gd, *gd = &_gd;
+  return n_bytes ? (n - 1) * 4 + (n_bytes + 15) / 16 : n * 4;
+}
 
-  _mm_prefetch (iv, _MM_HINT_T0);
-  _mm_prefetch (in, _MM_HINT_T0);
-  _mm_prefetch (in + CLIB_CACHE_LINE_BYTES, _MM_HINT_T0);
+static_always_inline void
+aes4_gcm_load (__m512i * d, u8 * src, int n, int n_bytes)
+{
+  for (int i = 0; i < n - 1; i++)
+    d[i] = _mm512_loadu_si512 (src + i * 64);
+  d[n - 1] = _mm512_maskz_loadu_epi8 (aes4_gcm_byte_mask (n_bytes),
+				      src + (n - 1) * 64);
+}
 
-  /* calculate ghash for AAD - optimized for ipsec common cases */
-  if (aad_bytes == 8)
-    T = aesni_gcm_ghash (T, kd, (__m128i *) addt, 8);
-  else if (aad_bytes == 12)
-    T = aesni_gcm_ghash (T, kd, (__m128i *) addt, 12);
+static_always_inline void
+aes4_gcm_store (__m512i * d, u8 * dst, int n, int n_bytes)
+{
+  for (int i = 0; i < n - 1; i++)
+    _mm512_storeu_si512 (dst + i * 64, d[i]);
+  _mm512_mask_storeu_epi8 (dst + (n - 1) * 64, aes4_gcm_byte_mask (n_bytes),
+			   d[n - 1]);
+}
+
+/* counters for all 4 * n lanes are generated, but only n_blocks of them
+   are consumed so the next call continues where the data ended */
+static_always_inline void
+aes4_gcm_enc_first_round (__m512i * r, __m128i * Y, u32 * ctr, __m128i k,
+			  int n, int n_blocks)
+{
+  __m512i kz = _mm512_broadcast_i32x4 (k);
+  u32 i;
+
+  if (PREDICT_TRUE ((u8) ctr[0] < (256 - 4 * n)))
+    {
+      __m512i Yz = _mm512_add_epi32 (_mm512_broadcast_i32x4 (Y[0]),
+				    (__m512i) ctr_inc_1234);
+      for (i = 0; i < n; i++)
+	{
+	  r[i] = kz ^ Yz;
+	  Yz = _mm512_add_epi32 (Yz, (__m512i) ctr_inc_4444);
+	}
+    }
   else
-    T = aesni_gcm_ghash (T, kd, (__m128i *) addt, aad_bytes);
+    {
+      __m128i t[4];
+      for (i = 0; i < 4 * n; i++)
+	{
+	  t[i & 3] = _mm_insert_epi32 (Y[0],
+				       clib_host_to_net_u32 (ctr[0] + i + 1),
+				       3);
+	  if ((i & 3) == 3)
+	    r[i / 4] = kz ^ _mm512_loadu_si512 (t);
+	}
+    }
 
-  /* initalize counter */
-  Y0 = _mm_loadu_si128 ((__m128i *) iv);
-  Y0 = _mm_insert_epi32 (Y0, clib_host_to_net_u32 (1), 3);
+  ctr[0] += n_blocks;
+  Y[0] = _mm_insert_epi32 (Y[0], clib_host_to_net_u32 (ctr[0]), 3);
+}
 
-  /* ghash and encrypt/edcrypt  */
-  if (is_encrypt)
-    T = aesni_gcm_enc (T, kd, Y0, in, out, data_bytes, aes_rounds);
+static_always_inline void
+aes4_gcm_enc_round (__m512i * r, __m128i k, int n)
+{
+  __m512i kz = _mm512_broadcast_i32x4 (k);
+  for (int i = 0; i < n; i++)
+    r[i] = _mm512_aesenc_epi128 (r[i], kz);
+}
+
+static_always_inline void
+aes4_gcm_enc_last_round (__m512i * r, __m512i * d, const __m128i * k,
+			 int rounds, int n)
+{
+  __m512i kz;
+
+  /* additional ronuds for AES-192 and AES-256 */
+  for (int i = 10; i < rounds; i++)
+    aes4_gcm_enc_round (r, k[i], n);
+
+  kz = _mm512_broadcast_i32x4 (k[rounds]);
+  for (int i = 0; i < n; i++)
+    d[i] ^= _mm512_aesenclast_epi128 (r[i], kz);
+}
+
+/* GHASH of register i out of n_blocks blocks, the last block is
+   multiplied with H^1 */
+static_always_inline void
+aes4_gcm_ghash_mul (ghash4_data_t * gd, __m128i T, aes_gcm_key_data_t * kd,
+		    __m512i * d, int i, int n_blocks)
+{
+  __m512i H = _mm512_loadu_si512 (kd->Hi4 + 16 - n_blocks + 4 * i);
+
+  if (i == 0)
+    ghash4_mul_first (gd, aes4_gcm_bswap (d[0]) ^
+		      _mm512_inserti32x4 (_mm512_setzero_si512 (), T, 0), H);
   else
-    T = aesni_gcm_dec (T, kd, Y0, in, out, data_bytes, aes_rounds);
+    ghash4_mul_next (gd, aes4_gcm_bswap (d[i]), H);
+}
+
+/* encrypt or decrypt n registers of data, last one holding n_bytes bytes
+   (0 - full). If with_ghash is set, GHASH is calculated on the 4 registers
+   of ciphertext from the previous call when encrypting, or on the loaded
+   ciphertext when decrypting */
+static_always_inline __m128i
+aes4_gcm_calc (__m128i T, aes_gcm_key_data_t * kd, __m512i * d,
+	       __m128i * Y, u32 * ctr, u8 * src, u8 * dst, int rounds,
+	       int n, int n_bytes, int with_ghash, int is_encrypt)
+{
+  __m512i r[4];
+  ghash4_data_t _gd4, *gd4 = &_gd4;
+  ghash_data_t _gd, *gd = &_gd;
+  const __m128i *k = kd->Ke;
+  int n_blocks = aes4_gcm_n_blocks (n, n_bytes);
+  int ghash_n = is_encrypt ? 4 : n;
+  int ghash_blocks = is_encrypt ? 16 : n_blocks;
+
+  /* AES rounds 0 and 1 */
+  aes4_gcm_enc_first_round (r, Y, ctr, k[0], n, n_blocks);
+  aes4_gcm_enc_round (r, k[1], n);
+
+  /* load data - decrypt round */
+  if (is_encrypt == 0)
+    aes4_gcm_load (d, src, n, n_bytes);
+
+  /* GHASH multiply register 1 */
+  if (with_ghash)
+    aes4_gcm_ghash_mul (gd4, T, kd, d, 0, ghash_blocks);
+
+  /* AES rounds 2 and 3 */
+  aes4_gcm_enc_round (r, k[2], n);
+  aes4_gcm_enc_round (r, k[3], n);
+
+  /* GHASH multiply register 2 */
+  if (with_ghash && ghash_n > 1)
+    aes4_gcm_ghash_mul (gd4, T, kd, d, 1, ghash_blocks);
+
+  /* AES rounds 4 and 5 */
+  aes4_gcm_enc_round (r, k[4], n);
+  aes4_gcm_enc_round (r, k[5], n);
+
+  /* GHASH multiply register 3 */
+  if (with_ghash && ghash_n > 2)
+    aes4_gcm_ghash_mul (gd4, T, kd, d, 2, ghash_blocks);
+
+  /* AES rounds 6 and 7 */
+  aes4_gcm_enc_round (r, k[6], n);
+  aes4_gcm_enc_round (r, k[7], n);
+
+  /* GHASH multiply register 4 */
+  if (with_ghash && ghash_n > 3)
+    aes4_gcm_ghash_mul (gd4, T, kd, d, 3, ghash_blocks);
+
+  /* AES rounds 8 and 9 */
+  aes4_gcm_enc_round (r, k[8], n);
+  aes4_gcm_enc_round (r, k[9], n);
+
+  /* GHASH reduce 1st step */
+  if (with_ghash)
+    ghash4_reduce (gd4, gd);
+
+  /* load data - encrypt round */
+  if (is_encrypt)
+    aes4_gcm_load (d, src, n, n_bytes);
+
+  /* GHASH reduce 2nd step */
+  if (with_ghash)
+    ghash_reduce2 (gd);
+
+  /* AES last round(s) */
+  aes4_gcm_enc_last_round (r, d, k, rounds, n);
+
+  /* store data */
+  aes4_gcm_store (d, dst, n, n_bytes);
+
+  /* GHASH final step */
+  if (with_ghash)
+    T = ghash_final (gd);
+
+  return T;
+}
+
+static_always_inline __m128i
+aes4_gcm_ghash_last (__m128i T, aes_gcm_key_data_t * kd, __m512i * d,
+		     int n, int n_bytes)
+{
+  ghash4_data_t _gd4, *gd4 = &_gd4;
+  ghash_data_t _gd, *gd = &_gd;
+  int n_blocks = aes4_gcm_n_blocks (n, n_bytes);
+
+  /* ciphertext is padded with zeros up to the register size */
+  d[n - 1] = _mm512_maskz_mov_epi8 (aes4_gcm_byte_mask (n_bytes), d[n - 1]);
+
+  for (int i = 0; i < n; i++)
+    aes4_gcm_ghash_mul (gd4, T, kd, d, i, n_blocks);
+  ghash4_reduce (gd4, gd);
+  ghash_reduce2 (gd);
+  return ghash_final (gd);
+}
+
+static_always_inline __m128i
+aes4_gcm_enc (__m128i T, aes_gcm_key_data_t * kd, __m128i * Y, u32 * ctr,
+	      const u8 * in, const u8 * out, u32 n_left, int rounds)
+{
+  u8 *src = (u8 *) in, *dst = (u8 *) out;
+  __m512i d[4];
+  int n;
+
+  if (n_left == 0)
+    return T;
+
+  if (n_left < 256)
+    {
+      n = (n_left + 63) / 64;
+      n_left &= 0x3f;
+      aes4_gcm_calc (T, kd, d, Y, ctr, src, dst, rounds, n, n_left,
+		     /* with_ghash */ 0, /* is_encrypt */ 1);
+      return aes4_gcm_ghash_last (T, kd, d, n, n_left);
+    }
+
+  aes4_gcm_calc (T, kd, d, Y, ctr, src, dst, rounds, 4, 0,
+		 /* with_ghash */ 0, /* is_encrypt */ 1);
+
+  /* next */
+  n_left -= 256;
+  src += 256;
+  dst += 256;
+
+  while (n_left >= 256)
+    {
+      T = aes4_gcm_calc (T, kd, d, Y, ctr, src, dst, rounds, 4, 0,
+			 /* with_ghash */ 1, /* is_encrypt */ 1);
+
+      /* next */
+      n_left -= 256;
+      src += 256;
+      dst += 256;
+    }
+
+  if (n_left == 0)
+    return aes4_gcm_ghash_last (T, kd, d, 4, 0);
+
+  n = (n_left + 63) / 64;
+  n_left &= 0x3f;
+  T = aes4_gcm_calc (T, kd, d, Y, ctr, src, dst, rounds, n, n_left,
+		     /* with_ghash */ 1, /* is_encrypt */ 1);
+  return aes4_gcm_ghash_last (T, kd, d, n, n_left);
+}
+
+static_always_inline __m128i
+aes4_gcm_dec (__m128i T, aes_gcm_key_data_t * kd, __m128i * Y, u32 * ctr,
+	      const u8 * in, const u8 * out, u32 n_left, int rounds)
+{
+  u8 *src = (u8 *) in, *dst = (u8 *) out;
+  __m512i d[4];
+
+  while (n_left >= 256)
+    {
+      T = aes4_gcm_calc (T, kd, d, Y, ctr, src, dst, rounds, 4, 0,
+			 /* with_ghash */ 1, /* is_encrypt */ 0);
+
+      /* next */
+      n_left -= 256;
+      src += 256;
+      dst += 256;
+    }
+
+  if (n_left == 0)
+    return T;
+
+  return aes4_gcm_calc (T, kd, d, Y, ctr, src, dst, rounds,
+			(n_left + 63) / 64, n_left & 0x3f,
+			/* with_ghash */ 1, /* is_encrypt */ 0);
+}
+#endif
+
+static_always_inline __m128i
+aes_gcm_enc_data (__m128i T, aes_gcm_key_data_t * kd, __m128i * Y, u32 * ctr,
+		  const u8 * in, const u8 * out, u32 n_left, int rounds)
+{
+#if __VAES__
+  return aes4_gcm_enc (T, kd, Y, ctr, in, out, n_left, rounds);
+#else
+  return aesni_gcm_enc (T, kd, Y, ctr, in, out, n_left, rounds);
+#endif
+}
+
+static_always_inline __m128i
+aes_gcm_dec_data (__m128i T, aes_gcm_key_data_t * kd, __m128i * Y, u32 * ctr,
+		  const u8 * in, const u8 * out, u32 n_left, int rounds)
+{
+#if __VAES__
+  return aes4_gcm_dec (T, kd, Y, ctr, in, out, n_left, rounds);
+#else
+  return aesni_gcm_dec (T, kd, Y, ctr, in, out, n_left, rounds);
+#endif
+}
+
+static_always_inline int
+aes_gcm_final (__m128i T, aes_gcm_key_data_t * kd, __m128i Y0, u8 * tag,
+	       u32 data_bytes, u32 aad_bytes, u8 tag_len, int aes_rounds,
+	       int is_encrypt)
+{
+  int i;
+  __m128i r;
+  ghash_data_t _gd, *gd = &_gd;
 
   _mm_prefetch (tag, _MM_HINT_T0);
 
@@ -646,6 +951,110 @@ aes_gcm (const u8 * in, u8 * out, const u8 * addt, const u8 * iv, u8 * tag,
   return 1;
 }
 
+static_always_inline int
+aes_gcm (const u8 * in, u8 * out, const u8 * addt, const u8 * iv, u8 * tag,
+	 u32 data_bytes, u32 aad_bytes, u8 tag_len, aes_gcm_key_data_t * kd,
+	 int aes_rounds, int is_encrypt)
+{
+  __m128i Y, Y0, T = { };
+  u32 ctr = 1;
+
+  _mm_prefetch (iv, _MM_HINT_T0);
+  _mm_prefetch (in, _MM_HINT_T0);
+  _mm_prefetch (in + CLIB_CACHE_LINE_BYTES, _MM_HINT_T0);
+
+  /* calculate ghash for AAD - optimized for ipsec common cases */
+  if (aad_bytes == 8)
+    T = aesni_gcm_ghash (T, kd, (__m128i *) addt, 8);
+  else if (aad_bytes == 12)
+    T = aesni_gcm_ghash (T, kd, (__m128i *) addt, 12);
+  else
+    T = aesni_gcm_ghash (T, kd, (__m128i *) addt, aad_bytes);
+
+  /* initalize counter */
+  Y0 = _mm_loadu_si128 ((__m128i *) iv);
+  Y0 = _mm_insert_epi32 (Y0, clib_host_to_net_u32 (1), 3);
+  Y = Y0;
+
+  /* ghash and encrypt/edcrypt  */
+  if (is_encrypt)
+    T = aes_gcm_enc_data (T, kd, &Y, &ctr, in, out, data_bytes, aes_rounds);
+  else
+    T = aes_gcm_dec_data (T, kd, &Y, &ctr, in, out, data_bytes, aes_rounds);
+
+  return aes_gcm_final (T, kd, Y0, tag, data_bytes, aad_bytes, tag_len,
+			aes_rounds, is_encrypt);
+}
+
+/* same as aes_gcm () but the data is spread over multiple chunks, the
+   counter and the ghash state are carried from one chunk to the next */
+static_always_inline int
+aes_gcm_chained (vnet_crypto_op_t * op, vnet_crypto_op_chunk_t * chp,
+		 aes_gcm_key_data_t * kd, int aes_rounds, int is_encrypt)
+{
+  aesni_chunk_block_t cb = { };
+  __m128i Y, Y0, T = { };
+  u32 i, n, len, ctr = 1, data_bytes = 0;
+  u8 *src, *dst;
+
+  T = aesni_gcm_ghash (T, kd, (__m128i *) op->aad, op->aad_len);
+
+  Y0 = _mm_loadu_si128 ((__m128i *) op->iv);
+  Y0 = _mm_insert_epi32 (Y0, clib_host_to_net_u32 (1), 3);
+  Y = Y0;
+
+  for (i = 0; i < op->n_chunks; i++, chp++)
+    {
+      src = chp->src;
+      dst = chp->dst;
+      len = chp->len;
+      data_bytes += len;
+
+      /* complete the block left over from the previous chunk(s) */
+      if (cb.n_bytes)
+	{
+	  n = aesni_chunk_block_fill (&cb, src, dst, len);
+	  src += n;
+	  dst += n;
+	  len -= n;
+
+	  if (cb.n_bytes < 16)
+	    continue;
+
+	  if (is_encrypt)
+	    T = aes_gcm_enc_data (T, kd, &Y, &ctr, cb.data, cb.data, 16,
+			       aes_rounds);
+	  else
+	    T = aes_gcm_dec_data (T, kd, &Y, &ctr, cb.data, cb.data, 16,
+			       aes_rounds);
+	  aesni_chunk_block_flush (&cb);
+	}
+
+      n = len & ~15;
+      if (is_encrypt)
+	T = aes_gcm_enc_data (T, kd, &Y, &ctr, src, dst, n, aes_rounds);
+      else
+	T = aes_gcm_dec_data (T, kd, &Y, &ctr, src, dst, n, aes_rounds);
+
+      aesni_chunk_block_fill (&cb, src + n, dst + n, len - n);
+    }
+
+  /* trailing partial block */
+  if (cb.n_bytes)
+    {
+      if (is_encrypt)
+	T = aes_gcm_enc_data (T, kd, &Y, &ctr, cb.data, cb.data, cb.n_bytes,
+			   aes_rounds);
+      else
+	T = aes_gcm_dec_data (T, kd, &Y, &ctr, cb.data, cb.data, cb.n_bytes,
+			   aes_rounds);
+      aesni_chunk_block_flush (&cb);
+    }
+
+  return aes_gcm_final (T, kd, Y0, op->tag, data_bytes, op->aad_len,
+			op->tag_len, aes_rounds, is_encrypt);
+}
+
 static_always_inline u32
 aesni_ops_enc_aes_gcm (vlib_main_t * vm, vnet_crypto_op_t * ops[],
 		       u32 n_ops, aesni_key_size_t ks)
@@ -706,6 +1115,34 @@ next:
   return n_ops;
 }
 
+static_always_inline u32
+aesni_ops_aes_gcm_chained (vlib_main_t * vm, vnet_crypto_op_t * ops[],
+			   vnet_crypto_op_chunk_t * chunks, u32 n_ops,
+			   aesni_key_size_t ks, int is_encrypt)
+{
+  crypto_ia32_main_t *cm = &crypto_ia32_main;
+  aes_gcm_key_data_t *kd;
+  vnet_crypto_op_t *op;
+  u32 i, n_fail = 0;
+
+  for (i = 0; i < n_ops; i++)
+    {
+      op = ops[i];
+      kd = (aes_gcm_key_data_t *) cm->key_data[op->key_index];
+
+      if (aes_gcm_chained (op, chunks + op->chunk_index, kd,
+			   AESNI_KEY_ROUNDS (ks), is_encrypt))
+	op->status = VNET_CRYPTO_OP_STATUS_COMPLETED;
+      else
+	{
+	  op->status = VNET_CRYPTO_OP_STATUS_FAIL_BAD_HMAC;
+	  n_fail++;
+	}
+    }
+
+  return n_ops - n_fail;
+}
+
 static_always_inline void *
 aesni_gcm_key_exp (vnet_crypto_key_t * key, aesni_key_size_t ks)
 {
@@ -724,7 +1161,18 @@ aesni_gcm_key_exp (vnet_crypto_key_t * key, aesni_key_size_t ks)
     H = _mm_aesenc_si128 (H, kd->Ke[i]);
   H = _mm_aesenclast_si128 (H, kd->Ke[i]);
   H = aesni_gcm_bswap (H);
+#if __VAES__
+  {
+    __m128i Hi[16];
+    ghash_precompute (H, Hi, 16);
+    clib_memcpy_fast ((__m128i *) kd->Hi, Hi, sizeof (kd->Hi));
+    for (i = 0; i < 16; i++)
+      ((__m128i *) kd->Hi4)[i] = Hi[15 - i];
+    clib_memset ((__m128i *) kd->Hi4 + 16, 0, 3 * sizeof (__m128i));
+  }
+#else
   ghash_precompute (H, (__m128i *) kd->Hi, 8);
+#endif
   return kd;
 }
 
@@ -737,6 +1185,16 @@ static u32 aesni_ops_dec_aes_gcm_##x                                         \
 static u32 aesni_ops_enc_aes_gcm_##x                                         \
 (vlib_main_t * vm, vnet_crypto_op_t * ops[], u32 n_ops)                      \
 { return aesni_ops_enc_aes_gcm (vm, ops, n_ops, AESNI_KEY_##x); }            \
+static u32 aesni_ops_dec_aes_gcm_chained_##x                                 \
+(vlib_main_t * vm, vnet_crypto_op_t * ops[], vnet_crypto_op_chunk_t *chunks, \
+ u32 n_ops)                                                                  \
+{ return aesni_ops_aes_gcm_chained (vm, ops, chunks, n_ops, AESNI_KEY_##x,   \
+				    /* is_encrypt */ 0); }                   \
+static u32 aesni_ops_enc_aes_gcm_chained_##x                                 \
+(vlib_main_t * vm, vnet_crypto_op_t * ops[], vnet_crypto_op_chunk_t *chunks, \
+ u32 n_ops)                                                                  \
+{ return aesni_ops_aes_gcm_chained (vm, ops, chunks, n_ops, AESNI_KEY_##x,   \
+				    /* is_encrypt */ 1); }                   \
 static void * aesni_gcm_key_exp_##x (vnet_crypto_key_t *key)                 \
 { return aesni_gcm_key_exp (key, AESNI_KEY_##x); }
 
@@ -744,7 +1202,9 @@ foreach_aesni_gcm_handler_type;
 #undef _
 
 clib_error_t *
-#ifdef __AVX512F__
+#if __VAES__
+crypto_ia32_aesni_gcm_init_vaes (vlib_main_t * vm)
+#elif __AVX512F__
 crypto_ia32_aesni_gcm_init_avx512 (vlib_main_t * vm)
 #elif __AVX2__
 crypto_ia32_aesni_gcm_init_avx2 (vlib_main_t * vm)
@@ -761,6 +1221,12 @@ crypto_ia32_aesni_gcm_init_sse42 (vlib_main_t * vm)
   vnet_crypto_register_ops_handler (vm, cm->crypto_engine_index, \
 				    VNET_CRYPTO_OP_AES_##x##_GCM_DEC, \
 				    aesni_ops_dec_aes_gcm_##x); \
+  vnet_crypto_register_chained_ops_handler \
+    (vm, cm->crypto_engine_index, VNET_CRYPTO_OP_AES_##x##_GCM_ENC, \
+     aesni_ops_enc_aes_gcm_chained_##x); \
+  vnet_crypto_register_chained_ops_handler \
+    (vm, cm->crypto_engine_index, VNET_CRYPTO_OP_AES_##x##_GCM_DEC, \
+     aesni_ops_dec_aes_gcm_chained_##x); \
   cm->key_fn[VNET_CRYPTO_ALG_AES_##x##_GCM] = aesni_gcm_key_exp_##x;
   foreach_aesni_gcm_handler_type;
 #undef _
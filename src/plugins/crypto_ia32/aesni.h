@@ -215,6 +215,50 @@ aes_key_enc_to_dec (__m128i * k, aesni_key_size_t ks)
   k[rounds / 2] = _mm_aesimc_si128 (k[rounds / 2]);
 }
 
+/* Chained buffer ops: AES works on 16 byte blocks while chunk boundaries
+   can fall anywhere, so a block which straddles two or more chunks is
+   gathered here, processed in place and scattered back. */
+
+typedef struct
+{
+  u8 data[16];
+  u8 *dst[16];
+  u8 len[16];
+  u8 n_bytes;
+  u8 n_pieces;
+} aesni_chunk_block_t;
+
+/* add up to one block worth of bytes, returns number of bytes consumed */
+static_always_inline u32
+aesni_chunk_block_fill (aesni_chunk_block_t * cb, u8 * src, u8 * dst,
+			u32 len)
+{
+  u32 i, n = clib_min (len, 16 - cb->n_bytes);
+
+  if (n == 0)
+    return 0;
+
+  cb->dst[cb->n_pieces] = dst;
+  cb->len[cb->n_pieces] = n;
+  cb->n_pieces++;
+
+  /* never more than 15 bytes, not worth a memcpy call */
+  for (i = 0; i < n && cb->n_bytes < 16; i++)
+    cb->data[cb->n_bytes++] = src[i];
+  return n;
+}
+
+static_always_inline void
+aesni_chunk_block_flush (aesni_chunk_block_t * cb)
+{
+  u8 *p = cb->data;
+
+  for (int i = 0; i < cb->n_pieces; i++)
+    for (int j = 0; j < cb->len[i]; j++)
+      cb->dst[i][j] = *p++;
+  cb->n_bytes = cb->n_pieces = 0;
+}
+
 #endif /* __aesni_h__ */
 
 /*
@@ -22,7 +22,8 @@ typedef void *(crypto_ia32_key_fn_t) (vnet_crypto_key_t * key);
 
 typedef struct
 {
-  __m128i cbc_iv[4];
+  /* one IV generator per AES-CBC encrypt lane, up to 16 lanes with VAES */
+  __m128i cbc_iv[16];
 } crypto_ia32_per_thread_data_t;
 
 typedef struct
@@ -42,6 +43,10 @@ clib_error_t *crypto_ia32_aesni_cbc_init_avx512 (vlib_main_t * vm);
 clib_error_t *crypto_ia32_aesni_gcm_init_sse42 (vlib_main_t * vm);
 clib_error_t *crypto_ia32_aesni_gcm_init_avx2 (vlib_main_t * vm);
 clib_error_t *crypto_ia32_aesni_gcm_init_avx512 (vlib_main_t * vm);
+
+/* only built when the compiler supports VAES */
+clib_error_t __clib_weak *crypto_ia32_aesni_cbc_init_vaes (vlib_main_t * vm);
+clib_error_t __clib_weak *crypto_ia32_aesni_gcm_init_vaes (vlib_main_t * vm);
 #endif /* __crypto_ia32_h__ */
 
 /*
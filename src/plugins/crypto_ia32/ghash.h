@@ -242,6 +242,63 @@ ghash_precompute (__m128i H, __m128i * Hi, int count)
     Hi[i] = ghash_mul (Hi[0], Hi[i - 1]);
 }
 
+#ifdef __VPCLMULQDQ__
+/* 512-bit variant of the above, each of the 4 lanes multiplies one block
+   with its own hash key power, lanes are folded together before the
+   reduction which is shared with the 128-bit code */
+
+typedef struct
+{
+  __m512i mid, hi, lo;
+} ghash4_data_t;
+
+static_always_inline __m512i
+ghash4_xor3 (__m512i a, __m512i b, __m512i c)
+{
+  return _mm512_ternarylogic_epi32 (a, b, c, 0x96);
+}
+
+static_always_inline __m128i
+ghash4_fold (__m512i r)
+{
+  return ghash_xor3 (_mm512_castsi512_si128 (r) ^
+		     _mm512_extracti32x4_epi32 (r, 1),
+		     _mm512_extracti32x4_epi32 (r, 2),
+		     _mm512_extracti32x4_epi32 (r, 3));
+}
+
+static_always_inline void
+ghash4_mul_first (ghash4_data_t * gd, __m512i a, __m512i b)
+{
+  gd->hi = _mm512_clmulepi64_epi128 (a, b, 0x11);
+  gd->lo = _mm512_clmulepi64_epi128 (a, b, 0x00);
+  gd->mid = (_mm512_clmulepi64_epi128 (a, b, 0x01) ^
+	     _mm512_clmulepi64_epi128 (a, b, 0x10));
+}
+
+static_always_inline void
+ghash4_mul_next (ghash4_data_t * gd, __m512i a, __m512i b)
+{
+  gd->hi ^= _mm512_clmulepi64_epi128 (a, b, 0x11);
+  gd->lo ^= _mm512_clmulepi64_epi128 (a, b, 0x00);
+  gd->mid = ghash4_xor3 (gd->mid,
+			 _mm512_clmulepi64_epi128 (a, b, 0x01),
+			 _mm512_clmulepi64_epi128 (a, b, 0x10));
+}
+
+/* fold the lanes and do the 1st reduction step, remaining steps are
+   ghash_reduce2 () and ghash_final () on the returned 128-bit state */
+static_always_inline void
+ghash4_reduce (ghash4_data_t * gd4, ghash_data_t * gd)
+{
+  gd->hi = ghash4_fold (gd4->hi);
+  gd->lo = ghash4_fold (gd4->lo);
+  gd->mid = ghash4_fold (gd4->mid);
+  gd->pending = 0;
+  ghash_reduce (gd);
+}
+#endif
+
 #endif /* __ghash_h__ */
 
 /*
@@ -59,6 +59,15 @@ crypto_ia32_key_handler (vlib_main_t * vm, vnet_crypto_key_op_t kop,
   cm->key_data[idx] = cm->key_fn[key->alg] (key);
 }
 
+/* the vaes variant is built for icelake and uses 512-bit registers, some
+   cpus have vaes without avx512 */
+static_always_inline int
+crypto_ia32_cpu_supports_vaes (void)
+{
+  return clib_cpu_supports_vaes () && clib_cpu_supports_avx512f () &&
+    clib_cpu_supports_avx512bw () && clib_cpu_supports_avx512vl ();
+}
+
 clib_error_t *
 crypto_ia32_init (vlib_main_t * vm)
 {
@@ -76,7 +85,9 @@ crypto_ia32_init (vlib_main_t * vm)
     vnet_crypto_register_engine (vm, "ia32", 100,
 				 "Intel IA32 ISA Optimized Crypto");
 
-  if (clib_cpu_supports_avx512f ())
+  if (crypto_ia32_aesni_cbc_init_vaes && crypto_ia32_cpu_supports_vaes ())
+    error = crypto_ia32_aesni_cbc_init_vaes (vm);
+  else if (clib_cpu_supports_avx512f ())
     error = crypto_ia32_aesni_cbc_init_avx512 (vm);
   else if (clib_cpu_supports_avx2 ())
     error = crypto_ia32_aesni_cbc_init_avx2 (vm);
@@ -88,7 +99,10 @@ crypto_ia32_init (vlib_main_t * vm)
 
   if (clib_cpu_supports_pclmulqdq ())
     {
-      if (clib_cpu_supports_avx512f ())
+      if (crypto_ia32_aesni_gcm_init_vaes && crypto_ia32_cpu_supports_vaes ()
+	  && clib_cpu_supports_vpclmulqdq ())
+	error = crypto_ia32_aesni_gcm_init_vaes (vm);
+      else if (clib_cpu_supports_avx512f ())
 	error = crypto_ia32_aesni_gcm_init_avx512 (vm);
       else if (clib_cpu_supports_avx2 ())
 	error = crypto_ia32_aesni_gcm_init_avx2 (vm);
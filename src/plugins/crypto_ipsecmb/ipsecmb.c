@@ -360,6 +360,91 @@ ipsecmb_ops_gcm_cipher_dec_##a (vlib_main_t * vm, vnet_crypto_op_t * ops[],  \
 foreach_ipsecmb_gcm_cipher_op;
 #undef _
 
+/*
+ * Chained buffers use the GCM init/update/finalize API directly rather
+ * than the job manager, which only takes a single contiguous buffer
+ */
+static_always_inline u32
+ipsecmb_ops_gcm_cipher_chained_inline (vlib_main_t * vm,
+				       vnet_crypto_op_t * ops[],
+				       vnet_crypto_op_chunk_t * chunks,
+				       u32 n_ops, aes_gcm_init_t init,
+				       aes_gcm_enc_dec_update_t update,
+				       aes_gcm_enc_dec_finalize_t finalize,
+				       JOB_CIPHER_DIRECTION direction)
+{
+  ipsecmb_main_t *imbm = &ipsecmb_main;
+  struct gcm_context_data ctx;
+  vnet_crypto_op_chunk_t *chp;
+  u32 i, j, n_fail = 0;
+  u8 scratch[64];
+
+  for (i = 0; i < n_ops; i++)
+    {
+      struct gcm_key_data *kd;
+      vnet_crypto_op_t *op = ops[i];
+      kd = (struct gcm_key_data *) imbm->key_data[op->key_index];
+
+      init (kd, &ctx, op->iv, op->aad, op->aad_len);
+
+      chp = chunks + op->chunk_index;
+      for (j = 0; j < op->n_chunks; j++)
+	{
+	  update (kd, &ctx, chp->dst, chp->src, chp->len);
+	  chp += 1;
+	}
+
+      if (DECRYPT == direction)
+	{
+	  finalize (kd, &ctx, scratch, op->tag_len);
+	  if ((memcmp (op->tag, scratch, op->tag_len)))
+	    {
+	      n_fail++;
+	      op->status = VNET_CRYPTO_OP_STATUS_FAIL_BAD_HMAC;
+	      continue;
+	    }
+	}
+      else
+	finalize (kd, &ctx, op->tag, op->tag_len);
+
+      op->status = VNET_CRYPTO_OP_STATUS_COMPLETED;
+    }
+
+  return n_ops - n_fail;
+}
+
+#define _(a, b)                                                              \
+static_always_inline u32                                                     \
+ipsecmb_ops_gcm_cipher_enc_chained_##a (vlib_main_t * vm,                    \
+                                        vnet_crypto_op_t * ops[],            \
+                                        vnet_crypto_op_chunk_t * chunks,     \
+                                        u32 n_ops)                           \
+{                                                                            \
+  ipsecmb_per_thread_data_t *ptd =                                           \
+    vec_elt_at_index (ipsecmb_main.per_thread_data, vm->thread_index);       \
+  return ipsecmb_ops_gcm_cipher_chained_inline                               \
+    (vm, ops, chunks, n_ops, ptd->mgr->gcm##b##_init,                        \
+     ptd->mgr->gcm##b##_enc_update, ptd->mgr->gcm##b##_enc_finalize,         \
+     ENCRYPT);                                                               \
+}                                                                            \
+                                                                             \
+static_always_inline u32                                                     \
+ipsecmb_ops_gcm_cipher_dec_chained_##a (vlib_main_t * vm,                    \
+                                        vnet_crypto_op_t * ops[],            \
+                                        vnet_crypto_op_chunk_t * chunks,     \
+                                        u32 n_ops)                           \
+{                                                                            \
+  ipsecmb_per_thread_data_t *ptd =                                           \
+    vec_elt_at_index (ipsecmb_main.per_thread_data, vm->thread_index);       \
+  return ipsecmb_ops_gcm_cipher_chained_inline                               \
+    (vm, ops, chunks, n_ops, ptd->mgr->gcm##b##_init,                        \
+     ptd->mgr->gcm##b##_dec_update, ptd->mgr->gcm##b##_dec_finalize,         \
+     DECRYPT);                                                               \
+}
+
+foreach_ipsecmb_gcm_cipher_op;
+#undef _
+
 clib_error_t *
 crypto_ipsecmb_iv_init (ipsecmb_main_t * imbm)
 {
@@ -533,6 +618,12 @@ crypto_ipsecmb_init (vlib_main_t * vm)
                                     ipsecmb_ops_gcm_cipher_enc_##a);    \
   vnet_crypto_register_ops_handler (vm, eidx, VNET_CRYPTO_OP_##a##_DEC, \
                                     ipsecmb_ops_gcm_cipher_dec_##a);    \
+  vnet_crypto_register_chained_ops_handler                              \
+    (vm, eidx, VNET_CRYPTO_OP_##a##_ENC,                                \
+     ipsecmb_ops_gcm_cipher_enc_chained_##a);                           \
+  vnet_crypto_register_chained_ops_handler                              \
+    (vm, eidx, VNET_CRYPTO_OP_##a##_DEC,                                \
+     ipsecmb_ops_gcm_cipher_dec_chained_##a);                           \
   ad = imbm->alg_data + VNET_CRYPTO_ALG_##a;                            \
   ad->data_size = sizeof (struct gcm_key_data);                         \
   ad->aes_gcm_pre = m->gcm##b##_pre;                                    \
@@ -29,6 +29,7 @@ typedef struct
   CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
   EVP_CIPHER_CTX *evp_cipher_ctx;
   HMAC_CTX *hmac_ctx;
+  u8 *scratch;
 #if OPENSSL_VERSION_NUMBER < 0x10100000L
   HMAC_CTX _hmac_ctx;
 #endif
@@ -57,14 +58,48 @@ static openssl_per_thread_data_t *per_thread_data = 0;
   _(SHA384, EVP_sha384) \
   _(SHA512, EVP_sha512)
 
+/* CBC output trails the input by up to one block, so chained buffers are
+   encrypted or decrypted into a scratch area and copied back */
+static_always_inline u8 *
+openssl_chained_scratch (openssl_per_thread_data_t * ptd,
+			 vnet_crypto_op_t * op,
+			 vnet_crypto_op_chunk_t * chunks)
+{
+  vnet_crypto_op_chunk_t *chp = chunks + op->chunk_index;
+  u32 j, len = 0;
+
+  for (j = 0; j < op->n_chunks; j++)
+    len += chp[j].len;
+
+  vec_validate (ptd->scratch, len + EVP_MAX_BLOCK_LENGTH);
+  return ptd->scratch;
+}
+
+static_always_inline void
+openssl_chained_copy_out (vnet_crypto_op_t * op,
+			  vnet_crypto_op_chunk_t * chunks, u8 * out)
+{
+  vnet_crypto_op_chunk_t *chp = chunks + op->chunk_index;
+  u32 j;
+
+  for (j = 0; j < op->n_chunks; j++)
+    {
+      clib_memcpy_fast (chp->dst, out, chp->len);
+      out += chp->len;
+      chp += 1;
+    }
+}
+
 static_always_inline u32
-openssl_ops_enc_cbc (vlib_main_t * vm, vnet_crypto_op_t * ops[], u32 n_ops,
+openssl_ops_enc_cbc (vlib_main_t * vm, vnet_crypto_op_t * ops[],
+		     vnet_crypto_op_chunk_t * chunks, u32 n_ops,
 		     const EVP_CIPHER * cipher)
 {
   openssl_per_thread_data_t *ptd = vec_elt_at_index (per_thread_data,
 						     vm->thread_index);
   EVP_CIPHER_CTX *ctx = ptd->evp_cipher_ctx;
-  u32 i;
+  vnet_crypto_op_chunk_t *chp;
+  u32 i, j;
   for (i = 0; i < n_ops; i++)
     {
       vnet_crypto_op_t *op = ops[i];
@@ -81,22 +116,45 @@ openssl_ops_enc_cbc (vlib_main_t * vm, vnet_crypto_op_t * ops[], u32 n_ops,
 	RAND_bytes (op->iv, iv_len);
 
       EVP_EncryptInit_ex (ctx, cipher, NULL, key->data, op->iv);
-      EVP_EncryptUpdate (ctx, op->dst, &out_len, op->src, op->len);
-      if (out_len < op->len)
-	EVP_EncryptFinal_ex (ctx, op->dst + out_len, &out_len);
+
+      if (op->flags & VNET_CRYPTO_OP_FLAG_CHAINED_BUFFERS)
+	{
+	  u8 *out = openssl_chained_scratch (ptd, op, chunks);
+	  u32 offset = 0;
+
+	  EVP_CIPHER_CTX_set_padding (ctx, 0);
+	  chp = chunks + op->chunk_index;
+	  for (j = 0; j < op->n_chunks; j++)
+	    {
+	      EVP_EncryptUpdate (ctx, out + offset, &out_len, chp->src,
+				 chp->len);
+	      offset += out_len;
+	      chp += 1;
+	    }
+	  EVP_EncryptFinal_ex (ctx, out + offset, &out_len);
+	  openssl_chained_copy_out (op, chunks, out);
+	}
+      else
+	{
+	  EVP_EncryptUpdate (ctx, op->dst, &out_len, op->src, op->len);
+	  if (out_len < op->len)
+	    EVP_EncryptFinal_ex (ctx, op->dst + out_len, &out_len);
+	}
       op->status = VNET_CRYPTO_OP_STATUS_COMPLETED;
     }
   return n_ops;
 }
 
 static_always_inline u32
-openssl_ops_dec_cbc (vlib_main_t * vm, vnet_crypto_op_t * ops[], u32 n_ops,
+openssl_ops_dec_cbc (vlib_main_t * vm, vnet_crypto_op_t * ops[],
+		     vnet_crypto_op_chunk_t * chunks, u32 n_ops,
 		     const EVP_CIPHER * cipher)
 {
   openssl_per_thread_data_t *ptd = vec_elt_at_index (per_thread_data,
 						     vm->thread_index);
   EVP_CIPHER_CTX *ctx = ptd->evp_cipher_ctx;
-  u32 i;
+  vnet_crypto_op_chunk_t *chp;
+  u32 i, j;
   for (i = 0; i < n_ops; i++)
     {
       vnet_crypto_op_t *op = ops[i];
@@ -104,22 +162,45 @@ openssl_ops_dec_cbc (vlib_main_t * vm, vnet_crypto_op_t * ops[], u32 n_ops,
       int out_len;
 
       EVP_DecryptInit_ex (ctx, cipher, NULL, key->data, op->iv);
-      EVP_DecryptUpdate (ctx, op->dst, &out_len, op->src, op->len);
-      if (out_len < op->len)
-	EVP_DecryptFinal_ex (ctx, op->dst + out_len, &out_len);
+
+      if (op->flags & VNET_CRYPTO_OP_FLAG_CHAINED_BUFFERS)
+	{
+	  u8 *out = openssl_chained_scratch (ptd, op, chunks);
+	  u32 offset = 0;
+
+	  EVP_CIPHER_CTX_set_padding (ctx, 0);
+	  chp = chunks + op->chunk_index;
+	  for (j = 0; j < op->n_chunks; j++)
+	    {
+	      EVP_DecryptUpdate (ctx, out + offset, &out_len, chp->src,
+				 chp->len);
+	      offset += out_len;
+	      chp += 1;
+	    }
+	  EVP_DecryptFinal_ex (ctx, out + offset, &out_len);
+	  openssl_chained_copy_out (op, chunks, out);
+	}
+      else
+	{
+	  EVP_DecryptUpdate (ctx, op->dst, &out_len, op->src, op->len);
+	  if (out_len < op->len)
+	    EVP_DecryptFinal_ex (ctx, op->dst + out_len, &out_len);
+	}
       op->status = VNET_CRYPTO_OP_STATUS_COMPLETED;
     }
   return n_ops;
 }
 
 static_always_inline u32
-openssl_ops_enc_gcm (vlib_main_t * vm, vnet_crypto_op_t * ops[], u32 n_ops,
+openssl_ops_enc_gcm (vlib_main_t * vm, vnet_crypto_op_t * ops[],
+		     vnet_crypto_op_chunk_t * chunks, u32 n_ops,
 		     const EVP_CIPHER * cipher)
 {
   openssl_per_thread_data_t *ptd = vec_elt_at_index (per_thread_data,
 						     vm->thread_index);
   EVP_CIPHER_CTX *ctx = ptd->evp_cipher_ctx;
-  u32 i;
+  vnet_crypto_op_chunk_t *chp;
+  u32 i, j;
   for (i = 0; i < n_ops; i++)
     {
       vnet_crypto_op_t *op = ops[i];
@@ -134,8 +215,22 @@ openssl_ops_enc_gcm (vlib_main_t * vm, vnet_crypto_op_t * ops[], u32 n_ops,
       EVP_EncryptInit_ex (ctx, 0, 0, key->data, op->iv);
       if (op->aad_len)
 	EVP_EncryptUpdate (ctx, NULL, &len, op->aad, op->aad_len);
-      EVP_EncryptUpdate (ctx, op->dst, &len, op->src, op->len);
-      EVP_EncryptFinal_ex (ctx, op->dst + len, &len);
+      if (op->flags & VNET_CRYPTO_OP_FLAG_CHAINED_BUFFERS)
+	{
+	  /* GCM is a stream mode, output matches input chunk by chunk */
+	  chp = chunks + op->chunk_index;
+	  for (j = 0; j < op->n_chunks; j++)
+	    {
+	      EVP_EncryptUpdate (ctx, chp->dst, &len, chp->src, chp->len);
+	      chp += 1;
+	    }
+	  EVP_EncryptFinal_ex (ctx, 0, &len);
+	}
+      else
+	{
+	  EVP_EncryptUpdate (ctx, op->dst, &len, op->src, op->len);
+	  EVP_EncryptFinal_ex (ctx, op->dst + len, &len);
+	}
       EVP_CIPHER_CTX_ctrl (ctx, EVP_CTRL_GCM_GET_TAG, op->tag_len, op->tag);
       op->status = VNET_CRYPTO_OP_STATUS_COMPLETED;
     }
@@ -143,17 +238,20 @@ openssl_ops_enc_gcm (vlib_main_t * vm, vnet_crypto_op_t * ops[], u32 n_ops,
 }
 
 static_always_inline u32
-openssl_ops_dec_gcm (vlib_main_t * vm, vnet_crypto_op_t * ops[], u32 n_ops,
+openssl_ops_dec_gcm (vlib_main_t * vm, vnet_crypto_op_t * ops[],
+		     vnet_crypto_op_chunk_t * chunks, u32 n_ops,
 		     const EVP_CIPHER * cipher)
 {
   openssl_per_thread_data_t *ptd = vec_elt_at_index (per_thread_data,
 						     vm->thread_index);
   EVP_CIPHER_CTX *ctx = ptd->evp_cipher_ctx;
-  u32 i, n_fail = 0;
+  vnet_crypto_op_chunk_t *chp;
+  u32 i, j, n_fail = 0;
   for (i = 0; i < n_ops; i++)
     {
       vnet_crypto_op_t *op = ops[i];
       vnet_crypto_key_t *key = vnet_crypto_get_key (op->key_index);
+      u8 *last_dst;
       int len;
 
       EVP_DecryptInit_ex (ctx, cipher, 0, 0, 0);
@@ -161,10 +259,24 @@ openssl_ops_dec_gcm (vlib_main_t * vm, vnet_crypto_op_t * ops[], u32 n_ops,
       EVP_DecryptInit_ex (ctx, 0, 0, key->data, op->iv);
       if (op->aad_len)
 	EVP_DecryptUpdate (ctx, 0, &len, op->aad, op->aad_len);
-      EVP_DecryptUpdate (ctx, op->dst, &len, op->src, op->len);
+      if (op->flags & VNET_CRYPTO_OP_FLAG_CHAINED_BUFFERS)
+	{
+	  chp = chunks + op->chunk_index;
+	  for (j = 0; j < op->n_chunks; j++)
+	    {
+	      EVP_DecryptUpdate (ctx, chp->dst, &len, chp->src, chp->len);
+	      chp += 1;
+	    }
+	  last_dst = 0;
+	}
+      else
+	{
+	  EVP_DecryptUpdate (ctx, op->dst, &len, op->src, op->len);
+	  last_dst = op->dst + len;
+	}
       EVP_CIPHER_CTX_ctrl (ctx, EVP_CTRL_GCM_SET_TAG, op->tag_len, op->tag);
 
-      if (EVP_DecryptFinal_ex (ctx, op->dst + len, &len) > 0)
+      if (EVP_DecryptFinal_ex (ctx, last_dst, &len) > 0)
 	op->status = VNET_CRYPTO_OP_STATUS_COMPLETED;
       else
 	{
@@ -176,14 +288,16 @@ openssl_ops_dec_gcm (vlib_main_t * vm, vnet_crypto_op_t * ops[], u32 n_ops,
 }
 
 static_always_inline u32
-openssl_ops_hmac (vlib_main_t * vm, vnet_crypto_op_t * ops[], u32 n_ops,
+openssl_ops_hmac (vlib_main_t * vm, vnet_crypto_op_t * ops[],
+		  vnet_crypto_op_chunk_t * chunks, u32 n_ops,
 		  const EVP_MD * md)
 {
   u8 buffer[64];
   openssl_per_thread_data_t *ptd = vec_elt_at_index (per_thread_data,
 						     vm->thread_index);
   HMAC_CTX *ctx = ptd->hmac_ctx;
-  u32 i, n_fail = 0;
+  vnet_crypto_op_chunk_t *chp;
+  u32 i, j, n_fail = 0;
   for (i = 0; i < n_ops; i++)
     {
       vnet_crypto_op_t *op = ops[i];
@@ -192,7 +306,17 @@ openssl_ops_hmac (vlib_main_t * vm, vnet_crypto_op_t * ops[], u32 n_ops,
       size_t sz = op->digest_len ? op->digest_len : EVP_MD_size (md);
 
       HMAC_Init_ex (ctx, key->data, vec_len (key->data), md, NULL);
-      HMAC_Update (ctx, op->src, op->len);
+      if (op->flags & VNET_CRYPTO_OP_FLAG_CHAINED_BUFFERS)
+	{
+	  chp = chunks + op->chunk_index;
+	  for (j = 0; j < op->n_chunks; j++)
+	    {
+	      HMAC_Update (ctx, chp->src, chp->len);
+	      chp += 1;
+	    }
+	}
+      else
+	HMAC_Update (ctx, op->src, op->len);
       HMAC_Final (ctx, buffer, &out_len);
 
       if (op->flags & VNET_CRYPTO_OP_FLAG_HMAC_CHECK)
@@ -214,11 +338,21 @@ openssl_ops_hmac (vlib_main_t * vm, vnet_crypto_op_t * ops[], u32 n_ops,
 #define _(m, a, b) \
 static u32 \
 openssl_ops_enc_##a (vlib_main_t * vm, vnet_crypto_op_t * ops[], u32 n_ops) \
-{ return openssl_ops_enc_##m (vm, ops, n_ops, b ()); } \
+{ return openssl_ops_enc_##m (vm, ops, 0, n_ops, b ()); } \
 \
 u32 \
 openssl_ops_dec_##a (vlib_main_t * vm, vnet_crypto_op_t * ops[], u32 n_ops) \
-{ return openssl_ops_dec_##m (vm, ops, n_ops, b ()); }
+{ return openssl_ops_dec_##m (vm, ops, 0, n_ops, b ()); } \
+\
+static u32 \
+openssl_ops_enc_chained_##a (vlib_main_t * vm, vnet_crypto_op_t * ops[], \
+			     vnet_crypto_op_chunk_t *chunks, u32 n_ops) \
+{ return openssl_ops_enc_##m (vm, ops, chunks, n_ops, b ()); } \
+\
+static u32 \
+openssl_ops_dec_chained_##a (vlib_main_t * vm, vnet_crypto_op_t * ops[], \
+			     vnet_crypto_op_chunk_t *chunks, u32 n_ops) \
+{ return openssl_ops_dec_##m (vm, ops, chunks, n_ops, b ()); }
 
 foreach_openssl_evp_op;
 #undef _
@@ -226,7 +360,12 @@ foreach_openssl_evp_op;
 #define _(a, b) \
 static u32 \
 openssl_ops_hmac_##a (vlib_main_t * vm, vnet_crypto_op_t * ops[], u32 n_ops) \
-{ return openssl_ops_hmac (vm, ops, n_ops, b ()); } \
+{ return openssl_ops_hmac (vm, ops, 0, n_ops, b ()); } \
+\
+static u32 \
+openssl_ops_hmac_chained_##a (vlib_main_t * vm, vnet_crypto_op_t * ops[], \
+			      vnet_crypto_op_chunk_t *chunks, u32 n_ops) \
+{ return openssl_ops_hmac (vm, ops, chunks, n_ops, b ()); }
 
 foreach_openssl_hmac_op;
 #undef _
@@ -247,7 +386,13 @@ crypto_openssl_init (vlib_main_t * vm)
   vnet_crypto_register_ops_handler (vm, eidx, VNET_CRYPTO_OP_##a##_ENC, \
 				    openssl_ops_enc_##a); \
   vnet_crypto_register_ops_handler (vm, eidx, VNET_CRYPTO_OP_##a##_DEC, \
-				    openssl_ops_dec_##a);
+				    openssl_ops_dec_##a); \
+  vnet_crypto_register_chained_ops_handler (vm, eidx, \
+					    VNET_CRYPTO_OP_##a##_ENC, \
+					    openssl_ops_enc_chained_##a); \
+  vnet_crypto_register_chained_ops_handler (vm, eidx, \
+					    VNET_CRYPTO_OP_##a##_DEC, \
+					    openssl_ops_dec_chained_##a);
 
   foreach_openssl_evp_op;
 #undef _
@@ -255,6 +400,9 @@ crypto_openssl_init (vlib_main_t * vm)
 #define _(a, b) \
   vnet_crypto_register_ops_handler (vm, eidx, VNET_CRYPTO_OP_##a##_HMAC, \
 				    openssl_ops_hmac_##a); \
+  vnet_crypto_register_chained_ops_handler (vm, eidx, \
+					    VNET_CRYPTO_OP_##a##_HMAC, \
+					    openssl_ops_hmac_chained_##a);
 
   foreach_openssl_hmac_op;
 #undef _
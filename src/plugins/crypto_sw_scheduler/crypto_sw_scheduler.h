@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2019 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __crypto_sw_scheduler_h__
+#define __crypto_sw_scheduler_h__
+
+#define CRYPTO_SW_SCHEDULER_QUEUE_SIZE 64
+#define CRYPTO_SW_SCHEDULER_QUEUE_MASK (CRYPTO_SW_SCHEDULER_QUEUE_SIZE - 1)
+
+/*
+ * Per-thread ring of submitted frames. Only the owning thread moves head
+ * (enqueue) and tail (dequeue of completed frames); crypto workers scan the
+ * slots in between and claim pending frames by CAS on the frame state.
+ */
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  u32 head;
+  u32 tail;
+  vnet_crypto_async_frame_t *jobs[CRYPTO_SW_SCHEDULER_QUEUE_SIZE];
+} crypto_sw_scheduler_queue_t;
+
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  crypto_sw_scheduler_queue_t queue;
+  u32 last_serve_thread;
+  u8 self_crypto_enabled;
+  u64 n_frames_processed;
+} crypto_sw_scheduler_per_thread_data_t;
+
+typedef struct
+{
+  u32 crypto_engine_index;
+  crypto_sw_scheduler_per_thread_data_t *per_thread_data;
+} crypto_sw_scheduler_main_t;
+
+extern crypto_sw_scheduler_main_t crypto_sw_scheduler_main;
+
+int crypto_sw_scheduler_set_worker_crypto (u32 worker_idx, u8 enabled);
+
+#endif /* __crypto_sw_scheduler_h__ */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2019 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vlib/vlib.h>
+#include <vnet/plugin/plugin.h>
+#include <vnet/crypto/crypto.h>
+#include <vpp/app/version.h>
+
+#include <crypto_sw_scheduler/crypto_sw_scheduler.h>
+
+crypto_sw_scheduler_main_t crypto_sw_scheduler_main;
+
+int
+crypto_sw_scheduler_set_worker_crypto (u32 worker_idx, u8 enabled)
+{
+  crypto_sw_scheduler_main_t *cm = &crypto_sw_scheduler_main;
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  crypto_sw_scheduler_per_thread_data_t *ptd;
+  u32 count = 0, i = vlib_num_workers () > 0;
+
+  if (worker_idx >= vlib_num_workers ())
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  for (; i < tm->n_vlib_mains; i++)
+    {
+      ptd = cm->per_thread_data + i;
+      count += ptd->self_crypto_enabled;
+    }
+
+  ptd = cm->per_thread_data + worker_idx + 1;
+
+  /* at least one thread has to keep processing frames */
+  if (enabled || count > 1)
+    ptd->self_crypto_enabled = enabled;
+  else
+    return VNET_API_ERROR_INVALID_VALUE_2;
+
+  return 0;
+}
+
+static int
+crypto_sw_scheduler_frame_enqueue (vlib_main_t * vm,
+				   vnet_crypto_async_frame_t * frame)
+{
+  crypto_sw_scheduler_main_t *cm = &crypto_sw_scheduler_main;
+  crypto_sw_scheduler_queue_t *q =
+    &cm->per_thread_data[vm->thread_index].queue;
+  u32 head = q->head;
+
+  if (PREDICT_FALSE (head - q->tail >= CRYPTO_SW_SCHEDULER_QUEUE_SIZE))
+    return -1;
+
+  q->jobs[head & CRYPTO_SW_SCHEDULER_QUEUE_MASK] = frame;
+  clib_atomic_store_rel_n (&q->head, head + 1);
+  return 0;
+}
+
+static_always_inline vnet_crypto_async_frame_t *
+crypto_sw_scheduler_claim_frame (crypto_sw_scheduler_queue_t * q)
+{
+  vnet_crypto_async_frame_t *f;
+  u32 head = clib_atomic_load_acq_n (&q->head);
+  u32 i;
+
+  /* slots may be recycled under us, but frames live in a preallocated pool
+     so the CAS can only ever succeed on a genuinely pending frame */
+  for (i = clib_atomic_load_acq_n (&q->tail); i != head; i++)
+    {
+      f = q->jobs[i & CRYPTO_SW_SCHEDULER_QUEUE_MASK];
+      if (f->state == VNET_CRYPTO_FRAME_STATE_PENDING &&
+	  clib_atomic_bool_cmp_and_swap (&f->state,
+					 VNET_CRYPTO_FRAME_STATE_PENDING,
+					 VNET_CRYPTO_FRAME_STATE_WORK_IN_PROGRESS))
+	return f;
+    }
+
+  return 0;
+}
+
+static vnet_crypto_async_frame_t *
+crypto_sw_scheduler_frame_dequeue (vlib_main_t * vm)
+{
+  crypto_sw_scheduler_main_t *cm = &crypto_sw_scheduler_main;
+  crypto_sw_scheduler_per_thread_data_t *ptd =
+    cm->per_thread_data + vm->thread_index;
+  crypto_sw_scheduler_queue_t *q = &ptd->queue;
+  vnet_crypto_async_frame_t *f;
+  u32 n_threads = vec_len (cm->per_thread_data);
+  u32 i, t;
+
+  if (ptd->self_crypto_enabled)
+    {
+      /* serve one frame per call, rotating over the enqueueing threads */
+      for (i = 0; i < n_threads; i++)
+	{
+	  t = (ptd->last_serve_thread + 1 + i) % n_threads;
+	  f = crypto_sw_scheduler_claim_frame (&cm->per_thread_data[t].queue);
+	  if (f)
+	    {
+	      vnet_crypto_async_process_frame (vm, f);
+	      ptd->last_serve_thread = t;
+	      ptd->n_frames_processed++;
+	      break;
+	    }
+	}
+    }
+
+  /* frames complete out of order but are handed back in submission order */
+  if (q->tail == q->head)
+    return 0;
+
+  f = q->jobs[q->tail & CRYPTO_SW_SCHEDULER_QUEUE_MASK];
+  if (clib_atomic_load_acq_n (&f->state) < VNET_CRYPTO_FRAME_STATE_SUCCESS)
+    return 0;
+
+  q->tail++;
+  return f;
+}
+
+static clib_error_t *
+sw_scheduler_set_worker_crypto (vlib_main_t * vm, unformat_input_t * input,
+				vlib_cli_command_t * cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  u32 worker_index = ~0;
+  u8 crypto_enable = 0;
+  int rv;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return clib_error_return (0, "expected worker index and on|off");
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "worker %u", &worker_index))
+	{
+	  if (unformat (line_input, "crypto"))
+	    {
+	      if (unformat (line_input, "on"))
+		crypto_enable = 1;
+	      else if (unformat (line_input, "off"))
+		crypto_enable = 0;
+	      else
+		return clib_error_return (0, "unknown input '%U'",
+					  format_unformat_error, line_input);
+	    }
+	  else
+	    return clib_error_return (0, "unknown input '%U'",
+				      format_unformat_error, line_input);
+	}
+      else
+	return clib_error_return (0, "unknown input '%U'",
+				  format_unformat_error, line_input);
+    }
+  unformat_free (line_input);
+
+  rv = crypto_sw_scheduler_set_worker_crypto (worker_index, crypto_enable);
+  if (rv == VNET_API_ERROR_INVALID_VALUE)
+    return clib_error_return (0, "invalid worker idx: %d", worker_index);
+  else if (rv == VNET_API_ERROR_INVALID_VALUE_2)
+    return clib_error_return (0, "cannot disable all crypto workers");
+
+  return 0;
+}
+
+/*?
+ * This command sets if worker will do crypto processing.
+ *
+ * @cliexpar
+ * Example of how to set worker crypto processing off:
+ * @cliexstart{set sw_scheduler worker 0 crypto off}
+ * @cliexend
+ ?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (cmd_set_sw_scheduler_worker_crypto, static) = {
+  .path = "set sw_scheduler",
+  .short_help = "set sw_scheduler worker <idx> crypto <on|off>",
+  .function = sw_scheduler_set_worker_crypto,
+  .is_mp_safe = 1,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+sw_scheduler_show_workers (vlib_main_t * vm, unformat_input_t * input,
+			   vlib_cli_command_t * cmd)
+{
+  crypto_sw_scheduler_main_t *cm = &crypto_sw_scheduler_main;
+  crypto_sw_scheduler_per_thread_data_t *ptd;
+  u32 i;
+
+  vlib_cli_output (vm, "%-10s%-10s%-12s%s", "Thread", "Crypto", "Queued",
+		   "Processed");
+
+  for (i = 0; i < vec_len (cm->per_thread_data); i++)
+    {
+      ptd = cm->per_thread_data + i;
+      vlib_cli_output (vm, "%-10u%-10s%-12u%lu", i,
+		       ptd->self_crypto_enabled ? "on" : "off",
+		       ptd->queue.head - ptd->queue.tail,
+		       ptd->n_frames_processed);
+    }
+
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (cmd_show_sw_scheduler_workers, static) = {
+  .path = "show sw_scheduler workers",
+  .short_help = "show sw_scheduler workers",
+  .function = sw_scheduler_show_workers,
+  .is_mp_safe = 1,
+};
+/* *INDENT-ON* */
+
+clib_error_t *
+crypto_sw_scheduler_init (vlib_main_t * vm)
+{
+  crypto_sw_scheduler_main_t *cm = &crypto_sw_scheduler_main;
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  crypto_sw_scheduler_per_thread_data_t *ptd;
+  u32 i;
+
+  vec_validate_aligned (cm->per_thread_data, tm->n_vlib_mains - 1,
+			CLIB_CACHE_LINE_BYTES);
+
+  /* the main thread only processes frames when there are no workers */
+  for (i = 0; i < tm->n_vlib_mains; i++)
+    {
+      ptd = cm->per_thread_data + i;
+      ptd->self_crypto_enabled = i > 0 || vlib_num_workers () == 0;
+      ptd->last_serve_thread = i;
+    }
+
+  cm->crypto_engine_index =
+    vnet_crypto_register_engine (vm, "sw_scheduler", 100,
+				 "SW Scheduler Async Engine");
+
+  vnet_crypto_register_async_handler (vm, cm->crypto_engine_index,
+				      crypto_sw_scheduler_frame_enqueue,
+				      crypto_sw_scheduler_frame_dequeue);
+
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_INIT_FUNCTION (crypto_sw_scheduler_init) = {
+  .runs_after = VLIB_INITS ("vnet_crypto_init"),
+};
+
+VLIB_PLUGIN_REGISTER () = {
+  .version = VPP_BUILD_VER,
+  .description = "SW Scheduler Async Crypto Engine",
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -30,6 +30,109 @@ sort_registrations (void *a0, void *a1)
   return (strncmp (r0[0]->name, r1[0]->name, 256));
 }
 
+static void
+test_crypto_check_ops (vlib_main_t * vm, crypto_test_main_t * tm,
+		       unittest_crypto_test_registration_t ** rv,
+		       vnet_crypto_op_t * ops, int chained)
+{
+  unittest_crypto_test_registration_t *r;
+  vnet_crypto_op_t *op;
+  u8 *s = 0, *err = 0;
+
+  /* *INDENT-OFF* */
+  vec_foreach (op, ops)
+    {
+      int fail = 0;
+      r = rv[op->user_data];
+      unittest_crypto_test_data_t *exp_pt = 0, *exp_ct = 0;
+      unittest_crypto_test_data_t *exp_digest = 0, *exp_tag = 0;
+
+      switch (vnet_crypto_get_op_type (op->op))
+	{
+	case VNET_CRYPTO_OP_TYPE_AEAD_ENCRYPT:
+	  exp_tag = &r->tag;
+          /* fall through */
+	case VNET_CRYPTO_OP_TYPE_ENCRYPT:
+	  exp_ct = &r->ciphertext;
+	  break;
+	case VNET_CRYPTO_OP_TYPE_AEAD_DECRYPT:
+	case VNET_CRYPTO_OP_TYPE_DECRYPT:
+	  exp_pt = &r->plaintext;
+	  break;
+	case VNET_CRYPTO_OP_TYPE_HMAC:
+	  exp_digest = &r->digest;
+	  break;
+	default:
+	  break;
+	}
+
+      vec_reset_length (err);
+
+      /* not all engines implement chained ops for all algs */
+      if (chained && op->status == VNET_CRYPTO_OP_STATUS_FAIL_NO_HANDLER)
+	continue;
+
+      if (op->status != VNET_CRYPTO_OP_STATUS_COMPLETED)
+	err = format (err, "%sengine error: %U", vec_len (err) ? ", " : "",
+		      format_vnet_crypto_op_status, op->status);
+
+      if (exp_ct && memcmp (op->dst, exp_ct->data, exp_ct->length) != 0)
+	err = format (err, "%sciphertext mismatch",
+		      vec_len (err) ? ", " : "");
+
+      if (exp_pt && memcmp (op->dst, exp_pt->data, exp_pt->length) != 0)
+	err = format (err, "%splaintext mismatch", vec_len (err) ? ", " : "");
+
+      if (exp_tag && memcmp (op->tag, exp_tag->data, exp_tag->length) != 0)
+	err = format (err, "%stag mismatch", vec_len (err) ? ", " : "");
+
+      if (exp_digest &&
+	  memcmp (op->digest, exp_digest->data, exp_digest->length) != 0)
+	err = format (err, "%sdigest mismatch", vec_len (err) ? ", " : "");
+
+      vec_reset_length (s);
+      s = format (s, "%s (%U%s)", r->name, format_vnet_crypto_op, op->op,
+		  chained ? " chained" : "");
+
+      if (vec_len (err))
+	fail = 1;
+
+      vlib_cli_output (vm, "%-60v%s%v", s, vec_len (err) ? "FAIL: " : "OK",
+		       err);
+      if (tm->verbose)
+	{
+	  if (tm->verbose == 2)
+	    fail = 1;
+
+	  if (exp_ct && fail)
+	    vlib_cli_output (vm, "Expected ciphertext:\n%U"
+			     "\nCalculated ciphertext:\n%U",
+			     format_hexdump, exp_ct->data, exp_ct->length,
+			     format_hexdump, op->dst, exp_ct->length);
+	  if (exp_pt && fail)
+	    vlib_cli_output (vm, "Expected plaintext:\n%U"
+			     "\nCalculated plaintext:\n%U",
+			     format_hexdump, exp_pt->data, exp_pt->length,
+			     format_hexdump, op->dst, exp_pt->length);
+	  if (r->tag.length && fail)
+	    vlib_cli_output (vm, "Expected tag:\n%U"
+			     "\nCalculated tag:\n%U",
+			     format_hexdump, r->tag.data, r->tag.length,
+			     format_hexdump, op->tag, op->tag_len);
+	  if (exp_digest && fail)
+	    vlib_cli_output (vm, "Expected digest:\n%U"
+			     "\nCalculated Digest:\n%U",
+			     format_hexdump, exp_digest->data,
+			     exp_digest->length, format_hexdump, op->digest,
+			     op->digest_len);
+	}
+    }
+  /* *INDENT-ON* */
+
+  vec_free (err);
+  vec_free (s);
+}
+
 static clib_error_t *
 test_crypto (vlib_main_t * vm, crypto_test_main_t * tm)
 {
@@ -37,9 +140,10 @@ test_crypto (vlib_main_t * vm, crypto_test_main_t * tm)
   unittest_crypto_test_registration_t *r = tm->test_registrations;
   unittest_crypto_test_registration_t **rv = 0;
   vnet_crypto_alg_data_t *ad;
-  vnet_crypto_op_t *ops = 0, *op;
+  vnet_crypto_op_t *ops = 0, *chained_ops = 0, *op;
+  vnet_crypto_op_chunk_t *chunks = 0;
   vnet_crypto_key_index_t *key_indices = 0;
-  u8 *computed_data = 0, *s = 0, *err = 0;
+  u8 *computed_data = 0, *chained_data = 0;
   u32 computed_data_total_len = 0, n_ops = 0;
   u32 i;
 
@@ -172,99 +276,66 @@ test_crypto (vlib_main_t * vm, crypto_test_main_t * tm)
 
   vnet_crypto_process_ops (vm, ops, vec_len (ops));
 
+  test_crypto_check_ops (vm, tm, rv, ops, 0);
+
+  /* same ops again, with the data split over multiple chunks */
+  vec_validate_aligned (chained_data, computed_data_total_len - 1,
+			CLIB_CACHE_LINE_BYTES);
+  vec_validate_aligned (chained_ops, n_ops - 1, CLIB_CACHE_LINE_BYTES);
+
   /* *INDENT-OFF* */
-  vec_foreach (op, ops)
+  vec_foreach_index (i, ops)
     {
-      int fail = 0;
-      r = rv[op->user_data];
-      unittest_crypto_test_data_t *exp_pt = 0, *exp_ct = 0;
-      unittest_crypto_test_data_t *exp_digest = 0, *exp_tag = 0;
-
-      switch (vnet_crypto_get_op_type (op->op))
+      vnet_crypto_op_t *cop = chained_ops + i;
+      u32 j, n_chunks, offset = 0;
+
+      op = ops + i;
+      cop[0] = op[0];
+      cop->status = VNET_CRYPTO_OP_STATUS_PENDING;
+      cop->flags |= VNET_CRYPTO_OP_FLAG_CHAINED_BUFFERS;
+
+#define _(p) \
+      if (op->p >= computed_data && \
+          op->p < computed_data + computed_data_total_len) \
+        cop->p = chained_data + (op->p - computed_data);
+      _(dst) _(tag) _(digest)
+#undef _
+
+      /* uneven chunk lengths, so blocks straddle chunks */
+      n_chunks = op->len >= 8 ? 3 : 1;
+      cop->chunk_index = vec_len (chunks);
+      cop->n_chunks = n_chunks;
+      for (j = 0; j < n_chunks; j++)
 	{
-	case VNET_CRYPTO_OP_TYPE_AEAD_ENCRYPT:
-	  exp_tag = &r->tag;
-          /* fall through */
-	case VNET_CRYPTO_OP_TYPE_ENCRYPT:
-	  exp_ct = &r->ciphertext;
-	  break;
-	case VNET_CRYPTO_OP_TYPE_AEAD_DECRYPT:
-	case VNET_CRYPTO_OP_TYPE_DECRYPT:
-	  exp_pt = &r->plaintext;
-	  break;
-	case VNET_CRYPTO_OP_TYPE_HMAC:
-	  exp_digest = &r->digest;
-	  break;
-	default:
-	  break;
+	  vnet_crypto_op_chunk_t *ch;
+	  u32 len = (j == n_chunks - 1) ? op->len - offset :
+	    op->len / n_chunks + (j == 0);
+
+	  vec_add2 (chunks, ch, 1);
+	  ch->src = op->src + offset;
+	  ch->dst = cop->dst ? cop->dst + offset : 0;
+	  ch->len = len;
+	  offset += len;
 	}
+    }
+  /* *INDENT-ON* */
 
-      vec_reset_length (err);
-
-      if (op->status != VNET_CRYPTO_OP_STATUS_COMPLETED)
-	err = format (err, "%sengine error: %U", vec_len (err) ? ", " : "",
-		      format_vnet_crypto_op_status, op->status);
-
-      if (exp_ct && memcmp (op->dst, exp_ct->data, exp_ct->length) != 0)
-	err = format (err, "%sciphertext mismatch",
-		      vec_len (err) ? ", " : "");
-
-      if (exp_pt && memcmp (op->dst, exp_pt->data, exp_pt->length) != 0)
-	err = format (err, "%splaintext mismatch", vec_len (err) ? ", " : "");
-
-      if (exp_tag && memcmp (op->tag, exp_tag->data, exp_tag->length) != 0)
-	err = format (err, "%stag mismatch", vec_len (err) ? ", " : "");
-
-      if (exp_digest &&
-	  memcmp (op->digest, exp_digest->data, exp_digest->length) != 0)
-	err = format (err, "%sdigest mismatch", vec_len (err) ? ", " : "");
-
-      vec_reset_length (s);
-      s = format (s, "%s (%U)", r->name, format_vnet_crypto_op, op->op);
-
-      if (vec_len (err))
-	fail = 1;
-
-      vlib_cli_output (vm, "%-60v%s%v", s, vec_len (err) ? "FAIL: " : "OK",
-		       err);
-      if (tm->verbose)
-	{
-	  if (tm->verbose == 2)
-	    fail = 1;
+  vnet_crypto_process_chained_ops (vm, chained_ops, chunks,
+				   vec_len (chained_ops));
 
-	  if (exp_ct && fail)
-	    vlib_cli_output (vm, "Expected ciphertext:\n%U"
-			     "\nCalculated ciphertext:\n%U",
-			     format_hexdump, exp_ct->data, exp_ct->length,
-			     format_hexdump, op->dst, exp_ct->length);
-	  if (exp_pt && fail)
-	    vlib_cli_output (vm, "Expected plaintext:\n%U"
-			     "\nCalculated plaintext:\n%U",
-			     format_hexdump, exp_pt->data, exp_pt->length,
-			     format_hexdump, op->dst, exp_pt->length);
-	  if (r->tag.length && fail)
-	    vlib_cli_output (vm, "Expected tag:\n%U"
-			     "\nCalculated tag:\n%U",
-			     format_hexdump, r->tag.data, r->tag.length,
-			     format_hexdump, op->tag, op->tag_len);
-	  if (exp_digest && fail)
-	    vlib_cli_output (vm, "Expected digest:\n%U"
-			     "\nCalculated Digest:\n%U",
-			     format_hexdump, exp_digest->data,
-			     exp_digest->length, format_hexdump, op->digest,
-			     op->digest_len);
-	}
-    }
+  test_crypto_check_ops (vm, tm, rv, chained_ops, 1);
 
+  /* *INDENT-OFF* */
   vec_foreach_index (i, key_indices)
     vnet_crypto_key_del (vm, key_indices[i]);
   /* *INDENT-ON* */
 
   vec_free (computed_data);
+  vec_free (chained_data);
   vec_free (ops);
-  vec_free (err);
+  vec_free (chained_ops);
+  vec_free (chunks);
   vec_free (rv);
-  vec_free (s);
   return 0;
 }
 
@@ -5264,6 +5264,433 @@ fib_test_v6 (void)
     return (res);
 }
 
+typedef struct fib_test_bsearch_walk_ctx_t_
+{
+    u32 fib_index;
+    u32 lbi;
+    u32 n_entries;
+    u32 n_lbi;
+} fib_test_bsearch_walk_ctx_t;
+
+static void
+fib_test_bsearch_walk (clib_bihash_kv_24_8_t * kvp,
+                       void *arg)
+{
+    fib_test_bsearch_walk_ctx_t *ctx = arg;
+
+    if ((kvp->key[2] >> 32) != ctx->fib_index ||
+        !(kvp->key[2] & IP6_FIB_BSEARCH_KEY_FLAG))
+        return;
+
+    ctx->n_entries++;
+    if (kvp->value == ctx->lbi)
+        ctx->n_lbi++;
+}
+
+/*
+ * Count the binary search entries of a FIB, and those of them that refer
+ * to a given load-balance
+ */
+static fib_test_bsearch_walk_ctx_t
+fib_test_bsearch_count (u32 fib_index, u32 lbi)
+{
+    fib_test_bsearch_walk_ctx_t ctx = {
+        .fib_index = fib_index,
+        .lbi = lbi,
+    };
+
+    clib_bihash_foreach_key_value_pair_24_8(
+        &ip6_main.ip6_table[IP6_FIB_TABLE_FWDING].ip6_hash,
+        fib_test_bsearch_walk,
+        &ctx);
+
+    return (ctx);
+}
+
+/*
+ * Test the binary search lookup of an IPv6 table against hash probing
+ */
+static int
+fib_test_v6_bsearch (void)
+{
+    static const u8 lengths[] = {16, 24, 32, 33, 40, 47, 48, 56, 64, 96, 127, 128};
+    fib_prefix_t *pfxs = NULL, *pfx;
+    ip6_address_t addrs[4], *addrp[4];
+    u32 fib_index, ii, jj, bit, del;
+    u32 lbi, del_lbi, lbis[4], fib_indices[4];
+    fib_node_index_t fei;
+    vlib_main_t *vm;
+    int res;
+
+    res = 0;
+    vm = vlib_get_main();
+
+    fib_index = fib_table_find_or_create_and_lock(FIB_PROTOCOL_IP6, 12,
+                                                  FIB_SOURCE_API);
+    ip6_fib_table_set_lookup_algo(fib_index, IP6_FIB_LOOKUP_ALGO_BSEARCH);
+
+    /*
+     * 2001:db8::/len for each length, nested in one another, plus three
+     * siblings of each that differ in the last two bits of the prefix
+     */
+    for (ii = 0; ii < ARRAY_LEN(lengths); ii++)
+    {
+        for (jj = 0; jj < 4; jj++)
+        {
+            fib_prefix_t p = {
+                .fp_len = lengths[ii],
+                .fp_proto = FIB_PROTOCOL_IP6,
+                .fp_addr.ip6.as_u64[0] =
+                    clib_host_to_net_u64(0x20010db800000000),
+            };
+
+            bit = lengths[ii] - 1;
+            if (jj & 1)
+                p.fp_addr.ip6.as_u8[bit / 8] |= 0x80 >> (bit % 8);
+            bit = lengths[ii] - 2;
+            if (jj & 2)
+                p.fp_addr.ip6.as_u8[bit / 8] |= 0x80 >> (bit % 8);
+
+            fib_table_entry_special_add(fib_index, &p,
+                                        FIB_SOURCE_API,
+                                        FIB_ENTRY_FLAG_DROP);
+            vec_add1(pfxs, p);
+        }
+    }
+
+    for (ii = 0; ii < 500 && !ip6_fib_get(fib_index)->bsearch_ready; ii++)
+        vlib_process_suspend(vm, 1e-2);
+    FIB_TEST(ip6_fib_get(fib_index)->bsearch_ready,
+             "bsearch entries rebuilt");
+    /* plus the default route and link-local */
+    FIB_TEST(vec_len(ip6_fib_get(fib_index)->bsearch_prefix_lengths) ==
+             ARRAY_LEN(lengths) + 2,
+             "bsearch over %d lengths",
+             vec_len(ip6_fib_get(fib_index)->bsearch_prefix_lengths));
+
+    vec_foreach(pfx, pfxs)
+    {
+        /* the prefix itself, and addresses below it */
+        for (jj = 0; jj < 4; jj++)
+        {
+            fib_indices[jj] = fib_index;
+            addrs[jj] = pfx->fp_addr.ip6;
+            addrp[jj] = &addrs[jj];
+        }
+        addrs[1].as_u64[1] ^= clib_host_to_net_u64(0x1);
+        addrs[2].as_u64[1] ^= clib_host_to_net_u64(0xffffffff);
+        addrs[3].as_u64[0] ^= clib_host_to_net_u64(0xff);
+
+        fei = fib_table_lookup_exact_match(fib_index, pfx);
+        lbi = ip6_fib_table_fwding_lookup(&ip6_main, fib_index,
+                                          &pfx->fp_addr.ip6);
+        FIB_TEST(lbi == fib_entry_contribute_ip_forwarding(fei)->dpoi_index,
+                 "%U bsearch finds the prefix",
+                 format_fib_prefix, pfx);
+
+        ip6_fib_table_fwding_lookup_x4(&ip6_main, fib_indices,
+                                       (const ip6_address_t **)addrp, lbis);
+        for (jj = 0; jj < 4; jj++)
+        {
+            lbi = ip6_fib_table_fwding_lookup_hash(fib_index, &addrs[jj]);
+            FIB_TEST(lbi == ip6_fib_table_fwding_lookup(&ip6_main, fib_index,
+                                                        &addrs[jj]),
+                     "%U: bsearch and hash match", format_ip6_address,
+                     &addrs[jj]);
+            FIB_TEST(lbi == lbis[jj],
+                     "%U: x4 and hash match", format_ip6_address,
+                     &addrs[jj]);
+        }
+    }
+
+    /*
+     * a delete drops the binary search entries, so none of them can
+     * refer to the deleted prefix's load-balance, before or after the
+     * rebuild
+     */
+    del = 8 * 4;
+    FIB_TEST(64 == pfxs[del].fp_len, "delete a /64");
+    fei = fib_table_lookup_exact_match(fib_index, &pfxs[del]);
+    del_lbi = fib_entry_contribute_ip_forwarding(fei)->dpoi_index;
+    FIB_TEST(0 != fib_test_bsearch_count(fib_index, del_lbi).n_lbi,
+             "bsearch entries refer to the /64");
+
+    fib_table_entry_special_remove(fib_index, &pfxs[del], FIB_SOURCE_API);
+    FIB_TEST(!ip6_fib_get(fib_index)->bsearch_ready,
+             "bsearch entries stale after delete");
+    FIB_TEST(0 == fib_test_bsearch_count(fib_index, del_lbi).n_entries,
+             "bsearch entries removed on delete");
+
+    for (ii = 0; ii < 500 && !ip6_fib_get(fib_index)->bsearch_ready; ii++)
+        vlib_process_suspend(vm, 1e-2);
+    FIB_TEST(ip6_fib_get(fib_index)->bsearch_ready,
+             "bsearch entries rebuilt after delete");
+    FIB_TEST(0 == fib_test_bsearch_count(fib_index, del_lbi).n_lbi,
+             "no bsearch entry refers to the deleted /64");
+
+    for (jj = 0; jj < 4; jj++)
+    {
+        fib_indices[jj] = fib_index;
+        addrs[jj] = pfxs[del].fp_addr.ip6;
+        addrp[jj] = &addrs[jj];
+    }
+    addrs[1].as_u64[1] ^= clib_host_to_net_u64(0x1);
+    addrs[2].as_u64[1] ^= clib_host_to_net_u64(0xffffffff);
+    addrs[3].as_u64[0] ^= clib_host_to_net_u64(0x1);
+
+    ip6_fib_table_fwding_lookup_x4(&ip6_main, fib_indices,
+                                   (const ip6_address_t **)addrp, lbis);
+    for (jj = 0; jj < 4; jj++)
+    {
+        lbi = ip6_fib_table_fwding_lookup_hash(fib_index, &addrs[jj]);
+        FIB_TEST(lbi != del_lbi,
+                 "%U: deleted /64 not found", format_ip6_address,
+                 &addrs[jj]);
+        FIB_TEST(lbi == ip6_fib_table_fwding_lookup(&ip6_main, fib_index,
+                                                    &addrs[jj]),
+                 "%U: bsearch and hash match after delete",
+                 format_ip6_address, &addrs[jj]);
+        FIB_TEST(lbi == lbis[jj],
+                 "%U: x4 and hash match after delete", format_ip6_address,
+                 &addrs[jj]);
+    }
+
+    /*
+     * a change moves the table back to hash probing until the rebuild
+     */
+    fib_table_entry_special_remove(fib_index, &pfxs[0], FIB_SOURCE_API);
+    FIB_TEST(!ip6_fib_get(fib_index)->bsearch_ready,
+             "bsearch entries stale after remove");
+    lbi = ip6_fib_table_fwding_lookup(&ip6_main, fib_index,
+                                      &pfxs[0].fp_addr.ip6);
+    FIB_TEST(lbi == ip6_fib_table_fwding_lookup_hash(
+                 fib_index, &pfxs[0].fp_addr.ip6),
+             "lookup after remove matches hash");
+
+    for (ii = 1; ii < vec_len(pfxs); ii++)
+    {
+        if (ii != del)
+            fib_table_entry_special_remove(fib_index, &pfxs[ii],
+                                           FIB_SOURCE_API);
+    }
+
+    ip6_fib_table_set_lookup_algo(fib_index, IP6_FIB_LOOKUP_ALGO_HASH);
+    FIB_TEST(NULL == ip6_fib_get(fib_index)->bsearch_prefix_lengths,
+             "bsearch entries flushed");
+
+    fib_table_unlock(fib_index, FIB_PROTOCOL_IP6, FIB_SOURCE_API);
+    vec_free(pfxs);
+
+    return (res);
+}
+
+typedef struct fib_test_mtrie_route_t_
+{
+    ip4_address_t addr;
+    u32 len;
+    u32 lbi;
+} fib_test_mtrie_route_t;
+
+static u32
+fib_test_mtrie_lookup (const ip4_fib_mtrie_t *m,
+                       const ip4_address_t *dst)
+{
+    ip4_fib_mtrie_leaf_t leaf;
+
+    leaf = ip4_fib_mtrie_lookup_step_one(m, dst);
+    leaf = ip4_fib_mtrie_lookup_step(m, leaf, dst, 2);
+    leaf = ip4_fib_mtrie_lookup_step(m, leaf, dst, 3);
+
+    return (ip4_fib_mtrie_leaf_get_adj_index(leaf));
+}
+
+/*
+ * The longest match among the first n routes, by brute force
+ */
+static const fib_test_mtrie_route_t *
+fib_test_mtrie_best (const fib_test_mtrie_route_t *routes,
+                     u32 n,
+                     const ip4_address_t *dst,
+                     const fib_test_mtrie_route_t *skip)
+{
+    const fib_test_mtrie_route_t *best = NULL;
+    u32 ii;
+
+    for (ii = 0; ii < n; ii++)
+    {
+        if (&routes[ii] == skip)
+            continue;
+        if ((dst->as_u32 & ip4_main.fib_masks[routes[ii].len]) !=
+            routes[ii].addr.as_u32)
+            continue;
+        if (NULL == best || routes[ii].len > best->len)
+            best = &routes[ii];
+    }
+
+    return (best);
+}
+
+/*
+ * Compare lookups in an mtrie with compressed plies against one without,
+ * and against the longest match of the routes
+ */
+static int
+fib_test_mtrie_check (const ip4_fib_mtrie_t *m,
+                      const fib_test_mtrie_route_t *routes,
+                      u32 n_routes,
+                      const char *what)
+{
+    static const u32 bases[] = {
+        0x0a000000, 0x0a010000, 0x0a010100, 0x0a010200,
+        0x0a010300, 0x0a020000, 0x0b000000,
+    };
+    const fib_test_mtrie_route_t *best;
+    ip4_address_t dst;
+    u32 ii, jj, lbi[2];
+    int res;
+
+    res = 0;
+
+    for (ii = 0; ii < ARRAY_LEN(bases); ii++)
+    {
+        for (jj = 0; jj < 256; jj++)
+        {
+            dst.as_u32 = clib_host_to_net_u32(bases[ii] | jj);
+            best = fib_test_mtrie_best(routes, n_routes, &dst, NULL);
+
+            lbi[0] = fib_test_mtrie_lookup(&m[0], &dst);
+            lbi[1] = fib_test_mtrie_lookup(&m[1], &dst);
+
+            FIB_TEST(lbi[0] == lbi[1],
+                     "%s %U: compressed %d, uncompressed %d", what,
+                     format_ip4_address, &dst, lbi[1], lbi[0]);
+            FIB_TEST(lbi[1] == (best ? best->lbi : 0),
+                     "%s %U: found %d, expected %d", what,
+                     format_ip4_address, &dst, lbi[1],
+                     (best ? best->lbi : 0));
+            if (res)
+                return (res);
+        }
+    }
+
+    return (res);
+}
+
+/*
+ * Test the compressed mtrie plies against the uncompressed layout
+ */
+static int
+fib_test_mtrie (void)
+{
+    /* nested, so a delete always has a cover in the table */
+    static const struct {
+        u32 addr;
+        u32 len;
+    } prefixes[] = {
+        {0x0a000000, 8},
+        {0x0a010000, 16},
+        {0x0a010100, 24},
+        {0x0a010180, 25},
+        {0x0a010181, 32},
+        {0x0a0101fe, 31},
+        {0x0a010200, 23},
+        {0x0a010300, 26},
+        {0x0a010340, 28},
+        {0x0a010100, 32},
+        {0x0a0100ff, 32},
+        {0x0a020000, 15},
+    };
+    fib_test_mtrie_route_t *routes = NULL, *route;
+    const fib_test_mtrie_route_t *cover;
+    u32 ii, n_plies, n_c_plies;
+    ip4_fib_mtrie_t *m;
+    int res;
+
+    res = 0;
+    n_plies = pool_elts(ip4_ply_pool);
+    n_c_plies = pool_elts(ip4_c_ply_pool);
+
+    m = clib_mem_alloc_aligned(2 * sizeof(*m), CLIB_CACHE_LINE_BYTES);
+    ip4_mtrie_init(&m[0]);
+    ip4_mtrie_init(&m[1]);
+    m[0].flags = 0;
+    m[1].flags = IP4_FIB_MTRIE_FLAG_COMPRESSED;
+
+    for (ii = 0; ii < ARRAY_LEN(prefixes); ii++)
+    {
+        vec_add2(routes, route, 1);
+        route->addr.as_u32 = clib_host_to_net_u32(prefixes[ii].addr);
+        route->len = prefixes[ii].len;
+        route->lbi = ii + 1;
+
+        ip4_fib_mtrie_route_add(&m[0], &route->addr, route->len, route->lbi);
+        ip4_fib_mtrie_route_add(&m[1], &route->addr, route->len, route->lbi);
+
+        res += fib_test_mtrie_check(m, routes, vec_len(routes), "add");
+        if (res)
+            goto out;
+    }
+
+    FIB_TEST(ip4_fib_mtrie_leaf_is_compressed_ply(
+                 m[1].root_ply.leaves[routes[1].addr.as_u16[0]]),
+             "10.1/16 is a compressed ply");
+    FIB_TEST(!ip4_fib_mtrie_leaf_is_compressed_ply(
+                 m[0].root_ply.leaves[routes[1].addr.as_u16[0]]),
+             "10.1/16 is not compressed");
+    FIB_TEST(pool_elts(ip4_c_ply_pool) > n_c_plies,
+             "compressed plies in use");
+
+    /*
+     * re-adding a route with a new load-balance replaces it in place
+     */
+    route = &routes[3];
+    route->lbi = 100;
+    ip4_fib_mtrie_route_add(&m[0], &route->addr, route->len, route->lbi);
+    ip4_fib_mtrie_route_add(&m[1], &route->addr, route->len, route->lbi);
+    res += fib_test_mtrie_check(m, routes, vec_len(routes), "update");
+    if (res)
+        goto out;
+
+    /*
+     * delete the most specific routes first, each falls back to its cover
+     */
+    while (vec_len(routes))
+    {
+        route = vec_end(routes) - 1;
+        cover = fib_test_mtrie_best(routes, vec_len(routes),
+                                    &route->addr, route);
+
+        ip4_fib_mtrie_route_del(&m[0], &route->addr, route->len, route->lbi,
+                                (cover ? cover->len : 0),
+                                (cover ? cover->lbi : 0));
+        ip4_fib_mtrie_route_del(&m[1], &route->addr, route->len, route->lbi,
+                                (cover ? cover->len : 0),
+                                (cover ? cover->lbi : 0));
+        _vec_len(routes) -= 1;
+
+        res += fib_test_mtrie_check(m, routes, vec_len(routes), "del");
+        if (res)
+            goto out;
+    }
+
+    /*
+     * the test runs under the barrier, so replaced plies are freed at once
+     */
+    FIB_TEST(pool_elts(ip4_ply_pool) == n_plies,
+             "all plies freed: %d", pool_elts(ip4_ply_pool) - n_plies);
+    FIB_TEST(pool_elts(ip4_c_ply_pool) == n_c_plies,
+             "all compressed plies freed: %d",
+             pool_elts(ip4_c_ply_pool) - n_c_plies);
+
+out:
+    ip4_mtrie_free(&m[0]);
+    ip4_mtrie_free(&m[1]);
+    clib_mem_free(m);
+    vec_free(routes);
+
+    return (res);
+}
+
 /*
  * Test Attached Exports
  */
@@ -7886,6 +8313,398 @@ fib_test_walk (void)
     return (res);
 }
 
+#define N_DEFER_ROUTES 4
+
+/*
+ * Test the batching of sync walks between fib_walk_defer_start() and
+ * fib_walk_defer_end(). Two groups of recursive routes each share a
+ * path-list; a test child of each path-list counts its back-walks.
+ */
+static int
+fib_test_walk_defer (void)
+{
+    fib_prefix_t pfx_via_a[N_DEFER_ROUTES+1], pfx_via_b[N_DEFER_ROUTES+1];
+    fib_node_index_t fei, pl_a, pl_b, fib_index;
+    fib_node_test_t *tc;
+    test_main_t *tm;
+    u32 ii, n_feis, n_batch, res;
+
+    res = 0;
+    fib_index = 0;
+    tm = &test_main;
+    n_feis = fib_entry_pool_size();
+    fib_test_walk_spawns_walks = 0;
+    fib_node_register_type(FIB_NODE_TYPE_TEST, &fib_test_child_vft);
+
+    /* via 10.10.10.1 */
+    ip46_address_t nh_10_10_10_1 = {
+        .ip4.as_u32 = clib_host_to_net_u32(0x0a0a0a01),
+    };
+    /* via 10.10.10.2 */
+    ip46_address_t nh_10_10_10_2 = {
+        .ip4.as_u32 = clib_host_to_net_u32(0x0a0a0a02),
+    };
+    fib_prefix_t pfx_1_1_1_1_s_32 = {
+        .fp_len = 32,
+        .fp_proto = FIB_PROTOCOL_IP4,
+        .fp_addr = {
+            .ip4.as_u32 = clib_host_to_net_u32(0x01010101),
+        },
+    };
+    fib_prefix_t pfx_1_1_1_2_s_32 = {
+        .fp_len = 32,
+        .fp_proto = FIB_PROTOCOL_IP4,
+        .fp_addr = {
+            .ip4.as_u32 = clib_host_to_net_u32(0x01010102),
+        },
+    };
+    fib_prefix_t pfx_1_1_0_0_s_16 = {
+        .fp_len = 16,
+        .fp_proto = FIB_PROTOCOL_IP4,
+        .fp_addr = {
+            .ip4.as_u32 = clib_host_to_net_u32(0x01010000),
+        },
+    };
+    fib_prefix_t pfx_1_1_1_0_s_24 = {
+        .fp_len = 24,
+        .fp_proto = FIB_PROTOCOL_IP4,
+        .fp_addr = {
+            .ip4.as_u32 = clib_host_to_net_u32(0x01010100),
+        },
+    };
+    fib_prefix_t pfx_1_1_1_0_s_28 = {
+        .fp_len = 28,
+        .fp_proto = FIB_PROTOCOL_IP4,
+        .fp_addr = {
+            .ip4.as_u32 = clib_host_to_net_u32(0x01010100),
+        },
+    };
+    fib_prefix_t pfx_4_4_4_4_s_32 = {
+        .fp_len = 32,
+        .fp_proto = FIB_PROTOCOL_IP4,
+        .fp_addr = {
+            .ip4.as_u32 = clib_host_to_net_u32(0x04040404),
+        },
+    };
+
+    /*
+     * 2.2.2.x/32 recurse via 1.1.1.1 and 3.3.3.x/32 via 1.1.1.2.
+     * the last of each is added later, inside a batch.
+     */
+    for (ii = 0; ii <= N_DEFER_ROUTES; ii++)
+    {
+        pfx_via_a[ii].fp_len = 32;
+        pfx_via_a[ii].fp_proto = FIB_PROTOCOL_IP4;
+        pfx_via_a[ii].fp_addr.ip4.as_u32 =
+            clib_host_to_net_u32(0x02020201 + ii);
+        pfx_via_b[ii].fp_len = 32;
+        pfx_via_b[ii].fp_proto = FIB_PROTOCOL_IP4;
+        pfx_via_b[ii].fp_addr.ip4.as_u32 =
+            clib_host_to_net_u32(0x03030301 + ii);
+    }
+
+    /*
+     * with no route to either via the recursive routes are unresolved
+     */
+    for (ii = 0; ii < N_DEFER_ROUTES; ii++)
+    {
+        fib_table_entry_update_one_path(fib_index,
+                                        &pfx_via_a[ii],
+                                        FIB_SOURCE_API,
+                                        FIB_ENTRY_FLAG_NONE,
+                                        DPO_PROTO_IP4,
+                                        &pfx_1_1_1_1_s_32.fp_addr,
+                                        ~0,
+                                        fib_index,
+                                        1,
+                                        NULL,
+                                        FIB_ROUTE_PATH_FLAG_NONE);
+        fib_table_entry_update_one_path(fib_index,
+                                        &pfx_via_b[ii],
+                                        FIB_SOURCE_API,
+                                        FIB_ENTRY_FLAG_NONE,
+                                        DPO_PROTO_IP4,
+                                        &pfx_1_1_1_2_s_32.fp_addr,
+                                        ~0,
+                                        fib_index,
+                                        1,
+                                        NULL,
+                                        FIB_ROUTE_PATH_FLAG_NONE);
+    }
+
+    pl_a = fib_entry_get_path_list(
+        fib_table_lookup_exact_match(fib_index, &pfx_via_a[0]));
+    pl_b = fib_entry_get_path_list(
+        fib_table_lookup_exact_match(fib_index, &pfx_via_b[0]));
+
+    for (ii = 0; ii < N_DEFER_ROUTES; ii++)
+    {
+        fei = fib_table_lookup_exact_match(fib_index, &pfx_via_a[ii]);
+        FIB_TEST((pl_a == fib_entry_get_path_list(fei)),
+                 "%U shares the path-list via 1.1.1.1",
+                 format_fib_prefix, &pfx_via_a[ii]);
+        FIB_TEST(load_balance_is_drop(fib_entry_contribute_ip_forwarding(fei)),
+                 "%U is drop", format_fib_prefix, &pfx_via_a[ii]);
+        fei = fib_table_lookup_exact_match(fib_index, &pfx_via_b[ii]);
+        FIB_TEST((pl_b == fib_entry_get_path_list(fei)),
+                 "%U shares the path-list via 1.1.1.2",
+                 format_fib_prefix, &pfx_via_b[ii]);
+        FIB_TEST(load_balance_is_drop(fib_entry_contribute_ip_forwarding(fei)),
+                 "%U is drop", format_fib_prefix, &pfx_via_b[ii]);
+    }
+
+    /*
+     * 4.4.4.4/32 is a parent whose route is deleted inside a batch
+     */
+    fei = fib_table_entry_update_one_path(fib_index,
+                                          &pfx_4_4_4_4_s_32,
+                                          FIB_SOURCE_API,
+                                          FIB_ENTRY_FLAG_NONE,
+                                          DPO_PROTO_IP4,
+                                          &nh_10_10_10_1,
+                                          tm->hw[0]->sw_if_index,
+                                          ~0,
+                                          1,
+                                          NULL,
+                                          FIB_ROUTE_PATH_FLAG_NONE);
+
+    /*
+     * test child 1 and 3 hang off the path-list via 1.1.1.1,
+     * 2 off that via 1.1.1.2 and 4 off 4.4.4.4/32
+     */
+    FOR_EACH_TEST_CHILD(tc)
+    {
+        fib_node_init(&tc->node, FIB_NODE_TYPE_TEST);
+        fib_node_lock(&tc->node);
+        tc->ctxs = NULL;
+        tc->index = ii;
+        tc->destroyed = 0;
+    }
+    fib_test_nodes[1].sibling =
+        fib_path_list_child_add(pl_a, FIB_NODE_TYPE_TEST, 1);
+    fib_test_nodes[2].sibling =
+        fib_path_list_child_add(pl_b, FIB_NODE_TYPE_TEST, 2);
+    fib_test_nodes[3].sibling =
+        fib_path_list_child_add(pl_a, FIB_NODE_TYPE_TEST, 3);
+    fib_test_nodes[4].sibling =
+        fib_entry_child_add(fei, FIB_NODE_TYPE_TEST, 4);
+
+    /*
+     * bulk add more specific covers of the vias and another route via each,
+     * as one batch. each cover added changes the resolution of both vias,
+     * but nothing is walked until the batch ends.
+     */
+    fib_walk_defer_start();
+
+    fib_table_entry_update_one_path(fib_index,
+                                    &pfx_1_1_0_0_s_16,
+                                    FIB_SOURCE_API,
+                                    FIB_ENTRY_FLAG_NONE,
+                                    DPO_PROTO_IP4,
+                                    &nh_10_10_10_1,
+                                    tm->hw[0]->sw_if_index,
+                                    ~0,
+                                    1,
+                                    NULL,
+                                    FIB_ROUTE_PATH_FLAG_NONE);
+    fib_table_entry_update_one_path(fib_index,
+                                    &pfx_1_1_1_0_s_24,
+                                    FIB_SOURCE_API,
+                                    FIB_ENTRY_FLAG_NONE,
+                                    DPO_PROTO_IP4,
+                                    &nh_10_10_10_1,
+                                    tm->hw[0]->sw_if_index,
+                                    ~0,
+                                    1,
+                                    NULL,
+                                    FIB_ROUTE_PATH_FLAG_NONE);
+    fib_table_entry_update_one_path(fib_index,
+                                    &pfx_1_1_1_0_s_28,
+                                    FIB_SOURCE_API,
+                                    FIB_ENTRY_FLAG_NONE,
+                                    DPO_PROTO_IP4,
+                                    &nh_10_10_10_1,
+                                    tm->hw[0]->sw_if_index,
+                                    ~0,
+                                    1,
+                                    NULL,
+                                    FIB_ROUTE_PATH_FLAG_NONE);
+    fib_table_entry_update_one_path(fib_index,
+                                    &pfx_via_a[N_DEFER_ROUTES],
+                                    FIB_SOURCE_API,
+                                    FIB_ENTRY_FLAG_NONE,
+                                    DPO_PROTO_IP4,
+                                    &pfx_1_1_1_1_s_32.fp_addr,
+                                    ~0,
+                                    fib_index,
+                                    1,
+                                    NULL,
+                                    FIB_ROUTE_PATH_FLAG_NONE);
+    fib_table_entry_update_one_path(fib_index,
+                                    &pfx_via_b[N_DEFER_ROUTES],
+                                    FIB_SOURCE_API,
+                                    FIB_ENTRY_FLAG_NONE,
+                                    DPO_PROTO_IP4,
+                                    &pfx_1_1_1_2_s_32.fp_addr,
+                                    ~0,
+                                    fib_index,
+                                    1,
+                                    NULL,
+                                    FIB_ROUTE_PATH_FLAG_NONE);
+
+    FOR_EACH_TEST_CHILD(tc)
+    {
+        FIB_TEST(0 == vec_len(tc->ctxs),
+                 "%d child visited %d times in bulk add batch",
+                 ii, vec_len(tc->ctxs));
+    }
+    fei = fib_table_lookup_exact_match(fib_index, &pfx_via_a[0]);
+    FIB_TEST(load_balance_is_drop(fib_entry_contribute_ip_forwarding(fei)),
+             "%U is drop in bulk add batch",
+             format_fib_prefix, &pfx_via_a[0]);
+
+    fib_walk_defer_end();
+
+    /*
+     * one walk per path-list, and all the routes via them resolved
+     */
+    FIB_TEST(1 == vec_len(fib_test_nodes[1].ctxs),
+             "child 1 visited %d times post bulk add batch",
+             vec_len(fib_test_nodes[1].ctxs));
+    FIB_TEST(1 == vec_len(fib_test_nodes[2].ctxs),
+             "child 2 visited %d times post bulk add batch",
+             vec_len(fib_test_nodes[2].ctxs));
+    FIB_TEST(1 == vec_len(fib_test_nodes[3].ctxs),
+             "child 3 visited %d times post bulk add batch",
+             vec_len(fib_test_nodes[3].ctxs));
+    FIB_TEST(0 == vec_len(fib_test_nodes[4].ctxs),
+             "child 4 visited %d times post bulk add batch",
+             vec_len(fib_test_nodes[4].ctxs));
+    FOR_EACH_TEST_CHILD(tc)
+    {
+        vec_free(tc->ctxs);
+    }
+    for (ii = 0; ii <= N_DEFER_ROUTES; ii++)
+    {
+        FIB_TEST_REC_FORW(&pfx_via_a[ii], &pfx_1_1_1_1_s_32, 0);
+        FIB_TEST_REC_FORW(&pfx_via_b[ii], &pfx_1_1_1_2_s_32, 0);
+    }
+
+    /*
+     * a nested batch in which a cover, a route via 1.1.1.1, a child of
+     * that path-list, and a parent with a walk pending are all deleted.
+     */
+    fib_walk_defer_start();
+    fib_walk_defer_start();
+
+    fib_table_entry_delete(fib_index,
+                           &pfx_1_1_1_0_s_28,
+                           FIB_SOURCE_API);
+    fib_table_entry_delete(fib_index,
+                           &pfx_via_a[0],
+                           FIB_SOURCE_API);
+    fib_path_list_child_remove(pl_a, fib_test_nodes[3].sibling);
+
+    fei = fib_table_lookup_exact_match(fib_index, &pfx_4_4_4_4_s_32);
+    fib_table_entry_path_add(fib_index,
+                             &pfx_4_4_4_4_s_32,
+                             FIB_SOURCE_API,
+                             FIB_ENTRY_FLAG_NONE,
+                             DPO_PROTO_IP4,
+                             &nh_10_10_10_2,
+                             tm->hw[0]->sw_if_index,
+                             ~0,
+                             1,
+                             NULL,
+                             FIB_ROUTE_PATH_FLAG_NONE);
+    fib_entry_child_remove(fei, fib_test_nodes[4].sibling);
+    fib_table_entry_delete(fib_index,
+                           &pfx_4_4_4_4_s_32,
+                           FIB_SOURCE_API);
+
+    FIB_TEST(FIB_NODE_INDEX_INVALID ==
+             fib_table_lookup_exact_match(fib_index, &pfx_via_a[0]),
+             "%U removed in batch", format_fib_prefix, &pfx_via_a[0]);
+    FIB_TEST(FIB_NODE_INDEX_INVALID ==
+             fib_table_lookup_exact_match(fib_index, &pfx_4_4_4_4_s_32),
+             "%U removed in batch", format_fib_prefix, &pfx_4_4_4_4_s_32);
+
+    fib_walk_defer_end();
+
+    FOR_EACH_TEST_CHILD(tc)
+    {
+        FIB_TEST(0 == vec_len(tc->ctxs),
+                 "%d child visited %d times at end of inner batch",
+                 ii, vec_len(tc->ctxs));
+    }
+
+    /*
+     * the pending walk holds the deleted 4.4.4.4/32 until the batch ends
+     */
+    n_batch = fib_entry_pool_size();
+
+    fib_walk_defer_end();
+
+    FIB_TEST(1 == vec_len(fib_test_nodes[1].ctxs),
+             "child 1 visited %d times post delete batch",
+             vec_len(fib_test_nodes[1].ctxs));
+    FIB_TEST(1 == vec_len(fib_test_nodes[2].ctxs),
+             "child 2 visited %d times post delete batch",
+             vec_len(fib_test_nodes[2].ctxs));
+    FIB_TEST(0 == vec_len(fib_test_nodes[3].ctxs),
+             "child 3 visited %d times post delete batch",
+             vec_len(fib_test_nodes[3].ctxs));
+    FIB_TEST(0 == vec_len(fib_test_nodes[4].ctxs),
+             "child 4 visited %d times post delete batch",
+             vec_len(fib_test_nodes[4].ctxs));
+    FIB_TEST((n_batch - 1 == fib_entry_pool_size()),
+             "4.4.4.4/32 freed post delete batch");
+    FOR_EACH_TEST_CHILD(tc)
+    {
+        vec_free(tc->ctxs);
+    }
+    for (ii = 1; ii <= N_DEFER_ROUTES; ii++)
+    {
+        FIB_TEST_REC_FORW(&pfx_via_a[ii], &pfx_1_1_1_1_s_32, 0);
+        FIB_TEST_REC_FORW(&pfx_via_b[ii], &pfx_1_1_1_2_s_32, 0);
+    }
+
+    /*
+     * cleanup
+     */
+    fib_path_list_child_remove(pl_a, fib_test_nodes[1].sibling);
+    fib_path_list_child_remove(pl_b, fib_test_nodes[2].sibling);
+    FOR_EACH_TEST_CHILD(tc)
+    {
+        fib_node_deinit(&tc->node);
+        fib_node_unlock(&tc->node);
+    }
+
+    for (ii = 1; ii <= N_DEFER_ROUTES; ii++)
+    {
+        fib_table_entry_delete(fib_index,
+                               &pfx_via_a[ii],
+                               FIB_SOURCE_API);
+    }
+    for (ii = 0; ii <= N_DEFER_ROUTES; ii++)
+    {
+        fib_table_entry_delete(fib_index,
+                               &pfx_via_b[ii],
+                               FIB_SOURCE_API);
+    }
+    fib_table_entry_delete(fib_index,
+                           &pfx_1_1_1_0_s_24,
+                           FIB_SOURCE_API);
+    fib_table_entry_delete(fib_index,
+                           &pfx_1_1_0_0_s_16,
+                           FIB_SOURCE_API);
+
+    FIB_TEST((n_feis == fib_entry_pool_size()), "Entries gone");
+    FIB_TEST(0 == adj_nbr_db_size(), "All adjacencies removed");
+
+    return (res);
+}
+
 /*
  * declaration of the otherwise static callback functions
  */
@@ -10544,6 +11363,14 @@ fib_test (vlib_main_t * vm,
     {
         res += fib_test_v6();
     }
+    else if (unformat (input, "bsearch"))
+    {
+        res += fib_test_v6_bsearch();
+    }
+    else if (unformat (input, "mtrie"))
+    {
+        res += fib_test_mtrie();
+    }
     else if (unformat (input, "ip"))
     {
         res += fib_test_v4();
@@ -10569,6 +11396,10 @@ fib_test (vlib_main_t * vm,
     {
         res += fib_test_walk();
     }
+    else if (unformat (input, "defer"))
+    {
+        res += fib_test_walk_defer();
+    }
     else if (unformat (input, "bfd"))
     {
         res += fib_test_bfd();
@@ -10585,6 +11416,8 @@ fib_test (vlib_main_t * vm,
     {
         res += fib_test_v4();
         res += fib_test_v6();
+        res += fib_test_v6_bsearch();
+        res += fib_test_mtrie();
         res += fib_test_ae();
         res += fib_test_bfd();
         res += fib_test_pref();
@@ -10598,6 +11431,7 @@ fib_test (vlib_main_t * vm,
         fib_walk_process_disable();
         res += fib_test_walk();
         fib_walk_process_enable();
+        res += fib_test_walk_defer();
     }
 
     fflush(NULL);
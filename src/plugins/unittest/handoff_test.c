@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2019 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <vlib/vlib.h>
+#include <vlib/buffer_node.h>
+
+#define HANDOFF_TEST_I(_cond, _comment, _args...)		\
+({								\
+  int _evald = (_cond);						\
+  if (!(_evald)) {						\
+    fformat(stderr, "FAIL:%d: " _comment "\n",			\
+	    __LINE__, ##_args);					\
+  } else {							\
+    fformat(stderr, "PASS:%d: " _comment "\n",			\
+	    __LINE__, ##_args);					\
+  }								\
+  _evald;							\
+})
+
+#define HANDOFF_TEST(_cond, _comment, _args...)			\
+{								\
+    if (!HANDOFF_TEST_I(_cond, _comment, ##_args)) {		\
+	return 1;                                               \
+    }								\
+}
+
+/* small rings, so a few packets fill them */
+#define HANDOFF_TEST_RING_SIZE 8
+
+/* ring heads and tails start this close to the u32 wrap */
+#define HANDOFF_TEST_RING_START (0xffffffff - 3)
+
+/*
+ * A frame queue main of our own, so the workers never dequeue its rings
+ * and the rings of the real handoff nodes are left alone. The counters
+ * live on the stats heap, so it is set up once and reused.
+ */
+static vlib_frame_queue_main_t handoff_test_fqm;
+static vlib_frame_queue_t handoff_test_fq;
+
+static vlib_frame_queue_main_t *
+handoff_test_fqm_get (vlib_main_t * vm)
+{
+  vlib_frame_queue_main_t *fqm = &handoff_test_fqm;
+  vlib_frame_queue_per_thread_data_t *ptd;
+  vlib_handoff_ring_t *r;
+  u32 n_threads = vec_len (vlib_mains);
+
+  if (0 == vec_len (fqm->rings))
+    {
+      fqm->node_index =
+	vlib_get_node_by_name (vm, (u8 *) "error-drop")->index;
+      vec_validate_init_empty (fqm->vlib_frame_queues, n_threads - 1,
+			       &handoff_test_fq);
+      vec_validate (fqm->per_thread_data, n_threads - 1);
+      vec_foreach (ptd, fqm->per_thread_data)
+	vec_validate (ptd->ring_head_by_thread_index, n_threads - 1);
+      vec_validate_aligned (fqm->rings, n_threads * n_threads - 1,
+			    CLIB_CACHE_LINE_BYTES);
+      vec_foreach (r, fqm->rings)
+      {
+	vec_validate_aligned (r->buffer_indices, HANDOFF_TEST_RING_SIZE - 1,
+			      CLIB_CACHE_LINE_BYTES);
+	r->size = HANDOFF_TEST_RING_SIZE;
+      }
+      vlib_validate_simple_counter (&fqm->ring_occupancy,
+				    n_threads * VLIB_HANDOFF_RING_N_HIST - 1);
+      vlib_validate_simple_counter (&fqm->ring_backpressure, n_threads - 1);
+      vlib_validate_simple_counter (&fqm->ring_drops, n_threads - 1);
+    }
+
+  /* all rings empty, about to wrap */
+  vec_foreach (r, fqm->rings)
+  {
+    r->head = r->tail = r->tail_cache = HANDOFF_TEST_RING_START;
+  }
+  vec_foreach (ptd, fqm->per_thread_data)
+  {
+    u32 i;
+    for (i = 0; i < n_threads; i++)
+      ptd->ring_head_by_thread_index[i] = HANDOFF_TEST_RING_START;
+  }
+  vlib_clear_simple_counters (&fqm->ring_backpressure);
+  vlib_clear_simple_counters (&fqm->ring_drops);
+
+  return fqm;
+}
+
+/* returns the number of packets enqueued */
+static u32
+handoff_test_enqueue (vlib_main_t * vm, vlib_frame_queue_main_t * fqm,
+		      u32 receiver, u32 n_packets, int drop_on_congestion,
+		      u32 * bi)
+{
+  u16 thread_indices[VLIB_FRAME_SIZE];
+  u32 i;
+
+  if (!HANDOFF_TEST_I (n_packets == vlib_buffer_alloc (vm, bi, n_packets),
+		       "alloc %u buffers", n_packets))
+    return 0;
+  for (i = 0; i < n_packets; i++)
+    thread_indices[i] = receiver;
+
+  return vlib_buffer_enqueue_to_handoff_ring (vm, fqm, bi, thread_indices,
+					      n_packets, drop_on_congestion);
+}
+
+/* packets written across the u32 wrap of the ring head come out in
+   order, from the right slots */
+static int
+handoff_test_wrap (vlib_main_t * vm)
+{
+  vlib_frame_queue_main_t *fqm = handoff_test_fqm_get (vm);
+  vlib_handoff_ring_t *r = vlib_get_handoff_ring (fqm, 0, 0);
+  u32 bi[HANDOFF_TEST_RING_SIZE], i, n_bad = 0, n;
+
+  n = HANDOFF_TEST_RING_SIZE - 2;
+  HANDOFF_TEST (n == handoff_test_enqueue (vm, fqm, 0, n, 1, bi),
+		"enqueued %u", n);
+  HANDOFF_TEST (r->head == HANDOFF_TEST_RING_START + n,
+		"head wrapped to %u", r->head);
+  HANDOFF_TEST (r->head < r->tail, "head below tail after the wrap");
+
+  for (i = 0; i < n; i++)
+    n_bad += r->buffer_indices[(HANDOFF_TEST_RING_START + i) &
+			       (HANDOFF_TEST_RING_SIZE - 1)] != bi[i];
+  HANDOFF_TEST (0 == n_bad, "%u packets in the wrong slot", n_bad);
+
+  HANDOFF_TEST (vlib_frame_queue_dequeue (vm, fqm), "dequeued");
+  HANDOFF_TEST (r->tail == r->head, "ring drained, tail %u", r->tail);
+
+  return 0;
+}
+
+/* a sender that does not drop on congestion waits for space instead,
+   here made by its own dequeue of the self-addressed ring */
+static int
+handoff_test_full_wait (vlib_main_t * vm)
+{
+  vlib_frame_queue_main_t *fqm = handoff_test_fqm_get (vm);
+  vlib_handoff_ring_t *r = vlib_get_handoff_ring (fqm, 0, 0);
+  u32 bi[2 * HANDOFF_TEST_RING_SIZE], n;
+
+  n = HANDOFF_TEST_RING_SIZE + HANDOFF_TEST_RING_SIZE / 2;
+  HANDOFF_TEST (n == handoff_test_enqueue (vm, fqm, 0, n, 0, bi),
+		"enqueued %u to a ring of %u", n, HANDOFF_TEST_RING_SIZE);
+  HANDOFF_TEST (1 == vlib_get_simple_counter (&fqm->ring_backpressure, 0),
+		"waited once");
+  HANDOFF_TEST (0 == vlib_get_simple_counter (&fqm->ring_drops, 0),
+		"nothing dropped");
+  HANDOFF_TEST (r->head - r->tail == n - HANDOFF_TEST_RING_SIZE,
+		"%u packets left in the ring", r->head - r->tail);
+
+  HANDOFF_TEST (vlib_frame_queue_dequeue (vm, fqm), "dequeued");
+  HANDOFF_TEST (r->tail == r->head, "ring drained, tail %u", r->tail);
+
+  return 0;
+}
+
+/* a sender that drops on congestion drops what does not fit in a ring
+   nobody drains. Needs a worker, the sender drains its own rings. */
+static int
+handoff_test_full_drop (vlib_main_t * vm)
+{
+  vlib_frame_queue_main_t *fqm;
+  vlib_handoff_ring_t *r;
+  u32 bi[2 * HANDOFF_TEST_RING_SIZE], n, i;
+
+  if (vec_len (vlib_mains) < 2)
+    {
+      fformat (stderr, "SKIP: no worker to hand off to\n");
+      return 0;
+    }
+
+  fqm = handoff_test_fqm_get (vm);
+  r = vlib_get_handoff_ring (fqm, 1, 0);
+
+  n = HANDOFF_TEST_RING_SIZE + HANDOFF_TEST_RING_SIZE / 2;
+  HANDOFF_TEST (HANDOFF_TEST_RING_SIZE ==
+		handoff_test_enqueue (vm, fqm, 1, n, 1, bi),
+		"enqueued %u of %u", HANDOFF_TEST_RING_SIZE, n);
+  HANDOFF_TEST (n - HANDOFF_TEST_RING_SIZE ==
+		vlib_get_simple_counter (&fqm->ring_drops, 1),
+		"dropped %u", n - HANDOFF_TEST_RING_SIZE);
+  HANDOFF_TEST (r->head - r->tail == HANDOFF_TEST_RING_SIZE, "ring full");
+
+  /* the worker never looks at these rings, free what is left */
+  for (i = r->tail; i != r->head; i++)
+    vlib_buffer_free_one (vm, r->buffer_indices[i & (r->size - 1)]);
+  r->tail = r->head;
+
+  return 0;
+}
+
+static clib_error_t *
+handoff_test (vlib_main_t * vm,
+	      unformat_input_t * input, vlib_cli_command_t * cmd_arg)
+{
+  int res = 0;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "wrap"))
+	res = handoff_test_wrap (vm);
+      else if (unformat (input, "full"))
+	{
+	  if ((res = handoff_test_full_wait (vm)))
+	    goto done;
+	  res = handoff_test_full_drop (vm);
+	}
+      else if (unformat (input, "all"))
+	{
+	  if ((res = handoff_test_wrap (vm)))
+	    goto done;
+	  if ((res = handoff_test_full_wait (vm)))
+	    goto done;
+	  if ((res = handoff_test_full_drop (vm)))
+	    goto done;
+	}
+      else
+	break;
+    }
+
+done:
+  if (res)
+    return clib_error_return (0, "handoff unit test failed");
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (handoff_test_command, static) =
+{
+  .path = "test handoff-ring",
+  .short_help = "test handoff-ring [wrap|full|all]",
+  .function = handoff_test,
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
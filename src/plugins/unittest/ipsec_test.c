@@ -68,6 +68,116 @@ VLIB_CLI_COMMAND (test_ipsec_command, static) =
 };
 /* *INDENT-ON* */
 
+#define IPSEC_TEST(_cond, _comment, _args...)			\
+{								\
+  if (!(_cond))							\
+    return clib_error_return (0, "FAIL:%d: " _comment,		\
+			      __LINE__, ##_args);		\
+}
+
+static clib_error_t *
+test_ipsec_spd_flow_cache_command_fn (vlib_main_t * vm,
+				      unformat_input_t * input,
+				      vlib_cli_command_t * cmd)
+{
+  ipsec_main_t *im = &ipsec_main;
+  ipsec_spd_flow_cache_entry_t k = { }, zk = { }, *e;
+  ipsec_spd_flow_cache_t *fc;
+  ipsec_policy_t policy = { }, *p;
+  u32 epoch, stat_index, spd_id = 0xfc0ffee;
+  u64 hits, misses;
+  int hit, rv;
+
+  fc = &im->ptd[vlib_get_thread_index ()].spd_flow_cache;
+  if (!fc->entries)
+    return clib_error_return (0, "SPD flow cache is disabled");
+
+  hits = fc->hits;
+  misses = fc->misses;
+
+  k.laddr.ip4.as_u32 = clib_host_to_net_u32 (0x0a000001);
+  k.raddr.ip4.as_u32 = clib_host_to_net_u32 (0x0a000002);
+  k.lport = 1234;
+  k.rport = 4321;
+  k.protocol = IP_PROTOCOL_UDP;
+  k.type = IPSEC_SPD_POLICY_IP4_OUTBOUND;
+
+  /* a new flow misses, and hits once its result is recorded */
+  ipsec_spd_flow_cache_flush ();
+  e = ipsec_spd_flow_cache_lookup (&k, &hit);
+  IPSEC_TEST (e && !hit, "new flow misses");
+  ipsec_spd_flow_cache_update (e, &k, 0);
+  e = ipsec_spd_flow_cache_lookup (&k, &hit);
+  IPSEC_TEST (hit, "recorded flow hits");
+  IPSEC_TEST (ipsec_spd_flow_cache_policy (e) == 0, "no-match is cached");
+  IPSEC_TEST (fc->hits == hits + 1 && fc->misses == misses + 1,
+	      "hit/miss counted");
+
+  /* a different selector is a different flow */
+  k.rport++;
+  ipsec_spd_flow_cache_lookup (&k, &hit);
+  IPSEC_TEST (!hit, "different port misses");
+  k.rport--;
+
+  /* adding and deleting a policy invalidate cached results */
+  rv = ipsec_add_del_spd (vm, spd_id, 1);
+  IPSEC_TEST (!rv, "add SPD: %d", rv);
+  e = ipsec_spd_flow_cache_lookup (&k, &hit);
+  ipsec_spd_flow_cache_update (e, &k, 0);
+
+  policy.id = spd_id;
+  policy.type = IPSEC_SPD_POLICY_IP4_OUTBOUND;
+  policy.laddr.stop.ip4.as_u32 = ~0;
+  policy.raddr.stop.ip4.as_u32 = ~0;
+  policy.lport.stop = ~0;
+  policy.rport.stop = ~0;
+  policy.policy = IPSEC_POLICY_ACTION_BYPASS;
+  epoch = im->spd_flow_cache_epoch;
+  rv = ipsec_add_del_policy (vm, &policy, 1, &stat_index);
+  IPSEC_TEST (!rv, "add policy: %d", rv);
+  IPSEC_TEST (im->spd_flow_cache_epoch != epoch, "policy add bumps epoch");
+  e = ipsec_spd_flow_cache_lookup (&k, &hit);
+  IPSEC_TEST (!hit, "policy add invalidates");
+
+  p = pool_elt_at_index (im->policies, stat_index);
+  ipsec_spd_flow_cache_update (e, &k, p);
+  e = ipsec_spd_flow_cache_lookup (&k, &hit);
+  IPSEC_TEST (hit && ipsec_spd_flow_cache_policy (e) == p,
+	      "matched policy is cached");
+
+  rv = ipsec_add_del_policy (vm, &policy, 0, &stat_index);
+  IPSEC_TEST (!rv, "del policy: %d", rv);
+  ipsec_spd_flow_cache_lookup (&k, &hit);
+  IPSEC_TEST (!hit, "policy delete invalidates");
+  rv = ipsec_add_del_spd (vm, spd_id, 0);
+  IPSEC_TEST (!rv, "del SPD: %d", rv);
+
+  /* epoch wrap: the caches are zeroed and a zeroed slot never hits, even
+     for the all zero key */
+  e = ipsec_spd_flow_cache_lookup (&k, &hit);
+  ipsec_spd_flow_cache_update (e, &k, 0);
+  im->spd_flow_cache_epoch = ~0;
+  ipsec_spd_flow_cache_flush ();
+  IPSEC_TEST (im->spd_flow_cache_epoch == 1, "epoch wraps to 1");
+  ipsec_spd_flow_cache_lookup (&k, &hit);
+  IPSEC_TEST (!hit, "wrap invalidates");
+  ipsec_spd_flow_cache_lookup (&zk, &hit);
+  IPSEC_TEST (!hit, "zeroed entry does not hit");
+
+  vlib_cli_output (vm, "SPD flow cache tests passed");
+
+  return (NULL);
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (test_ipsec_spd_flow_cache_command, static) =
+{
+  .path = "test ipsec spd-flow-cache",
+  .short_help = "test ipsec spd-flow-cache",
+  .function = test_ipsec_spd_flow_cache_command_fn,
+};
+/* *INDENT-ON* */
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2019 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <vlib/vlib.h>
+#include <vlib/rcu.h>
+
+#define RCU_TEST_I(_cond, _comment, _args...)			\
+({								\
+  int _evald = (_cond);						\
+  if (!(_evald)) {						\
+    fformat(stderr, "FAIL:%d: " _comment "\n",			\
+	    __LINE__, ##_args);					\
+  } else {							\
+    fformat(stderr, "PASS:%d: " _comment "\n",			\
+	    __LINE__, ##_args);					\
+  }								\
+  _evald;							\
+})
+
+#define RCU_TEST(_cond, _comment, _args...)			\
+{								\
+    if (!RCU_TEST_I(_cond, _comment, ##_args)) {		\
+	return 1;                                               \
+    }								\
+}
+
+/* how long the workers get to go round their main loop */
+#define RCU_TEST_TIMEOUT 1.0
+
+/*
+ * The readers are slots above the vlib threads, standing in for threads
+ * outside vlib: they report quiescent states only when the test says so,
+ * and the barrier does not stop them.
+ */
+static u32
+rcu_test_slot (u32 i)
+{
+  return vec_len (vlib_mains) + i;
+}
+
+/* static, a failed case may leave its callback behind */
+static u32 rcu_test_n_calls;
+
+static void
+rcu_test_cb (void *data)
+{
+  rcu_test_n_calls++;
+}
+
+/* poll until the callback runs; the workers are waited for too */
+static u32
+rcu_test_poll (vlib_main_t * vm)
+{
+  f64 deadline = vlib_time_now (vm) + RCU_TEST_TIMEOUT;
+
+  while (1)
+    {
+      vlib_rcu_poll (vm);
+      if (rcu_test_n_calls || vlib_time_now (vm) > deadline)
+	break;
+      vlib_process_suspend (vm, 1e-3);
+    }
+
+  return (rcu_test_n_calls);
+}
+
+/* a deferred callback waits for every registered reader */
+static int
+rcu_test_wait (vlib_main_t * vm)
+{
+  vlib_rcu_main_t *rm = &vlib_rcu_main;
+  u32 a = rcu_test_slot (0), b = rcu_test_slot (1);
+
+  rcu_test_n_calls = 0;
+  vlib_rcu_thread_register (a);
+  vlib_rcu_thread_register (b);
+  RCU_TEST (rm->n_foreign >= 2, "readers %u and %u registered", a, b);
+
+  vlib_rcu_call (rcu_test_cb, 0);
+  vlib_rcu_poll (vm);
+  RCU_TEST (0 == rcu_test_n_calls, "deferred while no reader is quiescent");
+
+  vlib_rcu_thread_quiescent (a);
+  vlib_rcu_poll (vm);
+  RCU_TEST (0 == rcu_test_n_calls,
+	    "deferred while reader %u is not quiescent", b);
+
+  vlib_rcu_thread_quiescent (b);
+  RCU_TEST (1 == rcu_test_poll (vm), "called once all readers are quiescent");
+
+  /* a reader quiescent in an older epoch holds back a new callback */
+  rcu_test_n_calls = 0;
+  vlib_rcu_call (rcu_test_cb, 0);
+  vlib_rcu_thread_quiescent (a);
+  vlib_rcu_poll (vm);
+  RCU_TEST (0 == rcu_test_n_calls,
+	    "deferred while reader %u is in an older epoch", b);
+
+  vlib_rcu_thread_quiescent (b);
+  RCU_TEST (1 == rcu_test_poll (vm), "called in the new epoch");
+
+  vlib_rcu_thread_unregister (a);
+  vlib_rcu_thread_unregister (b);
+
+  return 0;
+}
+
+/* threads that never register, or have unregistered, are not waited for */
+static int
+rcu_test_unregistered (vlib_main_t * vm)
+{
+  vlib_rcu_main_t *rm = &vlib_rcu_main;
+  u32 a = rcu_test_slot (0), c = rcu_test_slot (2);
+
+  RCU_TEST (!rm->threads[c].is_registered, "reader %u never registered", c);
+
+  rcu_test_n_calls = 0;
+  vlib_rcu_thread_register (a);
+  vlib_rcu_call (rcu_test_cb, 0);
+  vlib_rcu_thread_quiescent (a);
+  RCU_TEST (1 == rcu_test_poll (vm), "called without reader %u", c);
+
+  /* unregistering a reader releases what it held back */
+  rcu_test_n_calls = 0;
+  vlib_rcu_call (rcu_test_cb, 0);
+  vlib_rcu_poll (vm);
+  RCU_TEST (0 == rcu_test_n_calls,
+	    "deferred while reader %u is registered", a);
+
+  vlib_rcu_thread_unregister (a);
+  RCU_TEST (1 == rcu_test_poll (vm),
+	    "called once reader %u unregistered", a);
+
+  return 0;
+}
+
+static clib_error_t *
+rcu_test (vlib_main_t * vm,
+	  unformat_input_t * input, vlib_cli_command_t * cmd_arg)
+{
+  int res = 0;
+
+  if (rcu_test_slot (2) >= VLIB_MAX_CPUS)
+    return clib_error_return (0, "no spare thread slots");
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "wait"))
+	res = rcu_test_wait (vm);
+      else if (unformat (input, "unregistered"))
+	res = rcu_test_unregistered (vm);
+      else if (unformat (input, "all"))
+	{
+	  if ((res = rcu_test_wait (vm)))
+	    goto done;
+	  if ((res = rcu_test_unregistered (vm)))
+	    goto done;
+	}
+      else
+	break;
+    }
+
+done:
+  /* a reader left registered would hold back every deferred free */
+  vlib_rcu_thread_unregister (rcu_test_slot (0));
+  vlib_rcu_thread_unregister (rcu_test_slot (1));
+
+  if (res)
+    return clib_error_return (0, "rcu unit test failed");
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (rcu_test_command, static) =
+{
+  .path = "test rcu",
+  .short_help = "test rcu [wait|unregistered|all]",
+  .function = rcu_test,
+  .is_mp_safe = 1,
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
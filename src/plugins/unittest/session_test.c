@@ -1815,7 +1815,7 @@ session_test_mq_speed (vlib_main_t * vm, unformat_input_t * input)
     }
 
   sm = app_worker_get_or_alloc_connect_segment_manager (app_wrk);
-  segment_manager_alloc_session_fifos (sm, &rx_fifo, &tx_fifo);
+  segment_manager_alloc_session_fifos (sm, 0, &rx_fifo, &tx_fifo);
   s.rx_fifo = rx_fifo;
   s.tx_fifo = tx_fifo;
   s.session_state = SESSION_STATE_READY;
@@ -1901,6 +1901,7 @@ session_test_mq_basic (vlib_main_t * vm, unformat_input_t * input)
   cfg->n_rings = 2;
   cfg->q_nitems = 16;
   cfg->ring_cfgs = rc;
+  cfg->flags = 0;
 
   mq = svm_msg_q_alloc (cfg);
   SESSION_TEST (mq != 0, "svm_msg_q_alloc");
@@ -1970,6 +1971,55 @@ session_test_mq_basic (vlib_main_t * vm, unformat_input_t * input)
   rv = (mq->rings[0].cursize == 0 && mq->rings[1].cursize == 0);
   SESSION_TEST (rv, "post dequeue");
 
+  /*
+   * Lock-free queue
+   */
+  cfg->q_nitems = 12;
+  cfg->flags = SVM_MSG_Q_F_LOCK_FREE;
+  mq = svm_msg_q_alloc (cfg);
+  SESSION_TEST (mq != 0, "lock-free svm_msg_q_alloc");
+  SESSION_TEST (mq->q->maxsize == 16, "lock-free queue size rounded up");
+  SESSION_TEST (svm_msg_q_try_lock (mq) == 0, "lock-free try lock");
+
+  for (i = 0; i < 8; i++)
+    {
+      msg[i] = svm_msg_q_alloc_msg_w_ring (mq, 0);
+      *(u32 *) svm_msg_q_msg_data (mq, &msg[i]) = i;
+    }
+  SESSION_TEST (svm_msg_q_ring_is_full (mq, 0), "lock-free ring full");
+  msg1 = svm_msg_q_alloc_msg (mq, 8);
+  SESSION_TEST (msg1.ring_index == 1, "lock-free alloc falls back");
+  svm_msg_q_free_msg (mq, &msg1);
+
+  /* enqueue in reverse allocation order, as racing producers could */
+  for (i = 7; i >= 0; i--)
+    SESSION_TEST (svm_msg_q_add (mq, &msg[i], SVM_Q_NOWAIT) == 0,
+		  "lock-free enqueue");
+  SESSION_TEST (svm_msg_q_size (mq) == 8, "lock-free queue size");
+
+  for (i = 7; i >= 0; i--)
+    {
+      rv = svm_msg_q_sub (mq, &msg1, SVM_Q_NOWAIT, 0);
+      SESSION_TEST (rv == 0, "lock-free dequeue");
+      if (*(u32 *) svm_msg_q_msg_data (mq, &msg1) != i)
+	SESSION_TEST (0, "lock-free dequeue wrong data");
+      /* frees are out of ring order */
+      svm_msg_q_free_msg (mq, &msg1);
+      if (i == 4)
+	{
+	  msg2 = svm_msg_q_alloc_msg_w_ring (mq, 0);
+	  SESSION_TEST (msg2.elt_index == 4, "lock-free alloc reuses free "
+			"element");
+	  svm_msg_q_free_msg (mq, &msg2);
+	}
+    }
+
+  rv = svm_msg_q_sub (mq, &msg1, SVM_Q_NOWAIT, 0);
+  SESSION_TEST (rv == -2, "lock-free dequeue empty");
+  rv = (mq->rings[0].cursize == 0 && mq->rings[1].cursize == 0
+	&& svm_msg_q_is_empty (mq));
+  SESSION_TEST (rv, "lock-free post dequeue");
+
   return 0;
 }
 
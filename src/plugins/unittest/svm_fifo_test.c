@@ -1186,6 +1186,251 @@ sfifo_test_fifo_large (vlib_main_t * vm, unformat_input_t * input)
   return 0;
 }
 
+/*
+ * Enqueue arrays of segments, across the wrap and into a nearly full fifo
+ */
+static int
+sfifo_test_fifo_enqueue_segs (vlib_main_t * vm, unformat_input_t * input)
+{
+  u32 fifo_size = 200, seg_len = 40, n_segs = 3, start, i, j;
+  int __clib_unused verbose = 0, rv;
+  u8 *test_data = 0, *data_buf = 0;
+  svm_fifo_seg_t segs[3];
+  svm_fifo_t *f;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "verbose"))
+	verbose = 1;
+      else
+	{
+	  vlib_cli_output (vm, "parse error: '%U'", format_unformat_error,
+			   input);
+	  return -1;
+	}
+    }
+
+  f = fifo_prepare (fifo_size);
+
+  vec_validate (test_data, n_segs * seg_len - 1);
+  vec_validate (data_buf, fifo_size - 1);
+  for (i = 0; i < vec_len (test_data); i++)
+    test_data[i] = i % 0xff;
+  for (i = 0; i < n_segs; i++)
+    {
+      segs[i].data = test_data + i * seg_len;
+      segs[i].len = seg_len;
+    }
+
+  /*
+   * Segments copied across the wrap
+   */
+  svm_fifo_init_pointers (f, fifo_size - 50, fifo_size - 50);
+
+  rv = svm_fifo_enqueue_segments (f, segs, n_segs, 0 /* allow_partial */ );
+  SFIFO_TEST (rv == n_segs * seg_len, "enqueued %d expected %u", rv,
+	      n_segs * seg_len);
+  SFIFO_TEST (f->tail == n_segs * seg_len - 50, "tail expected %u is %u",
+	      n_segs * seg_len - 50, f->tail);
+
+  rv = svm_fifo_dequeue (f, fifo_size, data_buf);
+  SFIFO_TEST (rv == n_segs * seg_len, "dequeued %d expected %u", rv,
+	      n_segs * seg_len);
+  if (compare_data (data_buf, test_data, 0, n_segs * seg_len, &j))
+    SFIFO_TEST (0, "[%u] dequeued %u expected %u", j, data_buf[j],
+		test_data[j]);
+
+  /*
+   * Nearly full, with the free space across the wrap and covering the
+   * first segment and part of the second
+   */
+  start = fifo_size - 20 - (f->nitems - 50);
+  svm_fifo_init_pointers (f, start, start);
+  for (i = 0; i < f->nitems - 50; i += rv)
+    {
+      rv = svm_fifo_enqueue (f, clib_min (f->nitems - 50 - i, fifo_size),
+			     data_buf);
+      SFIFO_TEST (rv > 0, "filled %u", i);
+    }
+  SFIFO_TEST (svm_fifo_max_enqueue (f) == 50, "free expected 50 is %u",
+	      svm_fifo_max_enqueue (f));
+
+  rv = svm_fifo_enqueue_segments (f, segs, n_segs, 0 /* allow_partial */ );
+  SFIFO_TEST (rv == SVM_FIFO_EFULL, "all or nothing enqueue should fail");
+  SFIFO_TEST (svm_fifo_max_enqueue (f) == 50, "nothing should be enqueued");
+
+  rv = svm_fifo_enqueue_segments (f, segs, n_segs, 1 /* allow_partial */ );
+  SFIFO_TEST (rv == 50, "partially enqueued %d expected 50", rv);
+  SFIFO_TEST (svm_fifo_max_enqueue (f) == 0, "fifo should be full");
+  SFIFO_TEST (f->tail == start - 1, "tail expected %u is %u", start - 1,
+	      f->tail);
+
+  rv = svm_fifo_enqueue_segments (f, segs, n_segs, 1 /* allow_partial */ );
+  SFIFO_TEST (rv == SVM_FIFO_EFULL, "enqueue to a full fifo should fail");
+
+  svm_fifo_dequeue_drop (f, f->nitems - 50);
+  rv = svm_fifo_dequeue (f, fifo_size, data_buf);
+  SFIFO_TEST (rv == 50, "dequeued %d expected 50", rv);
+  if (compare_data (data_buf, test_data, 0, 50, &j))
+    SFIFO_TEST (0, "[%u] dequeued %u expected %u", j, data_buf[j],
+		test_data[j]);
+
+  SFIFO_TEST (1, "passed segment enqueue");
+
+  /*
+   * Cleanup
+   */
+  vec_free (test_data);
+  vec_free (data_buf);
+  svm_fifo_free (f);
+  return 0;
+}
+
+/*
+ * Write data directly into the free space after the tail
+ */
+static int
+sfifo_test_fifo_tail_segs (vlib_main_t * vm, unformat_input_t * input)
+{
+  u32 fifo_size = 200, start, len, i, j;
+  int __clib_unused verbose = 0, rv;
+  u8 *test_data = 0, *data_buf = 0;
+  svm_fifo_seg_t fs[3];
+  svm_fifo_chunk_t *c, *next;
+  svm_fifo_t *f;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "verbose"))
+	verbose = 1;
+      else
+	{
+	  vlib_cli_output (vm, "parse error: '%U'", format_unformat_error,
+			   input);
+	  return -1;
+	}
+    }
+
+  f = fifo_prepare (fifo_size);
+
+  vec_validate (test_data, 2 * fifo_size - 1);
+  vec_validate (data_buf, 2 * fifo_size - 1);
+  for (i = 0; i < vec_len (test_data); i++)
+    test_data[i] = i % 0xff;
+
+  /*
+   * Free space across the wrap
+   */
+  start = fifo_size - 50;
+  svm_fifo_init_pointers (f, start, start);
+  c = f->tail_chunk;
+
+  rv = svm_fifo_tail_segments (f, fs, 2, ~0);
+  SFIFO_TEST (rv == 2, "segments expected 2 is %d", rv);
+  SFIFO_TEST (fs[0].data == c->data + start && fs[0].len == 50,
+	      "first segment should end at the wrap, len %u", fs[0].len);
+  SFIFO_TEST (fs[1].data == c->data && fs[1].len == f->nitems - 50,
+	      "second segment should start after the wrap, len %u",
+	      fs[1].len);
+
+  rv = svm_fifo_tail_segments (f, fs, 1, ~0);
+  SFIFO_TEST (rv == 1 && fs[0].len == 50, "one segment len %u", fs[0].len);
+
+  rv = svm_fifo_tail_segments (f, fs, 2, 30);
+  SFIFO_TEST (rv == 1 && fs[0].len == 30, "limited to one segment len %u",
+	      fs[0].len);
+
+  rv = svm_fifo_tail_segments (f, fs, 2, 80);
+  SFIFO_TEST (rv == 2 && fs[0].len + fs[1].len == 80, "segments cover %u",
+	      fs[0].len + fs[1].len);
+
+  len = 0;
+  for (i = 0; i < rv; i++)
+    {
+      clib_memcpy_fast (fs[i].data, test_data + len, fs[i].len);
+      len += fs[i].len;
+    }
+  svm_fifo_enqueue_nocopy (f, len);
+  SFIFO_TEST (f->tail == 30, "tail expected 30 is %u", f->tail);
+
+  rv = svm_fifo_dequeue (f, 2 * fifo_size, data_buf);
+  SFIFO_TEST (rv == 80, "dequeued %d expected 80", rv);
+  if (compare_data (data_buf, test_data, 0, 80, &j))
+    SFIFO_TEST (0, "[%u] dequeued %u expected %u", j, data_buf[j],
+		test_data[j]);
+
+  /*
+   * Nearly full, the segments cover only what is free
+   */
+  start = fifo_size - 10 - (f->nitems - 20);
+  svm_fifo_init_pointers (f, start, start);
+  for (i = 0; i < f->nitems - 20; i += rv)
+    {
+      rv = svm_fifo_enqueue (f, f->nitems - 20 - i, test_data);
+      SFIFO_TEST (rv > 0, "filled %u", i);
+    }
+
+  rv = svm_fifo_tail_segments (f, fs, 2, ~0);
+  SFIFO_TEST (rv == 2 && fs[0].len == 10 && fs[1].len == 10,
+	      "segments len %u and %u expected 10", fs[0].len, fs[1].len);
+
+  svm_fifo_enqueue_nocopy (f, 20);
+  rv = svm_fifo_tail_segments (f, fs, 2, ~0);
+  SFIFO_TEST (rv == SVM_FIFO_EFULL, "full fifo should have no segments");
+
+  /*
+   * Free space over two chunks and the wrap
+   */
+  svm_fifo_init_pointers (f, 0, 0);
+  c = clib_mem_alloc (sizeof (svm_fifo_chunk_t) + 100);
+  c->length = 100;
+  c->start_byte = ~0;
+  c->next = 0;
+  svm_fifo_add_chunk (f, c);
+  svm_fifo_init_pointers (f, start, start);
+
+  rv = svm_fifo_tail_segments (f, fs, 3, ~0);
+  SFIFO_TEST (rv == 3, "segments expected 3 is %d", rv);
+  SFIFO_TEST (fs[1].data == c->data && fs[1].len == c->length,
+	      "second segment should be the new chunk, len %u", fs[1].len);
+  SFIFO_TEST (fs[0].len + fs[1].len + fs[2].len == f->nitems,
+	      "segments cover %u expected %u",
+	      fs[0].len + fs[1].len + fs[2].len, f->nitems);
+
+  len = 0;
+  for (i = 0; i < rv; i++)
+    {
+      clib_memcpy_fast (fs[i].data, test_data + len, fs[i].len);
+      len += fs[i].len;
+    }
+  svm_fifo_enqueue_nocopy (f, len);
+  SFIFO_TEST (svm_fifo_max_enqueue (f) == 0, "fifo should be full");
+
+  rv = svm_fifo_dequeue (f, 2 * fifo_size, data_buf);
+  SFIFO_TEST (rv == f->nitems, "dequeued %d expected %u", rv, f->nitems);
+  if (compare_data (data_buf, test_data, 0, f->nitems, &j))
+    SFIFO_TEST (0, "[%u] dequeued %u expected %u", j, data_buf[j],
+		test_data[j]);
+
+  SFIFO_TEST (1, "passed tail segments");
+
+  /*
+   * Cleanup
+   */
+  c = f->start_chunk->next;
+  while (c && c != f->start_chunk)
+    {
+      next = c->next;
+      clib_mem_free (c);
+      c = next;
+    }
+
+  vec_free (test_data);
+  vec_free (data_buf);
+  svm_fifo_free (f);
+  return 0;
+}
+
 static int
 sfifo_test_fifo_grow (vlib_main_t * vm, unformat_input_t * input)
 {
@@ -2363,7 +2608,7 @@ sfifo_test_fifo_segment_slave (int verbose)
   fsh = (fifo_segment_header_t *) sh->opaque[0];
 
   /* might wanna wait.. */
-  f = fsh->fifos;
+  f = fsh->slices[0].fifos;
 
   /* Lazy bastards united */
   test_data = format (0, "Hello world%c", 0);
@@ -2530,7 +2775,7 @@ sfifo_test_fifo_segment_prealloc (int verbose)
   free_space = fifo_segment_free_bytes (fs);
   SFIFO_TEST (free_space <= 256 << 10, "free space expected %u is %u",
 	      256 << 10, free_space);
-  rv = fifo_segment_prealloc_fifo_chunks (fs, 4096, 50);
+  rv = fifo_segment_prealloc_fifo_chunks (fs, 0, 4096, 50);
   SFIFO_TEST (rv == 0, "chunk prealloc should work");
   rv = fifo_segment_num_free_chunks (fs, 4096);
   SFIFO_TEST (rv == 50, "prealloc chunks expected %u is %u", 50, rv);
@@ -2542,7 +2787,7 @@ sfifo_test_fifo_segment_prealloc (int verbose)
   SFIFO_TEST (rv == 4096 * 50, "chunk free space expected %u is %u",
 	      4096 * 50, rv);
 
-  rv = fifo_segment_prealloc_fifo_hdrs (fs, 50);
+  rv = fifo_segment_prealloc_fifo_hdrs (fs, 0, 50);
   SFIFO_TEST (rv == 0, "fifo hdr prealloc should work");
   rv = fifo_segment_num_free_fifos (fs);
   SFIFO_TEST (rv == 50, "prealloc fifo hdrs expected %u is %u", 50, rv);
@@ -2585,7 +2830,7 @@ sfifo_test_fifo_segment_prealloc (int verbose)
   /* Preallocate as many more chunks as possible. Heap is almost full
    * so we may not use all the free space*/
   alloc = 0;
-  while (!fifo_segment_prealloc_fifo_chunks (fs, 4096, 1))
+  while (!fifo_segment_prealloc_fifo_chunks (fs, 0, 4096, 1))
     alloc++;
   SFIFO_TEST (alloc, "chunk prealloc should work %u", alloc);
   rv = fifo_segment_num_free_chunks (fs, 4096);
@@ -2607,10 +2852,10 @@ sfifo_test_fifo_segment_prealloc (int verbose)
   f = fifo_segment_alloc_fifo (fs, 200 << 10, FIFO_SEGMENT_RX_FIFO);
   SFIFO_TEST (f == 0, "fifo alloc should fail");
 
-  rv = fifo_segment_prealloc_fifo_chunks (fs, 4096, 50);
+  rv = fifo_segment_prealloc_fifo_chunks (fs, 0, 4096, 50);
   SFIFO_TEST (rv == -1, "chunk prealloc should fail");
 
-  rv = fifo_segment_prealloc_fifo_hdrs (fs, 50);
+  rv = fifo_segment_prealloc_fifo_hdrs (fs, 0, 50);
   SFIFO_TEST (rv == -1, "fifo hdr prealloc should fail");
 
   /*
@@ -2715,6 +2960,10 @@ svm_fifo_test (vlib_main_t * vm, unformat_input_t * input,
 	res = sfifo_test_fifo7 (vm, input);
       else if (unformat (input, "large"))
 	res = sfifo_test_fifo_large (vm, input);
+      else if (unformat (input, "enq-segs"))
+	res = sfifo_test_fifo_enqueue_segs (vm, input);
+      else if (unformat (input, "tail-segs"))
+	res = sfifo_test_fifo_tail_segs (vm, input);
       else if (unformat (input, "replay"))
 	res = sfifo_test_fifo_replay (vm, input);
       else if (unformat (input, "grow"))
@@ -2776,6 +3025,12 @@ svm_fifo_test (vlib_main_t * vm, unformat_input_t * input,
 	  if ((res = sfifo_test_fifo7 (vm, input)))
 	    goto done;
 
+	  if ((res = sfifo_test_fifo_enqueue_segs (vm, input)))
+	    goto done;
+
+	  if ((res = sfifo_test_fifo_tail_segs (vm, input)))
+	    goto done;
+
 	  if ((res = sfifo_test_fifo_grow (vm, input)))
 	    goto done;
 
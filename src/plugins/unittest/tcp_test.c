@@ -1102,6 +1102,461 @@ tcp_test_delivery (vlib_main_t * vm, unformat_input_t * input)
   return 0;
 }
 
+static int
+tcp_test_tso (vlib_main_t * vm, unformat_input_t * input)
+{
+  vnet_interface_main_t *im = &vnet_get_main ()->interface_main;
+  u32 gso_interface_count, bi, snd_nxt, mss;
+  tcp_main_t *tm = vnet_get_tcp_main ();
+  tcp_connection_t *tc;
+  vlib_buffer_t *b;
+  u8 tso, is_tso[3];
+
+  pool_get (tm->connections[0], tc);
+  clib_memset (tc, 0, sizeof (*tc));
+  tc->c_c_index = tc - tm->connections[0];
+  tc->c_thread_index = 0;
+  tc->c_is_ip4 = 1;
+  tc->c_lcl_port = clib_host_to_net_u16 (1234);
+  tc->c_rmt_port = clib_host_to_net_u16 (11234);
+  tc->rcv_opts.mss = 1450;
+
+  /*
+   * New connections are tso capable only if configured and if gso
+   * segments can leave the node graph
+   */
+  tso = tm->tso;
+  gso_interface_count = im->gso_interface_count;
+
+  tm->tso = 1;
+  im->gso_interface_count = 0;
+  tcp_connection_init_vars (tc);
+  is_tso[0] = transport_connection_is_tso (&tc->connection);
+
+  tm->tso = 0;
+  im->gso_interface_count = 1;
+  tcp_connection_init_vars (tc);
+  is_tso[1] = transport_connection_is_tso (&tc->connection);
+
+  tm->tso = 1;
+  tcp_connection_init_vars (tc);
+  is_tso[2] = transport_connection_is_tso (&tc->connection);
+
+  tm->tso = tso;
+  im->gso_interface_count = gso_interface_count;
+
+  TCP_TEST (!is_tso[0], "no tso without gso interfaces");
+  TCP_TEST (!is_tso[1], "no tso unless configured");
+  TCP_TEST (is_tso[2], "tso with gso interfaces");
+
+  /*
+   * A super segment is marked for gso with the connection's mss. Use
+   * close-wait, not established, as there is no session and tx fifo.
+   */
+  tc->state = TCP_STATE_CLOSE_WAIT;
+  tc->snd_opts_len = 0;
+  mss = tc->snd_mss;
+  snd_nxt = tc->snd_nxt;
+
+  TCP_TEST (vlib_buffer_alloc (vm, &bi, 1) == 1, "buffer allocated");
+  b = vlib_get_buffer (vm, bi);
+  vlib_buffer_make_headroom (b, TRANSPORT_MAX_HDRS_LEN);
+
+  /* the length of a chain of four segments, without the chain */
+  b->current_length = mss;
+  b->flags |= VLIB_BUFFER_NEXT_PRESENT;
+  b->total_length_not_including_first_buffer = 3 * mss;
+
+  tcp_session_push_header (&tc->connection, b);
+  TCP_TEST (b->flags & VNET_BUFFER_F_GSO, "super segment is gso");
+  TCP_TEST (vnet_buffer2 (b)->gso_size == mss, "gso size %u is mss %u",
+	    vnet_buffer2 (b)->gso_size, mss);
+  TCP_TEST (vnet_buffer2 (b)->gso_l4_hdr_sz == sizeof (tcp_header_t),
+	    "gso l4 header size %u", vnet_buffer2 (b)->gso_l4_hdr_sz);
+  TCP_TEST (tc->snd_nxt == snd_nxt + 4 * mss, "snd_nxt moved 4 segments");
+
+  /* a segment of exactly one mss is sent as is */
+  b->flags &= ~(VLIB_BUFFER_NEXT_PRESENT | VNET_BUFFER_F_GSO);
+  b->total_length_not_including_first_buffer = 0;
+  b->current_data = TRANSPORT_MAX_HDRS_LEN;
+  b->current_length = mss;
+
+  tcp_session_push_header (&tc->connection, b);
+  TCP_TEST (!(b->flags & VNET_BUFFER_F_GSO), "mss segment is not gso");
+  TCP_TEST (tc->snd_nxt == snd_nxt + 5 * mss, "snd_nxt moved 1 segment");
+
+  vlib_buffer_free (vm, &bi, 1);
+  tcp_connection_timers_reset (tc);
+  pool_put (tm->connections[0], tc);
+
+  return 0;
+}
+
+static void
+tcp_test_gro_segment (vlib_buffer_t * b, u32 seq, u32 data_len)
+{
+  b->current_data = 0;
+  b->current_length = sizeof (tcp_header_t) + data_len;
+  b->flags &= ~VLIB_BUFFER_NEXT_PRESENT;
+  vnet_buffer (b)->tcp.seq_number = seq;
+  vnet_buffer (b)->tcp.data_offset = sizeof (tcp_header_t);
+  vnet_buffer (b)->tcp.data_len = data_len;
+}
+
+static int
+tcp_test_gro (vlib_main_t * vm, unformat_input_t * input)
+{
+  tcp_connection_t _tc, *tc = &_tc, _tc2, *tc2 = &_tc2;
+  tcp_header_t _th, *th = &_th;
+  tcp_gro_ctx_t _gro, *gro = &_gro;
+  vlib_buffer_t *b[4];
+  u32 bis[4];
+
+  clib_memset (tc, 0, sizeof (*tc));
+  clib_memset (tc2, 0, sizeof (*tc2));
+  clib_memset (th, 0, sizeof (*th));
+  clib_memset (gro, 0, sizeof (*gro));
+  tc->rcv_nxt = 1000;
+  tc2->rcv_nxt = 1000;
+  th->flags = TCP_FLAG_ACK;
+
+  TCP_TEST (vlib_buffer_alloc (vm, bis, 4) == 4, "buffers allocated");
+  vlib_get_buffers (vm, bis, b, 4);
+
+  /*
+   * In order data segments are chained
+   */
+  tcp_test_gro_segment (b[0], 1000, 100);
+  TCP_TEST (tcp_gro_can_append (gro, tc, b[0], th), "first segment");
+  tcp_gro_append (gro, tc, b[0], bis[0]);
+  TCP_TEST (tc->rcv_nxt == 1100, "rcv_nxt %u advanced", tc->rcv_nxt);
+  TCP_TEST (b[0]->current_length == 100, "header stripped");
+
+  th->flags = TCP_FLAG_ACK | TCP_FLAG_PSH;
+  tcp_test_gro_segment (b[1], 1100, 200);
+  TCP_TEST (tcp_gro_can_append (gro, tc, b[1], th), "psh segment");
+  tcp_gro_append (gro, tc, b[1], bis[1]);
+  th->flags = TCP_FLAG_ACK;
+
+  TCP_TEST (gro->head == b[0] && gro->tail == b[1], "head and tail");
+  TCP_TEST ((b[0]->flags & VLIB_BUFFER_NEXT_PRESENT)
+	    && b[0]->next_buffer == bis[1], "segments chained");
+  TCP_TEST (gro->n_segs == 2 && gro->n_bytes == 300,
+	    "%u segments, %u bytes", gro->n_segs, gro->n_bytes);
+  TCP_TEST (gro->rcv_nxt == 1000 && tc->rcv_nxt == 1300,
+	    "rcv_nxt before chain %u, after %u", gro->rcv_nxt, tc->rcv_nxt);
+
+  /*
+   * Anything else ends the chain
+   */
+  tcp_test_gro_segment (b[2], 1400, 100);
+  TCP_TEST (!tcp_gro_can_append (gro, tc, b[2], th), "out of order");
+
+  tcp_test_gro_segment (b[2], 1300, 0);
+  TCP_TEST (!tcp_gro_can_append (gro, tc, b[2], th), "no data");
+
+  tcp_test_gro_segment (b[2], 1300, 100);
+  th->flags = TCP_FLAG_ACK | TCP_FLAG_FIN;
+  TCP_TEST (!tcp_gro_can_append (gro, tc, b[2], th), "fin");
+  th->flags = TCP_FLAG_ACK | TCP_FLAG_URG;
+  TCP_TEST (!tcp_gro_can_append (gro, tc, b[2], th), "urg");
+  th->flags = TCP_FLAG_ACK;
+
+  tc2->rcv_nxt = 1300;
+  TCP_TEST (!tcp_gro_can_append (gro, tc2, b[2], th), "other connection");
+
+  b[2]->flags |= VLIB_BUFFER_NEXT_PRESENT;
+  TCP_TEST (!tcp_gro_can_append (gro, tc, b[2], th), "buffer chain");
+  tcp_test_gro_segment (b[2], 1300, 100);
+
+  b[2]->current_length += 1;
+  TCP_TEST (!tcp_gro_can_append (gro, tc, b[2], th), "padded segment");
+  tcp_test_gro_segment (b[2], 1300, 100);
+
+  /* the chain is limited to TCP_GRO_MAX_BYTES */
+  gro->n_bytes = TCP_GRO_MAX_BYTES - 100;
+  TCP_TEST (tcp_gro_can_append (gro, tc, b[2], th), "up to max bytes");
+  gro->n_bytes = TCP_GRO_MAX_BYTES - 99;
+  TCP_TEST (!tcp_gro_can_append (gro, tc, b[2], th), "over max bytes");
+  gro->n_bytes = 300;
+
+  /* a new chain can start on any connection */
+  gro->n_segs = 0;
+  tcp_test_gro_segment (b[3], 1300, 100);
+  TCP_TEST (tcp_gro_can_append (gro, tc2, b[3], th), "new chain");
+
+  b[0]->flags &= ~VLIB_BUFFER_NEXT_PRESENT;
+  vlib_buffer_free (vm, bis, 4);
+
+  return 0;
+}
+
+static int
+tcp_test_syn_cookie (vlib_main_t * vm, unformat_input_t * input)
+{
+  static const u16 mss_in[] = { 100, 536, 1000, 1459, 1460, 1500, 9000 };
+  static const u16 mss_out[] = { 536, 536, 536, 1440, 1460, 1460, 8960 };
+  tcp_connection_t _tc, *tc = &_tc;
+  tcp_worker_ctx_t *wrk = tcp_get_worker (vlib_get_thread_index ());
+  tcp_options_t _opts, *opts = &_opts, _ropts, *ropts = &_ropts;
+  u32 irs = 0x12345678, cookie, tsval, time_now;
+  u16 mss;
+  int i;
+
+  clib_memset (tc, 0, sizeof (*tc));
+  tc->c_is_ip4 = 1;
+  tc->c_lcl_ip4.as_u32 = clib_host_to_net_u32 (0x06000101);
+  tc->c_rmt_ip4.as_u32 = clib_host_to_net_u32 (0x06000102);
+  tc->c_lcl_port = clib_host_to_net_u16 (1234);
+  tc->c_rmt_port = clib_host_to_net_u16 (11234);
+
+  /*
+   * The peer's mss is rounded down to one the cookie can encode, and
+   * recovered from the cookie
+   */
+  for (i = 0; i < ARRAY_LEN (mss_in); i++)
+    {
+      mss = mss_in[i];
+      cookie = tcp_syn_cookie_make (tc, irs, &mss);
+      TCP_TEST (mss == mss_out[i], "mss %u encoded as %u", mss_in[i], mss);
+      mss = 0;
+      TCP_TEST (!tcp_syn_cookie_check (tc, irs, cookie, &mss),
+		"cookie for mss %u valid", mss_in[i]);
+      TCP_TEST (mss == mss_out[i], "mss %u decoded", mss);
+    }
+
+  /*
+   * A cookie is only valid for the connection and SYN it was made for
+   */
+  mss = 1460;
+  cookie = tcp_syn_cookie_make (tc, irs, &mss);
+  TCP_TEST (tcp_syn_cookie_check (tc, irs + 1, cookie, &mss),
+	    "other irs invalid");
+  tc->c_rmt_port = clib_host_to_net_u16 (11235);
+  TCP_TEST (tcp_syn_cookie_check (tc, irs, cookie, &mss),
+	    "other port invalid");
+  tc->c_rmt_port = clib_host_to_net_u16 (11234);
+  tc->c_rmt_ip4.as_u32 = clib_host_to_net_u32 (0x06000103);
+  TCP_TEST (tcp_syn_cookie_check (tc, irs, cookie, &mss),
+	    "other address invalid");
+  tc->c_rmt_ip4.as_u32 = clib_host_to_net_u32 (0x06000102);
+
+  /*
+   * Cookies expire after TCP_SYN_COOKIE_MAX_AGE counter periods
+   */
+  time_now = wrk->time_now;
+  wrk->time_now = 0x10000 + 0x8000;
+  cookie = tcp_syn_cookie_make (tc, irs, &mss);
+  wrk->time_now += 0x10000;
+  TCP_TEST (!tcp_syn_cookie_check (tc, irs, cookie, &mss),
+	    "cookie from last period valid");
+  wrk->time_now += 0x10000;
+  TCP_TEST (tcp_syn_cookie_check (tc, irs, cookie, &mss),
+	    "cookie from two periods ago invalid");
+
+  /*
+   * Window scale and sack permitted go through the low bits of the
+   * tsval, which is never ahead of now
+   */
+  for (i = 0; i < 4 * (TCP_MAX_WND_SCALE + 2); i++)
+    {
+      clib_memset (opts, 0, sizeof (*opts));
+      clib_memset (ropts, 0, sizeof (*ropts));
+      if (i % (TCP_MAX_WND_SCALE + 2) <= TCP_MAX_WND_SCALE)
+	{
+	  opts->flags |= TCP_OPTS_FLAG_WSCALE;
+	  opts->wscale = i % (TCP_MAX_WND_SCALE + 2);
+	}
+      if ((i / (TCP_MAX_WND_SCALE + 2)) & 1)
+	opts->flags |= TCP_OPTS_FLAG_SACK_PERMITTED;
+
+      /* the tsval low bits are all set, or all clear */
+      wrk->time_now = ((i / (TCP_MAX_WND_SCALE + 2)) & 2) ? 0x1001f : 0x10000;
+
+      tsval = tcp_syn_cookie_tsval (opts);
+      TCP_TEST (timestamp_leq (tsval, wrk->time_now)
+		&& timestamp_lt (wrk->time_now - 32, tsval),
+		"tsval %x within 32 ticks before %x", tsval, wrk->time_now);
+
+      tcp_syn_cookie_tsecr_opts (tsval, ropts);
+      TCP_TEST (tcp_opts_wscale (ropts) == tcp_opts_wscale (opts),
+		"wscale %d recovered", opts->wscale);
+      TCP_TEST (!tcp_opts_wscale (opts) || ropts->wscale == opts->wscale,
+		"wscale %d recovered as %d", opts->wscale, ropts->wscale);
+      TCP_TEST (tcp_opts_sack_permitted (ropts)
+		== tcp_opts_sack_permitted (opts), "sack permitted recovered");
+    }
+
+  /* the tsval does not go back across a wrap of the tcp clock */
+  wrk->time_now = 0x5;
+  clib_memset (opts, 0, sizeof (*opts));
+  tsval = tcp_syn_cookie_tsval (opts);
+  TCP_TEST (timestamp_leq (tsval, wrk->time_now), "tsval %x before %x",
+	    tsval, wrk->time_now);
+
+  wrk->time_now = time_now;
+
+  return 0;
+}
+
+static int
+tcp_test_rack (vlib_main_t * vm, unformat_input_t * input)
+{
+  u32 thread_index = vlib_get_thread_index ();
+  tcp_main_t *tm = vnet_get_tcp_main ();
+  sack_block_t block;
+  sack_scoreboard_t *sb;
+  tcp_connection_t *tc;
+  f64 *now;
+
+  now = &session_main.wrk[thread_index].last_vlib_time;
+
+  /* Timers need a connection the rack timer wheel can look up */
+  pool_get (tm->connections[thread_index], tc);
+  clib_memset (tc, 0, sizeof (*tc));
+  tc->c_c_index = tc - tm->connections[thread_index];
+  tc->c_thread_index = thread_index;
+  tc->state = TCP_STATE_ESTABLISHED;
+  tc->snd_mss = 100;
+  tc->rcv_opts.flags |= TCP_OPTS_FLAG_SACK;
+  tc->srtt = 100;
+  tc->rto = 1000;
+  tcp_connection_timers_init (tc);
+  scoreboard_init (&tc->sack_sb);
+  tcp_bt_init (tc);
+  tcp_rack_init (tc);
+  sb = &tc->sack_sb;
+
+  /*
+   * The most recently sent delivered segment is tracked. Acks for
+   * retransmits faster than min rtt are ambiguous and ignored.
+   */
+  *now = 10;
+  tcp_rack_update (tc, 9, 100, 0);
+  TCP_TEST (tc->rack.xmit_ts == 9 && tc->rack.end_seq == 100,
+	    "rack segment tracked");
+  TCP_TEST (tc->rack.rtt == 1 && tc->rack.min_rtt == 1, "rack rtt 1");
+
+  tcp_rack_update (tc, 8.5, 200, 0);
+  TCP_TEST (tc->rack.xmit_ts == 9, "older segment not tracked");
+
+  tcp_rack_update (tc, 9.5, 300, 1 /* is_rxt */ );
+  TCP_TEST (tc->rack.xmit_ts == 9 && tc->rack.min_rtt == 1,
+	    "ambiguous retransmit ignored");
+
+  tcp_rack_update (tc, 9.75, 300, 0);
+  TCP_TEST (tc->rack.xmit_ts == 9.75 && tc->rack.end_seq == 300,
+	    "newer segment tracked");
+  TCP_TEST (tc->rack.min_rtt == 0.25, "min rtt %f", tc->rack.min_rtt);
+
+  /*
+   * Three bursts, sent at times 1, 2 and 3. The last one is sacked.
+   */
+  tcp_rack_init (tc);
+  *now = 1;
+  tcp_bt_track_tx (tc);
+  tc->snd_nxt += 100;
+  *now = 2;
+  tcp_bt_track_tx (tc);
+  tc->snd_nxt += 100;
+  *now = 3;
+  tcp_bt_track_tx (tc);
+  tc->snd_nxt += 100;
+  tc->snd_una_max = tc->snd_nxt;
+
+  block.start = 200;
+  block.end = 300;
+  vec_add1 (tc->rcv_opts.sacks, block);
+  tc->rcv_opts.n_sack_blocks = 1;
+  tcp_rcv_sacks (tc, 0);
+  TCP_TEST (pool_elts (sb->holes) == 1 && sb->lost_bytes == 0,
+	    "one hole, not lost by dupthresh");
+
+  /* sacked burst delivered at 3.4: rtt 0.4, reordering window 0.1 */
+  *now = 3.4;
+  tcp_rack_update (tc, 3, 300, 0);
+
+  /* the hole was sent at 1, so it is due at 1.5 */
+  *now = 1.45;
+  TCP_TEST (tcp_rack_detect_loss (tc) == 0, "hole not yet lost");
+  TCP_TEST (tc->rack.timer != TCP_TIMER_HANDLE_INVALID
+	    && tc->rack.timer_id == TCP_RACK_TIMER_REO,
+	    "reordering timer armed");
+
+  *now = 3.5;
+  TCP_TEST (tcp_rack_detect_loss (tc) == 200, "hole lost");
+  TCP_TEST (sb->lost_bytes == 200, "lost bytes %u", sb->lost_bytes);
+  TCP_TEST (tc->rack.timer == TCP_TIMER_HANDLE_INVALID,
+	    "reordering timer stopped");
+  TCP_TEST (tcp_rack_detect_loss (tc) == 0, "lost only once");
+
+  /*
+   * Tail loss probe timer
+   */
+  scoreboard_clear (sb);
+  tcp_rack_init (tc);
+  tc->snd_una = 0;
+  tc->snd_nxt = 300;
+
+  tcp_rack_tlp_schedule (tc);
+  TCP_TEST (tc->rack.timer != TCP_TIMER_HANDLE_INVALID
+	    && tc->rack.timer_id == TCP_RACK_TIMER_TLP, "tlp timer armed");
+
+  /* single segment flight waits for a delayed ack, and then the
+   * retransmit timer is sooner */
+  tc->snd_nxt = 100;
+  tc->rto = 300;
+  tcp_rack_tlp_schedule (tc);
+  TCP_TEST (tc->rack.timer == TCP_TIMER_HANDLE_INVALID,
+	    "no tlp if rto is sooner");
+  tc->rto = 1000;
+
+  tcp_rack_tlp_schedule (tc);
+  TCP_TEST (tc->rack.timer != TCP_TIMER_HANDLE_INVALID, "tlp re-armed");
+  tc->snd_una = tc->snd_nxt;
+  tcp_rack_tlp_schedule (tc);
+  TCP_TEST (tc->rack.timer == TCP_TIMER_HANDLE_INVALID,
+	    "no tlp without outstanding data");
+
+  /*
+   * Acks for the probe: a dsack means the probe was not needed, an ack
+   * beyond it that it repaired a loss and cwnd is reduced
+   */
+  tc->cc_algo = tcp_cc_algo_get (TCP_CC_NEWRENO);
+  tc->snd_una = 0;
+  tc->snd_nxt = 300;
+  tc->cwnd = tc->prev_cwnd = 10 * tc->snd_mss;
+  tc->ssthresh = ~0;
+  tc->rack.tlp_pending = 1;
+  tc->rack.tlp_is_rxt = 1;
+  tc->rack.tlp_high_seq = 300;
+
+  tcp_rack_tlp_rcv_ack (tc, 200);
+  TCP_TEST (tc->rack.tlp_pending, "probe pending until acked");
+
+  vec_reset_length (tc->rcv_opts.sacks);
+  vec_add1 (tc->rcv_opts.sacks, block);
+  tcp_rack_tlp_rcv_ack (tc, 300);
+  TCP_TEST (!tc->rack.tlp_pending, "dsack clears probe");
+  TCP_TEST (tc->cwnd == 10 * tc->snd_mss, "cwnd unchanged after dsack");
+
+  tc->rack.tlp_pending = 1;
+  vec_reset_length (tc->rcv_opts.sacks);
+  tcp_rack_tlp_rcv_ack (tc, 350);
+  TCP_TEST (!tc->rack.tlp_pending, "ack beyond probe clears it");
+  TCP_TEST (tc->cwnd == 2 * tc->snd_mss, "cwnd %u reduced", tc->cwnd);
+
+  vec_free (tc->rcv_opts.sacks);
+  tcp_rack_timer_reset (tc);
+  tcp_connection_timers_reset (tc);
+  scoreboard_clear (sb);
+  pool_free (sb->holes);
+  tcp_bt_cleanup (tc);
+  pool_put (tm->connections[thread_index], tc);
+
+  return 0;
+}
+
 static clib_error_t *
 tcp_test (vlib_main_t * vm,
 	  unformat_input_t * input, vlib_cli_command_t * cmd_arg)
@@ -1126,6 +1581,22 @@ tcp_test (vlib_main_t * vm,
 	{
 	  res = tcp_test_delivery (vm, input);
 	}
+      else if (unformat (input, "tso"))
+	{
+	  res = tcp_test_tso (vm, input);
+	}
+      else if (unformat (input, "gro"))
+	{
+	  res = tcp_test_gro (vm, input);
+	}
+      else if (unformat (input, "syn-cookie"))
+	{
+	  res = tcp_test_syn_cookie (vm, input);
+	}
+      else if (unformat (input, "rack"))
+	{
+	  res = tcp_test_rack (vm, input);
+	}
       else if (unformat (input, "all"))
 	{
 	  if ((res = tcp_test_sack (vm, input)))
@@ -1134,6 +1605,14 @@ tcp_test (vlib_main_t * vm,
 	    goto done;
 	  if ((res = tcp_test_delivery (vm, input)))
 	    goto done;
+	  if ((res = tcp_test_tso (vm, input)))
+	    goto done;
+	  if ((res = tcp_test_gro (vm, input)))
+	    goto done;
+	  if ((res = tcp_test_syn_cookie (vm, input)))
+	    goto done;
+	  if ((res = tcp_test_rack (vm, input)))
+	    goto done;
 	}
       else
 	break;
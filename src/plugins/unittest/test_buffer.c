@@ -82,6 +82,155 @@ VLIB_CLI_COMMAND (test_linearize_command, static) =
 };
 /* *INDENT-ON* */
 
+static u32
+buffer_pool_n_free (vlib_buffer_pool_t * bp)
+{
+  vlib_buffer_pool_thread_t *bpt;
+  u64 n_free = bp->n_buffers;
+
+  /* *INDENT-OFF* */
+  vec_foreach (bpt, bp->threads)
+    n_free += bpt->n_buffers_put - bpt->n_buffers_get +
+      vec_len (bpt->cached_buffers);
+  /* *INDENT-ON* */
+
+  return n_free;
+}
+
+static int
+buffer_alloc_unique (vlib_main_t * vm, u32 * bi, u32 n_buffers)
+{
+  uword *seen = 0;
+  u32 i, n_alloc, n_dups = 0;
+
+  n_alloc = vlib_buffer_alloc (vm, bi, n_buffers);
+  if (!TEST_I (n_alloc == n_buffers, "alloc %u buffers", n_buffers))
+    {
+      vlib_buffer_free (vm, bi, n_alloc);
+      return 1;
+    }
+
+  for (i = 0; i < n_buffers; i++)
+    {
+      n_dups += clib_bitmap_get (seen, bi[i]);
+      seen = clib_bitmap_set (seen, bi[i], 1);
+    }
+  clib_bitmap_free (seen);
+
+  TEST (0 == n_dups, "%u buffers allocated twice", n_dups);
+  return 0;
+}
+
+static void
+buffer_magazines_release (vlib_buffer_pool_t * bp, volatile u64 * head,
+			  u32 * held, vlib_buffer_pool_thread_t * bpt)
+{
+  u32 i;
+
+  for (i = 0; i < vec_len (held); i++)
+    vlib_buffer_magazine_push (bp, head, held[i], bpt);
+  vec_reset_length (held);
+}
+
+/* alloc refills the thread cache from full magazines and free flushes it
+   into empty ones. When the magazine stacks are drained the buffers go
+   through the pool's free list instead, and none may get lost */
+static int
+buffer_magazines (vlib_main_t * vm)
+{
+  u8 pool_index = vlib_buffer_pool_get_default_for_numa (vm, vm->numa_node);
+  vlib_buffer_pool_t *bp = vlib_get_buffer_pool (vm, pool_index);
+  vlib_buffer_pool_thread_t *bpt =
+    vec_elt_at_index (bp->threads, vm->thread_index);
+  u32 *bi = 0, *held_empty = 0, *held_full = 0;
+  u32 n_free, n_get, n_put, n_spilled, n, mi;
+  int rv = 1;
+
+  n = 8 * VLIB_BUFFER_POOL_MAGAZINE_SIZE;
+  n_free = buffer_pool_n_free (bp);
+  TEST (n_free >= n + vec_len (bpt->cached_buffers) +
+	VLIB_BUFFER_POOL_MAGAZINE_SIZE, "%u free buffers", n_free);
+  vec_validate (bi, n + vec_len (bpt->cached_buffers) +
+		VLIB_BUFFER_POOL_MAGAZINE_SIZE - 1);
+
+  /* round trip through the magazines */
+  n_get = bpt->n_magazines_get;
+  n_put = bpt->n_magazines_put;
+  if (buffer_alloc_unique (vm, bi, n))
+    goto done;
+  if (!TEST_I (bpt->n_magazines_get > n_get, "alloc took full magazines"))
+    goto done;
+  vlib_buffer_free (vm, bi, n);
+  if (!TEST_I (bpt->n_magazines_put > n_put, "free flushed magazines"))
+    goto done;
+  if (!TEST_I (vec_len (bpt->cached_buffers) <=
+	       4 * VLIB_BUFFER_POOL_MAGAZINE_SIZE, "thread cache bounded"))
+    goto done;
+  if (!TEST_I (n_free == buffer_pool_n_free (bp),
+	       "round trip keeps %u buffers", n_free))
+    goto done;
+
+  /* flush with no empty magazine spills to the free list */
+  if (buffer_alloc_unique (vm, bi, n))
+    goto done;
+  while (~0 != (mi = vlib_buffer_magazine_pop (bp, &bp->empty_magazines,
+					       bpt)))
+    vec_add1 (held_empty, mi);
+  n_put = bpt->n_magazines_put;
+  vlib_buffer_free (vm, bi, n);
+  buffer_magazines_release (bp, &bp->empty_magazines, held_empty, bpt);
+  if (!TEST_I (bpt->n_magazines_put == n_put, "no magazine flushed"))
+    goto done;
+  n_spilled = vec_len (bp->free_buffers);
+  if (!TEST_I (n_spilled > 0, "%u buffers spilled", n_spilled))
+    goto done;
+
+  /* refill with no full magazine takes them back */
+  while (~0 != (mi = vlib_buffer_magazine_pop (bp, &bp->full_magazines,
+					       bpt)))
+    vec_add1 (held_full, mi);
+  n = vec_len (bpt->cached_buffers) + VLIB_BUFFER_POOL_MAGAZINE_SIZE;
+  if (buffer_alloc_unique (vm, bi, n))
+    goto done;
+  if (!TEST_I (vec_len (bp->free_buffers) < n_spilled,
+	       "refill took spilled buffers"))
+    goto done;
+  vlib_buffer_free (vm, bi, n);
+  buffer_magazines_release (bp, &bp->full_magazines, held_full, bpt);
+  if (!TEST_I (n_free == buffer_pool_n_free (bp),
+	       "spill and refill keep %u buffers", n_free))
+    goto done;
+
+  rv = 0;
+
+done:
+  buffer_magazines_release (bp, &bp->empty_magazines, held_empty, bpt);
+  buffer_magazines_release (bp, &bp->full_magazines, held_full, bpt);
+  vec_free (bi);
+  vec_free (held_empty);
+  vec_free (held_full);
+  return rv;
+}
+
+static clib_error_t *
+test_buffer_magazines_fn (vlib_main_t * vm, unformat_input_t * input,
+			  vlib_cli_command_t * cmd)
+{
+  if (buffer_magazines (vm))
+    return clib_error_return (0, "buffer_magazines failed");
+
+  return (NULL);
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (test_buffer_magazines_command, static) =
+{
+  .path = "test buffer-magazines",
+  .short_help = "test buffer-magazines",
+  .function = test_buffer_magazines_fn,
+};
+/* *INDENT-ON* */
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
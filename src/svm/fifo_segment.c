@@ -14,6 +14,7 @@
  */
 
 #include <svm/fifo_segment.h>
+#include <vppinfra/lock.h>
 
 /**
  * Fifo segment free space
@@ -34,8 +35,30 @@ fs_free_space (fifo_segment_t * fs)
   return dlminfo.fordblks;
 }
 
+static inline fifo_segment_slice_t *
+fsh_slice_get (fifo_segment_header_t * fsh, u32 slice_index)
+{
+  ASSERT (slice_index < fsh->n_slices);
+  return &fsh->slices[slice_index];
+}
+
+static inline void
+fss_lock (fifo_segment_slice_t * fss)
+{
+  while (clib_atomic_test_and_set (&fss->lock))
+    CLIB_PAUSE ();
+}
+
+static inline void
+fss_unlock (fifo_segment_slice_t * fss)
+{
+  clib_atomic_release (&fss->lock);
+}
+
 /**
  * Initialize fifo segment shared header
+ *
+ * Number of slices is taken from fs->n_slices, which defaults to 1.
  */
 int
 fifo_segment_init (fifo_segment_t * fs)
@@ -45,10 +68,15 @@ fifo_segment_init (fifo_segment_t * fs)
   void *oldheap;
 
   sh = fs->ssvm.sh;
+  fs->n_slices = clib_max (fs->n_slices, 1);
   oldheap = ssvm_push_heap (sh);
 
   fsh = clib_mem_alloc (sizeof (*fsh));
   clib_memset (fsh, 0, sizeof (*fsh));
+  fsh->slices = clib_mem_alloc_aligned (sizeof (fifo_segment_slice_t) *
+					fs->n_slices, CLIB_CACHE_LINE_BYTES);
+  clib_memset (fsh->slices, 0, sizeof (fifo_segment_slice_t) * fs->n_slices);
+  fsh->n_slices = fs->n_slices;
   fs->h = sh->opaque[0] = fsh;
 
   ssvm_pop_heap (oldheap);
@@ -120,6 +148,7 @@ fifo_segment_attach (fifo_segment_main_t * sm, fifo_segment_create_args_t * a)
 
   /* Fish the segment header */
   s->h = s->ssvm.sh->opaque[0];
+  s->n_slices = s->h->n_slices;
 
   vec_add1 (a->new_segment_indices, s - sm->segments);
   return (0);
@@ -190,20 +219,20 @@ fs_chunk_size_is_valid (u32 size)
 }
 
 static svm_fifo_t *
-fs_try_alloc_fifo_freelist (fifo_segment_t * fs, u32 fl_index, u32 data_bytes)
+fs_try_alloc_fifo_freelist (fifo_segment_slice_t * fss, u32 fl_index,
+			    u32 data_bytes)
 {
-  fifo_segment_header_t *fsh = fs->h;
   svm_fifo_chunk_t *c;
   svm_fifo_t *f;
 
-  f = fsh->free_fifos;
-  c = fsh->free_chunks[fl_index];
+  f = fss->free_fifos;
+  c = fss->free_chunks[fl_index];
 
   if (!f || !c)
     return 0;
 
-  fsh->free_fifos = f->next;
-  fsh->free_chunks[fl_index] = c->next;
+  fss->free_fifos = f->next;
+  fss->free_chunks[fl_index] = c->next;
   c->next = c;
   c->start_byte = 0;
   c->length = data_bytes;
@@ -211,19 +240,20 @@ fs_try_alloc_fifo_freelist (fifo_segment_t * fs, u32 fl_index, u32 data_bytes)
   f->start_chunk = c;
   f->end_chunk = c;
 
-  fsh->n_fl_chunk_bytes -= fs_freelist_index_to_size (fl_index);
+  fss->n_fl_chunk_bytes -= fs_freelist_index_to_size (fl_index);
   return f;
 }
 
 static svm_fifo_t *
-fs_try_alloc_fifo_freelist_multi_chunk (fifo_segment_t * fs, u32 data_bytes)
+fs_try_alloc_fifo_freelist_multi_chunk (fifo_segment_t * fs,
+					fifo_segment_slice_t * fss,
+					u32 data_bytes)
 {
   svm_fifo_chunk_t *c, *first = 0, *last = 0;
-  fifo_segment_header_t *fsh = fs->h;
   u32 fl_index, fl_size, n_alloc = 0;
   svm_fifo_t *f;
 
-  f = fsh->free_fifos;
+  f = fss->free_fifos;
   if (!f)
     {
       void *oldheap = ssvm_push_heap (fs->ssvm.sh);
@@ -233,17 +263,21 @@ fs_try_alloc_fifo_freelist_multi_chunk (fifo_segment_t * fs, u32 data_bytes)
 	return 0;
       memset (f, 0, sizeof (*f));
     }
+  else
+    {
+      fss->free_fifos = f->next;
+      memset (f, 0, sizeof (*f));
+    }
 
   fl_index = fs_freelist_for_size (data_bytes) - 1;
-  vec_validate_init_empty (fsh->free_chunks, fl_index, 0);
   fl_size = fs_freelist_index_to_size (fl_index);
 
   while (data_bytes)
     {
-      c = fsh->free_chunks[fl_index];
+      c = fss->free_chunks[fl_index];
       if (c)
 	{
-	  fsh->free_chunks[fl_index] = c->next;
+	  fss->free_chunks[fl_index] = c->next;
 	  if (!last)
 	    last = c;
 	  c->next = first;
@@ -262,12 +296,18 @@ fs_try_alloc_fifo_freelist_multi_chunk (fifo_segment_t * fs, u32 data_bytes)
   f->start_chunk = first;
   f->end_chunk = last;
   last->next = first;
-  fsh->n_fl_chunk_bytes -= n_alloc;
+  fss->n_fl_chunk_bytes -= n_alloc;
   return f;
 }
 
+/**
+ * Refill slice freelists with a batch of fifo headers and chunks
+ *
+ * Must be called with the slice lock held.
+ */
 static int
-fs_try_alloc_fifo_batch (fifo_segment_t * fs, u32 fl_index, u32 batch_size)
+fs_try_alloc_fifo_batch (fifo_segment_t * fs, fifo_segment_slice_t * fss,
+			 u32 fl_index, u32 batch_size)
 {
   fifo_segment_header_t *fsh = fs->h;
   u32 size, hdrs, rounded_data_size;
@@ -277,7 +317,6 @@ fs_try_alloc_fifo_batch (fifo_segment_t * fs, u32 fl_index, u32 batch_size)
   u8 *fmem;
   int i;
 
-  vec_validate_init_empty (fsh->free_chunks, fl_index, 0);
   rounded_data_size = fs_freelist_index_to_size (fl_index);
   hdrs = sizeof (*f) + sizeof (*c);
   size = (hdrs + rounded_data_size) * batch_size;
@@ -297,18 +336,18 @@ fs_try_alloc_fifo_batch (fifo_segment_t * fs, u32 fl_index, u32 batch_size)
     {
       f = (svm_fifo_t *) fmem;
       memset (f, 0, sizeof (*f));
-      f->next = fsh->free_fifos;
-      fsh->free_fifos = f;
+      f->next = fss->free_fifos;
+      fss->free_fifos = f;
       c = (svm_fifo_chunk_t *) (fmem + sizeof (*f));
       c->start_byte = 0;
       c->length = rounded_data_size;
-      c->next = fsh->free_chunks[fl_index];
-      fsh->free_chunks[fl_index] = c;
+      c->next = fss->free_chunks[fl_index];
+      fss->free_chunks[fl_index] = c;
       fmem += hdrs + rounded_data_size;
     }
 
-  fsh->n_fl_chunk_bytes += batch_size * rounded_data_size;
-  fsh->n_free_bytes -= size;
+  fss->n_fl_chunk_bytes += batch_size * rounded_data_size;
+  clib_atomic_fetch_sub (&fsh->n_free_bytes, size);
 
   return 0;
 }
@@ -321,32 +360,34 @@ fs_try_alloc_fifo_batch (fifo_segment_t * fs, u32 fl_index, u32 batch_size)
  * - batch fifo and chunk allocation
  * - single fifo allocation
  * - grab multiple fifo chunks from freelists
+ *
+ * Must be called with the slice lock held.
  */
 static svm_fifo_t *
-fs_try_alloc_fifo (fifo_segment_t * fs, u32 data_bytes)
+fs_try_alloc_fifo (fifo_segment_t * fs, fifo_segment_slice_t * fss,
+		   u32 data_bytes)
 {
   fifo_segment_header_t *fsh = fs->h;
   u32 fifo_sz, fl_index;
   svm_fifo_t *f = 0;
 
   fl_index = fs_freelist_for_size (data_bytes);
-  vec_validate_init_empty (fsh->free_chunks, fl_index, 0);
   fifo_sz = sizeof (svm_fifo_t) + sizeof (svm_fifo_chunk_t);
   fifo_sz += 1 << max_log2 (data_bytes);
 
-  if (fsh->free_fifos && fsh->free_chunks[fl_index])
+  if (fss->free_fifos && fss->free_chunks[fl_index])
     {
-      f = fs_try_alloc_fifo_freelist (fs, fl_index, data_bytes);
+      f = fs_try_alloc_fifo_freelist (fss, fl_index, data_bytes);
       if (f)
 	goto done;
     }
   if (fifo_sz * FIFO_SEGMENT_ALLOC_BATCH_SIZE < fsh->n_free_bytes)
     {
-      if (fs_try_alloc_fifo_batch (fs, fl_index,
+      if (fs_try_alloc_fifo_batch (fs, fss, fl_index,
 				   FIFO_SEGMENT_ALLOC_BATCH_SIZE))
 	goto done;
 
-      f = fs_try_alloc_fifo_freelist (fs, fl_index, data_bytes);
+      f = fs_try_alloc_fifo_freelist (fss, fl_index, data_bytes);
       goto done;
     }
   if (fifo_sz <= fsh->n_free_bytes)
@@ -356,12 +397,12 @@ fs_try_alloc_fifo (fifo_segment_t * fs, u32 data_bytes)
       ssvm_pop_heap (oldheap);
       if (f)
 	{
-	  fsh->n_free_bytes -= fifo_sz;
+	  clib_atomic_fetch_sub (&fsh->n_free_bytes, fifo_sz);
 	  goto done;
 	}
     }
-  if (data_bytes <= fsh->n_fl_chunk_bytes)
-    f = fs_try_alloc_fifo_freelist_multi_chunk (fs, data_bytes);
+  if (data_bytes <= fss->n_fl_chunk_bytes)
+    f = fs_try_alloc_fifo_freelist_multi_chunk (fs, fss, data_bytes);
 
 done:
 
@@ -369,13 +410,14 @@ done:
 }
 
 /**
- * Allocate fifo in fifo segment
+ * Allocate fifo in fifo segment slice
  */
 svm_fifo_t *
-fifo_segment_alloc_fifo (fifo_segment_t * fs, u32 data_bytes,
-			 fifo_segment_ftype_t ftype)
+fifo_segment_alloc_fifo_w_slice (fifo_segment_t * fs, u32 slice_index,
+				 u32 data_bytes, fifo_segment_ftype_t ftype)
 {
-  fifo_segment_header_t *fsh;
+  fifo_segment_header_t *fsh = fs->h;
+  fifo_segment_slice_t *fss;
   svm_fifo_t *f = 0;
 
   if (!fs_chunk_size_is_valid (data_bytes))
@@ -384,15 +426,18 @@ fifo_segment_alloc_fifo (fifo_segment_t * fs, u32 data_bytes,
       return 0;
     }
 
-  fsh = fs->h;
-  ssvm_lock_non_recursive (fs->ssvm.sh, 1);
-
-  f = fs_try_alloc_fifo (fs, data_bytes);
+  fss = fsh_slice_get (fsh, slice_index);
+  fss_lock (fss);
+  f = fs_try_alloc_fifo (fs, fss, data_bytes);
   if (!f)
-    goto done;
+    {
+      fss_unlock (fss);
+      return 0;
+    }
 
   /* (re)initialize the fifo, as in svm_fifo_create */
   svm_fifo_init (f, data_bytes);
+  f->slice_index = slice_index;
 
   /* Initialize chunks and rbtree for multi-chunk fifos */
   if (f->start_chunk->next != f->start_chunk)
@@ -408,21 +453,30 @@ fifo_segment_alloc_fifo (fifo_segment_t * fs, u32 data_bytes,
    * only one. */
   if (ftype == FIFO_SEGMENT_RX_FIFO)
     {
-      if (fsh->fifos)
+      if (fss->fifos)
 	{
-	  fsh->fifos->prev = f;
-	  f->next = fsh->fifos;
+	  fss->fifos->prev = f;
+	  f->next = fss->fifos;
 	}
-      fsh->fifos = f;
+      fss->fifos = f;
       f->flags |= SVM_FIFO_F_LL_TRACKED;
     }
-  fsh->n_active_fifos++;
+  fss_unlock (fss);
+  clib_atomic_fetch_add (&fsh->n_active_fifos, 1);
 
-done:
-  ssvm_unlock_non_recursive (fs->ssvm.sh);
   return (f);
 }
 
+/**
+ * Allocate fifo in fifo segment's first slice
+ */
+svm_fifo_t *
+fifo_segment_alloc_fifo (fifo_segment_t * fs, u32 data_bytes,
+			 fifo_segment_ftype_t ftype)
+{
+  return fifo_segment_alloc_fifo_w_slice (fs, 0, data_bytes, ftype);
+}
+
 /**
  * Free fifo allocated in fifo segment
  */
@@ -431,6 +485,7 @@ fifo_segment_free_fifo (fifo_segment_t * fs, svm_fifo_t * f)
 {
   svm_fifo_chunk_t *cur, *next;
   fifo_segment_header_t *fsh;
+  fifo_segment_slice_t *fss;
   ssvm_shared_header_t *sh;
   void *oldheap;
   int fl_index;
@@ -442,8 +497,24 @@ fifo_segment_free_fifo (fifo_segment_t * fs, svm_fifo_t * f)
 
   sh = fs->ssvm.sh;
   fsh = fs->h;
+  fss = fsh_slice_get (fsh, f->slice_index);
+
+  /* Release what only the fifo points to before it is put on a freelist */
+  oldheap = ssvm_push_heap (sh);
+  svm_fifo_free_chunk_lookup (f);
+  ssvm_pop_heap (oldheap);
+
+  /* not allocated on segment heap */
+  svm_fifo_free_ooo_data (f);
+
+  if (CLIB_DEBUG)
+    {
+      f->master_session_index = ~0;
+      f->master_thread_index = ~0;
+    }
 
-  ssvm_lock_non_recursive (sh, 2);
+  /* The slice may belong to another thread, e.g., if the session moved */
+  fss_lock (fss);
 
   /* Remove from active list. Only rx fifos are tracked */
   if (f->flags & SVM_FIFO_F_LL_TRACKED)
@@ -451,27 +522,22 @@ fifo_segment_free_fifo (fifo_segment_t * fs, svm_fifo_t * f)
       if (f->prev)
 	f->prev->next = f->next;
       else
-	fsh->fifos = f->next;
+	fss->fifos = f->next;
       if (f->next)
 	f->next->prev = f->prev;
       f->flags &= ~SVM_FIFO_F_LL_TRACKED;
     }
 
-  /* Add to free list */
-  f->next = fsh->free_fifos;
-  f->prev = 0;
-  fsh->free_fifos = f;
-
   /* Free fifo chunks */
   cur = f->start_chunk;
   do
     {
       next = cur->next;
       fl_index = fs_freelist_for_size (cur->length);
-      ASSERT (fl_index < vec_len (fsh->free_chunks));
-      cur->next = fsh->free_chunks[fl_index];
-      fsh->free_chunks[fl_index] = cur;
-      fsh->n_fl_chunk_bytes += fs_freelist_index_to_size (fl_index);
+      ASSERT (fl_index < FIFO_SEGMENT_N_FREELISTS);
+      cur->next = fss->free_chunks[fl_index];
+      fss->free_chunks[fl_index] = cur;
+      fss->n_fl_chunk_bytes += fs_freelist_index_to_size (fl_index);
       cur = next;
     }
   while (cur != f->start_chunk);
@@ -479,27 +545,22 @@ fifo_segment_free_fifo (fifo_segment_t * fs, svm_fifo_t * f)
   f->start_chunk = f->end_chunk = f->new_chunks = 0;
   f->head_chunk = f->tail_chunk = f->ooo_enq = f->ooo_deq = 0;
 
-  oldheap = ssvm_push_heap (sh);
-  svm_fifo_free_chunk_lookup (f);
-  ssvm_pop_heap (oldheap);
-
-  /* not allocated on segment heap */
-  svm_fifo_free_ooo_data (f);
+  /* Add to free list */
+  f->next = fss->free_fifos;
+  f->prev = 0;
+  fss->free_fifos = f;
 
-  if (CLIB_DEBUG)
-    {
-      f->master_session_index = ~0;
-      f->master_thread_index = ~0;
-    }
+  fss_unlock (fss);
 
-  fsh->n_active_fifos--;
-  ssvm_unlock_non_recursive (sh);
+  clib_atomic_fetch_sub (&fsh->n_active_fifos, 1);
 }
 
 int
-fifo_segment_prealloc_fifo_hdrs (fifo_segment_t * fs, u32 batch_size)
+fifo_segment_prealloc_fifo_hdrs (fifo_segment_t * fs, u32 slice_index,
+				 u32 batch_size)
 {
   fifo_segment_header_t *fsh = fs->h;
+  fifo_segment_slice_t *fss;
   svm_fifo_t *f;
   void *oldheap;
   u32 size;
@@ -519,26 +580,30 @@ fifo_segment_prealloc_fifo_hdrs (fifo_segment_t * fs, u32 batch_size)
     return -1;
 
   /* Carve fifo + chunk space */
+  fss = fsh_slice_get (fsh, slice_index);
+  fss_lock (fss);
   for (i = 0; i < batch_size; i++)
     {
       f = (svm_fifo_t *) fmem;
       memset (f, 0, sizeof (*f));
-      f->next = fsh->free_fifos;
-      fsh->free_fifos = f;
+      f->next = fss->free_fifos;
+      fss->free_fifos = f;
       fmem += sizeof (*f);
     }
+  fss_unlock (fss);
 
-  fsh->n_free_bytes -= size;
+  clib_atomic_fetch_sub (&fsh->n_free_bytes, size);
 
   return 0;
 }
 
 int
-fifo_segment_prealloc_fifo_chunks (fifo_segment_t * fs, u32 chunk_size,
-				   u32 batch_size)
+fifo_segment_prealloc_fifo_chunks (fifo_segment_t * fs, u32 slice_index,
+				   u32 chunk_size, u32 batch_size)
 {
   fifo_segment_header_t *fsh = fs->h;
   u32 size, rounded_data_size, fl_index;
+  fifo_segment_slice_t *fss;
   svm_fifo_chunk_t *c;
   void *oldheap;
   u8 *cmem;
@@ -551,7 +616,6 @@ fifo_segment_prealloc_fifo_chunks (fifo_segment_t * fs, u32 chunk_size,
     }
 
   fl_index = fs_freelist_for_size (chunk_size);
-  vec_validate_init_empty (fsh->free_chunks, fl_index, 0);
   rounded_data_size = fs_freelist_index_to_size (fl_index);
   size = (sizeof (*c) + rounded_data_size) * batch_size;
 
@@ -566,18 +630,21 @@ fifo_segment_prealloc_fifo_chunks (fifo_segment_t * fs, u32 chunk_size,
     return -1;
 
   /* Carve fifo + chunk space */
+  fss = fsh_slice_get (fsh, slice_index);
+  fss_lock (fss);
   for (i = 0; i < batch_size; i++)
     {
       c = (svm_fifo_chunk_t *) cmem;
       c->start_byte = 0;
       c->length = rounded_data_size;
-      c->next = fsh->free_chunks[fl_index];
-      fsh->free_chunks[fl_index] = c;
+      c->next = fss->free_chunks[fl_index];
+      fss->free_chunks[fl_index] = c;
       cmem += sizeof (*c) + rounded_data_size;
     }
 
-  fsh->n_fl_chunk_bytes += batch_size * rounded_data_size;
-  fsh->n_free_bytes -= size;
+  fss->n_fl_chunk_bytes += batch_size * rounded_data_size;
+  fss_unlock (fss);
+  clib_atomic_fetch_sub (&fsh->n_free_bytes, size);
 
   return 0;
 }
@@ -591,9 +658,10 @@ fifo_segment_preallocate_fifo_pairs (fifo_segment_t * fs,
 				     u32 * n_fifo_pairs)
 {
   u32 rx_rounded_data_size, tx_rounded_data_size, pair_size, pairs_to_alloc;
+  u32 hdrs, pairs_per_slice, pairs_leftover, n_pairs, i;
   int rx_fl_index, tx_fl_index;
+  fifo_segment_slice_t *fss;
   uword space_available;
-  u32 hdrs;
 
   /* Parameter check */
   if (rx_fifo_size == 0 || tx_fifo_size == 0 || *n_fifo_pairs == 0)
@@ -627,10 +695,22 @@ fifo_segment_preallocate_fifo_pairs (fifo_segment_t * fs,
   if (!pairs_to_alloc)
     return;
 
-  if (fs_try_alloc_fifo_batch (fs, rx_fl_index, pairs_to_alloc))
-    clib_warning ("rx prealloc failed: pairs %u", pairs_to_alloc);
-  if (fs_try_alloc_fifo_batch (fs, tx_fl_index, pairs_to_alloc))
-    clib_warning ("tx prealloc failed: pairs %u", pairs_to_alloc);
+  pairs_per_slice = pairs_to_alloc / fs->h->n_slices;
+  pairs_leftover = pairs_to_alloc % fs->h->n_slices;
+
+  for (i = 0; i < fs->h->n_slices; i++)
+    {
+      fss = fsh_slice_get (fs->h, i);
+      n_pairs = pairs_per_slice + (i < pairs_leftover);
+      if (!n_pairs)
+	break;
+      fss_lock (fss);
+      if (fs_try_alloc_fifo_batch (fs, fss, rx_fl_index, n_pairs))
+	clib_warning ("rx prealloc failed: pairs %u", n_pairs);
+      if (fs_try_alloc_fifo_batch (fs, fss, tx_fl_index, n_pairs))
+	clib_warning ("tx prealloc failed: pairs %u", n_pairs);
+      fss_unlock (fss);
+    }
 
   /* Account for the pairs allocated */
   *n_fifo_pairs -= pairs_to_alloc;
@@ -639,6 +719,7 @@ fifo_segment_preallocate_fifo_pairs (fifo_segment_t * fs,
 int
 fifo_segment_grow_fifo (fifo_segment_t * fs, svm_fifo_t * f, u32 chunk_size)
 {
+  fifo_segment_slice_t *fss;
   ssvm_shared_header_t *sh;
   svm_fifo_chunk_t *c;
   void *oldheap;
@@ -653,10 +734,17 @@ fifo_segment_grow_fifo (fifo_segment_t * fs, svm_fifo_t * f, u32 chunk_size)
   fl_index = fs_freelist_for_size (chunk_size);
 
   sh = fs->ssvm.sh;
-  ssvm_lock_non_recursive (sh, 1);
+  fss = fsh_slice_get (fs->h, f->slice_index);
 
-  vec_validate_init_empty (fs->h->free_chunks, fl_index, 0);
-  c = fs->h->free_chunks[fl_index];
+  fss_lock (fss);
+  c = fss->free_chunks[fl_index];
+  if (c)
+    {
+      fss->free_chunks[fl_index] = c->next;
+      c->next = 0;
+      fss->n_fl_chunk_bytes -= fs_freelist_index_to_size (fl_index);
+    }
+  fss_unlock (fss);
 
   oldheap = ssvm_push_heap (sh);
 
@@ -666,21 +754,13 @@ fifo_segment_grow_fifo (fifo_segment_t * fs, svm_fifo_t * f, u32 chunk_size)
       if (!c)
 	{
 	  ssvm_pop_heap (oldheap);
-	  ssvm_unlock_non_recursive (sh);
 	  return -1;
 	}
     }
-  else
-    {
-      fs->h->free_chunks[fl_index] = c->next;
-      c->next = 0;
-      fs->h->n_fl_chunk_bytes -= fs_freelist_index_to_size (fl_index);
-    }
 
   svm_fifo_add_chunk (f, c);
 
   ssvm_pop_heap (oldheap);
-  ssvm_unlock_non_recursive (sh);
   return 0;
 }
 
@@ -688,27 +768,28 @@ int
 fifo_segment_collect_fifo_chunks (fifo_segment_t * fs, svm_fifo_t * f)
 {
   svm_fifo_chunk_t *cur, *next;
+  fifo_segment_slice_t *fss;
   ssvm_shared_header_t *sh;
   void *oldheap;
   int fl_index;
 
   sh = fs->ssvm.sh;
-  ssvm_lock_non_recursive (sh, 1);
+  fss = fsh_slice_get (fs->h, f->slice_index);
 
   oldheap = ssvm_push_heap (sh);
   cur = svm_fifo_collect_chunks (f);
+  ssvm_pop_heap (oldheap);
 
+  fss_lock (fss);
   while (cur)
     {
       next = cur->next;
       fl_index = fs_freelist_for_size (cur->length);
-      cur->next = fs->h->free_chunks[fl_index];
-      fs->h->free_chunks[fl_index] = cur;
+      cur->next = fss->free_chunks[fl_index];
+      fss->free_chunks[fl_index] = cur;
       cur = next;
     }
-
-  ssvm_pop_heap (oldheap);
-  ssvm_unlock_non_recursive (sh);
+  fss_unlock (fss);
 
   return 0;
 }
@@ -722,17 +803,13 @@ fifo_segment_num_fifos (fifo_segment_t * fs)
   return fs->h->n_active_fifos;
 }
 
-u32
-fifo_segment_num_free_fifos (fifo_segment_t * fs)
+static u32
+fs_slice_num_free_fifos (fifo_segment_slice_t * fss)
 {
-  fifo_segment_header_t *fsh = fs->h;
   svm_fifo_t *f;
   u32 count = 0;
 
-  f = fsh->free_fifos;
-  if (f == 0)
-    return 0;
-
+  f = fss->free_fifos;
   while (f)
     {
       f = f->next;
@@ -741,25 +818,44 @@ fifo_segment_num_free_fifos (fifo_segment_t * fs)
   return count;
 }
 
+/**
+ * Count free fifos in all slices
+ *
+ * Slices are locked one at a time, so the result is only an estimate
+ * while the segment is in use.
+ */
 u32
-fifo_segment_num_free_chunks (fifo_segment_t * fs, u32 size)
+fifo_segment_num_free_fifos (fifo_segment_t * fs)
+{
+  fifo_segment_header_t *fsh = fs->h;
+  fifo_segment_slice_t *fss;
+  u32 count = 0;
+  int i;
+
+  for (i = 0; i < fsh->n_slices; i++)
+    {
+      fss = fsh_slice_get (fsh, i);
+      fss_lock (fss);
+      count += fs_slice_num_free_fifos (fss);
+      fss_unlock (fss);
+    }
+
+  return count;
+}
+
+static u32
+fs_slice_num_free_chunks (fifo_segment_slice_t * fss, u32 size)
 {
   u32 count = 0, rounded_size, fl_index;
-  fifo_segment_header_t *fsh;
   svm_fifo_chunk_t *c;
   int i;
 
-  fsh = fs->h;
-
   /* Count all free chunks? */
   if (size == ~0)
     {
-      for (i = 0; i < vec_len (fsh->free_chunks); i++)
+      for (i = 0; i < FIFO_SEGMENT_N_FREELISTS; i++)
 	{
-	  c = fsh->free_chunks[i];
-	  if (c == 0)
-	    continue;
-
+	  c = fss->free_chunks[i];
 	  while (c)
 	    {
 	      c = c->next;
@@ -772,13 +868,10 @@ fifo_segment_num_free_chunks (fifo_segment_t * fs, u32 size)
   rounded_size = (1 << (max_log2 (size)));
   fl_index = fs_freelist_for_size (rounded_size);
 
-  if (fl_index >= vec_len (fsh->free_chunks))
-    return 0;
-
-  c = fsh->free_chunks[fl_index];
-  if (c == 0)
+  if (fl_index >= FIFO_SEGMENT_N_FREELISTS)
     return 0;
 
+  c = fss->free_chunks[fl_index];
   while (c)
     {
       c = c->next;
@@ -787,6 +880,25 @@ fifo_segment_num_free_chunks (fifo_segment_t * fs, u32 size)
   return count;
 }
 
+u32
+fifo_segment_num_free_chunks (fifo_segment_t * fs, u32 size)
+{
+  fifo_segment_header_t *fsh = fs->h;
+  fifo_segment_slice_t *fss;
+  u32 count = 0;
+  int i;
+
+  for (i = 0; i < fsh->n_slices; i++)
+    {
+      fss = fsh_slice_get (fsh, i);
+      fss_lock (fss);
+      count += fs_slice_num_free_chunks (fss, size);
+      fss_unlock (fss);
+    }
+
+  return count;
+}
+
 void
 fifo_segment_update_free_bytes (fifo_segment_t * fs)
 {
@@ -802,19 +914,50 @@ fifo_segment_free_bytes (fifo_segment_t * fs)
 u32
 fifo_segment_fl_chunk_bytes (fifo_segment_t * fs)
 {
-  return fs->h->n_fl_chunk_bytes;
+  fifo_segment_header_t *fsh = fs->h;
+  u32 n_bytes = 0;
+  int i;
+
+  for (i = 0; i < fsh->n_slices; i++)
+    n_bytes += fsh_slice_get (fsh, i)->n_fl_chunk_bytes;
+
+  return n_bytes;
 }
 
 u8
 fifo_segment_has_fifos (fifo_segment_t * fs)
 {
-  return fs->h->fifos != 0;
+  fifo_segment_header_t *fsh = fs->h;
+  int i;
+
+  for (i = 0; i < fsh->n_slices; i++)
+    if (fsh_slice_get (fsh, i)->fifos)
+      return 1;
+  return 0;
+}
+
+void
+fifo_segment_slice_lock (fifo_segment_t * fs, u32 slice_index)
+{
+  fss_lock (fsh_slice_get (fs->h, slice_index));
+}
+
+void
+fifo_segment_slice_unlock (fifo_segment_t * fs, u32 slice_index)
+{
+  fss_unlock (fsh_slice_get (fs->h, slice_index));
 }
 
 svm_fifo_t *
-fifo_segment_get_fifo_list (fifo_segment_t * fs)
+fifo_segment_get_slice_fifo_list (fifo_segment_t * fs, u32 slice_index)
+{
+  return fsh_slice_get (fs->h, slice_index)->fifos;
+}
+
+u32
+fifo_segment_num_slices (fifo_segment_t * fs)
 {
-  return fs->h->fifos;
+  return fs->h->n_slices;
 }
 
 u8 *
@@ -844,13 +987,12 @@ format_fifo_segment (u8 * s, va_list * args)
   fifo_segment_t *fs = va_arg (*args, fifo_segment_t *);
   int verbose __attribute__ ((unused)) = va_arg (*args, int);
   fifo_segment_header_t *fsh;
-  svm_fifo_chunk_t *c;
   u32 count, indent;
   u32 active_fifos;
   u32 free_fifos;
   char *address;
   size_t size;
-  int i;
+  int i, j;
 
   indent = format_get_indent (s) + 2;
 #if USE_DLMALLOC == 0
@@ -880,17 +1022,11 @@ format_fifo_segment (u8 * s, va_list * args)
     return s;
 
   s = format (s, "\n");
-  for (i = 0; i < vec_len (fsh->free_chunks); i++)
+  for (i = 0; i < FIFO_SEGMENT_N_FREELISTS; i++)
     {
-      c = fsh->free_chunks[i];
-      if (c == 0)
+      count = fifo_segment_num_free_chunks (fs, fs_freelist_index_to_size (i));
+      if (!count)
 	continue;
-      count = 0;
-      while (c)
-	{
-	  c = c->next;
-	  count++;
-	}
 
       s = format (s, "%U%-5u Kb: %u free", format_white_space, indent + 2,
 		  1 << (i + max_log2 (FIFO_SEGMENT_MIN_FIFO_SIZE) - 10),
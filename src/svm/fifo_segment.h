@@ -29,6 +29,7 @@ typedef enum
 #define FIFO_SEGMENT_MIN_FIFO_SIZE 4096	/* 4kB min fifo size */
 #define FIFO_SEGMENT_MAX_FIFO_SIZE (2 << 30)	/* 2GB max fifo size */
 #define FIFO_SEGMENT_ALLOC_BATCH_SIZE 32	/* Allocation quantum */
+#define FIFO_SEGMENT_N_FREELISTS 20	/* Chunk sizes from 4kB to 2GB */
 
 typedef enum fifo_segment_flags_
 {
@@ -36,21 +37,40 @@ typedef enum fifo_segment_flags_
   FIFO_SEGMENT_F_WILL_DELETE = 1 << 1,
 } fifo_segment_flags_t;
 
-typedef struct
+/**
+ * Per thread share of a fifo segment
+ *
+ * Slices are mostly used by the thread they were created for, so their
+ * locks are seldom contended. Fifos are however freed into the slice they
+ * were allocated from, which need not belong to the caller's thread, e.g.,
+ * after a udp session moves threads, and active fifo lists are walked from
+ * the main thread. So all accesses are serialized by the slice lock.
+ */
+typedef struct fifo_segment_slice_
 {
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline);
+  volatile u32 lock;			/**< Spinlock, in the shared header */
   svm_fifo_t *fifos;			/**< Linked list of active RX fifos */
-  svm_fifo_t *free_fifos;		/**< Freelists by fifo size  */
-  svm_fifo_chunk_t **free_chunks;	/**< Freelists by chunk size */
+  svm_fifo_t *free_fifos;		/**< Freelist of fifo headers */
+  svm_fifo_chunk_t *free_chunks[FIFO_SEGMENT_N_FREELISTS]; /**< Freelists
+								by chunk size */
+  u32 n_fl_chunk_bytes;			/**< Chunk bytes on freelist */
+} fifo_segment_slice_t;
+
+typedef struct
+{
+  fifo_segment_slice_t *slices;		/**< Fixed array of slices */
   u32 n_active_fifos;			/**< Number of active fifos */
   u8 flags;				/**< Segment flags */
+  u8 n_slices;				/**< Number of slices */
   u32 n_free_bytes;			/**< Bytes usable for new allocs */
-  u32 n_fl_chunk_bytes;			/**< Chunk bytes on freelist */
 } fifo_segment_header_t;
 
 typedef struct
 {
   ssvm_private_t ssvm;		/**< ssvm segment data */
   fifo_segment_header_t *h;	/**< fifo segment data */
+  u8 n_slices;			/**< number of segment slices */
 } fifo_segment_t;
 
 typedef struct
@@ -94,6 +114,20 @@ svm_fifo_t *fifo_segment_alloc_fifo (fifo_segment_t * fs,
 				     u32 data_bytes,
 				     fifo_segment_ftype_t ftype);
 
+/**
+ * Allocate fifo in fifo segment slice
+ *
+ * @param fs		fifo segment for fifo
+ * @param slice_index	index of the slice, typically the caller's thread
+ * @param data_bytes	size of default fifo chunk in bytes
+ * @param ftype		fifo type @ref fifo_segment_ftype_t
+ * @return		new fifo or 0 if alloc failed
+ */
+svm_fifo_t *fifo_segment_alloc_fifo_w_slice (fifo_segment_t * fs,
+					     u32 slice_index,
+					     u32 data_bytes,
+					     fifo_segment_ftype_t ftype);
+
 /**
  * Free fifo allocated in fifo segment
  *
@@ -108,10 +142,12 @@ void fifo_segment_free_fifo (fifo_segment_t * fs, svm_fifo_t * f);
  * Tries to preallocate fifo headers and adds them to freelist.
  *
  * @param fs		fifo segment
+ * @param slice_index	target slice for freelist
  * @param batch_size	number of chunks to be allocated
  * @return		0 on success, negative number otherwise
  */
-int fifo_segment_prealloc_fifo_hdrs (fifo_segment_t * fs, u32 batch_size);
+int fifo_segment_prealloc_fifo_hdrs (fifo_segment_t * fs, u32 slice_index,
+				     u32 batch_size);
 
 /**
  * Try to preallocate fifo chunks on segment
@@ -120,19 +156,21 @@ int fifo_segment_prealloc_fifo_hdrs (fifo_segment_t * fs, u32 batch_size);
  * to chunk freelist.
  *
  * @param fs		fifo segment
+ * @param slice_index	target slice for freelist
  * @param chunk_size	size of chunks to be allocated in bytes
  * @param batch_size	number of chunks to be allocated
  * @return		0 on success, negative number otherwise
  */
-int fifo_segment_prealloc_fifo_chunks (fifo_segment_t * fs, u32 chunk_size,
-				       u32 batch_size);
+int fifo_segment_prealloc_fifo_chunks (fifo_segment_t * fs, u32 slice_index,
+				       u32 chunk_size, u32 batch_size);
 /**
  * Pre-allocates fifo pairs in fifo segment
  *
  * The number of fifos pre-allocated is the minimum of the requested number
  * of pairs and the maximum number that fit within the segment. If the maximum
  * is hit, the number of fifo pairs requested is updated by subtracting the
- * number of fifos that have been successfully allocated.
+ * number of fifos that have been successfully allocated. Pairs are spread
+ * evenly across the segment's slices.
  *
  * @param fs		fifo segment for fifo
  * @param rx_fifo_size	data size of rx fifos
@@ -194,7 +232,20 @@ void fifo_segment_update_free_bytes (fifo_segment_t * fs);
  */
 u32 fifo_segment_fl_chunk_bytes (fifo_segment_t * fs);
 u8 fifo_segment_has_fifos (fifo_segment_t * fs);
-svm_fifo_t *fifo_segment_get_fifo_list (fifo_segment_t * fs);
+/**
+ * Lock fifo segment slice
+ *
+ * Must be held while walking the slice's active fifo list, see
+ * @ref fifo_segment_get_slice_fifo_list.
+ *
+ * @param fs		fifo segment
+ * @param slice_index	index of slice to be locked
+ */
+void fifo_segment_slice_lock (fifo_segment_t * fs, u32 slice_index);
+void fifo_segment_slice_unlock (fifo_segment_t * fs, u32 slice_index);
+svm_fifo_t *fifo_segment_get_slice_fifo_list (fifo_segment_t * fs,
+					      u32 slice_index);
+u32 fifo_segment_num_slices (fifo_segment_t * fs);
 u32 fifo_segment_num_fifos (fifo_segment_t * fs);
 u32 fifo_segment_num_free_fifos (fifo_segment_t * fs);
 /**
@@ -15,8 +15,12 @@
 
 #include <svm/message_queue.h>
 #include <vppinfra/mem.h>
+#include <vppinfra/time.h>
 #include <sys/eventfd.h>
 
+/* value of a lock-free queue slot that holds no message */
+#define SVM_MSG_Q_LF_SLOT_EMPTY ((u64) ~0)
+
 static inline svm_msg_q_ring_t *
 svm_msg_q_ring_inline (svm_msg_q_t * mq, u32 ring_index)
 {
@@ -36,43 +40,208 @@ svm_msg_q_ring_data (svm_msg_q_ring_t * ring, u32 elt_index)
   return (ring->data + elt_index * ring->elsize);
 }
 
+static inline u64 *
+svm_msg_q_lf_slots (svm_queue_t * q)
+{
+  return (u64 *) q->data;
+}
+
+static inline void
+svm_msg_q_lf_signal (int fd)
+{
+  int __clib_unused rv;
+  u64 data = 1;
+
+  if (fd != -1)
+    rv = write (fd, &data, sizeof (data));
+}
+
+/**
+ * Wake up the consumer if it sleeps on the condvar
+ *
+ * The caller has bumped the queue size with a full barrier before checking
+ * for waiters and the consumer registers before checking the size, so at
+ * least one of them sees the other. The consumer holds the mutex from
+ * the check until it sleeps, so taking it here cannot miss the sleeper.
+ */
+static inline void
+svm_msg_q_lf_wake (svm_msg_q_t * mq)
+{
+  if (PREDICT_TRUE (mq->n_waiters == 0))
+    return;
+  pthread_mutex_lock (&mq->q->mutex);
+  pthread_cond_broadcast (&mq->q->condvar);
+  pthread_mutex_unlock (&mq->q->mutex);
+}
+
+static int
+svm_msg_q_lf_wait_inline (svm_msg_q_t * mq, struct timespec *ts)
+{
+  svm_queue_t *q = mq->q;
+
+  pthread_mutex_lock (&q->mutex);
+  clib_atomic_fetch_add (&mq->n_waiters, 1);
+  while (q->cursize == 0)
+    {
+      if (!ts)
+	pthread_cond_wait (&q->condvar, &q->mutex);
+      else if (pthread_cond_timedwait (&q->condvar, &q->mutex, ts))
+	break;
+    }
+  clib_atomic_fetch_sub (&mq->n_waiters, 1);
+  pthread_mutex_unlock (&q->mutex);
+
+  return (q->cursize == 0 ? ETIMEDOUT : 0);
+}
+
+/**
+ * Lock-free ring element allocation
+ *
+ * Elements are reserved by bumping the ring size and then claimed by
+ * flipping their in-use flag. Because the single consumer may free them
+ * out of allocation order, the tail is only a hint of where to start
+ * looking for a free element.
+ */
+static inline int
+svm_msg_q_lf_ring_alloc (svm_msg_q_ring_t * ring, u32 * elt_index)
+{
+  u32 i;
+
+  if (clib_atomic_fetch_add (&ring->cursize, 1) >= ring->nitems)
+    {
+      clib_atomic_fetch_sub (&ring->cursize, 1);
+      return -1;
+    }
+
+  /* the reservation guarantees there is a free element */
+  i = ring->tail;
+  while (ring->busy[i]
+	 || !clib_atomic_bool_cmp_and_swap (&ring->busy[i], 0, 1))
+    i = i + 1 == ring->nitems ? 0 : i + 1;
+
+  ring->tail = i + 1 == ring->nitems ? 0 : i + 1;
+  *elt_index = i;
+  return 0;
+}
+
+static inline void
+svm_msg_q_lf_ring_free (svm_msg_q_ring_t * ring, u32 elt_index)
+{
+  ASSERT (ring->busy[elt_index]);
+  clib_atomic_store_rel_n (&ring->busy[elt_index], 0);
+  clib_atomic_fetch_sub (&ring->cursize, 1);
+}
+
+/**
+ * Lock-free enqueue
+ *
+ * Producers reserve room by bumping the queue size, take a slot from the
+ * tail and publish the message with a release store. The consumer frees
+ * slots before decrementing the size, so a reserved slot is always empty.
+ */
+static inline int
+svm_msg_q_lf_add (svm_msg_q_t * mq, svm_msg_q_msg_t * msg)
+{
+  svm_queue_t *q = mq->q;
+  u32 sz, pos;
+
+  sz = clib_atomic_fetch_add (&q->cursize, 1);
+  if (PREDICT_FALSE (sz >= q->maxsize))
+    {
+      clib_atomic_fetch_sub (&q->cursize, 1);
+      return -2;
+    }
+
+  pos = clib_atomic_fetch_add (&q->tail, 1);
+  clib_atomic_store_rel_n (&svm_msg_q_lf_slots (q)[pos & (q->maxsize - 1)],
+			   msg->as_u64);
+
+  /* only the empty to non-empty transition needs a wakeup */
+  if (sz == 0)
+    svm_msg_q_lf_signal (q->producer_evtfd);
+  svm_msg_q_lf_wake (mq);
+
+  return 0;
+}
+
+/**
+ * Lock-free dequeue, single consumer only
+ *
+ * Fails if the queue is empty or if the producer that reserved the head
+ * slot has not published its message yet.
+ */
+static inline int
+svm_msg_q_lf_sub (svm_msg_q_t * mq, svm_msg_q_msg_t * msg)
+{
+  svm_queue_t *q = mq->q;
+  u64 *slot;
+  u32 sz;
+
+  slot = &svm_msg_q_lf_slots (q)[(u32) q->head & (q->maxsize - 1)];
+  msg->as_u64 = clib_atomic_load_acq_n (slot);
+  if (msg->as_u64 == SVM_MSG_Q_LF_SLOT_EMPTY)
+    return -2;
+
+  clib_atomic_store_rel_n (slot, SVM_MSG_Q_LF_SLOT_EMPTY);
+  q->head = (u32) q->head + 1;
+  sz = clib_atomic_fetch_sub (&q->cursize, 1);
+
+  if (sz == q->maxsize)
+    svm_msg_q_lf_signal (q->consumer_evtfd);
+
+  return 0;
+}
+
 svm_msg_q_t *
 svm_msg_q_alloc (svm_msg_q_cfg_t * cfg)
 {
   svm_msg_q_ring_cfg_t *ring_cfg;
-  uword rings_sz = 0, mq_sz;
+  uword rings_sz = 0, busy_sz = 0, mq_sz;
+  u32 vec_sz, q_sz, q_nitems;
+  u8 *base, *rings_ptr, *busy_ptr;
   svm_msg_q_ring_t *ring;
-  u8 *base, *rings_ptr;
   vec_header_t *vh;
-  u32 vec_sz, q_sz;
   svm_msg_q_t *mq;
-  int i;
+  int i, is_lf;
 
   ASSERT (cfg);
 
+  is_lf = (cfg->flags & SVM_MSG_Q_F_LOCK_FREE) != 0;
+  q_nitems = is_lf ? 1 << max_log2 (cfg->q_nitems) : cfg->q_nitems;
+
   vec_sz = vec_header_bytes (0) + sizeof (svm_msg_q_ring_t) * cfg->n_rings;
   for (i = 0; i < cfg->n_rings; i++)
     {
-      if (cfg->ring_cfgs[i].data)
-	continue;
       ring_cfg = &cfg->ring_cfgs[i];
+      if (is_lf)
+	busy_sz += ring_cfg->nitems;
+      if (ring_cfg->data)
+	continue;
       rings_sz += (uword) ring_cfg->nitems * ring_cfg->elsize;
     }
 
-  q_sz = sizeof (svm_queue_t) + cfg->q_nitems * sizeof (svm_msg_q_msg_t);
-  mq_sz = sizeof (svm_msg_q_t) + vec_sz + rings_sz + q_sz;
+  q_sz = sizeof (svm_queue_t) + q_nitems * sizeof (svm_msg_q_msg_t);
+  mq_sz = sizeof (svm_msg_q_t) + vec_sz + rings_sz + q_sz + busy_sz;
   base = clib_mem_alloc_aligned (mq_sz, CLIB_CACHE_LINE_BYTES);
   if (!base)
     return 0;
 
   mq = (svm_msg_q_t *) base;
-  mq->q = svm_queue_init (base + sizeof (svm_msg_q_t), cfg->q_nitems,
+  mq->q = svm_queue_init (base + sizeof (svm_msg_q_t), q_nitems,
 			  sizeof (svm_msg_q_msg_t));
   mq->q->consumer_pid = cfg->consumer_pid;
+  mq->flags = cfg->flags;
+  mq->n_waiters = 0;
+  if (is_lf)
+    {
+      for (i = 0; i < q_nitems; i++)
+	svm_msg_q_lf_slots (mq->q)[i] = SVM_MSG_Q_LF_SLOT_EMPTY;
+    }
   vh = (vec_header_t *) ((u8 *) mq->q + q_sz);
   vh->len = cfg->n_rings;
   mq->rings = (svm_msg_q_ring_t *) (vh + 1);
   rings_ptr = (u8 *) mq->rings + sizeof (svm_msg_q_ring_t) * cfg->n_rings;
+  busy_ptr = rings_ptr + rings_sz;
   for (i = 0; i < cfg->n_rings; i++)
     {
       ring = &mq->rings[i];
@@ -86,6 +255,13 @@ svm_msg_q_alloc (svm_msg_q_cfg_t * cfg)
 	  ring->data = rings_ptr;
 	  rings_ptr += (uword) ring->nitems * ring->elsize;
 	}
+      ring->busy = 0;
+      if (is_lf)
+	{
+	  ring->busy = busy_ptr;
+	  clib_memset (ring->busy, 0, ring->nitems);
+	  busy_ptr += ring->nitems;
+	}
     }
 
   return mq;
@@ -104,6 +280,15 @@ svm_msg_q_alloc_msg_w_ring (svm_msg_q_t * mq, u32 ring_index)
   svm_msg_q_msg_t msg;
   svm_msg_q_ring_t *ring = svm_msg_q_ring_inline (mq, ring_index);
 
+  if (svm_msg_q_is_lock_free (mq))
+    {
+      /* caller saw room, but other producers may have raced us to it */
+      msg.ring_index = ring_index;
+      while (svm_msg_q_lf_ring_alloc (ring, &msg.elt_index))
+	CLIB_PAUSE ();
+      return msg;
+    }
+
   ASSERT (ring->cursize < ring->nitems);
   msg.ring_index = ring - mq->rings;
   msg.elt_index = ring->tail;
@@ -116,6 +301,20 @@ int
 svm_msg_q_lock_and_alloc_msg_w_ring (svm_msg_q_t * mq, u32 ring_index,
 				     u8 noblock, svm_msg_q_msg_t * msg)
 {
+  if (svm_msg_q_is_lock_free (mq))
+    {
+      svm_msg_q_ring_t *ring = svm_msg_q_ring_inline (mq, ring_index);
+
+      msg->ring_index = ring_index;
+      while (svm_msg_q_lf_ring_alloc (ring, &msg->elt_index))
+	{
+	  if (noblock)
+	    return -2;
+	  CLIB_PAUSE ();
+	}
+      return 0;
+    }
+
   if (noblock)
     {
       if (svm_msg_q_try_lock (mq))
@@ -148,6 +347,20 @@ svm_msg_q_alloc_msg (svm_msg_q_t * mq, u32 nbytes)
   svm_msg_q_msg_t msg = {.as_u64 = ~0 };
   svm_msg_q_ring_t *ring;
 
+  if (svm_msg_q_is_lock_free (mq))
+    {
+      vec_foreach (ring, mq->rings)
+      {
+	if (ring->elsize < nbytes)
+	  continue;
+	if (svm_msg_q_lf_ring_alloc (ring, &msg.elt_index))
+	  continue;
+	msg.ring_index = ring - mq->rings;
+	break;
+      }
+      return msg;
+    }
+
   vec_foreach (ring, mq->rings)
   {
     if (ring->elsize < nbytes || ring->cursize == ring->nitems)
@@ -175,6 +388,11 @@ svm_msg_q_free_msg (svm_msg_q_t * mq, svm_msg_q_msg_t * msg)
 
   ASSERT (vec_len (mq->rings) > msg->ring_index);
   ring = &mq->rings[msg->ring_index];
+  if (svm_msg_q_is_lock_free (mq))
+    {
+      svm_msg_q_lf_ring_free (ring, msg->elt_index);
+      return;
+    }
   if (msg->elt_index == ring->head)
     {
       ring->head = (ring->head + 1) % ring->nitems;
@@ -197,6 +415,8 @@ svm_msq_q_msg_is_valid (svm_msg_q_t * mq, svm_msg_q_msg_t * msg)
   if (vec_len (mq->rings) <= msg->ring_index)
     return 0;
   ring = &mq->rings[msg->ring_index];
+  if (svm_msg_q_is_lock_free (mq))
+    return (msg->elt_index < ring->nitems && ring->busy[msg->elt_index]);
   tail = ring->tail;
   head = ring->head;
 
@@ -212,6 +432,16 @@ int
 svm_msg_q_add (svm_msg_q_t * mq, svm_msg_q_msg_t * msg, int nowait)
 {
   ASSERT (svm_msq_q_msg_is_valid (mq, msg));
+  if (svm_msg_q_is_lock_free (mq))
+    {
+      while (svm_msg_q_lf_add (mq, msg))
+	{
+	  if (nowait)
+	    return -2;
+	  CLIB_PAUSE ();
+	}
+      return 0;
+    }
   return svm_queue_add (mq->q, (u8 *) msg, nowait);
 }
 
@@ -219,6 +449,12 @@ void
 svm_msg_q_add_and_unlock (svm_msg_q_t * mq, svm_msg_q_msg_t * msg)
 {
   ASSERT (svm_msq_q_msg_is_valid (mq, msg));
+  if (svm_msg_q_is_lock_free (mq))
+    {
+      while (svm_msg_q_lf_add (mq, msg))
+	CLIB_PAUSE ();
+      return;
+    }
   svm_queue_add_raw (mq->q, (u8 *) msg);
   svm_msg_q_unlock (mq);
 }
@@ -227,15 +463,69 @@ int
 svm_msg_q_sub (svm_msg_q_t * mq, svm_msg_q_msg_t * msg,
 	       svm_q_conditional_wait_t cond, u32 time)
 {
+  if (svm_msg_q_is_lock_free (mq))
+    {
+      f64 max_time = 0;
+
+      if (cond == SVM_Q_NOWAIT)
+	return svm_msg_q_lf_sub (mq, msg);
+
+      if (cond == SVM_Q_TIMEDWAIT)
+	max_time = unix_time_now () + time;
+
+      while (svm_msg_q_lf_sub (mq, msg))
+	{
+	  /* a producer reserved the head slot but has not published yet */
+	  if (!svm_msg_q_is_empty (mq))
+	    {
+	      CLIB_PAUSE ();
+	      continue;
+	    }
+	  if (cond == SVM_Q_WAIT)
+	    svm_msg_q_lock_free_wait (mq);
+	  else if (svm_msg_q_lock_free_timedwait (mq,
+						  max_time - unix_time_now ()))
+	    return ETIMEDOUT;
+	}
+      return 0;
+    }
   return svm_queue_sub (mq->q, (u8 *) msg, cond, time);
 }
 
 void
 svm_msg_q_sub_w_lock (svm_msg_q_t * mq, svm_msg_q_msg_t * msg)
 {
+  if (svm_msg_q_is_lock_free (mq))
+    {
+      /* caller saw a non-empty queue, the message may still be in flight */
+      while (svm_msg_q_lf_sub (mq, msg))
+	CLIB_PAUSE ();
+      return;
+    }
   svm_queue_sub_raw (mq->q, (u8 *) msg);
 }
 
+void
+svm_msg_q_lock_free_wait (svm_msg_q_t * mq)
+{
+  svm_msg_q_lf_wait_inline (mq, 0);
+}
+
+int
+svm_msg_q_lock_free_timedwait (svm_msg_q_t * mq, double timeout)
+{
+  struct timespec ts;
+  f64 max_time;
+
+  if (timeout <= 0)
+    return (svm_msg_q_is_empty (mq) ? ETIMEDOUT : 0);
+
+  max_time = unix_time_now () + timeout;
+  ts.tv_sec = (time_t) max_time;
+  ts.tv_nsec = (max_time - ts.tv_sec) * 1e9;
+  return svm_msg_q_lf_wait_inline (mq, &ts);
+}
+
 void
 svm_msg_q_set_consumer_eventfd (svm_msg_q_t * mq, int fd)
 {
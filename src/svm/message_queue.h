@@ -22,6 +22,7 @@
 
 #include <vppinfra/clib.h>
 #include <vppinfra/error.h>
+#include <vppinfra/lock.h>
 #include <svm/queue.h>
 
 typedef struct svm_msg_q_ring_
@@ -32,12 +33,22 @@ typedef struct svm_msg_q_ring_
   volatile u32 tail;			/**< current tail (for enqueue) */
   u32 elsize;				/**< size of an element */
   u8 *data;				/**< chunk of memory for msg data */
+  u8 *busy;				/**< per element in-use flags, only
+					     used by lock-free queues */
 } __clib_packed svm_msg_q_ring_t;
 
+typedef enum svm_msg_q_flags_
+{
+  SVM_MSG_Q_F_LOCK_FREE = 1 << 0,	/**< no mutex, atomic head/tail */
+} svm_msg_q_flags_t;
+
 typedef struct svm_msg_q_
 {
   svm_queue_t *q;			/**< queue for exchanging messages */
   svm_msg_q_ring_t *rings;		/**< rings with message data*/
+  u32 flags;				/**< svm_msg_q_flags_t */
+  volatile u32 n_waiters;		/**< consumers sleeping on the condvar,
+					     only used by lock-free queues */
 } __clib_packed svm_msg_q_t;
 
 typedef struct svm_msg_q_ring_cfg_
@@ -53,6 +64,7 @@ typedef struct svm_msg_q_cfg_
   u32 q_nitems;				/**< msg queue size (not rings) */
   u32 n_rings;				/**< number of msg rings */
   svm_msg_q_ring_cfg_t *ring_cfgs;	/**< array of ring cfgs */
+  u32 flags;				/**< svm_msg_q_flags_t */
 } svm_msg_q_cfg_t;
 
 typedef union
@@ -73,6 +85,15 @@ typedef union
  * apart from the message queue this also allocates (one or multiple)
  * shared-memory rings for the messages.
  *
+ * If SVM_MSG_Q_F_LOCK_FREE is set, the queue never takes its mutex.
+ * Producers reserve queue and ring slots with atomic operations, so any
+ * number of them may run concurrently, but there must be a single
+ * consumer. The queue length is rounded up to a power of 2 and the
+ * locking functions become no-ops. With eventfds, producers only signal
+ * the consumer when the queue goes from empty to non-empty. Blocking
+ * consumers sleep on the queue condvar and producers only take the mutex
+ * to wake them when one is waiting.
+ *
  * @param cfg 		configuration options: queue len, consumer pid,
  * 			ring configs
  * @return		message queue
@@ -242,25 +263,53 @@ void svm_msg_q_set_producer_eventfd (svm_msg_q_t * mq, int fd);
  */
 int svm_msg_q_alloc_consumer_eventfd (svm_msg_q_t * mq);
 
+/**
+ * Wait for lock-free message queue to be non-empty
+ *
+ * @param mq 		message queue
+ */
+void svm_msg_q_lock_free_wait (svm_msg_q_t * mq);
+
+/**
+ * Timed wait for lock-free message queue to be non-empty
+ *
+ * @param mq 		message queue
+ * @param timeout	time in seconds
+ * @return		0 if the queue is non-empty, ETIMEDOUT otherwise
+ */
+int svm_msg_q_lock_free_timedwait (svm_msg_q_t * mq, double timeout);
+
 /**
  * Allocate event fd for queue consumer
  */
 int svm_msg_q_alloc_producer_eventfd (svm_msg_q_t * mq);
 
+/**
+ * Check if message queue is lock-free
+ */
+static inline u8
+svm_msg_q_is_lock_free (svm_msg_q_t * mq)
+{
+  return ((mq->flags & SVM_MSG_Q_F_LOCK_FREE) != 0);
+}
+
 /**
  * Check if message queue is full
+ *
+ * Lock-free producers reserve before checking capacity, so sizes may
+ * briefly exceed the maximum.
  */
 static inline u8
 svm_msg_q_is_full (svm_msg_q_t * mq)
 {
-  return (mq->q->cursize == mq->q->maxsize);
+  return (mq->q->cursize >= mq->q->maxsize);
 }
 
 static inline u8
 svm_msg_q_ring_is_full (svm_msg_q_t * mq, u32 ring_index)
 {
   ASSERT (ring_index < vec_len (mq->rings));
-  return (mq->rings[ring_index].cursize == mq->rings[ring_index].nitems);
+  return (mq->rings[ring_index].cursize >= mq->rings[ring_index].nitems);
 }
 
 /**
@@ -296,6 +345,8 @@ svm_msg_q_msg_is_invalid (svm_msg_q_msg_t * msg)
 static inline int
 svm_msg_q_try_lock (svm_msg_q_t * mq)
 {
+  if (svm_msg_q_is_lock_free (mq))
+    return 0;
   return pthread_mutex_trylock (&mq->q->mutex);
 }
 
@@ -305,6 +356,8 @@ svm_msg_q_try_lock (svm_msg_q_t * mq)
 static inline int
 svm_msg_q_lock (svm_msg_q_t * mq)
 {
+  if (svm_msg_q_is_lock_free (mq))
+    return 0;
   return pthread_mutex_lock (&mq->q->mutex);
 }
 
@@ -314,6 +367,8 @@ svm_msg_q_lock (svm_msg_q_t * mq)
 static inline void
 svm_msg_q_unlock (svm_msg_q_t * mq)
 {
+  if (svm_msg_q_is_lock_free (mq))
+    return;
   pthread_mutex_unlock (&mq->q->mutex);
 }
 
@@ -321,11 +376,18 @@ svm_msg_q_unlock (svm_msg_q_t * mq)
  * Wait for message queue event
  *
  * Must be called with mutex held. The queue only works non-blocking
- * with eventfds, so handle blocking calls as an exception here.
+ * with eventfds, so handle blocking calls as an exception here. Lock-free
+ * queues are only waited on by their consumer, which sleeps until the
+ * queue is non-empty.
  */
 static inline void
 svm_msg_q_wait (svm_msg_q_t * mq)
 {
+  if (svm_msg_q_is_lock_free (mq))
+    {
+      svm_msg_q_lock_free_wait (mq);
+      return;
+    }
   svm_queue_wait (mq->q);
 }
 
@@ -340,6 +402,8 @@ svm_msg_q_wait (svm_msg_q_t * mq)
 static inline int
 svm_msg_q_timedwait (svm_msg_q_t * mq, double timeout)
 {
+  if (svm_msg_q_is_lock_free (mq))
+    return svm_msg_q_lock_free_timedwait (mq, timeout);
   return svm_queue_timedwait (mq->q, timeout);
 }
 
@@ -839,6 +839,56 @@ svm_fifo_enqueue (svm_fifo_t * f, u32 len, const u8 * src)
   return len;
 }
 
+int
+svm_fifo_enqueue_segments (svm_fifo_t * f, const svm_fifo_seg_t segs[],
+			   u32 n_segs, u8 allow_partial)
+{
+  u32 tail, head, free_count, len = 0, to_copy, i;
+
+  f_load_head_tail_prod (f, &head, &tail);
+
+  /* free space in fifo can only increase during enqueue: SPSC */
+  free_count = f_free_count (f, head, tail);
+
+  f->ooos_newest = OOO_SEGMENT_INVALID_INDEX;
+
+  if (PREDICT_FALSE (free_count == 0))
+    return SVM_FIFO_EFULL;
+
+  if (!allow_partial)
+    {
+      for (i = 0; i < n_segs; i++)
+	len += segs[i].len;
+      if (len > free_count)
+	return SVM_FIFO_EFULL;
+      len = 0;
+    }
+
+  for (i = 0; i < n_segs && len < free_count; i++)
+    {
+      to_copy = clib_min (segs[i].len, free_count - len);
+      svm_fifo_copy_to_chunk (f, f->tail_chunk, tail, segs[i].data, to_copy,
+			      &f->tail_chunk);
+      tail = (tail + to_copy) % f->size;
+      len += to_copy;
+    }
+
+  svm_fifo_trace_add (f, head, len, 2);
+
+  /* collect out-of-order segments */
+  if (PREDICT_FALSE (f->ooos_list_head != OOO_SEGMENT_INVALID_INDEX))
+    {
+      len += ooo_segment_try_collect (f, len, &tail);
+      if (!svm_fifo_chunk_includes_pos (f->tail_chunk, tail))
+	f->tail_chunk = svm_fifo_find_chunk (f, tail);
+    }
+
+  /* store-rel: producer owned index (paired with load-acq in consumer) */
+  clib_atomic_store_rel_n (&f->tail, tail);
+
+  return len;
+}
+
 /**
  * Enqueue a future segment.
  *
@@ -896,6 +946,40 @@ svm_fifo_enqueue_nocopy (svm_fifo_t * f, u32 len)
   clib_atomic_store_rel_n (&f->tail, tail);
 }
 
+int
+svm_fifo_tail_segments (svm_fifo_t * f, svm_fifo_seg_t * fs, u32 n_segs,
+			u32 max_len)
+{
+  u32 head, tail, free_count, len, i = 0;
+  svm_fifo_chunk_t *c;
+
+  ASSERT (f->ooos_list_head == OOO_SEGMENT_INVALID_INDEX);
+
+  f_load_head_tail_prod (f, &head, &tail);
+
+  /* free space in fifo can only increase while we're working: SPSC */
+  free_count = f_free_count (f, head, tail);
+
+  if (PREDICT_FALSE (free_count == 0))
+    return SVM_FIFO_EFULL;
+
+  max_len = clib_min (free_count, max_len);
+  c = f->tail_chunk;
+
+  while (max_len && i < n_segs)
+    {
+      len = clib_min (c->start_byte + c->length - tail, max_len);
+      fs[i].data = c->data + (tail - c->start_byte);
+      fs[i].len = len;
+      max_len -= len;
+      i += 1;
+      c = c->next;
+      tail = c->start_byte;
+    }
+
+  return i;
+}
+
 int
 svm_fifo_dequeue (svm_fifo_t * f, u32 len, u8 * dst)
 {
@@ -78,6 +78,7 @@ typedef struct _svm_fifo
   u32 size;			/**< size of the fifo in bytes */
   u32 nitems;			/**< usable size (size-1) */
   u8 flags;			/**< fifo flags */
+  u8 slice_index;		/**< segment slice for fifo */
   svm_fifo_chunk_t *start_chunk;/**< first chunk in fifo chunk list */
   svm_fifo_chunk_t *end_chunk;	/**< end chunk in fifo chunk list */
   svm_fifo_chunk_t *new_chunks;	/**< chunks yet to be added to list */
@@ -360,6 +361,21 @@ void svm_fifo_clone (svm_fifo_t * df, svm_fifo_t * sf);
  * @return	number of contiguous bytes that can be consumed or error
  */
 int svm_fifo_enqueue (svm_fifo_t * f, u32 len, const u8 * src);
+/**
+ * Enqueue array of segments to fifo
+ *
+ * Segments are copied back to back and the tail is updated only once, so
+ * the consumer sees either none or all of the data enqueued.
+ *
+ * @param f		fifo
+ * @param segs		array of segments to copy
+ * @param n_segs	number of segments in the array
+ * @param allow_partial	if set, enqueue as much as fits, otherwise all or
+ * 			nothing
+ * @return		number of bytes enqueued or error
+ */
+int svm_fifo_enqueue_segments (svm_fifo_t * f, const svm_fifo_seg_t segs[],
+			       u32 n_segs, u8 allow_partial);
 /**
  * Enqueue data to fifo with offset
  *
@@ -385,6 +401,21 @@ int svm_fifo_enqueue_with_offset (svm_fifo_t * f, u32 offset, u32 len,
  * @param len		number of bytes to add to tail
  */
 void svm_fifo_enqueue_nocopy (svm_fifo_t * f, u32 len);
+/**
+ * Get segments of free space that follow the tail
+ *
+ * Allows producers to write data directly into the fifo. Once done, data
+ * must be committed with @ref svm_fifo_enqueue_nocopy. Should not be used
+ * on fifos that may have out-of-order data.
+ *
+ * @param f		fifo
+ * @param fs		array of segments to be filled
+ * @param n_segs	number of segments in the array
+ * @param max_len	max number of bytes the segments should cover
+ * @return		number of segments filled or error
+ */
+int svm_fifo_tail_segments (svm_fifo_t * f, svm_fifo_seg_t * fs, u32 n_segs,
+			    u32 max_len);
 /**
  * Overwrite fifo head with new data
  *
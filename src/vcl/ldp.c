@@ -12,6 +12,7 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#define _GNU_SOURCE
 #include <unistd.h>
 #include <stdio.h>
 #include <signal.h>
@@ -24,8 +25,8 @@
 
 #include <vcl/ldp_socket_wrapper.h>
 #include <vcl/ldp.h>
-#include <vcl/vppcom.h>
-#include <vcl/vcl_private.h>
+#include <vcl/vcl_locked.h>
+#include <vnet/ip/ip6_packet.h>
 #include <sys/time.h>
 
 #include <vppinfra/time.h>
@@ -50,11 +51,18 @@
 #define DESTRUCTOR_ATTRIBUTE
 #endif
 
-#define LDP_MAX_NWORKERS 32
+/*
+ * With _GNU_SOURCE, socket address arguments are transparent unions. Use this
+ * to get the sockaddr from __SOCKADDR_ARG and __CONST_SOCKADDR_ARG
+ */
+#ifdef __USE_GNU
+#define SOCKADDR_GET_SA(__addr) __addr.__sockaddr__
+#else
+#define SOCKADDR_GET_SA(__addr) __addr
+#endif
 
 typedef struct ldp_worker_ctx_
 {
-  u8 *io_buffer;
   clib_time_t clib_time;
 
   /*
@@ -83,6 +91,13 @@ typedef struct ldp_worker_ctx_
   u8 epoll_wait_vcl;
   int vcl_mq_epfd;
 
+  /*
+   * Batched io state
+   */
+  vppcom_msg_t *vcl_msgs;
+  vppcom_endpt_t *vcl_eps;
+  ip46_address_t *vcl_ep_ips;
+
 } ldp_worker_ctx_t;
 
 /* clib_bitmap_t, fd_mask and vcl_si_set are used interchangeably. Make sure
@@ -124,6 +139,9 @@ static ldp_main_t *ldp = &ldp_main;
 static inline ldp_worker_ctx_t *
 ldp_worker_get_current (void)
 {
+  /* Threads get their vcl worker on first use */
+  if (PREDICT_FALSE (vppcom_worker_index () == -1))
+    vls_register_vcl_worker ();
   return (ldp->workers + vppcom_worker_index ());
 }
 
@@ -150,16 +168,16 @@ ldp_get_app_name ()
 }
 
 static inline int
-ldp_vclsh_to_fd (vcl_session_handle_t vclsh)
+ldp_vlsh_to_fd (vls_handle_t vlsh)
 {
-  return (vclsh + ldp->vcl_bit_val);
+  return (vlsh + ldp->vcl_bit_val);
 }
 
-static inline vcl_session_handle_t
-ldp_fd_to_vclsh (int fd)
+static inline vls_handle_t
+ldp_fd_to_vlsh (int fd)
 {
   if (fd < (ldp->vcl_bit_val))
-    return INVALID_SESSION_ID;
+    return VLS_INVALID_HANDLE;
 
   return (fd - ldp->vcl_bit_val);
 }
@@ -169,189 +187,7 @@ ldp_alloc_workers (void)
 {
   if (ldp->workers)
     return;
-  pool_alloc (ldp->workers, LDP_MAX_NWORKERS);
-}
-
-static void
-ldp_share_listen_session (vcl_worker_t * parent_wrk,
-			  vcl_worker_t * child_wrk,
-			  vcl_session_t * listen_session)
-{
-/*Find the listen session of parent worker*/
-  if (listen_session->session_index == parent_wrk->listen_session_index)
-    {
-      listen_session->session_state = STATE_LISTEN_NO_MQ;
-      vppcom_session_listen (vcl_session_handle_from_index
-			     (parent_wrk->listen_session_index),
-			     parent_wrk->listen_queue_size);
-    }
-}
-
-void
-ldp_vcl_worker_copy_on_fork (vcl_worker_t * parent_wrk)
-{
-  vcl_worker_t *wrk = vcl_worker_get_current ();
-  vcl_session_t *listen_session;
-  wrk->vpp_event_queues = vec_dup (parent_wrk->vpp_event_queues);
-  wrk->sessions = pool_dup (parent_wrk->sessions);
-  wrk->session_index_by_vpp_handles =
-    hash_dup (parent_wrk->session_index_by_vpp_handles);
-/*Update listen session for child*/
-  pool_foreach (listen_session, wrk->sessions, (
-						 {
-						 ldp_share_listen_session
-						 (parent_wrk, wrk,
-						  listen_session);}));
-}
-
-static void
-ldp_cleanup_vcl_worker (vcl_worker_t * wrk)
-{
-  vcl_worker_cleanup (wrk, 1 /* notify vpp */ );
-}
-
-static void
-ldp_cleanup_forked_child (vcl_worker_t * wrk, vcl_worker_t * child_wrk)
-{
-  vcl_worker_t *sub_child;
-  int tries = 0;
-
-  if (child_wrk->forked_child != ~0)
-    {
-      sub_child = vcl_worker_get_if_valid (child_wrk->forked_child);
-      if (sub_child)
-	{
-	  /* Wait a bit, maybe the process is going away */
-	  while (kill (sub_child->current_pid, 0) >= 0 && tries++ < 50)
-	    usleep (1e3);
-	  if (kill (sub_child->current_pid, 0) < 0)
-	    ldp_cleanup_forked_child (child_wrk, sub_child);
-	}
-    }
-  ldp_cleanup_vcl_worker (child_wrk);
-  VDBG (0, "Cleaned up forked child wrk %u", child_wrk->wrk_index);
-  wrk->forked_child = ~0;
-}
-
-static struct sigaction old_sa;
-
-static void
-ldp_intercept_sigchld_handler (int signum, siginfo_t * si, void *uc)
-{
-  vcl_worker_t *wrk, *child_wrk;
-
-  if (vcl_get_worker_index () == ~0)
-    return;
-
-  /*restore sigchld */
-  if (sigaction (SIGCHLD, &old_sa, 0))
-    {
-      VERR ("couldn't restore sigchld");
-      exit (-1);
-    }
-
-  wrk = vcl_worker_get_current ();
-  if (wrk->forked_child == ~0)
-    return;
-
-  child_wrk = vcl_worker_get_if_valid (wrk->forked_child);
-  if (!child_wrk)
-    goto done;
-
-  if (si && si->si_pid != child_wrk->current_pid)
-    {
-      VDBG (0, "unexpected child pid %u", si->si_pid);
-      goto done;
-    }
-  ldp_cleanup_forked_child (wrk, child_wrk);
-
-done:
-  if (old_sa.sa_flags & SA_SIGINFO)
-    {
-      void (*fn) (int, siginfo_t *, void *) = old_sa.sa_sigaction;
-      fn (signum, si, uc);
-    }
-  else
-    {
-      void (*fn) (int) = old_sa.sa_handler;
-      if (fn)
-	fn (signum);
-    }
-}
-
-/*Intercept signal SIGCHLD*/
-static void
-ldp_intercept_sigchld ()
-{
-  struct sigaction sa;
-  clib_memset (&sa, 0, sizeof (sa));
-  /*set SA_SIGINFO to validate sa.sa_sigaction rather than sa.sa_handler */
-  sa.sa_sigaction = ldp_intercept_sigchld_handler;
-  sa.sa_flags = SA_SIGINFO;
-  /*When current process receive the SIGCHLD signal, it would call
-   **ldp_intercept_sigchld_handler.
-   */
-  if (sigaction (SIGCHLD, &sa, &old_sa))
-    {
-      VERR ("couldn't intercept sigchld");
-      exit (-1);
-    }
-}
-
-static void
-ldp_app_pre_fork (void)
-{
-  ldp_intercept_sigchld ();
-  vcl_flush_mq_events ();
-}
-
-static void
-ldp_app_fork_parent_handler (void)
-{
-  vcm->forking = 1;
-  while (vcm->forking)
-    ;
-}
-
-static void
-ldp_app_fork_child_handler (void)
-{
-  vcl_worker_t *parent_wrk;
-  int rv, parent_wrk_index;
-  u8 *child_name;
-
-  parent_wrk_index = vcl_get_worker_index ();
-  VDBG (0,
-	"initializing forked child (pid) %u with parent wrk (vcl worker index) %u",
-	getpid (), parent_wrk_index);
-
-/*Allocate vcl worker for child*/
-  vcl_set_worker_index (~0);
-  if (!vcl_worker_alloc_and_init ())
-    VERR ("couldn't allocate new worker for child process %u", getpid ());
-
-/*Attach to binary api*/
-  child_name = format (0, "%v-child-%u%c", vcm->app_name, getpid (), 0);
-  vcl_cleanup_bapi ();
-  vppcom_api_hookup ();
-  vcm->app_state = STATE_APP_START;
-  rv = vppcom_connect_to_vpp ((char *) child_name);
-  vec_free (child_name);
-  if (rv)
-    {
-      VERR ("couldn't connect to VPP!");
-      return;
-    }
-
-/*
-**Register new allocated vcl worker with VPP
-*/
-  vcl_worker_register_with_vpp ();
-  parent_wrk = vcl_worker_get (parent_wrk_index);
-  ldp_vcl_worker_copy_on_fork (parent_wrk);
-  parent_wrk->forked_child = vcl_get_worker_index ();
-  VDBG (0, "forked child main worker initialized");
-  vcm->forking = 0;
+  vec_validate (ldp->workers, vppcom_max_workers () - 1);
 }
 
 static inline int
@@ -365,15 +201,13 @@ ldp_init (void)
 
   ldp->init = 1;
   ldp->vcl_needs_real_epoll = 1;
-  rv = vppcom_app_create (ldp_get_app_name ());
-  pthread_atfork (ldp_app_pre_fork, ldp_app_fork_parent_handler,
-		  ldp_app_fork_child_handler);
+  rv = vls_app_create (ldp_get_app_name ());
   if (rv != VPPCOM_OK)
     {
       ldp->vcl_needs_real_epoll = 0;
       if (rv == VPPCOM_EEXIST)
 	return 0;
-      LDBG (2, "\nERROR: ldp_init: vppcom_app_create()"
+      LDBG (2, "\nERROR: ldp_init: vls_app_create()"
 	    " failed!  rv = %d (%s)\n", rv, vppcom_retval_str (rv));
       ldp->init = 0;
       return rv;
@@ -449,7 +283,7 @@ ldp_init (void)
       /* Make sure there are enough bits in the fd set for vcl sessions */
       if (ldp->vcl_bit_val > FD_SETSIZE / 2)
 	{
-	  LDBG (0, "ERROR: LDP vclsh bit value %d > FD_SETSIZE/2 %d!",
+	  LDBG (0, "ERROR: LDP vlsh bit value %d > FD_SETSIZE/2 %d!",
 		ldp->vcl_bit_val, FD_SETSIZE / 2);
 	  ldp->init = 0;
 	  return -1;
@@ -461,11 +295,8 @@ ldp_init (void)
       ldp->transparent_tls = 1;
     }
 
-  /* *INDENT-OFF* */
-  pool_foreach (ldpw, ldp->workers, ({
+  vec_foreach (ldpw, ldp->workers)
     clib_memset (&ldpw->clib_time, 0, sizeof (ldpw->clib_time));
-  }));
-  /* *INDENT-ON* */
 
   LDBG (0, "LDP initialization: done!");
 
@@ -475,16 +306,16 @@ ldp_init (void)
 int
 close (int fd)
 {
-  vcl_session_handle_t vclsh;
+  vls_handle_t vlsh;
   int rv, epfd;
 
   if ((errno = -ldp_init ()))
     return -1;
 
-  vclsh = ldp_fd_to_vclsh (fd);
-  if (vclsh != INVALID_SESSION_ID)
+  vlsh = ldp_fd_to_vlsh (fd);
+  if (vlsh != VLS_INVALID_HANDLE)
     {
-      epfd = vppcom_session_attr (vclsh, VPPCOM_ATTR_GET_LIBC_EPFD, 0, 0);
+      epfd = vls_attr (vlsh, VPPCOM_ATTR_GET_LIBC_EPFD, 0, 0);
       if (epfd > 0)
 	{
 	  LDBG (0, "fd %d: calling libc_close: epfd %u", fd, epfd);
@@ -495,7 +326,7 @@ close (int fd)
 	      u32 size = sizeof (epfd);
 	      epfd = 0;
 
-	      (void) vppcom_session_attr (vclsh, VPPCOM_ATTR_SET_LIBC_EPFD,
+	      (void) vls_attr (vlsh, VPPCOM_ATTR_SET_LIBC_EPFD,
 					  &epfd, &size);
 	    }
 	}
@@ -506,9 +337,9 @@ close (int fd)
 	  goto done;
 	}
 
-      LDBG (0, "fd %d: calling vppcom_session_close: vclsh %u", fd, vclsh);
+      LDBG (0, "fd %d: calling vls_close: vlsh %u", fd, vlsh);
 
-      rv = vppcom_session_close (vclsh);
+      rv = vls_close (vlsh);
       if (rv != VPPCOM_OK)
 	{
 	  errno = -rv;
@@ -528,16 +359,16 @@ done:
 ssize_t
 read (int fd, void *buf, size_t nbytes)
 {
-  vcl_session_handle_t vclsh;
+  vls_handle_t vlsh;
   ssize_t size;
 
   if ((errno = -ldp_init ()))
     return -1;
 
-  vclsh = ldp_fd_to_vclsh (fd);
-  if (vclsh != INVALID_SESSION_ID)
+  vlsh = ldp_fd_to_vlsh (fd);
+  if (vlsh != VLS_INVALID_HANDLE)
     {
-      size = vppcom_session_read (vclsh, buf, nbytes);
+      size = vls_read (vlsh, buf, nbytes);
       if (size < 0)
 	{
 	  errno = -size;
@@ -555,41 +386,21 @@ read (int fd, void *buf, size_t nbytes)
 ssize_t
 readv (int fd, const struct iovec * iov, int iovcnt)
 {
-  int rv = 0, i, total = 0;
-  vcl_session_handle_t vclsh;
+  vls_handle_t vlsh;
   ssize_t size = 0;
 
   if ((errno = -ldp_init ()))
     return -1;
 
-  vclsh = ldp_fd_to_vclsh (fd);
-  if (vclsh != INVALID_SESSION_ID)
+  vlsh = ldp_fd_to_vlsh (fd);
+  if (vlsh != VLS_INVALID_HANDLE)
     {
-      do
-	{
-	  for (i = 0; i < iovcnt; ++i)
-	    {
-	      rv =
-		vppcom_session_read (vclsh, iov[i].iov_base, iov[i].iov_len);
-	      if (rv < 0)
-		break;
-	      else
-		{
-		  total += rv;
-		  if (rv < iov[i].iov_len)
-		    break;
-		}
-	    }
-	}
-      while ((rv >= 0) && (total == 0));
-
-      if (rv < 0)
+      size = vls_readv (vlsh, iov, iovcnt);
+      if (size < 0)
 	{
-	  errno = -rv;
+	  errno = -size;
 	  size = -1;
 	}
-      else
-	size = total;
     }
   else
     {
@@ -602,16 +413,16 @@ readv (int fd, const struct iovec * iov, int iovcnt)
 ssize_t
 write (int fd, const void *buf, size_t nbytes)
 {
-  vcl_session_handle_t vclsh;
+  vls_handle_t vlsh;
   ssize_t size = 0;
 
   if ((errno = -ldp_init ()))
     return -1;
 
-  vclsh = ldp_fd_to_vclsh (fd);
-  if (vclsh != INVALID_SESSION_ID)
+  vlsh = ldp_fd_to_vlsh (fd);
+  if (vlsh != VLS_INVALID_HANDLE)
     {
-      size = vppcom_session_write_msg (vclsh, (void *) buf, nbytes);
+      size = vls_write_msg (vlsh, (void *) buf, nbytes);
       if (size < 0)
 	{
 	  errno = -size;
@@ -629,42 +440,21 @@ write (int fd, const void *buf, size_t nbytes)
 ssize_t
 writev (int fd, const struct iovec * iov, int iovcnt)
 {
-  ssize_t size = 0, total = 0;
-  vcl_session_handle_t vclsh;
-  int i, rv = 0;
+  vls_handle_t vlsh;
+  ssize_t size = 0;
 
   if ((errno = -ldp_init ()))
     return -1;
 
-  vclsh = ldp_fd_to_vclsh (fd);
-  if (vclsh != INVALID_SESSION_ID)
+  vlsh = ldp_fd_to_vlsh (fd);
+  if (vlsh != VLS_INVALID_HANDLE)
     {
-      do
-	{
-	  for (i = 0; i < iovcnt; ++i)
-	    {
-	      rv =
-		vppcom_session_write_msg (vclsh, iov[i].iov_base,
-					  iov[i].iov_len);
-	      if (rv < 0)
-		break;
-	      else
-		{
-		  total += rv;
-		  if (rv < iov[i].iov_len)
-		    break;
-		}
-	    }
-	}
-      while ((rv >= 0) && (total == 0));
-
-      if (rv < 0)
+      size = vls_writev (vlsh, iov, iovcnt);
+      if (size < 0)
 	{
-	  errno = -rv;
+	  errno = -size;
 	  size = -1;
 	}
-      else
-	size = total;
     }
   else
     {
@@ -677,7 +467,7 @@ writev (int fd, const struct iovec * iov, int iovcnt)
 int
 fcntl (int fd, int cmd, ...)
 {
-  vcl_session_handle_t vclsh;
+  vls_handle_t vlsh;
   int rv = 0;
   va_list ap;
 
@@ -686,9 +476,9 @@ fcntl (int fd, int cmd, ...)
 
   va_start (ap, cmd);
 
-  vclsh = ldp_fd_to_vclsh (fd);
-  LDBG (0, "fd %u vclsh %d, cmd %u", fd, vclsh, cmd);
-  if (vclsh != INVALID_SESSION_ID)
+  vlsh = ldp_fd_to_vlsh (fd);
+  LDBG (0, "fd %u vlsh %d, cmd %u", fd, vlsh, cmd);
+  if (vlsh != VLS_INVALID_HANDLE)
     {
       int flags = va_arg (ap, int);
       u32 size;
@@ -699,12 +489,12 @@ fcntl (int fd, int cmd, ...)
 	{
 	case F_SETFL:
 	  rv =
-	    vppcom_session_attr (vclsh, VPPCOM_ATTR_SET_FLAGS, &flags, &size);
+	    vls_attr (vlsh, VPPCOM_ATTR_SET_FLAGS, &flags, &size);
 	  break;
 
 	case F_GETFL:
 	  rv =
-	    vppcom_session_attr (vclsh, VPPCOM_ATTR_GET_FLAGS, &flags, &size);
+	    vls_attr (vlsh, VPPCOM_ATTR_GET_FLAGS, &flags, &size);
 	  if (rv == VPPCOM_OK)
 	    rv = flags;
 	  break;
@@ -736,7 +526,7 @@ fcntl (int fd, int cmd, ...)
 int
 ioctl (int fd, unsigned long int cmd, ...)
 {
-  vcl_session_handle_t vclsh;
+  vls_handle_t vlsh;
   va_list ap;
   int rv;
 
@@ -745,13 +535,13 @@ ioctl (int fd, unsigned long int cmd, ...)
 
   va_start (ap, cmd);
 
-  vclsh = ldp_fd_to_vclsh (fd);
-  if (vclsh != INVALID_SESSION_ID)
+  vlsh = ldp_fd_to_vlsh (fd);
+  if (vlsh != VLS_INVALID_HANDLE)
     {
       switch (cmd)
 	{
 	case FIONREAD:
-	  rv = vppcom_session_attr (vclsh, VPPCOM_ATTR_GET_NREAD, 0, 0);
+	  rv = vls_attr (vlsh, VPPCOM_ATTR_GET_NREAD, 0, 0);
 	  break;
 
 	case FIONBIO:
@@ -764,7 +554,7 @@ ioctl (int fd, unsigned long int cmd, ...)
 	     *      with O_NONBLOCK.
 	     */
 	    rv =
-	      vppcom_session_attr (vclsh, VPPCOM_ATTR_SET_FLAGS, &flags,
+	      vls_attr (vlsh, VPPCOM_ATTR_SET_FLAGS, &flags,
 				   &size);
 	  }
 	  break;
@@ -795,7 +585,8 @@ ldp_select_init_maps (fd_set * __restrict original,
 		      u32 n_bytes, uword * si_bits, uword * libc_bits)
 {
   uword si_bits_set, libc_bits_set;
-  vcl_session_handle_t vclsh;
+  vls_handle_t vlsh;
+  u32 si;
   int fd;
 
   clib_bitmap_validate (*vclb, minbits);
@@ -808,11 +599,15 @@ ldp_select_init_maps (fd_set * __restrict original,
   clib_bitmap_foreach (fd, *resultb, ({
     if (fd > nfds)
       break;
-    vclsh = ldp_fd_to_vclsh (fd);
-    if (vclsh == INVALID_SESSION_ID)
+    vlsh = ldp_fd_to_vlsh (fd);
+    if (vlsh == VLS_INVALID_HANDLE)
       clib_bitmap_set_no_check (*libcb, fd, 1);
     else
-      clib_bitmap_set_no_check (*vclb, vppcom_session_index (vclsh), 1);
+      {
+        si = vlsh_to_session_index (vlsh);
+        if (si != INVALID_SESSION_ID)
+          clib_bitmap_set_no_check (*vclb, si, 1);
+      }
   }));
   /* *INDENT-ON* */
 
@@ -826,7 +621,7 @@ ldp_select_init_maps (fd_set * __restrict original,
 always_inline int
 ldp_select_vcl_map_to_libc (clib_bitmap_t * vclb, fd_set * __restrict libcb)
 {
-  vcl_session_handle_t vclsh;
+  vls_handle_t vlsh;
   uword si;
   int fd;
 
@@ -835,8 +630,9 @@ ldp_select_vcl_map_to_libc (clib_bitmap_t * vclb, fd_set * __restrict libcb)
 
   /* *INDENT-OFF* */
   clib_bitmap_foreach (si, vclb, ({
-    vclsh = vcl_session_handle_from_index (si);
-    fd = ldp_vclsh_to_fd (vclsh);
+    vlsh = vls_session_index_to_vlsh (si);
+    ASSERT (vlsh != VLS_INVALID_HANDLE);
+    fd = ldp_vlsh_to_fd (vlsh);
     if (PREDICT_FALSE (fd < 0))
       {
         errno = EBADFD;
@@ -959,7 +755,7 @@ ldp_pselect (int nfds, fd_set * __restrict readfds,
 			      vec_len (ldpw->ex_bitmap) *
 			      sizeof (clib_bitmap_t));
 
-	  rv = vppcom_select (si_bits, readfds ? ldpw->rd_bitmap : NULL,
+	  rv = vls_select (si_bits, readfds ? ldpw->rd_bitmap : NULL,
 			      writefds ? ldpw->wr_bitmap : NULL,
 			      exceptfds ? ldpw->ex_bitmap : NULL,
 			      vcl_timeout);
@@ -1074,7 +870,7 @@ pselect (int nfds, fd_set * __restrict readfds,
 /* If transparent TLS mode is turned on, then ldp will load key and cert.
  */
 static int
-load_tls_cert (vcl_session_handle_t vclsh)
+load_tls_cert (vls_handle_t vlsh)
 {
   char *env_var_str = getenv (LDP_ENV_TLS_CERT);
   char inbuf[4096];
@@ -1092,8 +888,7 @@ load_tls_cert (vcl_session_handle_t vclsh)
 	}
       cert_size = fread (inbuf, sizeof (char), sizeof (inbuf), fp);
       tls_cert = inbuf;
-      vppcom_session_tls_add_cert (vppcom_session_index (vclsh), tls_cert,
-				   cert_size);
+      vppcom_session_tls_add_cert (vlsh_to_sh (vlsh), tls_cert, cert_size);
       fclose (fp);
     }
   else
@@ -1106,7 +901,7 @@ load_tls_cert (vcl_session_handle_t vclsh)
 }
 
 static int
-load_tls_key (vcl_session_handle_t vclsh)
+load_tls_key (vls_handle_t vlsh)
 {
   char *env_var_str = getenv (LDP_ENV_TLS_KEY);
   char inbuf[4096];
@@ -1124,8 +919,7 @@ load_tls_key (vcl_session_handle_t vclsh)
 	}
       key_size = fread (inbuf, sizeof (char), sizeof (inbuf), fp);
       tls_key = inbuf;
-      vppcom_session_tls_add_key (vppcom_session_index (vclsh), tls_key,
-				  key_size);
+      vppcom_session_tls_add_key (vlsh_to_sh (vlsh), tls_key, key_size);
       fclose (fp);
     }
   else
@@ -1141,7 +935,7 @@ socket (int domain, int type, int protocol)
 {
   int rv, sock_type = type & ~(SOCK_CLOEXEC | SOCK_NONBLOCK);
   u8 is_nonblocking = type & SOCK_NONBLOCK ? 1 : 0;
-  vcl_session_handle_t vclsh;
+  vls_handle_t vlsh;
 
   if ((errno = -ldp_init ()))
     return -1;
@@ -1159,25 +953,25 @@ socket (int domain, int type, int protocol)
 		 VPPCOM_PROTO_UDP : VPPCOM_PROTO_TCP);
 
       LDBG (0,
-	    "calling vppcom_session_create: proto %u (%s), is_nonblocking %u",
+	    "calling vls_create: proto %u (%s), is_nonblocking %u",
 	    proto, vppcom_proto_str (proto), is_nonblocking);
 
-      vclsh = vppcom_session_create (proto, is_nonblocking);
-      if (vclsh < 0)
+      vlsh = vls_create (proto, is_nonblocking);
+      if (vlsh < 0)
 	{
-	  errno = -vclsh;
+	  errno = -vlsh;
 	  rv = -1;
 	}
       else
 	{
 	  if (ldp->transparent_tls)
 	    {
-	      if (load_tls_cert (vclsh) < 0 || load_tls_key (vclsh) < 0)
+	      if (load_tls_cert (vlsh) < 0 || load_tls_key (vlsh) < 0)
 		{
 		  return -1;
 		}
 	    }
-	  rv = ldp_vclsh_to_fd (vclsh);
+	  rv = ldp_vlsh_to_fd (vlsh);
 	}
     }
   else
@@ -1221,16 +1015,17 @@ socketpair (int domain, int type, int protocol, int fds[2])
 }
 
 int
-bind (int fd, __CONST_SOCKADDR_ARG addr, socklen_t len)
+bind (int fd, __CONST_SOCKADDR_ARG _addr, socklen_t len)
 {
-  vcl_session_handle_t vclsh;
+  const struct sockaddr *addr = SOCKADDR_GET_SA (_addr);
+  vls_handle_t vlsh;
   int rv;
 
   if ((errno = -ldp_init ()))
     return -1;
 
-  vclsh = ldp_fd_to_vclsh (fd);
-  if (vclsh != INVALID_SESSION_ID)
+  vlsh = ldp_fd_to_vlsh (fd);
+  if (vlsh != VLS_INVALID_HANDLE)
     {
       vppcom_endpt_t ep;
 
@@ -1239,8 +1034,8 @@ bind (int fd, __CONST_SOCKADDR_ARG addr, socklen_t len)
 	case AF_INET:
 	  if (len != sizeof (struct sockaddr_in))
 	    {
-	      LDBG (0, "ERROR: fd %d: vclsh %u: Invalid AF_INET addr len %u!",
-		    fd, vclsh, len);
+	      LDBG (0, "ERROR: fd %d: vlsh %u: Invalid AF_INET addr len %u!",
+		    fd, vlsh, len);
 	      errno = EINVAL;
 	      rv = -1;
 	      goto done;
@@ -1254,8 +1049,8 @@ bind (int fd, __CONST_SOCKADDR_ARG addr, socklen_t len)
 	  if (len != sizeof (struct sockaddr_in6))
 	    {
 	      LDBG (0,
-		    "ERROR: fd %d: vclsh %u: Invalid AF_INET6 addr len %u!",
-		    fd, vclsh, len);
+		    "ERROR: fd %d: vlsh %u: Invalid AF_INET6 addr len %u!",
+		    fd, vlsh, len);
 	      errno = EINVAL;
 	      rv = -1;
 	      goto done;
@@ -1266,17 +1061,17 @@ bind (int fd, __CONST_SOCKADDR_ARG addr, socklen_t len)
 	  break;
 
 	default:
-	  LDBG (0, "ERROR: fd %d: vclsh %u: Unsupported address family %u!",
-		fd, vclsh, addr->sa_family);
+	  LDBG (0, "ERROR: fd %d: vlsh %u: Unsupported address family %u!",
+		fd, vlsh, addr->sa_family);
 	  errno = EAFNOSUPPORT;
 	  rv = -1;
 	  goto done;
 	}
       LDBG (0,
-	    "fd %d: calling vppcom_session_bind: vclsh %u, addr %p, len %u",
-	    fd, vclsh, addr, len);
+	    "fd %d: calling vls_bind: vlsh %u, addr %p, len %u",
+	    fd, vlsh, addr, len);
 
-      rv = vppcom_session_bind (vclsh, &ep);
+      rv = vls_bind (vlsh, &ep);
       if (rv != VPPCOM_OK)
 	{
 	  errno = -rv;
@@ -1296,7 +1091,7 @@ done:
 }
 
 static inline int
-ldp_copy_ep_to_sockaddr (__SOCKADDR_ARG addr, socklen_t * __restrict len,
+ldp_copy_ep_to_sockaddr (struct sockaddr *addr, socklen_t * __restrict len,
 			 vppcom_endpt_t * ep)
 {
   int rv = 0;
@@ -1342,16 +1137,17 @@ ldp_copy_ep_to_sockaddr (__SOCKADDR_ARG addr, socklen_t * __restrict len,
 }
 
 int
-getsockname (int fd, __SOCKADDR_ARG addr, socklen_t * __restrict len)
+getsockname (int fd, __SOCKADDR_ARG _addr, socklen_t * __restrict len)
 {
-  vcl_session_handle_t vclsh;
+  struct sockaddr *addr = SOCKADDR_GET_SA (_addr);
+  vls_handle_t vlsh;
   int rv;
 
   if ((errno = -ldp_init ()))
     return -1;
 
-  vclsh = ldp_fd_to_vclsh (fd);
-  if (vclsh != INVALID_SESSION_ID)
+  vlsh = ldp_fd_to_vlsh (fd);
+  if (vlsh != VLS_INVALID_HANDLE)
     {
       vppcom_endpt_t ep;
       u8 addr_buf[sizeof (struct in6_addr)];
@@ -1359,7 +1155,7 @@ getsockname (int fd, __SOCKADDR_ARG addr, socklen_t * __restrict len)
 
       ep.ip = addr_buf;
 
-      rv = vppcom_session_attr (vclsh, VPPCOM_ATTR_GET_LCL_ADDR, &ep, &size);
+      rv = vls_attr (vlsh, VPPCOM_ATTR_GET_LCL_ADDR, &ep, &size);
       if (rv != VPPCOM_OK)
 	{
 	  errno = -rv;
@@ -1384,9 +1180,10 @@ getsockname (int fd, __SOCKADDR_ARG addr, socklen_t * __restrict len)
 }
 
 int
-connect (int fd, __CONST_SOCKADDR_ARG addr, socklen_t len)
+connect (int fd, __CONST_SOCKADDR_ARG _addr, socklen_t len)
 {
-  vcl_session_handle_t vclsh;
+  const struct sockaddr *addr = SOCKADDR_GET_SA (_addr);
+  vls_handle_t vlsh;
   int rv;
 
   if ((errno = -ldp_init ()))
@@ -1400,8 +1197,8 @@ connect (int fd, __CONST_SOCKADDR_ARG addr, socklen_t len)
       goto done;
     }
 
-  vclsh = ldp_fd_to_vclsh (fd);
-  if (vclsh != INVALID_SESSION_ID)
+  vlsh = ldp_fd_to_vlsh (fd);
+  if (vlsh != VLS_INVALID_HANDLE)
     {
       vppcom_endpt_t ep;
 
@@ -1410,8 +1207,8 @@ connect (int fd, __CONST_SOCKADDR_ARG addr, socklen_t len)
 	case AF_INET:
 	  if (len != sizeof (struct sockaddr_in))
 	    {
-	      LDBG (0, "fd %d: ERROR vclsh %u: Invalid AF_INET addr len %u!",
-		    fd, vclsh, len);
+	      LDBG (0, "fd %d: ERROR vlsh %u: Invalid AF_INET addr len %u!",
+		    fd, vlsh, len);
 	      errno = EINVAL;
 	      rv = -1;
 	      goto done;
@@ -1424,8 +1221,8 @@ connect (int fd, __CONST_SOCKADDR_ARG addr, socklen_t len)
 	case AF_INET6:
 	  if (len != sizeof (struct sockaddr_in6))
 	    {
-	      LDBG (0, "fd %d: ERROR vclsh %u: Invalid AF_INET6 addr len %u!",
-		    fd, vclsh, len);
+	      LDBG (0, "fd %d: ERROR vlsh %u: Invalid AF_INET6 addr len %u!",
+		    fd, vlsh, len);
 	      errno = EINVAL;
 	      rv = -1;
 	      goto done;
@@ -1436,17 +1233,17 @@ connect (int fd, __CONST_SOCKADDR_ARG addr, socklen_t len)
 	  break;
 
 	default:
-	  LDBG (0, "fd %d: ERROR vclsh %u: Unsupported address family %u!",
-		fd, vclsh, addr->sa_family);
+	  LDBG (0, "fd %d: ERROR vlsh %u: Unsupported address family %u!",
+		fd, vlsh, addr->sa_family);
 	  errno = EAFNOSUPPORT;
 	  rv = -1;
 	  goto done;
 	}
       LDBG (0,
-	    "fd %d: calling vppcom_session_connect(): vclsh %u addr %p len %u",
-	    fd, vclsh, addr, len);
+	    "fd %d: calling vls_connect(): vlsh %u addr %p len %u",
+	    fd, vlsh, addr, len);
 
-      rv = vppcom_session_connect (vclsh, &ep);
+      rv = vls_connect (vlsh, &ep);
       if (rv != VPPCOM_OK)
 	{
 	  errno = -rv;
@@ -1467,23 +1264,24 @@ done:
 }
 
 int
-getpeername (int fd, __SOCKADDR_ARG addr, socklen_t * __restrict len)
+getpeername (int fd, __SOCKADDR_ARG _addr, socklen_t * __restrict len)
 {
-  vcl_session_handle_t vclsh;
+  struct sockaddr *addr = SOCKADDR_GET_SA (_addr);
+  vls_handle_t vlsh;
   int rv;
 
   if ((errno = -ldp_init ()))
     return -1;
 
-  vclsh = ldp_fd_to_vclsh (fd);
-  if (vclsh != INVALID_SESSION_ID)
+  vlsh = ldp_fd_to_vlsh (fd);
+  if (vlsh != VLS_INVALID_HANDLE)
     {
       vppcom_endpt_t ep;
       u8 addr_buf[sizeof (struct in6_addr)];
       u32 size = sizeof (ep);
 
       ep.ip = addr_buf;
-      rv = vppcom_session_attr (vclsh, VPPCOM_ATTR_GET_PEER_ADDR, &ep, &size);
+      rv = vls_attr (vlsh, VPPCOM_ATTR_GET_PEER_ADDR, &ep, &size);
       if (rv != VPPCOM_OK)
 	{
 	  errno = -rv;
@@ -1510,15 +1308,15 @@ getpeername (int fd, __SOCKADDR_ARG addr, socklen_t * __restrict len)
 ssize_t
 send (int fd, const void *buf, size_t n, int flags)
 {
-  vcl_session_handle_t vclsh = ldp_fd_to_vclsh (fd);
+  vls_handle_t vlsh = ldp_fd_to_vlsh (fd);
   ssize_t size;
 
   if ((errno = -ldp_init ()))
     return -1;
 
-  if (vclsh != INVALID_SESSION_ID)
+  if (vlsh != VLS_INVALID_HANDLE)
     {
-      size = vppcom_session_sendto (vclsh, (void *) buf, n, flags, NULL);
+      size = vls_sendto (vlsh, (void *) buf, n, flags, NULL);
       if (size < VPPCOM_OK)
 	{
 	  errno = -size;
@@ -1536,149 +1334,29 @@ send (int fd, const void *buf, size_t n, int flags)
 ssize_t
 sendfile (int out_fd, int in_fd, off_t * offset, size_t len)
 {
-  ldp_worker_ctx_t *ldpw = ldp_worker_get_current ();
-  vcl_session_handle_t vclsh;
+  vls_handle_t vlsh;
   ssize_t size = 0;
 
   if ((errno = -ldp_init ()))
     return -1;
 
-  vclsh = ldp_fd_to_vclsh (out_fd);
-  if (vclsh != INVALID_SESSION_ID)
+  vlsh = ldp_fd_to_vlsh (out_fd);
+  if (vlsh != VLS_INVALID_HANDLE)
     {
-      int rv;
-      ssize_t results = 0;
-      size_t n_bytes_left = len;
-      size_t bytes_to_read;
-      int nbytes;
-      u8 eagain = 0;
-      u32 flags, flags_len = sizeof (flags);
-
-      rv =
-	vppcom_session_attr (vclsh, VPPCOM_ATTR_GET_FLAGS, &flags,
-			     &flags_len);
-      if (PREDICT_FALSE (rv != VPPCOM_OK))
-	{
-	  LDBG (0,
-		"ERROR: out fd %d: vppcom_session_attr: vclsh %u, returned %d (%s)!",
-		out_fd, vclsh, rv, vppcom_retval_str (rv));
-
-	  vec_reset_length (ldpw->io_buffer);
-	  errno = -rv;
-	  size = -1;
-	  goto done;
-	}
-
-      if (offset)
-	{
-	  off_t off = lseek (in_fd, *offset, SEEK_SET);
-	  if (PREDICT_FALSE (off == -1))
-	    {
-	      size = -1;
-	      goto done;
-	    }
-
-	  ASSERT (off == *offset);
-	}
-
-      do
-	{
-	  size = vppcom_session_attr (vclsh, VPPCOM_ATTR_GET_NWRITE, 0, 0);
-	  if (size < 0)
-	    {
-	      LDBG (0,
-		    "ERROR: fd %d: voocom_session_attr: vclsh %u returned %d (%s)!",
-		    out_fd, vclsh, size, vppcom_retval_str (size));
-	      vec_reset_length (ldpw->io_buffer);
-	      errno = -size;
-	      size = -1;
-	      goto done;
-	    }
-
-	  bytes_to_read = size;
-	  if (bytes_to_read == 0)
-	    {
-	      if (flags & O_NONBLOCK)
-		{
-		  if (!results)
-		    eagain = 1;
-		  goto update_offset;
-		}
-	      else
-		continue;
-	    }
-	  bytes_to_read = clib_min (n_bytes_left, bytes_to_read);
-	  vec_validate (ldpw->io_buffer, bytes_to_read);
-	  nbytes = libc_read (in_fd, ldpw->io_buffer, bytes_to_read);
-	  if (nbytes < 0)
-	    {
-	      if (results == 0)
-		{
-		  vec_reset_length (ldpw->io_buffer);
-		  size = -1;
-		  goto done;
-		}
-	      goto update_offset;
-	    }
-
-	  size = vppcom_session_write (vclsh, ldpw->io_buffer, nbytes);
-	  if (size < 0)
-	    {
-	      if (size == VPPCOM_EAGAIN)
-		{
-		  if (flags & O_NONBLOCK)
-		    {
-		      if (!results)
-			eagain = 1;
-		      goto update_offset;
-		    }
-		  else
-		    continue;
-		}
-	      if (results == 0)
-		{
-		  vec_reset_length (ldpw->io_buffer);
-		  errno = -size;
-		  size = -1;
-		  goto done;
-		}
-	      goto update_offset;
-	    }
-
-	  results += nbytes;
-	  ASSERT (n_bytes_left >= nbytes);
-	  n_bytes_left = n_bytes_left - nbytes;
-	}
-      while (n_bytes_left > 0);
-
-    update_offset:
-      vec_reset_length (ldpw->io_buffer);
-      if (offset)
-	{
-	  off_t off = lseek (in_fd, *offset, SEEK_SET);
-	  if (PREDICT_FALSE (off == -1))
-	    {
-	      size = -1;
-	      goto done;
-	    }
-
-	  ASSERT (off == *offset);
-	  *offset += results + 1;
-	}
-      if (eagain)
+      size = vls_sendfile (vlsh, in_fd, offset, len);
+      if (size < 0)
 	{
-	  errno = EAGAIN;
+	  LDBG (1, "out fd %d: vls_sendfile: vlsh %u, returned "
+		"%d (%s)", out_fd, vlsh, size, vppcom_retval_str (size));
+	  errno = -size;
 	  size = -1;
 	}
-      else
-	size = results;
     }
   else
     {
       size = libc_sendfile (out_fd, in_fd, offset, len);
     }
 
-done:
   return size;
 }
 
@@ -1691,16 +1369,16 @@ sendfile64 (int out_fd, int in_fd, off_t * offset, size_t len)
 ssize_t
 recv (int fd, void *buf, size_t n, int flags)
 {
-  vcl_session_handle_t vclsh;
+  vls_handle_t vlsh;
   ssize_t size;
 
   if ((errno = -ldp_init ()))
     return -1;
 
-  vclsh = ldp_fd_to_vclsh (fd);
-  if (vclsh != INVALID_SESSION_ID)
+  vlsh = ldp_fd_to_vlsh (fd);
+  if (vlsh != VLS_INVALID_HANDLE)
     {
-      size = vppcom_session_recvfrom (vclsh, buf, n, flags, NULL);
+      size = vls_recvfrom (vlsh, buf, n, flags, NULL);
       if (size < 0)
 	errno = -size;
     }
@@ -1712,18 +1390,42 @@ recv (int fd, void *buf, size_t n, int flags)
   return size;
 }
 
+static inline int
+ldp_sockaddr_to_ep (const struct sockaddr *addr, vppcom_endpt_t * ep)
+{
+  switch (addr->sa_family)
+    {
+    case AF_INET:
+      ep->is_ip4 = VPPCOM_IS_IP4;
+      ep->ip = (uint8_t *) & ((const struct sockaddr_in *) addr)->sin_addr;
+      ep->port = (uint16_t) ((const struct sockaddr_in *) addr)->sin_port;
+      break;
+
+    case AF_INET6:
+      ep->is_ip4 = VPPCOM_IS_IP6;
+      ep->ip = (uint8_t *) & ((const struct sockaddr_in6 *) addr)->sin6_addr;
+      ep->port = (uint16_t) ((const struct sockaddr_in6 *) addr)->sin6_port;
+      break;
+
+    default:
+      return -1;
+    }
+  return 0;
+}
+
 ssize_t
 sendto (int fd, const void *buf, size_t n, int flags,
-	__CONST_SOCKADDR_ARG addr, socklen_t addr_len)
+	__CONST_SOCKADDR_ARG _addr, socklen_t addr_len)
 {
-  vcl_session_handle_t vclsh;
+  const struct sockaddr *addr = SOCKADDR_GET_SA (_addr);
+  vls_handle_t vlsh;
   ssize_t size;
 
   if ((errno = -ldp_init ()))
     return -1;
 
-  vclsh = ldp_fd_to_vclsh (fd);
-  if (vclsh != INVALID_SESSION_ID)
+  vlsh = ldp_fd_to_vlsh (fd);
+  if (vlsh != VLS_INVALID_HANDLE)
     {
       vppcom_endpt_t *ep = 0;
       vppcom_endpt_t _ep;
@@ -1731,32 +1433,15 @@ sendto (int fd, const void *buf, size_t n, int flags,
       if (addr)
 	{
 	  ep = &_ep;
-	  switch (addr->sa_family)
+	  if (ldp_sockaddr_to_ep (addr, ep))
 	    {
-	    case AF_INET:
-	      ep->is_ip4 = VPPCOM_IS_IP4;
-	      ep->ip =
-		(uint8_t *) & ((const struct sockaddr_in *) addr)->sin_addr;
-	      ep->port =
-		(uint16_t) ((const struct sockaddr_in *) addr)->sin_port;
-	      break;
-
-	    case AF_INET6:
-	      ep->is_ip4 = VPPCOM_IS_IP6;
-	      ep->ip =
-		(uint8_t *) & ((const struct sockaddr_in6 *) addr)->sin6_addr;
-	      ep->port =
-		(uint16_t) ((const struct sockaddr_in6 *) addr)->sin6_port;
-	      break;
-
-	    default:
 	      errno = EAFNOSUPPORT;
 	      size = -1;
 	      goto done;
 	    }
 	}
 
-      size = vppcom_session_sendto (vclsh, (void *) buf, n, flags, ep);
+      size = vls_sendto (vlsh, (void *) buf, n, flags, ep);
       if (size < 0)
 	{
 	  errno = -size;
@@ -1774,16 +1459,17 @@ done:
 
 ssize_t
 recvfrom (int fd, void *__restrict buf, size_t n, int flags,
-	  __SOCKADDR_ARG addr, socklen_t * __restrict addr_len)
+	  __SOCKADDR_ARG _addr, socklen_t * __restrict addr_len)
 {
-  vcl_session_handle_t sid;
+  struct sockaddr *addr = SOCKADDR_GET_SA (_addr);
+  vls_handle_t vlsh;
   ssize_t size, rv;
 
   if ((errno = -ldp_init ()))
     return -1;
 
-  sid = ldp_fd_to_vclsh (fd);
-  if (sid != INVALID_SESSION_ID)
+  vlsh = ldp_fd_to_vlsh (fd);
+  if (vlsh != VLS_INVALID_HANDLE)
     {
       vppcom_endpt_t ep;
       u8 src_addr[sizeof (struct sockaddr_in6)];
@@ -1791,7 +1477,7 @@ recvfrom (int fd, void *__restrict buf, size_t n, int flags,
       if (addr)
 	{
 	  ep.ip = src_addr;
-	  size = vppcom_session_recvfrom (sid, buf, n, flags, &ep);
+	  size = vls_recvfrom (vlsh, buf, n, flags, &ep);
 
 	  if (size > 0)
 	    {
@@ -1801,7 +1487,7 @@ recvfrom (int fd, void *__restrict buf, size_t n, int flags,
 	    }
 	}
       else
-	size = vppcom_session_recvfrom (sid, buf, n, flags, NULL);
+	size = vls_recvfrom (vlsh, buf, n, flags, NULL);
 
       if (size < 0)
 	{
@@ -1820,18 +1506,38 @@ recvfrom (int fd, void *__restrict buf, size_t n, int flags,
 ssize_t
 sendmsg (int fd, const struct msghdr * message, int flags)
 {
-  vcl_session_handle_t vclsh;
+  vls_handle_t vlsh;
   ssize_t size;
 
   if ((errno = -ldp_init ()))
     return -1;
 
-  vclsh = ldp_fd_to_vclsh (fd);
-  if (vclsh != INVALID_SESSION_ID)
+  vlsh = ldp_fd_to_vlsh (fd);
+  if (vlsh != VLS_INVALID_HANDLE)
     {
-      LDBG (0, "LDP-TBD");
-      errno = ENOSYS;
-      size = -1;
+      vppcom_msg_t msg = { 0 };
+      vppcom_endpt_t ep;
+
+      msg.iov = message->msg_iov;
+      msg.iovcnt = message->msg_iovlen;
+      if (message->msg_name)
+	{
+	  if (ldp_sockaddr_to_ep (message->msg_name, &ep))
+	    {
+	      errno = EAFNOSUPPORT;
+	      return -1;
+	    }
+	  msg.ep = &ep;
+	}
+
+      size = vls_sendmmsg (vlsh, &msg, 1, flags);
+      if (size < 0)
+	{
+	  errno = -size;
+	  size = -1;
+	}
+      else
+	size = msg.len;
     }
   else
     {
@@ -1841,69 +1547,109 @@ sendmsg (int fd, const struct msghdr * message, int flags)
   return size;
 }
 
-#ifdef USE_GNU
+#ifdef __USE_GNU
 int
 sendmmsg (int fd, struct mmsghdr *vmessages, unsigned int vlen, int flags)
 {
-  ssize_t size;
-  const char *func_str;
-  u32 sh = ldp_fd_to_vclsh (fd);
+  vls_handle_t vlsh;
+  ldp_worker_ctx_t *ldpw;
+  struct msghdr *mh;
+  vppcom_msg_t *msg;
+  int i, rv;
 
   if ((errno = -ldp_init ()))
     return -1;
 
-  if (sh != INVALID_SESSION_ID)
+  vlsh = ldp_fd_to_vlsh (fd);
+  if (vlsh != VLS_INVALID_HANDLE)
     {
-      clib_warning ("LDP<%d>: LDP-TBD", getpid ());
-      errno = ENOSYS;
-      size = -1;
-    }
-  else
-    {
-      func_str = "libc_sendmmsg";
+      if (!vlen)
+	return 0;
 
-      if (LDP_DEBUG > 2)
-	clib_warning ("LDP<%d>: fd %d (0x%x): calling %s(): "
-		      "vmessages %p, vlen %u, flags 0x%x",
-		      getpid (), fd, fd, func_str, vmessages, vlen, flags);
+      ldpw = ldp_worker_get_current ();
+      vec_validate (ldpw->vcl_msgs, vlen - 1);
+      vec_validate (ldpw->vcl_eps, vlen - 1);
 
-      size = libc_sendmmsg (fd, vmessages, vlen, flags);
-    }
+      for (i = 0; i < vlen; i++)
+	{
+	  mh = &vmessages[i].msg_hdr;
+	  msg = &ldpw->vcl_msgs[i];
+	  msg->iov = mh->msg_iov;
+	  msg->iovcnt = mh->msg_iovlen;
+	  msg->ep = 0;
+	  if (mh->msg_name)
+	    {
+	      msg->ep = &ldpw->vcl_eps[i];
+	      if (ldp_sockaddr_to_ep (mh->msg_name, msg->ep))
+		{
+		  errno = EAFNOSUPPORT;
+		  return -1;
+		}
+	    }
+	}
 
-  if (LDP_DEBUG > 2)
-    {
-      if (size < 0)
+      rv = vls_sendmmsg (vlsh, ldpw->vcl_msgs, vlen, flags);
+      if (rv < 0)
 	{
-	  int errno_val = errno;
-	  perror (func_str);
-	  clib_warning ("LDP<%d>: ERROR: fd %d (0x%x): %s() failed! "
-			"rv %d, errno = %d", getpid (), fd, fd,
-			func_str, size, errno_val);
-	  errno = errno_val;
+	  errno = -rv;
+	  rv = -1;
 	}
       else
-	clib_warning ("LDP<%d>: fd %d (0x%x): returning %d (0x%x)",
-		      getpid (), fd, fd, size, size);
+	{
+	  for (i = 0; i < rv; i++)
+	    vmessages[i].msg_len = ldpw->vcl_msgs[i].len;
+	}
     }
-  return size;
+  else
+    {
+      rv = libc_sendmmsg (fd, vmessages, vlen, flags);
+    }
+
+  LDBG (2, "fd %d: vlen %u, flags 0x%x, returning %d", fd, vlen, flags, rv);
+
+  return rv;
 }
 #endif
 
 ssize_t
 recvmsg (int fd, struct msghdr * message, int flags)
 {
-  vcl_session_handle_t vclsh;
+  vls_handle_t vlsh;
   ssize_t size;
 
   if ((errno = -ldp_init ()))
     return -1;
 
-  vclsh = ldp_fd_to_vclsh (fd);
-  if (vclsh != INVALID_SESSION_ID)
+  vlsh = ldp_fd_to_vlsh (fd);
+  if (vlsh != VLS_INVALID_HANDLE)
     {
-      LDBG (0, "LDP-TBD");
-      errno = ENOSYS;
-      size = -1;
+      u8 src_addr[sizeof (struct sockaddr_in6)];
+      vppcom_msg_t msg = { 0 };
+      vppcom_endpt_t ep;
+
+      msg.iov = message->msg_iov;
+      msg.iovcnt = message->msg_iovlen;
+      if (message->msg_name)
+	{
+	  ep.ip = src_addr;
+	  msg.ep = &ep;
+	}
+
+      size = vls_recvmmsg (vlsh, &msg, 1, flags);
+      if (size == 0)
+	size = VPPCOM_EWOULDBLOCK;
+      if (size < 0)
+	{
+	  errno = -size;
+	  return -1;
+	}
+
+      size = msg.len;
+      if (msg.ep && ldp_copy_ep_to_sockaddr (message->msg_name,
+					     &message->msg_namelen, &ep) < 0)
+	return -1;
+      message->msg_controllen = 0;
+      message->msg_flags = 0;
     }
   else
     {
@@ -1913,53 +1659,84 @@ recvmsg (int fd, struct msghdr * message, int flags)
   return size;
 }
 
-#ifdef USE_GNU
+#ifdef __USE_GNU
 int
 recvmmsg (int fd, struct mmsghdr *vmessages,
 	  unsigned int vlen, int flags, struct timespec *tmo)
 {
-  ssize_t size;
-  const char *func_str;
-  u32 sh = ldp_fd_to_vclsh (fd);
+  vls_handle_t vlsh;
+  ldp_worker_ctx_t *ldpw;
+  struct msghdr *mh;
+  vppcom_msg_t *msg;
+  int i, rv;
 
   if ((errno = -ldp_init ()))
     return -1;
 
-  if (sh != INVALID_SESSION_ID)
+  vlsh = ldp_fd_to_vlsh (fd);
+  if (vlsh != VLS_INVALID_HANDLE)
     {
-      clib_warning ("LDP<%d>: LDP-TBD", getpid ());
-      errno = ENOSYS;
-      size = -1;
-    }
-  else
-    {
-      func_str = "libc_recvmmsg";
+      if (!vlen)
+	return 0;
 
-      if (LDP_DEBUG > 2)
-	clib_warning ("LDP<%d>: fd %d (0x%x): calling %s(): "
-		      "vmessages %p, vlen %u, flags 0x%x, tmo %p",
-		      getpid (), fd, fd, func_str, vmessages, vlen,
-		      flags, tmo);
+      ldpw = ldp_worker_get_current ();
+      vec_validate (ldpw->vcl_msgs, vlen - 1);
+      vec_validate (ldpw->vcl_eps, vlen - 1);
+      vec_validate (ldpw->vcl_ep_ips, vlen - 1);
 
-      size = libc_recvmmsg (fd, vmessages, vlen, flags, tmo);
-    }
+      for (i = 0; i < vlen; i++)
+	{
+	  mh = &vmessages[i].msg_hdr;
+	  msg = &ldpw->vcl_msgs[i];
+	  msg->iov = mh->msg_iov;
+	  msg->iovcnt = mh->msg_iovlen;
+	  msg->ep = 0;
+	  if (mh->msg_name)
+	    {
+	      msg->ep = &ldpw->vcl_eps[i];
+	      msg->ep->ip = (u8 *) & ldpw->vcl_ep_ips[i];
+	    }
+	}
 
-  if (LDP_DEBUG > 2)
-    {
-      if (size < 0)
+      /* Only the first message is waited for, so MSG_WAITFORONE is implied
+       * and the timeout, which is checked only after a datagram is received,
+       * does not apply */
+      rv = vls_recvmmsg (vlsh, ldpw->vcl_msgs, vlen,
+				    flags & ~MSG_WAITFORONE);
+      if (rv == 0)
+	rv = VPPCOM_EWOULDBLOCK;
+      if (rv < 0)
 	{
-	  int errno_val = errno;
-	  perror (func_str);
-	  clib_warning ("LDP<%d>: ERROR: fd %d (0x%x): %s() failed! "
-			"rv %d, errno = %d", getpid (), fd, fd,
-			func_str, size, errno_val);
-	  errno = errno_val;
+	  errno = -rv;
+	  rv = -1;
+	  goto done;
+	}
+
+      for (i = 0; i < rv; i++)
+	{
+	  mh = &vmessages[i].msg_hdr;
+	  msg = &ldpw->vcl_msgs[i];
+	  vmessages[i].msg_len = msg->len;
+	  if (msg->ep
+	      && ldp_copy_ep_to_sockaddr (mh->msg_name, &mh->msg_namelen,
+					  msg->ep) < 0)
+	    {
+	      rv = -1;
+	      goto done;
+	    }
+	  mh->msg_controllen = 0;
+	  mh->msg_flags = 0;
 	}
-      else
-	clib_warning ("LDP<%d>: fd %d (0x%x): returning %d (0x%x)",
-		      getpid (), fd, fd, size, size);
     }
-  return size;
+  else
+    {
+      rv = libc_recvmmsg (fd, vmessages, vlen, flags, tmo);
+    }
+
+done:
+  LDBG (2, "fd %d: vlen %u, flags 0x%x, returning %d", fd, vlen, flags, rv);
+
+  return rv;
 }
 #endif
 
@@ -1967,14 +1744,14 @@ int
 getsockopt (int fd, int level, int optname,
 	    void *__restrict optval, socklen_t * __restrict optlen)
 {
-  vcl_session_handle_t vclsh;
+  vls_handle_t vlsh;
   int rv;
 
   if ((errno = -ldp_init ()))
     return -1;
 
-  vclsh = ldp_fd_to_vclsh (fd);
-  if (vclsh != INVALID_SESSION_ID)
+  vlsh = ldp_fd_to_vlsh (fd);
+  if (vlsh != VLS_INVALID_HANDLE)
     {
       rv = -EOPNOTSUPP;
 
@@ -1984,26 +1761,26 @@ getsockopt (int fd, int level, int optname,
 	  switch (optname)
 	    {
 	    case TCP_NODELAY:
-	      rv = vppcom_session_attr (vclsh, VPPCOM_ATTR_GET_TCP_NODELAY,
+	      rv = vls_attr (vlsh, VPPCOM_ATTR_GET_TCP_NODELAY,
 					optval, optlen);
 	      break;
 	    case TCP_MAXSEG:
-	      rv = vppcom_session_attr (vclsh, VPPCOM_ATTR_GET_TCP_USER_MSS,
+	      rv = vls_attr (vlsh, VPPCOM_ATTR_GET_TCP_USER_MSS,
 					optval, optlen);
 	      break;
 	    case TCP_KEEPIDLE:
-	      rv = vppcom_session_attr (vclsh, VPPCOM_ATTR_GET_TCP_KEEPIDLE,
+	      rv = vls_attr (vlsh, VPPCOM_ATTR_GET_TCP_KEEPIDLE,
 					optval, optlen);
 	      break;
 	    case TCP_KEEPINTVL:
-	      rv = vppcom_session_attr (vclsh, VPPCOM_ATTR_GET_TCP_KEEPINTVL,
+	      rv = vls_attr (vlsh, VPPCOM_ATTR_GET_TCP_KEEPINTVL,
 					optval, optlen);
 	      break;
 	    case TCP_INFO:
 	      if (optval && optlen && (*optlen == sizeof (struct tcp_info)))
 		{
-		  LDBG (1, "fd %d: vclsh %u SOL_TCP, TCP_INFO, optval %p, "
-			"optlen %d: #LDP-NOP#", fd, vclsh, optval, *optlen);
+		  LDBG (1, "fd %d: vlsh %u SOL_TCP, TCP_INFO, optval %p, "
+			"optlen %d: #LDP-NOP#", fd, vlsh, optval, *optlen);
 		  memset (optval, 0, *optlen);
 		  rv = VPPCOM_OK;
 		}
@@ -2017,7 +1794,7 @@ getsockopt (int fd, int level, int optname,
 	      break;
 	    default:
 	      LDBG (0, "ERROR: fd %d: getsockopt SOL_TCP: sid %u, "
-		    "optname %d unsupported!", fd, vclsh, optname);
+		    "optname %d unsupported!", fd, vlsh, optname);
 	      break;
 	    }
 	  break;
@@ -2026,12 +1803,12 @@ getsockopt (int fd, int level, int optname,
 	    {
 	    case IPV6_V6ONLY:
 	      rv =
-		vppcom_session_attr (vclsh, VPPCOM_ATTR_GET_V6ONLY, optval,
+		vls_attr (vlsh, VPPCOM_ATTR_GET_V6ONLY, optval,
 				     optlen);
 	      break;
 	    default:
-	      LDBG (0, "ERROR: fd %d: getsockopt SOL_IPV6: vclsh %u "
-		    "optname %d unsupported!", fd, vclsh, optname);
+	      LDBG (0, "ERROR: fd %d: getsockopt SOL_IPV6: vlsh %u "
+		    "optname %d unsupported!", fd, vlsh, optname);
 	      break;
 	    }
 	  break;
@@ -2040,46 +1817,46 @@ getsockopt (int fd, int level, int optname,
 	    {
 	    case SO_ACCEPTCONN:
 	      rv =
-		vppcom_session_attr (vclsh, VPPCOM_ATTR_GET_LISTEN, optval,
+		vls_attr (vlsh, VPPCOM_ATTR_GET_LISTEN, optval,
 				     optlen);
 	      break;
 	    case SO_KEEPALIVE:
 	      rv =
-		vppcom_session_attr (vclsh, VPPCOM_ATTR_GET_KEEPALIVE, optval,
+		vls_attr (vlsh, VPPCOM_ATTR_GET_KEEPALIVE, optval,
 				     optlen);
 	      break;
 	    case SO_PROTOCOL:
 	      rv =
-		vppcom_session_attr (vclsh, VPPCOM_ATTR_GET_PROTOCOL, optval,
+		vls_attr (vlsh, VPPCOM_ATTR_GET_PROTOCOL, optval,
 				     optlen);
 	      *(int *) optval = *(int *) optval ? SOCK_DGRAM : SOCK_STREAM;
 	      break;
 	    case SO_SNDBUF:
-	      rv = vppcom_session_attr (vclsh, VPPCOM_ATTR_GET_TX_FIFO_LEN,
+	      rv = vls_attr (vlsh, VPPCOM_ATTR_GET_TX_FIFO_LEN,
 					optval, optlen);
 	      break;
 	    case SO_RCVBUF:
-	      rv = vppcom_session_attr (vclsh, VPPCOM_ATTR_GET_RX_FIFO_LEN,
+	      rv = vls_attr (vlsh, VPPCOM_ATTR_GET_RX_FIFO_LEN,
 					optval, optlen);
 	      break;
 	    case SO_REUSEADDR:
 	      rv =
-		vppcom_session_attr (vclsh, VPPCOM_ATTR_GET_REUSEADDR, optval,
+		vls_attr (vlsh, VPPCOM_ATTR_GET_REUSEADDR, optval,
 				     optlen);
 	      break;
 	    case SO_BROADCAST:
 	      rv =
-		vppcom_session_attr (vclsh, VPPCOM_ATTR_GET_BROADCAST, optval,
+		vls_attr (vlsh, VPPCOM_ATTR_GET_BROADCAST, optval,
 				     optlen);
 	      break;
 	    case SO_ERROR:
 	      rv =
-		vppcom_session_attr (vclsh, VPPCOM_ATTR_GET_ERROR, optval,
+		vls_attr (vlsh, VPPCOM_ATTR_GET_ERROR, optval,
 				     optlen);
 	      break;
 	    default:
-	      LDBG (0, "ERROR: fd %d: getsockopt SOL_SOCKET: vclsh %u "
-		    "optname %d unsupported!", fd, vclsh, optname);
+	      LDBG (0, "ERROR: fd %d: getsockopt SOL_SOCKET: vlsh %u "
+		    "optname %d unsupported!", fd, vlsh, optname);
 	      break;
 	    }
 	  break;
@@ -2105,14 +1882,14 @@ int
 setsockopt (int fd, int level, int optname,
 	    const void *optval, socklen_t optlen)
 {
-  vcl_session_handle_t vclsh;
+  vls_handle_t vlsh;
   int rv;
 
   if ((errno = -ldp_init ()))
     return -1;
 
-  vclsh = ldp_fd_to_vclsh (fd);
-  if (vclsh != INVALID_SESSION_ID)
+  vlsh = ldp_fd_to_vlsh (fd);
+  if (vlsh != VLS_INVALID_HANDLE)
     {
       rv = -EOPNOTSUPP;
 
@@ -2122,19 +1899,19 @@ setsockopt (int fd, int level, int optname,
 	  switch (optname)
 	    {
 	    case TCP_NODELAY:
-	      rv = vppcom_session_attr (vclsh, VPPCOM_ATTR_SET_TCP_NODELAY,
+	      rv = vls_attr (vlsh, VPPCOM_ATTR_SET_TCP_NODELAY,
 					(void *) optval, &optlen);
 	      break;
 	    case TCP_MAXSEG:
-	      rv = vppcom_session_attr (vclsh, VPPCOM_ATTR_SET_TCP_USER_MSS,
+	      rv = vls_attr (vlsh, VPPCOM_ATTR_SET_TCP_USER_MSS,
 					(void *) optval, &optlen);
 	      break;
 	    case TCP_KEEPIDLE:
-	      rv = vppcom_session_attr (vclsh, VPPCOM_ATTR_SET_TCP_KEEPIDLE,
+	      rv = vls_attr (vlsh, VPPCOM_ATTR_SET_TCP_KEEPIDLE,
 					(void *) optval, &optlen);
 	      break;
 	    case TCP_KEEPINTVL:
-	      rv = vppcom_session_attr (vclsh, VPPCOM_ATTR_SET_TCP_KEEPINTVL,
+	      rv = vls_attr (vlsh, VPPCOM_ATTR_SET_TCP_KEEPINTVL,
 					(void *) optval, &optlen);
 	      break;
 	    case TCP_CONGESTION:
@@ -2143,8 +1920,8 @@ setsockopt (int fd, int level, int optname,
 	      rv = 0;
 	      break;
 	    default:
-	      LDBG (0, "ERROR: fd %d: setsockopt() SOL_TCP: vclsh %u"
-		    "optname %d unsupported!", fd, vclsh, optname);
+	      LDBG (0, "ERROR: fd %d: setsockopt() SOL_TCP: vlsh %u"
+		    "optname %d unsupported!", fd, vlsh, optname);
 	      break;
 	    }
 	  break;
@@ -2152,12 +1929,12 @@ setsockopt (int fd, int level, int optname,
 	  switch (optname)
 	    {
 	    case IPV6_V6ONLY:
-	      rv = vppcom_session_attr (vclsh, VPPCOM_ATTR_SET_V6ONLY,
+	      rv = vls_attr (vlsh, VPPCOM_ATTR_SET_V6ONLY,
 					(void *) optval, &optlen);
 	      break;
 	    default:
-	      LDBG (0, "ERROR: fd %d: setsockopt SOL_IPV6: vclsh %u"
-		    "optname %d unsupported!", fd, vclsh, optname);
+	      LDBG (0, "ERROR: fd %d: setsockopt SOL_IPV6: vlsh %u"
+		    "optname %d unsupported!", fd, vlsh, optname);
 	      break;
 	    }
 	  break;
@@ -2165,20 +1942,20 @@ setsockopt (int fd, int level, int optname,
 	  switch (optname)
 	    {
 	    case SO_KEEPALIVE:
-	      rv = vppcom_session_attr (vclsh, VPPCOM_ATTR_SET_KEEPALIVE,
+	      rv = vls_attr (vlsh, VPPCOM_ATTR_SET_KEEPALIVE,
 					(void *) optval, &optlen);
 	      break;
 	    case SO_REUSEADDR:
-	      rv = vppcom_session_attr (vclsh, VPPCOM_ATTR_SET_REUSEADDR,
+	      rv = vls_attr (vlsh, VPPCOM_ATTR_SET_REUSEADDR,
 					(void *) optval, &optlen);
 	      break;
 	    case SO_BROADCAST:
-	      rv = vppcom_session_attr (vclsh, VPPCOM_ATTR_SET_BROADCAST,
+	      rv = vls_attr (vlsh, VPPCOM_ATTR_SET_BROADCAST,
 					(void *) optval, &optlen);
 	      break;
 	    default:
-	      LDBG (0, "ERROR: fd %d: setsockopt SOL_SOCKET: vclsh %u "
-		    "optname %d unsupported!", fd, vclsh, optname);
+	      LDBG (0, "ERROR: fd %d: setsockopt SOL_SOCKET: vlsh %u "
+		    "optname %d unsupported!", fd, vlsh, optname);
 	      break;
 	    }
 	  break;
@@ -2203,20 +1980,19 @@ setsockopt (int fd, int level, int optname,
 int
 listen (int fd, int n)
 {
-  vcl_session_handle_t vclsh;
-vcl_worker_t *wrk = vcl_worker_get_current();
+  vls_handle_t vlsh;
   int rv;
 
   if ((errno = -ldp_init ()))
     return -1;
 
-  vclsh = ldp_fd_to_vclsh (fd);
-  if (vclsh != INVALID_SESSION_ID)
+  vlsh = ldp_fd_to_vlsh (fd);
+  if (vlsh != VLS_INVALID_HANDLE)
     {
-      LDBG (0, "fd %d: calling vppcom_session_listen: vclsh %u, n %d", fd,
-	    vclsh, n);
+      LDBG (0, "fd %d: calling vls_listen: vlsh %u, n %d", fd,
+	    vlsh, n);
 
-      rv = vppcom_session_listen (vclsh, n);
+      rv = vls_listen (vlsh, n);
       if (rv != VPPCOM_OK)
 	{
 	  errno = -rv;
@@ -2230,38 +2006,34 @@ vcl_worker_t *wrk = vcl_worker_get_current();
     }
 
   LDBG (1, "fd %d: returning %d", fd, rv);
-/*Update listen info in vcl worker*/
-wrk->listen_fd = fd;
-wrk->listen_queue_size = n;
-wrk->listen_session_index = vppcom_session_index(vclsh);
   return rv;
 }
 
 static inline int
-ldp_accept4 (int listen_fd, __SOCKADDR_ARG addr,
+ldp_accept4 (int listen_fd, struct sockaddr *addr,
 	     socklen_t * __restrict addr_len, int flags)
 {
-  vcl_session_handle_t listen_vclsh, accept_vclsh;
+  vls_handle_t listen_vlsh, accept_vlsh;
   int rv;
 
   if ((errno = -ldp_init ()))
     return -1;
 
-  listen_vclsh = ldp_fd_to_vclsh (listen_fd);
-  if (listen_vclsh != INVALID_SESSION_ID)
+  listen_vlsh = ldp_fd_to_vlsh (listen_fd);
+  if (listen_vlsh != VLS_INVALID_HANDLE)
     {
       vppcom_endpt_t ep;
       u8 src_addr[sizeof (struct sockaddr_in6)];
       memset (&ep, 0, sizeof (ep));
       ep.ip = src_addr;
 
-      LDBG (0, "listen fd %d: calling vppcom_session_accept: listen sid %u,"
-	    " ep %p, flags 0x%x", listen_fd, listen_vclsh, ep, flags);
+      LDBG (0, "listen fd %d: calling vls_accept: listen sid %u,"
+	    " ep %p, flags 0x%x", listen_fd, listen_vlsh, ep, flags);
 
-      accept_vclsh = vppcom_session_accept (listen_vclsh, &ep, flags);
-      if (accept_vclsh < 0)
+      accept_vlsh = vls_accept (listen_vlsh, &ep, flags);
+      if (accept_vlsh < 0)
 	{
-	  errno = -accept_vclsh;
+	  errno = -accept_vlsh;
 	  rv = -1;
 	}
       else
@@ -2269,13 +2041,13 @@ ldp_accept4 (int listen_fd, __SOCKADDR_ARG addr,
 	  rv = ldp_copy_ep_to_sockaddr (addr, addr_len, &ep);
 	  if (rv != VPPCOM_OK)
 	    {
-	      (void) vppcom_session_close (accept_vclsh);
+	      (void) vls_close (accept_vlsh);
 	      errno = -rv;
 	      rv = -1;
 	    }
 	  else
 	    {
-	      rv = ldp_vclsh_to_fd (accept_vclsh);
+	      rv = ldp_vlsh_to_fd (accept_vlsh);
 	    }
 	}
     }
@@ -2296,38 +2068,38 @@ int
 accept4 (int fd, __SOCKADDR_ARG addr, socklen_t * __restrict addr_len,
 	 int flags)
 {
-  return ldp_accept4 (fd, addr, addr_len, flags);
+  return ldp_accept4 (fd, SOCKADDR_GET_SA (addr), addr_len, flags);
 }
 
 int
 accept (int fd, __SOCKADDR_ARG addr, socklen_t * __restrict addr_len)
 {
-  return ldp_accept4 (fd, addr, addr_len, 0);
+  return ldp_accept4 (fd, SOCKADDR_GET_SA (addr), addr_len, 0);
 }
 
 int
 shutdown (int fd, int how)
 {
-  vcl_session_handle_t vclsh;
+  vls_handle_t vlsh;
   int rv = 0, flags;
   u32 flags_len = sizeof (flags);
 
   if ((errno = -ldp_init ()))
     return -1;
 
-  vclsh = ldp_fd_to_vclsh (fd);
-  if (vclsh != INVALID_SESSION_ID)
+  vlsh = ldp_fd_to_vlsh (fd);
+  if (vlsh != VLS_INVALID_HANDLE)
     {
-      LDBG (0, "called shutdown: fd %u vclsh %u how %d", fd, vclsh, how);
+      LDBG (0, "called shutdown: fd %u vlsh %u how %d", fd, vlsh, how);
 
-      if (vppcom_session_attr (vclsh, VPPCOM_ATTR_SET_SHUT, &how, &flags_len))
+      if (vls_attr (vlsh, VPPCOM_ATTR_SET_SHUT, &how, &flags_len))
 	{
 	  close (fd);
 	  return -1;
 	}
 
-      if (vppcom_session_attr
-	  (vclsh, VPPCOM_ATTR_GET_SHUT, &flags, &flags_len))
+      if (vls_attr
+	  (vlsh, VPPCOM_ATTR_GET_SHUT, &flags, &flags_len))
 	{
 	  close (fd);
 	  return -1;
@@ -2348,21 +2120,18 @@ shutdown (int fd, int how)
 int
 epoll_create1 (int flags)
 {
-  ldp_worker_ctx_t *ldpw = ldp_worker_get_current ();
-  vcl_session_handle_t vclsh;
+  ldp_worker_ctx_t *ldpw;
+  vls_handle_t vlsh;
   int rv;
 
   if ((errno = -ldp_init ()))
     return -1;
 
-  if (ldp->vcl_needs_real_epoll)
+  if (ldp->vcl_needs_real_epoll || vls_use_real_epoll ())
     {
       /* Make sure workers have been allocated */
-      if (!ldp->workers)
-	{
-	  ldp_alloc_workers ();
-	  ldpw = ldp_worker_get_current ();
-	}
+      ldp_alloc_workers ();
+      ldpw = ldp_worker_get_current ();
       rv = libc_epoll_create1 (flags);
       ldp->vcl_needs_real_epoll = 0;
       ldpw->vcl_mq_epfd = rv;
@@ -2370,17 +2139,17 @@ epoll_create1 (int flags)
       return rv;
     }
 
-  vclsh = vppcom_epoll_create ();
-  if (PREDICT_FALSE (vclsh == INVALID_SESSION_ID))
+  vlsh = vls_epoll_create ();
+  if (PREDICT_FALSE (vlsh == VLS_INVALID_HANDLE))
     {
-      errno = -vclsh;
+      errno = -vlsh;
       rv = -1;
     }
   else
     {
-      rv = ldp_vclsh_to_fd (vclsh);
+      rv = ldp_vlsh_to_fd (vlsh);
     }
-  LDBG (0, "epoll_create epfd %u vclsh %u", rv, vclsh);
+  LDBG (0, "epoll_create epfd %u vlsh %u", rv, vlsh);
   return rv;
 }
 
@@ -2393,14 +2162,14 @@ epoll_create (int size)
 int
 epoll_ctl (int epfd, int op, int fd, struct epoll_event *event)
 {
-  vcl_session_handle_t vep_vclsh, vclsh;
+  vls_handle_t vep_vlsh, vlsh;
   int rv;
 
   if ((errno = -ldp_init ()))
     return -1;
 
-  vep_vclsh = ldp_fd_to_vclsh (epfd);
-  if (PREDICT_FALSE (vep_vclsh == INVALID_SESSION_ID))
+  vep_vlsh = ldp_fd_to_vlsh (epfd);
+  if (PREDICT_FALSE (vep_vlsh == VLS_INVALID_HANDLE))
     {
       /* The LDP epoll_create1 always creates VCL epfd's.
        * The app should never have a kernel base epoll fd unless it
@@ -2414,18 +2183,18 @@ epoll_ctl (int epfd, int op, int fd, struct epoll_event *event)
       goto done;
     }
 
-  vclsh = ldp_fd_to_vclsh (fd);
+  vlsh = ldp_fd_to_vlsh (fd);
 
-  LDBG (0, "epfd %d ep_vclsh %d, fd %u vclsh %d, op %u", epfd, vep_vclsh, fd,
-	vclsh, op);
+  LDBG (0, "epfd %d ep_vlsh %d, fd %u vlsh %d, op %u", epfd, vep_vlsh, fd,
+	vlsh, op);
 
-  if (vclsh != INVALID_SESSION_ID)
+  if (vlsh != VLS_INVALID_HANDLE)
     {
       LDBG (1,
-	    "epfd %d: calling vppcom_epoll_ctl: ep_vclsh %d op %d, vclsh %u,"
-	    " event %p", epfd, vep_vclsh, vclsh, event);
+	    "epfd %d: calling vls_epoll_ctl: ep_vlsh %d op %d, vlsh %u,"
+	    " event %p", epfd, vep_vlsh, vlsh, event);
 
-      rv = vppcom_epoll_ctl (vep_vclsh, op, vclsh, event);
+      rv = vls_epoll_ctl (vep_vlsh, op, vlsh, event);
       if (rv != VPPCOM_OK)
 	{
 	  errno = -rv;
@@ -2438,11 +2207,11 @@ epoll_ctl (int epfd, int op, int fd, struct epoll_event *event)
       u32 size = sizeof (epfd);
 
       libc_epfd =
-	vppcom_session_attr (vep_vclsh, VPPCOM_ATTR_GET_LIBC_EPFD, 0, 0);
+	vls_attr (vep_vlsh, VPPCOM_ATTR_GET_LIBC_EPFD, 0, 0);
       if (!libc_epfd)
 	{
-	  LDBG (1, "epfd %d, vep_vclsh %d calling libc_epoll_create1: "
-		"EPOLL_CLOEXEC", epfd, vep_vclsh);
+	  LDBG (1, "epfd %d, vep_vlsh %d calling libc_epoll_create1: "
+		"EPOLL_CLOEXEC", epfd, vep_vlsh);
 
 	  libc_epfd = libc_epoll_create1 (EPOLL_CLOEXEC);
 	  if (libc_epfd < 0)
@@ -2452,7 +2221,7 @@ epoll_ctl (int epfd, int op, int fd, struct epoll_event *event)
 	    }
 
 	  rv =
-	    vppcom_session_attr (vep_vclsh, VPPCOM_ATTR_SET_LIBC_EPFD,
+	    vls_attr (vep_vlsh, VPPCOM_ATTR_SET_LIBC_EPFD,
 				 &libc_epfd, &size);
 	  if (rv < 0)
 	    {
@@ -2485,7 +2254,7 @@ ldp_epoll_pwait (int epfd, struct epoll_event *events, int maxevents,
   ldp_worker_ctx_t *ldpw = ldp_worker_get_current ();
   double time_to_wait = (double) 0, max_time;
   int libc_epfd, rv = 0;
-  vcl_session_handle_t ep_vclsh;
+  vls_handle_t ep_vlsh;
 
   if ((errno = -ldp_init ()))
     return -1;
@@ -2499,10 +2268,10 @@ ldp_epoll_pwait (int epfd, struct epoll_event *events, int maxevents,
   if (epfd == ldpw->vcl_mq_epfd)
     return libc_epoll_pwait (epfd, events, maxevents, timeout, sigmask);
 
-  ep_vclsh = ldp_fd_to_vclsh (epfd);
-  if (PREDICT_FALSE (ep_vclsh == INVALID_SESSION_ID))
+  ep_vlsh = ldp_fd_to_vlsh (epfd);
+  if (PREDICT_FALSE (ep_vlsh == VLS_INVALID_HANDLE))
     {
-      LDBG (0, "epfd %d: bad ep_vclsh %d!", epfd, ep_vclsh);
+      LDBG (0, "epfd %d: bad ep_vlsh %d!", epfd, ep_vlsh);
       errno = EBADFD;
       return -1;
     }
@@ -2512,7 +2281,7 @@ ldp_epoll_pwait (int epfd, struct epoll_event *events, int maxevents,
   time_to_wait = ((timeout >= 0) ? (double) timeout / 1000 : 0);
   max_time = clib_time_now (&ldpw->clib_time) + time_to_wait;
 
-  libc_epfd = vppcom_session_attr (ep_vclsh, VPPCOM_ATTR_GET_LIBC_EPFD, 0, 0);
+  libc_epfd = vls_attr (ep_vlsh, VPPCOM_ATTR_GET_LIBC_EPFD, 0, 0);
   if (PREDICT_FALSE (libc_epfd < 0))
     {
       errno = -libc_epfd;
@@ -2521,13 +2290,13 @@ ldp_epoll_pwait (int epfd, struct epoll_event *events, int maxevents,
     }
 
   LDBG (2, "epfd %d: vep_idx %d, libc_epfd %d, events %p, maxevents %d, "
-	"timeout %d, sigmask %p: time_to_wait %.02f", epfd, ep_vclsh,
+	"timeout %d, sigmask %p: time_to_wait %.02f", epfd, ep_vlsh,
 	libc_epfd, events, maxevents, timeout, sigmask, time_to_wait);
   do
     {
       if (!ldpw->epoll_wait_vcl)
 	{
-	  rv = vppcom_epoll_wait (ep_vclsh, events, maxevents, 0);
+	  rv = vls_epoll_wait (ep_vlsh, events, maxevents, 0);
 	  if (rv > 0)
 	    {
 	      ldpw->epoll_wait_vcl = 1;
@@ -2574,7 +2343,7 @@ poll (struct pollfd *fds, nfds_t nfds, int timeout)
 {
   ldp_worker_ctx_t *ldpw = ldp_worker_get_current ();
   int rv, i, n_revents = 0;
-  vcl_session_handle_t vclsh;
+  vls_handle_t vlsh;
   vcl_poll_t *vp;
   double max_time;
 
@@ -2591,13 +2360,13 @@ poll (struct pollfd *fds, nfds_t nfds, int timeout)
       if (fds[i].fd < 0)
 	continue;
 
-      vclsh = ldp_fd_to_vclsh (fds[i].fd);
-      if (vclsh != INVALID_SESSION_ID)
+      vlsh = ldp_fd_to_vlsh (fds[i].fd);
+      if (vlsh != VLS_INVALID_HANDLE)
 	{
 	  fds[i].fd = -fds[i].fd;
 	  vec_add2 (ldpw->vcl_poll, vp, 1);
 	  vp->fds_ndx = i;
-	  vp->sh = vclsh;
+	  vp->sh = vlsh_to_sh (vlsh);
 	  vp->events = fds[i].events;
 #ifdef __USE_XOPEN2K
 	  if (fds[i].events & POLLRDNORM)
@@ -2618,7 +2387,7 @@ poll (struct pollfd *fds, nfds_t nfds, int timeout)
     {
       if (vec_len (ldpw->vcl_poll))
 	{
-	  rv = vppcom_poll (ldpw->vcl_poll, vec_len (ldpw->vcl_poll), 0);
+	  rv = vls_poll (ldpw->vcl_poll, vec_len (ldpw->vcl_poll), 0);
 	  if (rv < 0)
 	    {
 	      errno = -rv;
@@ -55,6 +55,7 @@
    is set.
 */
 
+#define _GNU_SOURCE
 #include <signal.h>
 #include <dlfcn.h>
 
@@ -270,6 +271,11 @@ typedef int (*__libc_poll) (struct pollfd * __fds, nfds_t __nfds,
 typedef int (*__libc_ppoll) (struct pollfd * __fds, nfds_t __nfds,
 			     const struct timespec * __timeout,
 			     const __sigset_t * __ss);
+typedef int (*__libc_sendmmsg) (int sockfd, struct mmsghdr * vmessages,
+				unsigned int vlen, int flags);
+typedef int (*__libc_recvmmsg) (int sockfd, struct mmsghdr * vmessages,
+				unsigned int vlen, int flags,
+				struct timespec * tmo);
 #endif
 
 
@@ -344,6 +350,8 @@ struct swrap_libc_symbols
   SWRAP_SYMBOL_ENTRY (poll);
 #ifdef __USE_GNU
   SWRAP_SYMBOL_ENTRY (ppoll);
+  SWRAP_SYMBOL_ENTRY (sendmmsg);
+  SWRAP_SYMBOL_ENTRY (recvmmsg);
 #endif
 };
 
@@ -844,6 +852,26 @@ libc_ppoll (struct pollfd *__fds, nfds_t __nfds,
 
   return swrap.libc.symbols._libc_ppoll.f (__fds, __nfds, __timeout, __ss);
 }
+
+int
+libc_sendmmsg (int sockfd, struct mmsghdr *vmessages, unsigned int vlen,
+	       int flags)
+{
+  swrap_bind_symbol_libc (sendmmsg);
+
+  return swrap.libc.symbols._libc_sendmmsg.f (sockfd, vmessages, vlen,
+					      flags);
+}
+
+int
+libc_recvmmsg (int sockfd, struct mmsghdr *vmessages, unsigned int vlen,
+	       int flags, struct timespec *tmo)
+{
+  swrap_bind_symbol_libc (recvmmsg);
+
+  return swrap.libc.symbols._libc_recvmmsg.f (sockfd, vmessages, vlen, flags,
+					      tmo);
+}
 #endif
 
 static void
@@ -218,6 +218,12 @@ int libc_poll (struct pollfd *__fds, nfds_t __nfds, int __timeout);
 #ifdef __USE_GNU
 int libc_ppoll (struct pollfd *__fds, nfds_t __nfds,
 		const struct timespec *__timeout, const __sigset_t * __ss);
+
+int libc_sendmmsg (int sockfd, struct mmsghdr *vmessages, unsigned int vlen,
+		   int flags);
+
+int libc_recvmmsg (int sockfd, struct mmsghdr *vmessages, unsigned int vlen,
+		   int flags, struct timespec *tmo);
 #endif
 
 void swrap_constructor (void);
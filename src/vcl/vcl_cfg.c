@@ -500,6 +500,12 @@ vppcom_cfg_read_file (char *conf_fname)
 	      VCFG_DBG (0, "VCL<%d>: configured with mq with eventfd",
 			getpid ());
 	    }
+	  else if (unformat (line_input, "multi-thread-workers"))
+	    {
+	      vcl_cfg->mt_wrk_supported = 1;
+	      VCFG_DBG (0, "VCL<%d>: configured with multi-thread workers",
+			getpid ());
+	    }
 	  else if (unformat (line_input, "}"))
 	    {
 	      vc_cfg_input = 0;
@@ -24,6 +24,7 @@ typedef struct vcl_locked_session_
   u32 vls_index;
   u32 *workers_subscribed;
   clib_bitmap_t *listeners;
+  u32 *mt_listeners;		/**< listener clones, by vcl worker index */
 } vcl_locked_session_t;
 
 typedef struct vls_local_
@@ -37,40 +38,51 @@ typedef struct vls_local_
 } vls_process_local_t;
 
 static vls_process_local_t vls_local;
-static vls_process_local_t *vlsl = &vls_local;
+static vls_process_local_t *vls_mt_wrk_local = &vls_local;
+#define vlsl vls_mt_wrk_local
 
-typedef struct vls_main_
+typedef struct vls_pending_cleanup_
 {
-  vcl_locked_session_t *vls_pool;
-  clib_rwlock_t vls_table_lock;
-  uword *session_index_to_vlsh_table;
-} vls_main_t;
-
-vls_main_t *vlsm;
+  u32 session_index;
+  u8 do_disconnect;
+} vls_pending_cleanup_t;
 
-static inline void
-vls_table_rlock (void)
+typedef struct vls_worker_
 {
-  clib_rwlock_reader_lock (&vlsm->vls_table_lock);
-}
+  /** Sessions other threads left behind in this worker */
+  vls_pending_cleanup_t *pending_cleanups;
+  clib_spinlock_t pending_lock;
+} vls_worker_t;
 
-static inline void
-vls_table_runlock (void)
-{
-  clib_rwlock_reader_unlock (&vlsm->vls_table_lock);
-}
+/*
+ * Locked sessions live in fixed size pages that are never freed or moved,
+ * so handles are resolved without a table lock. A vls is valid only as
+ * long as its vls_index matches the handle it was looked up with.
+ */
+#define VLS_TABLE_PAGE_BITS	10
+#define VLS_TABLE_PAGE_SIZE	(1 << VLS_TABLE_PAGE_BITS)
+#define VLS_TABLE_PAGE_MASK	(VLS_TABLE_PAGE_SIZE - 1)
+#define VLS_TABLE_MAX_PAGES	1024
+#define VLS_TABLE_MAX_SIZE	(VLS_TABLE_MAX_PAGES << VLS_TABLE_PAGE_BITS)
 
-static inline void
-vls_table_wlock (void)
+typedef struct vls_main_
 {
-  clib_rwlock_writer_lock (&vlsm->vls_table_lock);
-}
+  vcl_locked_session_t *vls_pages[VLS_TABLE_MAX_PAGES];
 
-static inline void
-vls_table_wunlock (void)
-{
-  clib_rwlock_writer_unlock (&vlsm->vls_table_lock);
-}
+  /** Handles not yet used */
+  u32 n_vls;
+
+  /** Freed handles */
+  u32 *vls_free_list;
+
+  /** Serializes vls allocs and frees. Lookups do not need it */
+  clib_spinlock_t vls_alloc_lock;
+
+  /** Per vcl worker state, only used with multi-thread workers */
+  vls_worker_t *workers;
+} vls_main_t;
+
+vls_main_t *vlsm;
 
 typedef enum
 {
@@ -86,9 +98,32 @@ typedef enum
   VLS_MT_LOCK_SPOOL = 1 << 1
 } vls_mt_lock_type_t;
 
+static inline u8
+vls_mt_wrk_supported (void)
+{
+  return vcm->cfg.mt_wrk_supported;
+}
+
 static void
 vls_mt_add (void)
 {
+  /* With multi-thread workers every thread gets its own vcl worker and
+   * message queue, so it needs no mq locks. If that fails, fall back to
+   * sharing the process worker */
+  if (vls_mt_wrk_supported ())
+    {
+      if (vppcom_worker_register () == VPPCOM_OK)
+	return;
+      VERR ("failed to register worker for thread, sharing worker %u",
+	    vlsl->vls_wrk_index);
+      /* Worker may have been allocated before registration failed */
+      if (vcl_get_worker_index () != ~0)
+	{
+	  vcl_worker_cleanup (vcl_worker_get_current (), 0 /* notify vpp */ );
+	  vcl_set_worker_index (~0);
+	}
+    }
+
   vlsl->vls_mt_n_threads += 1;
   vcl_set_worker_index (vlsl->vls_wrk_index);
 }
@@ -124,104 +159,464 @@ vls_mt_locks_init (void)
   pthread_mutex_init (&vlsl->vls_mt_spool_mlock, NULL);
 }
 
-static inline vcl_session_handle_t
-vls_to_sh (vcl_locked_session_t * vls)
+static inline vcl_locked_session_t *
+vls_table_elt (u32 vls_index)
 {
-  return vcl_session_handle_from_index (vls->session_index);
+  vcl_locked_session_t *page;
+  page = clib_atomic_load_acq_n (&vlsm->vls_pages[vls_index >>
+						  VLS_TABLE_PAGE_BITS]);
+  return page ? &page[vls_index & VLS_TABLE_PAGE_MASK] : 0;
+}
+
+static void
+vls_table_page_alloc (u32 page_index)
+{
+  vcl_locked_session_t *page;
+  int i;
+
+  page = clib_mem_alloc_aligned (VLS_TABLE_PAGE_SIZE * sizeof (*page),
+				 CLIB_CACHE_LINE_BYTES);
+  clib_memset (page, 0, VLS_TABLE_PAGE_SIZE * sizeof (*page));
+  for (i = 0; i < VLS_TABLE_PAGE_SIZE; i++)
+    {
+      clib_spinlock_init (&page[i].lock);
+      page[i].vls_index = ~0;
+    }
+  clib_atomic_store_rel_n (&vlsm->vls_pages[page_index], page);
+}
+
+static inline void
+vls_lock (vcl_locked_session_t * vls)
+{
+  clib_spinlock_lock (&vls->lock);
+}
+
+static inline void
+vls_unlock (vcl_locked_session_t * vls)
+{
+  clib_spinlock_unlock (&vls->lock);
 }
 
 static inline vcl_session_handle_t
-vls_to_sh_tu (vcl_locked_session_t * vls)
+vls_to_sh (vcl_locked_session_t * vls)
 {
-  vcl_session_handle_t sh;
-  sh = vls_to_sh (vls);
-  vls_table_runlock ();
-  return sh;
+  u32 wrk_index = vcl_get_worker_index ();
+
+  if (PREDICT_FALSE (vls->worker_index != wrk_index
+		     && vls_mt_wrk_supported ()))
+    {
+      if (wrk_index < vec_len (vls->mt_listeners)
+	  && vls->mt_listeners[wrk_index] != ~0)
+	return vcl_session_handle_from_index (vls->mt_listeners[wrk_index]);
+      return INVALID_SESSION_ID;
+    }
+  return vcl_session_handle_from_index (vls->session_index);
 }
 
 static vls_handle_t
 vls_alloc (vcl_session_handle_t sh)
 {
   vcl_locked_session_t *vls;
+  vcl_session_t *s;
+  u32 vls_index;
+
+  clib_spinlock_lock (&vlsm->vls_alloc_lock);
+  if (vec_len (vlsm->vls_free_list))
+    {
+      vls_index = vec_pop (vlsm->vls_free_list);
+    }
+  else
+    {
+      if (PREDICT_FALSE (vlsm->n_vls == VLS_TABLE_MAX_SIZE))
+	{
+	  clib_spinlock_unlock (&vlsm->vls_alloc_lock);
+	  return VLS_INVALID_HANDLE;
+	}
+      vls_index = vlsm->n_vls++;
+      if (!(vls_index & VLS_TABLE_PAGE_MASK))
+	vls_table_page_alloc (vls_index >> VLS_TABLE_PAGE_BITS);
+    }
+  clib_spinlock_unlock (&vlsm->vls_alloc_lock);
 
-  vls_table_wlock ();
-  pool_get (vlsm->vls_pool, vls);
+  vls = vls_table_elt (vls_index);
+  vls_lock (vls);
   vls->session_index = vppcom_session_index (sh);
   vls->worker_index = vppcom_session_worker (sh);
-  vls->vls_index = vls - vlsm->vls_pool;
-  hash_set (vlsm->session_index_to_vlsh_table, vls->session_index,
-	    vls->vls_index);
-  clib_spinlock_init (&vls->lock);
-  vls_table_wunlock ();
-  return vls->vls_index;
+  s = vcl_session_get (vcl_worker_get_current (), vls->session_index);
+  s->vls_index = vls_index;
+  clib_atomic_store_rel_n (&vls->vls_index, vls_index);
+  vls_unlock (vls);
+
+  return vls_index;
 }
 
 static vcl_locked_session_t *
 vls_get (vls_handle_t vlsh)
 {
-  if (pool_is_free_index (vlsm->vls_pool, vlsh))
+  vcl_locked_session_t *vls;
+
+  if (PREDICT_FALSE ((u32) vlsh >= VLS_TABLE_MAX_SIZE))
     return 0;
-  return pool_elt_at_index (vlsm->vls_pool, vlsh);
+  vls = vls_table_elt (vlsh);
+  if (!vls || clib_atomic_load_acq_n (&vls->vls_index) != vlsh)
+    return 0;
+  return vls;
 }
 
+/**
+ * Free locked session. Must be called with the vls locked and releases
+ * the lock, as handles may be reused as soon as they hit the free list.
+ */
 static void
 vls_free (vcl_locked_session_t * vls)
 {
+  u32 vls_index = vls->vls_index;
+
   ASSERT (vls != 0);
-  hash_unset (vlsm->session_index_to_vlsh_table, vls->session_index);
-  clib_spinlock_free (&vls->lock);
-  pool_put (vlsm->vls_pool, vls);
+  vec_free (vls->workers_subscribed);
+  clib_bitmap_free (vls->listeners);
+  vec_free (vls->mt_listeners);
+  clib_atomic_store_rel_n (&vls->vls_index, ~0);
+  vls_unlock (vls);
+
+  clib_spinlock_lock (&vlsm->vls_alloc_lock);
+  vec_add1 (vlsm->vls_free_list, vls_index);
+  clib_spinlock_unlock (&vlsm->vls_alloc_lock);
 }
 
 static vcl_locked_session_t *
 vls_get_and_lock (vls_handle_t vlsh)
 {
   vcl_locked_session_t *vls;
-  if (pool_is_free_index (vlsm->vls_pool, vlsh))
+
+  if (!(vls = vls_get (vlsh)))
     return 0;
-  vls = pool_elt_at_index (vlsm->vls_pool, vlsh);
-  clib_spinlock_lock (&vls->lock);
+  vls_lock (vls);
+
+  /* Could have been freed while we waited for the lock */
+  if (PREDICT_FALSE (vls->vls_index != vlsh))
+    {
+      vls_unlock (vls);
+      return 0;
+    }
   return vls;
 }
 
-static vcl_locked_session_t *
-vls_get_w_dlock (vls_handle_t vlsh)
+static void
+vls_mt_session_cleanup_defer (u32 wrk_index, u32 session_index,
+			      u8 do_disconnect)
 {
-  vcl_locked_session_t *vls;
-  vls_table_rlock ();
-  vls = vls_get_and_lock (vlsh);
-  if (!vls)
-    vls_table_runlock ();
-  return vls;
+  vls_worker_t *vlsw = &vlsm->workers[wrk_index];
+  vls_pending_cleanup_t *pc;
+
+  clib_spinlock_lock (&vlsw->pending_lock);
+  vec_add2 (vlsw->pending_cleanups, pc, 1);
+  pc->session_index = session_index;
+  pc->do_disconnect = do_disconnect;
+  clib_spinlock_unlock (&vlsw->pending_lock);
 }
 
-static inline void
-vls_lock (vcl_locked_session_t * vls)
+static void
+vls_mt_handle_pending_cleanups (void)
 {
-  clib_spinlock_lock (&vls->lock);
+  vcl_worker_t *wrk = vcl_worker_get_current ();
+  vls_pending_cleanup_t *pending, *pc;
+  vls_worker_t *vlsw;
+  vcl_session_t *s;
+
+  vlsw = &vlsm->workers[wrk->wrk_index];
+  if (PREDICT_TRUE (clib_atomic_load_acq_n (&vlsw->pending_cleanups) == 0))
+    return;
+
+  clib_spinlock_lock (&vlsw->pending_lock);
+  pending = vlsw->pending_cleanups;
+  vlsw->pending_cleanups = 0;
+  clib_spinlock_unlock (&vlsw->pending_lock);
+
+  vec_foreach (pc, pending)
+  {
+    if (!(s = vcl_session_get (wrk, pc->session_index)))
+      continue;
+    vcl_session_cleanup (wrk, s, vcl_session_handle (s), pc->do_disconnect);
+  }
+  vec_free (pending);
 }
 
 static inline void
-vls_unlock (vcl_locked_session_t * vls)
+vls_mt_detect (void)
 {
-  clib_spinlock_unlock (&vls->lock);
+  if (PREDICT_FALSE (vcl_get_worker_index () == ~0))
+    vls_mt_add ();
+  if (vls_mt_wrk_supported ())
+    vls_mt_handle_pending_cleanups ();
 }
 
-static inline void
-vls_get_and_unlock (vls_handle_t vlsh)
+/**
+ * Copy session of other worker, i.e., other thread
+ */
+static int
+vls_mt_session_copy (vcl_locked_session_t * vls, vcl_session_t * s)
+{
+  vcl_worker_t *owner_wrk;
+  vcl_session_t *os;
+
+  if (!(owner_wrk = vcl_worker_get_if_valid (vls->worker_index)))
+    return VPPCOM_EBADFD;
+
+  /* Owner could be handling events for the session or growing its
+   * session pool */
+  clib_spinlock_lock (&owner_wrk->mq_evt_lock);
+  clib_spinlock_lock (&owner_wrk->sessions_lock);
+  if ((os = vcl_session_get (owner_wrk, vls->session_index)))
+    clib_memcpy_fast (s, os, sizeof (*s));
+  clib_spinlock_unlock (&owner_wrk->sessions_lock);
+  clib_spinlock_unlock (&owner_wrk->mq_evt_lock);
+
+  return os ? VPPCOM_OK : VPPCOM_EBADFD;
+}
+
+static inline u8
+vls_mt_session_is_clonable (vcl_session_t * s)
+{
+  /* Datagram listeners own fifos, so they are moved instead */
+  return ((s->session_state & STATE_LISTEN) && !s->is_dgram);
+}
+
+static inline u8
+vls_mt_session_can_migrate (vcl_session_t * s)
+{
+  /* Sessions are not moved out of epoll sets and epoll sets with
+   * registered sessions are not moved. Cut-through sessions are not
+   * known by vpp's session layer so they cannot change owner. */
+  return !(s->is_vep_session || vcl_session_is_ct (s)
+	   || (s->is_vep && s->vep.next_sh != ~0));
+}
+
+/**
+ * Listen on current worker with a copy of the listener
+ */
+static int
+vls_mt_listener_clone (vcl_locked_session_t * vls, vcl_session_t * ls)
+{
+  vcl_worker_t *wrk = vcl_worker_get_current ();
+  u32 session_index;
+  vcl_session_t *s;
+  int rv;
+
+  s = vcl_session_alloc (wrk);
+  session_index = s->session_index;
+  clib_memcpy_fast (s, ls, sizeof (*s));
+  s->session_index = session_index;
+  s->session_state = STATE_START;
+  s->vpp_handle = ~0;
+  s->rx_fifo = s->tx_fifo = 0;
+  s->accept_evts_fifo = 0;
+  s->is_vep_session = 0;
+  clib_memset (&s->vep, 0, sizeof (s->vep));
+
+  rv = vppcom_session_listen (vcl_session_handle (s), ~0);
+  if (rv)
+    {
+      VDBG (0, "vls %u: listen on worker %u failed: %d", vls->vls_index,
+	    wrk->wrk_index, rv);
+      vcl_session_free (wrk, vcl_session_get (wrk, session_index));
+      return rv;
+    }
+
+  vec_validate_init_empty (vls->mt_listeners, wrk->wrk_index, ~0);
+  vls->mt_listeners[wrk->wrk_index] = session_index;
+
+  VDBG (1, "vls %u: listener cloned to session %u worker %u",
+	vls->vls_index, session_index, wrk->wrk_index);
+
+  return VPPCOM_OK;
+}
+
+/**
+ * Move session to current worker
+ *
+ * The session is copied into the current worker's pool and, if it has
+ * vpp state, vpp is asked to change its owner, which also moves its
+ * fifos. The original copy is freed by its worker.
+ */
+static int
+vls_mt_session_migrate (vcl_locked_session_t * vls, vcl_session_t * src)
+{
+  vcl_worker_t *wrk = vcl_worker_get_current ();
+  u32 session_index;
+  vcl_session_t *s;
+  int rv;
+
+  s = vcl_session_alloc (wrk);
+  session_index = s->session_index;
+  clib_memcpy_fast (s, src, sizeof (*s));
+  s->session_index = session_index;
+
+  if (s->vpp_handle != ~0)
+    {
+      vcl_session_table_add_vpp_handle (wrk, s->vpp_handle, session_index);
+      if (s->vpp_evt_q)
+	{
+	  vec_validate (wrk->vpp_event_queues, s->vpp_thread_index);
+	  wrk->vpp_event_queues[s->vpp_thread_index] = s->vpp_evt_q;
+	}
+    }
+
+  if (s->session_state & (STATE_CONNECT | STATE_ACCEPT | STATE_LISTEN))
+    {
+      rv = vcl_session_worker_update_wait (wrk, session_index,
+					   wrk->vpp_wrk_index);
+      if (rv)
+	{
+	  VDBG (0, "vls %u: session %u worker %u migration failed: %d",
+		vls->vls_index, vls->session_index, vls->worker_index, rv);
+	  s = vcl_session_get (wrk, session_index);
+	  vcl_session_table_del_vpp_handle (wrk, s->vpp_handle);
+	  vcl_session_free (wrk, s);
+	  return rv;
+	}
+    }
+
+  vls_mt_session_cleanup_defer (vls->worker_index, vls->session_index,
+				0 /* do_disconnect */ );
+
+  VDBG (1, "vls %u: session %u worker %u moved to session %u worker %u",
+	vls->vls_index, vls->session_index, vls->worker_index,
+	session_index, wrk->wrk_index);
+
+  vls->worker_index = wrk->wrk_index;
+  vls->session_index = session_index;
+
+  return VPPCOM_OK;
+}
+
+/**
+ * Make vls usable from current thread's worker
+ */
+static int
+vls_mt_session_localize (vcl_locked_session_t * vls)
+{
+  u32 wrk_index = vcl_get_worker_index ();
+  vcl_session_t _s, *s = &_s;
+  int rv;
+
+  if (PREDICT_TRUE (vls->worker_index == wrk_index))
+    return VPPCOM_OK;
+
+  if (wrk_index < vec_len (vls->mt_listeners)
+      && vls->mt_listeners[wrk_index] != ~0)
+    return VPPCOM_OK;
+
+  if ((rv = vls_mt_session_copy (vls, s)))
+    return rv;
+
+  if (vls_mt_session_is_clonable (s))
+    return vls_mt_listener_clone (vls, s);
+
+  if (!vls_mt_session_can_migrate (s))
+    {
+      VDBG (0, "vls %u: session %u worker %u cannot move to worker %u",
+	    vls->vls_index, vls->session_index, vls->worker_index,
+	    wrk_index);
+      return VPPCOM_EBADFD;
+    }
+
+  return vls_mt_session_migrate (vls, s);
+}
+
+/**
+ * Get and lock vls whose vcl session is usable from the current worker
+ *
+ * With multi-thread workers, sessions owned by other threads are moved
+ * to the current thread or, if listeners, cloned into it.
+ */
+static vcl_locked_session_t *
+vls_get_for_wrk (vls_handle_t vlsh)
 {
   vcl_locked_session_t *vls;
-  vls_table_rlock ();
-  vls = vls_get (vlsh);
-  vls_unlock (vls);
-  vls_table_runlock ();
+
+  if (!(vls = vls_get_and_lock (vlsh)))
+    return 0;
+
+  if (PREDICT_FALSE (vls_mt_wrk_supported ()
+		     && vls_mt_session_localize (vls)))
+    {
+      vls_unlock (vls);
+      return 0;
+    }
+
+  return vls;
 }
 
-static inline void
-vls_dunlock (vcl_locked_session_t * vls)
+static void
+vls_mt_listeners_close (vcl_locked_session_t * vls)
 {
-  vls_unlock (vls);
-  vls_table_runlock ();
+  u32 wrk_index = vcl_get_worker_index (), i;
+  vcl_worker_t *wrk;
+  vcl_session_t *s;
+
+  vec_foreach_index (i, vls->mt_listeners)
+  {
+    if (vls->mt_listeners[i] == ~0)
+      continue;
+
+    if (i == wrk_index)
+      {
+	vppcom_session_close (vcl_session_handle_from_index
+			      (vls->mt_listeners[i]));
+	continue;
+      }
+
+    if (!(wrk = vcl_worker_get_if_valid (i)))
+      continue;
+
+    clib_spinlock_lock (&wrk->mq_evt_lock);
+    clib_spinlock_lock (&wrk->sessions_lock);
+    s = vcl_session_get (wrk, vls->mt_listeners[i]);
+    if (s && (s->session_state & STATE_LISTEN))
+      vppcom_send_unbind_sock (wrk, s->vpp_handle);
+    clib_spinlock_unlock (&wrk->sessions_lock);
+    clib_spinlock_unlock (&wrk->mq_evt_lock);
+
+    vls_mt_session_cleanup_defer (i, vls->mt_listeners[i],
+				  0 /* do_disconnect */ );
+  }
+  vec_reset_length (vls->mt_listeners);
+}
+
+static int
+vls_mt_session_close (vcl_locked_session_t * vls)
+{
+  vcl_session_t _s, *s = &_s;
+  int rv;
+
+  vls_mt_listeners_close (vls);
+
+  if (vls->worker_index == vcl_get_worker_index ())
+    return vppcom_session_close (vls_to_sh (vls));
+
+  if ((rv = vls_mt_session_copy (vls, s)))
+    return rv;
+
+  if (vls_mt_session_is_clonable (s))
+    {
+      /* Reply is handled by owner, which also frees the session */
+      vppcom_send_unbind_sock (vcl_worker_get (vls->worker_index),
+			       s->vpp_handle);
+      vls_mt_session_cleanup_defer (vls->worker_index, vls->session_index,
+				    0 /* do_disconnect */ );
+      return VPPCOM_OK;
+    }
+
+  if (!vls_mt_session_can_migrate (s)
+      || vls_mt_session_migrate (vls, s) != VPPCOM_OK)
+    {
+      vls_mt_session_cleanup_defer (vls->worker_index, vls->session_index,
+				    1 /* do_disconnect */ );
+      return VPPCOM_OK;
+    }
+
+  return vppcom_session_close (vls_to_sh (vls));
 }
 
 vcl_session_handle_t
@@ -230,11 +625,11 @@ vlsh_to_sh (vls_handle_t vlsh)
   vcl_locked_session_t *vls;
   int rv;
 
-  vls = vls_get_w_dlock (vlsh);
-  if (!vls)
+  vls_mt_detect ();
+  if (!(vls = vls_get_for_wrk (vlsh)))
     return INVALID_SESSION_ID;
   rv = vls_to_sh (vls);
-  vls_dunlock (vls);
+  vls_unlock (vls);
   return rv;
 }
 
@@ -243,27 +638,24 @@ vlsh_to_session_index (vls_handle_t vlsh)
 {
   vcl_session_handle_t sh;
   sh = vlsh_to_sh (vlsh);
+  if (sh == INVALID_SESSION_ID)
+    return INVALID_SESSION_ID;
   return vppcom_session_index (sh);
 }
 
-vls_handle_t
+static vls_handle_t
 vls_si_to_vlsh (u32 session_index)
 {
-  uword *vlshp;
-  vlshp = hash_get (vlsm->session_index_to_vlsh_table, session_index);
-  return vlshp ? *vlshp : VLS_INVALID_HANDLE;
+  vcl_session_t *s;
+  s = vcl_session_get (vcl_worker_get_current (), session_index);
+  return (s && s->vls_index != ~0) ? s->vls_index : VLS_INVALID_HANDLE;
 }
 
 vls_handle_t
 vls_session_index_to_vlsh (uint32_t session_index)
 {
-  vls_handle_t vlsh;
-
-  vls_table_rlock ();
-  vlsh = vls_si_to_vlsh (session_index);
-  vls_table_runlock ();
-
-  return vlsh;
+  vls_mt_detect ();
+  return vls_si_to_vlsh (session_index);
 }
 
 u8
@@ -369,10 +761,9 @@ vls_share_vcl_session (vcl_worker_t * wrk, vcl_session_t * s)
 {
   vcl_locked_session_t *vls;
 
-  vls = vls_get (vls_si_to_vlsh (s->session_index));
+  vls = vls_get_and_lock (s->vls_index);
   if (!vls)
     return;
-  vls_lock (vls);
   vec_add1 (vls->workers_subscribed, wrk->wrk_index);
   if (s->rx_fifo)
     {
@@ -397,15 +788,12 @@ vls_worker_copy_on_fork (vcl_worker_t * parent_wrk)
   wrk->sessions = pool_dup (parent_wrk->sessions);
   wrk->session_index_by_vpp_handles =
     hash_dup (parent_wrk->session_index_by_vpp_handles);
-  vls_table_rlock ();
 
   /* *INDENT-OFF* */
   pool_foreach (s, wrk->sessions, ({
     vls_share_vcl_session (wrk, s);
   }));
   /* *INDENT-ON* */
-
-  vls_table_runlock ();
 }
 
 static void
@@ -417,7 +805,7 @@ vls_mt_acq_locks (vcl_locked_session_t * vls, vls_mt_ops_t op, int *locks_acq)
 
   if (vls)
     {
-      s = vcl_session_get (wrk, vls->session_index);
+      s = vcl_session_get_w_handle (wrk, vls_to_sh (vls));
       if (PREDICT_FALSE (!s))
 	return;
       is_nonblk = VCL_SESS_ATTR_TEST (s->attr, VCL_SESS_ATTR_NONBLOCK);
@@ -466,10 +854,10 @@ vls_mt_rel_locks (int locks_acq)
     vls_mt_create_unlock ();
 }
 
+/* Threads that share a vcl worker serialize on its message queue and
+ * session pool. Threads with their own workers need no locks */
 #define vls_mt_guard(_vls, _op)				\
   int _locks_acq = 0;					\
-  if (PREDICT_FALSE (vcl_get_worker_index () == ~0))	\
-    vls_mt_add ();					\
   if (PREDICT_FALSE (vlsl->vls_mt_n_threads > 1))	\
     vls_mt_acq_locks (_vls, _op, &_locks_acq);		\
 
@@ -483,13 +871,14 @@ vls_write (vls_handle_t vlsh, void *buf, size_t nbytes)
   vcl_locked_session_t *vls;
   int rv;
 
-  if (!(vls = vls_get_w_dlock (vlsh)))
+  vls_mt_detect ();
+  if (!(vls = vls_get_for_wrk (vlsh)))
     return VPPCOM_EBADFD;
 
   vls_mt_guard (vls, VLS_MT_OP_WRITE);
-  rv = vppcom_session_write (vls_to_sh_tu (vls), buf, nbytes);
+  rv = vppcom_session_write (vls_to_sh (vls), buf, nbytes);
   vls_mt_unguard ();
-  vls_get_and_unlock (vlsh);
+  vls_unlock (vls);
   return rv;
 }
 
@@ -499,12 +888,29 @@ vls_write_msg (vls_handle_t vlsh, void *buf, size_t nbytes)
   vcl_locked_session_t *vls;
   int rv;
 
-  if (!(vls = vls_get_w_dlock (vlsh)))
+  vls_mt_detect ();
+  if (!(vls = vls_get_for_wrk (vlsh)))
     return VPPCOM_EBADFD;
   vls_mt_guard (vls, VLS_MT_OP_WRITE);
-  rv = vppcom_session_write_msg (vls_to_sh_tu (vls), buf, nbytes);
+  rv = vppcom_session_write_msg (vls_to_sh (vls), buf, nbytes);
   vls_mt_unguard ();
-  vls_get_and_unlock (vlsh);
+  vls_unlock (vls);
+  return rv;
+}
+
+int
+vls_writev (vls_handle_t vlsh, const struct iovec *iov, int iovcnt)
+{
+  vcl_locked_session_t *vls;
+  int rv;
+
+  vls_mt_detect ();
+  if (!(vls = vls_get_for_wrk (vlsh)))
+    return VPPCOM_EBADFD;
+  vls_mt_guard (vls, VLS_MT_OP_WRITE);
+  rv = vppcom_session_writev (vls_to_sh (vls), iov, iovcnt);
+  vls_mt_unguard ();
+  vls_unlock (vls);
   return rv;
 }
 
@@ -515,12 +921,46 @@ vls_sendto (vls_handle_t vlsh, void *buf, int buflen, int flags,
   vcl_locked_session_t *vls;
   int rv;
 
-  if (!(vls = vls_get_w_dlock (vlsh)))
+  vls_mt_detect ();
+  if (!(vls = vls_get_for_wrk (vlsh)))
+    return VPPCOM_EBADFD;
+  vls_mt_guard (vls, VLS_MT_OP_WRITE);
+  rv = vppcom_session_sendto (vls_to_sh (vls), buf, buflen, flags, ep);
+  vls_mt_unguard ();
+  vls_unlock (vls);
+  return rv;
+}
+
+int
+vls_sendmmsg (vls_handle_t vlsh, vppcom_msg_t * msgs, uint32_t n_msgs,
+	      int flags)
+{
+  vcl_locked_session_t *vls;
+  int rv;
+
+  vls_mt_detect ();
+  if (!(vls = vls_get_for_wrk (vlsh)))
+    return VPPCOM_EBADFD;
+  vls_mt_guard (vls, VLS_MT_OP_WRITE);
+  rv = vppcom_session_sendmmsg (vls_to_sh (vls), msgs, n_msgs, flags);
+  vls_mt_unguard ();
+  vls_unlock (vls);
+  return rv;
+}
+
+int
+vls_sendfile (vls_handle_t vlsh, int in_fd, off_t * offset, size_t len)
+{
+  vcl_locked_session_t *vls;
+  int rv;
+
+  vls_mt_detect ();
+  if (!(vls = vls_get_for_wrk (vlsh)))
     return VPPCOM_EBADFD;
   vls_mt_guard (vls, VLS_MT_OP_WRITE);
-  rv = vppcom_session_sendto (vls_to_sh_tu (vls), buf, buflen, flags, ep);
+  rv = vppcom_session_sendfile (vls_to_sh (vls), in_fd, offset, len);
   vls_mt_unguard ();
-  vls_get_and_unlock (vlsh);
+  vls_unlock (vls);
   return rv;
 }
 
@@ -530,12 +970,29 @@ vls_read (vls_handle_t vlsh, void *buf, size_t nbytes)
   vcl_locked_session_t *vls;
   int rv;
 
-  if (!(vls = vls_get_w_dlock (vlsh)))
+  vls_mt_detect ();
+  if (!(vls = vls_get_for_wrk (vlsh)))
+    return VPPCOM_EBADFD;
+  vls_mt_guard (vls, VLS_MT_OP_READ);
+  rv = vppcom_session_read (vls_to_sh (vls), buf, nbytes);
+  vls_mt_unguard ();
+  vls_unlock (vls);
+  return rv;
+}
+
+ssize_t
+vls_readv (vls_handle_t vlsh, const struct iovec * iov, int iovcnt)
+{
+  vcl_locked_session_t *vls;
+  int rv;
+
+  vls_mt_detect ();
+  if (!(vls = vls_get_for_wrk (vlsh)))
     return VPPCOM_EBADFD;
   vls_mt_guard (vls, VLS_MT_OP_READ);
-  rv = vppcom_session_read (vls_to_sh_tu (vls), buf, nbytes);
+  rv = vppcom_session_readv (vls_to_sh (vls), iov, iovcnt);
   vls_mt_unguard ();
-  vls_get_and_unlock (vlsh);
+  vls_unlock (vls);
   return rv;
 }
 
@@ -546,29 +1003,45 @@ vls_recvfrom (vls_handle_t vlsh, void *buffer, uint32_t buflen, int flags,
   vcl_locked_session_t *vls;
   int rv;
 
-  if (!(vls = vls_get_w_dlock (vlsh)))
+  vls_mt_detect ();
+  if (!(vls = vls_get_for_wrk (vlsh)))
     return VPPCOM_EBADFD;
   vls_mt_guard (vls, VLS_MT_OP_READ);
-  rv = vppcom_session_recvfrom (vls_to_sh_tu (vls), buffer, buflen, flags,
+  rv = vppcom_session_recvfrom (vls_to_sh (vls), buffer, buflen, flags,
 				ep);
   vls_mt_unguard ();
-  vls_get_and_unlock (vlsh);
+  vls_unlock (vls);
   return rv;
 }
 
 int
-vls_attr (vls_handle_t vlsh, uint32_t op, void *buffer, uint32_t * buflen)
+vls_recvmmsg (vls_handle_t vlsh, vppcom_msg_t * msgs, uint32_t n_msgs,
+	      int flags)
 {
   vcl_locked_session_t *vls;
   int rv;
 
-  if (PREDICT_FALSE (vcl_get_worker_index () == ~0))
-    vls_mt_add ();
+  vls_mt_detect ();
+  if (!(vls = vls_get_for_wrk (vlsh)))
+    return VPPCOM_EBADFD;
+  vls_mt_guard (vls, VLS_MT_OP_READ);
+  rv = vppcom_session_recvmmsg (vls_to_sh (vls), msgs, n_msgs, flags);
+  vls_mt_unguard ();
+  vls_unlock (vls);
+  return rv;
+}
+
+int
+vls_attr (vls_handle_t vlsh, uint32_t op, void *buffer, uint32_t * buflen)
+{
+  vcl_locked_session_t *vls;
+  int rv;
 
-  if (!(vls = vls_get_w_dlock (vlsh)))
+  vls_mt_detect ();
+  if (!(vls = vls_get_for_wrk (vlsh)))
     return VPPCOM_EBADFD;
-  rv = vppcom_session_attr (vls_to_sh_tu (vls), op, buffer, buflen);
-  vls_get_and_unlock (vlsh);
+  rv = vppcom_session_attr (vls_to_sh (vls), op, buffer, buflen);
+  vls_unlock (vls);
   return rv;
 }
 
@@ -578,10 +1051,11 @@ vls_bind (vls_handle_t vlsh, vppcom_endpt_t * ep)
   vcl_locked_session_t *vls;
   int rv;
 
-  if (!(vls = vls_get_w_dlock (vlsh)))
+  vls_mt_detect ();
+  if (!(vls = vls_get_for_wrk (vlsh)))
     return VPPCOM_EBADFD;
-  rv = vppcom_session_bind (vls_to_sh_tu (vls), ep);
-  vls_get_and_unlock (vlsh);
+  rv = vppcom_session_bind (vls_to_sh (vls), ep);
+  vls_unlock (vls);
   return rv;
 }
 
@@ -591,12 +1065,13 @@ vls_listen (vls_handle_t vlsh, int q_len)
   vcl_locked_session_t *vls;
   int rv;
 
-  if (!(vls = vls_get_w_dlock (vlsh)))
+  vls_mt_detect ();
+  if (!(vls = vls_get_for_wrk (vlsh)))
     return VPPCOM_EBADFD;
   vls_mt_guard (vls, VLS_MT_OP_XPOLL);
-  rv = vppcom_session_listen (vls_to_sh_tu (vls), q_len);
+  rv = vppcom_session_listen (vls_to_sh (vls), q_len);
   vls_mt_unguard ();
-  vls_get_and_unlock (vlsh);
+  vls_unlock (vls);
   return rv;
 }
 
@@ -606,12 +1081,13 @@ vls_connect (vls_handle_t vlsh, vppcom_endpt_t * server_ep)
   vcl_locked_session_t *vls;
   int rv;
 
-  if (!(vls = vls_get_w_dlock (vlsh)))
+  vls_mt_detect ();
+  if (!(vls = vls_get_for_wrk (vlsh)))
     return VPPCOM_EBADFD;
   vls_mt_guard (vls, VLS_MT_OP_XPOLL);
-  rv = vppcom_session_connect (vls_to_sh_tu (vls), server_ep);
+  rv = vppcom_session_connect (vls_to_sh (vls), server_ep);
   vls_mt_unguard ();
-  vls_get_and_unlock (vlsh);
+  vls_unlock (vls);
   return rv;
 }
 
@@ -662,14 +1138,15 @@ vls_accept (vls_handle_t listener_vlsh, vppcom_endpt_t * ep, int flags)
   vcl_locked_session_t *vls;
   int sh;
 
-  if (!(vls = vls_get_w_dlock (listener_vlsh)))
+  vls_mt_detect ();
+  if (!(vls = vls_get_for_wrk (listener_vlsh)))
     return VPPCOM_EBADFD;
-  if (vcl_n_workers () > 1)
+  if (vcl_n_workers () > 1 && !vls_mt_wrk_supported ())
     vls_mp_checks (vls, 1 /* is_add */ );
   vls_mt_guard (vls, VLS_MT_OP_SPOOL);
-  sh = vppcom_session_accept (vls_to_sh_tu (vls), ep, flags);
+  sh = vppcom_session_accept (vls_to_sh (vls), ep, flags);
   vls_mt_unguard ();
-  vls_get_and_unlock (listener_vlsh);
+  vls_unlock (vls);
   if (sh < 0)
     return sh;
   accepted_vlsh = vls_alloc (sh);
@@ -684,6 +1161,7 @@ vls_create (uint8_t proto, uint8_t is_nonblocking)
   vcl_session_handle_t sh;
   vls_handle_t vlsh;
 
+  vls_mt_detect ();
   vls_mt_guard (0, VLS_MT_OP_SPOOL);
   sh = vppcom_session_create (proto, is_nonblocking);
   vls_mt_unguard ();
@@ -703,14 +1181,9 @@ vls_close (vls_handle_t vlsh)
   vcl_locked_session_t *vls;
   int rv;
 
-  vls_table_wlock ();
-
-  vls = vls_get_and_lock (vlsh);
-  if (!vls)
-    {
-      vls_table_wunlock ();
-      return VPPCOM_EBADFD;
-    }
+  vls_mt_detect ();
+  if (!(vls = vls_get_and_lock (vlsh)))
+    return VPPCOM_EBADFD;
 
   vls_mt_guard (0, VLS_MT_OP_SPOOL);
   if (vls_is_shared (vls))
@@ -719,16 +1192,16 @@ vls_close (vls_handle_t vlsh)
       vls_unshare_session (vls, vcl_worker_get_current ());
       vls_unlock (vls);
       vls_mt_unguard ();
-      vls_table_wunlock ();
       return VPPCOM_OK;
     }
 
-  rv = vppcom_session_close (vls_to_sh (vls));
+  if (vls_mt_wrk_supported ())
+    rv = vls_mt_session_close (vls);
+  else
+    rv = vppcom_session_close (vls_to_sh (vls));
   vls_free (vls);
   vls_mt_unguard ();
 
-  vls_table_wunlock ();
-
   return rv;
 }
 
@@ -738,8 +1211,7 @@ vls_epoll_create (void)
   vcl_session_handle_t sh;
   vls_handle_t vlsh;
 
-  if (PREDICT_FALSE (vcl_get_worker_index () == ~0))
-    vls_mt_add ();
+  vls_mt_detect ();
 
   sh = vppcom_epoll_create ();
   if (sh == INVALID_SESSION_ID)
@@ -755,7 +1227,7 @@ vls_epoll_create (void)
 static void
 vls_epoll_ctl_mp_checks (vcl_locked_session_t * vls, int op)
 {
-  if (vcl_n_workers () <= 1)
+  if (vcl_n_workers () <= 1 || vls_mt_wrk_supported ())
     {
       vlsl->epoll_mp_check = 1;
       return;
@@ -773,28 +1245,24 @@ vls_epoll_ctl (vls_handle_t ep_vlsh, int op, vls_handle_t vlsh,
 	       struct epoll_event *event)
 {
   vcl_locked_session_t *ep_vls, *vls;
-  vcl_session_handle_t ep_sh, sh;
   int rv;
 
-  vls_table_rlock ();
-  ep_vls = vls_get_and_lock (ep_vlsh);
-  vls = vls_get_and_lock (vlsh);
-  ep_sh = vls_to_sh (ep_vls);
-  sh = vls_to_sh (vls);
+  vls_mt_detect ();
+  if (!(ep_vls = vls_get_for_wrk (ep_vlsh)))
+    return VPPCOM_EBADFD;
+  if (!(vls = vls_get_for_wrk (vlsh)))
+    {
+      vls_unlock (ep_vls);
+      return VPPCOM_EBADFD;
+    }
 
   if (PREDICT_FALSE (!vlsl->epoll_mp_check))
     vls_epoll_ctl_mp_checks (vls, op);
 
-  vls_table_runlock ();
-
-  rv = vppcom_epoll_ctl (ep_sh, op, sh, event);
+  rv = vppcom_epoll_ctl (vls_to_sh (ep_vls), op, vls_to_sh (vls), event);
 
-  vls_table_rlock ();
-  ep_vls = vls_get (ep_vlsh);
-  vls = vls_get (vlsh);
   vls_unlock (vls);
   vls_unlock (ep_vls);
-  vls_table_runlock ();
   return rv;
 }
 
@@ -805,13 +1273,14 @@ vls_epoll_wait (vls_handle_t ep_vlsh, struct epoll_event *events,
   vcl_locked_session_t *vls;
   int rv;
 
-  if (!(vls = vls_get_w_dlock (ep_vlsh)))
+  vls_mt_detect ();
+  if (!(vls = vls_get_for_wrk (ep_vlsh)))
     return VPPCOM_EBADFD;
   vls_mt_guard (0, VLS_MT_OP_XPOLL);
-  rv = vppcom_epoll_wait (vls_to_sh_tu (vls), events, maxevents,
+  rv = vppcom_epoll_wait (vls_to_sh (vls), events, maxevents,
 			  wait_for_time);
   vls_mt_unguard ();
-  vls_get_and_unlock (ep_vlsh);
+  vls_unlock (vls);
   return rv;
 }
 
@@ -823,7 +1292,7 @@ vls_select_mp_checks (vcl_si_set * read_map)
   vcl_session_t *s;
   u32 si;
 
-  if (vcl_n_workers () <= 1)
+  if (vcl_n_workers () <= 1 || vls_mt_wrk_supported ())
     {
       vlsl->select_mp_check = 1;
       return;
@@ -840,8 +1309,10 @@ vls_select_mp_checks (vcl_si_set * read_map)
     s = vcl_session_get (wrk, si);
     if (s->session_state == STATE_LISTEN)
       {
-	vls = vls_get (vls_session_index_to_vlsh (si));
+	if (!(vls = vls_get_and_lock (vls_si_to_vlsh (si))))
+	  continue;
 	vls_mp_checks (vls, 1 /* is_add */);
+	vls_unlock (vls);
       }
   }));
   /* *INDENT-ON* */
@@ -853,6 +1324,7 @@ vls_select (int n_bits, vcl_si_set * read_map, vcl_si_set * write_map,
 {
   int rv;
 
+  vls_mt_detect ();
   vls_mt_guard (0, VLS_MT_OP_XPOLL);
   if (PREDICT_FALSE (!vlsl->select_mp_check))
     vls_select_mp_checks (read_map);
@@ -861,6 +1333,18 @@ vls_select (int n_bits, vcl_si_set * read_map, vcl_si_set * write_map,
   return rv;
 }
 
+int
+vls_poll (vcl_poll_t * vp, uint32_t n_sids, double wait_for_time)
+{
+  int rv;
+
+  vls_mt_detect ();
+  vls_mt_guard (0, VLS_MT_OP_XPOLL);
+  rv = vppcom_poll (vp, n_sids, wait_for_time);
+  vls_mt_unguard ();
+  return rv;
+}
+
 static void
 vls_unshare_vcl_worker_sessions (vcl_worker_t * wrk)
 {
@@ -873,17 +1357,16 @@ vls_unshare_vcl_worker_sessions (vcl_worker_t * wrk)
 
   current_wrk = vcl_get_worker_index ();
   is_current = current_wrk == wrk->wrk_index;
-  vls_table_wlock ();
 
   /* *INDENT-OFF* */
   pool_foreach (s, wrk->sessions, ({
-    vls = vls_get (vls_si_to_vlsh (s->session_index));
-    if (vls && (is_current || vls_is_shared_by_wrk (vls, current_wrk)))
+    if (!(vls = vls_get_and_lock (s->vls_index)))
+      continue;
+    if (is_current || vls_is_shared_by_wrk (vls, current_wrk))
       vls_unshare_session (vls, wrk);
+    vls_unlock (vls);
   }));
   /* *INDENT-ON* */
-
-  vls_table_wunlock ();
 }
 
 static void
@@ -1025,8 +1508,9 @@ vls_app_fork_child_handler (void)
   vls_worker_copy_on_fork (parent_wrk);
   parent_wrk->forked_child = vcl_get_worker_index ();
 
-  /* Reset number of threads and set wrk index */
-  vlsl->vls_mt_n_threads = 0;
+  /* Reset number of threads and set wrk index. Only the forking thread
+   * survives in the child */
+  vlsl->vls_mt_n_threads = 1;
   vlsl->vls_wrk_index = vcl_get_worker_index ();
   vlsl->select_mp_check = 0;
   vlsl->epoll_mp_check = 0;
@@ -1044,6 +1528,21 @@ vls_app_fork_parent_handler (void)
     ;
 }
 
+void
+vls_register_vcl_worker (void)
+{
+  vls_mt_detect ();
+}
+
+unsigned char
+vls_use_real_epoll (void)
+{
+  if (vcl_get_worker_index () == ~0)
+    return 0;
+
+  return vcl_worker_get_current ()->vcl_needs_real_epoll;
+}
+
 void
 vls_app_exit (void)
 {
@@ -1060,11 +1559,19 @@ vls_app_create (char *app_name)
     return rv;
   vlsm = clib_mem_alloc (sizeof (vls_main_t));
   clib_memset (vlsm, 0, sizeof (*vlsm));
-  clib_rwlock_init (&vlsm->vls_table_lock);
+  clib_spinlock_init (&vlsm->vls_alloc_lock);
+  if (vls_mt_wrk_supported ())
+    {
+      vls_worker_t *vlsw;
+      vec_validate (vlsm->workers, vcm->cfg.max_workers - 1);
+      vec_foreach (vlsw, vlsm->workers)
+	clib_spinlock_init (&vlsw->pending_lock);
+    }
   pthread_atfork (vls_app_pre_fork, vls_app_fork_parent_handler,
 		  vls_app_fork_child_handler);
   atexit (vls_app_exit);
   vlsl->vls_wrk_index = vcl_get_worker_index ();
+  vlsl->vls_mt_n_threads = 1;
   vls_mt_locks_init ();
   return VPPCOM_OK;
 }
@@ -31,12 +31,19 @@ int vls_listen (vls_handle_t vlsh, int q_len);
 int vls_connect (vls_handle_t vlsh, vppcom_endpt_t * server_ep);
 vls_handle_t vls_accept (vls_handle_t vlsh, vppcom_endpt_t * ep, int flags);
 ssize_t vls_read (vls_handle_t vlsh, void *buf, size_t nbytes);
+ssize_t vls_readv (vls_handle_t vlsh, const struct iovec *iov, int iovcnt);
 ssize_t vls_recvfrom (vls_handle_t vlsh, void *buffer, uint32_t buflen,
 		      int flags, vppcom_endpt_t * ep);
+int vls_recvmmsg (vls_handle_t vlsh, vppcom_msg_t * msgs, uint32_t n_msgs,
+		  int flags);
 int vls_write (vls_handle_t vlsh, void *buf, size_t nbytes);
 int vls_write_msg (vls_handle_t vlsh, void *buf, size_t nbytes);
+int vls_writev (vls_handle_t vlsh, const struct iovec *iov, int iovcnt);
 int vls_sendto (vls_handle_t vlsh, void *buf, int buflen, int flags,
 		vppcom_endpt_t * ep);
+int vls_sendmmsg (vls_handle_t vlsh, vppcom_msg_t * msgs, uint32_t n_msgs,
+		  int flags);
+int vls_sendfile (vls_handle_t vlsh, int in_fd, off_t * offset, size_t len);
 int vls_attr (vls_handle_t vlsh, uint32_t op, void *buffer,
 	      uint32_t * buflen);
 vls_handle_t vls_epoll_create (void);
@@ -46,10 +53,13 @@ int vls_epoll_wait (vls_handle_t ep_vlsh, struct epoll_event *events,
 		    int maxevents, double wait_for_time);
 int vls_select (int n_bits, vcl_si_set * read_map, vcl_si_set * write_map,
 		vcl_si_set * except_map, double wait_for_time);
+int vls_poll (vcl_poll_t * vp, uint32_t n_sids, double wait_for_time);
 vcl_session_handle_t vlsh_to_sh (vls_handle_t vlsh);
 vcl_session_handle_t vlsh_to_session_index (vls_handle_t vlsh);
 vls_handle_t vls_session_index_to_vlsh (uint32_t session_index);
 int vls_app_create (char *app_name);
+void vls_register_vcl_worker (void);
+unsigned char vls_use_real_epoll (void);
 
 #endif /* SRC_VCL_VCL_LOCKED_H_ */
 
@@ -168,6 +168,8 @@ vcl_worker_cleanup (vcl_worker_t * wrk, u8 notify_vpp)
   hash_free (wrk->session_index_by_vpp_handles);
   vec_free (wrk->mq_events);
   vec_free (wrk->mq_msg_vector);
+  clib_spinlock_free (&wrk->sessions_lock);
+  clib_spinlock_free (&wrk->mq_evt_lock);
   vcl_worker_free (wrk);
   clib_spinlock_unlock (&vcm->workers_lock);
 }
@@ -203,10 +205,18 @@ vcl_worker_alloc_and_init ()
   wrk->thread_id = pthread_self ();
   wrk->current_pid = getpid ();
 
+  if (vcm->cfg.mt_wrk_supported)
+    {
+      clib_spinlock_init (&wrk->sessions_lock);
+      clib_spinlock_init (&wrk->mq_evt_lock);
+    }
+
   wrk->mqs_epfd = -1;
   if (vcm->cfg.use_mq_eventfd)
     {
+      wrk->vcl_needs_real_epoll = 1;
       wrk->mqs_epfd = epoll_create (1);
+      wrk->vcl_needs_real_epoll = 0;
       if (wrk->mqs_epfd < 0)
 	{
 	  clib_unix_warning ("epoll_create() returned");
@@ -239,6 +249,7 @@ vcl_worker_register_with_vpp (void)
   if (vcl_wait_for_app_state_change (STATE_APP_READY))
     {
       VDBG (0, "failed to add worker to vpp");
+      clib_spinlock_unlock (&vcm->workers_lock);
       return -1;
     }
   if (pthread_key_create (&vcl_worker_stop_key, vcl_worker_cleanup_cb))
@@ -174,6 +174,7 @@ typedef struct
   int libc_epfd;
   svm_msg_q_t *our_evt_q;
   vcl_session_msg_t *accept_evts_fifo;
+  u32 vls_index;		/**< locked session wrapping this, if any */
 #if VCL_ELOG
   elog_track_t elog_track;
 #endif
@@ -199,6 +200,7 @@ typedef struct vppcom_cfg_t_
   u8 *namespace_id;
   u64 namespace_secret;
   u8 use_mq_eventfd;
+  u8 mt_wrk_supported;
   f64 app_timeout;
   f64 session_timeout;
   f64 accept_timeout;
@@ -232,12 +234,15 @@ typedef struct vcl_worker_
   /* Session pool */
   vcl_session_t *sessions;
 
-  u32 listen_session_index;
+  /** Protects session pool reallocs. Only used with multi-thread workers,
+   *  whereby other threads may copy sessions out of this worker's pool */
+  clib_spinlock_t sessions_lock;
 
-  u32 listen_fd;
-  
-u32 listen_queue_size;
-/** Worker/thread index in current process */
+  /** Held while mq events update sessions. Only used with multi-thread
+   *  workers, so that copies of sessions by other threads are not torn */
+  clib_spinlock_t mq_evt_lock;
+
+  /** Worker/thread index in current process */
   u32 wrk_index;
 
   /** Worker index in vpp*/
@@ -255,6 +260,9 @@ u32 listen_queue_size;
   /** Message queues epoll fd. Initialized only if using mqs with eventfds */
   int mqs_epfd;
 
+  /** Set while the mqs epoll fd is created, which ldp must not intercept */
+  u8 vcl_needs_real_epoll;
+
   /** Pool of event message queue event connections */
   vcl_mq_evt_conn_t *mq_evt_conns;
 
@@ -284,6 +292,10 @@ u32 listen_queue_size;
   /** Vector of unhandled events */
   session_event_t *unhandled_evts_vector;
 
+  /** Scratch vectors for batched tx */
+  svm_fifo_seg_t *tx_segs;
+  session_dgram_hdr_t *tx_dgram_hdrs;
+
   u32 *pending_session_wrk_updates;
 
   /** Used also as a thread stop key buffer */
@@ -349,20 +361,28 @@ extern vppcom_main_t *vcm;
 #define VCL_INVALID_SEGMENT_INDEX ((u32)~0)
 #define VCL_INVALID_SEGMENT_HANDLE ((u64)~0)
 
+/** Max number of fifo segments sendfile reads into at once */
+#define VCL_SENDFILE_MAX_SEGS 16
+
 static inline vcl_session_t *
 vcl_session_alloc (vcl_worker_t * wrk)
 {
   vcl_session_t *s;
+  clib_spinlock_lock_if_init (&wrk->sessions_lock);
   pool_get (wrk->sessions, s);
   memset (s, 0, sizeof (*s));
   s->session_index = s - wrk->sessions;
+  s->vls_index = ~0;
+  clib_spinlock_unlock_if_init (&wrk->sessions_lock);
   return s;
 }
 
 static inline void
 vcl_session_free (vcl_worker_t * wrk, vcl_session_t * s)
 {
+  clib_spinlock_lock_if_init (&wrk->sessions_lock);
   pool_put (wrk->sessions, s);
+  clib_spinlock_unlock_if_init (&wrk->sessions_lock);
 }
 
 static inline vcl_session_t *
@@ -572,6 +592,8 @@ vcl_session_vpp_evt_q (vcl_worker_t * wrk, vcl_session_t * s)
 
 void vcl_send_session_worker_update (vcl_worker_t * wrk, vcl_session_t * s,
 				     u32 wrk_index);
+int vcl_session_worker_update_wait (vcl_worker_t * wrk, u32 session_index,
+				    u32 wrk_index);
 /*
  * VCL Binary API
  */
@@ -15,6 +15,8 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include <sys/syscall.h>
 #include <vcl/vppcom.h>
 #include <vcl/vcl_debug.h>
 #include <vcl/vcl_private.h>
@@ -646,6 +648,8 @@ vcl_handle_mq_event (vcl_worker_t * wrk, session_event_t * e)
   session_disconnected_msg_t *disconnected_msg;
   vcl_session_t *session;
 
+  clib_spinlock_lock_if_init (&wrk->mq_evt_lock);
+
   switch (e->event_type)
     {
     case SESSION_IO_EVT_RX:
@@ -688,6 +692,8 @@ vcl_handle_mq_event (vcl_worker_t * wrk, session_event_t * e)
     default:
       clib_warning ("unhandled %u", e->event_type);
     }
+
+  clib_spinlock_unlock_if_init (&wrk->mq_evt_lock);
   return VPPCOM_OK;
 }
 
@@ -736,24 +742,40 @@ vppcom_wait_for_session_state_change (u32 session_index,
   return VPPCOM_ETIMEDOUT;
 }
 
-static void
-vcl_handle_pending_wrk_updates (vcl_worker_t * wrk)
+/**
+ * Ask vpp to move session to worker and wait for the reply, which also
+ * carries the session's new fifos. Session state is preserved.
+ */
+int
+vcl_session_worker_update_wait (vcl_worker_t * wrk, u32 session_index,
+				u32 wrk_index)
 {
   vcl_session_state_t state;
   vcl_session_t *s;
+  int rv;
+
+  s = vcl_session_get (wrk, session_index);
+  vcl_send_session_worker_update (wrk, s, wrk_index);
+  state = s->session_state;
+  rv = vppcom_wait_for_session_state_change (session_index, STATE_UPDATED,
+					     5);
+  /* Session pool may have grown while handling events */
+  s = vcl_session_get (wrk, session_index);
+  if (s)
+    s->session_state = state;
+  return rv;
+}
+
+static void
+vcl_handle_pending_wrk_updates (vcl_worker_t * wrk)
+{
   u32 *sip;
 
   if (PREDICT_TRUE (vec_len (wrk->pending_session_wrk_updates) == 0))
     return;
 
   vec_foreach (sip, wrk->pending_session_wrk_updates)
-  {
-    s = vcl_session_get (wrk, *sip);
-    vcl_send_session_worker_update (wrk, s, wrk->wrk_index);
-    state = s->session_state;
-    vppcom_wait_for_session_state_change (s->session_index, STATE_UPDATED, 5);
-    s->session_state = state;
-  }
+    vcl_session_worker_update_wait (wrk, *sip, wrk->wrk_index);
   vec_reset_length (wrk->pending_session_wrk_updates);
 }
 
@@ -1480,18 +1502,71 @@ vcl_is_rx_evt_for_session (session_event_t * e, u32 sid, u8 is_ct)
   return (e->event_type == SESSION_IO_EVT_RX && e->session_index == sid);
 }
 
+/**
+ * Wait for data in session's rx fifo, unless non-blocking
+ */
+static int
+vcl_session_rx_wait (vcl_worker_t * wrk, vcl_session_t * s,
+		     svm_fifo_t * rx_fifo, u8 is_nonblocking)
+{
+  svm_msg_q_t *mq = wrk->app_event_queue;
+  u8 is_ct = vcl_session_is_ct (s);
+  svm_msg_q_msg_t msg;
+  session_event_t *e;
+
+  if (!svm_fifo_is_empty_cons (rx_fifo))
+    return 0;
+
+  if (is_nonblocking)
+    {
+      svm_fifo_unset_event (s->rx_fifo);
+      return VPPCOM_EWOULDBLOCK;
+    }
+
+  while (svm_fifo_is_empty_cons (rx_fifo))
+    {
+      if (vcl_session_is_closing (s))
+	return vcl_session_closing_error (s);
+
+      svm_fifo_unset_event (s->rx_fifo);
+      svm_msg_q_lock (mq);
+      if (svm_msg_q_is_empty (mq))
+	svm_msg_q_wait (mq);
+
+      svm_msg_q_sub_w_lock (mq, &msg);
+      e = svm_msg_q_msg_data (mq, &msg);
+      svm_msg_q_unlock (mq);
+      if (!vcl_is_rx_evt_for_session (e, s->session_index, is_ct))
+	vcl_handle_mq_event (wrk, e);
+      svm_msg_q_free_msg (mq, &msg);
+    }
+
+  return 0;
+}
+
+static void
+vcl_session_rx_done (vcl_session_t * s, svm_fifo_t * rx_fifo)
+{
+  if (svm_fifo_is_empty_cons (rx_fifo))
+    svm_fifo_unset_event (s->rx_fifo);
+
+  /* Cut-through sessions might request tx notifications on rx fifos */
+  if (PREDICT_FALSE (rx_fifo->want_deq_ntf))
+    {
+      app_send_io_evt_to_vpp (s->vpp_evt_q, s->rx_fifo->master_session_index,
+			      SESSION_IO_EVT_RX, SVM_Q_WAIT);
+      svm_fifo_reset_has_deq_ntf (s->rx_fifo);
+    }
+}
+
 static inline int
 vppcom_session_read_internal (uint32_t session_handle, void *buf, int n,
 			      u8 peek)
 {
   vcl_worker_t *wrk = vcl_worker_get_current ();
-  int n_read = 0, is_nonblocking;
+  int n_read = 0, is_nonblocking, rv;
   vcl_session_t *s = 0;
   svm_fifo_t *rx_fifo;
-  svm_msg_q_msg_t msg;
-  session_event_t *e;
-  svm_msg_q_t *mq;
-  u8 is_ct;
 
   if (PREDICT_FALSE (!buf))
     return VPPCOM_EINVAL;
@@ -1509,52 +1584,18 @@ vppcom_session_read_internal (uint32_t session_handle, void *buf, int n,
     }
 
   is_nonblocking = VCL_SESS_ATTR_TEST (s->attr, VCL_SESS_ATTR_NONBLOCK);
-  is_ct = vcl_session_is_ct (s);
-  mq = wrk->app_event_queue;
-  rx_fifo = is_ct ? s->ct_rx_fifo : s->rx_fifo;
+  rx_fifo = vcl_session_is_ct (s) ? s->ct_rx_fifo : s->rx_fifo;
   s->has_rx_evt = 0;
 
-  if (svm_fifo_is_empty_cons (rx_fifo))
-    {
-      if (is_nonblocking)
-	{
-	  svm_fifo_unset_event (s->rx_fifo);
-	  return VPPCOM_EWOULDBLOCK;
-	}
-      while (svm_fifo_is_empty_cons (rx_fifo))
-	{
-	  if (vcl_session_is_closing (s))
-	    return vcl_session_closing_error (s);
-
-	  svm_fifo_unset_event (s->rx_fifo);
-	  svm_msg_q_lock (mq);
-	  if (svm_msg_q_is_empty (mq))
-	    svm_msg_q_wait (mq);
-
-	  svm_msg_q_sub_w_lock (mq, &msg);
-	  e = svm_msg_q_msg_data (mq, &msg);
-	  svm_msg_q_unlock (mq);
-	  if (!vcl_is_rx_evt_for_session (e, s->session_index, is_ct))
-	    vcl_handle_mq_event (wrk, e);
-	  svm_msg_q_free_msg (mq, &msg);
-	}
-    }
+  if ((rv = vcl_session_rx_wait (wrk, s, rx_fifo, is_nonblocking)))
+    return rv;
 
   if (s->is_dgram)
     n_read = app_recv_dgram_raw (rx_fifo, buf, n, &s->transport, 0, peek);
   else
     n_read = app_recv_stream_raw (rx_fifo, buf, n, 0, peek);
 
-  if (svm_fifo_is_empty_cons (rx_fifo))
-    svm_fifo_unset_event (s->rx_fifo);
-
-  /* Cut-through sessions might request tx notifications on rx fifos */
-  if (PREDICT_FALSE (rx_fifo->want_deq_ntf))
-    {
-      app_send_io_evt_to_vpp (s->vpp_evt_q, s->rx_fifo->master_session_index,
-			      SESSION_IO_EVT_RX, SVM_Q_WAIT);
-      svm_fifo_reset_has_deq_ntf (s->rx_fifo);
-    }
+  vcl_session_rx_done (s, rx_fifo);
 
   VDBG (2, "session %u[0x%llx]: read %d bytes from (%p)", s->session_index,
 	s->vpp_handle, n_read, rx_fifo);
@@ -1668,18 +1709,54 @@ vcl_is_tx_evt_for_session (session_event_t * e, u32 sid, u8 is_ct)
   return (e->event_type == SESSION_IO_EVT_TX && e->session_index == sid);
 }
 
+/**
+ * Wait for space in session's tx fifo, unless non-blocking
+ */
+static int
+vcl_session_tx_wait (vcl_worker_t * wrk, vcl_session_t * s,
+		     svm_fifo_t * tx_fifo, u8 is_nonblocking)
+{
+  svm_msg_q_t *mq = wrk->app_event_queue;
+  u8 is_ct = vcl_session_is_ct (s);
+  svm_msg_q_msg_t msg;
+  session_event_t *e;
+
+  if (!svm_fifo_is_full_prod (tx_fifo))
+    return 0;
+
+  if (is_nonblocking)
+    return VPPCOM_EWOULDBLOCK;
+
+  while (svm_fifo_is_full_prod (tx_fifo))
+    {
+      svm_fifo_add_want_deq_ntf (tx_fifo, SVM_FIFO_WANT_DEQ_NOTIF);
+      if (vcl_session_is_closing (s))
+	return vcl_session_closing_error (s);
+      svm_msg_q_lock (mq);
+      if (svm_msg_q_is_empty (mq))
+	svm_msg_q_wait (mq);
+
+      svm_msg_q_sub_w_lock (mq, &msg);
+      e = svm_msg_q_msg_data (mq, &msg);
+      svm_msg_q_unlock (mq);
+
+      if (!vcl_is_tx_evt_for_session (e, s->session_index, is_ct))
+	vcl_handle_mq_event (wrk, e);
+      svm_msg_q_free_msg (mq, &msg);
+    }
+
+  return 0;
+}
+
 static inline int
 vppcom_session_write_inline (uint32_t session_handle, void *buf, size_t n,
 			     u8 is_flush)
 {
   vcl_worker_t *wrk = vcl_worker_get_current ();
-  int n_write, is_nonblocking;
+  int n_write, is_nonblocking, rv;
   vcl_session_t *s = 0;
   session_evt_type_t et;
-  svm_msg_q_msg_t msg;
   svm_fifo_t *tx_fifo;
-  session_event_t *e;
-  svm_msg_q_t *mq;
   u8 is_ct;
 
   if (PREDICT_FALSE (!buf))
@@ -1708,31 +1785,8 @@ vppcom_session_write_inline (uint32_t session_handle, void *buf, size_t n,
   tx_fifo = is_ct ? s->ct_tx_fifo : s->tx_fifo;
   is_nonblocking = VCL_SESS_ATTR_TEST (s->attr, VCL_SESS_ATTR_NONBLOCK);
 
-  mq = wrk->app_event_queue;
-  if (svm_fifo_is_full_prod (tx_fifo))
-    {
-      if (is_nonblocking)
-	{
-	  return VPPCOM_EWOULDBLOCK;
-	}
-      while (svm_fifo_is_full_prod (tx_fifo))
-	{
-	  svm_fifo_add_want_deq_ntf (tx_fifo, SVM_FIFO_WANT_DEQ_NOTIF);
-	  if (vcl_session_is_closing (s))
-	    return vcl_session_closing_error (s);
-	  svm_msg_q_lock (mq);
-	  if (svm_msg_q_is_empty (mq))
-	    svm_msg_q_wait (mq);
-
-	  svm_msg_q_sub_w_lock (mq, &msg);
-	  e = svm_msg_q_msg_data (mq, &msg);
-	  svm_msg_q_unlock (mq);
-
-	  if (!vcl_is_tx_evt_for_session (e, s->session_index, is_ct))
-	    vcl_handle_mq_event (wrk, e);
-	  svm_msg_q_free_msg (mq, &msg);
-	}
-    }
+  if ((rv = vcl_session_tx_wait (wrk, s, tx_fifo, is_nonblocking)))
+    return rv;
 
   et = SESSION_IO_EVT_TX;
   if (is_flush && !is_ct)
@@ -1772,6 +1826,457 @@ vppcom_session_write_msg (uint32_t session_handle, void *buf, size_t n)
 				      1 /* is_flush */ );
 }
 
+static inline u8
+vcl_session_ep_is_peer (vcl_session_t * s, vppcom_endpt_t * ep)
+{
+  if (ep->is_ip4 != s->transport.is_ip4
+      || ep->port != s->transport.rmt_port)
+    return 0;
+  if (ep->is_ip4)
+    return !memcmp (ep->ip, &s->transport.rmt_ip.ip4,
+		    sizeof (ip4_address_t));
+  return !memcmp (ep->ip, &s->transport.rmt_ip.ip6, sizeof (ip6_address_t));
+}
+
+static inline void
+vcl_dgram_hdr_to_ep (session_dgram_hdr_t * hdr, vppcom_endpt_t * ep)
+{
+  ep->is_ip4 = hdr->is_ip4;
+  ep->port = hdr->rmt_port;
+  if (hdr->is_ip4)
+    clib_memcpy_fast (ep->ip, &hdr->rmt_ip.ip4, sizeof (ip4_address_t));
+  else
+    clib_memcpy_fast (ep->ip, &hdr->rmt_ip.ip6, sizeof (ip6_address_t));
+}
+
+/**
+ * Scatter fifo data at offset to iovec array
+ *
+ * @return number of bytes copied
+ */
+static u32
+vcl_fifo_peek_iov (svm_fifo_t * f, u32 offset, u32 len,
+		   const struct iovec *iov, u32 iovcnt)
+{
+  u32 i, n_copy, n_copied = 0;
+
+  for (i = 0; i < iovcnt && n_copied < len; i++)
+    {
+      n_copy = clib_min (iov[i].iov_len, len - n_copied);
+      if (!n_copy)
+	continue;
+      svm_fifo_peek (f, offset + n_copied, n_copy, iov[i].iov_base);
+      n_copied += n_copy;
+    }
+
+  return n_copied;
+}
+
+static inline u32
+vcl_iov_len (const struct iovec *iov, u32 iovcnt)
+{
+  u32 i, len = 0;
+  for (i = 0; i < iovcnt; i++)
+    len += iov[i].iov_len;
+  return len;
+}
+
+/**
+ * Receive multiple messages with only one fifo dequeue
+ *
+ * For datagram sessions each message gets one datagram, and datagrams larger
+ * than the message's iovec array are truncated. For stream sessions, data is
+ * spread over the messages' iovecs. Blocks, unless the session is
+ * non-blocking or MSG_DONTWAIT is set, only until the first message is
+ * available.
+ *
+ * @return number of messages received or error
+ */
+int
+vppcom_session_recvmmsg (uint32_t session_handle, vppcom_msg_t * msgs,
+			 uint32_t n_msgs, int flags)
+{
+  vcl_worker_t *wrk = vcl_worker_get_current ();
+  u32 i, max_deq, offset = 0, len, n_read;
+  session_dgram_hdr_t hdr;
+  vcl_session_t *s = 0;
+  svm_fifo_t *rx_fifo;
+  u8 is_nonblocking;
+  int rv;
+
+  if (PREDICT_FALSE (!msgs || !n_msgs))
+    return VPPCOM_EINVAL;
+
+  if (PREDICT_FALSE (flags & ~(MSG_PEEK | MSG_DONTWAIT)))
+    {
+      VDBG (0, "Unsupported flags for recvmmsg %d", flags);
+      return VPPCOM_EAFNOSUPPORT;
+    }
+
+  s = vcl_session_get_w_handle (wrk, session_handle);
+  if (PREDICT_FALSE (!s || s->is_vep))
+    return VPPCOM_EBADFD;
+
+  if (PREDICT_FALSE (!vcl_session_is_open (s)))
+    {
+      VDBG (0, "session %u[0x%llx] is not open! state 0x%x (%s)",
+	    s->session_index, s->vpp_handle, s->session_state,
+	    vppcom_session_state_str (s->session_state));
+      return vcl_session_closed_error (s);
+    }
+
+  is_nonblocking = VCL_SESS_ATTR_TEST (s->attr, VCL_SESS_ATTR_NONBLOCK)
+    || (flags & MSG_DONTWAIT);
+  rx_fifo = vcl_session_is_ct (s) ? s->ct_rx_fifo : s->rx_fifo;
+  s->has_rx_evt = 0;
+
+  if ((rv = vcl_session_rx_wait (wrk, s, rx_fifo, is_nonblocking)))
+    return rv;
+
+  max_deq = svm_fifo_max_dequeue_cons (rx_fifo);
+
+  if (!s->is_dgram)
+    {
+      for (i = 0; i < n_msgs && offset < max_deq; i++)
+	{
+	  msgs[i].len = vcl_fifo_peek_iov (rx_fifo, offset, max_deq - offset,
+					   msgs[i].iov, msgs[i].iovcnt);
+	  offset += msgs[i].len;
+	}
+      goto done;
+    }
+
+  for (i = 0; i < n_msgs; i++)
+    {
+      if (max_deq - offset < SESSION_CONN_HDR_LEN)
+	break;
+      svm_fifo_peek (rx_fifo, offset, sizeof (hdr), (u8 *) & hdr);
+      ASSERT (hdr.data_length >= hdr.data_offset);
+      len = hdr.data_length - hdr.data_offset;
+
+      /* Producers enqueue headers and payloads together */
+      ASSERT (max_deq - offset >= SESSION_CONN_HDR_LEN + hdr.data_length);
+
+      n_read = vcl_fifo_peek_iov (rx_fifo, offset + SESSION_CONN_HDR_LEN
+				  + hdr.data_offset, len, msgs[i].iov,
+				  msgs[i].iovcnt);
+      msgs[i].len = n_read;
+      if (msgs[i].ep)
+	vcl_dgram_hdr_to_ep (&hdr, msgs[i].ep);
+
+      /* Like reads, keep track of the last peer */
+      if (!(flags & MSG_PEEK))
+	{
+	  s->transport.is_ip4 = hdr.is_ip4;
+	  s->transport.rmt_port = hdr.rmt_port;
+	  clib_memcpy_fast (&s->transport.rmt_ip, &hdr.rmt_ip,
+			    sizeof (ip46_address_t));
+	}
+
+      /* Remainder of truncated datagrams is discarded */
+      offset += SESSION_CONN_HDR_LEN + hdr.data_length;
+    }
+
+done:
+
+  if (!(flags & MSG_PEEK) && offset)
+    svm_fifo_dequeue_drop (rx_fifo, offset);
+
+  vcl_session_rx_done (s, rx_fifo);
+
+  VDBG (2, "session %u[0x%llx]: read %u msgs, %u bytes from (%p)",
+	s->session_index, s->vpp_handle, i, offset, rx_fifo);
+
+  return i;
+}
+
+/**
+ * Send multiple messages with only one fifo enqueue and at most one event
+ *
+ * For datagram sessions each message is sent as one datagram and, like for
+ * writes, only the first one may be truncated if the fifo lacks space. Only
+ * the connected peer is accepted as destination.
+ *
+ * @return number of messages sent or error
+ */
+int
+vppcom_session_sendmmsg (uint32_t session_handle, vppcom_msg_t * msgs,
+			 uint32_t n_msgs, int flags)
+{
+  vcl_worker_t *wrk = vcl_worker_get_current ();
+  u32 i, j, max_enq, n_bytes = 0, len, n_seg_bytes;
+  session_dgram_hdr_t *hdr;
+  svm_fifo_seg_t *seg;
+  session_evt_type_t et;
+  vcl_session_t *s = 0;
+  svm_fifo_t *tx_fifo;
+  u8 is_nonblocking;
+  int rv;
+
+  if (PREDICT_FALSE (!msgs || !n_msgs))
+    return VPPCOM_EINVAL;
+
+  s = vcl_session_get_w_handle (wrk, session_handle);
+  if (PREDICT_FALSE (!s || s->is_vep))
+    return VPPCOM_EBADFD;
+
+  if (PREDICT_FALSE (!vcl_session_is_open (s)))
+    {
+      VDBG (1, "session %u [0x%llx]: is not open! state 0x%x (%s)",
+	    s->session_index, s->vpp_handle, s->session_state,
+	    vppcom_session_state_str (s->session_state));
+      return vcl_session_closed_error (s);
+    }
+
+  for (i = 0; i < n_msgs; i++)
+    if (msgs[i].ep && !vcl_session_ep_is_peer (s, msgs[i].ep))
+      return VPPCOM_EINVAL;
+
+  tx_fifo = vcl_session_is_ct (s) ? s->ct_tx_fifo : s->tx_fifo;
+  is_nonblocking = VCL_SESS_ATTR_TEST (s->attr, VCL_SESS_ATTR_NONBLOCK)
+    || (flags & MSG_DONTWAIT);
+
+  if ((rv = vcl_session_tx_wait (wrk, s, tx_fifo, is_nonblocking)))
+    return rv;
+
+  max_enq = svm_fifo_max_enqueue_prod (tx_fifo);
+  if (s->is_dgram)
+    {
+      if (max_enq <= sizeof (session_dgram_hdr_t))
+	return VPPCOM_EWOULDBLOCK;
+      /* Headers must not move once referenced by segments */
+      vec_validate (wrk->tx_dgram_hdrs, n_msgs - 1);
+    }
+
+  vec_reset_length (wrk->tx_segs);
+  for (i = 0; i < n_msgs && n_bytes < max_enq; i++)
+    {
+      len = vcl_iov_len (msgs[i].iov, msgs[i].iovcnt);
+      if (s->is_dgram)
+	{
+	  if (n_bytes + sizeof (*hdr) + len > max_enq)
+	    {
+	      if (i)
+		break;
+	      len = max_enq - sizeof (*hdr);
+	    }
+	  hdr = &wrk->tx_dgram_hdrs[i];
+	  app_session_dgram_hdr_init (hdr, &s->transport, len);
+	  vec_add2 (wrk->tx_segs, seg, 1);
+	  seg->data = (u8 *) hdr;
+	  seg->len = sizeof (*hdr);
+	  n_bytes += sizeof (*hdr);
+	}
+      else
+	len = clib_min (len, max_enq - n_bytes);
+
+      msgs[i].len = len;
+      for (j = 0, n_seg_bytes = 0; n_seg_bytes < len; j++)
+	{
+	  if (!msgs[i].iov[j].iov_len)
+	    continue;
+	  vec_add2 (wrk->tx_segs, seg, 1);
+	  seg->data = msgs[i].iov[j].iov_base;
+	  seg->len = clib_min (msgs[i].iov[j].iov_len, len - n_seg_bytes);
+	  n_seg_bytes += seg->len;
+	}
+      n_bytes += len;
+    }
+
+  rv = svm_fifo_enqueue_segments (tx_fifo, wrk->tx_segs,
+				  vec_len (wrk->tx_segs), 0 /* partial */ );
+  ASSERT (rv == n_bytes);
+
+  et = vcl_session_is_ct (s) ? SESSION_IO_EVT_TX : SESSION_IO_EVT_TX_FLUSH;
+  if (svm_fifo_set_event (s->tx_fifo))
+    app_send_io_evt_to_vpp (s->vpp_evt_q, s->tx_fifo->master_session_index,
+			    et, SVM_Q_WAIT);
+
+  VDBG (2, "session %u [0x%llx]: wrote %u msgs, %u bytes", s->session_index,
+	s->vpp_handle, i, n_bytes);
+
+  return i;
+}
+
+int
+vppcom_session_readv (uint32_t session_handle, const struct iovec *iov,
+		      int iovcnt)
+{
+  vppcom_msg_t msg = {
+    .iov = (struct iovec *) iov,
+    .iovcnt = iovcnt,
+  };
+  int rv;
+
+  if (PREDICT_FALSE (!iov || iovcnt <= 0))
+    return VPPCOM_EINVAL;
+
+  rv = vppcom_session_recvmmsg (session_handle, &msg, 1, 0);
+  if (rv <= 0)
+    return rv ? rv : VPPCOM_EWOULDBLOCK;
+  return msg.len;
+}
+
+int
+vppcom_session_writev (uint32_t session_handle, const struct iovec *iov,
+		       int iovcnt)
+{
+  vppcom_msg_t msg = {
+    .iov = (struct iovec *) iov,
+    .iovcnt = iovcnt,
+  };
+  int rv;
+
+  if (PREDICT_FALSE (!iov || iovcnt <= 0))
+    return VPPCOM_EINVAL;
+
+  rv = vppcom_session_sendmmsg (session_handle, &msg, 1, 0);
+  if (rv <= 0)
+    return rv ? rv : VPPCOM_EWOULDBLOCK;
+  return msg.len;
+}
+
+static inline void
+vcl_fifo_segs_write (svm_fifo_seg_t * segs, u32 n_segs, u8 * src, u32 len)
+{
+  u32 i, n_copy;
+
+  for (i = 0; i < n_segs && len; i++)
+    {
+      n_copy = clib_min (segs[i].len, len);
+      clib_memcpy_fast (segs[i].data, src, n_copy);
+      src += n_copy;
+      len -= n_copy;
+    }
+}
+
+/**
+ * Read from a file into the fifo's iovecs
+ *
+ * Issues the system calls directly. If preloaded, the libc readv and
+ * preadv symbols resolve to ldp's overrides, which would re-enter vcl.
+ */
+static ssize_t
+vcl_file_readv (int fd, struct iovec *iov, int n_iov, off_t * offset)
+{
+  u64 pos;
+
+  if (!offset)
+    return syscall (SYS_readv, fd, iov, n_iov);
+
+  /* Kernel expects the offset split in low and high words */
+  pos = *offset;
+  return syscall (SYS_preadv, fd, iov, n_iov, (long) pos,
+		  (long) (pos >> 32));
+}
+
+/**
+ * Send data from file descriptor without intermediate copies
+ *
+ * Data is read from the file directly into the session's tx fifo. If offset
+ * is provided, data is read starting at offset and the offset is updated,
+ * without changing the file's position. Otherwise, data is read from the
+ * file's current position. Like writes, blocks if the session is not
+ * non-blocking and the tx fifo is full. For datagram sessions, each read
+ * from the file is sent as one datagram.
+ *
+ * @return number of bytes sent or error
+ */
+int
+vppcom_session_sendfile (uint32_t session_handle, int fd, off_t * offset,
+			 size_t len)
+{
+  vcl_worker_t *wrk = vcl_worker_get_current ();
+  svm_fifo_seg_t segs[VCL_SENDFILE_MAX_SEGS];
+  struct iovec iov[VCL_SENDFILE_MAX_SEGS];
+  u32 i, n_segs, n_iov, max_enq, hdr_len, skip;
+  session_dgram_hdr_t hdr;
+  session_evt_type_t et;
+  vcl_session_t *s = 0;
+  svm_fifo_t *tx_fifo;
+  u8 is_nonblocking;
+  size_t n_sent = 0;
+  ssize_t n_read;
+  int rv;
+
+  s = vcl_session_get_w_handle (wrk, session_handle);
+  if (PREDICT_FALSE (!s || s->is_vep))
+    return VPPCOM_EBADFD;
+
+  if (PREDICT_FALSE (!vcl_session_is_open (s)))
+    {
+      VDBG (1, "session %u [0x%llx]: is not open! state 0x%x (%s)",
+	    s->session_index, s->vpp_handle, s->session_state,
+	    vppcom_session_state_str (s->session_state));
+      return vcl_session_closed_error (s);
+    }
+
+  tx_fifo = vcl_session_is_ct (s) ? s->ct_tx_fifo : s->tx_fifo;
+  is_nonblocking = VCL_SESS_ATTR_TEST (s->attr, VCL_SESS_ATTR_NONBLOCK);
+  et = vcl_session_is_ct (s) ? SESSION_IO_EVT_TX : SESSION_IO_EVT_TX_FLUSH;
+  hdr_len = s->is_dgram ? sizeof (session_dgram_hdr_t) : 0;
+  len = clib_min (len, INT32_MAX);
+
+  while (n_sent < len)
+    {
+      if ((rv = vcl_session_tx_wait (wrk, s, tx_fifo, is_nonblocking)))
+	return n_sent ? n_sent : rv;
+
+      max_enq = svm_fifo_max_enqueue_prod (tx_fifo);
+      if (PREDICT_FALSE (max_enq <= hdr_len))
+	return n_sent ? n_sent : VPPCOM_EWOULDBLOCK;
+
+      n_segs = svm_fifo_tail_segments (tx_fifo, segs, VCL_SENDFILE_MAX_SEGS,
+				       clib_min (len - n_sent,
+						 max_enq - hdr_len) +
+				       hdr_len);
+
+      /* Leave room for the datagram header, if needed */
+      for (i = 0, n_iov = 0, skip = hdr_len; i < n_segs; i++)
+	{
+	  if (segs[i].len <= skip)
+	    {
+	      skip -= segs[i].len;
+	      continue;
+	    }
+	  iov[n_iov].iov_base = segs[i].data + skip;
+	  iov[n_iov].iov_len = segs[i].len - skip;
+	  skip = 0;
+	  n_iov += 1;
+	}
+
+      n_read = vcl_file_readv (fd, iov, n_iov, offset);
+
+      if (n_read <= 0)
+	{
+	  if (n_read < 0 && !n_sent)
+	    return -errno;
+	  break;
+	}
+
+      if (hdr_len)
+	{
+	  app_session_dgram_hdr_init (&hdr, &s->transport, n_read);
+	  vcl_fifo_segs_write (segs, n_segs, (u8 *) & hdr, hdr_len);
+	}
+      svm_fifo_enqueue_nocopy (tx_fifo, hdr_len + n_read);
+
+      if (svm_fifo_set_event (s->tx_fifo))
+	app_send_io_evt_to_vpp (s->vpp_evt_q,
+				s->tx_fifo->master_session_index, et,
+				SVM_Q_WAIT);
+
+      if (offset)
+	*offset += n_read;
+      n_sent += n_read;
+    }
+
+  VDBG (2, "session %u [0x%llx]: sent %lu bytes from fd %d",
+	s->session_index, s->vpp_handle, n_sent, fd);
+
+  return n_sent;
+}
+
 #define vcl_fifo_rx_evt_valid_or_break(_s)				\
 if (PREDICT_FALSE (svm_fifo_is_empty (_s->rx_fifo)))			\
   {									\
@@ -2360,6 +2865,8 @@ vcl_epoll_wait_handle_mq_event (vcl_worker_t * wrk, session_event_t * e,
   vcl_session_t *session;
   u8 add_event = 0;
 
+  clib_spinlock_lock_if_init (&wrk->mq_evt_lock);
+
   switch (e->event_type)
     {
     case SESSION_IO_EVT_RX:
@@ -2462,6 +2969,7 @@ vcl_epoll_wait_handle_mq_event (vcl_worker_t * wrk, session_event_t * e,
 	}
       *num_ev += 1;
     }
+  clib_spinlock_unlock_if_init (&wrk->mq_evt_lock);
 }
 
 static int
@@ -3370,6 +3878,12 @@ vppcom_worker_index (void)
   return vcl_get_worker_index ();
 }
 
+int
+vppcom_max_workers (void)
+{
+  return vcm->cfg.max_workers;
+}
+
 int
 vppcom_worker_mqs_epfd (void)
 {
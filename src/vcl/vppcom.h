@@ -20,6 +20,7 @@
 #include <errno.h>
 #include <sys/poll.h>
 #include <sys/epoll.h>
+#include <sys/uio.h>
 
 /* *INDENT-OFF* */
 #ifdef __cplusplus
@@ -172,6 +173,14 @@ typedef struct vppcom_data_segment_
 
 typedef vppcom_data_segment_t vppcom_data_segments_t[2];
 
+typedef struct vppcom_msg_
+{
+  struct iovec *iov;		/**< Scatter/gather array */
+  uint32_t iovcnt;		/**< Number of elements in iov */
+  uint32_t len;			/**< Bytes sent or received */
+  vppcom_endpt_t *ep;		/**< Optional remote endpoint */
+} vppcom_msg_t;
+
 typedef unsigned long vcl_si_set;
 
 /*
@@ -259,6 +268,18 @@ extern int vppcom_session_write (uint32_t session_handle, void *buf,
 				 size_t n);
 extern int vppcom_session_write_msg (uint32_t session_handle, void *buf,
 				     size_t n);
+extern int vppcom_session_readv (uint32_t session_handle,
+				 const struct iovec *iov, int iovcnt);
+extern int vppcom_session_writev (uint32_t session_handle,
+				  const struct iovec *iov, int iovcnt);
+extern int vppcom_session_recvmmsg (uint32_t session_handle,
+				    vppcom_msg_t * msgs, uint32_t n_msgs,
+				    int flags);
+extern int vppcom_session_sendmmsg (uint32_t session_handle,
+				    vppcom_msg_t * msgs, uint32_t n_msgs,
+				    int flags);
+extern int vppcom_session_sendfile (uint32_t session_handle, int fd,
+				    off_t * offset, size_t len);
 
 extern int vppcom_select (int n_bits, vcl_si_set * read_map,
 			  vcl_si_set * write_map, vcl_si_set * except_map,
@@ -313,6 +334,11 @@ extern void vppcom_worker_unregister (void);
  */
 extern int vppcom_worker_index (void);
 
+/**
+ * Retrieve max number of workers, as configured
+ */
+extern int vppcom_max_workers (void);
+
 /**
  * Returns the current worker's message queues epoll fd
  *
@@ -503,7 +503,7 @@ vlib_buffer_pool_create (vlib_main_t * vm, char *name, u32 data_size,
   uword start = pointer_to_uword (m->base);
   uword size = (uword) m->n_pages << m->log2_page_size;
   uword i, j;
-  u32 alloc_size, n_alloc_per_page;
+  u32 alloc_size, n_alloc_per_page, n_magazines;
 
   if (vec_len (bm->buffer_pools) >= 255)
     return ~0;
@@ -576,16 +576,71 @@ vlib_buffer_pool_create (vlib_main_t * vm, char *name, u32 data_size,
       }
 
   bp->n_buffers = vec_len (bp->buffers);
+
+  /* one spare magazine for the partially filled one and one so that a
+     thread flushing its cache never finds the empty stack drained */
+  n_magazines = bp->n_buffers / VLIB_BUFFER_POOL_MAGAZINE_SIZE + 2;
+  vec_validate (bp->magazines, n_magazines - 1);
+  bp->full_magazines = bp->empty_magazines = ~0;
+
+  /* sized for all buffers so spilling to it never allocates */
+  vec_validate_aligned (bp->free_buffers, bp->n_buffers,
+			CLIB_CACHE_LINE_BYTES);
+  vec_reset_length (bp->free_buffers);
+
+  for (i = 0; i < n_magazines; i++)
+    {
+      vlib_buffer_magazine_t *mag = bp->magazines + i;
+      u32 n_left, offset = i * VLIB_BUFFER_POOL_MAGAZINE_SIZE;
+      vlib_buffer_magazine_stack_t head;
+
+      n_left = offset < bp->n_buffers ? bp->n_buffers - offset : 0;
+      mag->n_buffers = clib_min (n_left, VLIB_BUFFER_POOL_MAGAZINE_SIZE);
+      clib_memcpy_fast (mag->buffers, bp->buffers + offset,
+			mag->n_buffers * sizeof (u32));
+
+      /* single threaded here, no need to bump the tags */
+      if (mag->n_buffers)
+	{
+	  head.as_u64 = bp->full_magazines;
+	  mag->next = head.index;
+	  bp->full_magazines = i;
+	}
+      else
+	{
+	  head.as_u64 = bp->empty_magazines;
+	  mag->next = head.index;
+	  bp->empty_magazines = i;
+	}
+    }
+
   return bp->index;
 }
 
+static u32
+vlib_buffer_pool_get_n_avail (vlib_buffer_pool_t * bp)
+{
+  vlib_buffer_pool_thread_t *bpt;
+  u64 n_get = 0, n_put = 0;
+
+  /* *INDENT-OFF* */
+  vec_foreach (bpt, bp->threads)
+    {
+      n_get += bpt->n_buffers_get;
+      n_put += bpt->n_buffers_put;
+    }
+  /* *INDENT-ON* */
+
+  return bp->n_buffers + n_put - n_get;
+}
+
 static u8 *
 format_vlib_buffer_pool (u8 * s, va_list * va)
 {
   vlib_main_t *vm = va_arg (*va, vlib_main_t *);
   vlib_buffer_pool_t *bp = va_arg (*va, vlib_buffer_pool_t *);
   vlib_buffer_pool_thread_t *bpt;
-  u32 cached = 0;
+  u32 cached = 0, avail;
 
   if (!bp)
     return format (s, "%-20s%=6s%=6s%=6s%=11s%=6s%=8s%=8s%=8s",
@@ -597,11 +652,31 @@ format_vlib_buffer_pool (u8 * s, va_list * va)
     cached += vec_len (bpt->cached_buffers);
   /* *INDENT-ON* */
 
+  avail = vlib_buffer_pool_get_n_avail (bp);
   s = format (s, "%-20s%=6d%=6d%=6u%=11u%=6u%=8u%=8u%=8u",
 	      bp->name, bp->index, bp->numa_node, bp->data_size +
 	      sizeof (vlib_buffer_t) + vm->buffer_main->ext_hdr_size,
-	      bp->data_size, bp->n_buffers, vec_len (bp->buffers), cached,
-	      bp->n_buffers - vec_len (bp->buffers) - cached);
+	      bp->data_size, bp->n_buffers, avail, cached,
+	      bp->n_buffers - avail - cached);
+
+  return s;
+}
+
+static u8 *
+format_vlib_buffer_pool_thread (u8 * s, va_list * va)
+{
+  vlib_buffer_pool_t *bp = va_arg (*va, vlib_buffer_pool_t *);
+  vlib_buffer_pool_thread_t *bpt = va_arg (*va, vlib_buffer_pool_thread_t *);
+
+  if (!bpt)
+    return format (s, "%-20s%=8s%=8s%=12s%=12s%=10s%=10s%=10s%=10s",
+		   "Pool Name", "Thread", "Cached", "Alloc", "Free",
+		   "Refills", "Flushes", "Retries", "Empty");
+
+  s = format (s, "%-20s%=8u%=8u%=12lu%=12lu%=10lu%=10lu%=10lu%=10lu",
+	      bp->name, bpt - bp->threads, vec_len (bpt->cached_buffers),
+	      bpt->n_alloc, bpt->n_free, bpt->n_magazines_get,
+	      bpt->n_magazines_put, bpt->n_cas_retries, bpt->n_pool_empty);
 
   return s;
 }
@@ -611,7 +686,18 @@ show_buffers (vlib_main_t * vm,
 	      unformat_input_t * input, vlib_cli_command_t * cmd)
 {
   vlib_buffer_main_t *bm = vm->buffer_main;
+  vlib_buffer_pool_thread_t *bpt;
   vlib_buffer_pool_t *bp;
+  u8 verbose = 0;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "verbose"))
+	verbose = 1;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
 
   vlib_cli_output (vm, "%U", format_vlib_buffer_pool, vm, 0);
 
@@ -620,13 +706,33 @@ show_buffers (vlib_main_t * vm,
     vlib_cli_output (vm, "%U", format_vlib_buffer_pool, vm, bp);
   /* *INDENT-ON* */
 
+  if (!verbose)
+    return 0;
+
+  vlib_cli_output (vm, "\n%U", format_vlib_buffer_pool_thread, 0, 0);
+
+  /* *INDENT-OFF* */
+  vec_foreach (bp, bm->buffer_pools)
+    vec_foreach (bpt, bp->threads)
+      vlib_cli_output (vm, "%U", format_vlib_buffer_pool_thread, bp, bpt);
+  /* *INDENT-ON* */
+
   return 0;
 }
 
+/*?
+ * Show packet buffer pools. With verbose, also show per thread cache
+ * occupancy, alloc/free counts, magazines taken from (refills) and
+ * returned to (flushes) the global pool, contended magazine swaps
+ * (retries) and refills that found the global pool empty.
+ *
+ * @cliexpar
+ * @cliexcmd{show buffers verbose}
+?*/
 /* *INDENT-OFF* */
 VLIB_CLI_COMMAND (show_buffers_command, static) = {
   .path = "show buffers",
-  .short_help = "Show packet buffer allocation",
+  .short_help = "show buffers [verbose]",
   .function = show_buffers,
 };
 /* *INDENT-ON* */
@@ -758,7 +864,8 @@ buffer_gauges_update_used_fn (stat_segment_directory_entry_t * e, u32 index)
   if (!bp)
     return;
 
-  e->value = bp->n_buffers - vec_len (bp->buffers) - buffer_get_cached (bp);
+  e->value = bp->n_buffers - vlib_buffer_pool_get_n_avail (bp) -
+    buffer_get_cached (bp);
 }
 
 static void
@@ -770,7 +877,7 @@ buffer_gauges_update_available_fn (stat_segment_directory_entry_t * e,
   if (!bp)
     return;
 
-  e->value = vec_len (bp->buffers);
+  e->value = vlib_buffer_pool_get_n_avail (bp);
 }
 
 static void
@@ -411,12 +411,46 @@ vlib_buffer_pull (vlib_buffer_t * b, u8 size)
 /* Forward declaration. */
 struct vlib_main_t;
 
+/* Number of buffer indices moved between a thread cache and the global
+   pool in one go. Same as VLIB_FRAME_SIZE */
+#define VLIB_BUFFER_POOL_MAGAZINE_SIZE 256
+
+typedef struct
+{
+  /* next magazine on the full or empty stack */
+  u32 next;
+  u32 n_buffers;
+  u32 buffers[VLIB_BUFFER_POOL_MAGAZINE_SIZE];
+} vlib_buffer_magazine_t;
+
+/* Head of a lock-free stack of magazines. The tag is bumped on every
+   update so that a stale head can't be swapped in (ABA) */
+typedef union
+{
+  struct
+  {
+    u32 index;
+    u32 tag;
+  };
+  u64 as_u64;
+} vlib_buffer_magazine_stack_t;
+
 typedef struct
 {
   CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
   u32 *cached_buffers;
-  u32 n_alloc;
+
+  /* stats, only updated by the owner thread */
+  u64 n_alloc;
+  u64 n_free;
+  u64 n_magazines_get;
+  u64 n_magazines_put;
+  u64 n_buffers_get;
+  u64 n_buffers_put;
+  u64 n_cas_retries;
+  u64 n_pool_empty;
 } vlib_buffer_pool_thread_t;
+
 typedef struct
 {
   CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
@@ -428,13 +462,28 @@ typedef struct
   u32 physmem_map_index;
   u32 data_size;
   u32 n_buffers;
+  /* all buffers in the pool, not modified after the pool is created */
   u32 *buffers;
   u8 *name;
   clib_spinlock_t lock;
 
+  /* global free buffers, kept in magazines */
+  vlib_buffer_magazine_t *magazines;
+
+  /* global free buffers which found no empty magazine, protected by the
+     lock */
+  u32 *free_buffers;
+
   /* per-thread data */
   vlib_buffer_pool_thread_t *threads;
 
+  /* magazine stack heads, on their own cache lines as they are the only
+     fields written by all threads */
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline1);
+  volatile u64 full_magazines;
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline2);
+  volatile u64 empty_magazines;
+
   /* buffer metadata template */
   vlib_buffer_t buffer_template;
 } vlib_buffer_pool_t;
@@ -481,34 +481,95 @@ vlib_get_buffer_pool (vlib_main_t * vm, u8 buffer_pool_index)
   return vec_elt_at_index (bm->buffer_pools, buffer_pool_index);
 }
 
+/* Pop a magazine from the full or empty stack, returns ~0 if empty.
+   The popped magazine is owned by the caller until pushed back. */
+static_always_inline u32
+vlib_buffer_magazine_pop (vlib_buffer_pool_t * bp, volatile u64 * head,
+			  vlib_buffer_pool_thread_t * bpt)
+{
+  vlib_buffer_magazine_stack_t old, new;
+
+  old.as_u64 = clib_atomic_load_acq_n (head);
+  while (old.index != ~0)
+    {
+      /* next may be stale if another thread got here first, the tag
+         makes sure the swap fails in that case */
+      new.index = *(volatile u32 *) &bp->magazines[old.index].next;
+      new.tag = old.tag + 1;
+      if (clib_atomic_bool_cmp_and_swap (head, old.as_u64, new.as_u64))
+	return old.index;
+      bpt->n_cas_retries++;
+      old.as_u64 = clib_atomic_load_acq_n (head);
+    }
+  return ~0;
+}
+
+static_always_inline void
+vlib_buffer_magazine_push (vlib_buffer_pool_t * bp, volatile u64 * head,
+			   u32 magazine_index, vlib_buffer_pool_thread_t * bpt)
+{
+  vlib_buffer_magazine_stack_t old, new;
+
+  new.index = magazine_index;
+  old.as_u64 = clib_atomic_load_acq_n (head);
+  while (1)
+    {
+      bp->magazines[magazine_index].next = old.index;
+      new.tag = old.tag + 1;
+      if (clib_atomic_bool_cmp_and_swap (head, old.as_u64, new.as_u64))
+	return;
+      bpt->n_cas_retries++;
+      old.as_u64 = clib_atomic_load_acq_n (head);
+    }
+}
+
+/* Take up to n_buffers buffers from the global pool, in whole magazines */
 static_always_inline uword
 vlib_buffer_pool_get (vlib_main_t * vm, u8 buffer_pool_index, u32 * buffers,
 		      u32 n_buffers)
 {
   vlib_buffer_pool_t *bp = vlib_get_buffer_pool (vm, buffer_pool_index);
-  u32 len;
+  vlib_buffer_pool_thread_t *bpt =
+    vec_elt_at_index (bp->threads, vm->thread_index);
+  vlib_buffer_magazine_t *m;
+  u32 mi, n = 0;
 
-  ASSERT (bp->buffers);
+  ASSERT (bp->magazines);
 
-  clib_spinlock_lock (&bp->lock);
-  len = vec_len (bp->buffers);
-  if (PREDICT_TRUE (n_buffers < len))
+  while (n + VLIB_BUFFER_POOL_MAGAZINE_SIZE <= n_buffers)
     {
-      len -= n_buffers;
-      vlib_buffer_copy_indices (buffers, bp->buffers + len, n_buffers);
-      _vec_len (bp->buffers) = len;
-      clib_spinlock_unlock (&bp->lock);
-      return n_buffers;
+      mi = vlib_buffer_magazine_pop (bp, &bp->full_magazines, bpt);
+      if (PREDICT_FALSE (mi == ~0))
+	{
+	  bpt->n_pool_empty++;
+	  break;
+	}
+      m = bp->magazines + mi;
+      vlib_buffer_copy_indices (buffers + n, m->buffers, m->n_buffers);
+      n += m->n_buffers;
+      m->n_buffers = 0;
+      vlib_buffer_magazine_push (bp, &bp->empty_magazines, mi, bpt);
+      bpt->n_magazines_get++;
     }
-  else
+
+  /* buffers spilled by vlib_buffer_pool_put () */
+  if (PREDICT_FALSE (n < n_buffers && vec_len (bp->free_buffers)))
     {
-      vlib_buffer_copy_indices (buffers, bp->buffers, len);
-      _vec_len (bp->buffers) = 0;
+      u32 len, n_copy;
+
+      clib_spinlock_lock (&bp->lock);
+      len = vec_len (bp->free_buffers);
+      n_copy = clib_min (len, n_buffers - n);
+      vlib_buffer_copy_indices (buffers + n, bp->free_buffers + len - n_copy,
+				n_copy);
+      _vec_len (bp->free_buffers) -= n_copy;
       clib_spinlock_unlock (&bp->lock);
-      return len;
+      n += n_copy;
     }
-}
 
+  bpt->n_buffers_get += n;
+  return n;
+}
 
 /** \brief Allocate buffers from specific pool into supplied array
 
@@ -541,6 +602,7 @@ vlib_buffer_alloc_from_pool (vlib_main_t * vm, u32 * buffers, u32 n_buffers,
       src = bpt->cached_buffers + len - n_buffers;
       vlib_buffer_copy_indices (dst, src, n_buffers);
       _vec_len (bpt->cached_buffers) -= n_buffers;
+      bpt->n_alloc += n_buffers;
 
       if (CLIB_DEBUG > 0)
 	vlib_buffer_validate_alloc_free (vm, buffers, n_buffers,
@@ -557,7 +619,7 @@ vlib_buffer_alloc_from_pool (vlib_main_t * vm, u32 * buffers, u32 n_buffers,
       n_left -= len;
     }
 
-  len = round_pow2 (n_left, 32);
+  len = round_pow2 (n_left, VLIB_BUFFER_POOL_MAGAZINE_SIZE);
   vec_validate_aligned (bpt->cached_buffers, len - 1, CLIB_CACHE_LINE_BYTES);
   len = vlib_buffer_pool_get (vm, buffer_pool_index, bpt->cached_buffers,
 			      len);
@@ -573,6 +635,7 @@ vlib_buffer_alloc_from_pool (vlib_main_t * vm, u32 * buffers, u32 n_buffers,
     }
 
   n_buffers -= n_left;
+  bpt->n_alloc += n_buffers;
 
   /* Verify that buffers are known free. */
   if (CLIB_DEBUG > 0)
@@ -691,15 +754,36 @@ vlib_buffer_pool_put (vlib_main_t * vm, u8 buffer_pool_index,
   vec_add_aligned (bpt->cached_buffers, buffers, n_buffers,
 		   CLIB_CACHE_LINE_BYTES);
 
-  if (vec_len (bpt->cached_buffers) > 4 * VLIB_FRAME_SIZE)
+  bpt->n_free += n_buffers;
+
+  if (vec_len (bpt->cached_buffers) > 4 * VLIB_BUFFER_POOL_MAGAZINE_SIZE)
     {
-      clib_spinlock_lock (&bp->lock);
+      vlib_buffer_magazine_t *m;
+      u32 mi;
+
+      /* there are enough magazines for all buffers, but other threads may
+         be holding the empty ones between pop and push */
+      mi = vlib_buffer_magazine_pop (bp, &bp->empty_magazines, bpt);
+      if (PREDICT_FALSE (mi == ~0))
+	{
+	  clib_spinlock_lock (&bp->lock);
+	  vec_add (bp->free_buffers, bpt->cached_buffers,
+		   VLIB_BUFFER_POOL_MAGAZINE_SIZE);
+	  clib_spinlock_unlock (&bp->lock);
+	  vec_delete (bpt->cached_buffers, VLIB_BUFFER_POOL_MAGAZINE_SIZE, 0);
+	  bpt->n_buffers_put += VLIB_BUFFER_POOL_MAGAZINE_SIZE;
+	  return;
+	}
+
       /* keep last stored buffers, as they are more likely hot in the cache */
-      vec_add_aligned (bp->buffers, bpt->cached_buffers, VLIB_FRAME_SIZE,
-		       CLIB_CACHE_LINE_BYTES);
-      vec_delete (bpt->cached_buffers, VLIB_FRAME_SIZE, 0);
-      bpt->n_alloc -= VLIB_FRAME_SIZE;
-      clib_spinlock_unlock (&bp->lock);
+      m = bp->magazines + mi;
+      vlib_buffer_copy_indices (m->buffers, bpt->cached_buffers,
+				VLIB_BUFFER_POOL_MAGAZINE_SIZE);
+      m->n_buffers = VLIB_BUFFER_POOL_MAGAZINE_SIZE;
+      vec_delete (bpt->cached_buffers, VLIB_BUFFER_POOL_MAGAZINE_SIZE, 0);
+      vlib_buffer_magazine_push (bp, &bp->full_magazines, mi, bpt);
+      bpt->n_magazines_put++;
+      bpt->n_buffers_put += VLIB_BUFFER_POOL_MAGAZINE_SIZE;
     }
 }
 
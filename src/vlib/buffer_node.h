@@ -483,6 +483,105 @@ next:
   vlib_put_next_frame (vm, node, next_index, n_left_to_next);
 }
 
+/*
+ * Enqueue to the handoff rings. Packets are written to each receiver's
+ * ring and the ring heads are published once, at the end. A full ring
+ * is waited on until there is space. Callers that drop on congestion
+ * wait at most VLIB_HANDOFF_RING_MAX_WAIT, and what still does not fit
+ * is dropped and counted.
+ */
+static_always_inline u32
+vlib_buffer_enqueue_to_handoff_ring (vlib_main_t * vm,
+				     vlib_frame_queue_main_t * fqm,
+				     u32 * buffer_indices,
+				     u16 * thread_indices, u32 n_packets,
+				     int drop_on_congestion)
+{
+  vlib_frame_queue_per_thread_data_t *ptd;
+  u32 drop_list[VLIB_FRAME_SIZE], *dbi = drop_list, n_drop = 0;
+  u32 next_thread_index, current_thread_index = ~0;
+  u32 n_left = n_packets, credits = 0, head = 0;
+  uword congested[VLIB_MAX_CPUS / BITS (uword)] = { 0 };
+  vlib_handoff_ring_t *r = 0;
+  int i;
+
+  ptd = vec_elt_at_index (fqm->per_thread_data, vm->thread_index);
+
+  while (n_left)
+    {
+      next_thread_index = thread_indices[0];
+
+      if (next_thread_index != current_thread_index)
+	{
+	  if (r)
+	    ptd->ring_head_by_thread_index[current_thread_index] = head;
+
+	  r = vlib_get_handoff_ring (fqm, next_thread_index,
+				     vm->thread_index);
+	  head = ptd->ring_head_by_thread_index[next_thread_index];
+	  credits = r->size - (head - r->tail_cache);
+	  current_thread_index = next_thread_index;
+	}
+
+      if (PREDICT_FALSE (0 == credits))
+	{
+	  r->tail_cache = clib_atomic_load_acq_n (&r->tail);
+	  credits = r->size - (head - r->tail_cache);
+
+	  /* wait at most once per receiver per call */
+	  if (0 == credits && !clib_bitmap_get_no_check (congested,
+							  current_thread_index))
+	    {
+	      ptd->ring_head_by_thread_index[current_thread_index] = head;
+	      credits = vlib_handoff_ring_wait (vm, fqm, current_thread_index,
+						drop_on_congestion);
+	      if (0 == credits)
+		clib_bitmap_set_no_check (congested, current_thread_index, 1);
+	    }
+	  if (0 == credits)
+	    {
+	      vlib_increment_simple_counter (&fqm->ring_drops,
+					     vm->thread_index,
+					     current_thread_index, 1);
+	      dbi[0] = buffer_indices[0];
+	      dbi++;
+	      n_drop++;
+	      goto next;
+	    }
+	}
+
+      r->buffer_indices[head & (r->size - 1)] = buffer_indices[0];
+      head++;
+      credits--;
+
+    next:
+      thread_indices += 1;
+      buffer_indices += 1;
+      n_left -= 1;
+    }
+
+  if (r)
+    ptd->ring_head_by_thread_index[current_thread_index] = head;
+
+  /* Publish to the receivers */
+  for (i = 0; i < vec_len (ptd->ring_head_by_thread_index); i++)
+    {
+      r = vlib_get_handoff_ring (fqm, i, vm->thread_index);
+      head = ptd->ring_head_by_thread_index[i];
+
+      if (head != r->head)
+	{
+	  clib_atomic_store_rel_n (&r->head, head);
+	  vlib_mains[i]->check_frame_queues = 1;
+	}
+    }
+
+  if (n_drop)
+    vlib_buffer_free (vm, drop_list, n_drop);
+
+  return n_packets - n_drop;
+}
+
 static_always_inline u32
 vlib_buffer_enqueue_to_thread (vlib_main_t * vm, u32 frame_queue_index,
 			       u32 * buffer_indices, u16 * thread_indices,
@@ -499,6 +598,12 @@ vlib_buffer_enqueue_to_thread (vlib_main_t * vm, u32 frame_queue_index,
   int i;
 
   fqm = vec_elt_at_index (tm->frame_queue_mains, frame_queue_index);
+
+  if (vec_len (fqm->rings))
+    return (vlib_buffer_enqueue_to_handoff_ring (vm, fqm, buffer_indices,
+						 thread_indices, n_packets,
+						 drop_on_congestion));
+
   ptd = vec_elt_at_index (fqm->per_thread_data, vm->thread_index);
 
   while (n_left)
@@ -1735,6 +1735,8 @@ vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
 	cpu_time_now = dispatch_process (vm, nm->processes[i], /* frame */ 0,
 					 cpu_time_now);
     }
+  else
+    vlib_rcu_thread_register (vm->thread_index);
 
   while (1)
     {
@@ -1749,6 +1751,7 @@ vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
       if (!is_main)
 	{
 	  vlib_worker_thread_barrier_check ();
+	  vlib_rcu_quiescent (vm);
 	  if (PREDICT_FALSE (vm->check_frame_queues +
 			     frame_queue_check_counter))
 	    {
@@ -1772,6 +1775,8 @@ vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
 	  if (PREDICT_FALSE (vec_len (vm->worker_thread_main_loop_callbacks)))
 	    clib_call_callbacks (vm->worker_thread_main_loop_callbacks, vm);
 	}
+      else if (PREDICT_FALSE (vec_len (vlib_rcu_main.deferred)))
+	vlib_rcu_poll (vm);
 
       /* Process pre-input nodes. */
       vec_foreach (n, nm->nodes_by_type[VLIB_NODE_TYPE_PRE_INPUT])
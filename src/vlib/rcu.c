@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) 2019 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vlib/vlib.h>
+#include <vlib/rcu.h>
+
+vlib_rcu_main_t vlib_rcu_main;
+
+/**
+ * The oldest epoch any registered thread may still be running in. The
+ * vlib threads are parked while the main thread holds the barrier.
+ */
+static u64
+vlib_rcu_quiescent_epoch (void)
+{
+  vlib_rcu_main_t *rm = &vlib_rcu_main;
+  u64 epoch = rm->epoch;
+  u32 i, n_threads = rm->n_threads;
+
+  i = vlib_thread_is_main_w_barrier ()? vec_len (vlib_mains) : 1;
+  for (; i < n_threads; i++)
+    if (rm->threads[i].is_registered)
+      epoch = clib_min (epoch,
+			clib_atomic_load_acq_n (&rm->threads[i].epoch));
+
+  return (epoch);
+}
+
+/**
+ * No registered thread can be reading: all of them are parked
+ */
+static int
+vlib_rcu_no_readers (void)
+{
+  return (vlib_thread_is_main_w_barrier () && 0 == vlib_rcu_main.n_foreign);
+}
+
+void
+vlib_rcu_thread_register (u32 thread_index)
+{
+  vlib_rcu_main_t *rm = &vlib_rcu_main;
+  vlib_rcu_thread_t *t;
+  u32 n_threads;
+
+  ASSERT (thread_index > 0 && thread_index < VLIB_MAX_CPUS);
+
+  t = &rm->threads[thread_index];
+  if (t->is_registered)
+    return;
+
+  if (thread_index >= vec_len (vlib_mains))
+    clib_atomic_fetch_add (&rm->n_foreign, 1);
+
+  while ((n_threads = rm->n_threads) <= thread_index)
+    if (clib_atomic_bool_cmp_and_swap (&rm->n_threads, n_threads,
+				       thread_index + 1))
+      break;
+
+  t->epoch = rm->epoch;
+  t->is_registered = 1;
+
+  /* a writer either sees the thread registered, or unpublished the data
+   * before the thread can read it */
+  CLIB_MEMORY_BARRIER ();
+}
+
+void
+vlib_rcu_thread_unregister (u32 thread_index)
+{
+  vlib_rcu_main_t *rm = &vlib_rcu_main;
+  vlib_rcu_thread_t *t;
+
+  ASSERT (thread_index > 0 && thread_index < VLIB_MAX_CPUS);
+
+  t = &rm->threads[thread_index];
+  if (!t->is_registered)
+    return;
+
+  clib_atomic_store_rel_n (&t->is_registered, 0);
+
+  if (thread_index >= vec_len (vlib_mains))
+    clib_atomic_fetch_sub (&rm->n_foreign, 1);
+}
+
+static void
+vlib_rcu_run (vlib_rcu_deferred_t * d)
+{
+  void *old_heap;
+
+  old_heap = clib_mem_set_heap (d->heap);
+  d->fn (d->data);
+  clib_mem_set_heap (old_heap);
+
+  vlib_rcu_main.n_reclaimed++;
+}
+
+/**
+ * Run the deferred callbacks up to and including those of the epoch
+ */
+static void
+vlib_rcu_run_until (u64 epoch)
+{
+  vlib_rcu_main_t *rm = &vlib_rcu_main;
+  vlib_rcu_deferred_t *deferred;
+  u32 i, n;
+
+  for (n = 0; n < vec_len (rm->deferred); n++)
+    if (rm->deferred[n].epoch > epoch)
+      break;
+
+  if (0 == n)
+    return;
+
+  /* the callbacks may defer more work, so detach the ones that are due */
+  deferred = 0;
+  vec_add (deferred, rm->deferred, n);
+  vec_delete (rm->deferred, n, 0);
+
+  for (i = 0; i < n; i++)
+    vlib_rcu_run (&deferred[i]);
+
+  vec_free (deferred);
+}
+
+static void
+vlib_rcu_poll_all (void)
+{
+  vlib_rcu_run_until (~0ULL);
+}
+
+void
+vlib_rcu_poll (vlib_main_t * vm)
+{
+  ASSERT (vlib_get_thread_index () == 0);
+
+  if (0 == vec_len (vlib_rcu_main.deferred))
+    return;
+
+  if (vlib_rcu_no_readers ())
+    vlib_rcu_poll_all ();
+  else
+    vlib_rcu_run_until (vlib_rcu_quiescent_epoch ());
+}
+
+void
+vlib_rcu_call (vlib_rcu_callback_t * fn, void *data)
+{
+  vlib_rcu_main_t *rm = &vlib_rcu_main;
+  vlib_rcu_deferred_t *d;
+
+  ASSERT (vlib_get_thread_index () == 0);
+
+  /* No workers, or all parked at the barrier, and no other readers */
+  if (vlib_rcu_no_readers ())
+    {
+      vlib_rcu_deferred_t now = {
+	.fn = fn,
+	.data = data,
+	.heap = clib_mem_get_heap (),
+      };
+      vlib_rcu_run (&now);
+      return;
+    }
+
+  vec_add2 (rm->deferred, d, 1);
+  d->fn = fn;
+  d->data = data;
+  d->heap = clib_mem_get_heap ();
+
+  /* order the caller's unpublish before the new epoch */
+  d->epoch = clib_atomic_add_fetch (&rm->epoch, 1);
+  rm->n_deferred++;
+}
+
+static void
+vlib_rcu_free_cb (void *p)
+{
+  clib_mem_free (p);
+}
+
+void
+vlib_rcu_free (void *p)
+{
+  vlib_rcu_call (vlib_rcu_free_cb, p);
+}
+
+void
+vlib_rcu_synchronize (vlib_main_t * vm)
+{
+  vlib_rcu_main_t *rm = &vlib_rcu_main;
+  f64 deadline;
+  u64 epoch;
+
+  ASSERT (vlib_get_thread_index () == 0);
+
+  rm->n_synchronize++;
+
+  if (vlib_rcu_no_readers ())
+    {
+      vlib_rcu_poll_all ();
+      return;
+    }
+
+  epoch = clib_atomic_add_fetch (&rm->epoch, 1);
+  deadline = vlib_time_now (vm) + BARRIER_SYNC_TIMEOUT;
+
+  while (vlib_rcu_quiescent_epoch () < epoch)
+    {
+      if (vlib_time_now (vm) > deadline && !vlib_thread_is_main_w_barrier ())
+	{
+	  /* a worker that is not running its main loop, e.g. one blocked
+	   * in a node, has to be waited for at the barrier. Threads the
+	   * barrier does not stop are still waited for. */
+	  vlib_worker_thread_barrier_sync (vm);
+	  while (vlib_rcu_quiescent_epoch () < epoch)
+	    CLIB_PAUSE ();
+	  vlib_rcu_run_until (epoch);
+	  vlib_worker_thread_barrier_release (vm);
+	  return;
+	}
+    }
+
+  vlib_rcu_poll (vm);
+}
+
+void *
+vlib_rcu_pool_grow (void *p, uword elt_bytes, uword align)
+{
+  uword len = vec_len (p), n_alloc;
+  void *new;
+
+  n_alloc = len + len / 2 + 1;
+  new = _vec_resize_inline (0, n_alloc, n_alloc * elt_bytes,
+			    pool_aligned_header_bytes, align);
+  _vec_len (new) = len;
+
+  clib_memcpy_fast (new, p, len * elt_bytes);
+  clib_memcpy_fast (pool_header (new), pool_header (p),
+		    sizeof (pool_header_t));
+
+  /* the new pool is complete before the caller publishes it */
+  CLIB_MEMORY_STORE_BARRIER ();
+
+  vlib_rcu_free (vec_header (p, pool_aligned_header_bytes));
+
+  return (new);
+}
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
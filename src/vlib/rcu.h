@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2019 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ * @brief Quiescent state based reclamation.
+ *
+ * The main thread updates shared data without stopping the workers by
+ * publishing the new version and deferring the free of the old one
+ * until every worker has gone through its main loop at least once, at
+ * which point no worker can still hold a reference to it.
+ *
+ * Workers announce the global epoch they have seen at the top of each
+ * main loop iteration, between node runs. The barrier can be reached
+ * from within a node, so a parked worker is not quiescent. A writer bumps
+ * the epoch when it defers a free; the free runs once every worker has
+ * announced that epoch or a later one.
+ *
+ * Only registered threads are waited for. The workers register when they
+ * enter their main loop, so a thread that never runs it cannot hold back
+ * the frees forever. Threads outside vlib that read the same data, e.g.
+ * application threads, register a slot above the vlib threads and report
+ * quiescent states themselves; the barrier does not stop them.
+ */
+
+#ifndef included_vlib_rcu_h
+#define included_vlib_rcu_h
+
+#include <vlib/main.h>
+
+typedef void (vlib_rcu_callback_t) (void *data);
+
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+
+  /* the last epoch the thread was seen quiescent in */
+  volatile u64 epoch;
+
+  /* set while the thread may hold references to shared data */
+  volatile u8 is_registered;
+} vlib_rcu_thread_t;
+
+typedef struct
+{
+  vlib_rcu_callback_t *fn;
+  void *data;
+
+  /* heap the callback runs on */
+  void *heap;
+
+  /* epoch all workers must reach before the callback runs */
+  u64 epoch;
+} vlib_rcu_deferred_t;
+
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+
+  /* bumped by the writer for each deferred callback */
+  volatile u64 epoch;
+
+  /* callbacks waiting for their grace period, oldest first */
+  vlib_rcu_deferred_t *deferred;
+
+  u64 n_deferred;
+  u64 n_reclaimed;
+  u64 n_synchronize;
+
+  /* one past the highest thread slot ever registered */
+  volatile u32 n_threads;
+
+  /* registered threads the barrier does not stop */
+  volatile u32 n_foreign;
+
+  vlib_rcu_thread_t threads[VLIB_MAX_CPUS];
+} vlib_rcu_main_t;
+
+extern vlib_rcu_main_t vlib_rcu_main;
+
+/**
+ * @brief Start waiting for a thread before running deferred callbacks.
+ * Slots below vec_len (vlib_mains) belong to the vlib threads; other
+ * threads use the slots above them.
+ */
+void vlib_rcu_thread_register (u32 thread_index);
+
+/**
+ * @brief Stop waiting for a thread, which must hold no references to
+ * shared data any more.
+ */
+void vlib_rcu_thread_unregister (u32 thread_index);
+
+/**
+ * @brief Announce that a registered thread holds no references to shared
+ * data.
+ */
+always_inline void
+vlib_rcu_thread_quiescent (u32 thread_index)
+{
+  vlib_rcu_main_t *rm = &vlib_rcu_main;
+  u64 epoch = rm->epoch;
+
+  if (rm->threads[thread_index].epoch != epoch)
+    clib_atomic_store_rel_n (&rm->threads[thread_index].epoch, epoch);
+}
+
+/**
+ * @brief Announce that the calling worker holds no references to shared
+ * data. Called by the workers at the top of each main loop iteration,
+ * and nowhere else: any other point may be inside a node.
+ */
+always_inline void
+vlib_rcu_quiescent (vlib_main_t * vm)
+{
+  vlib_rcu_thread_quiescent (vm->thread_index);
+}
+
+/**
+ * @brief Call fn (data) on the main thread once no registered thread can
+ * be using data the caller has unpublished. Main thread only.
+ */
+void vlib_rcu_call (vlib_rcu_callback_t * fn, void *data);
+
+/**
+ * @brief Free memory, from the current heap, once no worker can be
+ * using it. Main thread only.
+ */
+void vlib_rcu_free (void *p);
+
+/**
+ * @brief Wait for all the workers to pass a quiescent state and run the
+ * deferred callbacks. The workers are not stopped. Main thread only.
+ */
+void vlib_rcu_synchronize (vlib_main_t * vm);
+
+/**
+ * @brief Run the deferred callbacks whose grace period has elapsed.
+ * Called from the main thread's main loop.
+ */
+void vlib_rcu_poll (vlib_main_t * vm);
+
+/**
+ * @brief Grow a pool by at least one element. The old pool is freed
+ * once no worker can be using it.
+ */
+void *vlib_rcu_pool_grow (void *p, uword elt_bytes, uword align);
+
+/**
+ * @brief Get an element from a pool the workers read without holding the
+ * barrier. If the pool has to grow, the old memory is freed once no
+ * worker can still be reading it.
+ */
+#define vlib_rcu_pool_get_aligned(P,E,A)                                \
+do {                                                                    \
+  uword _rcu_will_expand;                                               \
+                                                                        \
+  pool_get_aligned_will_expand (P, _rcu_will_expand, A);                \
+  if (_rcu_will_expand && (P))                                          \
+    P = vlib_rcu_pool_grow (P, sizeof ((P)[0]), A);                     \
+  pool_get_aligned (P, E, A);                                           \
+} while (0)
+
+#define vlib_rcu_pool_get(P,E) vlib_rcu_pool_get_aligned(P,E,0)
+
+#endif /* included_vlib_rcu_h */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
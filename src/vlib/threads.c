@@ -1291,6 +1291,14 @@ cpu_config (vlib_main_t * vm, unformat_input_t * input)
 	;
       else if (unformat (input, "scheduler-priority %u", &tm->sched_priority))
 	;
+      else if (unformat (input, "handoff-ring-size %u",
+			 &tm->handoff_ring_size))
+	{
+	  if (!is_pow2 (tm->handoff_ring_size) ||
+	      tm->handoff_ring_size < VLIB_FRAME_SIZE)
+	    return clib_error_return (0, "handoff-ring-size must be a power "
+				      "of 2, at least %d", VLIB_FRAME_SIZE);
+	}
       else if (unformat (input, "%s %u", &name, &count))
 	{
 	  p = hash_get_mem (tm->thread_registrations_by_name, name);
@@ -1503,6 +1511,31 @@ vlib_worker_thread_barrier_sync_int (vlib_main_t * vm, const char *func_name)
 
 }
 
+static void
+vlib_barrier_stats_update (const char *caller, f64 hold_time)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_barrier_stats_t *bs;
+  uword *p;
+
+  /* callers are named by __FUNCTION__, so the name's address is its key */
+  p = hash_get (tm->barrier_stats_by_caller, caller);
+
+  if (p)
+    bs = vec_elt_at_index (tm->barrier_stats, p[0]);
+  else
+    {
+      vec_add2 (tm->barrier_stats, bs, 1);
+      bs->caller = caller;
+      hash_set (tm->barrier_stats_by_caller, caller,
+		bs - tm->barrier_stats);
+    }
+
+  bs->n_holds++;
+  bs->total_hold_time += hold_time;
+  bs->max_hold_time = clib_max (bs->max_hold_time, hold_time);
+}
+
 void
 vlib_worker_thread_barrier_release (vlib_main_t * vm)
 {
@@ -1593,6 +1626,9 @@ vlib_worker_thread_barrier_release (vlib_main_t * vm)
 
   t_closed_total = now - vm->barrier_epoch;
 
+  vlib_barrier_stats_update (vlib_worker_threads[0].barrier_caller,
+			     t_closed_total);
+
   minimum_open = t_closed_total * BARRIER_MINIMUM_OPEN_FACTOR;
 
   if (minimum_open > BARRIER_MINIMUM_OPEN_LIMIT)
@@ -1609,6 +1645,135 @@ vlib_worker_thread_barrier_release (vlib_main_t * vm)
 
 }
 
+/*
+ * Pull the packets off the rings of all the senders to this thread
+ * and put them to the handoff node. Packets from several senders share
+ * a frame, so partial batches are not shipped as partial frames.
+ */
+static int
+vlib_handoff_ring_dequeue (vlib_main_t * vm, vlib_frame_queue_main_t * fqm)
+{
+  u32 thread_index = vm->thread_index;
+  vlib_frame_queue_per_thread_data_t *ptd;
+  u32 i, n_threads, sender, head, tail, n, n_left_to_node, slot, n_wrap;
+  vlib_handoff_ring_t *r;
+  vlib_frame_t *f = 0;
+  vlib_buffer_t *b;
+  int processed = 0;
+  u32 *to = 0;
+
+  ptd = vec_elt_at_index (fqm->per_thread_data, thread_index);
+  n_threads = vec_len (fqm->per_thread_data);
+  n_left_to_node = VLIB_FRAME_SIZE;
+
+  for (i = 0; i < n_threads && n_left_to_node; i++)
+    {
+      sender = (ptd->ring_next_sender + i) % n_threads;
+      r = vlib_get_handoff_ring (fqm, thread_index, sender);
+
+      head = clib_atomic_load_acq_n (&r->head);
+      tail = r->tail;
+      n = head - tail;
+
+      if (0 == n)
+	continue;
+
+      vlib_increment_simple_counter
+	(&fqm->ring_occupancy, thread_index,
+	 sender * VLIB_HANDOFF_RING_N_HIST +
+	 clib_min (n * VLIB_HANDOFF_RING_N_HIST / r->size,
+		   VLIB_HANDOFF_RING_N_HIST - 1), 1);
+
+      if (0 == f)
+	{
+	  f = vlib_get_frame_to_node (vm, fqm->node_index);
+	  to = vlib_frame_vector_args (f);
+	}
+
+      n = clib_min (n, n_left_to_node);
+      slot = tail & (r->size - 1);
+      n_wrap = clib_min (n, r->size - slot);
+
+      /* If the first vector is traced, set the frame trace flag */
+      b = vlib_get_buffer (vm, r->buffer_indices[slot]);
+      if (b->flags & VLIB_BUFFER_IS_TRACED)
+	f->frame_flags |= VLIB_NODE_FLAG_TRACE;
+
+      clib_memcpy_fast (to, r->buffer_indices + slot,
+			n_wrap * sizeof (to[0]));
+      clib_memcpy_fast (to + n_wrap, r->buffer_indices,
+			(n - n_wrap) * sizeof (to[0]));
+
+      clib_atomic_store_rel_n (&r->tail, tail + n);
+
+      to += n;
+      n_left_to_node -= n;
+      processed++;
+    }
+
+  if (f)
+    {
+      f->n_vectors = VLIB_FRAME_SIZE - n_left_to_node;
+      vlib_put_frame_to_node (vm, fqm->node_index, f);
+      ptd->ring_next_sender = (ptd->ring_next_sender + 1) % n_threads;
+    }
+
+  return processed;
+}
+
+/*
+ * The receiver's ring is full: publish what was enqueued so far and wait
+ * for space. While waiting, drain the rings to this thread, so a receiver
+ * that is itself waiting on this thread can make progress.
+ * Callers that drop on congestion wait at most VLIB_HANDOFF_RING_MAX_WAIT
+ * and give up as soon as the main thread wants the barrier. Others wait
+ * for as long as it takes, parking at the barrier meanwhile, as senders
+ * on a full frame queue do.
+ * Returns the space available, 0 if the wait timed out.
+ */
+u32
+vlib_handoff_ring_wait (vlib_main_t * vm, vlib_frame_queue_main_t * fqm,
+			u32 receiver, int drop_on_congestion)
+{
+  vlib_frame_queue_per_thread_data_t *ptd;
+  vlib_handoff_ring_t *r;
+  u64 deadline;
+  u32 head;
+
+  ptd = vec_elt_at_index (fqm->per_thread_data, vm->thread_index);
+  r = vlib_get_handoff_ring (fqm, receiver, vm->thread_index);
+  head = ptd->ring_head_by_thread_index[receiver];
+
+  clib_atomic_store_rel_n (&r->head, head);
+  vlib_mains[receiver]->check_frame_queues = 1;
+
+  vlib_increment_simple_counter (&fqm->ring_backpressure, vm->thread_index,
+				 receiver, 1);
+
+  deadline = clib_cpu_time_now () +
+    VLIB_HANDOFF_RING_MAX_WAIT * vm->clib_time.clocks_per_second;
+
+  while (1)
+    {
+      r->tail_cache = clib_atomic_load_acq_n (&r->tail);
+      if (head - r->tail_cache < r->size)
+	return (r->size - (head - r->tail_cache));
+
+      vlib_handoff_ring_dequeue (vm, fqm);
+
+      if (drop_on_congestion)
+	{
+	  if (clib_cpu_time_now () > deadline
+	      || *vlib_worker_threads->wait_at_barrier)
+	    return 0;
+	}
+      else if (vm->thread_index)
+	vlib_worker_thread_barrier_check ();
+
+      CLIB_PAUSE ();
+    }
+}
+
 /*
  * Check the frame queue to see if any frames are available.
  * If so, pull the packets off the frames and put them to
@@ -1632,6 +1797,9 @@ vlib_frame_queue_dequeue (vlib_main_t * vm, vlib_frame_queue_main_t * fqm)
 
   if (PREDICT_FALSE (fqm->node_index == ~0))
     return 0;
+
+  if (vec_len (fqm->rings))
+    return (vlib_handoff_ring_dequeue (vm, fqm));
   /*
    * Gather trace data for frame queues
    */
@@ -1782,6 +1950,48 @@ VLIB_REGISTER_THREAD (worker_thread_reg, static) = {
 };
 /* *INDENT-ON* */
 
+static void
+vlib_handoff_rings_init (vlib_frame_queue_main_t * fqm, u32 ring_size)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_main_t *vm = vlib_get_main ();
+  vlib_frame_queue_per_thread_data_t *ptd;
+  vlib_handoff_ring_t *r;
+  u8 *name;
+
+  vec_validate_aligned (fqm->rings, tm->n_vlib_mains * tm->n_vlib_mains - 1,
+			CLIB_CACHE_LINE_BYTES);
+  vec_foreach (r, fqm->rings)
+  {
+    vec_validate_aligned (r->buffer_indices, ring_size - 1,
+			  CLIB_CACHE_LINE_BYTES);
+    r->size = ring_size;
+  }
+  vec_foreach (ptd, fqm->per_thread_data)
+    vec_validate (ptd->ring_head_by_thread_index, tm->n_vlib_mains - 1);
+
+  name = vlib_get_node (vm, fqm->node_index)->name;
+
+  /* counter names are static in the stats segment directory */
+  fqm->ring_occupancy.name = (char *) format (0, "/vlib/handoff/%v/occupancy%c",
+					      name, 0);
+  fqm->ring_occupancy.stat_segment_name = fqm->ring_occupancy.name;
+  vlib_validate_simple_counter (&fqm->ring_occupancy,
+				tm->n_vlib_mains * VLIB_HANDOFF_RING_N_HIST -
+				1);
+
+  fqm->ring_backpressure.name =
+    (char *) format (0, "/vlib/handoff/%v/backpressure%c", name, 0);
+  fqm->ring_backpressure.stat_segment_name = fqm->ring_backpressure.name;
+  vlib_validate_simple_counter (&fqm->ring_backpressure,
+				tm->n_vlib_mains - 1);
+
+  fqm->ring_drops.name = (char *) format (0, "/vlib/handoff/%v/drops%c",
+					  name, 0);
+  fqm->ring_drops.stat_segment_name = fqm->ring_drops.name;
+  vlib_validate_simple_counter (&fqm->ring_drops, tm->n_vlib_mains - 1);
+}
+
 u32
 vlib_frame_queue_main_init (u32 node_index, u32 frame_queue_nelts)
 {
@@ -1818,6 +2028,9 @@ vlib_frame_queue_main_init (u32 node_index, u32 frame_queue_nelts)
 			       (vlib_frame_queue_t *) (~0));
     }
 
+  if (tm->handoff_ring_size)
+    vlib_handoff_rings_init (fqm, tm->handoff_ring_size);
+
   return (fqm - tm->frame_queue_mains);
 }
 
@@ -62,6 +62,8 @@ typedef struct vlib_thread_registration_
 #define VLIB_CPU_MASK (VLIB_MAX_CPUS - 1)	/* 0x3f, max */
 #define VLIB_OFFSET_MASK (~VLIB_CPU_MASK)
 
+#include <vlib/rcu.h>
+
 #define VLIB_LOG2_THREAD_STACK_SIZE (21)
 #define VLIB_THREAD_STACK_SIZE (1<<VLIB_LOG2_THREAD_STACK_SIZE)
 
@@ -146,10 +148,47 @@ typedef struct
 }
 vlib_frame_queue_t;
 
+/*
+ * Single producer, single consumer ring of buffer indices, one for each
+ * (sender, receiver) pair of threads. Used instead of the frame queues
+ * when 'cpu { handoff-ring-size <n> }' is configured.
+ */
+typedef struct
+{
+  /* enqueue side */
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  volatile u32 head;
+  /* the dequeue side's tail, as last seen by the enqueue side */
+  u32 tail_cache;
+
+  /* dequeue side */
+    CLIB_CACHE_LINE_ALIGN_MARK (cacheline1);
+  volatile u32 tail;
+
+  /* read-only, constant, shared */
+    CLIB_CACHE_LINE_ALIGN_MARK (cacheline2);
+  u32 *buffer_indices;
+  u32 size;
+}
+vlib_handoff_ring_t;
+
+/* Occupancy histogram buckets, each an eighth of the ring */
+#define VLIB_HANDOFF_RING_N_HIST 8
+
+/* Longest wait for ring space before packets are dropped, for callers
+   that drop on congestion */
+#define VLIB_HANDOFF_RING_MAX_WAIT (10e-6)
+
 typedef struct
 {
   vlib_frame_queue_elt_t **handoff_queue_elt_by_thread_index;
   vlib_frame_queue_t **congested_handoff_queue_by_thread_index;
+
+  /* enqueued but not yet published ring heads, by receiver */
+  u32 *ring_head_by_thread_index;
+
+  /* sender whose ring is dequeued first, for fairness */
+  u32 ring_next_sender;
 } vlib_frame_queue_per_thread_data_t;
 
 typedef struct
@@ -164,6 +203,16 @@ typedef struct
   /* for frame queue tracing */
   frame_queue_trace_t *frame_queue_traces;
   frame_queue_nelt_counter_t *frame_queue_histogram;
+
+  /* SPSC rings, by receiver then sender. Empty if frame queues are used */
+  vlib_handoff_ring_t *rings;
+
+  /* ring occupancy seen at dequeue, by receiver, sender and bucket */
+  vlib_simple_counter_main_t ring_occupancy;
+
+  /* waits for ring space, and packets dropped, by sender and receiver */
+  vlib_simple_counter_main_t ring_backpressure;
+  vlib_simple_counter_main_t ring_drops;
 } vlib_frame_queue_main_t;
 
 typedef struct
@@ -173,6 +222,17 @@ typedef struct
   uword data;
 } vlib_process_signal_event_mt_args_t;
 
+/*
+ * Barrier holds, by the function that took the barrier
+ */
+typedef struct
+{
+  const char *caller;
+  u64 n_holds;
+  f64 total_hold_time;
+  f64 max_hold_time;
+} vlib_barrier_stats_t;
+
 /* Called early, in thread 0's context */
 clib_error_t *vlib_thread_init (vlib_main_t * vm);
 
@@ -191,6 +251,9 @@ void vlib_create_worker_threads (vlib_main_t * vm, int n,
 void vlib_worker_thread_init (vlib_worker_thread_t * w);
 u32 vlib_frame_queue_main_init (u32 node_index, u32 frame_queue_nelts);
 
+u32 vlib_handoff_ring_wait (vlib_main_t * vm, vlib_frame_queue_main_t * fqm,
+			    u32 receiver, int drop_on_congestion);
+
 /* Check for a barrier sync request every 30ms */
 #define BARRIER_SYNC_DELAY (0.030000)
 
@@ -326,6 +389,13 @@ typedef struct
   /* Worker handoff queues */
   vlib_frame_queue_main_t *frame_queue_mains;
 
+  /* Size of the worker handoff rings, 0 to use frame queues */
+  u32 handoff_ring_size;
+
+  /* Barrier holds, and index by caller name */
+  vlib_barrier_stats_t *barrier_stats;
+  uword *barrier_stats_by_caller;
+
   /* worker thread initialization barrier */
   volatile u32 worker_thread_release;
 
@@ -586,6 +656,13 @@ is_vlib_frame_queue_congested (u32 frame_queue_index,
   return NULL;
 }
 
+always_inline vlib_handoff_ring_t *
+vlib_get_handoff_ring (vlib_frame_queue_main_t * fqm, u32 receiver,
+		       u32 sender)
+{
+  return (fqm->rings + receiver * vec_len (fqm->per_thread_data) + sender);
+}
+
 static inline vlib_frame_queue_elt_t *
 vlib_get_worker_handoff_queue_elt (u32 frame_queue_index,
 				   u32 vlib_worker_index,
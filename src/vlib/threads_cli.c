@@ -92,6 +92,72 @@ VLIB_CLI_COMMAND (show_threads_command, static) = {
 };
 /* *INDENT-ON* */
 
+static clib_error_t *
+show_barrier_fn (vlib_main_t * vm,
+		 unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_rcu_main_t *rm = &vlib_rcu_main;
+  vlib_barrier_stats_t *bs;
+  u32 i;
+
+  vlib_cli_output (vm, "%-40s%12s%14s%14s%14s", "Caller", "Holds",
+		   "Total (ms)", "Average (us)", "Max (us)");
+
+  vec_foreach (bs, tm->barrier_stats)
+  {
+    vlib_cli_output (vm, "%-40s%12lu%14.3f%14.3f%14.3f",
+		     bs->caller, bs->n_holds, bs->total_hold_time * 1e3,
+		     bs->total_hold_time * 1e6 / bs->n_holds,
+		     bs->max_hold_time * 1e6);
+  }
+
+  vlib_cli_output (vm, "\nDeferred frees: epoch %lu, %lu deferred, "
+		   "%lu reclaimed, %d pending, %lu synchronize",
+		   rm->epoch, rm->n_deferred, rm->n_reclaimed,
+		   vec_len (rm->deferred), rm->n_synchronize);
+
+  for (i = 1; i < rm->n_threads; i++)
+    if (rm->threads[i].is_registered)
+      vlib_cli_output (vm, "  thread %u%s: quiescent in epoch %lu", i,
+		       i < vec_len (vlib_mains) ? "" : " (foreign)",
+		       rm->threads[i].epoch);
+
+  return 0;
+}
+
+/*?
+ * Show how often, and for how long, each caller has held the worker
+ * barrier, and the state of the deferred frees that avoid it.
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_barrier_command, static) = {
+  .path = "show barrier",
+  .short_help = "show barrier",
+  .function = show_barrier_fn,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+clear_barrier_fn (vlib_main_t * vm,
+		  unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+
+  vec_reset_length (tm->barrier_stats);
+  hash_free (tm->barrier_stats_by_caller);
+
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (clear_barrier_command, static) = {
+  .path = "clear barrier",
+  .short_help = "clear barrier",
+  .function = clear_barrier_fn,
+};
+/* *INDENT-ON* */
+
 /*
  * Trigger threads to grab frame queue trace data
  */
@@ -378,6 +444,58 @@ VLIB_CLI_COMMAND (cmd_show_frame_queue_histogram,static) = {
 };
 /* *INDENT-ON* */
 
+static clib_error_t *
+show_frame_queue_rings (vlib_main_t * vm, unformat_input_t * input,
+			vlib_cli_command_t * cmd)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_frame_queue_main_t *fqm;
+  vlib_handoff_ring_t *r;
+  u32 sender, receiver, bucket;
+  u8 *s = 0;
+
+  vec_foreach (fqm, tm->frame_queue_mains)
+  {
+    if (0 == vec_len (fqm->rings))
+      continue;
+
+    vlib_cli_output (vm, "Worker handoff queue index %u (next node '%U'):",
+		     fqm - tm->frame_queue_mains,
+		     format_vlib_node_name, vm, fqm->node_index);
+    vlib_cli_output (vm, "  %=8s%=8s%=10s%=14s%=10s  %s", "sender",
+		     "receiver", "in-use", "backpressure", "drops",
+		     "occupancy histogram (eighths of the ring)");
+
+    for (receiver = 0; receiver < tm->n_vlib_mains; receiver++)
+      for (sender = 0; sender < tm->n_vlib_mains; sender++)
+	{
+	  r = vlib_get_handoff_ring (fqm, receiver, sender);
+
+	  vec_reset_length (s);
+	  for (bucket = 0; bucket < VLIB_HANDOFF_RING_N_HIST; bucket++)
+	    s = format (s, "%lu ", fqm->ring_occupancy.counters[receiver]
+			[sender * VLIB_HANDOFF_RING_N_HIST + bucket]);
+
+	  /* counted by the sender, per receiver */
+	  vlib_cli_output (vm, "  %=8u%=8u%=10u%=14lu%=10lu  %v",
+			   sender, receiver, r->head - r->tail,
+			   fqm->ring_backpressure.counters[sender][receiver],
+			   fqm->ring_drops.counters[sender][receiver], s);
+	}
+  }
+
+  vec_free (s);
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (cmd_show_frame_queue_rings,static) = {
+    .path = "show frame-queue rings",
+    .short_help = "show frame-queue rings",
+    .function = show_frame_queue_rings,
+};
+/* *INDENT-ON* */
+
 
 /*
  * Modify the number of elements on the frame_queues
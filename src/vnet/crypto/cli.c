@@ -35,11 +35,13 @@ show_crypto_engines_command_fn (vlib_main_t * vm,
       return 0;
     }
 
-  vlib_cli_output (vm, "%-20s%-8s%s", "Name", "Prio", "Description");
+  vlib_cli_output (vm, "%-20s%-8s%-8s%s", "Name", "Prio", "Async",
+		   "Description");
   /* *INDENT-OFF* */
   vec_foreach (p, cm->engines)
     {
-      vlib_cli_output (vm, "%-20s%-8u%s", p->name, p->priority, p->desc);
+      vlib_cli_output (vm, "%-20s%-8u%-8s%s", p->name, p->priority,
+		       p->enqueue_handler ? "yes" : "no", p->desc);
     }
   /* *INDENT-ON* */
   return 0;
@@ -74,13 +76,15 @@ format_vnet_crypto_handlers (u8 * s, va_list * args)
       od = vec_elt_at_index (cm->opt_data, id);
       if (first == 0)
         s = format (s, "\n%U", format_white_space, indent);
-      s = format (s, "%-20U%-20U", format_vnet_crypto_op_type, od->type,
-		  format_vnet_crypto_engine, od->active_engine_index,s);
+      s = format (s, "%-20U%-20U%-20U", format_vnet_crypto_op_type, od->type,
+		  format_vnet_crypto_engine, od->active_engine_index,
+		  format_vnet_crypto_engine, od->active_engine_index_chained);
 
       vec_foreach (e, cm->engines)
 	{
 	  if (e->ops_handlers[id] != 0)
-	    s = format (s, "%U ", format_vnet_crypto_engine, e - cm->engines);
+	    s = format (s, "%U%s ", format_vnet_crypto_engine, e - cm->engines,
+			e->chained_ops_handlers[id] ? "*" : "");
 	}
       first = 0;
     }
@@ -98,8 +102,8 @@ show_crypto_handlers_command_fn (vlib_main_t * vm,
   if (unformat_user (input, unformat_line_input, line_input))
     unformat_free (line_input);
 
-  vlib_cli_output (vm, "%-20s%-20s%-20s%s", "Algo", "Type", "Active",
-		   "Candidates");
+  vlib_cli_output (vm, "%-20s%-20s%-20s%-20s%s", "Algo", "Type", "Active",
+		   "Active (chained)", "Candidates (*: chained)");
 
   for (i = 0; i < VNET_CRYPTO_N_ALGS; i++)
     vlib_cli_output (vm, "%-20U%U", format_vnet_crypto_alg, i,
@@ -200,6 +204,83 @@ VLIB_CLI_COMMAND (set_crypto_handler_command, static) =
 };
 /* *INDENT-ON* */
 
+static clib_error_t *
+show_crypto_async_status_command_fn (vlib_main_t * vm,
+				     unformat_input_t * input,
+				     vlib_cli_command_t * cmd)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  vnet_crypto_thread_t *ct;
+
+  if (cm->async_engine_index == ~0)
+    {
+      vlib_cli_output (vm, "No async crypto engine registered");
+      return 0;
+    }
+
+  vlib_cli_output (vm, "Active engine: %U, mode %s, users %u",
+		   format_vnet_crypto_engine, cm->async_engine_index,
+		   cm->async_refcnt ? "enabled" : "disabled",
+		   cm->async_refcnt);
+  vlib_cli_output (vm, "%-10s%-12s%s", "Thread", "In-flight", "Frames");
+
+  vec_foreach (ct, cm->threads)
+  {
+    if (ct - cm->threads >= vec_len (vlib_mains))
+      break;
+    vlib_cli_output (vm, "%-10u%-12u%u", ct - cm->threads, ct->n_inflight,
+		     pool_elts (ct->frame_pool));
+  }
+
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_crypto_async_status_command, static) =
+{
+  .path = "show crypto async status",
+  .short_help = "show crypto async status",
+  .function = show_crypto_async_status_command_fn,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+set_crypto_async_handler_command_fn (vlib_main_t * vm,
+				     unformat_input_t * input,
+				     vlib_cli_command_t * cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  clib_error_t *error = 0;
+  char *engine = 0;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return 0;
+
+  if (!unformat (line_input, "%s", &engine))
+    {
+      error = clib_error_return (0, "missing engine!");
+      goto done;
+    }
+  vec_add1 (engine, 0);
+
+  if (vnet_crypto_set_async_handler (engine))
+    error = clib_error_return (0, "failed to set async engine %s!", engine);
+
+done:
+  vec_free (engine);
+  unformat_free (line_input);
+  return error;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (set_crypto_async_handler_command, static) =
+{
+  .path = "set crypto async handler",
+  .short_help = "set crypto async handler engine",
+  .function = set_crypto_async_handler_command_fn,
+};
+/* *INDENT-ON* */
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
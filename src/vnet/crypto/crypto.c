@@ -23,27 +23,41 @@ static_always_inline u32
 vnet_crypto_process_ops_call_handler (vlib_main_t * vm,
 				      vnet_crypto_main_t * cm,
 				      vnet_crypto_op_id_t opt,
-				      vnet_crypto_op_t * ops[], u32 n_ops)
+				      vnet_crypto_op_t * ops[],
+				      vnet_crypto_op_chunk_t * chunks,
+				      u32 n_ops)
 {
+  u32 rv = 0;
+
   if (n_ops == 0)
     return 0;
 
-  if (cm->ops_handlers[opt] == 0)
+  if (chunks)
     {
-      while (n_ops--)
-	{
-	  ops[0]->status = VNET_CRYPTO_OP_STATUS_FAIL_NO_HANDLER;
-	  ops++;
-	}
-      return 0;
+      if (cm->chained_ops_handlers[opt] == 0)
+	goto no_handler;
+      rv = (cm->chained_ops_handlers[opt]) (vm, ops, chunks, n_ops);
     }
+  else
+    {
+      if (cm->ops_handlers[opt] == 0)
+	goto no_handler;
+      rv = (cm->ops_handlers[opt]) (vm, ops, n_ops);
+    }
+  return rv;
 
-  return (cm->ops_handlers[opt]) (vm, ops, n_ops);
+no_handler:
+  while (n_ops--)
+    {
+      ops[0]->status = VNET_CRYPTO_OP_STATUS_FAIL_NO_HANDLER;
+      ops++;
+    }
+  return 0;
 }
 
-
-u32
-vnet_crypto_process_ops (vlib_main_t * vm, vnet_crypto_op_t ops[], u32 n_ops)
+static_always_inline u32
+vnet_crypto_process_ops_inline (vlib_main_t * vm, vnet_crypto_op_t ops[],
+				vnet_crypto_op_chunk_t * chunks, u32 n_ops)
 {
   vnet_crypto_main_t *cm = &crypto_main;
   const int op_q_size = VLIB_FRAME_SIZE;
@@ -61,7 +75,8 @@ vnet_crypto_process_ops (vlib_main_t * vm, vnet_crypto_op_t ops[], u32 n_ops)
       if (current_op_type != opt || n_op_queue >= op_q_size)
 	{
 	  rv += vnet_crypto_process_ops_call_handler (vm, cm, current_op_type,
-						      op_queue, n_op_queue);
+						      op_queue, chunks,
+						      n_op_queue);
 	  n_op_queue = 0;
 	  current_op_type = opt;
 	}
@@ -70,10 +85,27 @@ vnet_crypto_process_ops (vlib_main_t * vm, vnet_crypto_op_t ops[], u32 n_ops)
     }
 
   rv += vnet_crypto_process_ops_call_handler (vm, cm, current_op_type,
-					      op_queue, n_op_queue);
+					      op_queue, chunks, n_op_queue);
   return rv;
 }
 
+u32
+vnet_crypto_process_ops (vlib_main_t * vm, vnet_crypto_op_t ops[], u32 n_ops)
+{
+  return vnet_crypto_process_ops_inline (vm, ops, 0, n_ops);
+}
+
+/*
+ * Process ops carrying VNET_CRYPTO_OP_FLAG_CHAINED_BUFFERS, their data is
+ * described by the chunks array instead of the src/dst/len fields.
+ */
+u32
+vnet_crypto_process_chained_ops (vlib_main_t * vm, vnet_crypto_op_t ops[],
+				 vnet_crypto_op_chunk_t * chunks, u32 n_ops)
+{
+  return vnet_crypto_process_ops_inline (vm, ops, chunks, n_ops);
+}
+
 u32
 vnet_crypto_register_engine (vlib_main_t * vm, char *name, int prio,
 			     char *desc)
@@ -124,6 +156,11 @@ vnet_crypto_set_handler (char *alg_name, char *engine)
 	  od->active_engine_index = p[0];
 	  cm->ops_handlers[id] = ce->ops_handlers[id];
 	}
+      if (ce->chained_ops_handlers[id])
+	{
+	  od->active_engine_index_chained = p[0];
+	  cm->chained_ops_handlers[id] = ce->chained_ops_handlers[id];
+	}
     }
 
   return 0;
@@ -165,6 +202,33 @@ vnet_crypto_register_ops_handler (vlib_main_t * vm, u32 engine_index,
   return;
 }
 
+void
+vnet_crypto_register_chained_ops_handler (vlib_main_t * vm, u32 engine_index,
+					  vnet_crypto_op_id_t opt,
+					  vnet_crypto_chained_ops_handler_t *
+					  fn)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  vnet_crypto_engine_t *ae, *e = vec_elt_at_index (cm->engines, engine_index);
+  vnet_crypto_op_data_t *otd = cm->opt_data + opt;
+  vec_validate_aligned (cm->chained_ops_handlers, VNET_CRYPTO_N_OP_IDS - 1,
+			CLIB_CACHE_LINE_BYTES);
+  e->chained_ops_handlers[opt] = fn;
+
+  if (otd->active_engine_index_chained == ~0)
+    {
+      otd->active_engine_index_chained = engine_index;
+      cm->chained_ops_handlers[opt] = fn;
+      return;
+    }
+  ae = vec_elt_at_index (cm->engines, otd->active_engine_index_chained);
+  if (ae->priority < e->priority)
+    {
+      otd->active_engine_index_chained = engine_index;
+      cm->chained_ops_handlers[opt] = fn;
+    }
+}
+
 void
 vnet_crypto_register_key_handler (vlib_main_t * vm, u32 engine_index,
 				  vnet_crypto_key_handler_t * key_handler)
@@ -175,6 +239,163 @@ vnet_crypto_register_key_handler (vlib_main_t * vm, u32 engine_index,
   return;
 }
 
+void
+vnet_crypto_register_async_handler (vlib_main_t * vm, u32 engine_index,
+				    vnet_crypto_frame_enqueue_t * enqh,
+				    vnet_crypto_frame_dequeue_t * deqh)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  vnet_crypto_engine_t *ae, *e = vec_elt_at_index (cm->engines, engine_index);
+
+  e->enqueue_handler = enqh;
+  e->dequeue_handler = deqh;
+
+  if (cm->async_engine_index != ~0)
+    {
+      ae = vec_elt_at_index (cm->engines, cm->async_engine_index);
+      if (ae->priority >= e->priority)
+	return;
+    }
+
+  cm->async_engine_index = engine_index;
+  cm->enqueue_handler = enqh;
+  cm->dequeue_handler = deqh;
+}
+
+int
+vnet_crypto_set_async_handler (char *engine)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  vnet_crypto_engine_t *e;
+  uword *p;
+
+  p = hash_get_mem (cm->engine_index_by_name, engine);
+  if (!p)
+    return -1;
+
+  e = vec_elt_at_index (cm->engines, p[0]);
+  if (e->enqueue_handler == 0 || e->dequeue_handler == 0)
+    return -1;
+
+  /* frames in flight must complete on the engine that accepted them */
+  if (cm->async_refcnt)
+    return -1;
+
+  cm->async_engine_index = p[0];
+  cm->enqueue_handler = e->enqueue_handler;
+  cm->dequeue_handler = e->dequeue_handler;
+  return 0;
+}
+
+static void
+vnet_crypto_set_dispatch_state (vlib_node_state_t state)
+{
+  /* *INDENT-OFF* */
+  foreach_vlib_main (({
+    vlib_node_set_state (this_vlib_main, crypto_dispatch_node.index, state);
+  }));
+  /* *INDENT-ON* */
+}
+
+int
+vnet_crypto_request_async_mode (int is_enable)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  vlib_main_t *vm = vlib_get_main ();
+
+  if (is_enable)
+    {
+      if (cm->enqueue_handler == 0)
+	return -1;
+
+      if (cm->async_refcnt++ == 0)
+	{
+	  vlib_worker_thread_barrier_sync (vm);
+	  vnet_crypto_set_dispatch_state (VLIB_NODE_STATE_POLLING);
+	  vlib_worker_thread_barrier_release (vm);
+	}
+    }
+  else
+    {
+      if (cm->async_refcnt == 0)
+	return -1;
+
+      /* the dispatch nodes keep polling until their in-flight frames have
+	 drained, see crypto_dispatch_node */
+      cm->async_refcnt--;
+    }
+
+  return 0;
+}
+
+u32
+vnet_crypto_register_post_node (vlib_main_t * vm, char *post_node_name)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  vlib_node_t *pn = vlib_get_node_by_name (vm, (u8 *) post_node_name);
+  u32 next;
+
+  if (!pn)
+    return ~0;
+
+  next = vlib_node_add_next (vm, crypto_dispatch_node.index, pn->index);
+  vec_add1 (cm->next_nodes, pn->index);
+  return next;
+}
+
+static_always_inline void
+vnet_crypto_async_process_ops (vlib_main_t * vm,
+			       vnet_crypto_async_frame_t * f,
+			       vnet_crypto_op_t * ops, u32 n_ops)
+{
+  u32 n_fail;
+
+  if (n_ops == 0)
+    return;
+
+  n_fail = n_ops - vnet_crypto_process_ops (vm, ops, n_ops);
+
+  while (n_fail)
+    {
+      if (ops->status != VNET_CRYPTO_OP_STATUS_COMPLETED)
+	{
+	  f->elt_status[ops->user_data] = ops->status;
+	  n_fail--;
+	}
+      ops++;
+    }
+}
+
+/*
+ * Run all ops of a frame through the currently active synchronous handlers.
+ * Software async engines call this from whichever thread picked the frame
+ * up; the final frame state is published with release semantics.
+ */
+void
+vnet_crypto_async_process_frame (vlib_main_t * vm,
+				 vnet_crypto_async_frame_t * f)
+{
+  u32 i, n_fail = 0;
+
+  if (f->flags & VNET_CRYPTO_FRAME_F_INTEG_FIRST)
+    {
+      vnet_crypto_async_process_ops (vm, f, f->integ_ops, f->n_integ_ops);
+      vnet_crypto_async_process_ops (vm, f, f->crypto_ops, f->n_crypto_ops);
+    }
+  else
+    {
+      vnet_crypto_async_process_ops (vm, f, f->crypto_ops, f->n_crypto_ops);
+      vnet_crypto_async_process_ops (vm, f, f->integ_ops, f->n_integ_ops);
+    }
+
+  for (i = 0; i < f->n_elts; i++)
+    n_fail += f->elt_status[i] != VNET_CRYPTO_OP_STATUS_COMPLETED;
+
+  clib_atomic_store_rel_n (&f->state, n_fail ?
+			   VNET_CRYPTO_FRAME_STATE_ELT_ERROR :
+			   VNET_CRYPTO_FRAME_STATE_SUCCESS);
+}
+
 static int
 vnet_crypto_key_len_check (vnet_crypto_alg_t alg, u16 length)
 {
@@ -257,6 +478,8 @@ vnet_crypto_init_cipher_data (vnet_crypto_alg_t alg, vnet_crypto_op_id_t eid,
   cm->opt_data[eid].alg = cm->opt_data[did].alg = alg;
   cm->opt_data[eid].active_engine_index = ~0;
   cm->opt_data[did].active_engine_index = ~0;
+  cm->opt_data[eid].active_engine_index_chained = ~0;
+  cm->opt_data[did].active_engine_index_chained = ~0;
   if (is_aead)
     {
       eopt = VNET_CRYPTO_OP_TYPE_AEAD_ENCRYPT;
@@ -283,6 +506,7 @@ vnet_crypto_init_hmac_data (vnet_crypto_alg_t alg,
   cm->algs[alg].op_by_type[VNET_CRYPTO_OP_TYPE_HMAC] = id;
   cm->opt_data[id].alg = alg;
   cm->opt_data[id].active_engine_index = ~0;
+  cm->opt_data[id].active_engine_index_chained = ~0;
   cm->opt_data[id].type = VNET_CRYPTO_OP_TYPE_HMAC;
   hash_set_mem (cm->alg_index_by_name, name, alg);
 }
@@ -292,10 +516,20 @@ vnet_crypto_init (vlib_main_t * vm)
 {
   vnet_crypto_main_t *cm = &crypto_main;
   vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vnet_crypto_thread_t *ct;
+
   cm->engine_index_by_name = hash_create_string ( /* size */ 0,
 						 sizeof (uword));
   cm->alg_index_by_name = hash_create_string (0, sizeof (uword));
+  cm->async_engine_index = ~0;
+  vec_validate_aligned (cm->ops_handlers, VNET_CRYPTO_N_OP_IDS - 1,
+			CLIB_CACHE_LINE_BYTES);
+  vec_validate_aligned (cm->chained_ops_handlers, VNET_CRYPTO_N_OP_IDS - 1,
+			CLIB_CACHE_LINE_BYTES);
   vec_validate_aligned (cm->threads, tm->n_vlib_mains, CLIB_CACHE_LINE_BYTES);
+  vec_foreach (ct, cm->threads)
+    pool_alloc_aligned (ct->frame_pool, VNET_CRYPTO_FRAME_POOL_SIZE,
+			CLIB_CACHE_LINE_BYTES);
   vec_validate (cm->algs, VNET_CRYPTO_N_ALGS);
 #define _(n, s, l) \
   vnet_crypto_init_cipher_data (VNET_CRYPTO_ALG_##n, \
@@ -17,6 +17,8 @@
 #define included_vnet_crypto_crypto_h
 
 #define VNET_CRYPTO_RING_SIZE 512
+#define VNET_CRYPTO_FRAME_SIZE 32
+#define VNET_CRYPTO_FRAME_POOL_SIZE 256
 
 #include <vlib/vlib.h>
 
@@ -131,6 +133,7 @@ typedef struct
   u8 flags;
 #define VNET_CRYPTO_OP_FLAG_INIT_IV (1 << 0)
 #define VNET_CRYPTO_OP_FLAG_HMAC_CHECK (1 << 1)
+#define VNET_CRYPTO_OP_FLAG_CHAINED_BUFFERS (1 << 2)
   u32 key_index;
   u32 len;
   u16 aad_len;
@@ -142,19 +145,72 @@ typedef struct
   u8 *tag;
   u8 *digest;
   uword user_data;
+  /* valid if VNET_CRYPTO_OP_FLAG_CHAINED_BUFFERS is set, src, dst and len
+     are then described by n_chunks entries of the chunk array starting
+     at chunk_index */
+  u32 chunk_index;
+  u16 n_chunks;
 } vnet_crypto_op_t;
 
+typedef struct
+{
+  u8 *src;
+  u8 *dst;
+  u32 len;
+} vnet_crypto_op_chunk_t;
+
 typedef struct
 {
   vnet_crypto_op_type_t type;
   vnet_crypto_alg_t alg;
   u32 active_engine_index;
+  u32 active_engine_index_chained;
 } vnet_crypto_op_data_t;
 
+#define foreach_crypto_async_frame_state \
+  _(NOT_PROCESSED, "not-processed") \
+  _(PENDING, "pending") \
+  _(WORK_IN_PROGRESS, "work-in-progress") \
+  _(SUCCESS, "success") \
+  _(ELT_ERROR, "element-error")
+
+typedef enum
+{
+#define _(n, s) VNET_CRYPTO_FRAME_STATE_##n,
+  foreach_crypto_async_frame_state
+#undef _
+    VNET_CRYPTO_FRAME_N_STATES,
+} vnet_crypto_async_frame_state_t;
+
+/*
+ * A frame of up to VNET_CRYPTO_FRAME_SIZE elements handed to an async
+ * engine. Each element is one buffer with an optional cipher/AEAD op and an
+ * optional integrity op; op->user_data holds the element index. Frames are
+ * allocated from, and returned to, the pool of the enqueueing thread.
+ */
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  volatile vnet_crypto_async_frame_state_t state;
+  u8 flags;
+#define VNET_CRYPTO_FRAME_F_INTEG_FIRST (1 << 0)
+  u16 n_elts;
+  u16 n_crypto_ops;
+  u16 n_integ_ops;
+  u32 enqueue_thread_index;
+  u32 buffer_indices[VNET_CRYPTO_FRAME_SIZE];
+  u16 next_node_index[VNET_CRYPTO_FRAME_SIZE];
+  u8 elt_status[VNET_CRYPTO_FRAME_SIZE];
+  vnet_crypto_op_t crypto_ops[VNET_CRYPTO_FRAME_SIZE];
+  vnet_crypto_op_t integ_ops[VNET_CRYPTO_FRAME_SIZE];
+} vnet_crypto_async_frame_t;
+
 typedef struct
 {
   CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
   clib_bitmap_t *act_queues;
+  vnet_crypto_async_frame_t *frame_pool;
+  u32 n_inflight;
 } vnet_crypto_thread_t;
 
 typedef u32 vnet_crypto_key_index_t;
@@ -162,18 +218,39 @@ typedef u32 vnet_crypto_key_index_t;
 typedef u32 (vnet_crypto_ops_handler_t) (vlib_main_t * vm,
 					 vnet_crypto_op_t * ops[], u32 n_ops);
 
+typedef u32 (vnet_crypto_chained_ops_handler_t) (vlib_main_t * vm,
+						 vnet_crypto_op_t * ops[],
+						 vnet_crypto_op_chunk_t *
+						 chunks, u32 n_ops);
+
 typedef void (vnet_crypto_key_handler_t) (vlib_main_t * vm,
 					  vnet_crypto_key_op_t kop,
 					  vnet_crypto_key_index_t idx);
 
+/* returns 0 if the frame was accepted, -1 if the engine queue is full */
+typedef int (vnet_crypto_frame_enqueue_t) (vlib_main_t * vm,
+					   vnet_crypto_async_frame_t * frame);
+
+/* returns the next completed frame enqueued by the calling thread, or 0 */
+typedef vnet_crypto_async_frame_t *(vnet_crypto_frame_dequeue_t) (vlib_main_t
+								   * vm);
+
 u32 vnet_crypto_register_engine (vlib_main_t * vm, char *name, int prio,
 				 char *desc);
 
 void vnet_crypto_register_ops_handler (vlib_main_t * vm, u32 engine_index,
 				       vnet_crypto_op_id_t opt,
 				       vnet_crypto_ops_handler_t * oph);
+void vnet_crypto_register_chained_ops_handler (vlib_main_t * vm,
+					       u32 engine_index,
+					       vnet_crypto_op_id_t opt,
+					       vnet_crypto_chained_ops_handler_t
+					       * oph);
 void vnet_crypto_register_key_handler (vlib_main_t * vm, u32 engine_index,
 				       vnet_crypto_key_handler_t * keyh);
+void vnet_crypto_register_async_handler (vlib_main_t * vm, u32 engine_index,
+					 vnet_crypto_frame_enqueue_t * enqh,
+					 vnet_crypto_frame_dequeue_t * deqh);
 
 typedef struct
 {
@@ -182,6 +259,10 @@ typedef struct
   int priority;
   vnet_crypto_key_handler_t *key_op_handler;
   vnet_crypto_ops_handler_t *ops_handlers[VNET_CRYPTO_N_OP_IDS];
+  vnet_crypto_chained_ops_handler_t
+    * chained_ops_handlers[VNET_CRYPTO_N_OP_IDS];
+  vnet_crypto_frame_enqueue_t *enqueue_handler;
+  vnet_crypto_frame_dequeue_t *dequeue_handler;
 } vnet_crypto_engine_t;
 
 typedef struct
@@ -189,24 +270,43 @@ typedef struct
   vnet_crypto_alg_data_t *algs;
   vnet_crypto_thread_t *threads;
   vnet_crypto_ops_handler_t **ops_handlers;
+  vnet_crypto_chained_ops_handler_t **chained_ops_handlers;
   vnet_crypto_op_data_t opt_data[VNET_CRYPTO_N_OP_IDS];
   vnet_crypto_engine_t *engines;
   vnet_crypto_key_t *keys;
   uword *engine_index_by_name;
   uword *alg_index_by_name;
+
+  /* async mode */
+  u32 async_engine_index;
+  vnet_crypto_frame_enqueue_t *enqueue_handler;
+  vnet_crypto_frame_dequeue_t *dequeue_handler;
+  u32 async_refcnt;
+  u32 *next_nodes;
 } vnet_crypto_main_t;
 
 extern vnet_crypto_main_t crypto_main;
+extern vlib_node_registration_t crypto_dispatch_node;
 
 u32 vnet_crypto_submit_ops (vlib_main_t * vm, vnet_crypto_op_t ** jobs,
 			    u32 n_jobs);
 
 u32 vnet_crypto_process_ops (vlib_main_t * vm, vnet_crypto_op_t ops[],
 			     u32 n_ops);
+u32 vnet_crypto_process_chained_ops (vlib_main_t * vm,
+				     vnet_crypto_op_t ops[],
+				     vnet_crypto_op_chunk_t * chunks,
+				     u32 n_ops);
 
 int vnet_crypto_set_handler (char *ops_handler_name, char *engine);
 int vnet_crypto_is_set_handler (vnet_crypto_alg_t alg);
 
+int vnet_crypto_set_async_handler (char *engine);
+int vnet_crypto_request_async_mode (int is_enable);
+u32 vnet_crypto_register_post_node (vlib_main_t * vm, char *post_node_name);
+void vnet_crypto_async_process_frame (vlib_main_t * vm,
+				      vnet_crypto_async_frame_t * f);
+
 u32 vnet_crypto_key_add (vlib_main_t * vm, vnet_crypto_alg_t alg,
 			 u8 * data, u16 length);
 void vnet_crypto_key_del (vlib_main_t * vm, vnet_crypto_key_index_t index);
@@ -216,6 +316,7 @@ format_function_t format_vnet_crypto_engine;
 format_function_t format_vnet_crypto_op;
 format_function_t format_vnet_crypto_op_type;
 format_function_t format_vnet_crypto_op_status;
+format_function_t format_vnet_crypto_async_frame_state;
 unformat_function_t unformat_vnet_crypto_alg;
 
 static_always_inline void
@@ -243,6 +344,92 @@ vnet_crypto_get_key (vnet_crypto_key_index_t index)
   return vec_elt_at_index (cm->keys, index);
 }
 
+static_always_inline int
+vnet_crypto_async_is_active (void)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  return cm->async_refcnt && cm->enqueue_handler != 0;
+}
+
+static_always_inline vnet_crypto_async_frame_t *
+vnet_crypto_async_get_frame (vlib_main_t * vm)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  vnet_crypto_thread_t *ct = cm->threads + vm->thread_index;
+  vnet_crypto_async_frame_t *f;
+
+  /* the pool is preallocated and must never move under an engine which
+     may be working on one of its frames from another thread */
+  if (PREDICT_FALSE (pool_elts (ct->frame_pool) >=
+		     VNET_CRYPTO_FRAME_POOL_SIZE))
+    return 0;
+
+  pool_get_aligned (ct->frame_pool, f, CLIB_CACHE_LINE_BYTES);
+  f->state = VNET_CRYPTO_FRAME_STATE_NOT_PROCESSED;
+  f->flags = 0;
+  f->n_elts = f->n_crypto_ops = f->n_integ_ops = 0;
+  f->enqueue_thread_index = vm->thread_index;
+  return f;
+}
+
+static_always_inline void
+vnet_crypto_async_free_frame (vlib_main_t * vm,
+			      vnet_crypto_async_frame_t * f)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  vnet_crypto_thread_t *ct = cm->threads + vm->thread_index;
+  pool_put (ct->frame_pool, f);
+}
+
+static_always_inline vnet_crypto_op_t *
+vnet_crypto_async_add_crypto_op (vnet_crypto_async_frame_t * f,
+				 vnet_crypto_op_id_t opt)
+{
+  vnet_crypto_op_t *op = f->crypto_ops + f->n_crypto_ops++;
+  vnet_crypto_op_init (op, opt);
+  op->user_data = f->n_elts;
+  return op;
+}
+
+static_always_inline vnet_crypto_op_t *
+vnet_crypto_async_add_integ_op (vnet_crypto_async_frame_t * f,
+				vnet_crypto_op_id_t opt)
+{
+  vnet_crypto_op_t *op = f->integ_ops + f->n_integ_ops++;
+  vnet_crypto_op_init (op, opt);
+  op->user_data = f->n_elts;
+  return op;
+}
+
+/* close the current element, returns 1 if the frame is now full */
+static_always_inline int
+vnet_crypto_async_add_elt (vnet_crypto_async_frame_t * f, u32 buffer_index,
+			   u16 next_node)
+{
+  f->buffer_indices[f->n_elts] = buffer_index;
+  f->next_node_index[f->n_elts] = next_node;
+  f->elt_status[f->n_elts] = VNET_CRYPTO_OP_STATUS_COMPLETED;
+  f->n_elts++;
+  return f->n_elts == VNET_CRYPTO_FRAME_SIZE;
+}
+
+static_always_inline int
+vnet_crypto_async_submit_open_frame (vlib_main_t * vm,
+				     vnet_crypto_async_frame_t * f)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  vnet_crypto_thread_t *ct = cm->threads + vm->thread_index;
+
+  f->state = VNET_CRYPTO_FRAME_STATE_PENDING;
+  if (PREDICT_FALSE (cm->enqueue_handler (vm, f) < 0))
+    {
+      f->state = VNET_CRYPTO_FRAME_STATE_NOT_PROCESSED;
+      return -1;
+    }
+  ct->n_inflight++;
+  return 0;
+}
+
 #endif /* included_vnet_crypto_crypto_h */
 
 /*
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2019 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdbool.h>
+#include <vlib/vlib.h>
+#include <vnet/crypto/crypto.h>
+
+typedef enum
+{
+#define _(n, s) CRYPTO_DISPATCH_ERROR_##n,
+  foreach_crypto_op_status
+#undef _
+    CRYPTO_DISPATCH_N_ERROR,
+} crypto_dispatch_error_t;
+
+static char *crypto_dispatch_error_strings[] = {
+#define _(n, s) s,
+  foreach_crypto_op_status
+#undef _
+};
+
+#define foreach_crypto_dispatch_next \
+  _(ERR_DROP, "error-drop")
+
+typedef enum
+{
+#define _(n, s) CRYPTO_DISPATCH_NEXT_##n,
+  foreach_crypto_dispatch_next
+#undef _
+    CRYPTO_DISPATCH_N_NEXT,
+} crypto_dispatch_next_t;
+
+typedef struct
+{
+  vnet_crypto_op_status_t op_status;
+  u32 enqueue_thread_index;
+  u16 next_index;
+} crypto_dispatch_trace_t;
+
+static u8 *
+format_crypto_dispatch_trace (u8 * s, va_list * args)
+{
+  CLIB_UNUSED (vlib_main_t * vm) = va_arg (*args, vlib_main_t *);
+  CLIB_UNUSED (vlib_node_t * node) = va_arg (*args, vlib_node_t *);
+  crypto_dispatch_trace_t *t = va_arg (*args, crypto_dispatch_trace_t *);
+
+  s = format (s, "status %U thread %u next %u",
+	      format_vnet_crypto_op_status, t->op_status,
+	      t->enqueue_thread_index, t->next_index);
+  return s;
+}
+
+static_always_inline u32
+crypto_dispatch_frame (vlib_main_t * vm, vlib_node_runtime_t * node,
+		       vnet_crypto_async_frame_t * f)
+{
+  vlib_buffer_t *bufs[VNET_CRYPTO_FRAME_SIZE], **b = bufs;
+  u16 nexts[VNET_CRYPTO_FRAME_SIZE];
+  u32 i, n_elts = f->n_elts;
+
+  vlib_get_buffers (vm, f->buffer_indices, bufs, n_elts);
+
+  for (i = 0; i < n_elts; i++)
+    {
+      if (PREDICT_TRUE (f->elt_status[i] == VNET_CRYPTO_OP_STATUS_COMPLETED))
+	nexts[i] = f->next_node_index[i];
+      else
+	{
+	  b[i]->error = node->errors[f->elt_status[i]];
+	  nexts[i] = CRYPTO_DISPATCH_NEXT_ERR_DROP;
+	}
+    }
+
+  for (i = 0; i < n_elts; i++)
+    if (PREDICT_FALSE (b[i]->flags & VLIB_BUFFER_IS_TRACED))
+      {
+	crypto_dispatch_trace_t *tr;
+	tr = vlib_add_trace (vm, node, b[i], sizeof (*tr));
+	tr->op_status = f->elt_status[i];
+	tr->enqueue_thread_index = f->enqueue_thread_index;
+	tr->next_index = nexts[i];
+      }
+
+  vlib_buffer_enqueue_to_next (vm, node, f->buffer_indices, nexts, n_elts);
+  return n_elts;
+}
+
+VLIB_NODE_FN (crypto_dispatch_node) (vlib_main_t * vm,
+				     vlib_node_runtime_t * node,
+				     vlib_frame_t * frame)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  vnet_crypto_thread_t *ct = cm->threads + vm->thread_index;
+  vnet_crypto_async_frame_t *f;
+  u32 n_dispatched = 0;
+
+  if (PREDICT_FALSE (cm->dequeue_handler == 0))
+    return 0;
+
+  /* the dequeue handler also gives software engines the chance to
+     process frames enqueued by other threads */
+  while (n_dispatched < VLIB_FRAME_SIZE && (f = cm->dequeue_handler (vm)))
+    {
+      n_dispatched += crypto_dispatch_frame (vm, node, f);
+      vnet_crypto_async_free_frame (vm, f);
+      ct->n_inflight--;
+    }
+
+  if (PREDICT_FALSE (cm->async_refcnt == 0 && ct->n_inflight == 0))
+    vlib_node_set_state (vm, node->node_index, VLIB_NODE_STATE_DISABLED);
+
+  return n_dispatched;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (crypto_dispatch_node) = {
+  .name = "crypto-dispatch",
+  .type = VLIB_NODE_TYPE_INPUT,
+  .state = VLIB_NODE_STATE_DISABLED,
+  .format_trace = format_crypto_dispatch_trace,
+
+  .n_errors = ARRAY_LEN(crypto_dispatch_error_strings),
+  .error_strings = crypto_dispatch_error_strings,
+
+  .n_next_nodes = CRYPTO_DISPATCH_N_NEXT,
+  .next_nodes = {
+#define _(n, s) \
+  [CRYPTO_DISPATCH_NEXT_##n] = s,
+      foreach_crypto_dispatch_next
+#undef _
+  },
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -94,15 +94,40 @@ load_balance_alloc_i (void)
 {
     load_balance_t *lb;
 
-    pool_get_aligned(load_balance_pool, lb, CLIB_CACHE_LINE_BYTES);
+    vlib_main_t *vm;
+    u8 need_barrier_sync;
+
+    /*
+     * the pool itself is grown without the barrier, the workers may be
+     * reading it. The counters cannot be, so only when they would expand
+     * are the workers stopped.
+     */
+    vlib_rcu_pool_get_aligned(load_balance_pool, lb, CLIB_CACHE_LINE_BYTES);
     clib_memset(lb, 0, sizeof(*lb));
 
     lb->lb_map = INDEX_INVALID;
     lb->lb_urpf = INDEX_INVALID;
+
+    vm = vlib_get_main();
+    need_barrier_sync =
+        vlib_validate_combined_counter_will_expand(
+            &(load_balance_main.lbm_to_counters),
+            load_balance_get_index(lb));
+    need_barrier_sync |=
+        vlib_validate_combined_counter_will_expand(
+            &(load_balance_main.lbm_via_counters),
+            load_balance_get_index(lb));
+
+    if (need_barrier_sync)
+        vlib_worker_thread_barrier_sync(vm);
+
     vlib_validate_combined_counter(&(load_balance_main.lbm_to_counters),
                                    load_balance_get_index(lb));
     vlib_validate_combined_counter(&(load_balance_main.lbm_via_counters),
                                    load_balance_get_index(lb));
+
+    if (need_barrier_sync)
+        vlib_worker_thread_barrier_release(vm);
     vlib_zero_combined_counter(&(load_balance_main.lbm_to_counters),
                                load_balance_get_index(lb));
     vlib_zero_combined_counter(&(load_balance_main.lbm_via_counters),
@@ -111,6 +136,18 @@ load_balance_alloc_i (void)
     return (lb);
 }
 
+static void
+load_balance_buckets_free (void *data)
+{
+    dpo_id_t *buckets = data, *tmp_dpo;
+
+    vec_foreach(tmp_dpo, buckets)
+    {
+        dpo_reset(tmp_dpo);
+    }
+    vec_free(buckets);
+}
+
 static u8*
 load_balance_format (index_t lbi,
                      load_balance_format_flags_t flags,
@@ -607,7 +644,6 @@ load_balance_multipath_update (const dpo_id_t *dpo,
     u32 sum_of_weights, n_buckets, ii;
     index_t lbmi, old_lbmi;
     load_balance_t *lb;
-    dpo_id_t *tmp_dpo;
 
     nhs = NULL;
 
@@ -730,7 +766,7 @@ load_balance_multipath_update (const dpo_id_t *dpo,
                      * we are not crossing the threshold. We need a new bucket array to
                      * hold the increased number of choices.
                      */
-                    dpo_id_t *new_buckets, *old_buckets, *tmp_dpo;
+                    dpo_id_t *new_buckets, *old_buckets;
 
                     new_buckets = NULL;
                     old_buckets = load_balance_get_buckets(lb);
@@ -746,11 +782,10 @@ load_balance_multipath_update (const dpo_id_t *dpo,
                     CLIB_MEMORY_BARRIER();
                     load_balance_set_n_buckets(lb, n_buckets);
 
-                    vec_foreach(tmp_dpo, old_buckets)
-                    {
-                        dpo_reset(tmp_dpo);
-                    }
-                    vec_free(old_buckets);
+                    /*
+                     * workers may still be using the old array
+                     */
+                    vlib_rcu_call(load_balance_buckets_free, old_buckets);
                 }
             }
 
@@ -789,11 +824,8 @@ load_balance_multipath_update (const dpo_id_t *dpo,
                 load_balance_set_n_buckets(lb, n_buckets);
                 CLIB_MEMORY_BARRIER();
 
-                vec_foreach(tmp_dpo, lb->lb_buckets)
-                {
-                    dpo_reset(tmp_dpo);
-                }
-                vec_free(lb->lb_buckets);
+                vlib_rcu_call(load_balance_buckets_free, lb->lb_buckets);
+                lb->lb_buckets = NULL;
             }
             else
             {
@@ -600,7 +600,11 @@ fib_entry_alloc (u32 fib_index,
     fib_entry_t *fib_entry;
     fib_prefix_t *fep;
 
-    pool_get(fib_entry_pool, fib_entry);
+    /*
+     * the session layer's workers read FIB entries, so the pool is
+     * grown without pulling the vector out from under them.
+     */
+    vlib_rcu_pool_get(fib_entry_pool, fib_entry);
     clib_memset(fib_entry, 0, sizeof(*fib_entry));
 
     fib_node_init(&fib_entry->fe_node,
@@ -40,6 +40,11 @@ typedef enum fib_walk_flags_t_
      * An indication that the walk is currently executing.
      */
     FIB_WALK_FLAG_EXECUTING = (1 << 2),
+    /**
+     * A synchronous walk whose execution is deferred until the end of
+     * the current batch of updates.
+     */
+    FIB_WALK_FLAG_DEFERRED = (1 << 3),
 } fib_walk_flags_t;
 
 /**
@@ -65,7 +70,8 @@ typedef struct fib_walk_t_
     u32 fw_dep_sibling;
 
     /**
-     * Sibling index in the list of all walks
+     * Sibling index in the list of all walks, or in the list of deferred
+     * walks
      */
     u32 fw_prio_sibling;
 
@@ -155,6 +161,21 @@ typedef struct fib_walk_queues_t_
  */
 static fib_walk_queues_t fib_walk_queues;
 
+/**
+ * The sync walks deferred until the end of the batch, in the order they
+ * were requested, and the DB of them keyed by parent
+ */
+static fib_node_list_t fib_walk_deferred;
+static uword *fib_walk_deferred_db;
+
+/**
+ * Nesting depth of batches. Sync walks are deferred while non-zero.
+ */
+static u32 fib_walk_defer_depth;
+
+#define FIB_WALK_DEFERRED_KEY(_type, _index) \
+    (((u64)(_type) << 32) | (_index))
+
 /**
  * The names of the walk priorities
  */
@@ -259,6 +280,12 @@ fib_walk_destroy (index_t fwi)
     {
 	fib_node_list_elt_remove(fwalk->fw_prio_sibling);
     }
+    if (fwalk->fw_flags & FIB_WALK_FLAG_DEFERRED)
+    {
+        hash_unset(fib_walk_deferred_db,
+                   FIB_WALK_DEFERRED_KEY(fwalk->fw_parent.fnp_type,
+                                         fwalk->fw_parent.fnp_index));
+    }
     fib_node_child_remove(fwalk->fw_parent.fnp_type,
 			  fwalk->fw_parent.fnp_index,
 			  fwalk->fw_dep_sibling);
@@ -735,50 +762,55 @@ fib_walk_async (fib_node_type_t parent_type,
 }
 
 /**
- * @brief Back walk all the children of a FIB node.
- *
- * note this is a synchronous depth first walk. Children visited may propagate
- * the walk to thier children. Other children node types may not propagate,
- * synchronously but instead queue the walk for later async completion.
+ * @brief Merge a walk context into those of a walk. The contexts can be
+ * merged if the reason for the walk is the same.
  */
-void
-fib_walk_sync (fib_node_type_t parent_type,
-	       fib_node_index_t parent_index,
-	       fib_node_back_walk_ctx_t *ctx)
+static void
+fib_walk_ctx_merge (fib_walk_t *fwalk,
+                    fib_node_back_walk_ctx_t *ctx)
 {
-    fib_walk_advance_rc_t rc;
-    fib_node_index_t fwi;
-    fib_walk_t *fwalk;
+    fib_node_back_walk_ctx_t *last;
 
-    if (FIB_NODE_GRAPH_MAX_DEPTH < ++ctx->fnbw_depth)
+    /*
+     * check whether the walk context can be merged with the most recent.
+     * the most recent was the one last added and is thus at the back of the vector.
+     */
+    last = vec_end(fwalk->fw_ctx) - 1;
+
+    if (last->fnbw_reason == ctx->fnbw_reason)
     {
-	/*
-	 * The walk has reached the maximum depth. there is a loop in the graph.
-	 * bail.
-	 */
-	return;
+        /*
+         * copy the largest of the depth values. in the presence of a loop,
+         * the same walk will merge with itself. if we take the smaller depth
+         * then it will never end.
+         */
+        last->fnbw_depth = ((last->fnbw_depth >= ctx->fnbw_depth) ?
+                            last->fnbw_depth :
+                            ctx->fnbw_depth);
     }
-    if (0 == fib_node_get_n_children(parent_type,
-                                     parent_index))
+    else
     {
         /*
-         * no children to walk - quit now
+         * walks could not be merged, this means that the walk infront needs to
+         * perform different action to this one that has caught up. the one in
+         * front was scheduled first so append the new walk context to the back
+         * of the list.
          */
-        return;
+        vec_add1(fwalk->fw_ctx, *ctx);
     }
+}
 
-    fwalk = fib_walk_alloc(parent_type,
-			   parent_index,
-			   FIB_WALK_FLAG_SYNC,
-			   ctx);
+/**
+ * @brief Run a sync walk to completion
+ */
+static void
+fib_walk_sync_execute (fib_node_index_t fwi,
+                       fib_node_back_walk_ctx_t *ctx)
+{
+    fib_walk_advance_rc_t rc;
+    fib_walk_t *fwalk;
 
-    fwalk->fw_dep_sibling = fib_node_child_add(parent_type,
-					       parent_index,
-					       FIB_NODE_TYPE_WALK,
-					       fib_walk_get_index(fwalk));
-    fwi = fib_walk_get_index(fwalk);
-    FIB_WALK_DBG(fwalk, "sync-start: %U",
-                 format_fib_node_bw_reason, ctx->fnbw_reason);
+    fwalk = fib_walk_get(fwi);
 
     while (1)
     {
@@ -858,6 +890,144 @@ fib_walk_sync (fib_node_type_t parent_type,
     }
 }
 
+/**
+ * @brief Defer a sync walk until the end of the batch. All the walks
+ * requested on the same parent in the meantime are coalesced into one.
+ */
+static void
+fib_walk_defer (fib_node_type_t parent_type,
+                fib_node_index_t parent_index,
+                fib_node_back_walk_ctx_t *ctx)
+{
+    fib_walk_t *fwalk;
+    uword *p;
+
+    p = hash_get(fib_walk_deferred_db,
+                 FIB_WALK_DEFERRED_KEY(parent_type, parent_index));
+
+    if (NULL != p)
+    {
+        fib_walk_ctx_merge(fib_walk_get(p[0]), ctx);
+        return;
+    }
+
+    fwalk = fib_walk_alloc(parent_type,
+			   parent_index,
+			   FIB_WALK_FLAG_SYNC | FIB_WALK_FLAG_DEFERRED,
+			   ctx);
+
+    /*
+     * the walk is a child of the parent, like all others. this keeps the
+     * parent locked until the walk is done, and other walks reaching the
+     * deferred one merge with it.
+     */
+    fwalk->fw_dep_sibling = fib_node_child_add(parent_type,
+					       parent_index,
+					       FIB_NODE_TYPE_WALK,
+					       fib_walk_get_index(fwalk));
+    fwalk->fw_prio_sibling = fib_node_list_push_back(fib_walk_deferred,
+                                                     0,
+                                                     FIB_NODE_TYPE_WALK,
+                                                     fib_walk_get_index(fwalk));
+    hash_set(fib_walk_deferred_db,
+             FIB_WALK_DEFERRED_KEY(parent_type, parent_index),
+             fib_walk_get_index(fwalk));
+
+    FIB_WALK_DBG(fwalk, "sync-defer: %U",
+                 format_fib_node_bw_reason, ctx->fnbw_reason);
+}
+
+void
+fib_walk_defer_start (void)
+{
+    fib_walk_defer_depth++;
+}
+
+void
+fib_walk_defer_end (void)
+{
+    fib_node_back_walk_ctx_t ctx;
+    fib_node_ptr_t wp;
+    fib_walk_t *fwalk;
+
+    ASSERT(fib_walk_defer_depth > 0);
+
+    if (--fib_walk_defer_depth)
+        return;
+
+    while (fib_node_list_get_front(fib_walk_deferred, &wp))
+    {
+        fwalk = fib_walk_get(wp.fnp_index);
+
+        fib_node_list_elt_remove(fwalk->fw_prio_sibling);
+        fwalk->fw_prio_sibling = FIB_NODE_INDEX_INVALID;
+        hash_unset(fib_walk_deferred_db,
+                   FIB_WALK_DEFERRED_KEY(fwalk->fw_parent.fnp_type,
+                                         fwalk->fw_parent.fnp_index));
+        fwalk->fw_flags &= ~FIB_WALK_FLAG_DEFERRED;
+
+        ctx = fwalk->fw_ctx[0];
+        fib_walk_sync_execute(wp.fnp_index, &ctx);
+    }
+}
+
+/**
+ * @brief Back walk all the children of a FIB node.
+ *
+ * note this is a synchronous depth first walk. Children visited may propagate
+ * the walk to thier children. Other children node types may not propagate,
+ * synchronously but instead queue the walk for later async completion.
+ */
+void
+fib_walk_sync (fib_node_type_t parent_type,
+	       fib_node_index_t parent_index,
+	       fib_node_back_walk_ctx_t *ctx)
+{
+    fib_node_index_t fwi;
+    fib_walk_t *fwalk;
+
+    if (FIB_NODE_GRAPH_MAX_DEPTH < ++ctx->fnbw_depth)
+    {
+	/*
+	 * The walk has reached the maximum depth. there is a loop in the graph.
+	 * bail.
+	 */
+	return;
+    }
+    if (0 == fib_node_get_n_children(parent_type,
+                                     parent_index))
+    {
+        /*
+         * no children to walk - quit now
+         */
+        return;
+    }
+    if (fib_walk_defer_depth &&
+        !(ctx->fnbw_flags & FIB_NODE_BW_FLAG_FORCE_SYNC))
+    {
+        /*
+         * in the middle of a batch of updates. the children are walked
+         * once at the end of it.
+         */
+        return (fib_walk_defer(parent_type, parent_index, ctx));
+    }
+
+    fwalk = fib_walk_alloc(parent_type,
+			   parent_index,
+			   FIB_WALK_FLAG_SYNC,
+			   ctx);
+
+    fwalk->fw_dep_sibling = fib_node_child_add(parent_type,
+					       parent_index,
+					       FIB_NODE_TYPE_WALK,
+					       fib_walk_get_index(fwalk));
+    fwi = fib_walk_get_index(fwalk);
+    FIB_WALK_DBG(fwalk, "sync-start: %U",
+                 format_fib_node_bw_reason, ctx->fnbw_reason);
+
+    fib_walk_sync_execute(fwi, ctx);
+}
+
 static fib_node_t *
 fib_walk_get_node (fib_node_index_t index)
 {
@@ -894,39 +1064,11 @@ static fib_node_back_walk_rc_t
 fib_walk_back_walk_notify (fib_node_t *node,
 			   fib_node_back_walk_ctx_t *ctx)
 {
-    fib_node_back_walk_ctx_t *last;
     fib_walk_t *fwalk;
 
     fwalk = fib_walk_get_from_node(node);
 
-    /*
-     * check whether the walk context can be merged with the most recent.
-     * the most recent was the one last added and is thus at the back of the vector.
-     * we can merge walks if the reason for the walk is the same.
-     */
-    last = vec_end(fwalk->fw_ctx) - 1;
-
-    if (last->fnbw_reason == ctx->fnbw_reason)
-    {
-        /*
-         * copy the largest of the depth values. in the presence of a loop,
-         * the same walk will merge with itself. if we take the smaller depth
-         * then it will never end.
-         */
-        last->fnbw_depth = ((last->fnbw_depth >= ctx->fnbw_depth) ?
-                            last->fnbw_depth :
-                            ctx->fnbw_depth);
-    }
-    else
-    {
-        /*
-         * walks could not be merged, this means that the walk infront needs to
-         * perform different action to this one that has caught up. the one in
-         * front was scheduled first so append the new walk context to the back
-         * of the list.
-         */
-        vec_add1(fwalk->fw_ctx, *ctx);
-    }
+    fib_walk_ctx_merge(fwalk, ctx);
 
     return (FIB_NODE_BACK_WALK_MERGE);
 }
@@ -949,6 +1091,7 @@ fib_walk_module_init (void)
     {
 	fib_walk_queues.fwqs_queues[prio].fwq_queue = fib_node_list_create();
     }
+    fib_walk_deferred = fib_node_list_create();
 
     fib_node_register_type(FIB_NODE_TYPE_WALK, &fib_walk_vft);
     fib_walk_logger = vlib_log_register_class("fib", "walk");
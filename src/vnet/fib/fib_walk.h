@@ -52,6 +52,23 @@ extern void fib_walk_sync(fib_node_type_t parent_type,
                           fib_node_index_t parent_index,
                           fib_node_back_walk_ctx_t *ctx);
 
+/**
+ * @brief Start a batch of updates. Synchronous walks requested until the
+ * matching fib_walk_defer_end() are deferred and those on the same parent
+ * coalesced, so each parent's children are walked only once per batch.
+ * Walks flagged FIB_NODE_BW_FLAG_FORCE_SYNC are never deferred.
+ *
+ * The workers must not run while walks are deferred, i.e. a batch is
+ * only permitted with the barrier held.
+ */
+extern void fib_walk_defer_start(void);
+
+/**
+ * @brief End a batch of updates and execute the deferred walks.
+ * Batches nest, the walks are run when the outermost one ends.
+ */
+extern void fib_walk_defer_end(void);
+
 extern u8* format_fib_walk_priority(u8 *s, va_list *ap);
 
 extern void fib_walk_process_enable(void);
@@ -581,6 +581,11 @@ format_ip4_fib_table_memory (u8 * s, va_list * args)
     return (s);
 }
 
+/**
+ * Random lookups done to measure the mtrie's lookup rate
+ */
+#define IP4_FIB_MTRIE_RATE_N_LOOKUPS (1 << 16)
+
 static clib_error_t *
 ip4_show_fib (vlib_main_t * vm,
 	      unformat_input_t * input,
@@ -694,6 +699,9 @@ ip4_show_fib (vlib_main_t * vm,
 	if (mtrie)
         {
 	    vlib_cli_output (vm, "%U", format_ip4_fib_mtrie, &fib->mtrie, verbose);
+            vlib_cli_output (vm, "lookup rate: %.2f Mlookups/sec",
+                             ip4_fib_mtrie_lookup_rate (&fib->mtrie,
+                                                        IP4_FIB_MTRIE_RATE_N_LOOKUPS) / 1e6);
             continue;
         }
 	if (! verbose)
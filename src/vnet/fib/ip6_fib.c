@@ -20,6 +20,397 @@
 #include <vppinfra/bihash_24_8.h>
 #include <vppinfra/bihash_template.c>
 
+/**
+ * Seconds without forwarding updates before a FIB's binary search
+ * entries are rebuilt, and the most a rebuild is deferred by a stream
+ * of updates
+ */
+#define IP6_FIB_BSEARCH_REBUILD_DELAY (0.05)
+#define IP6_FIB_BSEARCH_REBUILD_MAX_DELAY (1.0)
+
+/**
+ * Prefixes added per rebuild step, before yielding the main thread
+ */
+#define IP6_FIB_BSEARCH_REBUILD_QUOTA 1024
+
+/**
+ * FIBs waiting for a binary search rebuild
+ */
+static u32 *ip6_fib_bsearch_pending;
+
+vlib_node_registration_t ip6_fib_bsearch_process_node;
+
+/**
+ * @brief Switch a FIB's lookups back to hash probing until the binary
+ * search entries are rebuilt. Called on every change to its forwarding
+ * entries.
+ */
+static void ip6_fib_table_bsearch_purge(ip6_fib_t *fib);
+
+static void
+ip6_fib_table_bsearch_invalidate (u32 fib_index)
+{
+    ip6_fib_t *fib = ip6_fib_get(fib_index);
+
+    if (IP6_FIB_LOOKUP_ALGO_BSEARCH != fib->lookup_algo)
+        return;
+
+    fib->bsearch_ready = 0;
+    fib->bsearch_version++;
+
+    /*
+     * the entries carry the load-balance of their best match, which this
+     * change may be about to free. remove them now rather than at the
+     * rebuild; only the first change of a burst pays for the walk.
+     */
+    ip6_fib_table_bsearch_purge(fib);
+
+    if (!fib->bsearch_pending)
+    {
+        fib->bsearch_pending = 1;
+        vec_add1(ip6_fib_bsearch_pending, fib_index);
+        vlib_process_signal_event(vlib_get_main(),
+                                  ip6_fib_bsearch_process_node.index,
+                                  0, 0);
+    }
+}
+
+typedef struct ip6_fib_bsearch_collect_ctx_t_
+{
+    u32 fib_index;
+    clib_bihash_kv_24_8_t *prefixes;
+    clib_bihash_kv_24_8_t *bsearch;
+} ip6_fib_bsearch_collect_ctx_t;
+
+static void
+ip6_fib_bsearch_collect (clib_bihash_kv_24_8_t * kvp,
+                         void *arg)
+{
+    ip6_fib_bsearch_collect_ctx_t *ctx = arg;
+
+    if ((kvp->key[2] >> 32) != ctx->fib_index)
+        return;
+
+    if (kvp->key[2] & IP6_FIB_BSEARCH_KEY_FLAG)
+        vec_add1(ctx->bsearch, *kvp);
+    else
+        vec_add1(ctx->prefixes, *kvp);
+}
+
+static void
+ip6_fib_bsearch_collect_fib (ip6_fib_bsearch_collect_ctx_t *ctx,
+                             u32 fib_index)
+{
+    clib_bihash_kv_24_8_t *kvp;
+
+    ctx->fib_index = fib_index;
+    clib_bihash_foreach_key_value_pair_24_8(
+        &ip6_main.ip6_table[IP6_FIB_TABLE_FWDING].ip6_hash,
+        ip6_fib_bsearch_collect,
+        ctx);
+
+    /* the walk is not safe to deletes, so remove the old entries after */
+    vec_foreach(kvp, ctx->bsearch)
+    {
+        clib_bihash_add_del_24_8(
+            &ip6_main.ip6_table[IP6_FIB_TABLE_FWDING].ip6_hash, kvp, 0);
+    }
+}
+
+/**
+ * @brief Remove the binary search entries of a FIB from the forwarding
+ * hash, if it has any
+ */
+static void
+ip6_fib_table_bsearch_purge (ip6_fib_t *fib)
+{
+    ip6_fib_bsearch_collect_ctx_t ctx = {
+        .prefixes = NULL,
+        .bsearch = NULL,
+    };
+
+    if (!fib->bsearch_populated)
+        return;
+
+    ip6_fib_bsearch_collect_fib(&ctx, fib->index);
+    fib->bsearch_populated = 0;
+
+    vec_free(ctx.prefixes);
+    vec_free(ctx.bsearch);
+}
+
+/**
+ * @brief Remove all binary search entries of a FIB
+ */
+static void
+ip6_fib_table_bsearch_flush (ip6_fib_t *fib)
+{
+    fib->bsearch_ready = 0;
+    fib->bsearch_version++;
+
+    ip6_fib_table_bsearch_purge(fib);
+    vec_free(fib->bsearch_prefix_lengths);
+}
+
+/**
+ * @brief The longest prefix covering addr/lengths[i], from the per-prefix
+ * entries
+ */
+static u32
+ip6_fib_bsearch_best_match (u32 fib_index,
+                            const u8 *lengths,
+                            int i,
+                            const ip6_address_t *addr)
+{
+    ip6_fib_table_instance_t *table;
+    clib_bihash_kv_24_8_t kv, value;
+    ip6_address_t *mask;
+
+    table = &ip6_main.ip6_table[IP6_FIB_TABLE_FWDING];
+
+    for (; i >= 0; i--)
+    {
+	mask = &ip6_main.fib_masks[lengths[i]];
+	kv.key[0] = addr->as_u64[0] & mask->as_u64[0];
+	kv.key[1] = addr->as_u64[1] & mask->as_u64[1];
+	kv.key[2] = ((u64)fib_index << 32) | lengths[i];
+
+	if (0 == clib_bihash_search_inline_2_24_8(&table->ip6_hash,
+                                                  &kv, &value))
+	    return (value.value);
+    }
+
+    /* default route is always present */
+    ASSERT(0);
+    return (0);
+}
+
+/**
+ * @brief Rebuild the binary search entries of a FIB from its per-prefix
+ * forwarding entries.
+ *
+ * Each prefix gets an entry at its own length and a marker at each
+ * shorter length the binary search visits on the way to it. Every entry
+ * carries the best matching prefix of its address and length, so a
+ * search that follows a marker and then misses still has the answer.
+ *
+ * @return 0 if the FIB changed while the rebuild yielded, in which case
+ * it has been queued again.
+ */
+static int
+ip6_fib_table_bsearch_rebuild (vlib_main_t *vm,
+                               u32 fib_index)
+{
+    ip6_fib_bsearch_collect_ctx_t ctx = {
+        .prefixes = NULL,
+        .bsearch = NULL,
+    };
+    clib_bihash_kv_24_8_t kv, value, *kvp;
+    ip6_fib_table_instance_t *table;
+    uword *lengths_bitmap = NULL;
+    u8 *lengths = NULL, *index_of_length = NULL;
+    ip6_address_t addr, *mask;
+    int lo, hi, mid, len, i, rv;
+    ip6_fib_t *fib;
+    u32 version, n_added;
+
+    table = &ip6_main.ip6_table[IP6_FIB_TABLE_FWDING];
+    fib = ip6_fib_get(fib_index);
+    version = fib->bsearch_version;
+    rv = 1;
+
+    ip6_fib_bsearch_collect_fib(&ctx, fib_index);
+    fib->bsearch_populated = 1;
+
+    vec_foreach(kvp, ctx.prefixes)
+    {
+        lengths_bitmap = clib_bitmap_set(lengths_bitmap,
+                                         kvp->key[2] & 0xff, 1);
+    }
+    vec_validate(index_of_length, 128);
+    clib_bitmap_foreach (i, lengths_bitmap,
+    ({
+        index_of_length[i] = vec_len(lengths);
+        vec_add1(lengths, i);
+    }));
+
+    n_added = 0;
+    vec_foreach(kvp, ctx.prefixes)
+    {
+        len = kvp->key[2] & 0xff;
+        addr.as_u64[0] = kvp->key[0];
+        addr.as_u64[1] = kvp->key[1];
+
+        lo = 0;
+        hi = vec_len(lengths) - 1;
+
+        while (lo <= hi)
+        {
+            mid = (lo + hi) >> 1;
+            mask = &ip6_main.fib_masks[lengths[mid]];
+
+            kv.key[0] = addr.as_u64[0] & mask->as_u64[0];
+            kv.key[1] = addr.as_u64[1] & mask->as_u64[1];
+            kv.key[2] = (((u64)fib_index << 32) |
+                         IP6_FIB_BSEARCH_KEY_FLAG |
+                         lengths[mid]);
+
+            /*
+             * the value only depends on the key, so an entry added as a
+             * marker for a longer prefix is already correct for the prefix
+             * at that length, and vice versa
+             */
+            if (clib_bihash_search_inline_2_24_8(&table->ip6_hash,
+                                                 &kv, &value))
+            {
+                kv.value = ip6_fib_bsearch_best_match(fib_index, lengths,
+                                                      mid, &addr);
+                clib_bihash_add_del_24_8(&table->ip6_hash, &kv, 1);
+            }
+
+            if (mid == index_of_length[len])
+                break;
+            else if (mid < index_of_length[len])
+                lo = mid + 1;
+            else
+                hi = mid - 1;
+        }
+
+        if (++n_added % IP6_FIB_BSEARCH_REBUILD_QUOTA == 0)
+        {
+            vlib_process_suspend(vm, 1e-5);
+
+            /*
+             * the table changed or was deleted while we were away. the
+             * change purged the entries added so far
+             */
+            if (pool_is_free_index(ip6_main.v6_fibs, fib_index))
+            {
+                rv = 0;
+                goto done;
+            }
+            fib = ip6_fib_get(fib_index);
+            if (version != fib->bsearch_version ||
+                IP6_FIB_LOOKUP_ALGO_BSEARCH != fib->lookup_algo)
+            {
+                rv = 0;
+                goto done;
+            }
+        }
+    }
+
+    /* lookups are still hash probing, the old lengths are not in use */
+    vec_free(fib->bsearch_prefix_lengths);
+    fib->bsearch_prefix_lengths = lengths;
+    lengths = NULL;
+
+    CLIB_MEMORY_STORE_BARRIER();
+    fib->bsearch_ready = 1;
+
+done:
+    vec_free(lengths);
+    vec_free(index_of_length);
+    clib_bitmap_free(lengths_bitmap);
+    vec_free(ctx.prefixes);
+    vec_free(ctx.bsearch);
+
+    return (rv);
+}
+
+static uword
+ip6_fib_bsearch_process (vlib_main_t * vm,
+                         vlib_node_runtime_t * rt,
+                         vlib_frame_t * f)
+{
+    uword *event_data = NULL;
+    u32 *fib_indices = NULL, *fib_index;
+    ip6_fib_t *fib;
+    f64 start;
+
+    while (1)
+    {
+        if (0 == vec_len(ip6_fib_bsearch_pending))
+            vlib_process_wait_for_event(vm);
+        vlib_process_get_events(vm, &event_data);
+        vec_reset_length(event_data);
+
+        /*
+         * routes tend to come in bursts; wait for the burst to end so each
+         * FIB is rebuilt once, but not forever
+         */
+        start = vlib_time_now(vm);
+        while (vlib_time_now(vm) - start < IP6_FIB_BSEARCH_REBUILD_MAX_DELAY)
+        {
+            vlib_process_wait_for_event_or_clock(
+                vm, IP6_FIB_BSEARCH_REBUILD_DELAY);
+            if (~0 == vlib_process_get_events(vm, &event_data))
+                break;
+            vec_reset_length(event_data);
+        }
+
+        vec_append(fib_indices, ip6_fib_bsearch_pending);
+        vec_reset_length(ip6_fib_bsearch_pending);
+
+        vec_foreach(fib_index, fib_indices)
+        {
+            if (pool_is_free_index(ip6_main.v6_fibs, *fib_index))
+                continue;
+
+            fib = ip6_fib_get(*fib_index);
+            fib->bsearch_pending = 0;
+
+            if (IP6_FIB_LOOKUP_ALGO_BSEARCH != fib->lookup_algo)
+                continue;
+
+            /* a failed rebuild was due to a change which re-queued it */
+            ip6_fib_table_bsearch_rebuild(vm, *fib_index);
+        }
+        vec_reset_length(fib_indices);
+    }
+
+    return (0);
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (ip6_fib_bsearch_process_node) = {
+    .function = ip6_fib_bsearch_process,
+    .type = VLIB_NODE_TYPE_PROCESS,
+    .name = "ip6-fib-bsearch-rebuild",
+};
+/* *INDENT-ON* */
+
+void
+ip6_fib_table_set_lookup_algo (u32 fib_index,
+                               ip6_fib_lookup_algo_t algo)
+{
+    ip6_fib_t *fib = ip6_fib_get(fib_index);
+
+    if (algo == fib->lookup_algo)
+        return;
+
+    fib->lookup_algo = algo;
+
+    if (IP6_FIB_LOOKUP_ALGO_BSEARCH == algo)
+        ip6_fib_table_bsearch_invalidate(fib_index);
+    else
+        ip6_fib_table_bsearch_flush(fib);
+}
+
+u8 *
+format_ip6_fib_lookup_algo (u8 * s, va_list * args)
+{
+    ip6_fib_lookup_algo_t algo = va_arg (*args, int);
+
+    switch (algo)
+    {
+    case IP6_FIB_LOOKUP_ALGO_HASH:
+        return (format(s, "hash"));
+    case IP6_FIB_LOOKUP_ALGO_BSEARCH:
+        return (format(s, "bsearch"));
+    }
+    return (format(s, "unknown"));
+}
+
 static void
 vnet_ip6_fib_init (u32 fib_index)
 {
@@ -85,6 +476,7 @@ create_fib_with_table_id (u32 table_id,
     fib_table->ft_flow_hash_config = IP_FLOW_HASH_DEFAULT;
     fib_table->ft_flags = flags;
     fib_table->ft_desc = desc;
+    v6_fib->lookup_algo = ip6_main.fib_lookup_algo;
 
     vnet_ip6_fib_init(fib_table->ft_index);
     fib_table_lock(fib_table->ft_index, FIB_PROTOCOL_IP6, src);
@@ -164,6 +556,7 @@ ip6_fib_table_destroy (u32 fib_index)
     {
 	hash_unset (ip6_main.fib_index_by_table_id, fib_table->ft_table_id);
     }
+    ip6_fib_table_bsearch_flush(ip6_fib_get(fib_index));
     pool_put_index(ip6_main.v6_fibs, fib_table->ft_index);
     pool_put(ip6_main.fibs, fib_table);
 }
@@ -364,6 +757,8 @@ ip6_fib_table_fwding_dpo_update (u32 fib_index,
         clib_bitmap_set (table->non_empty_dst_address_length_bitmap, 
 			 128 - len, 1);
     compute_prefix_lengths_in_search_order (table);
+
+    ip6_fib_table_bsearch_invalidate (fib_index);
 }
 
 void
@@ -397,6 +792,8 @@ ip6_fib_table_fwding_dpo_remove (u32 fib_index,
                              128 - len, 0);
 	compute_prefix_lengths_in_search_order (table);
     }
+
+    ip6_fib_table_bsearch_invalidate (fib_index);
 }
 
 /**
@@ -704,6 +1101,15 @@ ip6_show_fib (vlib_main_t * vm,
 	    clib_bihash_24_8_t * h = &im6->ip6_table[IP6_FIB_TABLE_NON_FWDING].ip6_hash;
 	    int len;
 
+	    if (IP6_FIB_LOOKUP_ALGO_BSEARCH == fib->lookup_algo)
+		vlib_cli_output (vm, "lookup: %U, %d prefix lengths%s",
+				 format_ip6_fib_lookup_algo, fib->lookup_algo,
+				 vec_len (fib->bsearch_prefix_lengths),
+				 (fib->bsearch_ready ? "" : ", rebuilding"));
+	    else
+		vlib_cli_output (vm, "lookup: %U",
+				 format_ip6_fib_lookup_algo, fib->lookup_algo);
+
 	    vlib_cli_output (vm, "%=20s%=16s", "Prefix length", "Count");
 
 	    clib_memset (ca, 0, sizeof(*ca));
@@ -835,3 +1241,59 @@ VLIB_CLI_COMMAND (ip6_show_fib_command, static) = {
     .function = ip6_show_fib,
 };
 /* *INDENT-ON* */
+
+static clib_error_t *
+ip6_set_fib_lookup (vlib_main_t * vm,
+                    unformat_input_t * input,
+                    vlib_cli_command_t * cmd)
+{
+    u32 algo = ~0;
+    u32 table_id = 0;
+    u32 fib_index;
+
+    while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+	if (unformat (input, "table %d", &table_id))
+	    ;
+	else if (unformat (input, "hash"))
+	    algo = IP6_FIB_LOOKUP_ALGO_HASH;
+	else if (unformat (input, "bsearch"))
+	    algo = IP6_FIB_LOOKUP_ALGO_BSEARCH;
+	else
+	    return (clib_error_return (0, "unknown input '%U'",
+                                       format_unformat_error, input));
+    }
+
+    if (~0 == algo)
+	return (clib_error_return (0, "specify hash or bsearch"));
+
+    fib_index = ip6_fib_index_from_table_id (table_id);
+    if (~0 == fib_index)
+	return (clib_error_return (0, "no such table: %d", table_id));
+
+    ip6_fib_table_set_lookup_algo (fib_index, algo);
+
+    return (NULL);
+}
+
+/*?
+ * This command selects the algorithm used to find the longest matching
+ * prefix in an IPv6 table. 'hash' probes the table once per distinct
+ * prefix length; 'bsearch' does a binary search on the prefix lengths, at
+ * the cost of extra marker entries in the forwarding hash. The binary
+ * search entries are rebuilt in the background after the table changes,
+ * and lookups probe every length until the rebuild completes.
+ * The default for new tables is set with 'ip6 { fib-lookup bsearch }'
+ * in the startup config.
+ *
+ * @cliexpar
+ * @cliexstart{set ip6 fib lookup table 1 bsearch}
+ * @cliexend
+ ?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (ip6_set_fib_lookup_command, static) = {
+    .path = "set ip6 fib lookup",
+    .short_help = "set ip6 fib lookup [table <table-id>] hash|bsearch",
+    .function = ip6_set_fib_lookup,
+};
+/* *INDENT-ON* */
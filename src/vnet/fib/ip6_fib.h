@@ -63,10 +63,20 @@ extern void ip6_fib_table_walk(u32 fib_index,
                                fib_table_walk_fn_t fn,
                                void *ctx);
 
+static inline ip6_fib_t *
+ip6_fib_get (fib_node_index_t index)
+{
+    ASSERT(!pool_is_free_index(ip6_main.fibs, index));
+    return (pool_elt_at_index (ip6_main.v6_fibs, index));
+}
+
+/**
+ * @brief Lookup by probing the forwarding hash for each prefix length in
+ * use, longest first.
+ */
 always_inline u32
-ip6_fib_table_fwding_lookup (ip6_main_t * im,
-                             u32 fib_index,
-                             const ip6_address_t * dst)
+ip6_fib_table_fwding_lookup_hash (u32 fib_index,
+                                  const ip6_address_t * dst)
 {
     ip6_fib_table_instance_t *table;
     clib_bihash_kv_24_8_t kv, value;
@@ -102,6 +112,159 @@ ip6_fib_table_fwding_lookup (ip6_main_t * im,
     return 0;
 }
 
+/**
+ * @brief Lookup by binary search on the FIB's prefix lengths.
+ * A hit, on a prefix or a marker, records its best matching prefix and
+ * moves the search to the longer lengths; a miss to the shorter ones.
+ */
+always_inline u32
+ip6_fib_table_fwding_lookup_bsearch (const ip6_fib_t * fib,
+                                     const ip6_address_t * dst)
+{
+    ip6_fib_table_instance_t *table;
+    clib_bihash_kv_24_8_t kv, value;
+    const ip6_address_t *mask;
+    int lo, hi, mid, len;
+    u32 lbi;
+    u64 key;
+
+    table = &ip6_main.ip6_table[IP6_FIB_TABLE_FWDING];
+    key = ((u64)(fib->index) << 32) | IP6_FIB_BSEARCH_KEY_FLAG;
+    lo = 0;
+    hi = vec_len (fib->bsearch_prefix_lengths) - 1;
+
+    /* the default route is always present, so a result is always found */
+    lbi = 0;
+
+    while (lo <= hi)
+    {
+	mid = (lo + hi) >> 1;
+	len = fib->bsearch_prefix_lengths[mid];
+	mask = &ip6_main.fib_masks[len];
+
+	kv.key[0] = dst->as_u64[0] & mask->as_u64[0];
+	kv.key[1] = dst->as_u64[1] & mask->as_u64[1];
+	kv.key[2] = key | len;
+
+	if (0 == clib_bihash_search_inline_2_24_8(&table->ip6_hash, &kv, &value))
+	{
+	    lbi = value.value;
+	    lo = mid + 1;
+	}
+	else
+	    hi = mid - 1;
+    }
+
+    return (lbi);
+}
+
+always_inline u32
+ip6_fib_table_fwding_lookup (ip6_main_t * im,
+                             u32 fib_index,
+                             const ip6_address_t * dst)
+{
+    const ip6_fib_t *fib = ip6_fib_get (fib_index);
+
+    if (fib->bsearch_ready)
+	return (ip6_fib_table_fwding_lookup_bsearch (fib, dst));
+
+    return (ip6_fib_table_fwding_lookup_hash (fib_index, dst));
+}
+
+/**
+ * @brief Lookup four destinations at once.
+ * The lookups advance in lockstep, one batched hash search per step, so
+ * the cache misses of the four overlap. Each FIB may use either algorithm.
+ */
+always_inline void
+ip6_fib_table_fwding_lookup_x4 (ip6_main_t * im,
+                                const u32 * fib_index,
+                                const ip6_address_t ** dst,
+                                u32 * lbi)
+{
+    ip6_fib_table_instance_t *table;
+    clib_bihash_kv_24_8_t kv[4];
+    const ip6_fib_t *fib[4];
+    const ip6_address_t *mask;
+    int lo[4], hi[4], mid[4];
+    u8 found[4], lane[4], bsearch[4];
+    int i, j, n, len;
+    u64 key;
+
+    table = &ip6_main.ip6_table[IP6_FIB_TABLE_FWDING];
+
+    for (i = 0; i < 4; i++)
+    {
+	fib[i] = ip6_fib_get (fib_index[i]);
+	bsearch[i] = fib[i]->bsearch_ready;
+	lbi[i] = 0;
+	lo[i] = 0;
+	hi[i] = (bsearch[i] ?
+		 vec_len (fib[i]->bsearch_prefix_lengths) :
+		 vec_len (table->prefix_lengths_in_search_order)) - 1;
+    }
+
+    while (1)
+    {
+	n = 0;
+	for (i = 0; i < 4; i++)
+	{
+	    if (lo[i] > hi[i])
+		continue;
+
+	    key = (u64)(fib_index[i]) << 32;
+	    if (bsearch[i])
+	    {
+		mid[i] = (lo[i] + hi[i]) >> 1;
+		len = fib[i]->bsearch_prefix_lengths[mid[i]];
+		key |= IP6_FIB_BSEARCH_KEY_FLAG;
+	    }
+	    else
+	    {
+		mid[i] = lo[i];
+		len = table->prefix_lengths_in_search_order[mid[i]];
+	    }
+	    mask = &ip6_main.fib_masks[len];
+
+	    kv[n].key[0] = dst[i]->as_u64[0] & mask->as_u64[0];
+	    kv[n].key[1] = dst[i]->as_u64[1] & mask->as_u64[1];
+	    kv[n].key[2] = key | len;
+	    lane[n++] = i;
+	}
+
+	if (0 == n)
+	    break;
+
+	clib_bihash_search_batch_24_8 (&table->ip6_hash, kv, n, kv, found);
+
+	for (j = 0; j < n; j++)
+	{
+	    i = lane[j];
+
+	    if (bsearch[i])
+	    {
+		if (found[j])
+		{
+		    lbi[i] = kv[j].value;
+		    lo[i] = mid[i] + 1;
+		}
+		else
+		    hi[i] = mid[i] - 1;
+	    }
+	    else
+	    {
+		if (found[j])
+		{
+		    lbi[i] = kv[j].value;
+		    lo[i] = hi[i] + 1;
+		}
+		else
+		    lo[i]++;
+	    }
+	}
+    }
+}
+
 /**
  * @brief Walk all entries in a sub-tree of the FIB table
  * N.B: This is NOT safe to deletes. If you need to delete walk the whole
@@ -162,12 +325,12 @@ extern u32 ip6_fib_table_create_and_lock(fib_source_t src,
 
 extern u8 *format_ip6_fib_table_memory(u8 * s, va_list * args);
 
-static inline ip6_fib_t *
-ip6_fib_get (fib_node_index_t index)
-{
-    ASSERT(!pool_is_free_index(ip6_main.fibs, index));
-    return (pool_elt_at_index (ip6_main.v6_fibs, index));
-}
+/**
+ * @brief Select the forwarding lookup algorithm of a FIB
+ */
+extern void ip6_fib_table_set_lookup_algo(u32 fib_index,
+                                          ip6_fib_lookup_algo_t algo);
+extern u8 *format_ip6_fib_lookup_algo(u8 * s, va_list * args);
 
 static inline 
 u32 ip6_fib_index_from_table_id (u32 table_id)
@@ -323,7 +323,7 @@ tso_segment_buffer (vlib_main_t * vm, vnet_interface_per_thread_data_t * ptd,
   int is_ip4 = sb0->flags & VNET_BUFFER_F_IS_IP4;
   int is_ip6 = sb0->flags & VNET_BUFFER_F_IS_IP6;
   ASSERT (is_ip4 || is_ip6);
-  ASSERT (sb0->flags & VNET_BUFFER_F_L2_HDR_OFFSET_VALID);
+  /* l2 offset is not needed, locally originated packets don't have it */
   ASSERT (sb0->flags & VNET_BUFFER_F_L3_HDR_OFFSET_VALID);
   ASSERT (sb0->flags & VNET_BUFFER_F_L4_HDR_OFFSET_VALID);
   u16 gso_size = vnet_buffer2 (sb0)->gso_size;
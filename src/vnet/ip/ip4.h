@@ -169,6 +169,9 @@ typedef struct ip4_main_t
   /** The memory heap for the mtries */
   void *mtrie_mheap;
 
+  /** Use compressed plies in the mtries */
+  u8 mtrie_compressed;
+
   /** ARP throttling */
   throttle_t arp_throttle;
 
@@ -3028,6 +3028,8 @@ ip4_config (vlib_main_t * vm, unformat_input_t * input)
     {
       if (unformat (input, "heap-size %U", unformat_memory_size, &heapsize))
 	;
+      else if (unformat (input, "mtrie-compressed"))
+	im->mtrie_compressed = 1;
       else
 	return clib_error_return (0,
 				  "invalid heap-size parameter `%U'",
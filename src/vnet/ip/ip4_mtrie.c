@@ -40,6 +40,7 @@
 #include <vnet/ip/ip.h>
 #include <vnet/ip/ip4_mtrie.h>
 #include <vnet/fib/ip4_fib.h>
+#include <vppinfra/random.h>
 
 
 /**
@@ -47,6 +48,11 @@
  */
 ip4_fib_mtrie_8_ply_t *ip4_ply_pool;
 
+/**
+ * Global pool of IPv4 compressed 8bit PLYs
+ */
+ip4_fib_mtrie_c8_ply_t *ip4_c_ply_pool;
+
 always_inline u32
 ip4_fib_mtrie_leaf_is_non_empty (ip4_fib_mtrie_8_ply_t * p, u8 dst_byte)
 {
@@ -79,14 +85,23 @@ always_inline u32
 ip4_fib_mtrie_leaf_get_next_ply_index (ip4_fib_mtrie_leaf_t n)
 {
   ASSERT (ip4_fib_mtrie_leaf_is_next_ply (n));
-  return n >> 1;
+  return n >> 2;
 }
 
 always_inline ip4_fib_mtrie_leaf_t
 ip4_fib_mtrie_leaf_set_next_ply_index (u32 i)
 {
   ip4_fib_mtrie_leaf_t l;
-  l = 0 + 2 * i;
+  l = 0 + 4 * i;
+  ASSERT (ip4_fib_mtrie_leaf_get_next_ply_index (l) == i);
+  return l;
+}
+
+always_inline ip4_fib_mtrie_leaf_t
+ip4_fib_mtrie_leaf_set_compressed_ply_index (u32 i)
+{
+  ip4_fib_mtrie_leaf_t l;
+  l = 2 + 4 * i;
   ASSERT (ip4_fib_mtrie_leaf_get_next_ply_index (l) == i);
   return l;
 }
@@ -180,7 +195,7 @@ ply_create (ip4_fib_mtrie_t * m,
   /* Get cache aligned ply. */
 
   old_heap = clib_mem_set_heap (ip4_main.mtrie_mheap);
-  pool_get_aligned (ip4_ply_pool, p, CLIB_CACHE_LINE_BYTES);
+  vlib_rcu_pool_get_aligned (ip4_ply_pool, p, CLIB_CACHE_LINE_BYTES);
   clib_mem_set_heap (old_heap);
 
   ply_8_init (p, init_leaf, leaf_prefix_len, ply_base_len);
@@ -215,6 +230,7 @@ void
 ip4_mtrie_init (ip4_fib_mtrie_t * m)
 {
   ply_16_init (&m->root_ply, IP4_FIB_MTRIE_LEAF_EMPTY, 0);
+  m->flags = (ip4_main.mtrie_compressed ? IP4_FIB_MTRIE_FLAG_COMPRESSED : 0);
 }
 
 typedef struct
@@ -394,6 +410,332 @@ set_leaf (ip4_fib_mtrie_t * m,
     }
 }
 
+/*
+ * Compressed plies are updated copy-on-write: the ply is expanded into a
+ * full ply on the stack, updated with the same rules as the full plies
+ * above, and compressed into a new ply that replaces the old one in its
+ * parent's slot. The parent is in turn replaced, up to the root ply which
+ * is updated in place.
+ */
+
+static void
+c_ply_free (u32 ply_index)
+{
+  ip4_fib_mtrie_c8_ply_t *p;
+  void *old_heap;
+
+  old_heap = clib_mem_set_heap (ip4_main.mtrie_mheap);
+  p = pool_elt_at_index (ip4_c_ply_pool, ply_index);
+  clib_mem_free (p->leaves);
+  pool_put (ip4_c_ply_pool, p);
+  clib_mem_set_heap (old_heap);
+}
+
+static void
+c_ply_free_cb (void *data)
+{
+  c_ply_free (pointer_to_uword (data));
+}
+
+/**
+ * The replaced ply is freed once every worker has passed a quiescent
+ * state, so no lookup that started before the replacement still uses it
+ */
+static void
+c_ply_retire (ip4_fib_mtrie_leaf_t l)
+{
+  vlib_rcu_call (c_ply_free_cb,
+		 uword_to_pointer (ip4_fib_mtrie_leaf_get_next_ply_index (l),
+				   void *));
+}
+
+static void
+c_ply_expand (ip4_fib_mtrie_leaf_t l, ip4_fib_mtrie_8_ply_t * t)
+{
+  ip4_fib_mtrie_c8_ply_t *p;
+  int i, run;
+
+  p = pool_elt_at_index (ip4_c_ply_pool,
+			 ip4_fib_mtrie_leaf_get_next_ply_index (l));
+
+  for (i = 0, run = -1; i < ARRAY_LEN (t->leaves); i++)
+    {
+      run += (p->bitmap[i / 64] >> (i % 64)) & 1;
+      t->leaves[i] = p->leaves[run];
+      t->dst_address_bits_of_leaves[i] = p->dst_address_bits_of_leaves[run];
+    }
+  t->dst_address_bits_base = p->dst_address_bits_base;
+}
+
+static u32
+c_ply_n_non_empty_leafs (ip4_fib_mtrie_8_ply_t * t)
+{
+  u32 i, n = 0;
+
+  for (i = 0; i < ARRAY_LEN (t->leaves); i++)
+    n += ip4_fib_mtrie_leaf_is_non_empty (t, i);
+
+  return n;
+}
+
+/**
+ * Compress the ply and return the leaf for it. old_leaf is the ply it
+ * replaces, or ~0 for a new ply. The old ply is kept if nothing changed.
+ */
+static ip4_fib_mtrie_leaf_t
+c_ply_replace (ip4_fib_mtrie_leaf_t old_leaf, ip4_fib_mtrie_8_ply_t * t)
+{
+  ip4_fib_mtrie_leaf_t leaves[ARRAY_LEN (t->leaves)];
+  u8 bits[ARRAY_LEN (t->leaves)];
+  ip4_fib_mtrie_c8_ply_t *p;
+  u64 bitmap[4] = { 0 };
+  void *old_heap;
+  u32 i, n;
+
+  for (i = 0, n = 0; i < ARRAY_LEN (t->leaves); i++)
+    {
+      if (0 == i || t->leaves[i] != leaves[n - 1] ||
+	  t->dst_address_bits_of_leaves[i] != bits[n - 1])
+	{
+	  bitmap[i / 64] |= 1ULL << (i % 64);
+	  leaves[n] = t->leaves[i];
+	  bits[n] = t->dst_address_bits_of_leaves[i];
+	  n++;
+	}
+    }
+
+  if (~0 != old_leaf)
+    {
+      p = pool_elt_at_index (ip4_c_ply_pool,
+			     ip4_fib_mtrie_leaf_get_next_ply_index
+			     (old_leaf));
+      if (p->n_leaves == n &&
+	  0 == memcmp (p->bitmap, bitmap, sizeof (bitmap)) &&
+	  0 == memcmp (p->leaves, leaves, n * sizeof (leaves[0])) &&
+	  0 == memcmp (p->dst_address_bits_of_leaves, bits, n))
+	return (old_leaf);
+    }
+
+  old_heap = clib_mem_set_heap (ip4_main.mtrie_mheap);
+  /* the workers may be reading the pool, if it grows the old one is
+     freed once they are done with it */
+  vlib_rcu_pool_get_aligned (ip4_c_ply_pool, p, CLIB_CACHE_LINE_BYTES);
+  p->leaves = clib_mem_alloc (n * (sizeof (leaves[0]) + sizeof (bits[0])));
+  clib_mem_set_heap (old_heap);
+
+  p->dst_address_bits_of_leaves = (u8 *) (p->leaves + n);
+  clib_memcpy_fast (p->leaves, leaves, n * sizeof (leaves[0]));
+  clib_memcpy_fast (p->dst_address_bits_of_leaves, bits, n);
+  clib_memcpy_fast (p->bitmap, bitmap, sizeof (bitmap));
+  p->base[0] = 0;
+  for (i = 1; i < ARRAY_LEN (p->base); i++)
+    p->base[i] = p->base[i - 1] + count_set_bits (bitmap[i - 1]);
+  p->n_leaves = n;
+  p->dst_address_bits_base = t->dst_address_bits_base;
+
+  if (~0 != old_leaf)
+    c_ply_retire (old_leaf);
+
+  return (ip4_fib_mtrie_leaf_set_compressed_ply_index (p - ip4_c_ply_pool));
+}
+
+static ip4_fib_mtrie_leaf_t
+c_set_ply_with_more_specific_leaf (ip4_fib_mtrie_leaf_t ply_leaf,
+				   ip4_fib_mtrie_leaf_t new_leaf,
+				   uword new_leaf_dst_address_bits)
+{
+  ip4_fib_mtrie_8_ply_t t;
+  ip4_fib_mtrie_leaf_t old_leaf;
+  uword i;
+
+  ASSERT (ip4_fib_mtrie_leaf_is_terminal (new_leaf));
+
+  c_ply_expand (ply_leaf, &t);
+
+  for (i = 0; i < ARRAY_LEN (t.leaves); i++)
+    {
+      old_leaf = t.leaves[i];
+
+      /* Recurse into sub plies. */
+      if (!ip4_fib_mtrie_leaf_is_terminal (old_leaf))
+	t.leaves[i] = c_set_ply_with_more_specific_leaf
+	  (old_leaf, new_leaf, new_leaf_dst_address_bits);
+
+      /* Replace less specific terminal leaves with new leaf. */
+      else if (new_leaf_dst_address_bits >= t.dst_address_bits_of_leaves[i])
+	{
+	  t.leaves[i] = new_leaf;
+	  t.dst_address_bits_of_leaves[i] = new_leaf_dst_address_bits;
+	}
+    }
+
+  return (c_ply_replace (ply_leaf, &t));
+}
+
+static ip4_fib_mtrie_leaf_t c_set_leaf (const
+					ip4_fib_mtrie_set_unset_leaf_args_t *
+					a, ip4_fib_mtrie_leaf_t ply_leaf,
+					u32 dst_address_byte_index);
+
+/**
+ * Set the leaf in an expanded ply
+ */
+static void
+c_set_leaf_in_ply (const ip4_fib_mtrie_set_unset_leaf_args_t * a,
+		   ip4_fib_mtrie_8_ply_t * t, u32 dst_address_byte_index)
+{
+  ip4_fib_mtrie_leaf_t old_leaf, new_leaf;
+  i32 n_dst_bits_next_plies;
+  u8 dst_byte;
+
+  ASSERT (a->dst_address_length <= 32);
+  ASSERT (dst_address_byte_index < ARRAY_LEN (a->dst_address.as_u8));
+
+  /* how many bits of the destination address are in the next PLY */
+  n_dst_bits_next_plies =
+    a->dst_address_length - BITS (u8) * (dst_address_byte_index + 1);
+
+  dst_byte = a->dst_address.as_u8[dst_address_byte_index];
+
+  /* Number of bits next plies <= 0 => insert leaves this ply. */
+  if (n_dst_bits_next_plies <= 0)
+    {
+      u32 i, n_dst_bits_this_ply;
+
+      /* The number of bits, and hence slots/buckets, we will fill */
+      n_dst_bits_this_ply = clib_min (8, -n_dst_bits_next_plies);
+
+      for (i = dst_byte; i < dst_byte + (1 << n_dst_bits_this_ply); i++)
+	{
+	  old_leaf = t->leaves[i];
+
+	  if (a->dst_address_length >= t->dst_address_bits_of_leaves[i])
+	    {
+	      /* The new leaf is more or equally specific than the one
+	       * currently occupying the slot */
+	      new_leaf = ip4_fib_mtrie_leaf_set_adj_index (a->adj_index);
+
+	      if (ip4_fib_mtrie_leaf_is_terminal (old_leaf))
+		{
+		  t->dst_address_bits_of_leaves[i] = a->dst_address_length;
+		  t->leaves[i] = new_leaf;
+		}
+	      else
+		t->leaves[i] = c_set_ply_with_more_specific_leaf
+		  (old_leaf, new_leaf, a->dst_address_length);
+	    }
+	  else if (!ip4_fib_mtrie_leaf_is_terminal (old_leaf))
+	    {
+	      /* The current leaf is less specific and not termial (i.e. a
+	       * ply), recurse on down the trie */
+	      t->leaves[i] = c_set_leaf (a, old_leaf,
+					 dst_address_byte_index + 1);
+	    }
+	}
+    }
+  else
+    {
+      /* The address to insert requires us to move down at a lower level of
+       * the trie - recurse on down */
+      ip4_fib_mtrie_8_ply_t new_ply;
+      u8 ply_base_len;
+
+      ply_base_len = 8 * (dst_address_byte_index + 1);
+
+      old_leaf = t->leaves[dst_byte];
+
+      if (ip4_fib_mtrie_leaf_is_terminal (old_leaf))
+	{
+	  /* There is a leaf occupying the slot. Replace it with a new ply */
+	  ply_8_init (&new_ply, old_leaf,
+		      t->dst_address_bits_of_leaves[dst_byte], ply_base_len);
+	  c_set_leaf_in_ply (a, &new_ply, dst_address_byte_index + 1);
+
+	  t->leaves[dst_byte] = c_ply_replace (~0, &new_ply);
+	  t->dst_address_bits_of_leaves[dst_byte] = ply_base_len;
+	}
+      else
+	t->leaves[dst_byte] = c_set_leaf (a, old_leaf,
+					  dst_address_byte_index + 1);
+    }
+}
+
+static ip4_fib_mtrie_leaf_t
+c_set_leaf (const ip4_fib_mtrie_set_unset_leaf_args_t * a,
+	    ip4_fib_mtrie_leaf_t ply_leaf, u32 dst_address_byte_index)
+{
+  ip4_fib_mtrie_8_ply_t t;
+
+  c_ply_expand (ply_leaf, &t);
+  c_set_leaf_in_ply (a, &t, dst_address_byte_index);
+
+  return (c_ply_replace (ply_leaf, &t));
+}
+
+/**
+ * Unset the leaf in a compressed ply
+ * @return 1 if the ply is now empty and was removed, else 0 with the leaf
+ * of its replacement in new_ply_leaf
+ */
+static uword
+c_unset_leaf (const ip4_fib_mtrie_set_unset_leaf_args_t * a,
+	      ip4_fib_mtrie_leaf_t ply_leaf,
+	      u32 dst_address_byte_index, ip4_fib_mtrie_leaf_t * new_ply_leaf)
+{
+  ip4_fib_mtrie_leaf_t old_leaf, del_leaf, sub_ply_leaf;
+  i32 n_dst_bits_next_plies;
+  i32 i, n_dst_bits_this_ply;
+  ip4_fib_mtrie_8_ply_t t;
+  u8 dst_byte;
+
+  ASSERT (a->dst_address_length <= 32);
+  ASSERT (dst_address_byte_index < ARRAY_LEN (a->dst_address.as_u8));
+
+  c_ply_expand (ply_leaf, &t);
+
+  n_dst_bits_next_plies =
+    a->dst_address_length - BITS (u8) * (dst_address_byte_index + 1);
+
+  dst_byte = a->dst_address.as_u8[dst_address_byte_index];
+  if (n_dst_bits_next_plies < 0)
+    dst_byte &= ~pow2_mask (-n_dst_bits_next_plies);
+
+  n_dst_bits_this_ply =
+    n_dst_bits_next_plies <= 0 ? -n_dst_bits_next_plies : 0;
+  n_dst_bits_this_ply = clib_min (8, n_dst_bits_this_ply);
+
+  del_leaf = ip4_fib_mtrie_leaf_set_adj_index (a->adj_index);
+
+  for (i = dst_byte; i < dst_byte + (1 << n_dst_bits_this_ply); i++)
+    {
+      old_leaf = t.leaves[i];
+
+      if (old_leaf == del_leaf
+	  || (!ip4_fib_mtrie_leaf_is_terminal (old_leaf)
+	      && c_unset_leaf (a, old_leaf, dst_address_byte_index + 1,
+			       &sub_ply_leaf)))
+	{
+	  t.leaves[i] =
+	    ip4_fib_mtrie_leaf_set_adj_index (a->cover_adj_index);
+	  t.dst_address_bits_of_leaves[i] = a->cover_address_length;
+	}
+      else if (!ip4_fib_mtrie_leaf_is_terminal (old_leaf))
+	t.leaves[i] = sub_ply_leaf;
+    }
+
+  if (0 == c_ply_n_non_empty_leafs (&t))
+    {
+      c_ply_retire (ply_leaf);
+      /* Old ply was deleted. */
+      return 1;
+    }
+
+  *new_ply_leaf = c_ply_replace (ply_leaf, &t);
+
+  /* Old ply was not deleted. */
+  return 0;
+}
+
 static void
 set_root_leaf (ip4_fib_mtrie_t * m,
 	       const ip4_fib_mtrie_set_unset_leaf_args_t * a)
@@ -455,6 +797,12 @@ set_root_leaf (ip4_fib_mtrie_t * m,
 					    old_leaf, new_leaf);
 		  ASSERT (old_ply->leaves[slot] == new_leaf);
 		}
+	      else if (ip4_fib_mtrie_leaf_is_compressed_ply (old_leaf))
+		{
+		  new_leaf = c_set_ply_with_more_specific_leaf
+		    (old_leaf, new_leaf, a->dst_address_length);
+		  clib_atomic_store_rel_n (&old_ply->leaves[slot], new_leaf);
+		}
 	      else
 		{
 		  /* Existing leaf points to another ply.  We need to place
@@ -464,6 +812,11 @@ set_root_leaf (ip4_fib_mtrie_t * m,
 						   a->dst_address_length);
 		}
 	    }
+	  else if (ip4_fib_mtrie_leaf_is_compressed_ply (old_leaf))
+	    {
+	      new_leaf = c_set_leaf (a, old_leaf, 2);
+	      clib_atomic_store_rel_n (&old_ply->leaves[slot], new_leaf);
+	    }
 	  else if (!old_leaf_is_terminal)
 	    {
 	      /* The current leaf is less specific and not termial (i.e. a ply),
@@ -489,6 +842,27 @@ set_root_leaf (ip4_fib_mtrie_t * m,
 
       old_leaf = old_ply->leaves[dst_byte];
 
+      if (m->flags & IP4_FIB_MTRIE_FLAG_COMPRESSED)
+	{
+	  ip4_fib_mtrie_8_ply_t t;
+
+	  if (ip4_fib_mtrie_leaf_is_terminal (old_leaf))
+	    {
+	      /* Build the new ply aside and publish it compressed */
+	      ply_8_init (&t, old_leaf,
+			  old_ply->dst_address_bits_of_leaves[dst_byte],
+			  ply_base_len);
+	      c_set_leaf_in_ply (a, &t, 2);
+	      new_leaf = c_ply_replace (~0, &t);
+	      old_ply->dst_address_bits_of_leaves[dst_byte] = ply_base_len;
+	    }
+	  else
+	    new_leaf = c_set_leaf (a, old_leaf, 2);
+
+	  clib_atomic_store_rel_n (&old_ply->leaves[dst_byte], new_leaf);
+	  return;
+	}
+
       if (ip4_fib_mtrie_leaf_is_terminal (old_leaf))
 	{
 	  /* There is a leaf occupying the slot. Replace it with a new ply */
@@ -616,6 +990,19 @@ unset_root_leaf (ip4_fib_mtrie_t * m,
       old_leaf = old_ply->leaves[slot];
       old_leaf_is_terminal = ip4_fib_mtrie_leaf_is_terminal (old_leaf);
 
+      if (ip4_fib_mtrie_leaf_is_compressed_ply (old_leaf))
+	{
+	  ip4_fib_mtrie_leaf_t new_leaf;
+
+	  if (!c_unset_leaf (a, old_leaf, 2, &new_leaf))
+	    {
+	      clib_atomic_store_rel_n (&old_ply->leaves[slot], new_leaf);
+	      continue;
+	    }
+	  /* the compressed ply was removed, fall through to the cover */
+	  old_leaf = del_leaf;
+	}
+
       if (old_leaf == del_leaf
 	  || (!old_leaf_is_terminal
 	      && unset_leaf (m, a, get_next_ply_for_leaf (m, old_leaf), 2)))
@@ -666,6 +1053,9 @@ ip4_fib_mtrie_route_del (ip4_fib_mtrie_t * m,
   unset_root_leaf (m, &a);
 }
 
+static uword mtrie_leaf_memory_usage (ip4_fib_mtrie_t * m,
+				      ip4_fib_mtrie_leaf_t l);
+
 /* Returns number of bytes of memory used by mtrie. */
 static uword
 mtrie_ply_memory_usage (ip4_fib_mtrie_t * m, ip4_fib_mtrie_8_ply_t * p)
@@ -674,15 +1064,38 @@ mtrie_ply_memory_usage (ip4_fib_mtrie_t * m, ip4_fib_mtrie_8_ply_t * p)
 
   bytes = sizeof (p[0]);
   for (i = 0; i < ARRAY_LEN (p->leaves); i++)
-    {
-      ip4_fib_mtrie_leaf_t l = p->leaves[i];
-      if (ip4_fib_mtrie_leaf_is_next_ply (l))
-	bytes += mtrie_ply_memory_usage (m, get_next_ply_for_leaf (m, l));
-    }
+    bytes += mtrie_leaf_memory_usage (m, p->leaves[i]);
 
   return bytes;
 }
 
+static uword
+mtrie_c_ply_memory_usage (ip4_fib_mtrie_t * m, ip4_fib_mtrie_c8_ply_t * p)
+{
+  uword bytes, i;
+
+  bytes = sizeof (p[0]);
+  bytes += p->n_leaves * (sizeof (p->leaves[0]) +
+			  sizeof (p->dst_address_bits_of_leaves[0]));
+  for (i = 0; i < p->n_leaves; i++)
+    bytes += mtrie_leaf_memory_usage (m, p->leaves[i]);
+
+  return bytes;
+}
+
+static uword
+mtrie_leaf_memory_usage (ip4_fib_mtrie_t * m, ip4_fib_mtrie_leaf_t l)
+{
+  if (!ip4_fib_mtrie_leaf_is_next_ply (l))
+    return (0);
+  if (ip4_fib_mtrie_leaf_is_compressed_ply (l))
+    return (mtrie_c_ply_memory_usage
+	    (m, pool_elt_at_index (ip4_c_ply_pool,
+				   ip4_fib_mtrie_leaf_get_next_ply_index
+				   (l))));
+  return (mtrie_ply_memory_usage (m, get_next_ply_for_leaf (m, l)));
+}
+
 /* Returns number of bytes of memory used by mtrie. */
 uword
 ip4_fib_mtrie_memory_usage (ip4_fib_mtrie_t * m)
@@ -691,15 +1104,45 @@ ip4_fib_mtrie_memory_usage (ip4_fib_mtrie_t * m)
 
   bytes = sizeof (*m);
   for (i = 0; i < ARRAY_LEN (m->root_ply.leaves); i++)
-    {
-      ip4_fib_mtrie_leaf_t l = m->root_ply.leaves[i];
-      if (ip4_fib_mtrie_leaf_is_next_ply (l))
-	bytes += mtrie_ply_memory_usage (m, get_next_ply_for_leaf (m, l));
-    }
+    bytes += mtrie_leaf_memory_usage (m, m->root_ply.leaves[i]);
 
   return bytes;
 }
 
+f64
+ip4_fib_mtrie_lookup_rate (ip4_fib_mtrie_t * m, u32 n_lookups)
+{
+  ip4_fib_mtrie_leaf_t leaf, sum = 0;
+  ip4_address_t *dsts = 0, *dst;
+  u64 t0, t1;
+  u32 seed;
+
+  if (0 == n_lookups)
+    return (0);
+
+  seed = clib_cpu_time_now ();
+  vec_validate (dsts, n_lookups - 1);
+  vec_foreach (dst, dsts) dst->as_u32 = random_u32 (&seed);
+
+  t0 = clib_cpu_time_now ();
+  vec_foreach (dst, dsts)
+  {
+    leaf = ip4_fib_mtrie_lookup_step_one (m, dst);
+    leaf = ip4_fib_mtrie_lookup_step (m, leaf, dst, 2);
+    leaf = ip4_fib_mtrie_lookup_step (m, leaf, dst, 3);
+    sum += leaf;
+  }
+  t1 = clib_cpu_time_now ();
+
+  vec_free (dsts);
+
+  /* keep the compiler from dropping the lookups */
+  if (PREDICT_FALSE (sum == ~0))
+    t1++;
+
+  return (n_lookups * os_cpu_clock_frequency () / (f64) (t1 - t0 + 1));
+}
+
 static u8 *
 format_ip4_fib_mtrie_leaf (u8 * s, va_list * va)
 {
@@ -707,6 +1150,9 @@ format_ip4_fib_mtrie_leaf (u8 * s, va_list * va)
 
   if (ip4_fib_mtrie_leaf_is_terminal (l))
     s = format (s, "lb-index %d", ip4_fib_mtrie_leaf_get_adj_index (l));
+  else if (ip4_fib_mtrie_leaf_is_compressed_ply (l))
+    s = format (s, "next compressed ply %d",
+		ip4_fib_mtrie_leaf_get_next_ply_index (l));
   else
     s = format (s, "next ply %d", ip4_fib_mtrie_leaf_get_next_ply_index (l));
   return s;
@@ -728,8 +1174,7 @@ format_ip4_fib_mtrie_leaf (u8 * s, va_list * va)
                                                                         \
   if (ip4_fib_mtrie_leaf_is_next_ply (_l))                              \
     s = format (s, "\n%U",                                              \
-                format_ip4_fib_mtrie_ply, m, a, (_indent) + 8,          \
-                ip4_fib_mtrie_leaf_get_next_ply_index (_l));            \
+                format_ip4_fib_mtrie_ply, m, a, (_indent) + 8, _l);     \
   s;                                                                    \
 })
 
@@ -739,13 +1184,29 @@ format_ip4_fib_mtrie_ply (u8 * s, va_list * va)
   ip4_fib_mtrie_t *m = va_arg (*va, ip4_fib_mtrie_t *);
   u32 base_address = va_arg (*va, u32);
   u32 indent = va_arg (*va, u32);
-  u32 ply_index = va_arg (*va, u32);
-  ip4_fib_mtrie_8_ply_t *p;
+  ip4_fib_mtrie_leaf_t l = va_arg (*va, ip4_fib_mtrie_leaf_t);
+  ip4_fib_mtrie_8_ply_t *p, t;
+  u32 ply_index;
   int i;
 
-  p = pool_elt_at_index (ip4_ply_pool, ply_index);
-  s = format (s, "%Uply index %d, %d non-empty leaves",
-	      format_white_space, indent, ply_index, p->n_non_empty_leafs);
+  ply_index = ip4_fib_mtrie_leaf_get_next_ply_index (l);
+
+  if (ip4_fib_mtrie_leaf_is_compressed_ply (l))
+    {
+      c_ply_expand (l, &t);
+      p = &t;
+      s = format (s, "%Ucompressed ply index %d, %d runs, %d non-empty leaves",
+		  format_white_space, indent, ply_index,
+		  pool_elt_at_index (ip4_c_ply_pool, ply_index)->n_leaves,
+		  c_ply_n_non_empty_leafs (p));
+    }
+  else
+    {
+      p = pool_elt_at_index (ip4_ply_pool, ply_index);
+      s = format (s, "%Uply index %d, %d non-empty leaves",
+		  format_white_space, indent, ply_index,
+		  p->n_non_empty_leafs);
+    }
 
   for (i = 0; i < ARRAY_LEN (p->leaves); i++)
     {
@@ -768,8 +1229,8 @@ format_ip4_fib_mtrie (u8 * s, va_list * va)
   u32 base_address = 0;
   int i;
 
-  s = format (s, "%d plies, memory usage %U\n",
-	      pool_elts (ip4_ply_pool),
+  s = format (s, "%d plies, %d compressed plies, memory usage %U\n",
+	      pool_elts (ip4_ply_pool), pool_elts (ip4_c_ply_pool),
 	      format_memory_size, ip4_fib_mtrie_memory_usage (m));
   s = format (s, "root-ply");
   p = &m->root_ply;
@@ -802,6 +1263,7 @@ static clib_error_t *
 ip4_mtrie_module_init (vlib_main_t * vm)
 {
   CLIB_UNUSED (ip4_fib_mtrie_8_ply_t * p);
+  CLIB_UNUSED (ip4_fib_mtrie_c8_ply_t * c);
   ip4_main_t *im = &ip4_main;
   clib_error_t *error = NULL;
   uword *old_heap;
@@ -817,6 +1279,7 @@ ip4_mtrie_module_init (vlib_main_t * vm)
   /* Burn one ply so index 0 is taken */
   old_heap = clib_mem_set_heap (ip4_main.mtrie_mheap);
   pool_get (ip4_ply_pool, p);
+  pool_get (ip4_c_ply_pool, c);
   clib_mem_set_heap (old_heap);
 
   return (error);
@@ -42,12 +42,14 @@
 
 #include <vppinfra/cache.h>
 #include <vppinfra/vector.h>
+#include <vppinfra/bitops.h>
 #include <vnet/ip/lookup.h>
 #include <vnet/ip/ip4_packet.h>	/* for ip4_address_t */
 
-/* ip4 fib leafs: 4 ply 8-8-8-8 mtrie.
+/* ip4 fib leafs: 3 ply 16-8-8 mtrie.
    1 + 2*adj_index for terminal leaves.
-   0 + 2*next_ply_index for non-terminals, i.e. PLYs
+   0 + 4*next_ply_index for non-terminals, i.e. PLYs
+   2 + 4*next_ply_index for non-terminals that are compressed PLYs
    1 => empty (adjacency index of zero is special miss adjacency). */
 typedef u32 ip4_fib_mtrie_leaf_t;
 
@@ -122,6 +124,60 @@ ip4_fib_mtrie_8_ply_t;
 STATIC_ASSERT (0 == sizeof (ip4_fib_mtrie_8_ply_t) % CLIB_CACHE_LINE_BYTES,
 	       "IP4 Mtrie ply cache line");
 
+/**
+ * @brief A compressed 8 bit stride ply.
+ * Runs of consecutive slots with the same leaf share one entry in the
+ * leaves vector. A bitmap marks the slots that start a run, so the entry
+ * for a slot is found by counting the set bits up to and including it.
+ * Compressed plies are never modified; an update builds a new ply and
+ * swaps it into the parent's slot.
+ */
+typedef struct ip4_fib_mtrie_c8_ply_t_
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+
+  /**
+   * Bit per slot, set where a run starts
+   */
+  u64 bitmap[4];
+
+  /**
+   * The leaf of each run
+   */
+  ip4_fib_mtrie_leaf_t *leaves;
+
+  /**
+   * Number of runs that start in the preceding words of the bitmap
+   */
+  u8 base[4];
+
+  /**
+   * Number of runs
+   */
+  u16 n_leaves;
+
+  /**
+   * The length of the ply's covering prefix.
+   */
+  u8 dst_address_bits_base;
+
+  /**
+   * Prefix length for each run's leaf. Shares the allocation of the leaves.
+   */
+  u8 *dst_address_bits_of_leaves;
+} ip4_fib_mtrie_c8_ply_t;
+
+STATIC_ASSERT (0 == sizeof (ip4_fib_mtrie_c8_ply_t) % CLIB_CACHE_LINE_BYTES,
+	       "IP4 Mtrie compressed ply cache line");
+
+typedef enum ip4_fib_mtrie_flags_t_
+{
+  /**
+   * Use compressed plies below the root
+   */
+  IP4_FIB_MTRIE_FLAG_COMPRESSED = (1 << 0),
+} ip4_fib_mtrie_flags_t;
+
 /**
  * @brief The mutiway-TRIE.
  * There is no data associated with the mtrie apart from the top PLY
@@ -134,10 +190,17 @@ typedef struct
    * to it. therefore no cachline misses in the data-path.
    */
   ip4_fib_mtrie_16_ply_t root_ply;
+
+  /**
+   * ip4_fib_mtrie_flags_t, fixed when the mtrie is initialised
+   */
+  u32 flags;
 } ip4_fib_mtrie_t;
 
 /**
  * @brief Initialise an mtrie
+ * The layout of the plies, compressed or not, is chosen by the
+ * 'ip { mtrie-compressed }' startup config.
  */
 void ip4_mtrie_init (ip4_fib_mtrie_t * m);
 
@@ -166,6 +229,12 @@ void ip4_fib_mtrie_route_del (ip4_fib_mtrie_t * m,
  */
 uword ip4_fib_mtrie_memory_usage (ip4_fib_mtrie_t * m);
 
+/**
+ * @brief Measure the lookup rate of the table, in lookups per second,
+ * for n_lookups random destinations
+ */
+f64 ip4_fib_mtrie_lookup_rate (ip4_fib_mtrie_t * m, u32 n_lookups);
+
 /**
  * @brief Format/display the contents of the mtrie
  */
@@ -176,6 +245,11 @@ format_function_t format_ip4_fib_mtrie;
  */
 extern ip4_fib_mtrie_8_ply_t *ip4_ply_pool;
 
+/**
+ * @brief A global pool of compressed 8bit stride plys
+ */
+extern ip4_fib_mtrie_c8_ply_t *ip4_c_ply_pool;
+
 /**
  * Is the leaf terminal (i.e. an LB index) or non-terminak (i.e. a PLY index)
  */
@@ -195,6 +269,28 @@ ip4_fib_mtrie_leaf_get_adj_index (ip4_fib_mtrie_leaf_t n)
   return n >> 1;
 }
 
+/**
+ * Is the non-terminal leaf a compressed PLY
+ */
+always_inline u32
+ip4_fib_mtrie_leaf_is_compressed_ply (ip4_fib_mtrie_leaf_t n)
+{
+  return (n & 3) == 2;
+}
+
+/**
+ * @brief The leaf in the slot of a compressed ply
+ */
+always_inline ip4_fib_mtrie_leaf_t
+ip4_fib_mtrie_c8_ply_get_leaf (const ip4_fib_mtrie_c8_ply_t * ply, u8 slot)
+{
+  u64 bits;
+
+  bits = ply->bitmap[slot / 64] & (~0ULL >> (63 - (slot % 64)));
+
+  return (ply->leaves[ply->base[slot / 64] + count_set_bits (bits) - 1]);
+}
+
 /**
  * @brief Lookup step.  Processes 1 byte of 4 byte ip4 address.
  */
@@ -210,7 +306,12 @@ ip4_fib_mtrie_lookup_step (const ip4_fib_mtrie_t * m,
 
   if (!current_is_terminal)
     {
-      ply = ip4_ply_pool + (current_leaf >> 1);
+      if (ip4_fib_mtrie_leaf_is_compressed_ply (current_leaf))
+	return (ip4_fib_mtrie_c8_ply_get_leaf
+		(ip4_c_ply_pool + (current_leaf >> 2),
+		 dst_address->as_u8[dst_address_byte_index]));
+
+      ply = ip4_ply_pool + (current_leaf >> 2);
       return (ply->leaves[dst_address->as_u8[dst_address_byte_index]]);
     }
 
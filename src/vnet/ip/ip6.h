@@ -76,6 +76,26 @@ typedef struct
 
   /* Index into FIB vector. */
   u32 index;
+
+  /* Forwarding lookup algorithm, see ip6_fib_lookup_algo_t */
+  u8 lookup_algo;
+
+  /* Set when the binary search entries match the forwarding entries.
+     Until then lookups probe every prefix length. */
+  volatile u8 bsearch_ready;
+
+  /* Set while the FIB is queued for a binary search rebuild */
+  u8 bsearch_pending;
+
+  /* Set while the forwarding hash holds binary search entries for the
+     FIB, which may refer to load-balances since freed once it changes */
+  u8 bsearch_populated;
+
+  /* Bumped each time the forwarding entries change */
+  u32 bsearch_version;
+
+  /* Distinct prefix lengths in the FIB, ascending */
+  u8 *bsearch_prefix_lengths;
 } ip6_fib_t;
 
 typedef struct ip6_mfib_t
@@ -136,6 +156,30 @@ typedef enum ip6_fib_table_instance_type_t_
 
 #define IP6_FIB_NUM_TABLES (IP6_FIB_TABLE_NON_FWDING+1)
 
+/**
+ * The algorithms available to find the longest matching prefix in the
+ * forwarding table
+ */
+typedef enum ip6_fib_lookup_algo_t_
+{
+    /**
+     * Probe the hash once per distinct prefix length, longest first.
+     */
+  IP6_FIB_LOOKUP_ALGO_HASH,
+    /**
+     * Binary search on the prefix lengths of the FIB. Extra marker entries,
+     * carrying the best matching prefix, steer the search towards longer
+     * prefixes, so the cost is log2 of the number of distinct lengths.
+     */
+  IP6_FIB_LOOKUP_ALGO_BSEARCH,
+} ip6_fib_lookup_algo_t;
+
+/**
+ * Set in the prefix length word of the key of the binary search entries,
+ * which share the forwarding hash with the per-prefix entries
+ */
+#define IP6_FIB_BSEARCH_KEY_FLAG (1 << 8)
+
 /**
  * A represenation of a single IP6 table
  */
@@ -224,6 +268,9 @@ typedef struct ip6_main_t
   u32 lookup_table_nbuckets;
   uword lookup_table_size;
 
+  /* Forwarding lookup algorithm for new FIBs */
+  ip6_fib_lookup_algo_t fib_lookup_algo;
+
   /* Seed for Jenkins hash used to compute ip6 flow hash. */
   u32 flow_hash_seed;
 
@@ -3116,6 +3116,10 @@ ip6_config (vlib_main_t * vm, unformat_input_t * input)
       else if (unformat (input, "heap-size %U",
 			 unformat_memory_size, &heapsize))
 	;
+      else if (unformat (input, "fib-lookup hash"))
+	im->fib_lookup_algo = IP6_FIB_LOOKUP_ALGO_HASH;
+      else if (unformat (input, "fib-lookup bsearch"))
+	im->fib_lookup_algo = IP6_FIB_LOOKUP_ALGO_BSEARCH;
       else
 	return clib_error_return (0, "unknown input '%U'",
 				  format_unformat_error, input);
@@ -42,6 +42,7 @@
 #include <vnet/fib/ip4_fib.h>
 #include <vnet/fib/ip6_fib.h>
 #include <vnet/fib/fib_path_list.h>
+#include <vnet/fib/fib_walk.h>
 #include <vnet/ip/ip6_hop_by_hop.h>
 #include <vnet/ip/ip4_reassembly.h>
 #include <vnet/ip/ip6_reassembly.h>
@@ -91,6 +92,7 @@ _(PROXY_ARP_INTFC_ENABLE_DISABLE, proxy_arp_intfc_enable_disable)       \
  _(PROXY_ARP_INTFC_DUMP, proxy_arp_intfc_dump)                          \
 _(RESET_FIB, reset_fib)							\
 _(IP_ROUTE_ADD_DEL, ip_route_add_del)                                   \
+_(IP_ROUTE_ADD_DEL_BULK, ip_route_add_del_bulk)                         \
 _(IP_TABLE_ADD_DEL, ip_table_add_del)                                   \
 _(IP_PUNT_POLICE, ip_punt_police)                                       \
 _(IP_PUNT_REDIRECT, ip_punt_redirect)                                   \
@@ -650,47 +652,70 @@ vl_api_ip_table_add_del_t_handler (vl_api_ip_table_add_del_t * mp)
 }
 
 static int
-ip_route_add_del_t_handler (vl_api_ip_route_add_del_t * mp, u32 * stats_index)
+ip_route_path_decode (vl_api_fib_path_t * apath,
+		      fib_route_path_t * rpath, fib_entry_flag_t * entry_flags)
+{
+  int rv;
+
+  rv = fib_api_path_decode (apath, rpath);
+
+  if ((rpath->frp_flags & FIB_ROUTE_PATH_LOCAL) &&
+      (~0 == rpath->frp_sw_if_index))
+    *entry_flags |= (FIB_ENTRY_FLAG_CONNECTED | FIB_ENTRY_FLAG_LOCAL);
+
+  return (rv);
+}
+
+static int
+ip_route_add_del_paths (u8 is_add, u8 is_multipath, u32 table_id,
+			vl_api_prefix_t * prefix, fib_entry_flag_t entry_flags,
+			fib_route_path_t * rpaths, u32 * stats_index)
 {
-  fib_route_path_t *rpaths = NULL, *rpath;
-  fib_entry_flag_t entry_flags;
-  vl_api_fib_path_t *apath;
   fib_prefix_t pfx;
   u32 fib_index;
-  int rv, ii;
+  int rv;
 
-  entry_flags = FIB_ENTRY_FLAG_NONE;
-  ip_prefix_decode (&mp->route.prefix, &pfx);
+  ip_prefix_decode (prefix, &pfx);
 
-  rv = fib_api_table_id_decode (pfx.fp_proto,
-				ntohl (mp->route.table_id), &fib_index);
+  rv = fib_api_table_id_decode (pfx.fp_proto, table_id, &fib_index);
   if (0 != rv)
-    goto out;
+    return (rv);
+
+  rv = fib_api_route_add_del (is_add,
+			      is_multipath,
+			      fib_index, &pfx, entry_flags, rpaths);
+
+  if (is_add && 0 == rv)
+    *stats_index = fib_table_entry_get_stats_index (fib_index, &pfx);
+
+  return (rv);
+}
+
+static int
+ip_route_add_del_t_handler (vl_api_ip_route_add_del_t * mp, u32 * stats_index)
+{
+  fib_route_path_t *rpaths = NULL;
+  fib_entry_flag_t entry_flags;
+  int rv = 0, ii;
+
+  entry_flags = FIB_ENTRY_FLAG_NONE;
 
   if (0 != mp->route.n_paths)
     vec_validate (rpaths, mp->route.n_paths - 1);
 
   for (ii = 0; ii < mp->route.n_paths; ii++)
     {
-      apath = &mp->route.paths[ii];
-      rpath = &rpaths[ii];
-
-      rv = fib_api_path_decode (apath, rpath);
-
-      if ((rpath->frp_flags & FIB_ROUTE_PATH_LOCAL) &&
-	  (~0 == rpath->frp_sw_if_index))
-	entry_flags |= (FIB_ENTRY_FLAG_CONNECTED | FIB_ENTRY_FLAG_LOCAL);
-
+      rv = ip_route_path_decode (&mp->route.paths[ii], &rpaths[ii],
+				 &entry_flags);
       if (0 != rv)
 	goto out;
     }
 
-  rv = fib_api_route_add_del (mp->is_add,
-			      mp->is_multipath,
-			      fib_index, &pfx, entry_flags, rpaths);
-
-  if (mp->is_add && 0 == rv)
-    *stats_index = fib_table_entry_get_stats_index (fib_index, &pfx);
+  rv = ip_route_add_del_paths (mp->is_add,
+			       mp->is_multipath,
+			       ntohl (mp->route.table_id),
+			       &mp->route.prefix, entry_flags, rpaths,
+			       stats_index);
 
 out:
   vec_free (rpaths);
@@ -715,6 +740,95 @@ vl_api_ip_route_add_del_t_handler (vl_api_ip_route_add_del_t * mp)
   /* *INDENT-ON* */
 }
 
+void
+vl_api_ip_route_add_del_bulk_t_handler (vl_api_ip_route_add_del_bulk_t * mp)
+{
+  vl_api_ip_route_add_del_bulk_reply_t *rmp;
+  vl_api_ip_route_bulk_result_t *results = NULL, *result;
+  vl_api_ip_route_bulk_entry_t *entry;
+  fib_route_path_t *rpaths = NULL;
+  fib_entry_flag_t entry_flags;
+  u32 ii, jj, n_entries, n_paths;
+  int rv = 0, rv1;
+
+  n_entries = ntohl (mp->n_entries);
+
+  if (vl_msg_api_get_msg_length (mp) <
+      sizeof (*mp) + n_entries * sizeof (mp->entries[0]))
+    {
+      rv = VNET_API_ERROR_INVALID_VALUE;
+      goto out;
+    }
+
+  /*
+   * This message is not MP safe, so the workers are held at the barrier
+   * for the whole batch. Walks to the children of the updated objects are
+   * thus safe to defer to the end of it, where they run once per object.
+   */
+  fib_walk_defer_start ();
+
+  ii = 0;
+  while (ii < n_entries)
+    {
+      entry = &mp->entries[ii];
+      n_paths = entry->n_paths;
+      entry_flags = FIB_ENTRY_FLAG_NONE;
+      vec_reset_length (rpaths);
+
+      vec_add2 (results, result, 1);
+      result->stats_index = ~0;
+
+      if (ii + clib_max (n_paths, 1) > n_entries)
+	{
+	  rv1 = VNET_API_ERROR_INVALID_VALUE;
+	  n_paths = n_entries - ii;
+	  goto next;
+	}
+
+      if (0 != n_paths)
+	vec_validate (rpaths, n_paths - 1);
+
+      for (jj = 0; jj < n_paths; jj++)
+	{
+	  rv1 = ip_route_path_decode (&entry[jj].path, &rpaths[jj],
+				      &entry_flags);
+	  if (0 != rv1)
+	    goto next;
+	}
+
+      rv1 = ip_route_add_del_paths (entry->is_add,
+				    entry->is_multipath,
+				    ntohl (entry->table_id),
+				    &entry->prefix, entry_flags, rpaths,
+				    &result->stats_index);
+
+    next:
+      if (0 != rv1 && 0 == rv)
+	rv = rv1;
+      result->retval = htonl (rv1);
+      result->stats_index = htonl (result->stats_index);
+      ii += clib_max (n_paths, 1);
+    }
+
+  fib_walk_defer_end ();
+
+out:
+  vec_free (rpaths);
+
+  /* *INDENT-OFF* */
+  REPLY_MACRO3 (VL_API_IP_ROUTE_ADD_DEL_BULK_REPLY,
+                vec_len (results) * sizeof (*results),
+  ({
+    rmp->n_results = htonl (vec_len (results));
+    if (vec_len (results))
+      clib_memcpy (rmp->results, results,
+                   vec_len (results) * sizeof (*results));
+  }))
+  /* *INDENT-ON* */
+
+  vec_free (results);
+}
+
 void
 ip_table_create (fib_protocol_t fproto,
 		 u32 table_id, u8 is_api, const u8 * name)
@@ -153,6 +153,128 @@ esp_aad_fill (vnet_crypto_op_t * op,
       op->aad_len = 8;
     }
 }
+/*
+ * Describe 'len' bytes of a buffer chain, starting at 'start' in buffer
+ * 'b', as a list of crypto chunks. The data is processed in place.
+ */
+always_inline void
+esp_chain_chunks_fill (vlib_main_t * vm, vnet_crypto_op_t * op,
+		       vnet_crypto_op_chunk_t ** chunks, vlib_buffer_t * b,
+		       u8 * start, u32 len)
+{
+  vnet_crypto_op_chunk_t *ch;
+  u32 n;
+
+  op->flags |= VNET_CRYPTO_OP_FLAG_CHAINED_BUFFERS;
+  op->chunk_index = vec_len (*chunks);
+  op->n_chunks = 0;
+
+  n = clib_min (len, vlib_buffer_get_tail (b) - start);
+  while (1)
+    {
+      vec_add2 (*chunks, ch, 1);
+      ch->src = ch->dst = start;
+      ch->len = n;
+      op->n_chunks++;
+      len -= n;
+
+      if (len == 0 || !(b->flags & VLIB_BUFFER_NEXT_PRESENT))
+	break;
+
+      b = vlib_get_buffer (vm, b->next_buffer);
+      start = vlib_buffer_get_current (b);
+      n = clib_min (len, b->current_length);
+    }
+}
+
+/* per-packet data needed to finish ESP decryption once crypto is done */
+typedef struct
+{
+  union
+  {
+    struct
+    {
+      u8 icv_sz;
+      u8 iv_sz;
+      ipsec_sa_flags_t flags;
+      u32 sa_index;
+    };
+    u64 sa_data;
+  };
+
+  i16 current_data;
+  i16 current_length;
+  u16 hdr_sz;
+} esp_decrypt_packet_data_t;
+
+STATIC_ASSERT_SIZEOF (esp_decrypt_packet_data_t, 2 * sizeof (u64));
+
+/*
+ * State carried in the buffer across an async crypto operation, between
+ * the ESP node that builds the op and its post node which runs after
+ * the crypto-dispatch node.
+ */
+typedef struct
+{
+  esp_decrypt_packet_data_t decrypt_data;
+  u32 next_index;
+} esp_post_data_t;
+
+STATIC_ASSERT (sizeof (esp_post_data_t) <=
+	       STRUCT_SIZE_OF (vnet_buffer_opaque2_t, unused),
+	       "ESP post data too large for vnet_buffer_opaque2_t");
+
+#define esp_post_data(b) \
+  ((esp_post_data_t *) ((u8 *) ((b)->opaque2) + \
+    STRUCT_OFFSET_OF (vnet_buffer_opaque2_t, unused)))
+
+/* next index of packets which have been handed to an async crypto frame */
+#define ESP_NEXT_ASYNC ((u16) ~1)
+
+/* hand a frame to the async engine, dropping its packets on failure */
+always_inline void
+esp_async_submit_frame (vlib_main_t * vm, vlib_node_runtime_t * node,
+			vnet_crypto_async_frame_t * f, u16 * pkts,
+			vlib_buffer_t ** bufs, u16 * nexts, u32 err,
+			u16 drop_next)
+{
+  u32 i;
+
+  if (f->n_elts && vnet_crypto_async_submit_open_frame (vm, f) == 0)
+    return;
+
+  for (i = 0; i < f->n_elts; i++)
+    {
+      bufs[pkts[i]]->error = node->errors[err];
+      nexts[pkts[i]] = drop_next;
+    }
+  vnet_crypto_async_free_frame (vm, f);
+}
+
+/* collect the packets which stayed on the synchronous path */
+always_inline u32
+esp_async_filter_sync (u32 * from, u16 * nexts, u32 * sync_bi, u32 n_left)
+{
+  u32 i, n_sync = 0;
+
+  for (i = 0; i < n_left; i++)
+    if (nexts[i] != ESP_NEXT_ASYNC)
+      {
+	sync_bi[n_sync] = from[i];
+	nexts[n_sync] = nexts[i];
+	n_sync++;
+      }
+
+  return n_sync;
+}
+
+always_inline u16
+esp_async_post_next (ipsec_main_t * im, int is_encrypt, int is_ip6,
+		     int is_tun)
+{
+  return im->esp_post_next[is_encrypt][is_ip6][is_tun];
+}
+
 #endif /* __ESP_H__ */
 
 /*
@@ -85,28 +85,261 @@ format_esp_decrypt_trace (u8 * s, va_list * args)
   return s;
 }
 
-typedef struct
+#define ESP_ENCRYPT_PD_F_FD_TRANSPORT (1 << 2)
+
+static_always_inline void
+esp_decrypt_add_trace (vlib_main_t * vm, vlib_node_runtime_t * node,
+		       vlib_buffer_t * b, esp_decrypt_packet_data_t * pd)
+{
+  ipsec_main_t *im = &ipsec_main;
+  esp_decrypt_trace_t *tr;
+  ipsec_sa_t *sa0;
+  u8 *payload = b->data + pd->current_data;
+
+  tr = vlib_add_trace (vm, node, b, sizeof (*tr));
+  sa0 = pool_elt_at_index (im->sad, vnet_buffer (b)->ipsec.sad_index);
+  tr->crypto_alg = sa0->crypto_alg;
+  tr->integ_alg = sa0->integ_alg;
+  tr->seq = clib_host_to_net_u32 (((esp_header_t *) payload)->seq);
+}
+
+/*
+ * make sure the ESP footer and the ICV are contiguous in the last buffer
+ * of a chain, pulling the missing bytes from the tail of the previous
+ * buffer into its headroom. Returns 0 if the chain can't be handled.
+ */
+static_always_inline vlib_buffer_t *
+esp_decrypt_chain_prepare (vlib_main_t * vm, vlib_buffer_t * b, u16 need)
 {
-  union
-  {
-    struct
+  vlib_buffer_t *before_last = b, *lb = b;
+  i16 n;
+
+  while (lb->flags & VLIB_BUFFER_NEXT_PRESENT)
     {
-      u8 icv_sz;
-      u8 iv_sz;
-      ipsec_sa_flags_t flags;
-      u32 sa_index;
-    };
-    u64 sa_data;
-  };
+      before_last = lb;
+      lb = vlib_get_buffer (vm, lb->next_buffer);
+    }
 
-  i16 current_data;
-  i16 current_length;
-  u16 hdr_sz;
-} esp_decrypt_packet_data_t;
+  if (lb->current_length >= need)
+    return lb;
 
-STATIC_ASSERT_SIZEOF (esp_decrypt_packet_data_t, 2 * sizeof (u64));
+  n = need - lb->current_length;
+  if (before_last->current_length < n ||
+      lb->current_data - n < -VLIB_BUFFER_PRE_DATA_SIZE)
+    return 0;
 
-#define ESP_ENCRYPT_PD_F_FD_TRANSPORT (1 << 2)
+  vlib_buffer_advance (lb, -n);
+  clib_memcpy_fast (vlib_buffer_get_current (lb),
+		    vlib_buffer_get_tail (before_last) - n, n);
+  before_last->current_length -= n;
+
+  if (before_last == b)
+    b->total_length_not_including_first_buffer += n;
+
+  return lb;
+}
+
+/* trim the ESP trailer off the end of a chain, freeing emptied buffers */
+static_always_inline void
+esp_decrypt_chain_remove_tail (vlib_main_t * vm, vlib_buffer_t * b,
+			       u16 tail)
+{
+  while (tail)
+    {
+      vlib_buffer_t *before_last = 0, *lb = b;
+
+      while (lb->flags & VLIB_BUFFER_NEXT_PRESENT)
+	{
+	  before_last = lb;
+	  lb = vlib_get_buffer (vm, lb->next_buffer);
+	}
+
+      if (lb->current_length > tail || before_last == 0)
+	{
+	  lb->current_length -= tail;
+	  if (lb != b)
+	    b->total_length_not_including_first_buffer -= tail;
+	  return;
+	}
+
+      tail -= lb->current_length;
+      b->total_length_not_including_first_buffer -= lb->current_length;
+      vlib_buffer_free_one (vm, before_last->next_buffer);
+      before_last->next_buffer = 0;
+      before_last->flags &= ~VLIB_BUFFER_NEXT_PRESENT;
+    }
+}
+
+/* adjust packet data start and length and select the next node once the
+   payload has been decrypted and authenticated */
+static_always_inline void
+esp_decrypt_post_crypto (vlib_main_t * vm, vlib_node_runtime_t * node,
+			 esp_decrypt_packet_data_t * pd, vlib_buffer_t * b,
+			 u16 * next, int is_ip6, int is_tun)
+{
+  ipsec_main_t *im = &ipsec_main;
+  const u8 tun_flags = IPSEC_SA_FLAG_IS_TUNNEL | IPSEC_SA_FLAG_IS_TUNNEL_V6;
+  const u8 esp_sz = sizeof (esp_header_t);
+  ipsec_sa_t *sa0 = vec_elt_at_index (im->sad, pd->sa_index);
+  u8 *payload = b->data + pd->current_data;
+  u8 *data_end = payload + pd->current_length;
+  int is_chain = (b->flags & VLIB_BUFFER_NEXT_PRESENT) != 0;
+
+  ipsec_sa_anti_replay_advance (sa0, ((esp_header_t *) payload)->seq);
+
+  if (PREDICT_FALSE (is_chain))
+    {
+      vlib_buffer_t *lb = b;
+      while (lb->flags & VLIB_BUFFER_NEXT_PRESENT)
+	lb = vlib_get_buffer (vm, lb->next_buffer);
+      data_end = vlib_buffer_get_tail (lb);
+    }
+
+  esp_footer_t *f = (esp_footer_t *) (data_end - sizeof (esp_footer_t) -
+				      pd->icv_sz);
+  u16 adv = pd->iv_sz + esp_sz;
+  u16 tail = sizeof (esp_footer_t) + f->pad_length + pd->icv_sz;
+  /* for chains the trailer is trimmed off the last buffers instead */
+  u16 first_tail = is_chain ? 0 : tail;
+
+  if ((pd->flags & tun_flags) == 0 && !is_tun)	/* transport mode */
+    {
+      u8 udp_sz = (is_ip6 == 0 && pd->flags & IPSEC_SA_FLAG_UDP_ENCAP) ?
+	sizeof (udp_header_t) : 0;
+      u16 ip_hdr_sz = pd->hdr_sz - udp_sz;
+      u8 *old_ip = b->data + pd->current_data - ip_hdr_sz - udp_sz;
+      u8 *ip = old_ip + adv + udp_sz;
+
+      if (is_ip6 && ip_hdr_sz > 64)
+	memmove (ip, old_ip, ip_hdr_sz);
+      else
+	clib_memcpy_le64 (ip, old_ip, ip_hdr_sz);
+
+      b->current_data = pd->current_data + adv - ip_hdr_sz;
+      b->current_length = pd->current_length + ip_hdr_sz - first_tail - adv;
+
+      if (is_ip6)
+	{
+	  ip6_header_t *ip6 = (ip6_header_t *) ip;
+	  u16 len = clib_net_to_host_u16 (ip6->payload_length);
+	  len -= adv + tail;
+	  ip6->payload_length = clib_host_to_net_u16 (len);
+	  ip6->protocol = f->next_header;
+	  next[0] = ESP_DECRYPT_NEXT_IP6_INPUT;
+	}
+      else
+	{
+	  ip4_header_t *ip4 = (ip4_header_t *) ip;
+	  ip_csum_t sum = ip4->checksum;
+	  u16 len = clib_net_to_host_u16 (ip4->length);
+	  len = clib_host_to_net_u16 (len - adv - tail - udp_sz);
+	  sum = ip_csum_update (sum, ip4->protocol, f->next_header,
+				ip4_header_t, protocol);
+	  sum = ip_csum_update (sum, ip4->length, len, ip4_header_t, length);
+	  ip4->checksum = ip_csum_fold (sum);
+	  ip4->protocol = f->next_header;
+	  ip4->length = len;
+	  next[0] = ESP_DECRYPT_NEXT_IP4_INPUT;
+	}
+    }
+  else
+    {
+      if (PREDICT_TRUE (f->next_header == IP_PROTOCOL_IP_IN_IP))
+	{
+	  next[0] = ESP_DECRYPT_NEXT_IP4_INPUT;
+	  b->current_data = pd->current_data + adv;
+	  b->current_length = pd->current_length - adv - first_tail;
+	}
+      else if (f->next_header == IP_PROTOCOL_IPV6)
+	{
+	  next[0] = ESP_DECRYPT_NEXT_IP6_INPUT;
+	  b->current_data = pd->current_data + adv;
+	  b->current_length = pd->current_length - adv - first_tail;
+	}
+      else
+	{
+	  next[0] = ESP_DECRYPT_NEXT_DROP;
+	  b->error = node->errors[ESP_DECRYPT_ERROR_DECRYPTION_FAILED];
+	  return;
+	}
+      if (is_tun)
+	{
+	  if (ipsec_sa_is_set_IS_PROTECT (sa0))
+	    {
+	      /*
+	       * Check that the reveal IP header matches that
+	       * of the tunnel we are protecting
+	       */
+	      const ipsec_tun_protect_t *itp;
+
+	      itp = ipsec_tun_protect_get (vnet_buffer (b)->ipsec.protect_index);
+	      if (PREDICT_TRUE (f->next_header == IP_PROTOCOL_IP_IN_IP))
+		{
+		  const ip4_header_t *ip4;
+
+		  ip4 = vlib_buffer_get_current (b);
+
+		  if (!ip46_address_is_equal_v4 (&itp->itp_tun.src,
+						 &ip4->dst_address) ||
+		      !ip46_address_is_equal_v4 (&itp->itp_tun.dst,
+						 &ip4->src_address))
+		    next[0] = ESP_DECRYPT_NEXT_DROP;
+
+		}
+	      else if (f->next_header == IP_PROTOCOL_IPV6)
+		{
+		  const ip6_header_t *ip6;
+
+		  ip6 = vlib_buffer_get_current (b);
+
+		  if (!ip46_address_is_equal_v6 (&itp->itp_tun.src,
+						 &ip6->dst_address) ||
+		      !ip46_address_is_equal_v6 (&itp->itp_tun.dst,
+						 &ip6->src_address))
+		    next[0] = ESP_DECRYPT_NEXT_DROP;
+		}
+	    }
+	}
+    }
+
+  /* done with the footer, it may live in one of the trimmed buffers */
+  if (PREDICT_FALSE (is_chain))
+    esp_decrypt_chain_remove_tail (vm, b, tail);
+}
+
+static_always_inline void
+esp_process_ops (vlib_main_t * vm, vlib_node_runtime_t * node,
+		 vnet_crypto_op_t * ops, vlib_buffer_t * b[], u16 * nexts,
+		 vnet_crypto_op_chunk_t * chunks, int e)
+{
+  u32 n_fail, n_ops = vec_len (ops);
+  vnet_crypto_op_t *op = ops;
+
+  if (n_ops == 0)
+    return;
+
+  if (chunks)
+    n_fail = n_ops - vnet_crypto_process_chained_ops (vm, op, chunks, n_ops);
+  else
+    n_fail = n_ops - vnet_crypto_process_ops (vm, op, n_ops);
+
+  while (n_fail)
+    {
+      ASSERT (op - ops < n_ops);
+      if (op->status != VNET_CRYPTO_OP_STATUS_COMPLETED)
+	{
+	  u32 err, bi = op->user_data;
+	  if (op->status == VNET_CRYPTO_OP_STATUS_FAIL_BAD_HMAC)
+	    err = e;
+	  else
+	    err = ESP_DECRYPT_ERROR_CRYPTO_ENGINE_ERROR;
+	  b[bi]->error = node->errors[err];
+	  nexts[bi] = ESP_DECRYPT_NEXT_DROP;
+	  n_fail--;
+	}
+      op++;
+    }
+}
 
 always_inline uword
 esp_decrypt_inline (vlib_main_t * vm,
@@ -119,7 +352,7 @@ esp_decrypt_inline (vlib_main_t * vm,
   u16 len;
   ipsec_per_thread_data_t *ptd = vec_elt_at_index (im->ptd, thread_index);
   u32 *from = vlib_frame_vector_args (from_frame);
-  u32 n, n_left = from_frame->n_vectors;
+  u32 n_left = from_frame->n_vectors;
   vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b = bufs;
   u16 nexts[VLIB_FRAME_SIZE], *next = nexts;
   esp_decrypt_packet_data_t pkt_data[VLIB_FRAME_SIZE], *pd = pkt_data;
@@ -127,15 +360,32 @@ esp_decrypt_inline (vlib_main_t * vm,
   u32 current_sa_index = ~0, current_sa_bytes = 0, current_sa_pkts = 0;
   const u8 esp_sz = sizeof (esp_header_t);
   ipsec_sa_t *sa0 = 0;
+  vnet_crypto_async_frame_t *async_frame = 0;
+  u16 async_pkts[VNET_CRYPTO_FRAME_SIZE];
+  u16 post_next = 0;
+  int is_async = 0;
 
   vlib_get_buffers (vm, from, b, n_left);
   vec_reset_length (ptd->crypto_ops);
   vec_reset_length (ptd->integ_ops);
+  vec_reset_length (ptd->chained_crypto_ops);
+  vec_reset_length (ptd->chained_integ_ops);
+  vec_reset_length (ptd->chunks);
   clib_memset_u16 (nexts, -1, n_left);
 
+  if (PREDICT_FALSE (im->async_mode && vnet_crypto_async_is_active ()))
+    {
+      async_frame = vnet_crypto_async_get_frame (vm);
+      post_next = esp_async_post_next (im, 0, is_ip6, is_tun);
+      is_async = 1;
+    }
+
   while (n_left > 0)
     {
       u8 *payload;
+      u16 total_len;
+      vlib_buffer_t *lb;
+      vnet_crypto_async_frame_t *af;
 
       if (n_left > 2)
 	{
@@ -147,13 +397,6 @@ esp_decrypt_inline (vlib_main_t * vm,
 	  CLIB_PREFETCH (p, CLIB_CACHE_LINE_BYTES, LOAD);
 	}
 
-      if (vlib_buffer_chain_linearize (vm, b[0]) != 1)
-	{
-	  b[0]->error = node->errors[ESP_DECRYPT_ERROR_CHAINED_BUFFER];
-	  next[0] = ESP_DECRYPT_NEXT_DROP;
-	  goto next;
-	}
-
       if (vnet_buffer (b[0])->ipsec.sad_index != current_sa_index)
 	{
 	  if (current_sa_pkts)
@@ -174,13 +417,30 @@ esp_decrypt_inline (vlib_main_t * vm,
       /* store packet data for next round for easier prefetch */
       pd->sa_data = cpd.sa_data;
       pd->current_data = b[0]->current_data;
-      pd->current_length = b[0]->current_length;
       pd->hdr_sz = pd->current_data - vnet_buffer (b[0])->l3_hdr_offset;
       payload = b[0]->data + pd->current_data;
+      total_len = b[0]->current_length;
+      lb = b[0];
+
+      if (PREDICT_FALSE (b[0]->flags & VLIB_BUFFER_NEXT_PRESENT))
+	{
+	  /* the ESP header and IV have to be in the first buffer, the
+	     footer and ICV in the last one */
+	  total_len = vlib_buffer_length_in_chain (vm, b[0]);
+	  lb = esp_decrypt_chain_prepare (vm, b[0], cpd.icv_sz +
+					  sizeof (esp_footer_t));
+	  if (!lb || b[0]->current_length < esp_sz + cpd.iv_sz)
+	    {
+	      b[0]->error = node->errors[ESP_DECRYPT_ERROR_CHAINED_BUFFER];
+	      next[0] = ESP_DECRYPT_NEXT_DROP;
+	      goto next;
+	    }
+	}
+      pd->current_length = b[0]->current_length;
 
       /* we need 4 extra bytes for HMAC calculation when ESN are used */
       if (ipsec_sa_is_set_USE_ESN (sa0) && pd->icv_sz &&
-	  (pd->current_data + pd->current_length + 4 > buffer_data_size))
+	  (lb->current_data + lb->current_length + 4 > buffer_data_size))
 	{
 	  b[0]->error = node->errors[ESP_DECRYPT_ERROR_NO_TAIL_SPACE];
 	  next[0] = ESP_DECRYPT_NEXT_DROP;
@@ -195,39 +455,57 @@ esp_decrypt_inline (vlib_main_t * vm,
 	  goto next;
 	}
 
-      if (pd->current_length < cpd.icv_sz + esp_sz + cpd.iv_sz)
+      if (total_len < cpd.icv_sz + esp_sz + cpd.iv_sz)
 	{
 	  b[0]->error = node->errors[ESP_DECRYPT_ERROR_RUNT];
 	  next[0] = ESP_DECRYPT_NEXT_DROP;
 	  goto next;
 	}
 
-      len = pd->current_length - cpd.icv_sz;
+      len = total_len - cpd.icv_sz;
       current_sa_pkts += 1;
-      current_sa_bytes += pd->current_length;
+      current_sa_bytes += total_len;
+
+      /* async frames carry no chunks, chains are always done in place */
+      af = lb == b[0] ? async_frame : 0;
 
       if (PREDICT_TRUE (sa0->integ_op_id != VNET_CRYPTO_OP_NONE))
 	{
 	  vnet_crypto_op_t *op;
-	  vec_add2_aligned (ptd->integ_ops, op, 1, CLIB_CACHE_LINE_BYTES);
-
-	  vnet_crypto_op_init (op, sa0->integ_op_id);
+	  if (af)
+	    op = vnet_crypto_async_add_integ_op (af, sa0->integ_op_id);
+	  else
+	    {
+	      if (lb == b[0])
+		vec_add2_aligned (ptd->integ_ops, op, 1,
+				  CLIB_CACHE_LINE_BYTES);
+	      else
+		vec_add2_aligned (ptd->chained_integ_ops, op, 1,
+				  CLIB_CACHE_LINE_BYTES);
+	      vnet_crypto_op_init (op, sa0->integ_op_id);
+	      op->user_data = b - bufs;
+	    }
 	  op->key_index = sa0->integ_key_index;
 	  op->src = payload;
 	  op->flags = VNET_CRYPTO_OP_FLAG_HMAC_CHECK;
-	  op->user_data = b - bufs;
-	  op->digest = payload + len;
+	  op->digest = vlib_buffer_get_tail (lb) - cpd.icv_sz;
 	  op->digest_len = cpd.icv_sz;
 	  op->len = len;
+
+	  if (lb != b[0])
+	    esp_chain_chunks_fill (vm, op, &ptd->chunks, b[0], payload, len);
+
 	  if (ipsec_sa_is_set_USE_ESN (sa0))
 	    {
 	      /* shift ICV for 4 bytes to insert ESN */
 	      u8 tmp[ESP_MAX_ICV_SIZE], sz = sizeof (sa0->seq_hi);
-	      clib_memcpy_fast (tmp, payload + len, ESP_MAX_ICV_SIZE);
-	      clib_memcpy_fast (payload + len, &sa0->seq_hi, sz);
-	      clib_memcpy_fast (payload + len + sz, tmp, ESP_MAX_ICV_SIZE);
+	      clib_memcpy_fast (tmp, op->digest, ESP_MAX_ICV_SIZE);
+	      clib_memcpy_fast (op->digest, &sa0->seq_hi, sz);
+	      clib_memcpy_fast (op->digest + sz, tmp, ESP_MAX_ICV_SIZE);
 	      op->len += sz;
 	      op->digest += sz;
+	      if (lb != b[0])
+		ptd->chunks[op->chunk_index + op->n_chunks - 1].len += sz;
 	    }
 	}
 
@@ -237,8 +515,19 @@ esp_decrypt_inline (vlib_main_t * vm,
       if (sa0->crypto_enc_op_id != VNET_CRYPTO_OP_NONE)
 	{
 	  vnet_crypto_op_t *op;
-	  vec_add2_aligned (ptd->crypto_ops, op, 1, CLIB_CACHE_LINE_BYTES);
-	  vnet_crypto_op_init (op, sa0->crypto_dec_op_id);
+	  if (af)
+	    op = vnet_crypto_async_add_crypto_op (af, sa0->crypto_dec_op_id);
+	  else
+	    {
+	      if (lb == b[0])
+		vec_add2_aligned (ptd->crypto_ops, op, 1,
+				  CLIB_CACHE_LINE_BYTES);
+	      else
+		vec_add2_aligned (ptd->chained_crypto_ops, op, 1,
+				  CLIB_CACHE_LINE_BYTES);
+	      vnet_crypto_op_init (op, sa0->crypto_dec_op_id);
+	      op->user_data = b - bufs;
+	    }
 	  op->key_index = sa0->crypto_key_index;
 	  op->iv = payload;
 
@@ -268,12 +557,34 @@ esp_decrypt_inline (vlib_main_t * vm,
 	      op->iv -= sizeof (sa0->salt);
 	      clib_memcpy_fast (op->iv, &sa0->salt, sizeof (sa0->salt));
 
-	      op->tag = payload + len;
+	      op->tag = vlib_buffer_get_tail (lb) - cpd.icv_sz;
 	      op->tag_len = 16;
 	    }
 	  op->src = op->dst = payload += cpd.iv_sz;
 	  op->len = len - cpd.iv_sz;
-	  op->user_data = b - bufs;
+
+	  if (lb != b[0])
+	    esp_chain_chunks_fill (vm, op, &ptd->chunks, b[0], payload,
+				   op->len);
+	}
+
+      if (af)
+	{
+	  async_frame->flags |= VNET_CRYPTO_FRAME_F_INTEG_FIRST;
+	  esp_post_data (b[0])->decrypt_data = *pd;
+	  async_pkts[async_frame->n_elts] = b - bufs;
+	  next[0] = ESP_NEXT_ASYNC;
+
+	  if (vnet_crypto_async_add_elt (async_frame, from[b - bufs],
+					 post_next))
+	    {
+	      esp_async_submit_frame (vm, node, async_frame, async_pkts,
+				      bufs, nexts,
+				      ESP_DECRYPT_ERROR_CRYPTO_ENGINE_ERROR,
+				      ESP_DECRYPT_NEXT_DROP);
+	      /* falls back to the synchronous path if the pool is empty */
+	      async_frame = vnet_crypto_async_get_frame (vm);
+	    }
 	}
 
       /* next */
@@ -288,52 +599,19 @@ esp_decrypt_inline (vlib_main_t * vm,
 				   current_sa_index, current_sa_pkts,
 				   current_sa_bytes);
 
-  if ((n = vec_len (ptd->integ_ops)))
-    {
-      vnet_crypto_op_t *op = ptd->integ_ops;
-      n -= vnet_crypto_process_ops (vm, op, n);
-      while (n)
-	{
-	  ASSERT (op - ptd->integ_ops < vec_len (ptd->integ_ops));
-	  if (op->status != VNET_CRYPTO_OP_STATUS_COMPLETED)
-	    {
-	      u32 err, bi = op->user_data;
-	      if (op->status == VNET_CRYPTO_OP_STATUS_FAIL_BAD_HMAC)
-		err = ESP_DECRYPT_ERROR_INTEG_ERROR;
-	      else
-		err = ESP_DECRYPT_ERROR_CRYPTO_ENGINE_ERROR;
-	      bufs[bi]->error = node->errors[err];
-	      nexts[bi] = ESP_DECRYPT_NEXT_DROP;
-	      n--;
-	    }
-	  op++;
-	}
-    }
-  if ((n = vec_len (ptd->crypto_ops)))
-    {
-      vnet_crypto_op_t *op = ptd->crypto_ops;
-      n -= vnet_crypto_process_ops (vm, op, n);
-      while (n)
-	{
-	  ASSERT (op - ptd->crypto_ops < vec_len (ptd->crypto_ops));
-	  if (op->status != VNET_CRYPTO_OP_STATUS_COMPLETED)
-	    {
-	      u32 err, bi;
-
-	      bi = op->user_data;
+  if (async_frame)
+    esp_async_submit_frame (vm, node, async_frame, async_pkts, bufs, nexts,
+			    ESP_DECRYPT_ERROR_CRYPTO_ENGINE_ERROR,
+			    ESP_DECRYPT_NEXT_DROP);
 
-	      if (op->status == VNET_CRYPTO_OP_STATUS_FAIL_BAD_HMAC)
-		err = ESP_DECRYPT_ERROR_DECRYPTION_FAILED;
-	      else
-		err = ESP_DECRYPT_ERROR_CRYPTO_ENGINE_ERROR;
-
-	      bufs[bi]->error = node->errors[err];
-	      nexts[bi] = ESP_DECRYPT_NEXT_DROP;
-	      n--;
-	    }
-	  op++;
-	}
-    }
+  esp_process_ops (vm, node, ptd->integ_ops, bufs, nexts, 0,
+		   ESP_DECRYPT_ERROR_INTEG_ERROR);
+  esp_process_ops (vm, node, ptd->chained_integ_ops, bufs, nexts,
+		   ptd->chunks, ESP_DECRYPT_ERROR_INTEG_ERROR);
+  esp_process_ops (vm, node, ptd->crypto_ops, bufs, nexts, 0,
+		   ESP_DECRYPT_ERROR_DECRYPTION_FAILED);
+  esp_process_ops (vm, node, ptd->chained_crypto_ops, bufs, nexts,
+		   ptd->chunks, ESP_DECRYPT_ERROR_DECRYPTION_FAILED);
 
   /* Post decryption ronud - adjust packet data start and length and next
      node */
@@ -345,9 +623,6 @@ esp_decrypt_inline (vlib_main_t * vm,
 
   while (n_left)
     {
-      const u8 tun_flags = IPSEC_SA_FLAG_IS_TUNNEL |
-	IPSEC_SA_FLAG_IS_TUNNEL_V6;
-
       if (n_left >= 2)
 	{
 	  void *data = b[1]->data + pd[1].current_data;
@@ -367,134 +642,17 @@ esp_decrypt_inline (vlib_main_t * vm,
       if (next[0] < ESP_DECRYPT_N_NEXT)
 	goto trace;
 
-      sa0 = vec_elt_at_index (im->sad, pd->sa_index);
-      u8 *payload = b[0]->data + pd->current_data;
-
-      ipsec_sa_anti_replay_advance (sa0, ((esp_header_t *) payload)->seq);
-
-      esp_footer_t *f = (esp_footer_t *) (b[0]->data + pd->current_data +
-					  pd->current_length - sizeof (*f) -
-					  pd->icv_sz);
-      u16 adv = pd->iv_sz + esp_sz;
-      u16 tail = sizeof (esp_footer_t) + f->pad_length + pd->icv_sz;
+      if (next[0] == ESP_NEXT_ASYNC)
+	goto next_pkt;
 
-      if ((pd->flags & tun_flags) == 0 && !is_tun)	/* transport mode */
-	{
-	  u8 udp_sz = (is_ip6 == 0 && pd->flags & IPSEC_SA_FLAG_UDP_ENCAP) ?
-	    sizeof (udp_header_t) : 0;
-	  u16 ip_hdr_sz = pd->hdr_sz - udp_sz;
-	  u8 *old_ip = b[0]->data + pd->current_data - ip_hdr_sz - udp_sz;
-	  u8 *ip = old_ip + adv + udp_sz;
-
-	  if (is_ip6 && ip_hdr_sz > 64)
-	    memmove (ip, old_ip, ip_hdr_sz);
-	  else
-	    clib_memcpy_le64 (ip, old_ip, ip_hdr_sz);
-
-	  b[0]->current_data = pd->current_data + adv - ip_hdr_sz;
-	  b[0]->current_length = pd->current_length + ip_hdr_sz - tail - adv;
-
-	  if (is_ip6)
-	    {
-	      ip6_header_t *ip6 = (ip6_header_t *) ip;
-	      u16 len = clib_net_to_host_u16 (ip6->payload_length);
-	      len -= adv + tail;
-	      ip6->payload_length = clib_host_to_net_u16 (len);
-	      ip6->protocol = f->next_header;
-	      next[0] = ESP_DECRYPT_NEXT_IP6_INPUT;
-	    }
-	  else
-	    {
-	      ip4_header_t *ip4 = (ip4_header_t *) ip;
-	      ip_csum_t sum = ip4->checksum;
-	      u16 len = clib_net_to_host_u16 (ip4->length);
-	      len = clib_host_to_net_u16 (len - adv - tail - udp_sz);
-	      sum = ip_csum_update (sum, ip4->protocol, f->next_header,
-				    ip4_header_t, protocol);
-	      sum = ip_csum_update (sum, ip4->length, len,
-				    ip4_header_t, length);
-	      ip4->checksum = ip_csum_fold (sum);
-	      ip4->protocol = f->next_header;
-	      ip4->length = len;
-	      next[0] = ESP_DECRYPT_NEXT_IP4_INPUT;
-	    }
-	}
-      else
-	{
-	  if (PREDICT_TRUE (f->next_header == IP_PROTOCOL_IP_IN_IP))
-	    {
-	      next[0] = ESP_DECRYPT_NEXT_IP4_INPUT;
-	      b[0]->current_data = pd->current_data + adv;
-	      b[0]->current_length = pd->current_length - adv - tail;
-	    }
-	  else if (f->next_header == IP_PROTOCOL_IPV6)
-	    {
-	      next[0] = ESP_DECRYPT_NEXT_IP6_INPUT;
-	      b[0]->current_data = pd->current_data + adv;
-	      b[0]->current_length = pd->current_length - adv - tail;
-	    }
-	  else
-	    {
-	      next[0] = ESP_DECRYPT_NEXT_DROP;
-	      b[0]->error = node->errors[ESP_DECRYPT_ERROR_DECRYPTION_FAILED];
-	      goto trace;
-	    }
-	  if (is_tun)
-	    {
-	      if (ipsec_sa_is_set_IS_PROTECT (sa0))
-		{
-		  /*
-		   * Check that the reveal IP header matches that
-		   * of the tunnel we are protecting
-		   */
-		  const ipsec_tun_protect_t *itp;
-
-		  itp =
-		    ipsec_tun_protect_get (vnet_buffer (b[0])->
-					   ipsec.protect_index);
-		  if (PREDICT_TRUE (f->next_header == IP_PROTOCOL_IP_IN_IP))
-		    {
-		      const ip4_header_t *ip4;
-
-		      ip4 = vlib_buffer_get_current (b[0]);
-
-		      if (!ip46_address_is_equal_v4 (&itp->itp_tun.src,
-						     &ip4->dst_address) ||
-			  !ip46_address_is_equal_v4 (&itp->itp_tun.dst,
-						     &ip4->src_address))
-			next[0] = ESP_DECRYPT_NEXT_DROP;
-
-		    }
-		  else if (f->next_header == IP_PROTOCOL_IPV6)
-		    {
-		      const ip6_header_t *ip6;
-
-		      ip6 = vlib_buffer_get_current (b[0]);
-
-		      if (!ip46_address_is_equal_v6 (&itp->itp_tun.src,
-						     &ip6->dst_address) ||
-			  !ip46_address_is_equal_v6 (&itp->itp_tun.dst,
-						     &ip6->src_address))
-			next[0] = ESP_DECRYPT_NEXT_DROP;
-		    }
-		}
-	    }
-	}
+      esp_decrypt_post_crypto (vm, node, pd, b[0], next, is_ip6, is_tun);
 
     trace:
       if (PREDICT_FALSE (b[0]->flags & VLIB_BUFFER_IS_TRACED))
-	{
-	  esp_decrypt_trace_t *tr;
-	  u8 *payload = b[0]->data + pd->current_data;
-	  tr = vlib_add_trace (vm, node, b[0], sizeof (*tr));
-	  sa0 = pool_elt_at_index (im->sad,
-				   vnet_buffer (b[0])->ipsec.sad_index);
-	  tr->crypto_alg = sa0->crypto_alg;
-	  tr->integ_alg = sa0->integ_alg;
-	  tr->seq = clib_host_to_net_u32 (((esp_header_t *) payload)->seq);
-	}
+	esp_decrypt_add_trace (vm, node, b[0], pd);
 
       /* next */
+    next_pkt:
       n_left -= 1;
       next += 1;
       pd += 1;
@@ -505,12 +663,58 @@ esp_decrypt_inline (vlib_main_t * vm,
   vlib_node_increment_counter (vm, node->node_index,
 			       ESP_DECRYPT_ERROR_RX_PKTS, n_left);
 
-  vlib_buffer_enqueue_to_next (vm, node, from, nexts, n_left);
+  if (is_async)
+    {
+      u32 sync_bi[VLIB_FRAME_SIZE], n_sync;
+      n_sync = esp_async_filter_sync (from, nexts, sync_bi, n_left);
+      vlib_buffer_enqueue_to_next (vm, node, sync_bi, nexts, n_sync);
+    }
+  else
+    vlib_buffer_enqueue_to_next (vm, node, from, nexts, n_left);
 
   b = bufs;
   return n_left;
 }
 
+/* runs after crypto-dispatch for packets decrypted asynchronously */
+always_inline uword
+esp_decrypt_post_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
+			 vlib_frame_t * from_frame, int is_ip6, int is_tun)
+{
+  u32 *from = vlib_frame_vector_args (from_frame);
+  u32 n_left = from_frame->n_vectors;
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b = bufs;
+  u16 nexts[VLIB_FRAME_SIZE], *next = nexts;
+  esp_decrypt_packet_data_t *pd;
+
+  vlib_get_buffers (vm, from, b, n_left);
+
+  while (n_left > 0)
+    {
+      if (n_left >= 2)
+	{
+	  pd = &esp_post_data (b[1])->decrypt_data;
+	  vlib_prefetch_buffer_header (b[1], LOAD);
+	  CLIB_PREFETCH (b[1]->data + pd->current_data - CLIB_CACHE_LINE_BYTES,
+			 CLIB_CACHE_LINE_BYTES * 2, LOAD);
+	}
+
+      pd = &esp_post_data (b[0])->decrypt_data;
+      esp_decrypt_post_crypto (vm, node, pd, b[0], next, is_ip6, is_tun);
+
+      if (PREDICT_FALSE (b[0]->flags & VLIB_BUFFER_IS_TRACED))
+	esp_decrypt_add_trace (vm, node, b[0], pd);
+
+      n_left -= 1;
+      next += 1;
+      b += 1;
+    }
+
+  n_left = from_frame->n_vectors;
+  vlib_buffer_enqueue_to_next (vm, node, from, nexts, n_left);
+  return n_left;
+}
+
 VLIB_NODE_FN (esp4_decrypt_node) (vlib_main_t * vm,
 				  vlib_node_runtime_t * node,
 				  vlib_frame_t * from_frame)
@@ -539,6 +743,34 @@ VLIB_NODE_FN (esp6_decrypt_tun_node) (vlib_main_t * vm,
   return esp_decrypt_inline (vm, node, from_frame, 1, 1);
 }
 
+VLIB_NODE_FN (esp4_decrypt_post_node) (vlib_main_t * vm,
+				       vlib_node_runtime_t * node,
+				       vlib_frame_t * from_frame)
+{
+  return esp_decrypt_post_inline (vm, node, from_frame, 0, 0);
+}
+
+VLIB_NODE_FN (esp4_decrypt_tun_post_node) (vlib_main_t * vm,
+					   vlib_node_runtime_t * node,
+					   vlib_frame_t * from_frame)
+{
+  return esp_decrypt_post_inline (vm, node, from_frame, 0, 1);
+}
+
+VLIB_NODE_FN (esp6_decrypt_post_node) (vlib_main_t * vm,
+				       vlib_node_runtime_t * node,
+				       vlib_frame_t * from_frame)
+{
+  return esp_decrypt_post_inline (vm, node, from_frame, 1, 0);
+}
+
+VLIB_NODE_FN (esp6_decrypt_tun_post_node) (vlib_main_t * vm,
+					   vlib_node_runtime_t * node,
+					   vlib_frame_t * from_frame)
+{
+  return esp_decrypt_post_inline (vm, node, from_frame, 1, 1);
+}
+
 /* *INDENT-OFF* */
 VLIB_REGISTER_NODE (esp4_decrypt_node) = {
   .name = "esp4-decrypt",
@@ -607,6 +839,55 @@ VLIB_REGISTER_NODE (esp6_decrypt_tun_node) = {
 #undef _
   },
 };
+
+VLIB_REGISTER_NODE (esp4_decrypt_post_node) = {
+  .name = "esp4-decrypt-post",
+  .vector_size = sizeof (u32),
+  .format_trace = format_esp_decrypt_trace,
+  .type = VLIB_NODE_TYPE_INTERNAL,
+
+  .n_errors = ARRAY_LEN(esp_decrypt_error_strings),
+  .error_strings = esp_decrypt_error_strings,
+
+  .sibling_of = "esp4-decrypt",
+};
+
+VLIB_REGISTER_NODE (esp6_decrypt_post_node) = {
+  .name = "esp6-decrypt-post",
+  .vector_size = sizeof (u32),
+  .format_trace = format_esp_decrypt_trace,
+  .type = VLIB_NODE_TYPE_INTERNAL,
+
+  .n_errors = ARRAY_LEN(esp_decrypt_error_strings),
+  .error_strings = esp_decrypt_error_strings,
+
+  .sibling_of = "esp6-decrypt",
+};
+
+VLIB_REGISTER_NODE (esp4_decrypt_tun_post_node) = {
+  .name = "esp4-decrypt-tun-post",
+  .vector_size = sizeof (u32),
+  .format_trace = format_esp_decrypt_trace,
+  .type = VLIB_NODE_TYPE_INTERNAL,
+
+  .n_errors = ARRAY_LEN(esp_decrypt_error_strings),
+  .error_strings = esp_decrypt_error_strings,
+
+  .sibling_of = "esp4-decrypt-tun",
+};
+
+VLIB_REGISTER_NODE (esp6_decrypt_tun_post_node) = {
+  .name = "esp6-decrypt-tun-post",
+  .vector_size = sizeof (u32),
+  .format_trace = format_esp_decrypt_trace,
+  .type = VLIB_NODE_TYPE_INTERNAL,
+
+  .n_errors = ARRAY_LEN(esp_decrypt_error_strings),
+  .error_strings = esp_decrypt_error_strings,
+
+  .sibling_of = "esp6-decrypt-tun",
+};
+
 /* *INDENT-ON* */
 
 /*
@@ -43,7 +43,7 @@ typedef enum
  _(RX_PKTS, "ESP pkts received")                                \
  _(SEQ_CYCLED, "sequence number cycled (packet dropped)")       \
  _(CRYPTO_ENGINE_ERROR, "crypto engine error (packet dropped)") \
- _(CHAINED_BUFFER, "chained buffers (packet dropped)")          \
+ _(NO_BUFFERS, "no buffers (packet dropped)")                  \
  _(NO_TRAILER_SPACE, "no trailer space (packet dropped)")
 
 typedef enum
@@ -87,15 +87,15 @@ format_esp_encrypt_trace (u8 * s, va_list * args)
   return s;
 }
 
+static const u8 pad_data[ESP_MAX_BLOCK_SIZE] = {
+  0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+  0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x00, 0x00,
+};
+
 /* pad packet in input buffer */
 static_always_inline u8 *
 esp_add_footer_and_icv (vlib_buffer_t * b, u8 block_size, u8 icv_sz)
 {
-  static const u8 pad_data[ESP_MAX_BLOCK_SIZE] = {
-    0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
-    0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x00, 0x00,
-  };
-
   u16 min_length = b->current_length + sizeof (esp_footer_t);
   u16 new_length = round_pow2 (min_length, block_size);
   u8 pad_bytes = new_length - min_length;
@@ -110,6 +110,104 @@ esp_add_footer_and_icv (vlib_buffer_t * b, u8 block_size, u8 icv_sz)
   return &f->next_header;
 }
 
+static_always_inline int
+esp_trailer_icv_overflow (vlib_node_runtime_t * node, vlib_buffer_t * b,
+			  u16 * next, u16 buffer_data_size)
+{
+  if (b->current_data + b->current_length <= buffer_data_size)
+    return 0;
+
+  b->current_length -= buffer_data_size - b->current_data;
+  b->error = node->errors[ESP_ENCRYPT_ERROR_NO_TRAILER_SPACE];
+  next[0] = ESP_ENCRYPT_NEXT_DROP;
+  return 1;
+}
+
+/*
+ * pad a buffer chain, the trailer goes at the end of the last buffer or
+ * into a newly allocated one if it does not fit there. Returns 0 if no
+ * buffer could be allocated.
+ */
+static_always_inline u8 *
+esp_add_footer_and_icv_chain (vlib_main_t * vm, vlib_buffer_t * b,
+			      vlib_buffer_t ** last, u8 block_size,
+			      u8 icv_sz, u16 buffer_data_size)
+{
+  vlib_buffer_t *lb = b;
+  u16 min_length = vlib_buffer_length_in_chain (vm, b) +
+    sizeof (esp_footer_t);
+  u16 new_length = round_pow2 (min_length, block_size);
+  u8 pad_bytes = new_length - min_length;
+  u16 tail_sz = pad_bytes + sizeof (esp_footer_t) + icv_sz;
+  esp_footer_t *f;
+
+  while (lb->flags & VLIB_BUFFER_NEXT_PRESENT)
+    lb = vlib_get_buffer (vm, lb->next_buffer);
+
+  /* leave room for the ESN high bits appended for the ICV calculation */
+  if (lb->current_data + lb->current_length + tail_sz + sizeof (u32) >
+      buffer_data_size)
+    {
+      vlib_buffer_t *nb;
+      u32 bi;
+
+      if (vlib_buffer_alloc (vm, &bi, 1) != 1)
+	return 0;
+
+      nb = vlib_get_buffer (vm, bi);
+      nb->current_data = 0;
+      nb->current_length = 0;
+      nb->flags = 0;
+      lb->next_buffer = bi;
+      lb->flags |= VLIB_BUFFER_NEXT_PRESENT;
+      lb = nb;
+    }
+
+  f = (esp_footer_t *) (vlib_buffer_get_tail (lb) + pad_bytes);
+
+  if (pad_bytes)
+    clib_memcpy_fast ((u8 *) f - pad_bytes, pad_data, pad_bytes);
+
+  f->pad_length = pad_bytes;
+  lb->current_length += tail_sz;
+  b->total_length_not_including_first_buffer += tail_sz;
+  *last = lb;
+  return &f->next_header;
+}
+
+/* add the ESP trailer, returns 0 if the packet has to be dropped */
+static_always_inline u8 *
+esp_add_trailer (vlib_main_t * vm, vlib_node_runtime_t * node,
+		 vlib_buffer_t * b, vlib_buffer_t ** last, u16 * payload_len,
+		 u16 * next, u8 block_sz, u8 icv_sz, u16 buffer_data_size)
+{
+  u8 *next_hdr_ptr;
+
+  *last = b;
+
+  if (PREDICT_TRUE ((b->flags & VLIB_BUFFER_NEXT_PRESENT) == 0))
+    {
+      next_hdr_ptr = esp_add_footer_and_icv (b, block_sz, icv_sz);
+      *payload_len = b->current_length;
+
+      if (esp_trailer_icv_overflow (node, b, next, buffer_data_size))
+	return 0;
+      return next_hdr_ptr;
+    }
+
+  next_hdr_ptr = esp_add_footer_and_icv_chain (vm, b, last, block_sz,
+					       icv_sz, buffer_data_size);
+  if (PREDICT_FALSE (next_hdr_ptr == 0))
+    {
+      b->error = node->errors[ESP_ENCRYPT_ERROR_NO_BUFFERS];
+      next[0] = ESP_ENCRYPT_NEXT_DROP;
+      return 0;
+    }
+
+  *payload_len = vlib_buffer_length_in_chain (vm, b);
+  return next_hdr_ptr;
+}
+
 static_always_inline void
 esp_update_ip4_hdr (ip4_header_t * ip4, u16 len, int is_transport, int is_udp)
 {
@@ -186,22 +284,10 @@ esp_get_ip6_hdr_len (ip6_header_t * ip6)
   return len;
 }
 
-static_always_inline int
-esp_trailer_icv_overflow (vlib_node_runtime_t * node, vlib_buffer_t * b,
-			  u16 * next, u16 buffer_data_size)
-{
-  if (b->current_data + b->current_length <= buffer_data_size)
-    return 0;
-
-  b->current_length -= buffer_data_size - b->current_data;
-  b->error = node->errors[ESP_ENCRYPT_ERROR_NO_TRAILER_SPACE];
-  next[0] = ESP_ENCRYPT_NEXT_DROP;
-  return 1;
-}
-
 static_always_inline void
 esp_process_ops (vlib_main_t * vm, vlib_node_runtime_t * node,
-		 vnet_crypto_op_t * ops, vlib_buffer_t * b[], u16 * nexts)
+		 vnet_crypto_op_t * ops, vlib_buffer_t * b[], u16 * nexts,
+		 vnet_crypto_op_chunk_t * chunks)
 {
   u32 n_fail, n_ops = vec_len (ops);
   vnet_crypto_op_t *op = ops;
@@ -209,7 +295,10 @@ esp_process_ops (vlib_main_t * vm, vlib_node_runtime_t * node,
   if (n_ops == 0)
     return;
 
-  n_fail = n_ops - vnet_crypto_process_ops (vm, op, n_ops);
+  if (chunks)
+    n_fail = n_ops - vnet_crypto_process_chained_ops (vm, op, chunks, n_ops);
+  else
+    n_fail = n_ops - vnet_crypto_process_ops (vm, op, n_ops);
 
   while (n_fail)
     {
@@ -251,16 +340,32 @@ esp_encrypt_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
   u32 current_sa_bytes = 0, spi = 0;
   u8 block_sz = 0, iv_sz = 0, icv_sz = 0;
   ipsec_sa_t *sa0 = 0;
+  vnet_crypto_async_frame_t *async_frame = 0;
+  u16 async_pkts[VNET_CRYPTO_FRAME_SIZE];
+  u16 post_next = 0;
+  int is_async = 0;
 
   vlib_get_buffers (vm, from, b, n_left);
   vec_reset_length (ptd->crypto_ops);
   vec_reset_length (ptd->integ_ops);
+  vec_reset_length (ptd->chained_crypto_ops);
+  vec_reset_length (ptd->chained_integ_ops);
+  vec_reset_length (ptd->chunks);
+
+  if (PREDICT_FALSE (im->async_mode && vnet_crypto_async_is_active ()))
+    {
+      async_frame = vnet_crypto_async_get_frame (vm);
+      post_next = esp_async_post_next (im, 1, is_ip6, is_tun);
+      is_async = 1;
+    }
 
   while (n_left > 0)
     {
       u32 sa_index0;
       dpo_id_t *dpo;
       esp_header_t *esp;
+      vlib_buffer_t *lb;
+      vnet_crypto_async_frame_t *af;
       u8 *payload, *next_hdr_ptr;
       u16 payload_len;
       u32 hdr_len;
@@ -304,13 +409,6 @@ esp_encrypt_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 	  iv_sz = sa0->crypto_iv_size;
 	}
 
-      if (vlib_buffer_chain_linearize (vm, b[0]) != 1)
-	{
-	  b[0]->error = node->errors[ESP_ENCRYPT_ERROR_CHAINED_BUFFER];
-	  next[0] = ESP_ENCRYPT_NEXT_DROP;
-	  goto trace;
-	}
-
       if (PREDICT_FALSE (esp_seq_advance (sa0)))
 	{
 	  b[0]->error = node->errors[ESP_ENCRYPT_ERROR_SEQ_CYCLED];
@@ -324,10 +422,10 @@ esp_encrypt_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
       if (ipsec_sa_is_set_IS_TUNNEL (sa0))
 	{
 	  payload = vlib_buffer_get_current (b[0]);
-	  next_hdr_ptr = esp_add_footer_and_icv (b[0], block_sz, icv_sz);
-	  payload_len = b[0]->current_length;
-
-	  if (esp_trailer_icv_overflow (node, b[0], next, buffer_data_size))
+	  next_hdr_ptr = esp_add_trailer (vm, node, b[0], &lb, &payload_len,
+					  next, block_sz, icv_sz,
+					  buffer_data_size);
+	  if (!next_hdr_ptr)
 	    goto trace;
 
 	  /* ESP header */
@@ -387,10 +485,10 @@ esp_encrypt_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 
 	  vlib_buffer_advance (b[0], ip_len);
 	  payload = vlib_buffer_get_current (b[0]);
-	  next_hdr_ptr = esp_add_footer_and_icv (b[0], block_sz, icv_sz);
-	  payload_len = b[0]->current_length;
-
-	  if (esp_trailer_icv_overflow (node, b[0], next, buffer_data_size))
+	  next_hdr_ptr = esp_add_trailer (vm, node, b[0], &lb, &payload_len,
+					  next, block_sz, icv_sz,
+					  buffer_data_size);
+	  if (!next_hdr_ptr)
 	    goto trace;
 
 	  /* ESP header */
@@ -454,15 +552,32 @@ esp_encrypt_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
       esp->spi = spi;
       esp->seq = clib_net_to_host_u32 (sa0->seq);
 
+      /* async frames carry no chunks, chains are always done in place */
+      af = lb == b[0] ? async_frame : 0;
+
       if (sa0->crypto_enc_op_id)
 	{
 	  vnet_crypto_op_t *op;
-	  vec_add2_aligned (ptd->crypto_ops, op, 1, CLIB_CACHE_LINE_BYTES);
-	  vnet_crypto_op_init (op, sa0->crypto_enc_op_id);
+	  if (af)
+	    op = vnet_crypto_async_add_crypto_op (af, sa0->crypto_enc_op_id);
+	  else
+	    {
+	      if (lb == b[0])
+		vec_add2_aligned (ptd->crypto_ops, op, 1,
+				  CLIB_CACHE_LINE_BYTES);
+	      else
+		vec_add2_aligned (ptd->chained_crypto_ops, op, 1,
+				  CLIB_CACHE_LINE_BYTES);
+	      vnet_crypto_op_init (op, sa0->crypto_enc_op_id);
+	      op->user_data = b - bufs;
+	    }
 	  op->src = op->dst = payload;
 	  op->key_index = sa0->crypto_key_index;
 	  op->len = payload_len - icv_sz;
-	  op->user_data = b - bufs;
+
+	  if (lb != b[0])
+	    esp_chain_chunks_fill (vm, op, &ptd->chunks, b[0], payload,
+				   op->len);
 
 	  if (ipsec_sa_is_set_IS_AEAD (sa0))
 	    {
@@ -474,38 +589,65 @@ esp_encrypt_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 
 	      esp_aad_fill (op, esp, sa0);
 
-	      op->tag = payload + op->len;
+	      op->tag = vlib_buffer_get_tail (lb) - icv_sz;
 	      op->tag_len = 16;
 
 	      u64 *iv = (u64 *) (payload - iv_sz);
-	      nonce->salt = sa0->salt;
-	      nonce->iv = *iv = clib_host_to_net_u64 (sa0->gcm_iv_counter++);
-	      op->iv = (u8 *) nonce;
-	      nonce++;
+	      esp_gcm_nonce_t *n = nonce;
+
+	      /* async ops outlive this frame, keep the nonce in the
+		 scratch space in front of the AAD */
+	      if (af)
+		n = (esp_gcm_nonce_t *) (op->aad - sizeof (*n));
+	      else
+		nonce++;
+
+	      n->salt = sa0->salt;
+	      n->iv = *iv = clib_host_to_net_u64 (sa0->gcm_iv_counter++);
+	      op->iv = (u8 *) n;
 	    }
 	  else
 	    {
 	      op->iv = payload - iv_sz;
-	      op->flags = VNET_CRYPTO_OP_FLAG_INIT_IV;
+	      op->flags |= VNET_CRYPTO_OP_FLAG_INIT_IV;
 	    }
 	}
 
       if (sa0->integ_op_id)
 	{
 	  vnet_crypto_op_t *op;
-	  vec_add2_aligned (ptd->integ_ops, op, 1, CLIB_CACHE_LINE_BYTES);
-	  vnet_crypto_op_init (op, sa0->integ_op_id);
+	  if (af)
+	    op = vnet_crypto_async_add_integ_op (af, sa0->integ_op_id);
+	  else
+	    {
+	      if (lb == b[0])
+		vec_add2_aligned (ptd->integ_ops, op, 1,
+				  CLIB_CACHE_LINE_BYTES);
+	      else
+		vec_add2_aligned (ptd->chained_integ_ops, op, 1,
+				  CLIB_CACHE_LINE_BYTES);
+	      vnet_crypto_op_init (op, sa0->integ_op_id);
+	      op->user_data = b - bufs;
+	    }
 	  op->src = payload - iv_sz - sizeof (esp_header_t);
-	  op->digest = payload + payload_len - icv_sz;
+	  op->digest = vlib_buffer_get_tail (lb) - icv_sz;
 	  op->key_index = sa0->integ_key_index;
 	  op->digest_len = icv_sz;
 	  op->len = payload_len - icv_sz + iv_sz + sizeof (esp_header_t);
-	  op->user_data = b - bufs;
+
+	  if (lb != b[0])
+	    esp_chain_chunks_fill (vm, op, &ptd->chunks, b[0], op->src,
+				   op->len);
+
 	  if (ipsec_sa_is_set_USE_ESN (sa0))
 	    {
 	      u32 seq_hi = clib_net_to_host_u32 (sa0->seq_hi);
 	      clib_memcpy_fast (op->digest, &seq_hi, sizeof (seq_hi));
 	      op->len += sizeof (seq_hi);
+	      /* the digest directly follows the data in the last buffer */
+	      if (lb != b[0])
+		ptd->chunks[op->chunk_index + op->n_chunks - 1].len +=
+		  sizeof (seq_hi);
 	    }
 	}
 
@@ -514,6 +656,24 @@ esp_encrypt_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
       current_sa_packets += 1;
       current_sa_bytes += payload_len;
 
+      if (af)
+	{
+	  esp_post_data (b[0])->next_index = next[0];
+	  async_pkts[async_frame->n_elts] = b - bufs;
+	  next[0] = ESP_NEXT_ASYNC;
+
+	  if (vnet_crypto_async_add_elt (async_frame, from[b - bufs],
+					 post_next))
+	    {
+	      esp_async_submit_frame (vm, node, async_frame, async_pkts,
+				      bufs, nexts,
+				      ESP_ENCRYPT_ERROR_CRYPTO_ENGINE_ERROR,
+				      ESP_ENCRYPT_NEXT_DROP);
+	      /* falls back to the synchronous path if the pool is empty */
+	      async_frame = vnet_crypto_async_get_frame (vm);
+	    }
+	}
+
     trace:
       if (PREDICT_FALSE (b[0]->flags & VLIB_BUFFER_IS_TRACED))
 	{
@@ -535,12 +695,73 @@ esp_encrypt_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
   vlib_increment_combined_counter (&ipsec_sa_counters, thread_index,
 				   current_sa_index, current_sa_packets,
 				   current_sa_bytes);
-  esp_process_ops (vm, node, ptd->crypto_ops, bufs, nexts);
-  esp_process_ops (vm, node, ptd->integ_ops, bufs, nexts);
+  if (async_frame)
+    esp_async_submit_frame (vm, node, async_frame, async_pkts, bufs, nexts,
+			    ESP_ENCRYPT_ERROR_CRYPTO_ENGINE_ERROR,
+			    ESP_ENCRYPT_NEXT_DROP);
+
+  esp_process_ops (vm, node, ptd->crypto_ops, bufs, nexts, 0);
+  esp_process_ops (vm, node, ptd->chained_crypto_ops, bufs, nexts,
+		   ptd->chunks);
+  esp_process_ops (vm, node, ptd->integ_ops, bufs, nexts, 0);
+  esp_process_ops (vm, node, ptd->chained_integ_ops, bufs, nexts,
+		   ptd->chunks);
 
   vlib_node_increment_counter (vm, node->node_index,
 			       ESP_ENCRYPT_ERROR_RX_PKTS, frame->n_vectors);
 
+  if (is_async)
+    {
+      u32 sync_bi[VLIB_FRAME_SIZE], n_sync;
+      n_sync = esp_async_filter_sync (from, nexts, sync_bi,
+				      frame->n_vectors);
+      vlib_buffer_enqueue_to_next (vm, node, sync_bi, nexts, n_sync);
+    }
+  else
+    vlib_buffer_enqueue_to_next (vm, node, from, nexts, frame->n_vectors);
+  return frame->n_vectors;
+}
+
+/* runs after crypto-dispatch for packets encrypted asynchronously */
+always_inline uword
+esp_encrypt_post_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
+			 vlib_frame_t * frame)
+{
+  u32 *from = vlib_frame_vector_args (frame);
+  u32 n_left = frame->n_vectors;
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b = bufs;
+  u16 nexts[VLIB_FRAME_SIZE], *next = nexts;
+
+  vlib_get_buffers (vm, from, b, n_left);
+
+  while (n_left >= 4)
+    {
+      if (n_left >= 8)
+	{
+	  vlib_prefetch_buffer_header (b[4], LOAD);
+	  vlib_prefetch_buffer_header (b[5], LOAD);
+	  vlib_prefetch_buffer_header (b[6], LOAD);
+	  vlib_prefetch_buffer_header (b[7], LOAD);
+	}
+
+      next[0] = esp_post_data (b[0])->next_index;
+      next[1] = esp_post_data (b[1])->next_index;
+      next[2] = esp_post_data (b[2])->next_index;
+      next[3] = esp_post_data (b[3])->next_index;
+
+      next += 4;
+      b += 4;
+      n_left -= 4;
+    }
+
+  while (n_left > 0)
+    {
+      next[0] = esp_post_data (b[0])->next_index;
+      next += 1;
+      b += 1;
+      n_left -= 1;
+    }
+
   vlib_buffer_enqueue_to_next (vm, node, from, nexts, frame->n_vectors);
   return frame->n_vectors;
 }
@@ -571,6 +792,22 @@ VLIB_REGISTER_NODE (esp4_encrypt_node) = {
 };
 /* *INDENT-ON* */
 
+VLIB_NODE_FN (esp4_encrypt_post_node) (vlib_main_t * vm,
+				       vlib_node_runtime_t * node,
+				       vlib_frame_t * from_frame)
+{
+  return esp_encrypt_post_inline (vm, node, from_frame);
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (esp4_encrypt_post_node) = {
+  .name = "esp4-encrypt-post",
+  .vector_size = sizeof (u32),
+  .type = VLIB_NODE_TYPE_INTERNAL,
+  .sibling_of = "esp4-encrypt",
+};
+/* *INDENT-ON* */
+
 VLIB_NODE_FN (esp6_encrypt_node) (vlib_main_t * vm,
 				  vlib_node_runtime_t * node,
 				  vlib_frame_t * from_frame)
@@ -597,6 +834,22 @@ VLIB_REGISTER_NODE (esp6_encrypt_node) = {
 };
 /* *INDENT-ON* */
 
+VLIB_NODE_FN (esp6_encrypt_post_node) (vlib_main_t * vm,
+				       vlib_node_runtime_t * node,
+				       vlib_frame_t * from_frame)
+{
+  return esp_encrypt_post_inline (vm, node, from_frame);
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (esp6_encrypt_post_node) = {
+  .name = "esp6-encrypt-post",
+  .vector_size = sizeof (u32),
+  .type = VLIB_NODE_TYPE_INTERNAL,
+  .sibling_of = "esp6-encrypt",
+};
+/* *INDENT-ON* */
+
 VLIB_NODE_FN (esp4_encrypt_tun_node) (vlib_main_t * vm,
 				      vlib_node_runtime_t * node,
 				      vlib_frame_t * from_frame)
@@ -635,6 +888,22 @@ VNET_FEATURE_INIT (esp4_ethernet_encrypt_tun_feat_node, static) =
 };
 /* *INDENT-ON* */
 
+VLIB_NODE_FN (esp4_encrypt_tun_post_node) (vlib_main_t * vm,
+					   vlib_node_runtime_t * node,
+					   vlib_frame_t * from_frame)
+{
+  return esp_encrypt_post_inline (vm, node, from_frame);
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (esp4_encrypt_tun_post_node) = {
+  .name = "esp4-encrypt-tun-post",
+  .vector_size = sizeof (u32),
+  .type = VLIB_NODE_TYPE_INTERNAL,
+  .sibling_of = "esp4-encrypt-tun",
+};
+/* *INDENT-ON* */
+
 VLIB_NODE_FN (esp6_encrypt_tun_node) (vlib_main_t * vm,
 				      vlib_node_runtime_t * node,
 				      vlib_frame_t * from_frame)
@@ -666,6 +935,22 @@ VNET_FEATURE_INIT (esp6_encrypt_tun_feat_node, static) =
 };
 /* *INDENT-ON* */
 
+VLIB_NODE_FN (esp6_encrypt_tun_post_node) (vlib_main_t * vm,
+					   vlib_node_runtime_t * node,
+					   vlib_frame_t * from_frame)
+{
+  return esp_encrypt_post_inline (vm, node, from_frame);
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (esp6_encrypt_tun_post_node) = {
+  .name = "esp6-encrypt-tun-post",
+  .vector_size = sizeof (u32),
+  .type = VLIB_NODE_TYPE_INTERNAL,
+  .sibling_of = "esp6-encrypt-tun",
+};
+/* *INDENT-ON* */
+
 typedef struct
 {
   u32 sa_index;
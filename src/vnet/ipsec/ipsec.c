@@ -263,6 +263,46 @@ ipsec_select_esp_backend (ipsec_main_t * im, u32 backend_idx)
   return 0;
 }
 
+int
+ipsec_set_async_mode (u32 is_enabled)
+{
+  ipsec_main_t *im = &ipsec_main;
+
+  if (im->async_mode == is_enabled)
+    return 0;
+
+  if (vnet_crypto_request_async_mode (is_enabled))
+    return VNET_API_ERROR_UNSUPPORTED;
+
+  im->async_mode = is_enabled;
+  return 0;
+}
+
+static void
+ipsec_register_esp_post_nodes (vlib_main_t * vm, ipsec_main_t * im)
+{
+  /* *INDENT-OFF* */
+  static char *post_nodes[2][2][2] = {
+    [0][0][0] = "esp4-decrypt-post",
+    [0][0][1] = "esp4-decrypt-tun-post",
+    [0][1][0] = "esp6-decrypt-post",
+    [0][1][1] = "esp6-decrypt-tun-post",
+    [1][0][0] = "esp4-encrypt-post",
+    [1][0][1] = "esp4-encrypt-tun-post",
+    [1][1][0] = "esp6-encrypt-post",
+    [1][1][1] = "esp6-encrypt-tun-post",
+  };
+  /* *INDENT-ON* */
+  int is_enc, is_ip6, is_tun;
+
+  for (is_enc = 0; is_enc < 2; is_enc++)
+    for (is_ip6 = 0; is_ip6 < 2; is_ip6++)
+      for (is_tun = 0; is_tun < 2; is_tun++)
+	im->esp_post_next[is_enc][is_ip6][is_tun] =
+	  vnet_crypto_register_post_node (vm,
+					  post_nodes[is_enc][is_ip6][is_tun]);
+}
+
 static clib_error_t *
 ipsec_init (vlib_main_t * vm)
 {
@@ -401,11 +441,53 @@ ipsec_init (vlib_main_t * vm)
 
   vec_validate_aligned (im->ptd, vlib_num_workers (), CLIB_CACHE_LINE_BYTES);
 
+  im->spd_flow_cache_size = IPSEC_SPD_FLOW_CACHE_DEFAULT_SIZE;
+  im->spd_flow_cache_epoch = 1;
+
+  ipsec_register_esp_post_nodes (vm, im);
+
   return 0;
 }
 
 VLIB_INIT_FUNCTION (ipsec_init);
 
+static clib_error_t *
+ipsec_config (vlib_main_t * vm, unformat_input_t * input)
+{
+  ipsec_main_t *im = &ipsec_main;
+  ipsec_per_thread_data_t *ptd;
+  u32 size = im->spd_flow_cache_size;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "spd-flow-cache-size %u", &size))
+	;
+      else if (unformat (input, "no-spd-flow-cache"))
+	size = 0;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (size)
+    size = 1 << max_log2 (size);
+  im->spd_flow_cache_size = size;
+
+  if (size == 0)
+    return 0;
+
+  vec_foreach (ptd, im->ptd)
+  {
+    vec_validate_aligned (ptd->spd_flow_cache.entries, size - 1,
+			  CLIB_CACHE_LINE_BYTES);
+    ptd->spd_flow_cache.mask = size - 1;
+  }
+
+  return 0;
+}
+
+VLIB_CONFIG_FUNCTION (ipsec_config, "ipsec");
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
@@ -21,6 +21,7 @@
 
 #include <vppinfra/types.h>
 #include <vppinfra/cache.h>
+#include <vppinfra/xxhash.h>
 
 #include <vnet/ipsec/ipsec_spd.h>
 #include <vnet/ipsec/ipsec_spd_policy.h>
@@ -83,10 +84,18 @@ typedef struct
   u8 icv_size;
 } ipsec_main_integ_alg_t;
 
+#define IPSEC_SPD_FLOW_CACHE_DEFAULT_SIZE (1 << 13)
+
 typedef struct
 {
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
   vnet_crypto_op_t *crypto_ops;
   vnet_crypto_op_t *integ_ops;
+  /* ops on buffer chains, their data is described by the chunks vector */
+  vnet_crypto_op_t *chained_crypto_ops;
+  vnet_crypto_op_t *chained_integ_ops;
+  vnet_crypto_op_chunk_t *chunks;
+  ipsec_spd_flow_cache_t spd_flow_cache;
 } ipsec_per_thread_data_t;
 
 typedef struct
@@ -146,6 +155,11 @@ typedef struct
   u32 esp4_no_crypto_tun_feature_index;
   u32 esp6_no_crypto_tun_feature_index;
 
+  /* async crypto: crypto-dispatch next indices of the ESP post nodes,
+     indexed by [is_encrypt][is_ip6][is_tun] */
+  u16 esp_post_next[2][2][2];
+  u8 async_mode;
+
   /* pool of ah backends */
   ipsec_ah_backend_t *ah_backends;
   /* pool of esp backends */
@@ -167,6 +181,11 @@ typedef struct
 
   /* per-thread data */
   ipsec_per_thread_data_t *ptd;
+
+  /* SPD flow cache entries per thread, 0 if disabled */
+  u32 spd_flow_cache_size;
+  /* bumped on every policy change to invalidate all flow caches */
+  u32 spd_flow_cache_epoch;
 } ipsec_main_t;
 
 typedef enum ipsec_format_flags_t_
@@ -193,6 +212,8 @@ extern vlib_node_registration_t ah6_decrypt_node;
 extern vlib_node_registration_t ipsec4_if_input_node;
 extern vlib_node_registration_t ipsec6_if_input_node;
 
+int ipsec_set_async_mode (u32 is_enabled);
+
 /*
  * functions
  */
@@ -248,6 +269,62 @@ ipsec_sa_get (u32 sa_index)
 void ipsec_add_feature (const char *arc_name, const char *node_name,
 			u32 * out_feature_index);
 
+/**
+ * @brief Find the SPD flow cache slot for the key
+ *
+ * Returns 0 if the cache is disabled. Otherwise *hit tells whether the
+ * slot holds a current result for the key; if not, the caller does the
+ * full policy scan and records the result with
+ * ipsec_spd_flow_cache_update().
+ */
+always_inline ipsec_spd_flow_cache_entry_t *
+ipsec_spd_flow_cache_lookup (ipsec_spd_flow_cache_entry_t * k, int *hit)
+{
+  ipsec_main_t *im = &ipsec_main;
+  ipsec_spd_flow_cache_t *fc;
+  ipsec_spd_flow_cache_entry_t *e;
+  u64 h;
+
+  fc = &im->ptd[vlib_get_thread_index ()].spd_flow_cache;
+  if (PREDICT_FALSE (fc->entries == 0))
+    return 0;
+
+  h = k->key[0] ^ k->key[1] ^ k->key[2] ^ k->key[3] ^ k->key[4] ^ k->key[5];
+  e = fc->entries + (clib_xxhash (h) & fc->mask);
+
+  *hit = (e->epoch == im->spd_flow_cache_epoch &&
+	  ((e->key[0] ^ k->key[0]) | (e->key[1] ^ k->key[1]) |
+	   (e->key[2] ^ k->key[2]) | (e->key[3] ^ k->key[3]) |
+	   (e->key[4] ^ k->key[4]) | (e->key[5] ^ k->key[5])) == 0);
+
+  if (*hit)
+    fc->hits++;
+  else
+    fc->misses++;
+
+  return e;
+}
+
+always_inline void
+ipsec_spd_flow_cache_update (ipsec_spd_flow_cache_entry_t * e,
+			     ipsec_spd_flow_cache_entry_t * k,
+			     ipsec_policy_t * p)
+{
+  ipsec_main_t *im = &ipsec_main;
+
+  clib_memcpy_fast (e->key, k->key, sizeof (e->key));
+  e->policy_index = p ? p - im->policies : ~0;
+  e->epoch = im->spd_flow_cache_epoch;
+}
+
+always_inline ipsec_policy_t *
+ipsec_spd_flow_cache_policy (ipsec_spd_flow_cache_entry_t * e)
+{
+  if (e->policy_index == ~0)
+    return 0;
+  return pool_elt_at_index (ipsec_main.policies, e->policy_index);
+}
+
 #endif /* __IPSEC_H__ */
 
 /*
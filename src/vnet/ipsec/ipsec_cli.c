@@ -527,6 +527,51 @@ VLIB_CLI_COMMAND (show_ipsec_spd_command, static) = {
 };
 /* *INDENT-ON* */
 
+static clib_error_t *
+show_ipsec_spd_flow_cache_command_fn (vlib_main_t * vm,
+				      unformat_input_t * input,
+				      vlib_cli_command_t * cmd)
+{
+  ipsec_main_t *im = &ipsec_main;
+  ipsec_spd_flow_cache_t *fc;
+  u64 hits = 0, misses = 0;
+  u32 i;
+
+  if (im->spd_flow_cache_size == 0)
+    {
+      vlib_cli_output (vm, "SPD flow cache disabled");
+      return 0;
+    }
+
+  vlib_cli_output (vm, "SPD flow cache: %u entries per thread, epoch %u",
+		   im->spd_flow_cache_size, im->spd_flow_cache_epoch);
+  vlib_cli_output (vm, "%-10s%-16s%-16s%s", "Thread", "Hits", "Misses",
+		   "Hit rate");
+
+  vec_foreach_index (i, im->ptd)
+  {
+    fc = &im->ptd[i].spd_flow_cache;
+    vlib_cli_output (vm, "%-10u%-16lu%-16lu%.2f%%", i, fc->hits, fc->misses,
+		     fc->hits + fc->misses ?
+		     100.0 * fc->hits / (fc->hits + fc->misses) : 0.0);
+    hits += fc->hits;
+    misses += fc->misses;
+  }
+
+  vlib_cli_output (vm, "%-10s%-16lu%-16lu%.2f%%", "Total", hits, misses,
+		   hits + misses ? 100.0 * hits / (hits + misses) : 0.0);
+
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_ipsec_spd_flow_cache_command, static) = {
+    .path = "show ipsec spd flow-cache",
+    .short_help = "show ipsec spd flow-cache",
+    .function = show_ipsec_spd_flow_cache_command_fn,
+};
+/* *INDENT-ON* */
+
 static clib_error_t *
 show_ipsec_tunnel_command_fn (vlib_main_t * vm,
 			      unformat_input_t * input,
@@ -700,9 +745,17 @@ clear_ipsec_counters_command_fn (vlib_main_t * vm,
 				 unformat_input_t * input,
 				 vlib_cli_command_t * cmd)
 {
+  ipsec_per_thread_data_t *ptd;
+
   vlib_clear_combined_counters (&ipsec_spd_policy_counters);
   vlib_clear_combined_counters (&ipsec_sa_counters);
 
+  vec_foreach (ptd, ipsec_main.ptd)
+  {
+    ptd->spd_flow_cache.hits = 0;
+    ptd->spd_flow_cache.misses = 0;
+  }
+
   return (NULL);
 }
 
@@ -714,6 +767,47 @@ VLIB_CLI_COMMAND (clear_ipsec_counters_command, static) = {
 };
 /* *INDENT-ON* */
 
+static clib_error_t *
+set_async_mode_command_fn (vlib_main_t * vm, unformat_input_t * input,
+			   vlib_cli_command_t * cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  clib_error_t *error;
+  int async_enable = 0;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return clib_error_return (0, "'on' or 'off' expected");
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "on"))
+	async_enable = 1;
+      else if (unformat (line_input, "off"))
+	async_enable = 0;
+      else
+	{
+	  error = clib_error_return (0, "unknown input '%U'",
+				     format_unformat_error, line_input);
+	  unformat_free (line_input);
+	  return error;
+	}
+    }
+  unformat_free (line_input);
+
+  if (ipsec_set_async_mode (async_enable))
+    return clib_error_return (0, "no async crypto engine available");
+
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (set_async_mode_command, static) = {
+    .path = "set ipsec async mode",
+    .short_help = "set ipsec async mode on|off",
+    .function = set_async_mode_command_fn,
+};
+/* *INDENT-ON* */
+
 static clib_error_t *
 create_ipsec_tunnel_command_fn (vlib_main_t * vm,
 				unformat_input_t * input,
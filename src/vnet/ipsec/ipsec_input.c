@@ -69,7 +69,7 @@ format_ipsec_input_trace (u8 * s, va_list * args)
 }
 
 always_inline ipsec_policy_t *
-ipsec_input_protect_policy_match (ipsec_spd_t * spd, u32 sa, u32 da, u32 spi)
+ipsec_input_protect_policy_scan (ipsec_spd_t * spd, u32 sa, u32 da, u32 spi)
 {
   ipsec_main_t *im = &ipsec_main;
   ipsec_policy_t *p;
@@ -123,9 +123,9 @@ ip6_addr_match_range (ip6_address_t * a, ip6_address_t * la,
 }
 
 always_inline ipsec_policy_t *
-ipsec6_input_protect_policy_match (ipsec_spd_t * spd,
-				   ip6_address_t * sa,
-				   ip6_address_t * da, u32 spi)
+ipsec6_input_protect_policy_scan (ipsec_spd_t * spd,
+				  ip6_address_t * sa,
+				  ip6_address_t * da, u32 spi)
 {
   ipsec_main_t *im = &ipsec_main;
   ipsec_policy_t *p;
@@ -162,6 +162,60 @@ ipsec6_input_protect_policy_match (ipsec_spd_t * spd,
   return 0;
 }
 
+always_inline ipsec_policy_t *
+ipsec_input_protect_policy_match (ipsec_spd_t * spd, u32 sa, u32 da, u32 spi)
+{
+  ipsec_main_t *im = &ipsec_main;
+  ipsec_spd_flow_cache_entry_t k = { }, *e;
+  ipsec_policy_t *p;
+  int hit;
+
+  k.laddr.ip4.as_u32 = da;
+  k.raddr.ip4.as_u32 = sa;
+  k.spi = spi;
+  k.spd_index = spd - im->spds;
+  k.type = IPSEC_SPD_POLICY_IP4_INBOUND_PROTECT;
+
+  e = ipsec_spd_flow_cache_lookup (&k, &hit);
+  if (PREDICT_TRUE (e && hit))
+    return ipsec_spd_flow_cache_policy (e);
+
+  p = ipsec_input_protect_policy_scan (spd, sa, da, spi);
+
+  if (e)
+    ipsec_spd_flow_cache_update (e, &k, p);
+
+  return p;
+}
+
+always_inline ipsec_policy_t *
+ipsec6_input_protect_policy_match (ipsec_spd_t * spd,
+				   ip6_address_t * sa,
+				   ip6_address_t * da, u32 spi)
+{
+  ipsec_main_t *im = &ipsec_main;
+  ipsec_spd_flow_cache_entry_t k = { }, *e;
+  ipsec_policy_t *p;
+  int hit;
+
+  k.laddr.ip6 = *da;
+  k.raddr.ip6 = *sa;
+  k.spi = spi;
+  k.spd_index = spd - im->spds;
+  k.type = IPSEC_SPD_POLICY_IP6_INBOUND_PROTECT;
+
+  e = ipsec_spd_flow_cache_lookup (&k, &hit);
+  if (PREDICT_TRUE (e && hit))
+    return ipsec_spd_flow_cache_policy (e);
+
+  p = ipsec6_input_protect_policy_scan (spd, sa, da, spi);
+
+  if (e)
+    ipsec_spd_flow_cache_update (e, &k, p);
+
+  return p;
+}
+
 static vlib_node_registration_t ipsec4_input_node;
 
 VLIB_NODE_FN (ipsec4_input_node) (vlib_main_t * vm,
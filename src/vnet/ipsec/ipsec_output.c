@@ -66,16 +66,13 @@ format_ipsec_output_trace (u8 * s, va_list * args)
 }
 
 always_inline ipsec_policy_t *
-ipsec_output_policy_match (ipsec_spd_t * spd, u8 pr, u32 la, u32 ra, u16 lp,
-			   u16 rp)
+ipsec_output_policy_scan (ipsec_spd_t * spd, u8 pr, u32 la, u32 ra, u16 lp,
+			  u16 rp)
 {
   ipsec_main_t *im = &ipsec_main;
   ipsec_policy_t *p;
   u32 *i;
 
-  if (!spd)
-    return 0;
-
   vec_foreach (i, spd->policies[IPSEC_SPD_POLICY_IP4_OUTBOUND])
   {
     p = pool_elt_at_index (im->policies, *i);
@@ -127,17 +124,14 @@ ip6_addr_match_range (ip6_address_t * a, ip6_address_t * la,
 }
 
 always_inline ipsec_policy_t *
-ipsec6_output_policy_match (ipsec_spd_t * spd,
-			    ip6_address_t * la,
-			    ip6_address_t * ra, u16 lp, u16 rp, u8 pr)
+ipsec6_output_policy_scan (ipsec_spd_t * spd,
+			   ip6_address_t * la,
+			   ip6_address_t * ra, u16 lp, u16 rp, u8 pr)
 {
   ipsec_main_t *im = &ipsec_main;
   ipsec_policy_t *p;
   u32 *i;
 
-  if (!spd)
-    return 0;
-
   vec_foreach (i, spd->policies[IPSEC_SPD_POLICY_IP6_OUTBOUND])
   {
     p = pool_elt_at_index (im->policies, *i);
@@ -173,6 +167,86 @@ ipsec6_output_policy_match (ipsec_spd_t * spd,
   return 0;
 }
 
+always_inline int
+ipsec_output_policy_has_ports (u8 pr)
+{
+  return (pr == IP_PROTOCOL_TCP || pr == IP_PROTOCOL_UDP ||
+	  pr == IP_PROTOCOL_SCTP);
+}
+
+always_inline ipsec_policy_t *
+ipsec_output_policy_match (ipsec_spd_t * spd, u8 pr, u32 la, u32 ra, u16 lp,
+			   u16 rp)
+{
+  ipsec_main_t *im = &ipsec_main;
+  ipsec_spd_flow_cache_entry_t k = { }, *e;
+  ipsec_policy_t *p;
+  int hit;
+
+  if (!spd)
+    return 0;
+
+  k.laddr.ip4.as_u32 = la;
+  k.raddr.ip4.as_u32 = ra;
+  /* ports are not looked at for other protocols, so keep them out of
+     the key to let all such packets of a flow share one entry */
+  if (ipsec_output_policy_has_ports (pr))
+    {
+      k.lport = lp;
+      k.rport = rp;
+    }
+  k.spd_index = spd - im->spds;
+  k.protocol = pr;
+  k.type = IPSEC_SPD_POLICY_IP4_OUTBOUND;
+
+  e = ipsec_spd_flow_cache_lookup (&k, &hit);
+  if (PREDICT_TRUE (e && hit))
+    return ipsec_spd_flow_cache_policy (e);
+
+  p = ipsec_output_policy_scan (spd, pr, la, ra, lp, rp);
+
+  if (e)
+    ipsec_spd_flow_cache_update (e, &k, p);
+
+  return p;
+}
+
+always_inline ipsec_policy_t *
+ipsec6_output_policy_match (ipsec_spd_t * spd,
+			    ip6_address_t * la,
+			    ip6_address_t * ra, u16 lp, u16 rp, u8 pr)
+{
+  ipsec_main_t *im = &ipsec_main;
+  ipsec_spd_flow_cache_entry_t k = { }, *e;
+  ipsec_policy_t *p;
+  int hit;
+
+  if (!spd)
+    return 0;
+
+  k.laddr.ip6 = *la;
+  k.raddr.ip6 = *ra;
+  if (ipsec_output_policy_has_ports (pr))
+    {
+      k.lport = lp;
+      k.rport = rp;
+    }
+  k.spd_index = spd - im->spds;
+  k.protocol = pr;
+  k.type = IPSEC_SPD_POLICY_IP6_OUTBOUND;
+
+  e = ipsec_spd_flow_cache_lookup (&k, &hit);
+  if (PREDICT_TRUE (e && hit))
+    return ipsec_spd_flow_cache_policy (e);
+
+  p = ipsec6_output_policy_scan (spd, la, ra, lp, rp, pr);
+
+  if (e)
+    ipsec_spd_flow_cache_update (e, &k, p);
+
+  return p;
+}
+
 static inline uword
 ipsec_output_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 		     vlib_frame_t * from_frame, int is_ipv6)
@@ -47,6 +47,7 @@ ipsec_add_del_spd (vlib_main_t * vm, u32 spd_id, int is_add)
       foreach_ipsec_spd_policy_type
 #undef _
 	pool_put (im->spds, spd);
+      ipsec_spd_flow_cache_flush ();
     }
   else				/* create new SPD */
     {
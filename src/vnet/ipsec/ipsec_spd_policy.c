@@ -132,6 +132,23 @@ ipsec_policy_mk_type (bool is_outbound,
   return (-1);
 }
 
+void
+ipsec_spd_flow_cache_flush (void)
+{
+  ipsec_main_t *im = &ipsec_main;
+
+  /* workers are held at the barrier, so no lookup can see this half done.
+     Epoch 0 is never valid so that zeroed entries can never hit */
+  if (PREDICT_FALSE (++im->spd_flow_cache_epoch == 0))
+    {
+      ipsec_per_thread_data_t *ptd;
+
+      vec_foreach (ptd, im->ptd)
+	vec_zero (ptd->spd_flow_cache.entries);
+      im->spd_flow_cache_epoch = 1;
+    }
+}
+
 int
 ipsec_add_del_policy (vlib_main_t * vm,
 		      ipsec_policy_t * policy, int is_add, u32 * stat_index)
@@ -179,6 +196,7 @@ ipsec_add_del_policy (vlib_main_t * vm,
       vec_sort_with_function (spd->policies[policy->type],
 			      ipsec_spd_entry_sort);
       *stat_index = policy_index;
+      ipsec_spd_flow_cache_flush ();
     }
   else
     {
@@ -193,6 +211,7 @@ ipsec_add_del_policy (vlib_main_t * vm,
 	    vec_del1 (spd->policies[policy->type], ii);
 	    ipsec_sa_unlock (vp->sa_index);
 	    pool_put (im->policies, vp);
+	    ipsec_spd_flow_cache_flush ();
 	    break;
 	  }
       }
@@ -73,6 +73,53 @@ typedef struct ipsec_policy_t_
   u32 sa_index;
 } ipsec_policy_t;
 
+/**
+ * @brief A SPD flow cache entry
+ *
+ * Remembers the policy a flow matched in a SPD, or that it matched none.
+ * Entries are only valid while their epoch equals the global one; any
+ * policy or SPD change bumps that and so invalidates every cache at once.
+ */
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  union
+  {
+    struct
+    {
+      ip46_address_t laddr;
+      ip46_address_t raddr;
+      union
+      {
+	struct
+	{
+	  u16 lport;
+	  u16 rport;
+	};
+	u32 spi;
+      };
+      u32 spd_index;
+      u8 protocol;
+      u8 type;
+      u8 pad[6];
+    };
+    u64 key[6];
+  };
+  u32 policy_index;
+  u32 epoch;
+} ipsec_spd_flow_cache_entry_t;
+
+/**
+ * @brief A per-thread, direct mapped SPD flow cache
+ */
+typedef struct
+{
+  ipsec_spd_flow_cache_entry_t *entries;
+  u32 mask;
+  u64 hits;
+  u64 misses;
+} ipsec_spd_flow_cache_t;
+
 /**
  * @brief Add/Delete a SPD
  */
@@ -85,6 +132,7 @@ extern u8 *format_ipsec_policy_action (u8 * s, va_list * args);
 extern uword unformat_ipsec_policy_action (unformat_input_t * input,
 					   va_list * args);
 
+extern void ipsec_spd_flow_cache_flush (void);
 
 extern int ipsec_policy_mk_type (bool is_outbound,
 				 bool is_ipv6,
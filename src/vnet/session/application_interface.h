@@ -453,6 +453,19 @@ app_send_io_evt_to_vpp (svm_msg_q_t * mq, u32 session_index, u8 evt_type,
     }
 }
 
+always_inline void
+app_session_dgram_hdr_init (session_dgram_hdr_t * hdr,
+			    app_session_transport_t * at, u32 len)
+{
+  hdr->data_length = len;
+  hdr->data_offset = 0;
+  clib_memcpy_fast (&hdr->rmt_ip, &at->rmt_ip, sizeof (ip46_address_t));
+  hdr->is_ip4 = at->is_ip4;
+  hdr->rmt_port = at->rmt_port;
+  clib_memcpy_fast (&hdr->lcl_ip, &at->lcl_ip, sizeof (ip46_address_t));
+  hdr->lcl_port = at->lcl_port;
+}
+
 always_inline int
 app_send_dgram_raw (svm_fifo_t * f, app_session_transport_t * at,
 		    svm_msg_q_t * vpp_evt_q, u8 * data, u32 len, u8 evt_type,
@@ -460,6 +473,7 @@ app_send_dgram_raw (svm_fifo_t * f, app_session_transport_t * at,
 {
   u32 max_enqueue, actual_write;
   session_dgram_hdr_t hdr;
+  svm_fifo_seg_t segs[2];
   int rv;
 
   max_enqueue = svm_fifo_max_enqueue_prod (f);
@@ -468,17 +482,17 @@ app_send_dgram_raw (svm_fifo_t * f, app_session_transport_t * at,
 
   max_enqueue -= sizeof (session_dgram_hdr_t);
   actual_write = clib_min (len, max_enqueue);
-  hdr.data_length = actual_write;
-  hdr.data_offset = 0;
-  clib_memcpy_fast (&hdr.rmt_ip, &at->rmt_ip, sizeof (ip46_address_t));
-  hdr.is_ip4 = at->is_ip4;
-  hdr.rmt_port = at->rmt_port;
-  clib_memcpy_fast (&hdr.lcl_ip, &at->lcl_ip, sizeof (ip46_address_t));
-  hdr.lcl_port = at->lcl_port;
-  rv = svm_fifo_enqueue (f, sizeof (hdr), (u8 *) & hdr);
-  ASSERT (rv == sizeof (hdr));
-
-  rv = svm_fifo_enqueue (f, actual_write, data);
+  app_session_dgram_hdr_init (&hdr, at, actual_write);
+
+  /* Header and payload with one tail update */
+  segs[0].data = (u8 *) & hdr;
+  segs[0].len = sizeof (hdr);
+  segs[1].data = data;
+  segs[1].len = actual_write;
+  rv = svm_fifo_enqueue_segments (f, segs, 2, 0 /* allow_partial */ );
+  ASSERT (rv == sizeof (hdr) + actual_write);
+  rv -= sizeof (hdr);
+
   if (do_evt)
     {
       if (rv > 0 && svm_fifo_set_event (f))
@@ -569,6 +583,84 @@ app_recv_dgram (app_session_t * s, u8 * buf, u32 len)
   return app_recv_dgram_raw (s->rx_fifo, buf, len, &s->transport, 1, 0);
 }
 
+/** Datagram dequeued by @ref app_recv_dgrams_raw */
+typedef struct app_dgram_
+{
+  app_session_transport_t at;	/**< endpoints, unless read partially before */
+  u8 *data;			/**< payload, in the caller's buffer */
+  u32 len;			/**< payload length */
+} app_dgram_t;
+
+/**
+ * Dequeue up to n_dgrams datagrams into buf, moving fifo head only once
+ *
+ * Only whole datagrams are returned, packed back to back in buf, except
+ * for a first datagram larger than buf, which is returned truncated and
+ * the rest of it left in the fifo, as with @ref app_recv_dgram_raw.
+ *
+ * @param f		rx fifo
+ * @param dgs		array of datagrams to be filled
+ * @param n_dgrams	max number of datagrams to return
+ * @param buf		buffer the payloads are copied to
+ * @param len		length of buf
+ * @param clear_evt	flag that indicates if the fifo event should be unset
+ * @return		number of datagrams returned
+ */
+always_inline int
+app_recv_dgrams_raw (svm_fifo_t * f, app_dgram_t * dgs, u32 n_dgrams,
+		     u8 * buf, u32 len, u8 clear_evt)
+{
+  session_dgram_pre_hdr_t ph;
+  u32 max_deq, offset = 0, n_copied = 0;
+  int i;
+
+  if (clear_evt)
+    svm_fifo_unset_event (f);
+
+  max_deq = svm_fifo_max_dequeue_cons (f);
+
+  for (i = 0; i < n_dgrams; i++)
+    {
+      if (max_deq - offset < SESSION_CONN_HDR_LEN)
+	break;
+
+      svm_fifo_peek (f, offset, sizeof (ph), (u8 *) & ph);
+      ASSERT (ph.data_length >= ph.data_offset);
+      /* Producers enqueue headers and payloads together */
+      ASSERT (max_deq - offset >= SESSION_CONN_HDR_LEN + ph.data_length);
+
+      if (ph.data_length - ph.data_offset > len - n_copied)
+	{
+	  if (i)
+	    break;
+	  dgs[0].data = buf;
+	  dgs[0].len = app_recv_dgram_raw (f, buf, len, &dgs[0].at, 0, 0);
+	  return 1;
+	}
+
+      if (!ph.data_offset)
+	svm_fifo_peek (f, offset + sizeof (ph), sizeof (dgs[i].at),
+		       (u8 *) & dgs[i].at);
+      dgs[i].data = buf + n_copied;
+      dgs[i].len = ph.data_length - ph.data_offset;
+      svm_fifo_peek (f, offset + SESSION_CONN_HDR_LEN + ph.data_offset,
+		     dgs[i].len, dgs[i].data);
+      n_copied += dgs[i].len;
+      offset += SESSION_CONN_HDR_LEN + ph.data_length;
+    }
+
+  if (offset)
+    svm_fifo_dequeue_drop (f, offset);
+  return i;
+}
+
+always_inline int
+app_recv_dgrams (app_session_t * s, app_dgram_t * dgs, u32 n_dgrams,
+		 u8 * buf, u32 len)
+{
+  return app_recv_dgrams_raw (s->rx_fifo, dgs, n_dgrams, buf, len, 1);
+}
+
 always_inline int
 app_recv_stream_raw (svm_fifo_t * f, u8 * buf, u32 len, u8 clear_evt, u8 peek)
 {
@@ -151,6 +151,7 @@ segment_manager_add_segment (segment_manager_t * sm, u32 segment_size)
   /*
    * Initialize fifo segment
    */
+  fs->n_slices = vlib_num_workers () + 1;
   fifo_segment_init (fs);
 
   /*
@@ -475,26 +476,34 @@ segment_manager_del_sessions (segment_manager_t * sm)
   session_handle_t *handles = 0, *handle;
   session_t *session;
   svm_fifo_t *fifo;
+  u32 slice_index;
 
   ASSERT (pool_elts (sm->segments) != 0);
 
   /* Across all fifo segments used by the server */
   /* *INDENT-OFF* */
   segment_manager_foreach_segment_w_lock (fifo_segment, sm, ({
-    fifo = fifo_segment_get_fifo_list (fifo_segment);
-
-    /*
-     * Remove any residual sessions from the session lookup table
-     * Don't bother deleting the individual fifos, we're going to
-     * throw away the fifo segment in a minute.
-     */
-    while (fifo)
+    for (slice_index = 0; slice_index < fifo_segment_num_slices (fifo_segment);
+         slice_index++)
       {
-	session = session_get_if_valid (fifo->master_session_index,
-	                                fifo->master_thread_index);
-	if (session)
-	  vec_add1 (handles, session_handle (session));
-	fifo = fifo->next;
+        /* Owning threads may be freeing fifos while we walk the list */
+        fifo_segment_slice_lock (fifo_segment, slice_index);
+        fifo = fifo_segment_get_slice_fifo_list (fifo_segment, slice_index);
+
+        /*
+         * Remove any residual sessions from the session lookup table
+         * Don't bother deleting the individual fifos, we're going to
+         * throw away the fifo segment in a minute.
+         */
+        while (fifo)
+          {
+            session = session_get_if_valid (fifo->master_session_index,
+                                            fifo->master_thread_index);
+            if (session)
+              vec_add1 (handles, session_handle (session));
+            fifo = fifo->next;
+          }
+        fifo_segment_slice_unlock (fifo_segment, slice_index);
       }
 
     /* Instead of removing the segment, test when cleaning up disconnected
@@ -509,16 +518,19 @@ segment_manager_del_sessions (segment_manager_t * sm)
 
 int
 segment_manager_try_alloc_fifos (fifo_segment_t * fifo_segment,
+				 u32 thread_index,
 				 u32 rx_fifo_size, u32 tx_fifo_size,
 				 svm_fifo_t ** rx_fifo, svm_fifo_t ** tx_fifo)
 {
   rx_fifo_size = clib_max (rx_fifo_size, sm_main.default_fifo_size);
-  *rx_fifo = fifo_segment_alloc_fifo (fifo_segment, rx_fifo_size,
-				      FIFO_SEGMENT_RX_FIFO);
+  *rx_fifo = fifo_segment_alloc_fifo_w_slice (fifo_segment, thread_index,
+					      rx_fifo_size,
+					      FIFO_SEGMENT_RX_FIFO);
 
   tx_fifo_size = clib_max (tx_fifo_size, sm_main.default_fifo_size);
-  *tx_fifo = fifo_segment_alloc_fifo (fifo_segment, tx_fifo_size,
-				      FIFO_SEGMENT_TX_FIFO);
+  *tx_fifo = fifo_segment_alloc_fifo_w_slice (fifo_segment, thread_index,
+					      tx_fifo_size,
+					      FIFO_SEGMENT_TX_FIFO);
 
   if (*rx_fifo == 0)
     {
@@ -545,6 +557,7 @@ segment_manager_try_alloc_fifos (fifo_segment_t * fifo_segment,
 
 int
 segment_manager_alloc_session_fifos (segment_manager_t * sm,
+				     u32 thread_index,
 				     svm_fifo_t ** rx_fifo,
 				     svm_fifo_t ** tx_fifo)
 {
@@ -563,7 +576,7 @@ segment_manager_alloc_session_fifos (segment_manager_t * sm,
 
   /* *INDENT-OFF* */
   segment_manager_foreach_segment_w_lock (fs, sm, ({
-    alloc_fail = segment_manager_try_alloc_fifos (fs,
+    alloc_fail = segment_manager_try_alloc_fifos (fs, thread_index,
                                                   props->rx_fifo_size,
                                                   props->tx_fifo_size,
                                                   rx_fifo, tx_fifo);
@@ -617,7 +630,8 @@ alloc_check:
 	  return SESSION_ERROR_SEG_CREATE;
 	}
       fs = segment_manager_get_segment_w_lock (sm, new_fs_index);
-      alloc_fail = segment_manager_try_alloc_fifos (fs, props->rx_fifo_size,
+      alloc_fail = segment_manager_try_alloc_fifos (fs, thread_index,
+						    props->rx_fifo_size,
 						    props->tx_fifo_size,
 						    rx_fifo, tx_fifo);
       added_a_segment = 1;
@@ -762,6 +776,7 @@ segment_manager_alloc_queue (fifo_segment_t * segment,
   cfg->n_rings = 2;
   cfg->q_nitems = props->evt_q_size;
   cfg->ring_cfgs = rc;
+  cfg->flags = session_main.evt_qs_lock_free ? SVM_MSG_Q_F_LOCK_FREE : 0;
 
   oldheap = ssvm_push_heap (segment->ssvm.sh);
   q = svm_msg_q_alloc (cfg);
@@ -907,33 +922,46 @@ segment_manager_format_sessions (segment_manager_t * sm, int verbose)
 
   /* *INDENT-OFF* */
   pool_foreach (fifo_segment, sm->segments, ({
+    session_handle_t *handles = 0, *handle;
+    u32 slice_index;
     svm_fifo_t *fifo;
     u8 *str;
 
-    fifo = fifo_segment_get_fifo_list (fifo_segment);
-    while (fifo)
+    /* Collect the sessions with the slices locked, format them after */
+    for (slice_index = 0; slice_index < fifo_segment_num_slices (fifo_segment);
+         slice_index++)
       {
-        u32 session_index, thread_index;
-        session_t *session;
-
-        session_index = fifo->master_session_index;
-        thread_index = fifo->master_thread_index;
+        fifo_segment_slice_lock (fifo_segment, slice_index);
+        fifo = fifo_segment_get_slice_fifo_list (fifo_segment, slice_index);
+        while (fifo)
+          {
+            session_t *session;
+
+            session = session_get (fifo->master_session_index,
+                                   fifo->master_thread_index);
+            vec_add1 (handles, session_handle (session));
+            fifo = fifo->next;
+          }
+        fifo_segment_slice_unlock (fifo_segment, slice_index);
+      }
 
-        session = session_get (session_index, thread_index);
-        str = format (0, "%U", format_session, session, verbose);
+    vec_foreach (handle, handles)
+      {
+        str = format (0, "%U", format_session,
+                      session_get_from_handle (*handle), verbose);
 
         if (verbose)
           s = format (s, "%-40s%-20s%-15u%-10u", str, app_name,
-                      app_wrk->api_client_index, app_wrk->connects_seg_manager);
+                      app_wrk->api_client_index,
+                      app_wrk->connects_seg_manager);
         else
           s = format (s, "%-40s%-20s", str, app_name);
 
         vlib_cli_output (vm, "%v", s);
         vec_reset_length (s);
         vec_free (str);
-
-        fifo = fifo->next;
       }
+    vec_free (handles);
     vec_free (s);
   }));
   /* *INDENT-ON* */
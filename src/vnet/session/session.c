@@ -410,32 +410,64 @@ session_enqueue_stream_connection (transport_connection_t * tc,
   return enqueued;
 }
 
+/**
+ * Enqueue datagrams to session's rx fifo
+ *
+ * Headers and payloads, including buffer chains, are written with one
+ * fifo tail update, so the app never sees partial datagrams. All or none
+ * of the datagrams are enqueued, so callers must check that the fifo has
+ * room for all of them.
+ *
+ * @param s		session
+ * @param hdrs		array of datagram headers, one per buffer
+ * @param bufs		array of buffers with the datagrams' payloads
+ * @param n_dgrams	number of datagrams
+ * @param proto		transport proto of the session
+ * @param queue_event	flag that indicates if rx event should be queued
+ * @return		number of bytes enqueued, headers included, or error
+ */
 int
-session_enqueue_dgram_connection (session_t * s,
-				  session_dgram_hdr_t * hdr,
-				  vlib_buffer_t * b, u8 proto, u8 queue_event)
+session_enqueue_dgram_connection_batch (session_t * s,
+					session_dgram_hdr_t * hdrs,
+					vlib_buffer_t ** bufs, u32 n_dgrams,
+					u8 proto, u8 queue_event)
 {
-  int enqueued = 0, rv, in_order_off;
+  vlib_main_t *vm = vlib_get_main ();
+  session_worker_t *wrk;
+  svm_fifo_seg_t *seg;
+  vlib_buffer_t *b;
+  int enqueued;
+  u32 i;
 
-  ASSERT (svm_fifo_max_enqueue_prod (s->rx_fifo)
-	  >= b->current_length + sizeof (*hdr));
+  wrk = session_main_get_worker (vm->thread_index);
+  vec_reset_length (wrk->rx_dgram_segs);
 
-  svm_fifo_enqueue (s->rx_fifo, sizeof (session_dgram_hdr_t), (u8 *) hdr);
-  enqueued = svm_fifo_enqueue (s->rx_fifo, b->current_length,
-			       vlib_buffer_get_current (b));
-  if (PREDICT_FALSE ((b->flags & VLIB_BUFFER_NEXT_PRESENT) && enqueued >= 0))
+  for (i = 0; i < n_dgrams; i++)
     {
-      in_order_off = enqueued > b->current_length ? enqueued : 0;
-      rv = session_enqueue_chain_tail (s, b, in_order_off, 1);
-      if (rv > 0)
-	enqueued += rv;
+      vec_add2 (wrk->rx_dgram_segs, seg, 1);
+      seg->data = (u8 *) & hdrs[i];
+      seg->len = sizeof (session_dgram_hdr_t);
+
+      b = bufs[i];
+      while (1)
+	{
+	  vec_add2 (wrk->rx_dgram_segs, seg, 1);
+	  seg->data = vlib_buffer_get_current (b);
+	  seg->len = b->current_length;
+	  if (!(b->flags & VLIB_BUFFER_NEXT_PRESENT))
+	    break;
+	  b = vlib_get_buffer (vm, b->next_buffer);
+	}
     }
-  if (queue_event)
+
+  enqueued = svm_fifo_enqueue_segments (s->rx_fifo, wrk->rx_dgram_segs,
+					vec_len (wrk->rx_dgram_segs),
+					0 /* allow_partial */ );
+
+  if (queue_event && enqueued > 0)
     {
       /* Queue RX event on this fifo. Eventually these will need to be flushed
        * by calling stream_server_flush_enqueue_events () */
-      session_worker_t *wrk;
-
       wrk = session_main_get_worker (s->thread_index);
       if (!(s->flags & SESSION_F_RX_EVT))
 	{
@@ -446,6 +478,18 @@ session_enqueue_dgram_connection (session_t * s,
   return enqueued;
 }
 
+int
+session_enqueue_dgram_connection (session_t * s,
+				  session_dgram_hdr_t * hdr,
+				  vlib_buffer_t * b, u8 proto, u8 queue_event)
+{
+  ASSERT (svm_fifo_max_enqueue_prod (s->rx_fifo)
+	  >= hdr->data_length + sizeof (*hdr));
+
+  return session_enqueue_dgram_connection_batch (s, hdr, &b, 1, proto,
+						 queue_event);
+}
+
 int
 session_tx_fifo_peek_bytes (transport_connection_t * tc, u8 * buffer,
 			    u32 offset, u32 max_bytes)
@@ -1240,6 +1284,7 @@ session_vpp_event_queues_allocate (session_main_t * smm)
       cfg->n_rings = 2;
       cfg->q_nitems = evt_q_length;
       cfg->ring_cfgs = rc;
+      cfg->flags = smm->evt_qs_lock_free ? SVM_MSG_Q_F_LOCK_FREE : 0;
       smm->wrk[i].vpp_event_queue = svm_msg_q_alloc (cfg);
       if (smm->evt_qs_use_memfd_seg)
 	{
@@ -1591,6 +1636,8 @@ session_config_fn (vlib_main_t * vm, unformat_input_t * input)
 	;
       else if (unformat (input, "evt_qs_memfd_seg"))
 	smm->evt_qs_use_memfd_seg = 1;
+      else if (unformat (input, "evt_qs_lock_free"))
+	smm->evt_qs_lock_free = 1;
       else if (unformat (input, "evt_qs_seg_size %U", unformat_memory_size,
 			 &smm->evt_qs_segment_size))
 	;
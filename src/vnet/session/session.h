@@ -101,6 +101,9 @@ typedef struct session_worker_
   /** Peekers rw lock */
   clib_rwlock_t peekers_rw_locks;
 
+  /** Scratch fifo segments for batched dgram enqueues */
+  svm_fifo_seg_t *rx_dgram_segs;
+
   u32 last_tx_packets;
 
 } session_worker_t;
@@ -151,6 +154,9 @@ typedef struct session_main_
   uword evt_qs_segment_size;
   u8 evt_qs_use_memfd_seg;
 
+  /** Allocate vpp and app message queues in lock-free mode */
+  u8 evt_qs_lock_free;
+
   /** Session table size parameters */
   u32 configured_v4_session_table_buckets;
   u32 configured_v4_session_table_memory;
@@ -357,6 +363,11 @@ int session_enqueue_dgram_connection (session_t * s,
 				      session_dgram_hdr_t * hdr,
 				      vlib_buffer_t * b, u8 proto,
 				      u8 queue_event);
+int session_enqueue_dgram_connection_batch (session_t * s,
+					    session_dgram_hdr_t * hdrs,
+					    vlib_buffer_t ** bufs,
+					    u32 n_dgrams, u8 proto,
+					    u8 queue_event);
 int session_stream_connect_notify (transport_connection_t * tc, u8 is_fail);
 int session_dgram_connect_notify (transport_connection_t * tc,
 				  u32 old_thread_index,
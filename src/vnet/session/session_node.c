@@ -603,6 +603,13 @@ session_tx_set_dequeue_params (vlib_main_t * vm, session_tx_context_t * ctx,
       ctx->max_len_to_snd = ctx->snd_space;
     }
 
+  /* With tso, a segment is a gso super segment made of whole mss-sized
+   * segments that the nic or interface-output splits */
+  if (transport_connection_is_tso (ctx->tc))
+    ctx->snd_mss = clib_min (ctx->max_len_to_snd,
+			     TRANSPORT_MAX_GSO_SZ -
+			     TRANSPORT_MAX_GSO_SZ % ctx->snd_mss);
+
   /* Check if we're tx constrained by the node */
   ctx->n_segs_per_evt = ceil ((f64) ctx->max_len_to_snd / ctx->snd_mss);
   if (ctx->n_segs_per_evt > max_segs)
@@ -1050,11 +1057,14 @@ dump_thread_0_event_queue (void)
   int i, index;
 
   mq = smm->wrk[my_thread_index].vpp_event_queue;
-  index = mq->q->head;
+  /* lock-free queues use free running head counters */
+  index = (u32) mq->q->head % mq->q->maxsize;
 
   for (i = 0; i < mq->q->cursize; i++)
     {
       msg = (svm_msg_q_msg_t *) (&mq->q->data[0] + mq->q->elsize * index);
+      if (svm_msg_q_msg_is_invalid (msg))
+	break;
       ring = svm_msg_q_ring (mq, msg->ring_index);
       clib_memcpy_fast (e, svm_msg_q_msg_data (mq, msg), ring->elsize);
 
@@ -1144,10 +1154,13 @@ session_node_lookup_fifo_event (svm_fifo_t * f, session_event_t * e)
    * Search evt queue
    */
   mq = wrk->vpp_event_queue;
-  index = mq->q->head;
+  index = (u32) mq->q->head % mq->q->maxsize;
   for (i = 0; i < mq->q->cursize; i++)
     {
       msg = (svm_msg_q_msg_t *) (&mq->q->data[0] + mq->q->elsize * index);
+      /* reserved by a lock-free producer but not yet published */
+      if (svm_msg_q_msg_is_invalid (msg))
+	break;
       ring = svm_msg_q_ring (mq, msg->ring_index);
       clib_memcpy_fast (e, svm_msg_q_msg_data (mq, msg), ring->elsize);
       found = session_node_cmp_event (e, f);
@@ -234,6 +234,15 @@ transport_connection_is_tx_paced (transport_connection_t * tc)
   return (tc->flags & TRANSPORT_CONNECTION_F_IS_TX_PACED);
 }
 
+/**
+ * Check if transport connection can send gso segments
+ */
+always_inline u8
+transport_connection_is_tso (transport_connection_t * tc)
+{
+  return (tc->flags & TRANSPORT_CONNECTION_F_IS_TSO);
+}
+
 u8 *format_transport_pacer (u8 * s, va_list * args);
 
 /**
@@ -21,6 +21,8 @@
 #include <vnet/tcp/tcp_debug.h>
 
 #define TRANSPORT_MAX_HDRS_LEN    100	/* Max number of bytes for headers */
+#define TRANSPORT_MAX_GSO_SZ	(65535 - TRANSPORT_MAX_HDRS_LEN) /* Max gso
+							      payload */
 
 typedef enum transport_dequeue_type_
 {
@@ -45,6 +47,9 @@ typedef enum transport_connection_flags_
   TRANSPORT_CONNECTION_F_NO_LOOKUP = 1 << 1, /**< Don't register connection in lookup
 						  Does not apply to local apps and
 						  transports using the network layer (udp/tcp) */
+  TRANSPORT_CONNECTION_F_IS_TSO = 1 << 2, /**< Transport accepts segments larger
+					       than its mss and relies on
+					       gso to split them */
 } transport_connection_flags_t;
 
 typedef struct _transport_stats
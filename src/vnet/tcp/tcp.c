@@ -74,6 +74,8 @@ static void
 tcp_cc_init (tcp_connection_t * tc)
 {
   tc->cc_algo = tcp_cc_algo_get (tcp_main.cc_algo);
+  if (tc->cc_algo->flags & TCP_CC_ALGO_F_RATE_SAMPLE)
+    tc->flags |= TCP_CONN_RATE_SAMPLE;
   tc->cc_algo->init (tc);
 }
 
@@ -136,6 +138,7 @@ tcp_connection_bind (u32 session_index, transport_endpoint_t * lcl)
   listener->c_s_index = session_index;
   listener->c_fib_index = lcl->fib_index;
   listener->state = TCP_STATE_LISTEN;
+  listener->listener_gen = ++tm->listener_gen;
 
   tcp_connection_timers_init (listener);
 
@@ -247,6 +250,8 @@ tcp_connection_cleanup (tcp_connection_t * tc)
   transport_endpoint_cleanup (TRANSPORT_PROTO_TCP, &tc->c_lcl_ip,
 			      tc->c_lcl_port);
 
+  tcp_connection_listener_release (tc);
+
   /* Check if connection is not yet fully established */
   if (tc->state == TCP_STATE_SYN_SENT)
     {
@@ -321,6 +326,30 @@ tcp_connection_free (tcp_connection_t * tc)
   pool_put (tm->connections[tc->c_thread_index], tc);
 }
 
+/**
+ * Stop counting connection as half-open against its listener
+ */
+void
+tcp_connection_listener_release (tcp_connection_t * tc)
+{
+  tcp_main_t *tm = &tcp_main;
+  tcp_connection_t *lc;
+
+  if (!(tc->flags & TCP_CONN_HALF_OPEN_LISTEN))
+    return;
+
+  tc->flags &= ~TCP_CONN_HALF_OPEN_LISTEN;
+  if (pool_is_free_index (tm->listener_pool, tc->listener_index))
+    return;
+
+  /* the listener that accepted us may be gone, its index reused */
+  lc = tcp_listener_get (tc->listener_index);
+  if (lc->listener_gen != tc->listener_gen)
+    return;
+
+  clib_atomic_fetch_sub_rel (&lc->n_half_open, 1);
+}
+
 /** Notify session that connection has been reset.
  *
  * Switch state to closed and wait for session to call cleanup.
@@ -476,6 +505,7 @@ tcp_connection_timers_init (tcp_connection_t * tc)
     {
       tc->timers[i] = TCP_TIMER_HANDLE_INVALID;
     }
+  tc->rack.timer = TCP_TIMER_HANDLE_INVALID;
 
   tc->rto = TCP_RTO_INIT;
 }
@@ -491,6 +521,7 @@ tcp_connection_timers_reset (tcp_connection_t * tc)
     {
       tcp_timer_reset (tc, i);
     }
+  tcp_rack_timer_reset (tc);
 }
 
 #if 0
@@ -632,6 +663,145 @@ tcp_init_snd_vars (tcp_connection_t * tc)
   tc->srtt = 0;
 }
 
+/*
+ * SYN cookies as per rfc4987. The cookie is used as iss and encodes a
+ * coarse timestamp in its top 8 bits and the index of the peer's mss in
+ * a small table in its low 24 bits. Both are protected by hashes of the
+ * connection's endpoints keyed by the iss seed. Window scale and sack
+ * permitted don't fit so they are carried in the low bits of our SYN-ACK
+ * tsval, if the peer uses timestamps.
+ */
+
+/** Cookie counter period, approximately 64s in TCP ticks */
+#define TCP_SYN_COOKIE_COUNT_SHIFT	16
+/** Max age of a valid cookie, in counter periods */
+#define TCP_SYN_COOKIE_MAX_AGE		2
+/** Tsval bits used to carry options */
+#define TCP_SYN_COOKIE_TS_BITS		5
+#define TCP_SYN_COOKIE_TS_MASK		((1 << TCP_SYN_COOKIE_TS_BITS) - 1)
+#define TCP_SYN_COOKIE_TS_WSCALE_NONE	0xf
+#define TCP_SYN_COOKIE_TS_SACK		(1 << 4)
+
+static const u16 tcp_syn_cookie_mss_table[] = {
+  536, 1220, 1300, 1420, 1440, 1460, 8940, 8960
+};
+
+static u32
+tcp_syn_cookie_hash (tcp_connection_t * tc, u32 count)
+{
+  tcp_main_t *tm = &tcp_main;
+  u64 tmp;
+
+  if (tc->c_is_ip4)
+    tmp = (u64) tc->c_lcl_ip.ip4.as_u32 << 32 | (u64) tc->c_rmt_ip.ip4.as_u32;
+  else
+    tmp = tc->c_lcl_ip.ip6.as_u64[0] ^ tc->c_lcl_ip.ip6.as_u64[1]
+      ^ tc->c_rmt_ip.ip6.as_u64[0] ^ tc->c_rmt_ip.ip6.as_u64[1];
+
+  tmp ^= tm->iss_seed.second ^ ((u64) tc->c_lcl_port << 16 | tc->c_rmt_port);
+  tmp = clib_xxhash (tmp ^ tm->iss_seed.first ^ count);
+  return ((tmp >> 32) ^ (tmp & 0xffffffff));
+}
+
+static inline u32
+tcp_syn_cookie_count (void)
+{
+  return (tcp_time_now () >> TCP_SYN_COOKIE_COUNT_SHIFT) & 0xff;
+}
+
+/**
+ * Generate SYN cookie for connection
+ *
+ * @param tc connection with endpoints initialized
+ * @param irs peer's initial sequence number
+ * @param mss peer's mss. Rounded down to the mss that is encoded
+ * @return cookie to be used as iss
+ */
+u32
+tcp_syn_cookie_make (tcp_connection_t * tc, u32 irs, u16 * mss)
+{
+  u32 count = tcp_syn_cookie_count ();
+  int i;
+
+  for (i = ARRAY_LEN (tcp_syn_cookie_mss_table) - 1; i > 0; i--)
+    if (*mss >= tcp_syn_cookie_mss_table[i])
+      break;
+  *mss = tcp_syn_cookie_mss_table[i];
+
+  return (tcp_syn_cookie_hash (tc, 0) + irs + (count << 24)
+	  + ((tcp_syn_cookie_hash (tc, count) + i) & 0xffffff));
+}
+
+/**
+ * Validate SYN cookie acked by peer
+ *
+ * @param tc connection with endpoints initialized
+ * @param irs peer's initial sequence number, i.e., ack seq - 1
+ * @param cookie cookie to validate, i.e., ack number - 1
+ * @param mss mss encoded in cookie, if valid
+ * @return 0 if cookie is valid, -1 otherwise
+ */
+int
+tcp_syn_cookie_check (tcp_connection_t * tc, u32 irs, u32 cookie, u16 * mss)
+{
+  u32 count = tcp_syn_cookie_count (), diff, index;
+
+  cookie -= tcp_syn_cookie_hash (tc, 0) + irs;
+  diff = (count - (cookie >> 24)) & 0xff;
+  if (diff >= TCP_SYN_COOKIE_MAX_AGE)
+    return -1;
+
+  index = (cookie - tcp_syn_cookie_hash (tc, (count - diff) & 0xff)) & 0xffffff;
+  if (index >= ARRAY_LEN (tcp_syn_cookie_mss_table))
+    return -1;
+
+  *mss = tcp_syn_cookie_mss_table[index];
+  return 0;
+}
+
+/**
+ * Tsval for SYN-ACK that carries a cookie. Encodes options in low bits.
+ *
+ * The tsval is never ahead of now. The connection created from the
+ * cookie ack sends tsvals of now, which must not be lower than the one
+ * the peer saw in the SYN-ACK, or its PAWS check drops them.
+ */
+u32
+tcp_syn_cookie_tsval (tcp_options_t * opts)
+{
+  u32 now = tcp_time_now (), tsval = now & ~TCP_SYN_COOKIE_TS_MASK;
+
+  if (tcp_opts_wscale (opts))
+    tsval |= opts->wscale & 0xf;
+  else
+    tsval |= TCP_SYN_COOKIE_TS_WSCALE_NONE;
+  if (tcp_opts_sack_permitted (opts))
+    tsval |= TCP_SYN_COOKIE_TS_SACK;
+
+  /* 0 is never sent, it stands for no tsecr in the cookie ack */
+  if (timestamp_lt (now, tsval) || !tsval)
+    tsval -= 1 << TCP_SYN_COOKIE_TS_BITS;
+
+  return tsval;
+}
+
+/**
+ * Recover options negotiated in SYN from tsecr echoed with cookie ack
+ */
+void
+tcp_syn_cookie_tsecr_opts (u32 tsecr, tcp_options_t * opts)
+{
+  u8 wscale = tsecr & 0xf;
+
+  if (wscale != TCP_SYN_COOKIE_TS_WSCALE_NONE)
+    {
+      opts->flags |= TCP_OPTS_FLAG_WSCALE;
+      opts->wscale = clib_min (wscale, TCP_MAX_WND_SCALE);
+    }
+  if (tsecr & TCP_SYN_COOKIE_TS_SACK)
+    opts->flags |= TCP_OPTS_FLAG_SACK_PERMITTED;
+}
+
 void
 tcp_enable_pacing (tcp_connection_t * tc)
 {
@@ -643,6 +813,22 @@ tcp_enable_pacing (tcp_connection_t * tc)
   tc->mrtt_us = (u32) ~ 0;
 }
 
+/**
+ * Enable tso if gso segments can make it out of the node graph.
+ *
+ * ip rewrite nodes only skip the mtu check for gso packets, and
+ * interface-output only segments them, if at least one interface
+ * has gso enabled.
+ */
+static void
+tcp_check_gso (tcp_connection_t * tc)
+{
+  vnet_main_t *vnm = vnet_get_main ();
+
+  if (vnm->interface_main.gso_interface_count > 0)
+    tc->c_flags |= TRANSPORT_CONNECTION_F_IS_TSO;
+}
+
 /** Initialize tcp connection variables
  *
  * Should be called after having received a msg from the peer, i.e., a SYN or
@@ -663,11 +849,20 @@ tcp_connection_init_vars (tcp_connection_t * tc)
   /*  tcp_connection_fib_attach (tc); */
 
   if (transport_connection_is_tx_paced (&tc->connection)
-      || tcp_main.tx_pacing)
+      || tcp_main.tx_pacing || (tc->cc_algo->flags & TCP_CC_ALGO_F_PACING))
     tcp_enable_pacing (tc);
 
+  if (tcp_main.rack && tcp_opts_sack_permitted (&tc->rcv_opts))
+    {
+      tc->flags |= TCP_CONN_RACK | TCP_CONN_RATE_SAMPLE;
+      tcp_rack_init (tc);
+    }
+
   if (tc->flags & TCP_CONN_RATE_SAMPLE)
     tcp_bt_init (tc);
+
+  if (tcp_main.tso)
+    tcp_check_gso (tc);
 }
 
 static int
@@ -858,6 +1053,10 @@ format_tcp_congestion (u8 * s, va_list * args)
   s = format (s, "%Usnd_congestion %u dupack %u limited_transmit %u\n",
 	      format_white_space, indent, tc->snd_congestion - tc->iss,
 	      tc->rcv_dupacks, tc->limited_transmit - tc->iss);
+  if (tc->flags & TCP_CONN_RACK)
+    s = format (s, "%Urack rtt %.3f min_rtt %.3f end_seq %u tlp %u\n",
+		format_white_space, indent, tc->rack.rtt, tc->rack.min_rtt,
+		tc->rack.end_seq - tc->iss, tc->rack.tlp_pending);
   return s;
 }
 
@@ -1194,6 +1393,8 @@ tcp_update_time (f64 now, u8 thread_index)
 
   tcp_set_time_now (wrk);
   tw_timer_expire_timers_16t_2w_512sl (&wrk->timer_wheel, now);
+  if (tcp_main.rack)
+    tw_timer_expire_timers_16t_1w_2048sl (&wrk->rack_timer_wheel, now);
   tcp_do_fastretransmits (wrk);
   tcp_send_acks (wrk);
   tcp_flush_frames_to_output (wrk);
@@ -1245,6 +1446,10 @@ tcp_connection_tx_pacer_update (tcp_connection_t * tc)
   if (!transport_connection_is_tx_paced (&tc->connection))
     return;
 
+  /* Algorithm computes pacing rate on its own */
+  if (tc->cc_algo->flags & TCP_CC_ALGO_F_PACING)
+    return;
+
   srtt = clib_min ((f64) tc->srtt * TCP_TICK, tc->mrtt_us);
   /* TODO should constrain to interface's max throughput but
    * we don't have link speeds for sw ifs ..*/
@@ -1417,6 +1622,7 @@ tcp_expired_timers_dispatch (u32 * expired_timers)
 static void
 tcp_initialize_timer_wheels (tcp_main_t * tm)
 {
+  tw_timer_wheel_16t_1w_2048sl_t *rack_tw;
   tw_timer_wheel_16t_2w_512sl_t *tw;
   /* *INDENT-OFF* */
   foreach_vlib_main (({
@@ -1424,6 +1630,11 @@ tcp_initialize_timer_wheels (tcp_main_t * tm)
     tw_timer_wheel_init_16t_2w_512sl (tw, tcp_expired_timers_dispatch,
 				      100e-3 /* timer period 100ms */ , ~0);
     tw->last_run_time = vlib_time_now (this_vlib_main);
+    rack_tw = &tm->wrk_ctx[ii].rack_timer_wheel;
+    tw_timer_wheel_init_16t_1w_2048sl (rack_tw,
+				       tcp_rack_expired_timers_dispatch,
+				       TCP_RACK_TIMER_TICK, ~0);
+    rack_tw->last_run_time = vlib_time_now (this_vlib_main);
   }));
   /* *INDENT-ON* */
 }
@@ -1578,6 +1789,7 @@ tcp_init (vlib_main_t * vm)
   tm->cc_algo = TCP_CC_NEWRENO;
   tm->default_mtu = 1460;
   tm->initial_cwnd_multiplier = 0;
+  tm->syn_cookies_threshold = TCP_SYN_COOKIES_THRESHOLD;
   return 0;
 }
 
@@ -1652,6 +1864,15 @@ tcp_config_fn (vlib_main_t * vm, unformat_input_t * input)
 	;
       else if (unformat (input, "no-tx-pacing"))
 	tm->tx_pacing = 0;
+      else if (unformat (input, "tso"))
+	tm->tso = 1;
+      else if (unformat (input, "rack"))
+	tm->rack = 1;
+      else if (unformat (input, "syn-cookies-threshold %u",
+			 &tm->syn_cookies_threshold))
+	;
+      else if (unformat (input, "no-syn-cookies"))
+	tm->syn_cookies_threshold = 0;
       else if (unformat (input, "cc-algo %U", unformat_tcp_cc_algo,
 			 &tm->cc_algo))
 	;
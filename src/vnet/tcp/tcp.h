@@ -30,7 +30,7 @@
 #define TCP_PAWS_IDLE 24 * 24 * 60 * 60 * THZ /**< 24 days */
 #define TCP_FIB_RECHECK_PERIOD	1 * THZ	/**< Recheck every 1s */
 #define TCP_MAX_OPTION_SPACE 40
-#define TCP_CC_DATA_SZ 24
+#define TCP_CC_DATA_SZ 96
 
 #define TCP_DUPACK_THRESHOLD 	3
 #define TCP_MAX_RX_FIFO_SIZE 	32 << 20
@@ -114,6 +114,8 @@ extern timer_expiration_handler tcp_timer_retransmit_syn_handler;
 #define TCP_RTO_INIT 1 * THZ	/* Initial retransmit timer */
 #define TCP_RTO_BOFF_MAX 8	/* Max number of retries before reset */
 
+#define TCP_SYN_COOKIES_THRESHOLD 1024	/* Default listener half-opens */
+
 /** TCP connection flags */
 #define foreach_tcp_connection_flag             \
   _(SNDACK, "Send ACK")                         \
@@ -131,6 +133,8 @@ extern timer_expiration_handler tcp_timer_retransmit_syn_handler;
   _(RATE_SAMPLE, "Conn does rate sampling")	\
   _(TRACK_BURST, "Track burst")			\
   _(ZERO_RWND_SENT, "Zero RWND sent")		\
+  _(HALF_OPEN_LISTEN, "Counted in listener half-opens")	\
+  _(RACK, "RACK-TLP loss detection")		\
 
 typedef enum _tcp_connection_flag_bits
 {
@@ -279,13 +283,45 @@ typedef struct tcp_byte_tracker_
   u32 last_ooo;			/**< Cached last ooo sample */
 } tcp_byte_tracker_t;
 
+/** RACK-TLP timers, run on the worker's fine grained wheel */
+typedef enum tcp_rack_timer_
+{
+  TCP_RACK_TIMER_TLP,		/**< Tail loss probe timeout (PTO) */
+  TCP_RACK_TIMER_REO,		/**< Reordering window timeout */
+  TCP_RACK_N_TIMERS
+} tcp_rack_timer_e;
+
+#define TCP_RACK_TIMER_TICK	1e-3	/**< Rack timer wheel period (s) */
+#define TCP_TLP_MIN_PTO		10e-3	/**< Min probe timeout (s) */
+#define TCP_TLP_WC_DELACK	200e-3	/**< Worst case peer delayed ack */
+
+typedef struct tcp_rack_
+{
+  f64 xmit_ts;		/**< Tx time of most recently sent delivered seg */
+  f64 rtt;		/**< RTT of most recently sent delivered seg */
+  f64 min_rtt;		/**< Min RTT used to compute reordering window */
+  u32 end_seq;		/**< End seq of most recently sent delivered seg */
+  u32 timer;		/**< Handle of RACK or TLP timer */
+  u32 tlp_high_seq;	/**< snd_nxt when tail loss probe was sent */
+  u8 timer_id;		/**< Timer currently armed */
+  u8 tlp_pending;	/**< Tail loss probe not yet acked */
+  u8 tlp_is_rxt;	/**< Tail loss probe was a retransmission */
+} tcp_rack_t;
+
 typedef enum _tcp_cc_algorithm_type
 {
   TCP_CC_NEWRENO,
   TCP_CC_CUBIC,
-  TCP_CC_LAST = TCP_CC_CUBIC
+  TCP_CC_BBR,
+  TCP_CC_LAST = TCP_CC_BBR
 } tcp_cc_algorithm_type_e;
 
+typedef enum tcp_cc_algo_flags_
+{
+  TCP_CC_ALGO_F_RATE_SAMPLE = 1 << 0,	/**< Needs delivery rate samples */
+  TCP_CC_ALGO_F_PACING = 1 << 1,	/**< Sets its own pacing rate */
+} tcp_cc_algo_flags_e;
+
 typedef struct _tcp_cc_algorithm tcp_cc_algorithm_t;
 
 typedef enum _tcp_cc_ack_t
@@ -306,7 +342,7 @@ typedef struct _tcp_connection
   transport_connection_t connection;  /**< Common transport data. First! */
 
   u8 state;			/**< TCP state as per tcp_state_t */
-  u16 flags;			/**< Connection flags (see tcp_conn_flags_e) */
+  u32 flags;			/**< Connection flags (see tcp_conn_flags_e) */
   u32 timers[TCP_N_TIMERS];	/**< Timer handles into timer wheel */
 
   /* TODO RFC4898 */
@@ -385,12 +421,19 @@ typedef struct _tcp_connection
   u32 last_fib_check;	/**< Last time we checked fib route for peer */
   u16 mss;		/**< Our max seg size that includes options */
   u32 timestamp_delta;
+
+  tcp_rack_t rack;	/**< RACK-TLP loss detection state */
+
+  u32 listener_index;	/**< Listener that accepted us, while half-open */
+  u32 listener_gen;	/**< Generation of the listener, or of ours */
+  i32 n_half_open;	/**< Listener only. Children still in SYN_RCVD */
 } tcp_connection_t;
 
 /* *INDENT-OFF* */
 struct _tcp_cc_algorithm
 {
   const char *name;
+  u8 flags;			/**< See tcp_cc_algo_flags_e */
   uword (*unformat_cfg) (unformat_input_t * input);
   void (*init) (tcp_connection_t * tc);
   void (*cleanup) (tcp_connection_t * tc);
@@ -455,6 +498,9 @@ typedef struct tcp_worker_ctx_
   /** worker timer wheel */
   tw_timer_wheel_16t_2w_512sl_t timer_wheel;
 
+  /** fine grained timer wheel for RACK-TLP timers */
+  tw_timer_wheel_16t_1w_2048sl_t rack_timer_wheel;
+
   /** tx buffer free list */
   u32 *tx_buffers;
 
@@ -506,6 +552,10 @@ typedef struct _tcp_main
   /* Pool of listeners. */
   tcp_connection_t *listener_pool;
 
+  /** Last generation given to a listener. Tells a listener apart from
+   * the earlier ones that used the same pool index */
+  u32 listener_gen;
+
   /** Dispatch table by state and flags */
   tcp_lookup_dispatch_t dispatch_table[TCP_N_STATES][64];
 
@@ -565,6 +615,16 @@ typedef struct _tcp_main
   /** Enable tx pacing for new connections */
   u8 tx_pacing;
 
+  /** Allow gso segments on new connections, if interfaces support it */
+  u8 tso;
+
+  /** Use RACK-TLP loss detection on new sack connections */
+  u8 rack;
+
+  /** Half-open passive opens per listener above which SYN cookies are
+   *  used instead of allocating connections. 0 disables SYN cookies */
+  u32 syn_cookies_threshold;
+
   u8 punt_unknown4;
   u8 punt_unknown6;
 
@@ -661,6 +721,7 @@ int tcp_half_open_connection_cleanup (tcp_connection_t * tc);
 tcp_connection_t *tcp_connection_alloc (u8 thread_index);
 void tcp_connection_free (tcp_connection_t * tc);
 void tcp_connection_reset (tcp_connection_t * tc);
+void tcp_connection_listener_release (tcp_connection_t * tc);
 int tcp_configure_v4_source_address_range (vlib_main_t * vm,
 					   ip4_address_t * start,
 					   ip4_address_t * end, u32 table_id);
@@ -694,8 +755,13 @@ void tcp_send_reset_w_pkt (tcp_connection_t * tc, vlib_buffer_t * pkt,
 void tcp_send_reset (tcp_connection_t * tc);
 void tcp_send_syn (tcp_connection_t * tc);
 void tcp_send_synack (tcp_connection_t * tc);
+void tcp_send_synack_cookie (tcp_connection_t * tc);
 void tcp_send_fin (tcp_connection_t * tc);
+void tcp_send_tail_loss_probe (tcp_worker_ctx_t * wrk,
+			       tcp_connection_t * tc);
 void tcp_init_mss (tcp_connection_t * tc);
+void tcp_update_rcv_mss (tcp_connection_t * tc);
+u32 tcp_initial_window_to_advertise (tcp_connection_t * tc);
 void tcp_update_burst_snd_vars (tcp_connection_t * tc);
 void tcp_update_rto (tcp_connection_t * tc);
 void tcp_flush_frame_to_output (tcp_worker_ctx_t * wrk, u8 is_ip4);
@@ -768,6 +834,27 @@ void tcp_bt_check_app_limited (tcp_connection_t * tc);
  * @param bt	byte tracker
  */
 int tcp_bt_is_sane (tcp_byte_tracker_t * bt);
+/**
+ * Transmit time of the sample that tracks a sequence number
+ *
+ * @param tc	tcp connection
+ * @param seq	sequence number
+ * @return	tx time or 0 if no sample tracks seq
+ */
+f64 tcp_bt_seq_tx_time (tcp_connection_t * tc, u32 seq);
+
+/*
+ * RACK-TLP loss detection
+ */
+
+void tcp_rack_init (tcp_connection_t * tc);
+void tcp_rack_timer_reset (tcp_connection_t * tc);
+void tcp_rack_update (tcp_connection_t * tc, f64 xmit_ts, u32 end_seq,
+		      u8 is_rxt);
+u32 tcp_rack_detect_loss (tcp_connection_t * tc);
+void tcp_rack_tlp_schedule (tcp_connection_t * tc);
+void tcp_rack_tlp_rcv_ack (tcp_connection_t * tc, u32 ack);
+void tcp_rack_expired_timers_dispatch (u32 * expired_timers);
 
 always_inline u32
 tcp_end_seq (tcp_header_t * th, u32 len)
@@ -917,6 +1004,8 @@ int tcp_fast_retransmit (tcp_worker_ctx_t * wrk, tcp_connection_t * tc,
 			 u32 burst_size);
 void tcp_cc_init_congestion (tcp_connection_t * tc);
 void tcp_cc_fastrecovery_clear (tcp_connection_t * tc);
+void tcp_cc_fastrecovery_enter (tcp_connection_t * tc,
+				tcp_rate_sample_t * rs);
 
 fib_node_index_t tcp_lookup_rmt_in_fib (tcp_connection_t * tc);
 
@@ -965,6 +1054,11 @@ u32 tcp_session_push_header (transport_connection_t * tconn,
 void tcp_connection_timers_init (tcp_connection_t * tc);
 void tcp_connection_timers_reset (tcp_connection_t * tc);
 void tcp_init_snd_vars (tcp_connection_t * tc);
+u32 tcp_syn_cookie_make (tcp_connection_t * tc, u32 irs, u16 * mss);
+int tcp_syn_cookie_check (tcp_connection_t * tc, u32 irs, u32 cookie,
+			  u16 * mss);
+u32 tcp_syn_cookie_tsval (tcp_options_t * opts);
+void tcp_syn_cookie_tsecr_opts (u32 tsecr, tcp_options_t * opts);
 void tcp_connection_init_vars (tcp_connection_t * tc);
 void tcp_connection_tx_pacer_update (tcp_connection_t * tc);
 void tcp_connection_tx_pacer_reset (tcp_connection_t * tc, u32 window,
@@ -1202,6 +1296,71 @@ vlib_buffer_push_tcp (vlib_buffer_t * b, u16 sp_net, u16 dp_net, u32 seq,
 					 clib_host_to_net_u16 (wnd));
 }
 
+/** Max bytes coalesced into one enqueue */
+#define TCP_GRO_MAX_BYTES	(64 << 10)
+
+/**
+ * Segments of one connection, received in order, that are enqueued
+ * as a single buffer chain
+ */
+typedef struct tcp_gro_ctx_
+{
+  tcp_connection_t *tc;		/**< Connection segments belong to */
+  vlib_buffer_t *head;		/**< First segment and chain head */
+  vlib_buffer_t *tail;		/**< Last segment in chain */
+  u32 rcv_nxt;			/**< rcv_nxt before first segment */
+  u32 n_bytes;			/**< Data bytes in chain */
+  u32 n_segs;			/**< Segments in chain */
+} tcp_gro_ctx_t;
+
+/**
+ * Check if segment is plain in order data, in a single buffer, that
+ * can be appended to the connection's pending chain.
+ */
+always_inline u8
+tcp_gro_can_append (tcp_gro_ctx_t * gro, tcp_connection_t * tc,
+		    vlib_buffer_t * b, tcp_header_t * th)
+{
+  u32 data_len = vnet_buffer (b)->tcp.data_len;
+
+  return ((th->flags & ~TCP_FLAG_PSH) == TCP_FLAG_ACK && data_len
+	  && vnet_buffer (b)->tcp.seq_number == tc->rcv_nxt
+	  && !(b->flags & VLIB_BUFFER_NEXT_PRESENT)
+	  && b->current_length == vnet_buffer (b)->tcp.data_offset + data_len
+	  && (!gro->n_segs || (gro->tc == tc && gro->n_bytes + data_len
+			       <= TCP_GRO_MAX_BYTES)));
+}
+
+/**
+ * Link segment to the pending chain and advance rcv_nxt past it
+ */
+always_inline void
+tcp_gro_append (tcp_gro_ctx_t * gro, tcp_connection_t * tc,
+		vlib_buffer_t * b, u32 bi)
+{
+  u32 data_len = vnet_buffer (b)->tcp.data_len;
+
+  vlib_buffer_advance (b, vnet_buffer (b)->tcp.data_offset);
+  if (!gro->n_segs)
+    {
+      gro->tc = tc;
+      gro->head = b;
+      gro->rcv_nxt = tc->rcv_nxt;
+      gro->n_bytes = 0;
+    }
+  else
+    {
+      gro->tail->next_buffer = bi;
+      gro->tail->flags |= VLIB_BUFFER_NEXT_PRESENT;
+    }
+  gro->tail = b;
+  gro->n_bytes += data_len;
+  gro->n_segs += 1;
+
+  /* Segments that follow are validated as if data was enqueued */
+  tc->rcv_nxt += data_len;
+}
+
 #endif /* _vnet_tcp_h_ */
 
 /*
@@ -0,0 +1,586 @@
+/*
+ * Copyright (c) 2019 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * BBR congestion control, version 1, as described in
+ * draft-cardwell-iccrg-bbr-congestion-control-00. Bandwidth samples are
+ * provided by the byte tracker and the pacing rate is enforced by the
+ * transport tx pacer.
+ */
+
+#include <vnet/tcp/tcp.h>
+
+#define BBR_HIGH_GAIN		2.885	/**< 2/ln(2), doubles rate per round */
+#define BBR_DRAIN_GAIN		(1 / BBR_HIGH_GAIN)
+#define BBR_CWND_GAIN		2.0
+#define BBR_PACING_MARGIN	0.99	/**< Pace slightly below estimate */
+#define BBR_BW_FILTER_ROUNDS	10	/**< Max bw filter window, in rounds */
+#define BBR_MIN_RTT_WINDOW	10.0	/**< Min rtt filter window (s) */
+#define BBR_PROBE_RTT_TIME	0.2	/**< Time spent in probe rtt (s) */
+#define BBR_CYCLE_LEN		8
+#define BBR_FULL_BW_THRESH	1.25
+#define BBR_FULL_BW_ROUNDS	3
+#define BBR_MIN_PIPE_SEGS	4
+
+static const f64 bbr_pacing_gain_cycle[BBR_CYCLE_LEN] = {
+  1.25, 0.75, 1, 1, 1, 1, 1, 1
+};
+
+typedef enum bbr_mode_
+{
+  BBR_STARTUP,
+  BBR_DRAIN,
+  BBR_PROBE_BW,
+  BBR_PROBE_RTT,
+} __clib_packed bbr_mode_t;
+
+typedef enum bbr_flags_
+{
+  BBR_F_ROUND_START = 1 << 0,
+  BBR_F_FILLED_PIPE = 1 << 1,
+  BBR_F_PROBE_RTT_ROUND_DONE = 1 << 2,
+  BBR_F_PACKET_CONSERVATION = 1 << 3,
+  BBR_F_IDLE_RESTART = 1 << 4,
+  BBR_F_RESTORE_CWND = 1 << 5,
+} __clib_packed bbr_flags_t;
+
+typedef struct bbr_bw_sample_
+{
+  u64 bw;			/**< Delivery rate in bytes/s */
+  u32 round;			/**< Round the sample was taken in */
+} __clib_packed bbr_bw_sample_t;
+
+typedef struct bbr_data_
+{
+  /** Windowed max filter of delivery rate samples */
+  bbr_bw_sample_t bw_filter[3];
+
+  /** Min rtt (in sec) and time when it was last updated */
+  f64 min_rtt;
+  f64 min_rtt_stamp;
+
+  /** Time when probe rtt may be exited */
+  f64 probe_rtt_done_stamp;
+
+  /** Time current probe bw gain cycle phase started */
+  f64 cycle_stamp;
+
+  /** Delivered bytes that mark the end of the current round */
+  u64 next_round_delivered;
+
+  /** Max bw seen when pipe was last found to be growing */
+  u64 full_bw;
+
+  u32 round_count;
+  u32 prior_cwnd;
+  bbr_mode_t mode;
+  u8 cycle_index;
+  u8 full_bw_cnt;
+  bbr_flags_t flags;
+} __clib_packed bbr_data_t;
+
+STATIC_ASSERT (sizeof (bbr_data_t) <= TCP_CC_DATA_SZ, "bbr data len");
+
+static inline f64
+bbr_time (tcp_connection_t * tc)
+{
+  return tcp_time_now_us (tc->c_thread_index);
+}
+
+static inline u64
+bbr_max_bw (bbr_data_t * bd)
+{
+  return bd->bw_filter[0].bw;
+}
+
+/**
+ * Running max over the last BBR_BW_FILTER_ROUNDS rounds. Keeps the best,
+ * second best and third best samples in successive sub-windows, as per
+ * Kathleen Nichols' algorithm.
+ */
+static void
+bbr_max_bw_update (bbr_data_t * bd, u64 bw)
+{
+  bbr_bw_sample_t *s = bd->bw_filter, val;
+  u32 dt;
+
+  val.bw = bw;
+  val.round = bd->round_count;
+
+  if (bw >= s[0].bw || val.round - s[2].round > BBR_BW_FILTER_ROUNDS)
+    {
+      s[0] = s[1] = s[2] = val;
+      return;
+    }
+
+  if (bw >= s[1].bw)
+    s[2] = s[1] = val;
+  else if (bw >= s[2].bw)
+    s[2] = val;
+
+  dt = val.round - s[0].round;
+  if (dt > BBR_BW_FILTER_ROUNDS)
+    {
+      s[0] = s[1];
+      s[1] = s[2];
+      s[2] = val;
+      if (val.round - s[0].round > BBR_BW_FILTER_ROUNDS)
+	{
+	  s[0] = s[1];
+	  s[1] = s[2];
+	  s[2] = val;
+	}
+    }
+  else if (s[1].round == s[0].round && dt > BBR_BW_FILTER_ROUNDS / 4)
+    s[2] = s[1] = val;
+  else if (s[2].round == s[1].round && dt > BBR_BW_FILTER_ROUNDS / 2)
+    s[2] = val;
+}
+
+static inline f64
+bbr_pacing_gain (bbr_data_t * bd)
+{
+  switch (bd->mode)
+    {
+    case BBR_STARTUP:
+      return BBR_HIGH_GAIN;
+    case BBR_DRAIN:
+      return BBR_DRAIN_GAIN;
+    case BBR_PROBE_BW:
+      return bbr_pacing_gain_cycle[bd->cycle_index];
+    default:
+      return 1;
+    }
+}
+
+static inline f64
+bbr_cwnd_gain (bbr_data_t * bd)
+{
+  switch (bd->mode)
+    {
+    case BBR_STARTUP:
+    case BBR_DRAIN:
+      return BBR_HIGH_GAIN;
+    case BBR_PROBE_BW:
+      return BBR_CWND_GAIN;
+    default:
+      return 1;
+    }
+}
+
+static inline u32
+bbr_min_pipe_cwnd (tcp_connection_t * tc)
+{
+  return BBR_MIN_PIPE_SEGS * tc->snd_mss;
+}
+
+/**
+ * Bytes in flight needed to fully use the estimated bdp, scaled by gain
+ */
+static u32
+bbr_inflight (tcp_connection_t * tc, bbr_data_t * bd, f64 gain)
+{
+  if (!bd->min_rtt || !bbr_max_bw (bd))
+    return tcp_initial_cwnd (tc);
+
+  return gain * bbr_max_bw (bd) * bd->min_rtt;
+}
+
+static void
+bbr_save_cwnd (tcp_connection_t * tc, bbr_data_t * bd)
+{
+  if (!tcp_in_cong_recovery (tc) && bd->mode != BBR_PROBE_RTT)
+    bd->prior_cwnd = tc->cwnd;
+  else
+    bd->prior_cwnd = clib_max (bd->prior_cwnd, tc->cwnd);
+}
+
+static void
+bbr_restore_cwnd (tcp_connection_t * tc, bbr_data_t * bd)
+{
+  tc->cwnd = clib_max (tc->cwnd, bd->prior_cwnd);
+}
+
+static void
+bbr_set_pacing_rate (tcp_connection_t * tc, bbr_data_t * bd, f64 gain)
+{
+  u64 rate;
+  f64 srtt;
+
+  if (!transport_connection_is_tx_paced (&tc->connection))
+    return;
+
+  if (bbr_max_bw (bd))
+    {
+      rate = gain * bbr_max_bw (bd) * BBR_PACING_MARGIN;
+    }
+  else
+    {
+      /* No sample yet, pace the initial window over the handshake rtt */
+      srtt = clib_min ((f64) tc->srtt * TCP_TICK, tc->mrtt_us);
+      if (!tc->srtt || srtt <= 0)
+	return;
+      rate = gain * tc->cwnd / srtt;
+    }
+
+  /* Until the pipe is full, never slow down on a low sample */
+  if ((bd->flags & BBR_F_FILLED_PIPE)
+      || rate > transport_connection_tx_pacer_rate (&tc->connection))
+    transport_connection_tx_pacer_update (&tc->connection, rate);
+}
+
+static void
+bbr_enter_startup (bbr_data_t * bd)
+{
+  bd->mode = BBR_STARTUP;
+}
+
+static void
+bbr_advance_cycle_phase (tcp_connection_t * tc, bbr_data_t * bd)
+{
+  bd->cycle_index = (bd->cycle_index + 1) % BBR_CYCLE_LEN;
+  bd->cycle_stamp = bbr_time (tc);
+}
+
+static void
+bbr_enter_probe_bw (tcp_connection_t * tc, bbr_data_t * bd)
+{
+  bd->mode = BBR_PROBE_BW;
+  /* Randomize the starting phase, but never start by draining */
+  bd->cycle_index = BBR_CYCLE_LEN - 1
+    - (clib_cpu_time_now () % (BBR_CYCLE_LEN - 1));
+  bbr_advance_cycle_phase (tc, bd);
+}
+
+static void
+bbr_update_round (tcp_connection_t * tc, bbr_data_t * bd,
+		  tcp_rate_sample_t * rs)
+{
+  bd->flags &= ~BBR_F_ROUND_START;
+  if (rs->prior_delivered >= bd->next_round_delivered)
+    {
+      bd->next_round_delivered = tc->delivered;
+      bd->round_count++;
+      bd->flags |= BBR_F_ROUND_START;
+      bd->flags &= ~BBR_F_PACKET_CONSERVATION;
+    }
+}
+
+static void
+bbr_update_max_bw (tcp_connection_t * tc, bbr_data_t * bd,
+		   tcp_rate_sample_t * rs)
+{
+  u64 bw;
+
+  bbr_update_round (tc, bd, rs);
+
+  if (rs->interval_time <= 0)
+    return;
+
+  bw = rs->delivered / rs->interval_time;
+
+  /* App limited samples only count if they raise the estimate */
+  if (bw >= bbr_max_bw (bd) || !(rs->flags & TCP_BTS_IS_APP_LIMITED))
+    bbr_max_bw_update (bd, bw);
+}
+
+static u8
+bbr_is_next_cycle_phase (tcp_connection_t * tc, bbr_data_t * bd,
+			 tcp_rate_sample_t * rs)
+{
+  u32 prior_inflight;
+  u8 is_full_length;
+  f64 gain;
+
+  is_full_length = bbr_time (tc) - bd->cycle_stamp > bd->min_rtt;
+  gain = bbr_pacing_gain_cycle[bd->cycle_index];
+  if (gain == 1)
+    return is_full_length;
+
+  prior_inflight = tcp_flight_size (tc) + rs->acked_and_sacked;
+  if (gain > 1)
+    return (is_full_length
+	    && (rs->lost || prior_inflight >= bbr_inflight (tc, bd, gain)));
+
+  return (is_full_length || prior_inflight <= bbr_inflight (tc, bd, 1));
+}
+
+static void
+bbr_check_full_pipe (bbr_data_t * bd, tcp_rate_sample_t * rs)
+{
+  if ((bd->flags & BBR_F_FILLED_PIPE) || !(bd->flags & BBR_F_ROUND_START)
+      || (rs->flags & TCP_BTS_IS_APP_LIMITED))
+    return;
+
+  /* Still growing? */
+  if (bbr_max_bw (bd) >= bd->full_bw * BBR_FULL_BW_THRESH)
+    {
+      bd->full_bw = bbr_max_bw (bd);
+      bd->full_bw_cnt = 0;
+      return;
+    }
+
+  if (++bd->full_bw_cnt >= BBR_FULL_BW_ROUNDS)
+    bd->flags |= BBR_F_FILLED_PIPE;
+}
+
+static void
+bbr_check_drain (tcp_connection_t * tc, bbr_data_t * bd)
+{
+  if (bd->mode == BBR_STARTUP && (bd->flags & BBR_F_FILLED_PIPE))
+    {
+      bd->mode = BBR_DRAIN;
+      tc->ssthresh = bbr_inflight (tc, bd, 1);
+    }
+
+  if (bd->mode == BBR_DRAIN
+      && tcp_flight_size (tc) <= bbr_inflight (tc, bd, 1))
+    bbr_enter_probe_bw (tc, bd);
+}
+
+static void
+bbr_exit_probe_rtt (tcp_connection_t * tc, bbr_data_t * bd)
+{
+  if (bd->flags & BBR_F_FILLED_PIPE)
+    bbr_enter_probe_bw (tc, bd);
+  else
+    bbr_enter_startup (bd);
+}
+
+static void
+bbr_handle_probe_rtt (tcp_connection_t * tc, bbr_data_t * bd, f64 now)
+{
+  if (!bd->probe_rtt_done_stamp && tcp_flight_size (tc)
+      <= bbr_min_pipe_cwnd (tc))
+    {
+      bd->probe_rtt_done_stamp = now + BBR_PROBE_RTT_TIME;
+      bd->flags &= ~BBR_F_PROBE_RTT_ROUND_DONE;
+      bd->next_round_delivered = tc->delivered;
+    }
+  else if (bd->probe_rtt_done_stamp)
+    {
+      if (bd->flags & BBR_F_ROUND_START)
+	bd->flags |= BBR_F_PROBE_RTT_ROUND_DONE;
+      if ((bd->flags & BBR_F_PROBE_RTT_ROUND_DONE)
+	  && now > bd->probe_rtt_done_stamp)
+	{
+	  bd->min_rtt_stamp = now;
+	  bbr_restore_cwnd (tc, bd);
+	  bbr_exit_probe_rtt (tc, bd);
+	}
+    }
+}
+
+static void
+bbr_update_min_rtt (tcp_connection_t * tc, bbr_data_t * bd,
+		    tcp_rate_sample_t * rs)
+{
+  f64 now = bbr_time (tc);
+  u8 expired;
+
+  expired = now > bd->min_rtt_stamp + BBR_MIN_RTT_WINDOW;
+  if (rs->rtt_time > 0 && (rs->rtt_time < bd->min_rtt || !bd->min_rtt
+			   || expired))
+    {
+      bd->min_rtt = rs->rtt_time;
+      bd->min_rtt_stamp = now;
+    }
+
+  if (expired && !(bd->flags & BBR_F_IDLE_RESTART)
+      && bd->mode != BBR_PROBE_RTT)
+    {
+      bd->mode = BBR_PROBE_RTT;
+      bbr_save_cwnd (tc, bd);
+      bd->probe_rtt_done_stamp = 0;
+    }
+
+  if (bd->mode == BBR_PROBE_RTT)
+    bbr_handle_probe_rtt (tc, bd, now);
+
+  bd->flags &= ~BBR_F_IDLE_RESTART;
+}
+
+static void
+bbr_update_model (tcp_connection_t * tc, bbr_data_t * bd,
+		  tcp_rate_sample_t * rs)
+{
+  bbr_update_max_bw (tc, bd, rs);
+  if (bd->mode == BBR_PROBE_BW && bbr_is_next_cycle_phase (tc, bd, rs))
+    bbr_advance_cycle_phase (tc, bd);
+  bbr_check_full_pipe (bd, rs);
+  bbr_check_drain (tc, bd);
+  bbr_update_min_rtt (tc, bd, rs);
+}
+
+static void
+bbr_set_cwnd (tcp_connection_t * tc, bbr_data_t * bd, u32 acked)
+{
+  u32 target;
+
+  target = bbr_inflight (tc, bd, bbr_cwnd_gain (bd)) + 3 * tc->snd_mss;
+
+  if (bd->flags & BBR_F_PACKET_CONSERVATION)
+    tc->cwnd = clib_max (tc->cwnd, tcp_flight_size (tc) + acked);
+  else if (bd->flags & BBR_F_FILLED_PIPE)
+    tc->cwnd = clib_min (tc->cwnd + acked, target);
+  else if (tc->cwnd < target || tc->delivered < tcp_initial_cwnd (tc))
+    tc->cwnd += acked;
+
+  tc->cwnd = clib_max (tc->cwnd, bbr_min_pipe_cwnd (tc));
+  if (bd->mode == BBR_PROBE_RTT)
+    tc->cwnd = clib_min (tc->cwnd, bbr_min_pipe_cwnd (tc));
+
+  /* Constrained by tx fifo, can't grow further */
+  tc->cwnd = clib_min (tc->cwnd, clib_max (tc->tx_fifo_size,
+					   bbr_min_pipe_cwnd (tc)));
+}
+
+static void
+bbr_congestion (tcp_connection_t * tc)
+{
+  bbr_data_t *bd = (bbr_data_t *) tcp_cc_data (tc);
+
+  bbr_save_cwnd (tc, bd);
+
+  /* Start packet conservation for one round. Core fast recovery sets
+   * cwnd to ssthresh once we return */
+  bd->flags |= BBR_F_PACKET_CONSERVATION | BBR_F_RESTORE_CWND;
+  bd->next_round_delivered = tc->delivered;
+  tc->ssthresh = clib_max (tcp_flight_size (tc), bbr_min_pipe_cwnd (tc));
+}
+
+static void
+bbr_loss (tcp_connection_t * tc)
+{
+  bbr_data_t *bd = (bbr_data_t *) tcp_cc_data (tc);
+
+  bbr_save_cwnd (tc, bd);
+  bd->flags |= BBR_F_PACKET_CONSERVATION | BBR_F_RESTORE_CWND;
+  bd->next_round_delivered = tc->delivered;
+  tc->cwnd = tcp_loss_wnd (tc);
+}
+
+static void
+bbr_recovered (tcp_connection_t * tc)
+{
+  bbr_data_t *bd = (bbr_data_t *) tcp_cc_data (tc);
+
+  bd->flags &= ~(BBR_F_PACKET_CONSERVATION | BBR_F_RESTORE_CWND);
+  bbr_restore_cwnd (tc, bd);
+}
+
+static void
+bbr_rcv_ack (tcp_connection_t * tc, tcp_rate_sample_t * rs)
+{
+  bbr_data_t *bd = (bbr_data_t *) tcp_cc_data (tc);
+
+  /* Timeout recovery exits without notifying us, restore cwnd here */
+  if ((bd->flags & BBR_F_RESTORE_CWND) && !tcp_in_cong_recovery (tc))
+    {
+      bd->flags &= ~(BBR_F_PACKET_CONSERVATION | BBR_F_RESTORE_CWND);
+      bbr_restore_cwnd (tc, bd);
+    }
+
+  if (rs->delivered)
+    bbr_update_model (tc, bd, rs);
+
+  bbr_set_pacing_rate (tc, bd, bbr_pacing_gain (bd));
+  bbr_set_cwnd (tc, bd, rs->delivered ? rs->acked_and_sacked :
+		tc->bytes_acked);
+}
+
+static void
+bbr_rcv_cong_ack (tcp_connection_t * tc, tcp_cc_ack_t ack_type,
+		  tcp_rate_sample_t * rs)
+{
+  bbr_data_t *bd = (bbr_data_t *) tcp_cc_data (tc);
+
+  if (!rs || !rs->delivered)
+    return;
+
+  bbr_update_model (tc, bd, rs);
+  bbr_set_pacing_rate (tc, bd, bbr_pacing_gain (bd));
+  bbr_set_cwnd (tc, bd, rs->acked_and_sacked);
+
+  /* ssthresh is not used by bbr but keep the core's spurious fast
+   * retransmit heuristic from firing when cwnd grows during recovery */
+  tc->ssthresh = tc->cwnd;
+}
+
+static void
+bbr_undo_recovery (tcp_connection_t * tc)
+{
+  bbr_recovered (tc);
+}
+
+static void
+bbr_event (tcp_connection_t * tc, tcp_cc_event_t evt)
+{
+  bbr_data_t *bd = (bbr_data_t *) tcp_cc_data (tc);
+
+  if (evt != TCP_CC_EVT_START_TX)
+    return;
+
+  /* Restarting from idle, pace at the estimated bw */
+  bd->flags |= BBR_F_IDLE_RESTART;
+  if (bd->mode == BBR_PROBE_BW)
+    bbr_set_pacing_rate (tc, bd, 1);
+}
+
+static void
+bbr_conn_init (tcp_connection_t * tc)
+{
+  bbr_data_t *bd = (bbr_data_t *) tcp_cc_data (tc);
+
+  clib_memset (bd, 0, sizeof (*bd));
+  tc->ssthresh = ~0;
+  tc->cwnd = tcp_initial_cwnd (tc);
+  bd->min_rtt_stamp = bbr_time (tc);
+  bd->cycle_stamp = bd->min_rtt_stamp;
+  bbr_enter_startup (bd);
+}
+
+const static tcp_cc_algorithm_t tcp_bbr = {
+  .name = "bbr",
+  .flags = TCP_CC_ALGO_F_RATE_SAMPLE | TCP_CC_ALGO_F_PACING,
+  .congestion = bbr_congestion,
+  .loss = bbr_loss,
+  .recovered = bbr_recovered,
+  .undo_recovery = bbr_undo_recovery,
+  .rcv_ack = bbr_rcv_ack,
+  .rcv_cong_ack = bbr_rcv_cong_ack,
+  .event = bbr_event,
+  .init = bbr_conn_init,
+};
+
+clib_error_t *
+bbr_init (vlib_main_t * vm)
+{
+  clib_error_t *error = 0;
+
+  tcp_cc_algo_register (TCP_CC_BBR, &tcp_bbr);
+
+  return error;
+}
+
+VLIB_INIT_FUNCTION (bbr_init);
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -414,8 +414,15 @@ tcp_bt_track_rxt (tcp_connection_t * tc, u32 start, u32 end)
 
 static void
 tcp_bt_sample_to_rate_sample (tcp_connection_t * tc, tcp_bt_sample_t * bts,
-			      tcp_rate_sample_t * rs)
+			      u32 limit, tcp_rate_sample_t * rs)
 {
+  if (tc->flags & TCP_CONN_RACK)
+    {
+      tcp_bt_sample_t *next = bt_next_sample (tc->bt, bts);
+      u32 end = next && seq_lt (next->min_seq, limit) ? next->min_seq : limit;
+      tcp_rack_update (tc, bts->tx_time, end, bts->flags & TCP_BTS_IS_RXT);
+    }
+
   if (rs->prior_delivered && rs->prior_delivered >= bts->delivered)
     return;
 
@@ -433,12 +440,12 @@ tcp_bt_walk_samples (tcp_connection_t * tc, tcp_rate_sample_t * rs)
   tcp_bt_sample_t *next, *cur;
 
   cur = bt_get_sample (bt, bt->head);
-  tcp_bt_sample_to_rate_sample (tc, cur, rs);
+  tcp_bt_sample_to_rate_sample (tc, cur, tc->snd_una, rs);
   while ((next = bt_get_sample (bt, cur->next))
 	 && seq_lt (next->min_seq, tc->snd_una))
     {
       bt_free_sample (bt, cur);
-      tcp_bt_sample_to_rate_sample (tc, next, rs);
+      tcp_bt_sample_to_rate_sample (tc, next, tc->snd_una, rs);
       cur = next;
     }
 
@@ -480,7 +487,7 @@ tcp_bt_walk_samples_ooo (tcp_connection_t * tc, tcp_rate_sample_t * rs)
       if (!cur)
 	continue;
 
-      tcp_bt_sample_to_rate_sample (tc, cur, rs);
+      tcp_bt_sample_to_rate_sample (tc, cur, blk->end, rs);
 
       /* Current shouldn't be removed */
       if (cur->min_seq != blk->start)
@@ -494,7 +501,7 @@ tcp_bt_walk_samples_ooo (tcp_connection_t * tc, tcp_rate_sample_t * rs)
 	     && seq_lt (next->min_seq, blk->end))
 	{
 	  bt_free_sample (bt, cur);
-	  tcp_bt_sample_to_rate_sample (tc, next, rs);
+	  tcp_bt_sample_to_rate_sample (tc, next, blk->end, rs);
 	  cur = next;
 	}
 
@@ -536,6 +543,15 @@ tcp_bt_sample_delivery_rate (tcp_connection_t * tc, tcp_rate_sample_t * rs)
   rs->lost = tc->sack_sb.last_lost_bytes;
 }
 
+f64
+tcp_bt_seq_tx_time (tcp_connection_t * tc, u32 seq)
+{
+  tcp_bt_sample_t *bts;
+
+  bts = bt_lookup_seq (tc->bt, seq);
+  return bts ? bts->tx_time : 0;
+}
+
 void
 tcp_bt_flush_samples (tcp_connection_t * tc)
 {
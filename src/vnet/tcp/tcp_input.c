@@ -594,6 +594,9 @@ tcp_handle_postponed_dequeues (tcp_worker_ctx_t * wrk)
        * otherwise update. */
       tcp_retransmit_timer_update (tc);
 
+      if (tc->flags & TCP_CONN_RACK)
+	tcp_rack_tlp_schedule (tc);
+
       /* If not congested, update pacer based on our new
        * cwnd estimate */
       if (!tcp_in_fastrecovery (tc))
@@ -874,7 +877,6 @@ scoreboard_next_rxt_hole (sack_scoreboard_t * sb,
 
   return hole;
 }
-#endif /* CLIB_MARCH_VARIANT */
 
 static void
 scoreboard_init_high_rxt (sack_scoreboard_t * sb, u32 snd_una)
@@ -890,7 +892,6 @@ scoreboard_init_high_rxt (sack_scoreboard_t * sb, u32 snd_una)
   sb->rescue_rxt = snd_una - 1;
 }
 
-#ifndef  CLIB_MARCH_VARIANT
 void
 scoreboard_init (sack_scoreboard_t * sb)
 {
@@ -1302,10 +1303,40 @@ static u8
 tcp_should_fastrecover (tcp_connection_t * tc)
 {
   return (tc->rcv_dupacks == TCP_DUPACK_THRESHOLD
-	  || tcp_should_fastrecover_sack (tc));
+	  || tcp_should_fastrecover_sack (tc)
+	  || ((tc->flags & TCP_CONN_RACK) && tc->sack_sb.lost_bytes));
 }
 
 #ifndef CLIB_MARCH_VARIANT
+void
+tcp_cc_fastrecovery_enter (tcp_connection_t * tc, tcp_rate_sample_t * rs)
+{
+  u32 pacer_wnd;
+
+  ASSERT (!tcp_in_fastrecovery (tc));
+
+  tcp_cc_init_congestion (tc);
+  tcp_cc_rcv_cong_ack (tc, TCP_CC_DUPACK, rs);
+
+  if (tcp_opts_sack_permitted (&tc->rcv_opts))
+    {
+      tc->cwnd = tc->ssthresh;
+      scoreboard_init_high_rxt (&tc->sack_sb, tc->snd_una);
+    }
+  else
+    {
+      /* Post retransmit update cwnd to ssthresh and account for the
+       * three segments that have left the network and should've been
+       * buffered at the receiver XXX */
+      tc->cwnd = tc->ssthresh + 3 * tc->snd_mss;
+    }
+
+  /* Constrain rate until we get a partial ack */
+  pacer_wnd = clib_max (0.1 * tc->cwnd, 2 * tc->snd_mss);
+  tcp_connection_tx_pacer_reset (tc, pacer_wnd, 0 /* start bucket */ );
+  tcp_program_fastretransmit (tcp_get_worker (tc->c_thread_index), tc);
+}
+
 void
 tcp_program_fastretransmit (tcp_worker_ctx_t * wrk, tcp_connection_t * tc)
 {
@@ -1416,8 +1447,6 @@ tcp_cc_handle_event (tcp_connection_t * tc, tcp_rate_sample_t * rs,
 	}
       else if (tcp_should_fastrecover (tc))
 	{
-	  u32 pacer_wnd;
-
 	  ASSERT (!tcp_in_fastrecovery (tc));
 
 	  /* Heuristic to catch potential late dupacks
@@ -1429,28 +1458,7 @@ tcp_cc_handle_event (tcp_connection_t * tc, tcp_rate_sample_t * rs,
 	      return;
 	    }
 
-	  tcp_cc_init_congestion (tc);
-	  tcp_cc_rcv_cong_ack (tc, TCP_CC_DUPACK, rs);
-
-	  if (tcp_opts_sack_permitted (&tc->rcv_opts))
-	    {
-	      tc->cwnd = tc->ssthresh;
-	      scoreboard_init_high_rxt (&tc->sack_sb, tc->snd_una);
-	    }
-	  else
-	    {
-	      /* Post retransmit update cwnd to ssthresh and account for the
-	       * three segments that have left the network and should've been
-	       * buffered at the receiver XXX */
-	      tc->cwnd = tc->ssthresh + 3 * tc->snd_mss;
-	    }
-
-	  /* Constrain rate until we get a partial ack */
-	  pacer_wnd = clib_max (0.1 * tc->cwnd, 2 * tc->snd_mss);
-	  tcp_connection_tx_pacer_reset (tc, pacer_wnd,
-					 0 /* start bucket */ );
-	  tcp_program_fastretransmit (tcp_get_worker (tc->c_thread_index),
-				      tc);
+	  tcp_cc_fastrecovery_enter (tc, rs);
 	  return;
 	}
       else if (!tc->bytes_acked
@@ -1581,7 +1589,7 @@ static int
 tcp_rcv_ack (tcp_worker_ctx_t * wrk, tcp_connection_t * tc, vlib_buffer_t * b,
 	     tcp_header_t * th, u32 * error)
 {
-  u32 prev_snd_wnd, prev_snd_una;
+  u32 prev_snd_wnd, prev_snd_una, rack_lost = 0;
   tcp_rate_sample_t rs = { 0 };
   u8 is_dack;
 
@@ -1622,6 +1630,9 @@ process_ack:
   /*
    * Looks okay, process feedback
    */
+  if (tc->flags & TCP_CONN_RACK)
+    tcp_rack_tlp_rcv_ack (tc, vnet_buffer (b)->tcp.ack_number);
+
   if (tcp_opts_sack_permitted (&tc->rcv_opts))
     tcp_rcv_sacks (tc, vnet_buffer (b)->tcp.ack_number);
 
@@ -1643,15 +1654,20 @@ process_ack:
   if (tc->flags & TCP_CONN_RATE_SAMPLE)
     tcp_bt_sample_delivery_rate (tc, &rs);
 
+  /* Time based loss detection. Holes found lost count as dupacks */
+  if ((tc->flags & TCP_CONN_RACK) && !tcp_in_recovery (tc))
+    rack_lost = tcp_rack_detect_loss (tc);
+
   TCP_EVT_DBG (TCP_EVT_ACK_RCVD, tc);
 
   /*
    * Check if we have congestion event
    */
 
-  if (tcp_ack_is_cc_event (tc, b, prev_snd_wnd, prev_snd_una, &is_dack))
+  if (tcp_ack_is_cc_event (tc, b, prev_snd_wnd, prev_snd_una, &is_dack)
+      || rack_lost)
     {
-      tcp_cc_handle_event (tc, &rs, is_dack);
+      tcp_cc_handle_event (tc, &rs, is_dack || rack_lost);
       if (!tcp_in_cong_recovery (tc))
 	{
 	  *error = TCP_ERROR_ACK_OK;
@@ -1808,7 +1824,7 @@ tcp_sack_list_bytes (tcp_connection_t * tc)
 /** Enqueue data for delivery to application */
 static int
 tcp_session_enqueue_data (tcp_connection_t * tc, vlib_buffer_t * b,
-			  u16 data_len)
+			  u32 data_len)
 {
   int written, error = TCP_ERROR_ENQUEUED;
 
@@ -1922,6 +1938,19 @@ tcp_can_delack (tcp_connection_t * tc)
   return 1;
 }
 
+always_inline void
+tcp_program_ack_or_delack (tcp_worker_ctx_t * wrk, tcp_connection_t * tc)
+{
+  if (tcp_can_delack (tc))
+    {
+      if (!tcp_timer_is_active (tc, TCP_TIMER_DELACK))
+	tcp_timer_set (tc, TCP_TIMER_DELACK, TCP_DELACK_TIME);
+      return;
+    }
+
+  tcp_program_ack (wrk, tc);
+}
+
 static int
 tcp_buffer_discard_bytes (vlib_buffer_t * b, u32 n_bytes_to_drop)
 {
@@ -2006,19 +2035,47 @@ in_order:
   /* In order data, enqueue. Fifo figures out by itself if any out-of-order
    * segments can be enqueued after fifo tail offset changes. */
   error = tcp_session_enqueue_data (tc, b, n_data_bytes);
-  if (tcp_can_delack (tc))
-    {
-      if (!tcp_timer_is_active (tc, TCP_TIMER_DELACK))
-	tcp_timer_set (tc, TCP_TIMER_DELACK, TCP_DELACK_TIME);
-      goto done;
-    }
-
-  tcp_program_ack (wrk, tc);
+  tcp_program_ack_or_delack (wrk, tc);
 
 done:
   return error;
 }
 
+/**
+ * Enqueue coalesced segments and make one ack decision for all of them
+ */
+static void
+tcp_gro_flush (vlib_main_t * vm, tcp_worker_ctx_t * wrk,
+	       tcp_gro_ctx_t * gro, u16 * err_counters)
+{
+  tcp_connection_t *tc = gro->tc;
+  vlib_buffer_t *b = gro->head;
+  u32 error;
+
+  if (!gro->n_segs)
+    return;
+
+  tc->rcv_nxt = gro->rcv_nxt;
+  b->total_length_not_including_first_buffer = gro->n_bytes
+    - b->current_length;
+  b->flags |= VLIB_BUFFER_TOTAL_LENGTH_VALID;
+
+  error = tcp_session_enqueue_data (tc, b, gro->n_bytes);
+  tcp_program_ack_or_delack (wrk, tc);
+
+  err_counters[error] += gro->n_segs;
+  err_counters[TCP_ERROR_COALESCED] += gro->n_segs - 1;
+
+  /* Unchain, the node frees the buffers one by one */
+  while (b->flags & VLIB_BUFFER_NEXT_PRESENT)
+    {
+      b->flags &= ~VLIB_BUFFER_NEXT_PRESENT;
+      b = vlib_get_buffer (vm, b->next_buffer);
+    }
+
+  gro->n_segs = 0;
+}
+
 typedef struct
 {
   tcp_header_t tcp_header;
@@ -2152,6 +2209,7 @@ tcp46_established_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
   tcp_worker_ctx_t *wrk = tcp_get_worker (thread_index);
   u32 n_left_from, *from, *first_buffer;
   u16 err_counters[TCP_N_ERROR] = { 0 };
+  tcp_gro_ctx_t gro = { 0 };
 
   if (node->flags & VLIB_NODE_FLAG_TRACE)
     tcp_established_trace_frame (vm, node, frame, is_ip4);
@@ -2190,6 +2248,11 @@ tcp46_established_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 
       th0 = tcp_buffer_hdr (b0);
 
+      /* Anything but more in order data for the connection, and the
+       * pending segments must be enqueued first */
+      if (gro.n_segs && !tcp_gro_can_append (&gro, tc0, b0, th0))
+	tcp_gro_flush (vm, wrk, &gro, err_counters);
+
       /* TODO header prediction fast path */
 
       /* 1-4: check SEQ, RST, SYN */
@@ -2207,7 +2270,15 @@ tcp46_established_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 
       /* 7: process the segment text */
       if (vnet_buffer (b0)->tcp.data_len)
-	error0 = tcp_segment_rcv (wrk, tc0, b0);
+	{
+	  if (tcp_gro_can_append (&gro, tc0, b0, th0))
+	    {
+	      /* Counted when flushed */
+	      tcp_gro_append (&gro, tc0, b0, bi0);
+	      continue;
+	    }
+	  error0 = tcp_segment_rcv (wrk, tc0, b0);
+	}
 
       /* 8: check the FIN bit */
       if (PREDICT_FALSE (tcp_is_fin (th0)))
@@ -2217,6 +2288,8 @@ tcp46_established_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
       tcp_inc_err_counter (err_counters, error0, 1);
     }
 
+  tcp_gro_flush (vm, wrk, &gro, err_counters);
+
   errors = session_main_flush_enqueue_events (TRANSPORT_PROTO_TCP,
 					      thread_index);
   err_counters[TCP_ERROR_MSG_QUEUE_FULL] = errors;
@@ -2777,6 +2850,7 @@ tcp46_rcv_process_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 	  /* Reset SYN-ACK retransmit and SYN_RCV establish timers */
 	  tcp_retransmit_timer_reset (tc0);
 	  tcp_timer_reset (tc0, TCP_TIMER_ESTABLISH);
+	  tcp_connection_listener_release (tc0);
 	  if (session_stream_accept_notify (&tc0->connection))
 	    {
 	      error0 = TCP_ERROR_MSG_QUEUE_FULL;
@@ -3088,6 +3162,168 @@ VLIB_REGISTER_NODE (tcp6_rcv_process_node) =
 };
 /* *INDENT-ON* */
 
+static void
+tcp_listen_init_endpoints (tcp_connection_t * tc, tcp_connection_t * lc,
+			   vlib_buffer_t * b, tcp_header_t * th, u8 is_ip4)
+{
+  tc->c_lcl_port = th->dst_port;
+  tc->c_rmt_port = th->src_port;
+  tc->c_is_ip4 = is_ip4;
+  tc->c_fib_index = lc->c_fib_index;
+
+  if (is_ip4)
+    {
+      ip4_header_t *ip4 = vlib_buffer_get_current (b);
+      tc->c_lcl_ip4.as_u32 = ip4->dst_address.as_u32;
+      tc->c_rmt_ip4.as_u32 = ip4->src_address.as_u32;
+    }
+  else
+    {
+      ip6_header_t *ip6 = vlib_buffer_get_current (b);
+      clib_memcpy_fast (&tc->c_lcl_ip6, &ip6->dst_address,
+			sizeof (ip6_address_t));
+      clib_memcpy_fast (&tc->c_rmt_ip6, &ip6->src_address,
+			sizeof (ip6_address_t));
+    }
+}
+
+/**
+ * Answer SYN with a SYN cookie, without allocating a connection
+ */
+static u32
+tcp_listen_syn_cookie_send (tcp_connection_t * lc, vlib_buffer_t * b,
+			    tcp_header_t * th, u32 thread_index, u8 is_ip4)
+{
+  tcp_connection_t _tc, *tc = &_tc;
+
+  clib_memset (tc, 0, sizeof (*tc));
+  tcp_listen_init_endpoints (tc, lc, b, th, is_ip4);
+  tc->c_thread_index = thread_index;
+  tc->state = TCP_STATE_SYN_RCVD;
+
+  if (tcp_options_parse (th, &tc->rcv_opts, 1))
+    return TCP_ERROR_OPTIONS;
+
+  /* Window scale and sack permitted can only be recovered from the
+   * tsecr of the ack. Don't negotiate them if peer has no timestamps */
+  if (tcp_opts_tstamp (&tc->rcv_opts))
+    {
+      tc->tsval_recent = tc->rcv_opts.tsval;
+      tc->timestamp_delta = tcp_time_now ()
+	- tcp_syn_cookie_tsval (&tc->rcv_opts);
+    }
+  else
+    tc->rcv_opts.flags &= ~(TCP_OPTS_FLAG_WSCALE
+			    | TCP_OPTS_FLAG_SACK_PERMITTED);
+
+  tc->irs = vnet_buffer (b)->tcp.seq_number;
+  tc->rcv_nxt = tc->irs + 1;
+  tc->iss = tcp_syn_cookie_make (tc, tc->irs, &tc->rcv_opts.mss);
+  tcp_update_rcv_mss (tc);
+  tcp_send_synack_cookie (tc);
+
+  return TCP_ERROR_NONE;
+}
+
+/**
+ * Handle ACK received by listener. If it acks a valid SYN cookie, create
+ * the connection directly in ESTABLISHED, otherwise reset the peer.
+ * Data carried by the ACK is not enqueued and will be retransmitted.
+ */
+static u32
+tcp_listen_syn_cookie_ack (tcp_connection_t * lc, vlib_buffer_t * b,
+			   tcp_header_t * th, u32 thread_index, u8 is_ip4)
+{
+  tcp_main_t *tm = &tcp_main;
+  tcp_connection_t _tc, *tc = &_tc, *child;
+  u32 irs, iss;
+  u16 mss;
+
+  if (!tm->syn_cookies_threshold)
+    {
+      tcp_send_reset_w_pkt (lc, b, thread_index, is_ip4);
+      return TCP_ERROR_ACK_INVALID;
+    }
+
+  irs = vnet_buffer (b)->tcp.seq_number - 1;
+  iss = vnet_buffer (b)->tcp.ack_number - 1;
+
+  clib_memset (&tc->connection, 0, sizeof (tc->connection));
+  tcp_listen_init_endpoints (tc, lc, b, th, is_ip4);
+  if (tcp_syn_cookie_check (tc, irs, iss, &mss))
+    {
+      tcp_send_reset_w_pkt (lc, b, thread_index, is_ip4);
+      return TCP_ERROR_SYN_COOKIE_INVALID;
+    }
+
+  child = tcp_connection_alloc (thread_index);
+  tcp_listen_init_endpoints (child, lc, b, th, is_ip4);
+  child->state = TCP_STATE_SYN_RCVD;
+
+  /* Only timestamps are parsed from the ACK. Everything else negotiated
+   * in the SYN is recovered from the cookie and the echoed tsval. The
+   * SYN-ACK carried a timestamp only if the SYN did, and a cookie tsval
+   * is never 0, so a tsecr means timestamps were negotiated */
+  child->rcv_opts.flags = TCP_OPTS_FLAG_TSTAMP;
+  child->rcv_opts.tsecr = 0;
+  if (tcp_options_parse (th, &child->rcv_opts, 0 /* is_syn */ ))
+    {
+      tcp_connection_free (child);
+      return TCP_ERROR_OPTIONS;
+    }
+
+  child->rcv_opts.flags &= ~TCP_OPTS_FLAG_TSTAMP;
+  child->rcv_opts.flags |= TCP_OPTS_FLAG_MSS;
+  child->rcv_opts.mss = mss;
+  if (child->rcv_opts.tsecr)
+    {
+      child->rcv_opts.flags |= TCP_OPTS_FLAG_TSTAMP;
+      tcp_syn_cookie_tsecr_opts (child->rcv_opts.tsecr, &child->rcv_opts);
+      child->tsval_recent = child->rcv_opts.tsval;
+      child->tsval_recent_age = tcp_time_now ();
+    }
+  if (tcp_opts_wscale (&child->rcv_opts))
+    child->snd_wscale = child->rcv_opts.wscale;
+
+  child->irs = irs;
+  child->rcv_nxt = irs + 1;
+  child->rcv_las = child->rcv_nxt;
+  child->sw_if_index = vnet_buffer (b)->sw_if_index[VLIB_RX];
+
+  /* Recompute the window and scale we advertised in the SYN-ACK */
+  tcp_initial_window_to_advertise (child);
+
+  tcp_connection_set_state (child, TCP_STATE_ESTABLISHED);
+  child->iss = iss;
+  child->snd_una = iss + 1;
+  child->snd_nxt = child->snd_una;
+  child->snd_una_max = child->snd_nxt;
+  child->snd_wnd = clib_net_to_host_u16 (th->window) << child->snd_wscale;
+  child->snd_wl1 = vnet_buffer (b)->tcp.seq_number;
+  child->snd_wl2 = vnet_buffer (b)->tcp.ack_number;
+
+  tcp_connection_init_vars (child);
+  child->rto = TCP_RTO_MIN;
+  if (tcp_opts_tstamp (&child->rcv_opts))
+    tcp_estimate_initial_rtt (child);
+
+  if (session_stream_accept (&child->connection, lc->c_s_index,
+			     lc->c_thread_index, 0 /* notify */ ))
+    {
+      tcp_connection_cleanup (child);
+      return TCP_ERROR_CREATE_SESSION_FAIL;
+    }
+
+  child->tx_fifo_size = transport_tx_fifo_size (&child->connection);
+  if (session_stream_accept_notify (&child->connection))
+    {
+      tcp_connection_reset (child);
+      return TCP_ERROR_MSG_QUEUE_FULL;
+    }
+
+  return TCP_ERROR_SYN_COOKIE_OK;
+}
+
 /**
  * LISTEN state processing as per RFC 793 p. 65
  */
@@ -3095,8 +3331,9 @@ always_inline uword
 tcp46_listen_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 		     vlib_frame_t * from_frame, int is_ip4)
 {
-  u32 n_left_from, *from, n_syns = 0, *first_buffer;
+  u32 n_left_from, *from, n_syns = 0, n_cookies = 0, *first_buffer;
   u32 my_thread_index = vm->thread_index;
+  tcp_main_t *tm = &tcp_main;
 
   from = first_buffer = vlib_frame_vector_args (from_frame);
   n_left_from = from_frame->n_vectors;
@@ -3131,23 +3368,14 @@ tcp46_listen_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 	  th0 = ip6_next_header (ip60);
 	}
 
-      /* Create child session. For syn-flood protection use filter */
+      /* Create child session. For syn-flood protection use filter
+       * or, above the listener's half-open threshold, SYN cookies */
 
       /* 1. first check for an RST: handled in dispatch */
       /* if (tcp_rst (th0))
          goto drop;
        */
 
-      /* 2. second check for an ACK: handled in dispatch */
-      /* if (tcp_ack (th0))
-         {
-         tcp_send_reset (b0, is_ip4);
-         goto drop;
-         }
-       */
-
-      /* 3. check for a SYN (did that already) */
-
       /* Make sure connection wasn't just created */
       child0 = tcp_lookup_connection (lc0->c_fib_index, b0, my_thread_index,
 				      is_ip4);
@@ -3157,27 +3385,32 @@ tcp46_listen_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 	  goto drop;
 	}
 
-      /* Create child session and send SYN-ACK */
-      child0 = tcp_connection_alloc (my_thread_index);
-      child0->c_lcl_port = th0->dst_port;
-      child0->c_rmt_port = th0->src_port;
-      child0->c_is_ip4 = is_ip4;
-      child0->state = TCP_STATE_SYN_RCVD;
-      child0->c_fib_index = lc0->c_fib_index;
-
-      if (is_ip4)
+      /* 2. second check for an ACK. Could be completing a SYN cookie */
+      if (tcp_ack (th0))
 	{
-	  child0->c_lcl_ip4.as_u32 = ip40->dst_address.as_u32;
-	  child0->c_rmt_ip4.as_u32 = ip40->src_address.as_u32;
+	  error0 = tcp_listen_syn_cookie_ack (lc0, b0, th0, my_thread_index,
+					      is_ip4);
+	  tcp_inc_counter (listen, error0, 1);
+	  goto drop;
 	}
-      else
+
+      /* 3. check for a SYN (did that already) */
+
+      if (PREDICT_FALSE (tm->syn_cookies_threshold
+			 && lc0->n_half_open >=
+			 (i32) tm->syn_cookies_threshold))
 	{
-	  clib_memcpy_fast (&child0->c_lcl_ip6, &ip60->dst_address,
-			    sizeof (ip6_address_t));
-	  clib_memcpy_fast (&child0->c_rmt_ip6, &ip60->src_address,
-			    sizeof (ip6_address_t));
+	  error0 = tcp_listen_syn_cookie_send (lc0, b0, th0, my_thread_index,
+					       is_ip4);
+	  n_cookies += (error0 == TCP_ERROR_NONE);
+	  goto drop;
 	}
 
+      /* Create child session and send SYN-ACK */
+      child0 = tcp_connection_alloc (my_thread_index);
+      tcp_listen_init_endpoints (child0, lc0, b0, th0, is_ip4);
+      child0->state = TCP_STATE_SYN_RCVD;
+
       if (tcp_options_parse (th0, &child0->rcv_opts, 1))
 	{
 	  error0 = TCP_ERROR_OPTIONS;
@@ -3217,6 +3450,11 @@ tcp46_listen_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 	  goto drop;
 	}
 
+      child0->listener_index = lc0->c_c_index;
+      child0->listener_gen = lc0->listener_gen;
+      child0->flags |= TCP_CONN_HALF_OPEN_LISTEN;
+      clib_atomic_fetch_add_rel (&lc0->n_half_open, 1);
+
       TCP_EVT_DBG (TCP_EVT_SYN_RCVD, child0, 1);
       child0->tx_fifo_size = transport_tx_fifo_size (&child0->connection);
       tcp_send_synack (child0);
@@ -3236,6 +3474,7 @@ tcp46_listen_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
     }
 
   tcp_inc_counter (listen, TCP_ERROR_SYNS_RCVD, n_syns);
+  tcp_inc_counter (listen, TCP_ERROR_SYN_COOKIES_SENT, n_cookies);
   vlib_buffer_free (vm, first_buffer, from_frame->n_vectors);
 
   return from_frame->n_vectors;
@@ -3651,7 +3890,9 @@ do {                                                       	\
 
   /* RFC 793: In LISTEN if RST drop and if ACK return RST */
   _(LISTEN, 0, TCP_INPUT_NEXT_DROP, TCP_ERROR_SEGMENT_INVALID);
-  _(LISTEN, TCP_FLAG_ACK, TCP_INPUT_NEXT_RESET, TCP_ERROR_ACK_INVALID);
+  _(LISTEN, TCP_FLAG_ACK, TCP_INPUT_NEXT_LISTEN, TCP_ERROR_NONE);
+  _(LISTEN, TCP_FLAG_ACK | TCP_FLAG_PSH, TCP_INPUT_NEXT_LISTEN,
+    TCP_ERROR_NONE);
   _(LISTEN, TCP_FLAG_RST, TCP_INPUT_NEXT_DROP, TCP_ERROR_INVALID_CONNECTION);
   _(LISTEN, TCP_FLAG_SYN, TCP_INPUT_NEXT_LISTEN, TCP_ERROR_NONE);
   _(LISTEN, TCP_FLAG_SYN | TCP_FLAG_ACK, TCP_INPUT_NEXT_RESET,
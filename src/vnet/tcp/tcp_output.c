@@ -318,7 +318,7 @@ tcp_make_synack_options (tcp_connection_t * tc, tcp_options_t * opts)
   if (tcp_opts_tstamp (&tc->rcv_opts))
     {
       opts->flags |= TCP_OPTS_FLAG_TSTAMP;
-      opts->tsval = tcp_time_now ();
+      opts->tsval = tcp_tstamp (tc);
       opts->tsecr = tc->tsval_recent;
       len += TCP_OPTION_LEN_TIMESTAMP;
     }
@@ -986,6 +986,31 @@ tcp_send_synack (tcp_connection_t * tc)
   TCP_EVT_DBG (TCP_EVT_SYNACK_SENT, tc);
 }
 
+/**
+ * Send SYN-ACK that carries a SYN cookie
+ *
+ * No connection is allocated for the peer, so tc is scratch state built
+ * by the listener and the packet goes straight to ipx_lookup.
+ */
+void
+tcp_send_synack_cookie (tcp_connection_t * tc)
+{
+  tcp_worker_ctx_t *wrk = tcp_get_worker (tc->c_thread_index);
+  vlib_main_t *vm = wrk->vm;
+  vlib_buffer_t *b;
+  u32 bi;
+
+  if (PREDICT_FALSE (!vlib_buffer_alloc (vm, &bi, 1)))
+    return;
+
+  b = vlib_get_buffer (vm, bi);
+  tcp_init_buffer (vm, b);
+  tcp_make_synack (tc, b);
+  tcp_push_ip_hdr (wrk, tc, b);
+  tcp_enqueue_to_ip_lookup (wrk, b, bi, tc->c_is_ip4, tc->c_fib_index);
+  TCP_EVT_DBG (TCP_EVT_SYNACK_SENT, tc);
+}
+
 /**
  * Flush tx frame populated by retransmits and timer pops
  */
@@ -1113,6 +1138,15 @@ tcp_push_hdr_i (tcp_connection_t * tc, vlib_buffer_t * b, u32 snd_nxt,
 			     tc->rcv_nxt, tcp_hdr_opts_len, flags,
 			     advertise_wnd);
 
+  /* Super segment built by session layer for tso connection */
+  if (PREDICT_FALSE (data_len > tc->snd_mss))
+    {
+      ASSERT (transport_connection_is_tso (&tc->connection));
+      b->flags |= VNET_BUFFER_F_GSO;
+      vnet_buffer2 (b)->gso_size = tc->snd_mss;
+      vnet_buffer2 (b)->gso_l4_hdr_sz = tcp_hdr_opts_len;
+    }
+
   if (maybe_burst)
     {
       clib_memcpy_fast ((u8 *) (th + 1),
@@ -1164,6 +1198,9 @@ tcp_session_push_header (transport_connection_t * tconn, vlib_buffer_t * b)
       tcp_retransmit_timer_set (tc);
       tc->rto_boff = 0;
     }
+  if ((tc->flags & TCP_CONN_RACK)
+      && tc->rack.timer == TCP_TIMER_HANDLE_INVALID)
+    tcp_rack_tlp_schedule (tc);
   tcp_trajectory_add_start (b, 3);
   return 0;
 }
@@ -1471,6 +1508,39 @@ done:
   return n_bytes;
 }
 
+/**
+ * Send tail loss probe
+ *
+ * Retransmits the last segment sent, to trigger an ack that either
+ * confirms delivery or, with sacks, lets rack detect the losses.
+ */
+void
+tcp_send_tail_loss_probe (tcp_worker_ctx_t * wrk, tcp_connection_t * tc)
+{
+  u32 bi, n_bytes, flight, offset;
+  vlib_buffer_t *b = 0;
+
+  flight = tc->snd_nxt - tc->snd_una;
+  n_bytes = clib_min (tc->snd_mss, flight);
+  offset = flight - n_bytes;
+
+  n_bytes = tcp_prepare_segment (wrk, tc, offset, n_bytes, &b);
+  if (!n_bytes)
+    return;
+
+  if (tc->flags & TCP_CONN_RATE_SAMPLE)
+    tcp_bt_track_rxt (tc, tc->snd_una + offset, tc->snd_nxt);
+
+  tc->rack.tlp_high_seq = tc->snd_nxt;
+  tc->rack.tlp_pending = 1;
+  tc->rack.tlp_is_rxt = 1;
+
+  TCP_EVT_DBG (TCP_EVT_CC_RTX, tc, offset, n_bytes);
+  bi = vlib_get_buffer_index (wrk->vm, b);
+  tcp_enqueue_to_output (wrk, b, bi, tc->c_is_ip4);
+  tcp_retransmit_timer_force_update (tc);
+}
+
 /**
  * Reset congestion control, switch cwnd to loss window and try again.
  */
@@ -1579,6 +1649,12 @@ tcp_timer_retransmit_handler_i (u32 index, u8 is_syn)
       /* TODO be less aggressive about clearing scoreboard */
       scoreboard_clear (&tc->sack_sb);
 
+      if (tc->flags & TCP_CONN_RACK)
+	{
+	  tcp_rack_timer_reset (tc);
+	  tc->rack.tlp_pending = 0;
+	}
+
       /* First retransmit timeout */
       if (tc->rto_boff == 1)
 	tcp_cc_init_rxt_timeout (tc);
@@ -2080,7 +2156,8 @@ tcp_output_push_ip (vlib_main_t * vm, vlib_buffer_t * b0,
     {
       vlib_buffer_push_ip4 (vm, b0, &tc0->c_lcl_ip4, &tc0->c_rmt_ip4,
 			    IP_PROTOCOL_TCP, 1);
-      b0->flags |= VNET_BUFFER_F_OFFLOAD_TCP_CKSUM;
+      b0->flags |= VNET_BUFFER_F_OFFLOAD_TCP_CKSUM
+	| VNET_BUFFER_F_L3_HDR_OFFSET_VALID | VNET_BUFFER_F_L4_HDR_OFFSET_VALID;
       vnet_buffer (b0)->l4_hdr_offset = (u8 *) th0 - b0->data;
       th0->checksum = 0;
     }
@@ -2089,7 +2166,8 @@ tcp_output_push_ip (vlib_main_t * vm, vlib_buffer_t * b0,
       ip6_header_t *ih0;
       ih0 = vlib_buffer_push_ip6 (vm, b0, &tc0->c_lcl_ip6,
 				  &tc0->c_rmt_ip6, IP_PROTOCOL_TCP);
-      b0->flags |= VNET_BUFFER_F_OFFLOAD_TCP_CKSUM;
+      b0->flags |= VNET_BUFFER_F_OFFLOAD_TCP_CKSUM
+	| VNET_BUFFER_F_L3_HDR_OFFSET_VALID | VNET_BUFFER_F_L4_HDR_OFFSET_VALID;
       vnet_buffer (b0)->l3_hdr_offset = (u8 *) ih0 - b0->data;
       vnet_buffer (b0)->l4_hdr_offset = (u8 *) th0 - b0->data;
       th0->checksum = 0;
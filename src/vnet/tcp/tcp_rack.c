@@ -0,0 +1,300 @@
+/*
+ * Copyright (c) 2019 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * TCP RACK-TLP time based loss detection. Based on RFC8985
+ *
+ * Transmit times are taken from the byte tracker, so they have burst
+ * granularity. Holes are marked lost in addition to the RFC6675 DupThresh
+ * rule, so retransmissions still go through the sack fast retransmit path.
+ */
+
+#include <vnet/tcp/tcp.h>
+
+/** Max interval the 1ms rack timer wheel can handle */
+#define TCP_RACK_TIMER_MAX_TICKS	2047
+
+static inline tw_timer_wheel_16t_1w_2048sl_t *
+tcp_rack_timer_wheel (tcp_connection_t * tc)
+{
+  return &tcp_get_worker (tc->c_thread_index)->rack_timer_wheel;
+}
+
+static void
+tcp_rack_timer_update (tcp_connection_t * tc, u8 timer_id, f64 timeout)
+{
+  u32 interval;
+
+  ASSERT (tc->c_thread_index == vlib_get_thread_index ());
+
+  interval = timeout / TCP_RACK_TIMER_TICK + 1;
+  interval = clib_min (interval, TCP_RACK_TIMER_MAX_TICKS);
+
+  if (tc->rack.timer != TCP_TIMER_HANDLE_INVALID)
+    tw_timer_stop_16t_1w_2048sl (tcp_rack_timer_wheel (tc), tc->rack.timer);
+
+  tc->rack.timer = tw_timer_start_16t_1w_2048sl (tcp_rack_timer_wheel (tc),
+						 tc->c_c_index, timer_id,
+						 interval);
+  tc->rack.timer_id = timer_id;
+}
+
+void
+tcp_rack_timer_reset (tcp_connection_t * tc)
+{
+  if (tc->rack.timer == TCP_TIMER_HANDLE_INVALID)
+    return;
+
+  ASSERT (tc->c_thread_index == vlib_get_thread_index ());
+  tw_timer_stop_16t_1w_2048sl (tcp_rack_timer_wheel (tc), tc->rack.timer);
+  tc->rack.timer = TCP_TIMER_HANDLE_INVALID;
+}
+
+void
+tcp_rack_init (tcp_connection_t * tc)
+{
+  tcp_rack_timer_reset (tc);
+  clib_memset (&tc->rack, 0, sizeof (tc->rack));
+  tc->rack.timer = TCP_TIMER_HANDLE_INVALID;
+}
+
+void
+tcp_rack_update (tcp_connection_t * tc, f64 xmit_ts, u32 end_seq, u8 is_rxt)
+{
+  tcp_rack_t *rack = &tc->rack;
+  f64 rtt;
+
+  rtt = tcp_time_now_us (tc->c_thread_index) - xmit_ts;
+
+  /* Could be the ack for the original transmission. Ambiguous, ignore */
+  if (is_rxt && rtt < rack->min_rtt)
+    return;
+
+  if (!rack->min_rtt || rtt < rack->min_rtt)
+    rack->min_rtt = rtt;
+
+  if (xmit_ts > rack->xmit_ts
+      || (xmit_ts == rack->xmit_ts && seq_gt (end_seq, rack->end_seq)))
+    {
+      rack->xmit_ts = xmit_ts;
+      rack->end_seq = end_seq;
+      rack->rtt = rtt;
+    }
+}
+
+/**
+ * Mark as lost holes sent before the most recently delivered segment
+ * if more than rtt + reordering window elapsed since they were sent
+ *
+ * Recomputes the scoreboard's lost bytes and arms the reordering timer
+ * for holes that are not yet overdue.
+ *
+ * @return number of bytes newly marked as lost
+ */
+u32
+tcp_rack_detect_loss (tcp_connection_t * tc)
+{
+  sack_scoreboard_t *sb = &tc->sack_sb;
+  sack_scoreboard_hole_t *hole;
+  f64 now, reo_wnd, tx_time, remaining, timeout = 0;
+  u32 lost = 0;
+
+  if (!tc->rack.xmit_ts)
+    return 0;
+
+  now = tcp_time_now_us (tc->c_thread_index);
+  reo_wnd = clib_min (tc->rack.min_rtt / 4, tc->srtt * TCP_TICK);
+
+  sb->lost_bytes = 0;
+  hole = scoreboard_first_hole (sb);
+  while (hole)
+    {
+      if (!hole->is_lost && seq_lt (hole->start, tc->rack.end_seq))
+	{
+	  tx_time = tcp_bt_seq_tx_time (tc, hole->start);
+	  if (tx_time && tx_time <= tc->rack.xmit_ts)
+	    {
+	      remaining = tx_time + tc->rack.rtt + reo_wnd - now;
+	      if (remaining <= 0)
+		{
+		  hole->is_lost = 1;
+		  lost += hole->end - hole->start;
+		}
+	      else
+		timeout = clib_max (timeout, remaining);
+	    }
+	}
+      if (hole->is_lost)
+	sb->lost_bytes += hole->end - hole->start;
+      hole = scoreboard_next_hole (sb, hole);
+    }
+
+  sb->last_lost_bytes += lost;
+
+  if (timeout)
+    tcp_rack_timer_update (tc, TCP_RACK_TIMER_REO, timeout);
+  else if (tc->rack.timer_id == TCP_RACK_TIMER_REO)
+    tcp_rack_timer_reset (tc);
+
+  return lost;
+}
+
+/**
+ * Arm the tail loss probe timer, if possible
+ *
+ * Called when new data is sent and when acks are received.
+ */
+void
+tcp_rack_tlp_schedule (tcp_connection_t * tc)
+{
+  f64 pto;
+
+  if (tc->snd_una == tc->snd_nxt || tcp_in_cong_recovery (tc)
+      || tc->rack.tlp_pending || !tc->srtt)
+    {
+      if (tc->rack.timer_id == TCP_RACK_TIMER_TLP)
+	tcp_rack_timer_reset (tc);
+      return;
+    }
+
+  /* Reordering timer takes precedence */
+  if (tc->rack.timer != TCP_TIMER_HANDLE_INVALID
+      && tc->rack.timer_id == TCP_RACK_TIMER_REO)
+    return;
+
+  pto = 2 * tc->srtt * TCP_TICK;
+  if (tcp_flight_size (tc) <= tc->snd_mss)
+    pto += TCP_TLP_WC_DELACK;
+  pto = clib_max (pto, TCP_TLP_MIN_PTO);
+
+  /* Let the retransmit timer deal with it */
+  if (pto >= tc->rto * TCP_TICK
+      || pto >= TCP_RACK_TIMER_MAX_TICKS * TCP_RACK_TIMER_TICK)
+    {
+      tcp_rack_timer_reset (tc);
+      return;
+    }
+
+  tcp_rack_timer_update (tc, TCP_RACK_TIMER_TLP, pto);
+}
+
+/**
+ * Check if ack confirms loss repaired by tail loss probe
+ *
+ * Must be called before sacks are processed, as it looks for dsacks, and
+ * before snd_una is updated.
+ */
+void
+tcp_rack_tlp_rcv_ack (tcp_connection_t * tc, u32 ack)
+{
+  tcp_rack_t *rack = &tc->rack;
+  sack_block_t *blk;
+
+  if (!rack->tlp_pending || seq_lt (ack, rack->tlp_high_seq))
+    return;
+
+  if (!rack->tlp_is_rxt)
+    goto done;
+
+  /* Probe was only needed if the peer reports it as duplicate */
+  vec_foreach (blk, tc->rcv_opts.sacks)
+  {
+    if (blk->end == rack->tlp_high_seq && seq_leq (blk->end, ack))
+      goto done;
+  }
+
+  if (seq_gt (ack, rack->tlp_high_seq))
+    {
+      if (tcp_in_cong_recovery (tc))
+	goto done;
+
+      /* Probe repaired a loss. Reduce cwnd as if in fast recovery */
+      TCP_EVT_DBG (TCP_EVT_CC_EVT, tc, 4);
+      tc->prev_ssthresh = tc->ssthresh;
+      tc->prev_cwnd = tc->cwnd;
+      tc->cc_algo->congestion (tc);
+      tcp_cc_recovered (tc);
+      goto done;
+    }
+
+  /* Pure duplicate ack, probably no loss */
+  if (ack != tc->snd_una)
+    return;
+
+done:
+  rack->tlp_pending = 0;
+}
+
+static void
+tcp_rack_tlp_timeout (tcp_worker_ctx_t * wrk, tcp_connection_t * tc)
+{
+  if (tc->state < TCP_STATE_ESTABLISHED || tcp_in_cong_recovery (tc)
+      || tc->rack.tlp_pending || tc->snd_una == tc->snd_nxt
+      || (tc->flags & TCP_CONN_FINSNT))
+    return;
+
+  tcp_send_tail_loss_probe (wrk, tc);
+}
+
+static void
+tcp_rack_reo_timeout (tcp_worker_ctx_t * wrk, tcp_connection_t * tc)
+{
+  tcp_rate_sample_t rs = { 0 };
+
+  if (tc->state < TCP_STATE_ESTABLISHED || tcp_in_recovery (tc))
+    return;
+
+  if (!tcp_rack_detect_loss (tc))
+    return;
+
+  if (!tcp_in_fastrecovery (tc))
+    tcp_cc_fastrecovery_enter (tc, &rs);
+  else
+    tcp_program_fastretransmit (wrk, tc);
+}
+
+void
+tcp_rack_expired_timers_dispatch (u32 * expired_timers)
+{
+  u32 thread_index = vlib_get_thread_index ();
+  tcp_worker_ctx_t *wrk = tcp_get_worker (thread_index);
+  u32 connection_index, timer_id;
+  tcp_connection_t *tc;
+  int i;
+
+  for (i = 0; i < vec_len (expired_timers); i++)
+    {
+      connection_index = expired_timers[i] & 0x0FFFFFFF;
+      timer_id = expired_timers[i] >> 28;
+
+      tc = tcp_connection_get (connection_index, thread_index);
+      if (PREDICT_FALSE (tc == 0))
+	continue;
+
+      tc->rack.timer = TCP_TIMER_HANDLE_INVALID;
+      TCP_EVT_DBG (TCP_EVT_TIMER_POP, connection_index, timer_id);
+
+      if (timer_id == TCP_RACK_TIMER_TLP)
+	tcp_rack_tlp_timeout (wrk, tc);
+      else
+	tcp_rack_reo_timeout (wrk, tc);
+    }
+}
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -443,6 +443,8 @@ udp_init (vlib_main_t * vm)
   vec_validate (um->connection_peekers, num_threads - 1);
   vec_validate (um->peekers_readers_locks, num_threads - 1);
   vec_validate (um->peekers_write_locks, num_threads - 1);
+  vec_validate_aligned (um->rx_batches, num_threads - 1,
+			CLIB_CACHE_LINE_BYTES);
 
   if (num_threads > 1)
     for (i = 0; i < num_threads; i++)
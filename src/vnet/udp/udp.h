@@ -25,6 +25,7 @@
 
 #include <vnet/ip/ip.h>
 #include <vnet/session/transport.h>
+#include <vnet/session/session_types.h>
 
 typedef enum
 {
@@ -44,6 +45,19 @@ typedef struct
   u8 owns_port;				/**< does port belong to conn (UDPC) */
 } udp_connection_t;
 
+/**
+ * Datagrams received in a row for the same session, enqueued together
+ */
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  session_dgram_hdr_t hdrs[VLIB_FRAME_SIZE];
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE];
+  u32 session_index;
+  u32 n_dgrams;
+  u32 n_bytes;				/**< bytes to enqueue, headers incl. */
+} udp_rx_batch_t;
+
 #define foreach_udp4_dst_port			\
 _ (53, dns)					\
 _ (67, dhcp_to_server)                          \
@@ -144,6 +158,9 @@ typedef struct
   clib_spinlock_t *peekers_write_locks;
   udp_connection_t *listener_pool;
 
+  /** Per-worker thread rx batches */
+  udp_rx_batch_t *rx_batches;
+
 } udp_main_t;
 
 extern udp_main_t udp_main;
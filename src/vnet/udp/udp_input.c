@@ -76,6 +76,38 @@ udp_input_inc_counter (vlib_main_t * vm, u8 is_ip4, u8 evt, u8 val)
     vlib_node_increment_counter (vm, udp6_input_node.index, evt, val);
 }
 
+/**
+ * Enqueue datagrams batched for a session with one fifo update
+ */
+static void
+udp_input_batch_flush (udp_rx_batch_t * batch, u32 thread_index)
+{
+  udp_connection_t *uc;
+  session_t *s;
+  int wrote;
+
+  if (!batch->n_dgrams)
+    return;
+
+  s = session_get (batch->session_index, thread_index);
+  if (s->session_state == SESSION_STATE_LISTENING)
+    uc = udp_get_connection_from_transport (listen_session_get_transport (s));
+  else
+    uc = udp_get_connection_from_transport (session_get_transport (s));
+
+  clib_spinlock_lock (&uc->rx_lock);
+  wrote = session_enqueue_dgram_connection_batch (s, batch->hdrs,
+						  batch->bufs,
+						  batch->n_dgrams,
+						  TRANSPORT_PROTO_UDP,
+						  1 /* queue evt */ );
+  clib_spinlock_unlock (&uc->rx_lock);
+  ASSERT (wrote == batch->n_bytes);
+
+  batch->n_dgrams = 0;
+  batch->n_bytes = 0;
+}
+
 always_inline uword
 udp46_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 		    vlib_frame_t * frame, u8 is_ip4)
@@ -83,6 +115,10 @@ udp46_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
   u32 n_left_from, *from, *to_next;
   u32 next_index, errors;
   u32 my_thread_index = vm->thread_index;
+  udp_rx_batch_t *batch;
+  u32 batch_thread_index = ~0;
+
+  batch = &udp_main.rx_batches[my_thread_index];
 
   from = vlib_frame_vector_args (frame);
   n_left_from = frame->n_vectors;
@@ -109,7 +145,8 @@ udp46_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 	  transport_connection_t *tc0;
 	  int wrote0;
 	  void *rmt_addr, *lcl_addr;
-	  session_dgram_hdr_t hdr0;
+	  session_dgram_hdr_t _hdr0, *hdr0 = &_hdr0;
+	  u32 len0;
 
 	  /* speculatively enqueue b0 to the current next frame */
 	  bi0 = from[0];
@@ -164,6 +201,9 @@ udp46_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 	      uc0 = udp_get_connection_from_transport (tc0);
 	      if (uc0->is_connected)
 		{
+		  /* Session is about to move, enqueue what was batched */
+		  udp_input_batch_flush (batch, batch_thread_index);
+
 		  /*
 		   * Clone the transport. It will be cleaned up with the
 		   * session once we notify the session layer.
@@ -192,6 +232,7 @@ udp46_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 	      uc0 = udp_get_connection_from_transport (tc0);
 	      if (uc0->is_connected)
 		{
+		  udp_input_batch_flush (batch, batch_thread_index);
 		  child0 = udp_connection_alloc (my_thread_index);
 		  if (is_ip4)
 		    {
@@ -231,29 +272,60 @@ udp46_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 	    }
 
 
-	  if (svm_fifo_max_enqueue_prod (s0->rx_fifo)
-	      < b0->current_length + sizeof (session_dgram_hdr_t))
+	  len0 = vlib_buffer_length_in_chain (vm, b0);
+
+	  /*
+	   * Datagrams for sessions of this thread and for listeners are
+	   * batched while they hit the same session, so that the fifo and
+	   * the app are updated once per run. Others are enqueued one by one,
+	   * to avoid holding peeker locks.
+	   */
+	  if (PREDICT_TRUE (s0->thread_index == my_thread_index
+			    || s0->session_state == SESSION_STATE_LISTENING))
 	    {
+	      if (batch->n_dgrams
+		  && (batch->session_index != s0->session_index
+		      || batch_thread_index != s0->thread_index))
+		udp_input_batch_flush (batch, batch_thread_index);
+
+	      if (svm_fifo_max_enqueue_prod (s0->rx_fifo)
+		  < batch->n_bytes + len0 + sizeof (session_dgram_hdr_t))
+		{
+		  error0 = UDP_ERROR_FIFO_FULL;
+		  goto trace0;
+		}
+	      batch->session_index = s0->session_index;
+	      batch_thread_index = s0->thread_index;
+	      batch->bufs[batch->n_dgrams] = b0;
+	      batch->n_bytes += len0 + sizeof (session_dgram_hdr_t);
+	      hdr0 = &batch->hdrs[batch->n_dgrams++];
+	    }
+	  else if (svm_fifo_max_enqueue_prod (s0->rx_fifo)
+		   < len0 + sizeof (session_dgram_hdr_t))
+	    {
+	      session_pool_remove_peeker (s0->thread_index);
 	      error0 = UDP_ERROR_FIFO_FULL;
 	      goto trace0;
 	    }
-	  hdr0.data_length = b0->current_length;
-	  hdr0.data_offset = 0;
-	  ip_set (&hdr0.lcl_ip, lcl_addr, is_ip4);
-	  ip_set (&hdr0.rmt_ip, rmt_addr, is_ip4);
-	  hdr0.lcl_port = udp0->dst_port;
-	  hdr0.rmt_port = udp0->src_port;
-	  hdr0.is_ip4 = is_ip4;
-
-	  clib_spinlock_lock (&uc0->rx_lock);
-	  wrote0 = session_enqueue_dgram_connection (s0, &hdr0, b0,
-						     TRANSPORT_PROTO_UDP,
-						     1 /* queue evt */ );
-	  clib_spinlock_unlock (&uc0->rx_lock);
-	  ASSERT (wrote0 > 0);
-
-	  if (s0->session_state != SESSION_STATE_LISTENING)
-	    session_pool_remove_peeker (s0->thread_index);
+
+	  hdr0->data_length = len0;
+	  hdr0->data_offset = 0;
+	  ip_set (&hdr0->lcl_ip, lcl_addr, is_ip4);
+	  ip_set (&hdr0->rmt_ip, rmt_addr, is_ip4);
+	  hdr0->lcl_port = udp0->dst_port;
+	  hdr0->rmt_port = udp0->src_port;
+	  hdr0->is_ip4 = is_ip4;
+
+	  if (hdr0 == &_hdr0)
+	    {
+	      clib_spinlock_lock (&uc0->rx_lock);
+	      wrote0 = session_enqueue_dgram_connection (s0, hdr0, b0,
+							 TRANSPORT_PROTO_UDP,
+							 1 /* queue evt */ );
+	      clib_spinlock_unlock (&uc0->rx_lock);
+	      ASSERT (wrote0 > 0);
+	      session_pool_remove_peeker (s0->thread_index);
+	    }
 
 	trace0:
 
@@ -278,6 +350,8 @@ udp46_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
       vlib_put_next_frame (vm, node, next_index, n_left_to_next);
     }
 
+  udp_input_batch_flush (batch, batch_thread_index);
+
   errors = session_main_flush_all_enqueue_events (TRANSPORT_PROTO_UDP);
   udp_input_inc_counter (vm, is_ip4, UDP_ERROR_EVENT_FIFO_FULL, errors);
   return frame->n_vectors;
@@ -38,6 +38,8 @@ struct stat_client_main_t
   stat_segment_shared_header_t *shared_header;
   stat_segment_directory_entry_t *directory_vector;
   ssize_t memory_size;
+  /* last values returned by stat_segment_dump_delta, by directory index */
+  stat_segment_data_t *delta_cache;
 };
 
 stat_client_main_t stat_client_main;
@@ -162,9 +164,17 @@ stat_segment_connect (const char *socket_name)
   return stat_segment_connect_r (socket_name, sm);
 }
 
+static void free_data (stat_segment_data_t * d);
+
 void
 stat_segment_disconnect_r (stat_client_main_t * sm)
 {
+  int i;
+
+  for (i = 0; i < vec_len (sm->delta_cache); i++)
+    free_data (&sm->delta_cache[i]);
+  vec_free (sm->delta_cache);
+
   munmap (sm->shared_header, sm->memory_size);
   return;
 }
@@ -316,29 +326,168 @@ copy_data (stat_segment_directory_entry_t * ep, stat_client_main_t * sm)
   return result;
 }
 
-void
-stat_segment_data_free (stat_segment_data_t * res)
+static inline void
+sum_counters (counter_t * sum, counter_t * v, int n)
 {
-  int i, j;
-  for (i = 0; i < vec_len (res); i++)
+  int i = 0;
+
+#if defined(CLIB_HAVE_VEC256)
+  for (; i + 4 <= n; i += 4)
+    u64x4_store_unaligned (u64x4_load_unaligned (sum + i) +
+			   u64x4_load_unaligned (v + i), sum + i);
+#elif defined(CLIB_HAVE_VEC128)
+  for (; i + 2 <= n; i += 2)
+    u64x2_store_unaligned (u64x2_load_unaligned (sum + i) +
+			   u64x2_load_unaligned (v + i), sum + i);
+#endif
+  for (; i < n; i++)
+    sum[i] += v[i];
+}
+
+/*
+ * Same as copy_data, but counters of all threads are summed. Counter
+ * vectors have a single row and error vectors a single element.
+ */
+static stat_segment_data_t
+copy_data_summed (stat_segment_directory_entry_t * ep,
+		  stat_client_main_t * sm)
+{
+  stat_segment_data_t result = { 0 };
+  uint64_t *offset_vector;
+  counter_t **simple_c, *sum = 0;
+  vlib_counter_t **combined_c, *csum = 0;
+  int i, len;
+
+  switch (ep->type)
     {
-      switch (res[i].type)
+    case STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE:
+      if (ep->offset == 0)
+	break;
+      simple_c = stat_segment_pointer (sm->shared_header, ep->offset);
+      offset_vector =
+	stat_segment_pointer (sm->shared_header, ep->offset_vector);
+      for (i = 0; i < vec_len (simple_c); i++)
+	{
+	  counter_t *cb =
+	    stat_segment_pointer (sm->shared_header, offset_vector[i]);
+	  len = vec_len (cb);
+	  if (len > vec_len (sum))
+	    vec_validate (sum, len - 1);
+	  sum_counters (sum, cb, len);
+	}
+      result.type = ep->type;
+      result.name = strdup (ep->name);
+      vec_add1 (result.simple_counter_vec, sum);
+      return result;
+
+    case STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED:
+      if (ep->offset == 0)
+	break;
+      combined_c = stat_segment_pointer (sm->shared_header, ep->offset);
+      offset_vector =
+	stat_segment_pointer (sm->shared_header, ep->offset_vector);
+      for (i = 0; i < vec_len (combined_c); i++)
+	{
+	  vlib_counter_t *cb =
+	    stat_segment_pointer (sm->shared_header, offset_vector[i]);
+	  len = vec_len (cb);
+	  if (len > vec_len (csum))
+	    vec_validate (csum, len - 1);
+	  /* packets and bytes are summed alike */
+	  sum_counters ((counter_t *) csum, (counter_t *) cb, 2 * len);
+	}
+      result.type = ep->type;
+      result.name = strdup (ep->name);
+      vec_add1 (result.combined_counter_vec, csum);
+      return result;
+
+    case STAT_DIR_TYPE_ERROR_INDEX:
+      offset_vector = stat_segment_pointer (sm->shared_header,
+					    sm->shared_header->error_offset);
+      vec_validate (result.error_vector, 0);
+      for (i = 0; i < vec_len (offset_vector); i++)
 	{
-	case STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE:
-	  for (j = 0; j < vec_len (res[i].simple_counter_vec); j++)
-	    vec_free (res[i].simple_counter_vec[j]);
-	  vec_free (res[i].simple_counter_vec);
-	  break;
-	case STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED:
-	  for (j = 0; j < vec_len (res[i].combined_counter_vec); j++)
-	    vec_free (res[i].combined_counter_vec[j]);
-	  vec_free (res[i].combined_counter_vec);
-	  break;
-	default:
-	  ;
+	  counter_t *cb =
+	    stat_segment_pointer (sm->shared_header, offset_vector[i]);
+	  result.error_vector[0] += cb[ep->index];
 	}
-      free (res[i].name);
+      result.type = ep->type;
+      result.name = strdup (ep->name);
+      return result;
+
+    default:
+      break;
+    }
+
+  return copy_data (ep, sm);
+}
+
+/*
+ * Copy a directory entry. Retries if a writer changed the entry while it
+ * was being copied
+ */
+static stat_segment_data_t
+copy_entry (stat_client_main_t * sm, uint32_t index, int summed,
+	    uint64_t * entry_epoch)
+{
+  stat_segment_directory_entry_t *ep;
+  stat_segment_data_t result;
+  uint64_t seq;
+
+  ep = vec_elt_at_index (sm->directory_vector, index);
+
+  while (1)
+    {
+      while ((seq = clib_atomic_load_acq_n (&ep->seq)) & 1)
+	;
+      if (entry_epoch)
+	*entry_epoch = ep->epoch;
+      result = summed ? copy_data_summed (ep, sm) : copy_data (ep, sm);
+      CLIB_MEMORY_BARRIER ();
+      if (ep->seq == seq)
+	return result;
+      free_data (&result);
+    }
+}
+
+static void
+free_data (stat_segment_data_t * d)
+{
+  int j;
+
+  switch (d->type)
+    {
+    case STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE:
+      for (j = 0; j < vec_len (d->simple_counter_vec); j++)
+	vec_free (d->simple_counter_vec[j]);
+      vec_free (d->simple_counter_vec);
+      break;
+    case STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED:
+      for (j = 0; j < vec_len (d->combined_counter_vec); j++)
+	vec_free (d->combined_counter_vec[j]);
+      vec_free (d->combined_counter_vec);
+      break;
+    case STAT_DIR_TYPE_ERROR_INDEX:
+      vec_free (d->error_vector);
+      break;
+    case STAT_DIR_TYPE_NAME_VECTOR:
+      for (j = 0; j < vec_len (d->name_vector); j++)
+	vec_free (d->name_vector[j]);
+      vec_free (d->name_vector);
+      break;
+    default:
+      ;
     }
+  free (d->name);
+  clib_memset (d, 0, sizeof (*d));
+}
+
+void
+stat_segment_data_free (stat_segment_data_t * res)
+{
+  int i;
+  for (i = 0; i < vec_len (res); i++)
+    free_data (&res[i]);
   vec_free (res);
 }
 
@@ -406,7 +555,6 @@ stat_segment_data_t *
 stat_segment_dump_r (uint32_t * stats, stat_client_main_t * sm)
 {
   int i;
-  stat_segment_directory_entry_t *ep;
   stat_segment_data_t *res = 0;
   stat_segment_access_t sa;
 
@@ -418,14 +566,14 @@ stat_segment_dump_r (uint32_t * stats, stat_client_main_t * sm)
   for (i = 0; i < vec_len (stats); i++)
     {
       /* Collect counter */
-      ep = vec_elt_at_index (sm->directory_vector, stats[i]);
-      vec_add1 (res, copy_data (ep, sm));
+      vec_add1 (res, copy_entry (sm, stats[i], 0 /* summed */ , 0));
     }
 
   if (stat_segment_access_end (&sa, sm))
     return res;
 
   fprintf (stderr, "Epoch changed while reading, invalid results\n");
+  stat_segment_data_free (res);
   // TODO increase counter
   return 0;
 }
@@ -437,6 +585,141 @@ stat_segment_dump (uint32_t * stats)
   return stat_segment_dump_r (stats, sm);
 }
 
+static bool
+data_equal (stat_segment_data_t * a, stat_segment_data_t * b)
+{
+  counter_t *va, *vb;
+  vlib_counter_t *ca, *cb;
+
+  if (a->type != b->type)
+    return false;
+
+  switch (a->type)
+    {
+    case STAT_DIR_TYPE_SCALAR_INDEX:
+      return a->scalar_value == b->scalar_value;
+
+    case STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE:
+      va = vec_len (a->simple_counter_vec) ? a->simple_counter_vec[0] : 0;
+      vb = vec_len (b->simple_counter_vec) ? b->simple_counter_vec[0] : 0;
+      return vec_len (va) == vec_len (vb)
+	&& !memcmp (va, vb, vec_len (va) * sizeof (va[0]));
+
+    case STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED:
+      ca = vec_len (a->combined_counter_vec) ? a->combined_counter_vec[0] : 0;
+      cb = vec_len (b->combined_counter_vec) ? b->combined_counter_vec[0] : 0;
+      return vec_len (ca) == vec_len (cb)
+	&& !memcmp (ca, cb, vec_len (ca) * sizeof (ca[0]));
+
+    case STAT_DIR_TYPE_ERROR_INDEX:
+      return vec_len (a->error_vector) == vec_len (b->error_vector)
+	&& !memcmp (a->error_vector, b->error_vector,
+		    vec_len (a->error_vector) * sizeof (counter_t));
+
+    default:
+      /* names only change with the directory entry */
+      return true;
+    }
+}
+
+/* Copy of the values compared by data_equal */
+static stat_segment_data_t
+dup_data_values (stat_segment_data_t * d)
+{
+  stat_segment_data_t result = { 0 };
+
+  result.type = d->type;
+  switch (d->type)
+    {
+    case STAT_DIR_TYPE_SCALAR_INDEX:
+      result.scalar_value = d->scalar_value;
+      break;
+    case STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE:
+      if (vec_len (d->simple_counter_vec))
+	vec_add1 (result.simple_counter_vec,
+		  vec_dup (d->simple_counter_vec[0]));
+      break;
+    case STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED:
+      if (vec_len (d->combined_counter_vec))
+	vec_add1 (result.combined_counter_vec,
+		  vec_dup (d->combined_counter_vec[0]));
+      break;
+    case STAT_DIR_TYPE_ERROR_INDEX:
+      result.error_vector = vec_dup (d->error_vector);
+      break;
+    default:
+      ;
+    }
+  return result;
+}
+
+/*
+ * Dump only the stats that changed since the previous call, with counters
+ * summed over all threads: counter vectors have a single row and error
+ * vectors a single element.
+ *
+ * An entry is returned if its directory entry changed after *epoch, or
+ * if its value differs from the one returned by the previous call on this
+ * client. *epoch is updated for the next call, start with 0 to get all
+ * entries. Returns -1 if the directory changed and the stats must be
+ * listed again with stat_segment_ls_r.
+ */
+int
+stat_segment_dump_delta_r (uint32_t * stats, uint64_t * epoch,
+			   stat_segment_data_t ** res,
+			   stat_client_main_t * sm)
+{
+  stat_segment_data_t *out = 0, d, *cached;
+  stat_segment_access_t sa;
+  uint64_t entry_epoch, next_epoch;
+  int i;
+
+  *res = 0;
+
+  /* Has directory been update? */
+  if (sm->shared_header->epoch != sm->current_epoch)
+    return -1;
+
+  next_epoch = sm->shared_header->entry_epoch;
+
+  stat_segment_access_start (&sa, sm);
+  for (i = 0; i < vec_len (stats); i++)
+    {
+      d = copy_entry (sm, stats[i], 1 /* summed */ , &entry_epoch);
+      vec_validate (sm->delta_cache, stats[i]);
+      cached = vec_elt_at_index (sm->delta_cache, stats[i]);
+      if (entry_epoch <= *epoch && data_equal (&d, cached))
+	{
+	  free_data (&d);
+	  continue;
+	}
+      free_data (cached);
+      *cached = dup_data_values (&d);
+      vec_add1 (out, d);
+    }
+
+  if (!stat_segment_access_end (&sa, sm))
+    {
+      /* Nothing returned, so forget what was cached */
+      for (i = 0; i < vec_len (stats); i++)
+	free_data (vec_elt_at_index (sm->delta_cache, stats[i]));
+      stat_segment_data_free (out);
+      return -1;
+    }
+
+  *epoch = next_epoch;
+  *res = out;
+  return 0;
+}
+
+int
+stat_segment_dump_delta (uint32_t * stats, uint64_t * epoch,
+			 stat_segment_data_t ** res)
+{
+  stat_client_main_t *sm = &stat_client_main;
+  return stat_segment_dump_delta_r (stats, epoch, res, sm);
+}
+
 /* Wrapper for accessing vectors from other languages */
 int
 stat_segment_vec_len (void *vec)
@@ -465,18 +748,17 @@ stat_segment_string_vector (uint8_t ** string_vector, const char *string)
 stat_segment_data_t *
 stat_segment_dump_entry_r (uint32_t index, stat_client_main_t * sm)
 {
-  stat_segment_directory_entry_t *ep;
   stat_segment_data_t *res = 0;
   stat_segment_access_t sa;
 
   stat_segment_access_start (&sa, sm);
 
   /* Collect counter */
-  ep = vec_elt_at_index (sm->directory_vector, index);
-  vec_add1 (res, copy_data (ep, sm));
+  vec_add1 (res, copy_entry (sm, index, 0 /* summed */ , 0));
 
   if (stat_segment_access_end (&sa, sm))
     return res;
+  stat_segment_data_free (res);
   return 0;
 }
 
@@ -0,0 +1,412 @@
+/*
+ * test_stat_client.c - stat client tests against a local stat segment
+ *
+ * Copyright (c) 2019 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Builds a stat segment the way vpp lays it out, serves its fd on a
+ * socket and checks what the client library reads from it, while the
+ * test plays the part of vpp's writers.
+ */
+
+#define _GNU_SOURCE
+#include <vpp-api/client/stat_client.h>
+#include <vpp/stats/stat_segment.h>
+#include <vppinfra/linux/syscall.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <pthread.h>
+
+#define STAT_TEST_SEGMENT_SIZE	(1 << 20)
+#define STAT_TEST_N_THREADS	2
+#define STAT_TEST_N_COUNTERS	4
+
+#define STAT_TEST(_cond, _comment, _args...)			\
+{								\
+  if (!(_cond))							\
+    {								\
+      fformat (stderr, "FAIL:%d: " _comment "\n",		\
+	       __LINE__, ##_args);				\
+      return 1;							\
+    }								\
+  fformat (stdout, "PASS: " _comment "\n", ##_args);		\
+}
+
+enum
+{
+  STAT_TEST_SCALAR,
+  STAT_TEST_SIMPLE,
+  STAT_TEST_COMBINED,
+  STAT_TEST_ERROR,
+  STAT_TEST_N_ENTRIES,
+};
+
+typedef struct
+{
+  void *heap;
+  int memfd;
+  stat_segment_shared_header_t *shared_header;
+  stat_segment_directory_entry_t *directory_vector;
+  counter_t **simple;
+  vlib_counter_t **combined;
+  counter_t **errors;
+  char *socket_name;
+} stat_test_main_t;
+
+static stat_test_main_t stat_test_main;
+
+static u64
+stat_test_offset (void *data)
+{
+  return stat_segment_offset (stat_test_main.shared_header, data);
+}
+
+/* Vector of per thread counter vectors, and the offsets clients use */
+static void
+stat_test_simple_validate (stat_segment_directory_entry_t * ep, u32 max)
+{
+  stat_test_main_t *tm = &stat_test_main;
+  u64 *offset_vector = 0;
+  int i;
+
+  vec_validate (tm->simple, STAT_TEST_N_THREADS - 1);
+  vec_validate (offset_vector, STAT_TEST_N_THREADS - 1);
+  for (i = 0; i < STAT_TEST_N_THREADS; i++)
+    {
+      vec_validate (tm->simple[i], max);
+      offset_vector[i] = stat_test_offset (tm->simple[i]);
+    }
+  ep->offset = stat_test_offset (tm->simple);
+  ep->offset_vector = stat_test_offset (offset_vector);
+}
+
+static int
+stat_test_segment_init (void)
+{
+  stat_test_main_t *tm = &stat_test_main;
+  stat_segment_shared_header_t *shared_header;
+  stat_segment_directory_entry_t *ep;
+  u64 *offset_vector = 0;
+  void *memaddr, *oldheap;
+  int i;
+
+  if ((tm->memfd = memfd_create ("stat_test", 0)) < 0)
+    return -1;
+  if (ftruncate (tm->memfd, STAT_TEST_SEGMENT_SIZE) == -1)
+    return -1;
+  memaddr = mmap (0, STAT_TEST_SEGMENT_SIZE, PROT_READ | PROT_WRITE,
+		  MAP_SHARED, tm->memfd, 0);
+  if (memaddr == MAP_FAILED)
+    return -1;
+
+#if USE_DLMALLOC == 0
+  tm->heap = mheap_alloc_with_flags (((u8 *) memaddr) + getpagesize (),
+				     STAT_TEST_SEGMENT_SIZE - getpagesize (),
+				     MHEAP_FLAG_DISABLE_VM);
+#else
+  tm->heap = create_mspace_with_base (((u8 *) memaddr) + getpagesize (),
+				      STAT_TEST_SEGMENT_SIZE -
+				      getpagesize (), 0 /* locked */ );
+  mspace_disable_expand (tm->heap);
+#endif
+
+  tm->shared_header = shared_header = memaddr;
+  shared_header->version = STAT_SEGMENT_VERSION;
+  shared_header->epoch = 1;
+  shared_header->entry_epoch = 1;
+
+  oldheap = clib_mem_set_heap (tm->heap);
+
+  vec_validate (tm->directory_vector, STAT_TEST_N_ENTRIES - 1);
+
+  ep = &tm->directory_vector[STAT_TEST_SCALAR];
+  ep->type = STAT_DIR_TYPE_SCALAR_INDEX;
+  ep->value = 7;
+  strcpy (ep->name, "/test/scalar");
+
+  ep = &tm->directory_vector[STAT_TEST_SIMPLE];
+  ep->type = STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE;
+  strcpy (ep->name, "/test/simple");
+  stat_test_simple_validate (ep, STAT_TEST_N_COUNTERS - 1);
+  for (i = 0; i < STAT_TEST_N_COUNTERS; i++)
+    {
+      tm->simple[0][i] = i;
+      tm->simple[1][i] = 10 * i;
+    }
+
+  ep = &tm->directory_vector[STAT_TEST_COMBINED];
+  ep->type = STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED;
+  strcpy (ep->name, "/test/combined");
+  vec_validate (tm->combined, STAT_TEST_N_THREADS - 1);
+  for (i = 0; i < STAT_TEST_N_THREADS; i++)
+    {
+      vec_validate (tm->combined[i], 0);
+      tm->combined[i][0].packets = i + 1;
+      tm->combined[i][0].bytes = 100 * (i + 1);
+      vec_add1 (offset_vector, stat_test_offset (tm->combined[i]));
+    }
+  ep->offset = stat_test_offset (tm->combined);
+  ep->offset_vector = stat_test_offset (offset_vector);
+
+  /* Error counters of all nodes, per thread */
+  ep = &tm->directory_vector[STAT_TEST_ERROR];
+  ep->type = STAT_DIR_TYPE_ERROR_INDEX;
+  ep->index = 1;
+  strcpy (ep->name, "/test/error");
+  offset_vector = 0;
+  vec_validate (tm->errors, STAT_TEST_N_THREADS - 1);
+  for (i = 0; i < STAT_TEST_N_THREADS; i++)
+    {
+      vec_validate (tm->errors[i], 1);
+      tm->errors[i][1] = 3;
+      vec_add1 (offset_vector, stat_test_offset (tm->errors[i]));
+    }
+  shared_header->error_offset = stat_test_offset (offset_vector);
+
+  for (i = 0; i < STAT_TEST_N_ENTRIES; i++)
+    tm->directory_vector[i].epoch = 1;
+  shared_header->directory_offset = stat_test_offset (tm->directory_vector);
+
+  clib_mem_set_heap (oldheap);
+  return 0;
+}
+
+/* Hand the segment fd to one client, like vpp's stats socket does */
+static int
+stat_test_serve_fd (void)
+{
+  stat_test_main_t *tm = &stat_test_main;
+  clib_socket_t s = { 0 }, client = { 0 };
+  clib_error_t *err;
+  pid_t pid;
+
+  s.config = tm->socket_name;
+  s.flags = CLIB_SOCKET_F_IS_SERVER | CLIB_SOCKET_F_SEQPACKET;
+  if ((err = clib_socket_init (&s)))
+    {
+      clib_error_report (err);
+      return -1;
+    }
+
+  if ((pid = fork ()) < 0)
+    return -1;
+
+  if (pid == 0)
+    {
+      if ((err = clib_socket_accept (&s, &client)))
+	_exit (1);
+      if ((err = clib_socket_sendmsg (&client, 0, 0, &tm->memfd, 1)))
+	_exit (1);
+      _exit (0);
+    }
+
+  clib_socket_close (&s);
+  return pid;
+}
+
+static stat_segment_data_t *
+stat_test_find (stat_segment_data_t * res, char *name)
+{
+  stat_segment_data_t *d;
+
+  vec_foreach (d, res)
+  {
+    if (!strcmp (d->name, name))
+      return d;
+  }
+  return 0;
+}
+
+static void *
+stat_test_writer_fn (void *arg)
+{
+  stat_test_main_t *tm = &stat_test_main;
+  stat_segment_directory_entry_t *ep;
+
+  ep = &tm->directory_vector[STAT_TEST_SIMPLE];
+
+  /* Leave the client spinning on the odd seq for a while */
+  usleep (10000);
+  tm->simple[1][0] = 1000;
+  stat_segment_entry_update_end (tm->shared_header, ep);
+  return 0;
+}
+
+static int
+stat_test_delta (stat_client_main_t * sm, u32 * stats)
+{
+  stat_test_main_t *tm = &stat_test_main;
+  stat_segment_directory_entry_t *ep;
+  stat_segment_data_t *res, *d;
+  u64 epoch = 0, prev_epoch;
+  pthread_t writer;
+  void *oldheap;
+  int rv;
+
+  /* First dump returns all entries, counters summed over threads */
+  rv = stat_segment_dump_delta_r (stats, &epoch, &res, sm);
+  STAT_TEST (rv == 0 && vec_len (res) == STAT_TEST_N_ENTRIES,
+	     "first delta returns all %u entries", vec_len (res));
+  STAT_TEST (epoch == tm->shared_header->entry_epoch, "epoch updated");
+
+  d = stat_test_find (res, "/test/scalar");
+  STAT_TEST (d && d->scalar_value == 7, "scalar value");
+  d = stat_test_find (res, "/test/simple");
+  STAT_TEST (d && vec_len (d->simple_counter_vec) == 1
+	     && vec_len (d->simple_counter_vec[0]) == STAT_TEST_N_COUNTERS
+	     && d->simple_counter_vec[0][3] == 33,
+	     "simple counters summed in one row");
+  d = stat_test_find (res, "/test/combined");
+  STAT_TEST (d && vec_len (d->combined_counter_vec) == 1
+	     && d->combined_counter_vec[0][0].packets == 3
+	     && d->combined_counter_vec[0][0].bytes == 300,
+	     "combined counters summed in one row");
+  d = stat_test_find (res, "/test/error");
+  STAT_TEST (d && vec_len (d->error_vector) == 1 && d->error_vector[0] == 6,
+	     "errors summed in one element");
+  stat_segment_data_free (res);
+
+  /* Nothing changed */
+  prev_epoch = epoch;
+  rv = stat_segment_dump_delta_r (stats, &epoch, &res, sm);
+  STAT_TEST (rv == 0 && vec_len (res) == 0 && epoch == prev_epoch,
+	     "unchanged stats not returned");
+  stat_segment_data_free (res);
+
+  /* Counters change without their entry changing */
+  tm->simple[0][2] += 5;
+  tm->errors[1][1] += 1;
+  rv = stat_segment_dump_delta_r (stats, &epoch, &res, sm);
+  STAT_TEST (rv == 0 && vec_len (res) == 2, "changed values returned");
+  d = stat_test_find (res, "/test/simple");
+  STAT_TEST (d && d->simple_counter_vec[0][2] == 27, "new simple sum %lu",
+	     d ? d->simple_counter_vec[0][2] : 0);
+  d = stat_test_find (res, "/test/error");
+  STAT_TEST (d && d->error_vector[0] == 7, "new error sum");
+  stat_segment_data_free (res);
+
+  /*
+   * Grow the simple counter vector like vlib_stats_pop_heap: only the
+   * entry is versioned, the directory epoch doesn't change
+   */
+  ep = &tm->directory_vector[STAT_TEST_SIMPLE];
+  prev_epoch = ep->epoch;
+  stat_segment_entry_update_start (ep);
+  oldheap = clib_mem_set_heap (tm->heap);
+  stat_test_simple_validate (ep, 2 * STAT_TEST_N_COUNTERS - 1);
+  clib_mem_set_heap (oldheap);
+  stat_segment_entry_update_end (tm->shared_header, ep);
+  STAT_TEST (ep->epoch > prev_epoch && !(ep->seq & 1), "entry versioned");
+
+  rv = stat_segment_dump_delta_r (stats, &epoch, &res, sm);
+  STAT_TEST (rv == 0 && vec_len (res) == 1, "grown entry returned");
+  STAT_TEST (vec_len (res[0].simple_counter_vec[0]) ==
+	     2 * STAT_TEST_N_COUNTERS, "grown entry has new length");
+  stat_segment_data_free (res);
+
+  res = stat_segment_dump_r (stats, sm);
+  STAT_TEST (res != 0, "full dump still valid after entry change");
+  stat_segment_data_free (res);
+
+  /* Client retries an entry that is being changed */
+  stat_segment_entry_update_start (ep);
+  pthread_create (&writer, 0, stat_test_writer_fn, 0);
+  rv = stat_segment_dump_delta_r (stats, &epoch, &res, sm);
+  pthread_join (writer, 0);
+  STAT_TEST (rv == 0 && vec_len (res) == 1
+	     && res[0].simple_counter_vec[0][0] == 1000,
+	     "entry read after writer finished");
+  stat_segment_data_free (res);
+
+  /* Directory changes must be picked up with a new ls */
+  tm->shared_header->epoch++;
+  prev_epoch = epoch;
+  rv = stat_segment_dump_delta_r (stats, &epoch, &res, sm);
+  STAT_TEST (rv == -1 && res == 0 && epoch == prev_epoch,
+	     "directory change detected");
+
+  return 0;
+}
+
+static int
+stat_test_run (void)
+{
+  stat_test_main_t *tm = &stat_test_main;
+  stat_client_main_t *sm;
+  u8 **patterns = 0;
+  u32 *stats;
+  int i, pid, status, rv;
+
+  if (stat_test_segment_init ())
+    {
+      clib_unix_warning ("stat segment init failed");
+      return 1;
+    }
+
+  if ((pid = stat_test_serve_fd ()) < 0)
+    return 1;
+
+  sm = stat_client_get ();
+  rv = stat_segment_connect_r (tm->socket_name, sm);
+  waitpid (pid, &status, 0);
+  unlink (tm->socket_name);
+  STAT_TEST (rv == 0, "connected");
+
+  patterns = stat_segment_string_vector (patterns, "^/test/");
+  stats = stat_segment_ls_r (patterns, sm);
+  STAT_TEST (vec_len (stats) == STAT_TEST_N_ENTRIES, "ls found entries");
+
+  rv = stat_test_delta (sm, stats);
+
+  vec_free (stats);
+  for (i = 0; i < vec_len (patterns); i++)
+    vec_free (patterns[i]);
+  vec_free (patterns);
+  stat_segment_disconnect_r (sm);
+  stat_client_free (sm);
+  return rv;
+}
+
+int
+main (int argc, char *argv[])
+{
+  stat_test_main_t *tm = &stat_test_main;
+  unformat_input_t input;
+
+  tm->socket_name = "/tmp/test_stat_client.sock";
+
+  unformat_init_command_line (&input, argv);
+  while (unformat_check_input (&input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (&input, "socket-name %s", &tm->socket_name))
+	vec_add1 (tm->socket_name, 0);
+      else
+	{
+	  clib_warning ("unknown input '%U'", format_unformat_error, &input);
+	  return 1;
+	}
+    }
+  unformat_free (&input);
+
+  return stat_test_run ();
+}
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
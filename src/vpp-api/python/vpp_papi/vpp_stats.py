@@ -30,6 +30,8 @@ typedef struct
     uint64_t value;
   };
   uint64_t offset_vector;
+  uint64_t epoch;
+  uint64_t seq;
   char name[128]; // TODO change this to pointer to "somewhere"
 } stat_segment_directory_entry_t;
 
@@ -55,6 +57,7 @@ typedef struct
   uint64_t directory_offset;
   uint64_t error_offset;
   uint64_t stats_offset;
+  uint64_t entry_epoch;
 } stat_segment_shared_header_t;
 
 typedef struct
@@ -63,6 +66,7 @@ typedef struct
   stat_segment_shared_header_t *shared_header;
   stat_segment_directory_entry_t *directory_vector;
   ssize_t memory_size;
+  stat_segment_data_t *delta_cache;
 } stat_client_main_t;
 
 stat_client_main_t * stat_client_get(void);
@@ -78,6 +82,9 @@ stat_segment_data_t *stat_segment_dump_r (uint32_t * stats,
                                           stat_client_main_t * sm);
 stat_segment_data_t *stat_segment_dump (uint32_t * counter_vec);
 void stat_segment_data_free (stat_segment_data_t * res);
+int stat_segment_dump_delta_r (uint32_t * stats, uint64_t * epoch,
+                               stat_segment_data_t ** res,
+                               stat_client_main_t * sm);
 
 double stat_segment_heartbeat_r (stat_client_main_t * sm);
 int stat_segment_vec_len(void *vec);
@@ -523,6 +523,51 @@ out:
   return rv;
 }
 
+vapi_error_e
+vapi_send_n (vapi_ctx_t ctx, void **msgs, u32 n_msgs)
+{
+  vapi_error_e rv = VAPI_OK;
+  u32 i;
+  if (!ctx || !msgs || !ctx->connected)
+    {
+      rv = VAPI_EINVAL;
+      goto out;
+    }
+  svm_queue_t *q = api_main.shmem_hdr->vl_input_queue;
+  VAPI_DBG ("send %u messages", n_msgs);
+  if (VAPI_MODE_BLOCKING == ctx->mode)
+    {
+      svm_queue_lock (q);
+    }
+  else
+    {
+      /* all or nothing, like vapi_send2. A batch larger than the queue
+         can never fit, so it is admitted once a queue sized chunk fits
+         and the rest waits for vpp to make room */
+      if (pthread_mutex_trylock (&q->mutex))
+	{
+	  rv = VAPI_EAGAIN;
+	  goto out;
+	}
+      if (q->cursize + clib_min (n_msgs, q->maxsize) > q->maxsize)
+	{
+	  svm_queue_unlock (q);
+	  rv = VAPI_EAGAIN;
+	  goto out;
+	}
+    }
+  for (i = 0; i < n_msgs; i++)
+    {
+      while (q->cursize == q->maxsize)
+	svm_queue_wait (q);
+      svm_queue_add_raw (q, (u8 *) & msgs[i]);
+    }
+  svm_queue_unlock (q);
+out:
+  VAPI_DBG ("vapi_send_n() rv = %d", rv);
+  return rv;
+}
+
 vapi_error_e
 vapi_recv (vapi_ctx_t ctx, void **msg, size_t * msg_size,
 	   svm_q_conditional_wait_t cond, u32 time)
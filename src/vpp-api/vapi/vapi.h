@@ -157,6 +157,25 @@ extern "C"
  */
   vapi_error_e vapi_send2 (vapi_ctx_t ctx, void *msg1, void *msg2);
 
+/**
+ * @brief low-level api for sending a batch of messages to vpp, taking the
+ * shared memory queue lock only once
+ *
+ * @note in non-blocking mode either all messages are sent or none is. A
+ * batch larger than the queue is sent once the queue has room for a queue
+ * sized chunk, the remaining chunks wait for room
+ *
+ * @note it is not recommended to use this api directly, use generated api
+ * instead
+ *
+ * @param ctx opaque vapi context
+ * @param msgs array of messages to send
+ * @param n_msgs number of messages in the array
+ *
+ * @return VAPI_OK on success, other error code on error
+ */
+  vapi_error_e vapi_send_n (vapi_ctx_t ctx, void **msgs, u32 n_msgs);
+
 /**
  * @brief low-level api for reading messages from vpp
  *
@@ -26,6 +26,10 @@
 #include <functional>
 #include <algorithm>
 #include <atomic>
+#include <memory>
+#include <future>
+#include <thread>
+#include <condition_variable>
 #include <vppinfra/types.h>
 #include <vapi/vapi.h>
 #include <vapi/vapi_internal.h>
@@ -115,6 +119,21 @@ private:
     response_state = state;
   }
 
+  std::future<vapi_error_e> make_future ()
+  {
+    completion.reset (new std::promise<vapi_error_e> ());
+    return completion->get_future ();
+  }
+
+  void complete (vapi_error_e rv)
+  {
+    if (completion)
+      {
+        completion->set_value (rv);
+        completion.reset ();
+      }
+  }
+
   virtual std::tuple<vapi_error_e, bool> assign_response (vapi_msg_id_t id,
                                                           void *shm_data) = 0;
 
@@ -129,7 +148,8 @@ private:
   }
 
   u32 context;
-  vapi_response_state_e response_state;
+  std::atomic<vapi_response_state_e> response_state;
+  std::unique_ptr<std::promise<vapi_error_e>> completion;
 
   friend class Connection;
 
@@ -153,7 +173,9 @@ private:
 class Connection
 {
 public:
-  Connection (void) : vapi_ctx{0}, event_count{0}
+  Connection (void)
+      : vapi_ctx{0}, dispatching{nullptr}, event_count{0}, batching{false},
+        dispatch_thread_active{false}, dispatch_thread_stop{false}
   {
 
     vapi_error_e rv = VAPI_OK;
@@ -171,6 +193,7 @@ public:
 
   ~Connection (void)
   {
+    stop_dispatch_thread ();
     vapi_ctx_free (vapi_ctx);
 #if VAPI_CPP_DEBUG_LEAKS
     for (auto x : shm_data_set)
@@ -196,32 +219,46 @@ public:
    * @param chroot_prefix shared memory prefix
    * @param max_queued_request max number of outstanding requests queued
    * @param handle_keepalives handle memclnt_keepalive automatically
+   * @param mode in non-blocking mode, sending returns VAPI_EAGAIN instead
+   * of waiting for room in the shared memory queue
    *
    * @return VAPI_OK on success, other error code on error
    */
   vapi_error_e connect (const char *name, const char *chroot_prefix,
                         int max_outstanding_requests, int response_queue_size,
-                        bool handle_keepalives = true)
+                        bool handle_keepalives = true,
+                        vapi_mode_e mode = VAPI_MODE_BLOCKING)
   {
     return vapi_connect (vapi_ctx, name, chroot_prefix,
-                         max_outstanding_requests, response_queue_size,
-                         VAPI_MODE_BLOCKING, handle_keepalives);
+                         max_outstanding_requests, response_queue_size, mode,
+                         handle_keepalives);
   }
 
   /**
    * @brief disconnect from vpp
    *
+   * @note outstanding requests complete with VAPI_ENORESP, requests queued
+   * by start_batch() are dropped
+   *
    * @return VAPI_OK on success, other error code on error
    */
   vapi_error_e disconnect ()
   {
-    auto x = requests.size ();
-    while (x > 0)
-      {
-        VAPI_DBG ("popping request @%p", requests.front ());
-        requests.pop_front ();
-        --x;
-      }
+    stop_dispatch_thread ();
+    {
+      std::lock_guard<std::mutex> lock (send_mutex);
+      std::lock_guard<std::mutex> requests_lock (requests_mutex);
+      batching = false;
+      for (auto &e : batch)
+        {
+          if (e.ping)
+            {
+              vapi_msg_free (vapi_ctx, e.ping);
+            }
+        }
+      batch.clear ();
+      fail_requests (VAPI_ENORESP);
+    }
     return vapi_disconnect (vapi_ctx);
   };
 
@@ -243,12 +280,19 @@ public:
   /**
    * @brief wait for responses from vpp and assign them to appropriate objects
    *
+   * @note if the dispatch thread is running, this only waits for the limit
+   * object to receive it's response
+   *
    * @param limit stop dispatch after the limit object received it's response
    *
    * @return VAPI_OK on success, other error code on error
    */
   vapi_error_e dispatch (const Common_req *limit = nullptr, u32 time = 5)
   {
+    if (dispatch_thread_active)
+      {
+        return limit ? wait_for_completion (*limit, time) : VAPI_OK;
+      }
     std::lock_guard<std::mutex> lock (dispatch_mutex);
     vapi_error_e rv = VAPI_OK;
     bool loop_again = true;
@@ -262,55 +306,13 @@ public:
           {
             return rv;
           }
-#if VAPI_CPP_DEBUG_LEAKS
-        on_shm_data_alloc (shm_data);
-#endif
-        std::lock_guard<std::recursive_mutex> requests_lock (requests_mutex);
-        std::lock_guard<std::recursive_mutex> events_lock (events_mutex);
-        vapi_msg_id_t id = vapi_lookup_vapi_msg_id_t (
-            vapi_ctx, be16toh (*static_cast<u16 *> (shm_data)));
-        bool has_context = vapi_msg_is_with_context (id);
-        bool break_dispatch = false;
-        Common_req *matching_req = nullptr;
-        if (has_context)
-          {
-            u32 context = *reinterpret_cast<u32 *> (
-                (static_cast<u8 *> (shm_data) + vapi_get_context_offset (id)));
-            const auto x = requests.front ();
-            matching_req = x;
-            if (context == x->context)
-              {
-                std::tie (rv, break_dispatch) =
-                    x->assign_response (id, shm_data);
-              }
-            else
-              {
-                std::tie (rv, break_dispatch) =
-                    x->assign_response (id, nullptr);
-              }
-            if (break_dispatch)
-              {
-                requests.pop_front ();
-              }
-          }
-        else
-          {
-            if (events[id])
-              {
-                std::tie (rv, break_dispatch) =
-                    events[id]->assign_response (id, shm_data);
-                matching_req = events[id];
-              }
-            else
-              {
-                msg_free (shm_data);
-              }
-          }
-        if ((matching_req && matching_req == limit && break_dispatch) ||
-            VAPI_OK != rv)
+        bool limit_done = false;
+        rv = dispatch_msg (shm_data, limit, limit_done);
+        if (limit_done || VAPI_OK != rv)
           {
             return rv;
           }
+        std::lock_guard<std::mutex> requests_lock (requests_mutex);
         loop_again = !requests.empty () || (event_count > 0);
       }
     return rv;
@@ -340,6 +342,113 @@ public:
     return dispatch (req);
   }
 
+  /**
+   * @brief start a thread which dispatches responses and events as they
+   * arrive, so that any number of requests can be outstanding
+   *
+   * Callbacks are called from the dispatch thread. Completion of requests
+   * executed via execute_async() is signalled through their futures,
+   * wait_for_response() and dispatch() wait for the dispatch thread.
+   *
+   * @param time interval in seconds in which the thread checks for stop
+   */
+  void start_dispatch_thread (u32 time = 1)
+  {
+    if (dispatch_thread.joinable ())
+      {
+        return;
+      }
+    dispatch_thread_stop = false;
+    dispatch_thread_active = true;
+    dispatch_thread = std::thread (&Connection::dispatch_thread_fn, this, time);
+  }
+
+  /**
+   * @brief stop the dispatch thread, if running
+   */
+  void stop_dispatch_thread ()
+  {
+    if (!dispatch_thread.joinable ())
+      {
+        return;
+      }
+    dispatch_thread_stop = true;
+    dispatch_thread.join ();
+    std::lock_guard<std::mutex> lock (requests_mutex);
+    dispatch_thread_active = false;
+    requests_cv.notify_all ();
+  }
+
+  /**
+   * @brief start batching - requests executed from now on are queued
+   * locally until flush_batch() is called
+   *
+   * @note batching applies to the whole connection, responses to batched
+   * requests cannot be waited for before the batch is flushed
+   */
+  void start_batch ()
+  {
+    std::lock_guard<std::mutex> lock (send_mutex);
+    batching = true;
+  }
+
+  /**
+   * @brief send all requests queued since start_batch() to vpp in one go
+   *
+   * @return VAPI_OK on success, other error code on error, in which case
+   * none of the queued requests was sent
+   */
+  vapi_error_e flush_batch ()
+  {
+    std::lock_guard<std::mutex> lock (send_mutex);
+    batching = false;
+    std::vector<Batch_entry> entries;
+    std::vector<void *> msgs;
+    {
+      /* messages are owned by the batch from here on, so requests destroyed
+         meanwhile don't free them */
+      std::lock_guard<std::mutex> requests_lock (requests_mutex);
+      entries.swap (batch);
+      for (auto &e : entries)
+        {
+          e.msg = e.take_msg ();
+          msgs.push_back (e.msg);
+          if (e.ping)
+            {
+              msgs.push_back (e.ping);
+            }
+        }
+    }
+    vapi_error_e rv = VAPI_OK;
+    if (!msgs.empty ())
+      {
+        rv = vapi_send_n (vapi_ctx, msgs.data (), msgs.size ());
+      }
+    if (VAPI_OK == rv)
+      {
+        return rv;
+      }
+    std::lock_guard<std::mutex> requests_lock (requests_mutex);
+    for (auto &e : entries)
+      {
+        if (e.ping)
+          {
+            vapi_msg_free (vapi_ctx, e.ping);
+          }
+        auto it = std::find (requests.begin (), requests.end (), e.req);
+        if (it == requests.end ())
+          {
+            /* request is gone */
+            vapi_msg_free (vapi_ctx, e.msg);
+            continue;
+          }
+        requests.erase (it);
+        e.restore_msg (e.msg);
+        e.req->complete (rv);
+      }
+    return rv;
+  }
+
 private:
   void msg_free (void *shm_data)
   {
@@ -349,75 +458,286 @@ private:
     vapi_msg_free (vapi_ctx, shm_data);
   }
 
-  template <template <typename XReq, typename XResp, typename... XArgs>
-            class X,
-            typename Req, typename Resp, typename... Args>
-  vapi_error_e send (X<Req, Resp, Args...> *req)
+  vapi_error_e dispatch_msg (void *shm_data, const Common_req *limit,
+                             bool &limit_done)
   {
-    if (!req)
+#if VAPI_CPP_DEBUG_LEAKS
+    on_shm_data_alloc (shm_data);
+#endif
+    vapi_error_e rv = VAPI_OK;
+    vapi_msg_id_t id = vapi_lookup_vapi_msg_id_t (
+        vapi_ctx, be16toh (*static_cast<u16 *> (shm_data)));
+    bool has_context = vapi_msg_is_with_context (id);
+    bool break_dispatch = false;
+    Common_req *matching_req = nullptr;
+    if (has_context)
       {
-        return VAPI_EINVAL;
+        u32 context = *reinterpret_cast<u32 *> (
+            (static_cast<u8 *> (shm_data) + vapi_get_context_offset (id)));
+        std::unique_ptr<std::promise<vapi_error_e>> completion;
+        {
+          std::lock_guard<std::mutex> requests_lock (requests_mutex);
+          if (!requests.empty ())
+            {
+              matching_req = requests.front ();
+              completion = std::move (matching_req->completion);
+              dispatching = matching_req;
+              dispatching_thread = std::this_thread::get_id ();
+            }
+        }
+        if (!matching_req)
+          {
+            msg_free (shm_data);
+            return VAPI_OK;
+          }
+        /* requests_mutex is not held while the response is assigned and the
+           callback runs, so that submitters are never blocked behind it */
+        if (context == matching_req->context)
+          {
+            std::tie (rv, break_dispatch) =
+                matching_req->assign_response (id, shm_data);
+          }
+        else
+          {
+            std::tie (rv, break_dispatch) =
+                matching_req->assign_response (id, nullptr);
+          }
+        std::lock_guard<std::mutex> requests_lock (requests_mutex);
+        if (break_dispatch)
+          {
+            if (!requests.empty () && requests.front () == matching_req)
+              {
+                requests.pop_front ();
+              }
+            if (completion)
+              {
+                completion->set_value (rv);
+              }
+          }
+        else
+          {
+            matching_req->completion = std::move (completion);
+          }
+        dispatching = nullptr;
+        requests_cv.notify_all ();
       }
+    else
+      {
+        std::lock_guard<std::recursive_mutex> events_lock (events_mutex);
+        if (events[id])
+          {
+            std::tie (rv, break_dispatch) =
+                events[id]->assign_response (id, shm_data);
+            matching_req = events[id];
+          }
+        else
+          {
+            msg_free (shm_data);
+          }
+      }
+    limit_done = matching_req && matching_req == limit && break_dispatch;
+    return rv;
+  }
+
+  void dispatch_thread_fn (u32 time)
+  {
+    std::lock_guard<std::mutex> lock (dispatch_mutex);
+    while (!dispatch_thread_stop)
+      {
+        void *shm_data;
+        size_t shm_data_size;
+        vapi_error_e rv = vapi_recv (vapi_ctx, &shm_data, &shm_data_size,
+                                     SVM_Q_TIMEDWAIT, time);
+        if (VAPI_EAGAIN == rv)
+          {
+            continue;
+          }
+        if (VAPI_OK != rv)
+          {
+            dispatch_thread_fail (rv);
+            break;
+          }
+        /* errors returned by callbacks are delivered via the futures */
+        bool limit_done;
+        dispatch_msg (shm_data, nullptr, limit_done);
+      }
+  }
+
+  /* nothing will dispatch responses any more, fail outstanding requests */
+  void dispatch_thread_fail (vapi_error_e rv)
+  {
+    std::lock_guard<std::mutex> lock (requests_mutex);
+    dispatch_thread_active = false;
+    fail_requests (rv);
+  }
+
+  /* called with requests_mutex held */
+  void fail_requests (vapi_error_e rv)
+  {
+    for (auto req : requests)
+      {
+        VAPI_DBG ("failing request @%p", req);
+        req->complete (rv);
+      }
+    requests.clear ();
+    requests_cv.notify_all ();
+  }
+
+  vapi_error_e wait_for_completion (const Common_req &req, u32 time)
+  {
+    std::unique_lock<std::mutex> lock (requests_mutex);
+    bool done = requests_cv.wait_for (lock, std::chrono::seconds (time), [&] {
+      return RESPONSE_NOT_READY != req.get_response_state () ||
+             !dispatch_thread_active;
+    });
+    if (!done || RESPONSE_NOT_READY == req.get_response_state ())
+      {
+        return VAPI_EAGAIN;
+      }
+    return VAPI_OK;
+  }
+
+  template <typename Req>
+  vapi_error_e submit (Common_req *req, Msg<Req> &request,
+                       bool with_control_ping)
+  {
     u32 req_context =
         req_context_counter.fetch_add (1, std::memory_order_relaxed);
-    req->request.shm_data->header.context = req_context;
-    vapi_swap_to_be<Req> (req->request.shm_data);
-    std::lock_guard<std::recursive_mutex> lock (requests_mutex);
-    vapi_error_e rv = vapi_send (vapi_ctx, req->request.shm_data);
-    if (VAPI_OK == rv)
+    request.shm_data->header.context = req_context;
+    req->set_context (req_context);
+    vapi_msg_control_ping *ping = nullptr;
+    if (with_control_ping)
       {
-        VAPI_DBG ("Push %p", req);
-        requests.emplace_back (req);
-        req->set_context (req_context);
+        ping = vapi_alloc_control_ping (vapi_ctx);
+        if (!ping)
+          {
+            req->complete (VAPI_ENOMEM);
+            return VAPI_ENOMEM;
+          }
+        ping->header.context = req_context;
+        vapi_msg_control_ping_hton (ping);
+      }
+    vapi_swap_to_be<Req> (request.shm_data);
+    /* send_mutex keeps the order of requests the same as the order of
+       messages in the queue, requests_mutex is only held while queueing the
+       request so that the dispatcher is not blocked while the send waits for
+       room in the shared memory queue */
+    std::lock_guard<std::mutex> lock (send_mutex);
+    {
+      std::lock_guard<std::mutex> requests_lock (requests_mutex);
+      VAPI_DBG ("Push %p", req);
+      requests.emplace_back (req);
+      if (batching)
+        {
+          /* request is only accessed while registered, requests leaving
+             before the flush take their entry out of the batch */
+          Batch_entry e;
+          e.req = req;
+          e.msg = nullptr;
+          e.ping = ping;
+          e.take_msg = [this, &request]() -> void * {
+            void *msg = request.shm_data;
 #if VAPI_CPP_DEBUG_LEAKS
-        on_shm_data_free (req->request.shm_data);
+            on_shm_data_free (msg);
 #endif
-        req->request.shm_data = nullptr; /* consumed by vapi_send */
+            request.shm_data = nullptr;
+            return msg;
+          };
+          e.restore_msg = [this, &request](void *msg) {
+#if VAPI_CPP_DEBUG_LEAKS
+            on_shm_data_alloc (msg);
+#endif
+            request.shm_data = static_cast<decltype (request.shm_data)> (msg);
+            vapi_swap_to_host<Req> (request.shm_data);
+          };
+          batch.push_back (std::move (e));
+          return VAPI_OK;
+        }
+    }
+    vapi_error_e rv;
+    if (ping)
+      {
+        rv = vapi_send2 (vapi_ctx, request.shm_data, ping);
       }
     else
       {
-        vapi_swap_to_host<Req> (req->request.shm_data);
+        rv = vapi_send (vapi_ctx, request.shm_data);
       }
+    submit_done<Req> (req, request, ping, rv);
     return rv;
   }
 
+  template <typename Req>
+  void submit_done (Common_req *req, Msg<Req> &request, void *ping,
+                    vapi_error_e rv)
+  {
+    if (VAPI_OK == rv)
+      {
+#if VAPI_CPP_DEBUG_LEAKS
+        on_shm_data_free (request.shm_data);
+#endif
+        request.shm_data = nullptr; /* consumed by vapi_send */
+      }
+    else
+      {
+        unregister_request (req);
+        vapi_swap_to_host<Req> (request.shm_data);
+        if (ping)
+          {
+            vapi_msg_free (vapi_ctx, ping);
+          }
+        req->complete (rv);
+      }
+  }
+
   template <template <typename XReq, typename XResp, typename... XArgs>
             class X,
             typename Req, typename Resp, typename... Args>
-  vapi_error_e send_with_control_ping (X<Req, Resp, Args...> *req)
+  vapi_error_e send (X<Req, Resp, Args...> *req)
   {
     if (!req)
       {
         return VAPI_EINVAL;
       }
-    u32 req_context =
-        req_context_counter.fetch_add (1, std::memory_order_relaxed);
-    req->request.shm_data->header.context = req_context;
-    vapi_swap_to_be<Req> (req->request.shm_data);
-    std::lock_guard<std::recursive_mutex> lock (requests_mutex);
-    vapi_error_e rv = vapi_send_with_control_ping (
-        vapi_ctx, req->request.shm_data, req_context);
-    if (VAPI_OK == rv)
-      {
-        VAPI_DBG ("Push %p", req);
-        requests.emplace_back (req);
-        req->set_context (req_context);
-#if VAPI_CPP_DEBUG_LEAKS
-        on_shm_data_free (req->request.shm_data);
-#endif
-        req->request.shm_data = nullptr; /* consumed by vapi_send */
-      }
-    else
+    return submit<Req> (req, req->request, false);
+  }
+
+  template <template <typename XReq, typename XResp, typename... XArgs>
+            class X,
+            typename Req, typename Resp, typename... Args>
+  vapi_error_e send_with_control_ping (X<Req, Resp, Args...> *req)
+  {
+    if (!req)
       {
-        vapi_swap_to_host<Req> (req->request.shm_data);
+        return VAPI_EINVAL;
       }
-    return rv;
+    return submit<Req> (req, req->request, true);
   }
 
   void unregister_request (Common_req *request)
   {
-    std::lock_guard<std::recursive_mutex> lock (requests_mutex);
-    std::remove (requests.begin (), requests.end (), request);
+    std::unique_lock<std::mutex> lock (requests_mutex);
+    /* wait until the dispatcher is done with the request, unless called
+       from within its own callback */
+    requests_cv.wait (lock, [&] {
+      return dispatching != request ||
+             dispatching_thread == std::this_thread::get_id ();
+    });
+    requests.erase (std::remove (requests.begin (), requests.end (), request),
+                    requests.end ());
+    for (auto it = batch.begin (); it != batch.end ();)
+      {
+        if (it->req != request)
+          {
+            ++it;
+            continue;
+          }
+        if (it->ping)
+          {
+            vapi_msg_free (vapi_ctx, it->ping);
+          }
+        it = batch.erase (it);
+      }
   }
 
   template <typename M> void register_event (Event_registration<M> *event)
@@ -440,12 +760,34 @@ private:
   std::atomic_ulong req_context_counter;
   std::mutex dispatch_mutex;
 
-  std::recursive_mutex requests_mutex;
+  std::mutex send_mutex;
+  std::mutex requests_mutex;
+  std::condition_variable requests_cv;
   std::recursive_mutex events_mutex;
   std::deque<Common_req *> requests;
+  Common_req *dispatching;
+  std::thread::id dispatching_thread;
   std::vector<Common_req *> events;
   int event_count;
 
+  /* request queued by start_batch(), its message stays owned by the
+     request until flush_batch() takes it */
+  struct Batch_entry
+  {
+    Common_req *req;
+    void *msg;
+    void *ping;
+    std::function<void *()> take_msg;
+    std::function<void(void *)> restore_msg;
+  };
+
+  bool batching;
+  std::vector<Batch_entry> batch;
+
+  std::thread dispatch_thread;
+  std::atomic_bool dispatch_thread_active;
+  std::atomic_bool dispatch_thread_stop;
+
   template <typename Req, typename Resp, typename... Args>
   friend class Request;
 
@@ -666,6 +1008,19 @@ public:
     return con.send (this);
   }
 
+  /**
+   * @brief send the request without waiting for the response
+   *
+   * @return future which becomes ready once the response was received (with
+   * the return value of the callback) or the request failed to be sent
+   */
+  std::future<vapi_error_e> execute_async ()
+  {
+    std::future<vapi_error_e> f = make_future ();
+    con.send (this);
+    return f;
+  }
+
   const Msg<Req> &get_request (void) const
   {
     return request;
@@ -797,6 +1152,10 @@ public:
 
   virtual ~Dump ()
   {
+    if (RESPONSE_NOT_READY == get_response_state ())
+      {
+        con.unregister_request (this);
+      }
   }
 
   virtual std::tuple<vapi_error_e, bool> assign_response (vapi_msg_id_t id,
@@ -825,6 +1184,19 @@ public:
     return con.send_with_control_ping (this);
   }
 
+  /**
+   * @brief send the dump request without waiting for the responses
+   *
+   * @return future which becomes ready once the whole result set was
+   * received or the request failed to be sent
+   */
+  std::future<vapi_error_e> execute_async ()
+  {
+    std::future<vapi_error_e> f = make_future ();
+    con.send_with_control_ping (this);
+    return f;
+  }
+
   Msg<Req> &get_request (void)
   {
     return request;
@@ -28,157 +28,495 @@
 #include <unistd.h>
 #include <netdb.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <ctype.h>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
 #include <vpp-api/client/stat_client.h>
 #include <vlib/vlib.h>
-#include <ctype.h>
+#include <vppinfra/time.h>
 
 /* https://github.com/prometheus/prometheus/wiki/Default-port-allocations */
 #define SERVER_PORT 9482
 
-static char *
+#define PROM_MAX_REQUEST_SIZE 8192
+#define PROM_MAX_EVENTS 64
+
+typedef struct
+{
+  u8 *body;
+  u8 *gz_body;			/* built on first request accepting gzip */
+  f64 time;
+  u32 refcnt;
+} prom_snapshot_t;
+
+typedef struct
+{
+  int fd;
+  u8 *rx;
+  u8 *tx;			/* response header, or whole short reply */
+  u32 snapshot_index;		/* ~0 if tx is the whole reply */
+  u8 is_gzip;
+  u32 tx_offset;
+} prom_conn_t;
+
+typedef struct
+{
+  u8 *name;			/* metric name, with invalid chars replaced */
+  u8 *text;			/* formatted metric, summed mode only */
+} prom_entry_t;
+
+typedef struct
+{
+  u8 **patterns;
+  u32 *stats;			/* directory indices matching patterns */
+  uword *entry_by_name;
+  prom_entry_t *entries;
+  uint64_t delta_epoch;
+  prom_snapshot_t *snapshots;
+  u32 current_snapshot;
+  prom_conn_t *conns;
+  f64 min_interval;
+  u8 summed;
+  u8 gzip;
+  int epfd;
+} prom_main_t;
+
+static prom_main_t prom_main;
+
+static u8 *
 prom_string (char *s)
 {
-  char *p = s;
-  while (*p)
+  u8 *name = format (0, "%s", s);
+  u8 *p;
+
+  vec_foreach (p, name)
+  {
+    if (!isalnum (*p))
+      *p = '_';
+  }
+  return name;
+}
+
+static prom_entry_t *
+prom_entry_get (prom_main_t * pm, char *name)
+{
+  prom_entry_t *e;
+  uword *p;
+
+  p = hash_get_mem (pm->entry_by_name, name);
+  if (p)
+    return vec_elt_at_index (pm->entries, p[0]);
+
+  vec_add2 (pm->entries, e, 1);
+  e->name = prom_string (name);
+  hash_set_mem (pm->entry_by_name, format (0, "%s%c", name, 0),
+		e - pm->entries);
+  return e;
+}
+
+static void
+prom_entries_reset (prom_main_t * pm)
+{
+  prom_entry_t *e;
+  hash_pair_t *hp;
+  u8 **keys = 0, **key;
+
+  vec_foreach (e, pm->entries)
+  {
+    vec_free (e->name);
+    vec_free (e->text);
+  }
+  vec_reset_length (pm->entries);
+
+  /* *INDENT-OFF* */
+  hash_foreach_pair (hp, pm->entry_by_name, ({
+    vec_add1 (keys, (u8 *) hp->key);
+  }));
+  /* *INDENT-ON* */
+  vec_foreach (key, keys) vec_free (*key);
+  vec_free (keys);
+  hash_free (pm->entry_by_name);
+  pm->entry_by_name = hash_create_string (0, sizeof (uword));
+}
+
+static u8 *
+format_prom_entry (u8 * s, va_list * args)
+{
+  stat_segment_data_t *d = va_arg (*args, stat_segment_data_t *);
+  u8 *name = va_arg (*args, u8 *);
+  int summed = va_arg (*args, int);
+  int j, k;
+
+  switch (d->type)
     {
-      if (!isalnum (*p))
-	*p = '_';
-      p++;
+    case STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE:
+      s = format (s, "# TYPE %v counter\n", name);
+      for (k = 0; k < vec_len (d->simple_counter_vec); k++)
+	for (j = 0; j < vec_len (d->simple_counter_vec[k]); j++)
+	  if (summed)
+	    s = format (s, "%v{interface=\"%d\"} %llu\n", name, j,
+			d->simple_counter_vec[k][j]);
+	  else
+	    s = format (s, "%v{thread=\"%d\",interface=\"%d\"} %llu\n",
+			name, k, j, d->simple_counter_vec[k][j]);
+      break;
+
+    case STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED:
+      s = format (s, "# TYPE %v_packets counter\n", name);
+      s = format (s, "# TYPE %v_bytes counter\n", name);
+      for (k = 0; k < vec_len (d->combined_counter_vec); k++)
+	for (j = 0; j < vec_len (d->combined_counter_vec[k]); j++)
+	  if (summed)
+	    s = format (s, "%v_packets{interface=\"%d\"} %llu\n"
+			"%v_bytes{interface=\"%d\"} %llu\n", name, j,
+			d->combined_counter_vec[k][j].packets, name, j,
+			d->combined_counter_vec[k][j].bytes);
+	  else
+	    s = format (s, "%v_packets{thread=\"%d\",interface=\"%d\"} %llu\n"
+			"%v_bytes{thread=\"%d\",interface=\"%d\"} %llu\n",
+			name, k, j, d->combined_counter_vec[k][j].packets,
+			name, k, j, d->combined_counter_vec[k][j].bytes);
+      break;
+
+    case STAT_DIR_TYPE_ERROR_INDEX:
+      s = format (s, "# TYPE %v counter\n", name);
+      for (j = 0; j < vec_len (d->error_vector); j++)
+	if (summed)
+	  s = format (s, "%v %llu\n", name, d->error_vector[j]);
+	else
+	  s = format (s, "%v{thread=\"%d\"} %llu\n", name, j,
+		      d->error_vector[j]);
+      break;
+
+    case STAT_DIR_TYPE_SCALAR_INDEX:
+      s = format (s, "# TYPE %v counter\n", name);
+      s = format (s, "%v %.2f\n", name, d->scalar_value);
+      break;
+
+    default:
+      break;
     }
   return s;
 }
 
 static void
-dump_metrics (FILE * stream, u8 ** patterns)
+prom_list_stats (prom_main_t * pm)
+{
+  vec_free (pm->stats);
+  pm->stats = stat_segment_ls (pm->patterns);
+  prom_entries_reset (pm);
+  pm->delta_epoch = 0;
+}
+
+static u8 *
+dump_metrics (prom_main_t * pm, u8 * s)
 {
-  stat_segment_data_t *res;
-  int i, j, k;
-  static u32 *stats = 0;
-
-retry:
-  res = stat_segment_dump (stats);
-  if (res == 0)
-    {				/* Memory layout has changed */
-      if (stats)
-	vec_free (stats);
-      stats = stat_segment_ls (patterns);
-      goto retry;
+  stat_segment_data_t *res, *d;
+  prom_entry_t *e;
+
+  if (pm->summed)
+    {
+      /* only entries that changed since the last scrape are formatted */
+      while (stat_segment_dump_delta (pm->stats, &pm->delta_epoch, &res))
+	prom_list_stats (pm);	/* Memory layout has changed */
+
+      vec_foreach (d, res)
+      {
+	e = prom_entry_get (pm, d->name);
+	vec_reset_length (e->text);
+	e->text = format (e->text, "%U", format_prom_entry, d, e->name, 1);
+      }
+      stat_segment_data_free (res);
+
+      vec_foreach (e, pm->entries) vec_append (s, e->text);
+      return s;
     }
 
-  for (i = 0; i < vec_len (res); i++)
+  while ((res = stat_segment_dump (pm->stats)) == 0)
     {
-      switch (res[i].type)
-	{
-	case STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE:
-	  fformat (stream, "# TYPE %s counter\n", prom_string (res[i].name));
-	  for (k = 0; k < vec_len (res[i].simple_counter_vec); k++)
-	    for (j = 0; j < vec_len (res[i].simple_counter_vec[k]); j++)
-	      fformat (stream, "%s{thread=\"%d\",interface=\"%d\"} %lld\n",
-		       prom_string (res[i].name), k, j,
-		       res[i].simple_counter_vec[k][j]);
-	  break;
+      /* Memory layout has changed */
+      prom_list_stats (pm);
+      if (vec_len (pm->stats) == 0)
+	return s;
+    }
 
-	case STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED:
-	  fformat (stream, "# TYPE %s_packets counter\n",
-		   prom_string (res[i].name));
-	  fformat (stream, "# TYPE %s_bytes counter\n",
-		   prom_string (res[i].name));
-	  for (k = 0; k < vec_len (res[i].simple_counter_vec); k++)
-	    for (j = 0; j < vec_len (res[i].combined_counter_vec[k]); j++)
-	      {
-		fformat (stream,
-			 "%s_packets{thread=\"%d\",interface=\"%d\"} %lld\n",
-			 prom_string (res[i].name), k, j,
-			 res[i].combined_counter_vec[k][j].packets);
-		fformat (stream,
-			 "%s_bytes{thread=\"%d\",interface=\"%d\"} %lld\n",
-			 prom_string (res[i].name), k, j,
-			 res[i].combined_counter_vec[k][j].bytes);
-	      }
-	  break;
-	case STAT_DIR_TYPE_ERROR_INDEX:
-	  for (j = 0; j < vec_len (res[i].error_vector); j++)
-	    {
-	      fformat (stream, "# TYPE %s counter\n",
-		       prom_string (res[i].name));
-	      fformat (stream, "%s{thread=\"%d\"} %lld\n",
-		       prom_string (res[i].name), j, res[i].error_vector[j]);
-	    }
-	  break;
+  vec_foreach (d, res)
+  {
+    e = prom_entry_get (pm, d->name);
+    s = format (s, "%U", format_prom_entry, d, e->name, 0);
+  }
+  stat_segment_data_free (res);
+  return s;
+}
 
-	case STAT_DIR_TYPE_SCALAR_INDEX:
-	  fformat (stream, "# TYPE %s counter\n", prom_string (res[i].name));
-	  fformat (stream, "%s %.2f\n", prom_string (res[i].name),
-		   res[i].scalar_value);
-	  break;
+#ifdef HAVE_ZLIB
+static int
+prom_gzip (u8 * in, u8 ** out)
+{
+  z_stream zs = { 0 };
+  int rv;
 
-	default:
-	  fformat (stderr, "Unknown value %d\n", res[i].type);
-	  ;
-	}
+  if (deflateInit2 (&zs, Z_BEST_SPEED, Z_DEFLATED, 15 + 16 /* gzip */ , 8,
+		    Z_DEFAULT_STRATEGY) != Z_OK)
+    return -1;
+
+  vec_validate (*out, deflateBound (&zs, vec_len (in)));
+  zs.next_in = in;
+  zs.avail_in = vec_len (in);
+  zs.next_out = *out;
+  zs.avail_out = vec_len (*out);
+  rv = deflate (&zs, Z_FINISH);
+  deflateEnd (&zs);
+  if (rv != Z_STREAM_END)
+    return -1;
+
+  _vec_len (*out) = zs.total_out;
+  return 0;
+}
+#endif
+
+/*
+ * Scrapers arriving within min-interval of each other share a snapshot.
+ * Buffers of snapshots no longer being sent are reused.
+ */
+static u32
+prom_snapshot_get (prom_main_t * pm)
+{
+  prom_snapshot_t *snap;
+  f64 now = unix_time_now ();
+  u32 i;
+
+  if (pm->current_snapshot != ~0)
+    {
+      snap = vec_elt_at_index (pm->snapshots, pm->current_snapshot);
+      if (now - snap->time < pm->min_interval)
+	return pm->current_snapshot;
     }
-  stat_segment_data_free (res);
 
+  for (i = 0; i < vec_len (pm->snapshots); i++)
+    if (pm->snapshots[i].refcnt == 0 && i != pm->current_snapshot)
+      break;
+  if (i == vec_len (pm->snapshots))
+    vec_validate (pm->snapshots, i);
+
+  snap = vec_elt_at_index (pm->snapshots, i);
+  vec_reset_length (snap->body);
+  vec_reset_length (snap->gz_body);
+  snap->body = dump_metrics (pm, snap->body);
+  snap->time = now;
+  pm->current_snapshot = i;
+  return i;
 }
 
+static u8 *
+prom_conn_body (prom_main_t * pm, prom_conn_t * c)
+{
+  prom_snapshot_t *snap;
+
+  if (c->snapshot_index == ~0)
+    return 0;
+  snap = vec_elt_at_index (pm->snapshots, c->snapshot_index);
+  return c->is_gzip ? snap->gz_body : snap->body;
+}
 
 #define ROOTPAGE  "<html><head><title>Metrics exporter</title></head><body><ul><li><a href=\"/metrics\">metrics</a></li></ul></body></html>"
 #define NOT_FOUND_ERROR "<html><head><title>Document not found</title></head><body><h1>404 - Document not found</h1></body></html>"
 
+static int
+prom_accepts_gzip (char *headers)
+{
+  char *p, *end;
+
+  for (p = headers; *p; p++)
+    *p = tolower (*p);
+  if (!(p = strstr (headers, "accept-encoding:")))
+    return 0;
+  if ((end = strchr (p, '\n')))
+    *end = 0;
+  return strstr (p, "gzip") != 0;
+}
+
 static void
-http_handler (FILE * stream, u8 ** patterns)
+http_handler (prom_main_t * pm, prom_conn_t * c)
 {
-  char status[80] = { 0 };
-  if (fgets (status, sizeof (status) - 1, stream) == 0)
-    {
-      fprintf (stderr, "fgets error: %s %s\n", status, strerror (errno));
-      return;
-    }
-  char *saveptr;
-  char *method = strtok_r (status, " \t\r\n", &saveptr);
+  prom_snapshot_t *snap;
+  char *saveptr, *headers;
+  u8 *body;
+
+  vec_add1 (c->rx, 0);
+  char *method = strtok_r ((char *) c->rx, " \t\r\n", &saveptr);
   if (method == 0 || strncmp (method, "GET", 4) != 0)
     {
-      fputs ("HTTP/1.0 405 Method Not Allowed\r\n", stream);
+      c->tx = format (c->tx, "HTTP/1.0 405 Method Not Allowed\r\n\r\n");
       return;
     }
   char *request_uri = strtok_r (NULL, " \t", &saveptr);
   char *protocol = strtok_r (NULL, " \t\r\n", &saveptr);
   if (protocol == 0 || strncmp (protocol, "HTTP/1.", 7) != 0)
     {
-      fputs ("HTTP/1.0 400 Bad Request\r\n", stream);
+      c->tx = format (c->tx, "HTTP/1.0 400 Bad Request\r\n\r\n");
       return;
     }
-  /* Read the other headers */
-  for (;;)
+  headers = saveptr;
+
+  if (strcmp (request_uri, "/") == 0)
+    {
+      c->tx = format (c->tx, "HTTP/1.0 200 OK\r\nContent-Length: %lu\r\n\r\n"
+		      "%s", (unsigned long) strlen (ROOTPAGE), ROOTPAGE);
+      return;
+    }
+  if (strcmp (request_uri, "/metrics") != 0)
     {
-      char header[1024];
-      if (fgets (header, sizeof (header) - 1, stream) == 0)
+      c->tx = format (c->tx, "HTTP/1.0 404 Not Found\r\n"
+		      "Content-Length: %lu\r\n\r\n%s",
+		      (unsigned long) strlen (NOT_FOUND_ERROR),
+		      NOT_FOUND_ERROR);
+      return;
+    }
+
+  c->snapshot_index = prom_snapshot_get (pm);
+  snap = vec_elt_at_index (pm->snapshots, c->snapshot_index);
+  snap->refcnt++;
+
+#ifdef HAVE_ZLIB
+  if (pm->gzip && headers && prom_accepts_gzip (headers))
+    {
+      c->is_gzip = 1;
+      if (vec_len (snap->gz_body) == 0 && prom_gzip (snap->body,
+						     &snap->gz_body))
 	{
-	  fprintf (stderr, "fgets error: %s\n", strerror (errno));
-	  return;
+	  vec_reset_length (snap->gz_body);
+	  c->is_gzip = 0;
+	}
+    }
+#endif
+
+  body = prom_conn_body (pm, c);
+  c->tx = format (c->tx, "HTTP/1.0 200 OK\r\nContent-Type: text/plain\r\n"
+		  "%sContent-Length: %u\r\n\r\n",
+		  c->is_gzip ? "Content-Encoding: gzip\r\n" : "",
+		  vec_len (body));
+}
+
+static void
+prom_conn_close (prom_main_t * pm, prom_conn_t * c)
+{
+  if (c->snapshot_index != ~0)
+    pm->snapshots[c->snapshot_index].refcnt--;
+  epoll_ctl (pm->epfd, EPOLL_CTL_DEL, c->fd, 0);
+  close (c->fd);
+  vec_free (c->rx);
+  vec_free (c->tx);
+  pool_put (pm->conns, c);
+}
+
+/* Returns 1 when the whole reply was sent, 0 if it would block */
+static int
+prom_conn_send (prom_main_t * pm, prom_conn_t * c)
+{
+  u8 *body = prom_conn_body (pm, c);
+  u32 hdr_len = vec_len (c->tx), len = hdr_len + vec_len (body), offset;
+  struct msghdr msg = { 0 };
+  struct iovec iov[2];
+  ssize_t n;
+
+  while (c->tx_offset < len)
+    {
+      msg.msg_iov = iov;
+      msg.msg_iovlen = 0;
+      if (c->tx_offset < hdr_len)
+	{
+	  iov[msg.msg_iovlen].iov_base = c->tx + c->tx_offset;
+	  iov[msg.msg_iovlen++].iov_len = hdr_len - c->tx_offset;
 	}
-      if (header[0] == '\n' || header[1] == '\n')
+      offset = clib_max (c->tx_offset, hdr_len) - hdr_len;
+      if (offset < vec_len (body))
 	{
-	  break;
+	  iov[msg.msg_iovlen].iov_base = body + offset;
+	  iov[msg.msg_iovlen++].iov_len = vec_len (body) - offset;
 	}
+
+      n = sendmsg (c->fd, &msg, MSG_NOSIGNAL);
+      if (n < 0)
+	return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+      c->tx_offset += n;
     }
-  if (strcmp (request_uri, "/") == 0)
+  return 1;
+}
+
+static void
+prom_conn_ready (prom_main_t * pm, prom_conn_t * c, u32 events)
+{
+  struct epoll_event ev = { 0 };
+  u8 buf[2048];
+  ssize_t n;
+  int rv;
+
+  if (events & (EPOLLERR | EPOLLHUP))
+    goto close;
+
+  if (!vec_len (c->tx))
     {
-      fprintf (stream, "HTTP/1.0 200 OK\r\nContent-Length: %lu\r\n\r\n",
-	       (unsigned long) strlen (ROOTPAGE));
-      fputs (ROOTPAGE, stream);
-      return;
+      while ((n = read (c->fd, buf, sizeof (buf))) > 0)
+	vec_add (c->rx, buf, n);
+      if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+	goto close;
+      if (vec_len (c->rx) > PROM_MAX_REQUEST_SIZE)
+	goto close;
+
+      /* Wait for the end of the headers */
+      vec_add1 (c->rx, 0);
+      _vec_len (c->rx) -= 1;
+      if (!strstr ((char *) c->rx, "\r\n\r\n")
+	  && !strstr ((char *) c->rx, "\n\n"))
+	{
+	  if (n == 0)
+	    goto close;
+	  return;
+	}
+
+      http_handler (pm, c);
+
+      ev.events = EPOLLOUT;
+      ev.data.u32 = c - pm->conns;
+      epoll_ctl (pm->epfd, EPOLL_CTL_MOD, c->fd, &ev);
     }
-  if (strcmp (request_uri, "/metrics") != 0)
+
+  rv = prom_conn_send (pm, c);
+  if (rv == 0)
+    return;
+
+close:
+  prom_conn_close (pm, c);
+}
+
+static void
+prom_accept (prom_main_t * pm, int listen_fd)
+{
+  struct epoll_event ev = { 0 };
+  prom_conn_t *c;
+  int fd;
+
+  while ((fd = accept (listen_fd, NULL, NULL)) >= 0)
     {
-      fprintf (stream,
-	       "HTTP/1.0 404 Not Found\r\nContent-Length: %lu\r\n\r\n",
-	       (unsigned long) strlen (NOT_FOUND_ERROR));
-      fputs (NOT_FOUND_ERROR, stream);
-      return;
+      fcntl (fd, F_SETFL, fcntl (fd, F_GETFL) | O_NONBLOCK);
+      pool_get_zero (pm->conns, c);
+      c->fd = fd;
+      c->snapshot_index = ~0;
+      ev.events = EPOLLIN;
+      ev.data.u32 = c - pm->conns;
+      if (epoll_ctl (pm->epfd, EPOLL_CTL_ADD, fd, &ev) < 0)
+	{
+	  close (fd);
+	  pool_put (pm->conns, c);
+	}
     }
-  fputs ("HTTP/1.0 200 OK\r\nContent-Type: text/plain\r\n\r\n", stream);
-  dump_metrics (stream, patterns);
+
+  if (errno != EAGAIN && errno != EWOULDBLOCK)
+    fprintf (stderr, "Accept failed: %s\n", strerror (errno));
 }
 
 static int
@@ -188,13 +526,12 @@ start_listen (u16 port)
   int addrlen = sizeof (serveraddr);
   int enable = 1;
 
-  int listenfd = socket (AF_INET6, SOCK_STREAM, 0);
+  int listenfd = socket (AF_INET6, SOCK_STREAM | SOCK_NONBLOCK, 0);
   if (listenfd == -1)
     {
       perror ("Failed opening socket");
       return -1;
     }
-
   int rv =
     setsockopt (listenfd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof (int));
   if (rv < 0)
@@ -224,23 +561,14 @@ start_listen (u16 port)
   return listenfd;
 }
 
-/* Socket epoll, linux-specific */
-union my_sockaddr
-{
-  struct sockaddr_storage storage;
-  struct sockaddr addr;
-  struct sockaddr_in sin_addr;
-  struct sockaddr_in6 sin6_addr;
-};
-
-
-
 int
 main (int argc, char **argv)
 {
+  prom_main_t *pm = &prom_main;
   unformat_input_t _argv, *a = &_argv;
-  u8 *stat_segment_name, *pattern = 0, **patterns = 0;
-  int rv;
+  u8 *stat_segment_name, *pattern = 0;
+  struct epoll_event ev = { 0 }, events[PROM_MAX_EVENTS];
+  int i, n, rv;
 
   /* Allocating 32MB heap */
   clib_mem_init (0, 32 << 20);
@@ -248,31 +576,46 @@ main (int argc, char **argv)
   unformat_init_command_line (a, argv);
 
   stat_segment_name = (u8 *) STAT_SEGMENT_SOCKET_FILE;
+  pm->min_interval = 1.0;
+  pm->current_snapshot = ~0;
+  pm->entry_by_name = hash_create_string (0, sizeof (uword));
 
   while (unformat_check_input (a) != UNFORMAT_END_OF_INPUT)
     {
       if (unformat (a, "socket-name %s", &stat_segment_name))
 	;
+      else if (unformat (a, "min-interval %f", &pm->min_interval))
+	;
+      else if (unformat (a, "summed"))
+	pm->summed = 1;
+      else if (unformat (a, "gzip"))
+	pm->gzip = 1;
       else if (unformat (a, "%s", &pattern))
 	{
-	  vec_add1 (patterns, pattern);
+	  vec_add1 (pm->patterns, pattern);
 	}
       else
 	{
-	  fformat (stderr,
-		   "%s: usage [socket-name <name>] <patterns> ...\n",
+	  fformat (stderr, "%s: usage [socket-name <name>] "
+		   "[min-interval <sec>] [summed] [gzip] <patterns> ...\n",
 		   argv[0]);
 	  exit (1);
 	}
     }
 
-  if (vec_len (patterns) == 0)
+  if (vec_len (pm->patterns) == 0)
     {
-      fformat (stderr,
-	       "%s: usage [socket-name <name>] <patterns> ...\n", argv[0]);
+      fformat (stderr, "%s: usage [socket-name <name>] "
+	       "[min-interval <sec>] [summed] [gzip] <patterns> ...\n",
+	       argv[0]);
       exit (1);
     }
 
+#ifndef HAVE_ZLIB
+  if (pm->gzip)
+    fformat (stderr, "Built without zlib, gzip ignored\n");
+#endif
+
   rv = stat_segment_connect ((char *) stat_segment_name);
   if (rv)
     {
@@ -286,38 +629,34 @@ main (int argc, char **argv)
     {
       exit (1);
     }
+
+  if ((pm->epfd = epoll_create1 (0)) < 0)
+    {
+      perror ("epoll_create1");
+      exit (1);
+    }
+  ev.events = EPOLLIN;
+  ev.data.u32 = ~0;
+  epoll_ctl (pm->epfd, EPOLL_CTL_ADD, fd, &ev);
+
   for (;;)
     {
-      int conn_sock = accept (fd, NULL, NULL);
-      if (conn_sock < 0)
+      n = epoll_wait (pm->epfd, events, PROM_MAX_EVENTS, -1);
+      if (n < 0 && errno != EINTR)
 	{
-	  fprintf (stderr, "Accept failed: %s", strerror (errno));
-	  continue;
-	}
-      else
-	{
-	  struct sockaddr_in6 clientaddr = { 0 };
-	  char address[INET6_ADDRSTRLEN];
-	  socklen_t addrlen;
-	  getpeername (conn_sock, (struct sockaddr *) &clientaddr, &addrlen);
-	  if (inet_ntop
-	      (AF_INET6, &clientaddr.sin6_addr, address, sizeof (address)))
-	    {
-	      fprintf (stderr, "Client address is [%s]:%d\n", address,
-		       ntohs (clientaddr.sin6_port));
-	    }
+	  perror ("epoll_wait");
+	  break;
 	}
 
-      FILE *stream = fdopen (conn_sock, "r+");
-      if (stream == NULL)
+      for (i = 0; i < n; i++)
 	{
-	  fprintf (stderr, "fdopen error: %s\n", strerror (errno));
-	  close (conn_sock);
-	  continue;
+	  if (events[i].data.u32 == ~0)
+	    prom_accept (pm, fd);
+	  else if (!pool_is_free_index (pm->conns, events[i].data.u32))
+	    prom_conn_ready (pm, pool_elt_at_index (pm->conns,
+						    events[i].data.u32),
+			     events[i].events);
 	}
-      /* Single reader at the moment */
-      http_handler (stream, patterns);
-      fclose (stream);
     }
 
   stat_segment_disconnect ();
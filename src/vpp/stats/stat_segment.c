@@ -46,6 +46,33 @@ vlib_stat_segment_unlock (void)
   clib_spinlock_unlock (sm->stat_segment_lockp);
 }
 
+/*
+ *  Used by VPP writers that only change one existing directory entry.
+ *  Doesn't bump the directory epoch, so clients don't need to rescan
+ */
+static void
+vlib_stat_segment_entry_lock (u32 index)
+{
+  stat_segment_main_t *sm = &stat_segment_main;
+  clib_spinlock_lock (sm->stat_segment_lockp);
+  stat_segment_entry_update_start (&sm->directory_vector[index]);
+}
+
+static void
+vlib_stat_segment_entry_unlock (u32 index)
+{
+  stat_segment_main_t *sm = &stat_segment_main;
+  stat_segment_entry_update_end (sm->shared_header,
+				 &sm->directory_vector[index]);
+  clib_spinlock_unlock (sm->stat_segment_lockp);
+}
+
+static u64
+stat_segment_new_entry_epoch (stat_segment_shared_header_t * shared_header)
+{
+  return atomic_fetch_add (&shared_header->entry_epoch, 1) + 1;
+}
+
 /*
  * Change heap to the stats shared memory segment
  */
@@ -92,6 +119,7 @@ vlib_stats_pop_heap (void *cm_arg, void *oldheap, u32 cindex,
   stat_segment_shared_header_t *shared_header = sm->shared_header;
   char *stat_segment_name;
   stat_segment_directory_entry_t e = { 0 };
+  int is_new;
 
   /* Not all counters have names / hash-table entries */
   if (!cm->name && !cm->stat_segment_name)
@@ -102,7 +130,7 @@ vlib_stats_pop_heap (void *cm_arg, void *oldheap, u32 cindex,
 
   ASSERT (shared_header);
 
-  vlib_stat_segment_lock ();
+  clib_spinlock_lock (sm->stat_segment_lockp);
 
   /* Lookup hash-table is on the main heap */
   stat_segment_name =
@@ -114,14 +142,21 @@ vlib_stats_pop_heap (void *cm_arg, void *oldheap, u32 cindex,
   /* Back to stats segment */
   clib_mem_set_heap (sm->heap);	/* Re-enter stat segment */
 
+  /* Only adding an entry changes the directory, a counter vector that
+     grew is a change of its entry alone */
+  is_new = vector_index == next_vector_index;
 
   /* Update the vector */
-  if (vector_index == next_vector_index)
-    {				/* New */
+  if (is_new)
+    {
+      shared_header->in_progress = 1;
       strncpy (e.name, stat_segment_name, 128 - 1);
       e.type = type;
+      e.epoch = stat_segment_new_entry_epoch (shared_header);
       vec_add1 (sm->directory_vector, e);
     }
+  else
+    stat_segment_entry_update_start (&sm->directory_vector[vector_index]);
 
   stat_segment_directory_entry_t *ep = &sm->directory_vector[vector_index];
   ep->offset = stat_segment_offset (shared_header, cm->counters);	/* Vector of threads of vectors of counters */
@@ -147,11 +182,16 @@ vlib_stats_pop_heap (void *cm_arg, void *oldheap, u32 cindex,
   sm->directory_vector[vector_index].offset =
     stat_segment_offset (shared_header, cm->counters);
 
-  /* Reset the client hash table pointer, since it WILL change! */
-  shared_header->directory_offset =
-    stat_segment_offset (shared_header, sm->directory_vector);
+  if (is_new)
+    {
+      /* Reset the client hash table pointer, since it WILL change! */
+      shared_header->directory_offset =
+	stat_segment_offset (shared_header, sm->directory_vector);
+      vlib_stat_segment_unlock ();
+    }
+  else
+    vlib_stat_segment_entry_unlock (vector_index);
 
-  vlib_stat_segment_unlock ();
   clib_mem_set_heap (oldheap);
 }
 
@@ -182,6 +222,8 @@ vlib_stats_register_error_index (void *oldheap, u8 * name, u64 * em_vec,
       e.type = STAT_DIR_TYPE_ERROR_INDEX;
       e.offset = index;
       e.offset_vector = 0;
+      e.epoch = stat_segment_new_entry_epoch (shared_header);
+      e.seq = 0;
       vec_add1 (sm->directory_vector, e);
 
       /* Warn clients to refresh any pointers they might be holding */
@@ -216,6 +258,7 @@ stat_validate_counter_vector (stat_segment_directory_entry_t * ep, u32 max)
     }
   ep->offset = stat_segment_offset (shared_header, counters);
   ep->offset_vector = stat_segment_offset (shared_header, offset_vector);
+  ep->epoch = stat_segment_new_entry_epoch (shared_header);
 }
 
 void
@@ -303,12 +346,14 @@ vlib_map_stat_segment_init (void)
   sm->directory_vector = 0;
 
   shared_header->epoch = 1;
+  shared_header->entry_epoch = 1;
 
   /* Scalar stats and node counters */
   vec_validate (sm->directory_vector, STAT_COUNTERS - 1);
 #define _(E,t,n,p)							\
   strcpy(sm->directory_vector[STAT_COUNTER_##E].name,  #p "/" #n); \
-  sm->directory_vector[STAT_COUNTER_##E].type = STAT_DIR_TYPE_##t;
+  sm->directory_vector[STAT_COUNTER_##E].type = STAT_DIR_TYPE_##t;	\
+  sm->directory_vector[STAT_COUNTER_##E].epoch = 1;
   foreach_stat_segment_counter_name
 #undef _
     /* Save the vector offset in the shared segment, for clients */
@@ -484,6 +529,7 @@ update_node_counters (stat_segment_main_t * sm)
 
 	}
       ep->offset_vector = stat_segment_offset (shared_header, offset_vector);
+      ep->epoch = stat_segment_new_entry_epoch (shared_header);
 
       vlib_stat_segment_unlock ();
       clib_mem_set_heap (oldheap);
@@ -754,6 +800,7 @@ stat_segment_register_gauge (u8 * name, stat_segment_update_fn update_fn,
 
   memset (&e, 0, sizeof (e));
   e.type = STAT_DIR_TYPE_SCALAR_INDEX;
+  e.epoch = stat_segment_new_entry_epoch (shared_header);
 
   memcpy (e.name, name, vec_len (name));
   vec_add1 (sm->directory_vector, e);
@@ -820,7 +867,7 @@ statseg_sw_interface_add_del (vnet_main_t * vnm, u32 sw_if_index, u32 is_add)
   stat_segment_shared_header_t *shared_header = sm->shared_header;
 
   void *oldheap = vlib_stats_push_heap (sm->interfaces);
-  vlib_stat_segment_lock ();
+  vlib_stat_segment_entry_lock (STAT_COUNTER_INTERFACE_NAMES);
 
   vec_validate (sm->interfaces, sw_if_index);
   if (is_add)
@@ -875,7 +922,7 @@ statseg_sw_interface_add_del (vnet_main_t * vnm, u32 sw_if_index, u32 is_add)
     }
   ep->offset_vector = stat_segment_offset (shared_header, offset_vector);
 
-  vlib_stat_segment_unlock ();
+  vlib_stat_segment_entry_unlock (STAT_COUNTER_INTERFACE_NAMES);
   clib_mem_set_heap (oldheap);
 
   return 0;
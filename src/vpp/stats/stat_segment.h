@@ -68,6 +68,8 @@ typedef struct
     uint64_t value;
   };
   uint64_t offset_vector;
+  uint64_t epoch;	/* entry_epoch of the last change to this entry */
+  uint64_t seq;		/* odd while the entry is being changed */
   char name[128]; // TODO change this to pointer to "somewhere"
 } stat_segment_directory_entry_t;
 
@@ -75,7 +77,7 @@ typedef struct
 #define STAT_SEGMENT_DEFAULT_SIZE	(32<<20)
 
 /* Shared segment memory layout version */
-#define STAT_SEGMENT_VERSION		1
+#define STAT_SEGMENT_VERSION		2
 
 /*
  * Shared header first in the shared memory segment.
@@ -88,6 +90,7 @@ typedef struct
   atomic_int_fast64_t directory_offset;
   atomic_int_fast64_t error_offset;
   atomic_int_fast64_t stats_offset;
+  atomic_int_fast64_t entry_epoch;
 } stat_segment_shared_header_t;
 
 static inline uint64_t
@@ -102,6 +105,27 @@ stat_segment_pointer (void *start, uint64_t offset)
   return ((char *) start + offset);
 }
 
+/*
+ * Writers changing a single existing directory entry bracket the change
+ * with these, instead of bumping the directory epoch. Readers retry only
+ * the entries whose seq changed while they were copied.
+ */
+static inline void
+stat_segment_entry_update_start (stat_segment_directory_entry_t * ep)
+{
+  ep->seq++;
+  CLIB_MEMORY_STORE_BARRIER ();
+}
+
+static inline void
+stat_segment_entry_update_end (stat_segment_shared_header_t * shared_header,
+			       stat_segment_directory_entry_t * ep)
+{
+  ep->epoch = atomic_fetch_add (&shared_header->entry_epoch, 1) + 1;
+  CLIB_MEMORY_STORE_BARRIER ();
+  ep->seq++;
+}
+
 typedef void (*stat_segment_update_fn)(stat_segment_directory_entry_t * e, u32 i);
 
 typedef struct {
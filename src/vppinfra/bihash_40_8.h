@@ -17,6 +17,7 @@
 #undef BIHASH_KVP_PER_PAGE
 #undef BIHASH_32_64_SVM
 #undef BIHASH_ENABLE_STATS
+#undef BIHASH_INDIRECT_KEYS
 
 #define BIHASH_TYPE _40_8
 #define BIHASH_KVP_PER_PAGE 4
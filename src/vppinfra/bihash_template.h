@@ -473,6 +473,160 @@ static inline int BV (clib_bihash_search_inline_2)
 						     valuep);
 }
 
+/** Find a key in a single page of a bihash bucket
+    The first key word of all kvps in the page is compared at once, the
+    full key only for candidates.
+    @param v - the page
+    @param k - the key
+    @return index of the matching kvp in the page, or -1
+*/
+static inline int BV (clib_bihash_page_search)
+  (BVT (clib_bihash_value) * v, BVT (clib_bihash_kv) * k)
+{
+  int i;
+
+#if BIHASH_KVP_PER_PAGE == 4 && defined (__AVX2__) && !BIHASH_INDIRECT_KEYS
+  if (sizeof (BVT (clib_bihash_kv)) % sizeof (u64) == 0)
+    {
+      const int stride = sizeof (BVT (clib_bihash_kv)) / sizeof (u64);
+      u64 w = *(u64 *) & k->key;
+      u32 mask, shift = 1;
+
+#if defined (__AVX512F__)
+      if (stride == 2)
+	{
+	  /* the whole page fits in one register, key words are even lanes */
+	  __m512i page = _mm512_loadu_si512 (v->kvp);
+	  mask = _mm512_cmpeq_epi64_mask (page, _mm512_set1_epi64 (w)) & 0x55;
+	  shift = 2;
+	}
+      else
+#endif
+	{
+	  __m256i idx = _mm256_set_epi64x (3 * stride, 2 * stride, stride, 0);
+	  __m256i kw = _mm256_i64gather_epi64 ((long long *) v->kvp, idx, 8);
+	  kw = _mm256_cmpeq_epi64 (kw, _mm256_set1_epi64x (w));
+	  mask = _mm256_movemask_pd ((__m256d) kw);
+	}
+
+      while (mask)
+	{
+	  i = count_trailing_zeros (mask) / shift;
+	  if (BV (clib_bihash_key_compare) (v->kvp[i].key, k->key))
+	    return i;
+	  mask &= mask - 1;
+	}
+      return -1;
+    }
+#endif
+
+  for (i = 0; i < BIHASH_KVP_PER_PAGE; i++)
+    if (BV (clib_bihash_key_compare) (v->kvp[i].key, k->key))
+      return i;
+  return -1;
+}
+
+#ifndef BIHASH_SEARCH_BATCH_SIZE
+#define BIHASH_SEARCH_BATCH_SIZE 16
+#endif
+
+/** Search a bihash table for a batch of keys
+    Hashing, bucket prefetch and page prefetch are done for up to
+    BIHASH_SEARCH_BATCH_SIZE keys before any of them is compared, so the
+    cache misses of different keys overlap.
+    @param h - the bihash table
+    @param keys - the keys to look up
+    @param n_keys - number of keys
+    @param results - the kvps found, only written for keys found.
+                     May be the same array as keys.
+    @param found - if not NULL, set to 1 for each key found, 0 otherwise
+    @return number of keys found
+*/
+static inline u32 BV (clib_bihash_search_batch)
+  (BVT (clib_bihash) * h, BVT (clib_bihash_kv) * keys, u32 n_keys,
+   BVT (clib_bihash_kv) * results, u8 * found)
+{
+  u64 hashes[BIHASH_SEARCH_BATCH_SIZE], hash;
+  BVT (clib_bihash_value) * v;
+  BVT (clib_bihash_bucket) * b;
+  u32 i, n, n_found = 0;
+  int j, limit;
+
+  if (PREDICT_FALSE (alloc_arena (h) == 0))
+    {
+      if (found)
+	clib_memset (found, 0, n_keys);
+      return 0;
+    }
+
+  while (n_keys)
+    {
+      n = clib_min (n_keys, BIHASH_SEARCH_BATCH_SIZE);
+
+      for (i = 0; i < n; i++)
+	{
+	  hashes[i] = BV (clib_bihash_hash) (keys + i);
+	  BV (clib_bihash_prefetch_bucket) (h, hashes[i]);
+	}
+
+      for (i = 0; i < n; i++)
+	BV (clib_bihash_prefetch_data) (h, hashes[i]);
+
+      for (i = 0; i < n; i++)
+	{
+	  b = &h->buckets[hashes[i] & (h->nbuckets - 1)];
+	  v = 0;
+	  j = -1;
+
+	  if (PREDICT_FALSE (BV (clib_bihash_bucket_is_empty) (b)))
+	    goto done;
+
+	  if (PREDICT_FALSE (b->lock))
+	    {
+	      volatile BVT (clib_bihash_bucket) * bv = b;
+	      while (bv->lock)
+		CLIB_PAUSE ();
+	    }
+
+	  hash = hashes[i] >> h->log2_nbuckets;
+	  v = BV (clib_bihash_get_value) (h, b->offset);
+
+	  if (PREDICT_TRUE (b->linear_search == 0))
+	    {
+	      v += hash & ((1 << b->log2_pages) - 1);
+	      j = BV (clib_bihash_page_search) (v, keys + i);
+	    }
+	  else
+	    {
+	      /* unresolvable collisions, linear search all pages */
+	      limit = BIHASH_KVP_PER_PAGE << b->log2_pages;
+	      for (j = 0; j < limit; j++)
+		if (BV (clib_bihash_key_compare) (v->kvp[j].key, keys[i].key))
+		  break;
+	      if (j == limit)
+		j = -1;
+	    }
+
+	done:
+	  if (j >= 0)
+	    {
+	      results[i] = v->kvp[j];
+	      n_found++;
+	    }
+	  if (found)
+	    found[i] = j >= 0;
+	}
+
+      keys += n;
+      results += n;
+      if (found)
+	found += n;
+      n_keys -= n;
+    }
+
+  return n_found;
+}
+
 
 #endif /* __included_bihash_template_h__ */
 
@@ -16,9 +16,12 @@
 #undef BIHASH_KVP_PER_PAGE
 #undef BIHASH_32_64_SVM
 #undef BIHASH_ENABLE_STATS
+#undef BIHASH_INDIRECT_KEYS
 
 #define BIHASH_TYPE _vec8_8
 #define BIHASH_KVP_PER_PAGE 4
+/* keys point to vectors, which are compared by content */
+#define BIHASH_INDIRECT_KEYS 1
 
 #ifndef __included_bihash_vec8_8_h__
 #define __included_bihash_vec8_8_h__
@@ -130,6 +130,8 @@ _ (avx512f,  7, ebx, 16)  \
 _ (rdseed,   7, ebx, 18)  \
 _ (x86_aes,  1, ecx, 25)  \
 _ (sha,      7, ebx, 29)  \
+_ (avx512bw, 7, ebx, 30)  \
+_ (avx512vl, 7, ebx, 31)  \
 _ (vaes,     7, ecx, 9)   \
 _ (vpclmulqdq, 7, ecx, 10)   \
 _ (invariant_tsc, 0x80000007, edx, 8)
@@ -146,6 +146,106 @@ test_bihash_stale_overwrite (test_main_t * tm)
   return 0;
 }
 
+static clib_error_t *
+test_bihash_batch (test_main_t * tm)
+{
+  BVT (clib_bihash) * h;
+  BVT (clib_bihash_kv) kv, *kvs = 0, *results = 0;
+  u32 i, j, n, table_size;
+  u64 n_found, total_searches;
+  f64 before, delta, single_rate, batch_rate;
+  u8 *found = 0;
+
+  h = &tm->hash;
+
+  fformat (stdout, "%12s%20s%20s%10s\n", "entries", "single lookups/s",
+	   "batch lookups/s", "speedup");
+
+  for (table_size = 1 << 10; table_size <= tm->nitems; table_size <<= 2)
+    {
+#if BIHASH_32_64_SVM
+      BV (clib_bihash_master_init_svm) (h, "test", table_size,
+					0x30000000 /* base_addr */ ,
+					tm->hash_memory_size);
+#else
+      BV (clib_bihash_init) (h, "test", table_size, tm->hash_memory_size);
+#endif
+
+      vec_reset_length (kvs);
+      for (i = 0; i < table_size; i++)
+	{
+	  kv.key = random_u64 (&tm->seed);
+	  kv.value = i + 1;
+	  BV (clib_bihash_add_del) (h, &kv, 1 /* is_add */ );
+	  vec_add1 (kvs, kv);
+	}
+      vec_validate (results, table_size - 1);
+      vec_validate (found, table_size - 1);
+
+      /* look the keys up in random order, defeating the prefetcher */
+      for (i = table_size - 1; i > 0; i--)
+	{
+	  j = random_u64 (&tm->seed) % (i + 1);
+	  kv = kvs[i];
+	  kvs[i] = kvs[j];
+	  kvs[j] = kv;
+	}
+
+      total_searches = (u64) tm->search_iter * table_size;
+
+      n_found = 0;
+      before = clib_time_now (&tm->clib_time);
+      for (j = 0; j < tm->search_iter; j++)
+	for (i = 0; i < table_size; i++)
+	  n_found += BV (clib_bihash_search_inline_2) (h, kvs + i,
+						       results + i) == 0;
+      delta = clib_time_now (&tm->clib_time) - before;
+      single_rate = delta > 0 ? total_searches / delta : 0;
+
+      if (n_found != total_searches)
+	return clib_error_return (0, "single search found %llu of %llu keys",
+				  n_found, total_searches);
+
+      n_found = 0;
+      before = clib_time_now (&tm->clib_time);
+      for (j = 0; j < tm->search_iter; j++)
+	for (i = 0; i < table_size; i += n)
+	  {
+	    n = clib_min (table_size - i, 256);
+	    n_found += BV (clib_bihash_search_batch) (h, kvs + i, n,
+						      results + i, found + i);
+	  }
+      delta = clib_time_now (&tm->clib_time) - before;
+      batch_rate = delta > 0 ? total_searches / delta : 0;
+
+      if (n_found != total_searches)
+	return clib_error_return (0, "batch search found %llu of %llu keys",
+				  n_found, total_searches);
+
+      for (i = 0; i < table_size; i++)
+	if (!found[i] || results[i].key != kvs[i].key
+	    || results[i].value != kvs[i].value)
+	  return clib_error_return (0, "batch search result %u wrong", i);
+
+      /* free kvps are all ones, so don't look for that */
+      kv.key = 0;
+      if (BV (clib_bihash_search) (h, &kv, &kv) < 0
+	  && (BV (clib_bihash_search_batch) (h, &kv, 1, results, found)
+	      || found[0]))
+	return clib_error_return (0, "batch search found a missing key");
+
+      fformat (stdout, "%12u%20.f%20.f%9.2fx\n", table_size, single_rate,
+	       batch_rate, single_rate > 0 ? batch_rate / single_rate : 0);
+
+      BV (clib_bihash_free) (h);
+    }
+
+  vec_free (kvs);
+  vec_free (results);
+  vec_free (found);
+  return 0;
+}
+
 void *
 test_bihash_thread_fn (void *arg)
 {
@@ -492,6 +592,8 @@ test_bihash_main (test_main_t * tm)
 	tm->verbose = 1;
       else if (unformat (i, "stale-overwrite"))
 	which = 3;
+      else if (unformat (i, "batch"))
+	which = 4;
       else
 	return clib_error_return (0, "unknown input '%U'",
 				  format_unformat_error, i);
@@ -521,6 +623,10 @@ test_bihash_main (test_main_t * tm)
       error = test_bihash_stale_overwrite (tm);
       break;
 
+    case 4:
+      error = test_bihash_batch (tm);
+      break;
+
     default:
       return clib_error_return (0, "no such test?");
     }
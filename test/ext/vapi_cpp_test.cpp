@@ -0,0 +1,194 @@
+/*
+ *------------------------------------------------------------------
+ * vapi_cpp_test.cpp
+ *
+ * Copyright (c) 2019 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *------------------------------------------------------------------
+ */
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <vector>
+#include <stdio.h>
+#include <check.h>
+#include <vapi/vapi.hpp>
+#include <vapi/vpe.api.vapi.hpp>
+
+DEFINE_VAPI_MSG_IDS_VPE_API_JSON;
+
+static char *app_name = nullptr;
+static char *api_prefix = nullptr;
+static const int max_outstanding_requests = 32;
+static const int response_queue_size = 32;
+
+/* default length of the vpp api input queue */
+static const int input_queue_size = 1024;
+
+using namespace vapi;
+
+Connection con;
+
+void setup (void)
+{
+  vapi_error_e rv = con.connect (
+      app_name, api_prefix, max_outstanding_requests, response_queue_size);
+  ck_assert_int_eq (VAPI_OK, rv);
+}
+
+void setup_nonblocking (void)
+{
+  vapi_error_e rv =
+      con.connect (app_name, api_prefix, max_outstanding_requests,
+                   response_queue_size, true, VAPI_MODE_NONBLOCKING);
+  ck_assert_int_eq (VAPI_OK, rv);
+}
+
+void teardown (void)
+{
+  con.disconnect ();
+}
+
+START_TEST (test_batch_larger_than_queue)
+{
+  printf ("--- Non-blocking batch larger than the input queue ---\n");
+  const int n = 2 * input_queue_size + 1;
+  std::vector<std::unique_ptr<Show_version>> svs;
+  std::vector<std::future<vapi_error_e>> futures;
+  /* vpp waits for room in our response queue, so keep draining it */
+  con.start_dispatch_thread ();
+  con.start_batch ();
+  for (int i = 0; i < n; ++i)
+    {
+      svs.emplace_back (new Show_version (con));
+      futures.emplace_back (svs.back ()->execute_async ());
+    }
+  vapi_error_e rv = con.flush_batch ();
+  ck_assert_int_eq (VAPI_OK, rv);
+  for (int i = 0; i < n; ++i)
+    {
+      ck_assert_int_eq (VAPI_OK, futures[i].get ());
+      ck_assert_int_eq (RESPONSE_READY, svs[i]->get_response_state ());
+    }
+  con.stop_dispatch_thread ();
+}
+
+END_TEST;
+
+START_TEST (test_dispatch_thread_stopped)
+{
+  printf ("--- Requests outstanding when the dispatch thread stops ---\n");
+  const int n = response_queue_size / 2;
+  std::vector<std::unique_ptr<Show_version>> svs;
+  std::vector<std::future<vapi_error_e>> futures;
+  con.start_dispatch_thread ();
+  con.start_batch ();
+  for (int i = 0; i < n; ++i)
+    {
+      svs.emplace_back (new Show_version (con));
+      futures.emplace_back (svs.back ()->execute_async ());
+    }
+  /* nothing is sent before the flush, so all the responses are left to
+     dispatch () */
+  con.stop_dispatch_thread ();
+  vapi_error_e rv = con.flush_batch ();
+  ck_assert_int_eq (VAPI_OK, rv);
+  rv = con.dispatch ();
+  ck_assert_int_eq (VAPI_OK, rv);
+  for (int i = 0; i < n; ++i)
+    {
+      ck_assert_int_eq (VAPI_OK, futures[i].get ());
+      ck_assert_int_eq (RESPONSE_READY, svs[i]->get_response_state ());
+    }
+}
+
+END_TEST;
+
+START_TEST (test_disconnect_fails_pending)
+{
+  printf ("--- Requests outstanding on disconnect fail ---\n");
+  con.start_dispatch_thread ();
+  Show_version sv (con);
+  auto f = sv.execute_async ();
+  ck_assert_int_eq (VAPI_OK, f.get ());
+  con.start_batch ();
+  Show_version sv1 (con);
+  Show_version sv2 (con);
+  auto f1 = sv1.execute_async ();
+  auto f2 = sv2.execute_async ();
+  ck_assert (std::future_status::timeout ==
+             f1.wait_for (std::chrono::milliseconds (100)));
+  vapi_error_e rv = con.disconnect ();
+  ck_assert_int_eq (VAPI_OK, rv);
+  /* the futures must not be left hanging */
+  ck_assert_int_eq (VAPI_ENORESP, f1.get ());
+  ck_assert_int_eq (VAPI_ENORESP, f2.get ());
+  ck_assert_int_eq (RESPONSE_NOT_READY, sv1.get_response_state ());
+  ck_assert_int_eq (RESPONSE_NOT_READY, sv2.get_response_state ());
+}
+
+END_TEST;
+
+Suite *test_suite (void)
+{
+  Suite *s = suite_create ("VAPI test");
+
+  TCase *tc_cpp_api = tcase_create ("C++ API");
+  tcase_set_timeout (tc_cpp_api, 25);
+  tcase_add_checked_fixture (tc_cpp_api, setup, teardown);
+  tcase_add_test (tc_cpp_api, test_dispatch_thread_stopped);
+  tcase_add_test (tc_cpp_api, test_disconnect_fails_pending);
+  suite_add_tcase (s, tc_cpp_api);
+
+  TCase *tc_cpp_api_nonblocking = tcase_create ("C++ API non-blocking");
+  tcase_set_timeout (tc_cpp_api_nonblocking, 25);
+  tcase_add_checked_fixture (tc_cpp_api_nonblocking, setup_nonblocking,
+                             teardown);
+  tcase_add_test (tc_cpp_api_nonblocking, test_batch_larger_than_queue);
+  suite_add_tcase (s, tc_cpp_api_nonblocking);
+
+  return s;
+}
+
+int main (int argc, char *argv[])
+{
+  if (3 != argc)
+    {
+      printf ("Invalid argc==`%d'\n", argc);
+      return EXIT_FAILURE;
+    }
+  app_name = argv[1];
+  api_prefix = argv[2];
+  printf ("App name: `%s', API prefix: `%s'\n", app_name, api_prefix);
+
+  int number_failed;
+  Suite *s;
+  SRunner *sr;
+
+  s = test_suite ();
+  sr = srunner_create (s);
+
+  srunner_run_all (sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed (sr);
+  srunner_free (sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */